@@ -6,6 +6,7 @@
 #include <itkImage.h>
 #include <itkImageFileReader.h>
 #include <itkPluginFilterWatcher.h>
+#include <itksys/SystemTools.hxx>
 
 // STD includes
 #include <vector>
@@ -52,6 +53,38 @@ namespace itk
       }
     }
 
+  //-----------------------------------------------------------------------------
+  /// Return true if the file is exchanged with Slicer through shared memory.
+  /// Slicer sets SLICER_CLI_SHARED_MEMORY_DIRECTORY to the memory-backed
+  /// directory (e.g. /dev/shm) where it writes the inputs and reads the
+  /// outputs of the module, it is empty or unset when files are on disk.
+  /// The output files are created by Slicer with user-only permissions
+  /// (0600) before the module runs: write them in place, do not remove them.
+  bool IsSharedMemoryFileName(const std::string& fileName)
+    {
+    std::string sharedMemoryDirectory;
+    if (!itksys::SystemTools::GetEnv("SLICER_CLI_SHARED_MEMORY_DIRECTORY", sharedMemoryDirectory)
+      || sharedMemoryDirectory.empty())
+      {
+      return false;
+      }
+    return itksys::SystemTools::GetParentDirectory(
+      itksys::SystemTools::CollapseFullPath(fileName)) ==
+      itksys::SystemTools::CollapseFullPath(sharedMemoryDirectory);
+    }
+
+  //-----------------------------------------------------------------------------
+  /// Return whether an output file should be compressed: files exchanged
+  /// through shared memory are read once by Slicer and deleted, compressing
+  /// them only costs time.
+  /// \code
+  /// writer->SetUseCompression(itk::UseCompressionForFileName(outputVolume));
+  /// \endcode
+  bool UseCompressionForFileName(const std::string& fileName, bool useCompression = true)
+    {
+    return useCompression && !IsSharedMemoryFileName(fileName);
+    }
+
   //-----------------------------------------------------------------------------
   template <class T>
   void AlignVolumeCenters(T *fixed, T *moving, typename T::PointType &origin)
@@ -0,0 +1,404 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerTask.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// MRML includes
+#include <vtkEventBroker.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Shared state of the test tasks.
+struct TaskRecorder
+{
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::vector<int> StartedTaskIds;
+  int NumberOfRunningTasks{0};
+  bool Released{false};
+};
+
+//----------------------------------------------------------------------------
+class vtkRecordingTask : public vtkSlicerTask
+{
+public:
+  static vtkRecordingTask* New();
+  vtkTypeMacro(vtkRecordingTask, vtkSlicerTask);
+
+  void Execute() override
+    {
+    this->StartTime = vtkTimerLog::GetUniversalTime();
+    std::unique_lock<std::mutex> lock(this->Recorder->Mutex);
+    this->Recorder->StartedTaskIds.push_back(this->Id);
+    ++this->Recorder->NumberOfRunningTasks;
+    this->Recorder->Changed.notify_all();
+    if (this->WaitForRelease)
+      {
+      this->Recorder->Changed.wait_for(lock, std::chrono::seconds(10),
+        [this]() { return this->Recorder->Released; });
+      }
+    --this->Recorder->NumberOfRunningTasks;
+    }
+
+  TaskRecorder* Recorder{nullptr};
+  int Id{0};
+  bool WaitForRelease{false};
+  double StartTime{0.0};
+
+protected:
+  vtkRecordingTask()
+    {
+    this->SetTypeToProcessing();
+    }
+  ~vtkRecordingTask() override = default;
+};
+vtkStandardNewMacro(vtkRecordingTask);
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkRecordingTask> CreateTask(TaskRecorder& recorder, int id,
+                                             int priority = 0, bool waitForRelease = false)
+{
+  vtkSmartPointer<vtkRecordingTask> task = vtkSmartPointer<vtkRecordingTask>::New();
+  task->Recorder = &recorder;
+  task->Id = id;
+  task->SetPriority(priority);
+  task->WaitForRelease = waitForRelease;
+  return task;
+}
+
+//----------------------------------------------------------------------------
+void Release(TaskRecorder& recorder)
+{
+  std::lock_guard<std::mutex> lock(recorder.Mutex);
+  recorder.Released = true;
+  recorder.Changed.notify_all();
+}
+
+//----------------------------------------------------------------------------
+int TestPriorityAndCancel()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(1);
+
+  TaskRecorder recorder;
+  vtkSmartPointer<vtkRecordingTask> blockingTask = CreateTask(recorder, 0, 0, true);
+  // threads are not started yet
+  CHECK_BOOL(appLogic->ScheduleTask(blockingTask) != 0, false);
+  CHECK_INT(blockingTask->GetState(), vtkSlicerTask::Idle);
+
+  appLogic->CreateProcessingThread();
+  CHECK_BOOL(appLogic->ScheduleTask(blockingTask) != 0, true);
+  {
+  // wait for the only processing thread to be busy
+  std::unique_lock<std::mutex> lock(recorder.Mutex);
+  CHECK_BOOL(recorder.Changed.wait_for(lock, std::chrono::seconds(10),
+    [&recorder]() { return recorder.NumberOfRunningTasks == 1; }), true);
+  }
+  CHECK_INT(blockingTask->GetState(), vtkSlicerTask::Running);
+
+  vtkSmartPointer<vtkRecordingTask> lowPriorityTask = CreateTask(recorder, 1, -1);
+  vtkSmartPointer<vtkRecordingTask> normalPriorityTask1 = CreateTask(recorder, 2);
+  vtkSmartPointer<vtkRecordingTask> canceledTask = CreateTask(recorder, 3);
+  vtkSmartPointer<vtkRecordingTask> normalPriorityTask2 = CreateTask(recorder, 4);
+  vtkSmartPointer<vtkRecordingTask> highPriorityTask = CreateTask(recorder, 5, 10);
+  CHECK_BOOL(appLogic->ScheduleTask(lowPriorityTask) != 0, true);
+  CHECK_BOOL(appLogic->ScheduleTask(normalPriorityTask1) != 0, true);
+  CHECK_BOOL(appLogic->ScheduleTask(canceledTask) != 0, true);
+  CHECK_BOOL(appLogic->ScheduleTask(normalPriorityTask2) != 0, true);
+  CHECK_BOOL(appLogic->ScheduleTask(highPriorityTask) != 0, true);
+  CHECK_INT(appLogic->GetNumberOfQueuedTasks(), 5);
+  CHECK_INT(lowPriorityTask->GetState(), vtkSlicerTask::Queued);
+
+  // a canceled queued task is finished immediately
+  canceledTask->Cancel();
+  CHECK_INT(canceledTask->GetState(), vtkSlicerTask::Canceled);
+  CHECK_BOOL(canceledTask->WaitForCompletion(0.0), true);
+  // a canceled task cannot be scheduled again
+  CHECK_BOOL(appLogic->ScheduleTask(canceledTask) != 0, false);
+
+  // the processing thread is still busy
+  CHECK_BOOL(lowPriorityTask->WaitForCompletion(0.01), false);
+
+  Release(recorder);
+  CHECK_BOOL(blockingTask->WaitForCompletion(), true);
+  CHECK_BOOL(lowPriorityTask->WaitForCompletion(), true);
+  CHECK_INT(blockingTask->GetState(), vtkSlicerTask::Completed);
+  CHECK_INT(lowPriorityTask->GetState(), vtkSlicerTask::Completed);
+  CHECK_INT(appLogic->GetNumberOfQueuedTasks(), 0);
+
+  // highest priority first, first scheduled first
+  std::vector<int> expectedIds = { 0, 5, 2, 4, 1 };
+  std::lock_guard<std::mutex> lock(recorder.Mutex);
+  CHECK_BOOL(recorder.StartedTaskIds == expectedIds, true);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestConcurrentTasks()
+{
+  const int numberOfThreads = 4;
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(numberOfThreads);
+  appLogic->CreateProcessingThread();
+
+  TaskRecorder recorder;
+  std::vector<vtkSmartPointer<vtkRecordingTask> > tasks;
+  for (int i = 0; i < numberOfThreads; ++i)
+    {
+    tasks.push_back(CreateTask(recorder, i, 0, true));
+    CHECK_BOOL(appLogic->ScheduleTask(tasks.back()) != 0, true);
+    }
+  {
+  // all the tasks run at the same time
+  std::unique_lock<std::mutex> lock(recorder.Mutex);
+  CHECK_BOOL(recorder.Changed.wait_for(lock, std::chrono::seconds(10),
+    [&recorder, numberOfThreads]() { return recorder.NumberOfRunningTasks == numberOfThreads; }), true);
+  }
+  Release(recorder);
+  for (int i = 0; i < numberOfThreads; ++i)
+    {
+    CHECK_BOOL(tasks[i]->WaitForCompletion(), true);
+    }
+
+  // queued tasks are canceled when the threads are terminated
+  recorder.Released = false;
+  tasks.clear();
+  for (int i = 0; i < numberOfThreads + 2; ++i)
+    {
+    tasks.push_back(CreateTask(recorder, i, 0, true));
+    CHECK_BOOL(appLogic->ScheduleTask(tasks.back()) != 0, true);
+    }
+  {
+  std::unique_lock<std::mutex> lock(recorder.Mutex);
+  CHECK_BOOL(recorder.Changed.wait_for(lock, std::chrono::seconds(10),
+    [&recorder, numberOfThreads]() { return recorder.NumberOfRunningTasks == numberOfThreads; }), true);
+  }
+  // release the running tasks once the queued tasks are canceled
+  std::thread releaseThread([&tasks, &recorder, numberOfThreads]()
+    {
+    tasks[numberOfThreads]->WaitForCompletion();
+    tasks[numberOfThreads + 1]->WaitForCompletion();
+    Release(recorder);
+    });
+  appLogic->TerminateProcessingThread();
+  releaseThread.join();
+  int numberOfCanceledTasks = 0;
+  for (size_t i = 0; i < tasks.size(); ++i)
+    {
+    CHECK_BOOL(tasks[i]->WaitForCompletion(), true);
+    numberOfCanceledTasks += (tasks[i]->GetState() == vtkSlicerTask::Canceled ? 1 : 0);
+    }
+  CHECK_INT(numberOfCanceledTasks, 2);
+  CHECK_BOOL(appLogic->ScheduleTask(CreateTask(recorder, 0)) != 0, false);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void CountEventCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                        void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<std::atomic<int>*>(clientData));
+}
+
+//----------------------------------------------------------------------------
+int TestTaskLatency()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(1);
+  appLogic->CreateProcessingThread();
+
+  // Time between ScheduleTask() and the start of the task. Tasks used to be
+  // pulled off the queue by polling every 100ms. The latency is only
+  // reported, as it depends on the load of the machine.
+  const int numberOfTasks = 100;
+  TaskRecorder recorder;
+  double totalLatency = 0.0;
+  double maximumLatency = 0.0;
+  std::vector<int> expectedIds;
+  for (int i = 0; i < numberOfTasks; ++i)
+    {
+    vtkSmartPointer<vtkRecordingTask> task = CreateTask(recorder, i);
+    double scheduleTime = vtkTimerLog::GetUniversalTime();
+    CHECK_BOOL(appLogic->ScheduleTask(task) != 0, true);
+    CHECK_BOOL(task->WaitForCompletion(), true);
+    CHECK_INT(task->GetState(), vtkSlicerTask::Completed);
+    expectedIds.push_back(i);
+    double latency = task->StartTime - scheduleTime;
+    totalLatency += latency;
+    maximumLatency = std::max(maximumLatency, latency);
+    }
+  double averageLatency = totalLatency / numberOfTasks;
+  std::cout << "Task enqueue-to-start latency: average " << averageLatency * 1000.0
+            << "ms, maximum " << maximumLatency * 1000.0 << "ms" << std::endl;
+
+  // tasks scheduled without waiting are all completed, in scheduling order
+  std::vector<vtkSmartPointer<vtkRecordingTask> > tasks;
+  for (int i = numberOfTasks; i < 2 * numberOfTasks; ++i)
+    {
+    tasks.push_back(CreateTask(recorder, i));
+    CHECK_BOOL(appLogic->ScheduleTask(tasks.back()) != 0, true);
+    expectedIds.push_back(i);
+    }
+  for (size_t i = 0; i < tasks.size(); ++i)
+    {
+    CHECK_BOOL(tasks[i]->WaitForCompletion(), true);
+    CHECK_INT(tasks[i]->GetState(), vtkSlicerTask::Completed);
+    }
+  std::lock_guard<std::mutex> lock(recorder.Mutex);
+  CHECK_BOOL(recorder.StartedTaskIds == expectedIds, true);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRestartProcessingThreads()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLModelNode> referencingNode;
+  scene->AddNode(referencingNode.GetPointer());
+  vtkNew<vtkMRMLModelNode> referencedNode;
+  scene->AddNode(referencedNode.GetPointer());
+
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetMRMLScene(scene.GetPointer());
+  std::atomic<int> requestInvokeEventCount(0);
+  vtkNew<vtkCallbackCommand> requestInvokeCallback;
+  requestInvokeCallback->SetCallback(CountEventCallback);
+  requestInvokeCallback->SetClientData(&requestInvokeEventCount);
+  appLogic->AddObserver(vtkSlicerApplicationLogic::RequestInvokeEvent, requestInvokeCallback.GetPointer());
+
+  appLogic->CreateProcessingThread();
+  CHECK_BOOL(appLogic->RequestAddNodeReference(
+    referencingNode->GetID(), referencedNode->GetID(), "test1") != 0, true);
+  CHECK_INT(requestInvokeEventCount, 1);
+
+  // the scheduled processing is skipped while the threads are terminated
+  appLogic->TerminateProcessingThread();
+  appLogic->ProcessReadData();
+  CHECK_INT(appLogic->GetReadDataQueueSize(), 1);
+  CHECK_NULL(referencingNode->GetNodeReference("test1"));
+
+  // processing of the queued request is scheduled again on restart
+  appLogic->CreateProcessingThread();
+  CHECK_INT(requestInvokeEventCount, 2);
+  appLogic->ProcessReadData();
+  CHECK_INT(appLogic->GetReadDataQueueSize(), 0);
+  CHECK_POINTER(referencingNode->GetNodeReference("test1"), referencedNode.GetPointer());
+
+  // new requests schedule processing
+  CHECK_BOOL(appLogic->RequestAddNodeReference(
+    referencingNode->GetID(), referencedNode->GetID(), "test2") != 0, true);
+  CHECK_INT(requestInvokeEventCount, 3);
+  appLogic->ProcessReadData();
+  CHECK_POINTER(referencingNode->GetNodeReference("test2"), referencedNode.GetPointer());
+
+  appLogic->TerminateProcessingThread();
+  appLogic->SetMRMLScene(nullptr);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRequestModified()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  std::atomic<int> requestInvokeEventCount(0);
+  vtkNew<vtkCallbackCommand> requestInvokeCallback;
+  requestInvokeCallback->SetCallback(CountEventCallback);
+  requestInvokeCallback->SetClientData(&requestInvokeEventCount);
+  appLogic->AddObserver(vtkSlicerApplicationLogic::RequestInvokeEvent, requestInvokeCallback.GetPointer());
+
+  vtkNew<vtkObject> object;
+  std::atomic<int> modifiedEventCount(0);
+  vtkNew<vtkCallbackCommand> modifiedCallback;
+  modifiedCallback->SetCallback(CountEventCallback);
+  modifiedCallback->SetClientData(&modifiedEventCount);
+  object->AddObserver(vtkCommand::ModifiedEvent, modifiedCallback.GetPointer());
+
+  // the processing threads are not started yet
+  CHECK_INT(appLogic->RequestModified(object.GetPointer()), 0);
+
+  appLogic->CreateProcessingThread();
+  vtkSlicerApplicationLogic* appLogicPointer = appLogic.GetPointer();
+  vtkObject* objectPointer = object.GetPointer();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    {
+    threads.push_back(std::thread([appLogicPointer, objectPointer]()
+      {
+      for (int j = 0; j < 10; ++j)
+        {
+        appLogicPointer->RequestModified(objectPointer);
+        }
+      }));
+    }
+  for (size_t i = 0; i < threads.size(); ++i)
+    {
+    threads[i].join();
+    }
+
+  // Modified() is called in the main thread only, the main thread is
+  // requested to process the posted events once
+  CHECK_INT(modifiedEventCount, 0);
+  CHECK_INT(requestInvokeEventCount, 1);
+  CHECK_BOOL(vtkEventBroker::GetInstance()->GetPostedEventsPending(), true);
+  appLogic->ProcessModified();
+  CHECK_INT(modifiedEventCount, 40);
+  CHECK_BOOL(vtkEventBroker::GetInstance()->GetPostedEventsPending(), false);
+
+  // a new request schedules processing again
+  CHECK_BOOL(appLogic->RequestModified(object.GetPointer()) != 0, true);
+  CHECK_INT(requestInvokeEventCount, 2);
+  appLogic->ProcessModified();
+  CHECK_INT(modifiedEventCount, 41);
+
+  appLogic->TerminateProcessingThread();
+  CHECK_INT(appLogic->RequestModified(object.GetPointer()), 0);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicTaskTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestPriorityAndCancel());
+  CHECK_EXIT_SUCCESS(TestConcurrentTasks());
+  CHECK_EXIT_SUCCESS(TestTaskLatency());
+  CHECK_EXIT_SUCCESS(TestRequestModified());
+  CHECK_EXIT_SUCCESS(TestRestartProcessingThreads());
+  return EXIT_SUCCESS;
+}
@@ -15,6 +15,7 @@
 // MRML includes
 #include <vtkCacheManager.h>
 #include <vtkDataIOManagerLogic.h>
+#include <vtkEventBroker.h>
 #ifdef Slicer_BUILD_CLI_SUPPORT
 # include <vtkMRMLCommandLineModuleNode.h>
 #endif
@@ -41,16 +42,83 @@
 # include <sys/resource.h>
 #endif
 
+#include <condition_variable>
 #include <queue>
 
 #include "vtkSlicerApplicationLogicRequests.h"
 
 //----------------------------------------------------------------------------
-class ProcessingTaskQueue : public std::queue<vtkSmartPointer<vtkSlicerTask> > {};
-class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> > {};
+/// Tasks waiting for the processing and networking threads.
+/// Idle threads wait on a condition variable until a task is scheduled.
+class ProcessingTaskQueue
+{
+public:
+  struct QueuedTask
+    {
+    vtkSmartPointer<vtkSlicerTask> Task;
+    int Priority;
+    unsigned long Sequence;
+    };
+
+  /// Highest priority first, then first scheduled first.
+  struct QueuedTaskCompare
+    {
+    bool operator()(const QueuedTask& a, const QueuedTask& b) const
+      {
+      if (a.Priority != b.Priority)
+        {
+        return a.Priority < b.Priority;
+        }
+      return a.Sequence > b.Sequence;
+      }
+    };
+
+  typedef std::priority_queue<QueuedTask, std::vector<QueuedTask>, QueuedTaskCompare> TaskQueue;
+
+  /// Block until a task is available in the queue and pull it off the
+  /// queue. Returns nullptr when the threads are terminated.
+  vtkSmartPointer<vtkSlicerTask> WaitForTask(TaskQueue& queue, std::condition_variable& taskAvailable)
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    taskAvailable.wait(lock, [&]() { return !this->Active || !queue.empty(); });
+    if (!this->Active)
+      {
+      return nullptr;
+      }
+    vtkSmartPointer<vtkSlicerTask> task = queue.top().Task;
+    queue.pop();
+    return task;
+    }
+
+  /// Cancel all queued tasks.
+  void CancelTasks(TaskQueue& queue)
+    {
+    while (!queue.empty())
+      {
+      queue.top().Task->Cancel();
+      queue.pop();
+      }
+    }
+
+  std::mutex Mutex;
+  bool Active{false};
+  unsigned long NextSequence{0};
+  TaskQueue ProcessingTasks;
+  TaskQueue NetworkingTasks;
+  std::condition_variable ProcessingTaskAvailable;
+  std::condition_variable NetworkingTaskAvailable;
+};
+
 class ReadDataQueue : public std::queue<DataRequest*> {};
 class WriteDataQueue : public std::queue<DataRequest*> {};
 
+namespace
+{
+/// Call data of the Request*Event invoked from InvokeRequestProcessingEvent().
+/// It must outlive the event as the event is invoked later in the main thread.
+int RequestProcessingDelay = 0;
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerApplicationLogic);
 
@@ -58,17 +126,17 @@ vtkStandardNewMacro(vtkSlicerApplicationLogic);
 vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 {
   this->ProcessingThreader = itk::PlatformMultiThreader::New();
-  this->ProcessingThreadId = -1;
-  this->ProcessingThreadActive = false;
+  this->NumberOfProcessingThreads = 4;
 
   this->ModifiedQueueActive = false;
 
   this->ReadDataQueueActive = false;
+  this->ReadDataProcessingScheduled = false;
 
   this->WriteDataQueueActive = false;
+  this->WriteDataProcessingScheduled = false;
 
   this->InternalTaskQueue = new ProcessingTaskQueue;
-  this->InternalModifiedQueue = new ModifiedQueue;
 
   this->InternalReadDataQueue = new ReadDataQueue;
   this->InternalWriteDataQueue = new WriteDataQueue;
@@ -80,32 +148,12 @@ vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 vtkSlicerApplicationLogic::~vtkSlicerApplicationLogic()
 {
   // Note that TerminateThread does not kill a thread, it only waits
-  // for the thread to finish.  We need to signal the thread that we
+  // for the thread to finish.  We need to signal the threads that we
   // want to terminate
-  if (this->ProcessingThreadId != -1 && this->ProcessingThreader)
-    {
-    // Signal the processingThread that we are terminating.
-    this->ProcessingThreadActiveLock.lock();
-    this->ProcessingThreadActive = false;
-    this->ProcessingThreadActiveLock.unlock();
-
-    // Wait for the thread to finish and clean up the state of the threader
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-
-    this->ProcessingThreadId = -1;
-    }
+  this->TerminateProcessingThread();
 
   delete this->InternalTaskQueue;
 
-  this->ModifiedQueueLock.lock();
-  while (!(*this->InternalModifiedQueue).empty())
-    {
-    vtkObject *obj = (*this->InternalModifiedQueue).front();
-    (*this->InternalModifiedQueue).pop();
-    obj->Delete(); // decrement ref count
-    }
-  this->ModifiedQueueLock.unlock();
-  delete this->InternalModifiedQueue;
   delete this->InternalReadDataQueue;
   delete this->InternalWriteDataQueue;
 
@@ -171,46 +219,49 @@ void vtkSlicerApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
   this->vtkObject::PrintSelf(os, indent);
 
   os << indent << "SlicerApplicationLogic:             " << this->GetClassName() << "\n";
+  os << indent << "NumberOfProcessingThreads:          " << this->NumberOfProcessingThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::CreateProcessingThread()
 {
-  if (this->ProcessingThreadId == -1)
+  if (this->ProcessingThreadIDs.empty())
     {
-    this->ProcessingThreadActiveLock.lock();
-    this->ProcessingThreadActive = true;
-    this->ProcessingThreadActiveLock.unlock();
+    this->InternalTaskQueue->Mutex.lock();
+    this->InternalTaskQueue->Active = true;
+    this->InternalTaskQueue->Mutex.unlock();
 
-    this->ProcessingThreadId
-      = this->ProcessingThreader
-      ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
-                    this);
-
-    // Start four network threads (TODO: make the number of threads a setting)
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
+    for (int i = 0; i < this->NumberOfProcessingThreads; ++i)
+      {
+      this->ProcessingThreadIDs.push_back( this->ProcessingThreader
+          ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
                     this) );
+      }
+
+    // Start a single network thread
     /*
      * TODO: it looks like curl is not thread safe by default
      * - maybe there's a setting that cmcurl can have
      *   similar to the --enable-threading of the standard curl build
-     *
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
+     */
     this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
           ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
                     this) );
-    this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
-          ->SpawnThread(vtkSlicerApplicationLogic::NetworkingThreaderCallback,
-                    this) );
-    */
 
-    // Setup the communication channel back to the main thread
+    // Setup the communication channel back to the main thread.
+    // The main thread is requested to process the queues when a request is
+    // added (see InvokeRequestProcessingEvent()), and to invoke the events
+    // posted to the event broker by any thread when the first one is posted.
     this->ModifiedQueueActiveLock.lock();
     this->ModifiedQueueActive = true;
     this->ModifiedQueueActiveLock.unlock();
+    vtkEventBroker::GetInstance()->SetPostedEventCallback(
+      vtkSlicerApplicationLogic::PostedEventCallback, this);
+    if (vtkEventBroker::GetInstance()->GetPostedEventsPending())
+      {
+      // events posted while the channel was down
+      this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestModifiedEvent);
+      }
     this->ReadDataQueueActiveLock.lock();
     this->ReadDataQueueActive = true;
     this->ReadDataQueueActiveLock.unlock();
@@ -218,18 +269,35 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
     this->WriteDataQueueActive = true;
     this->WriteDataQueueActiveLock.unlock();
 
-    int delay = 1000;
-    this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
-    this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
-    this->InvokeEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent, &delay);
+    // Processing may have been scheduled before the threads were terminated
+    // and skipped by the main thread (queues were inactive), schedule it
+    // again for the requests that are still queued.
+    this->ReadDataQueueLock.lock();
+    bool processReadData = !(*this->InternalReadDataQueue).empty();
+    this->ReadDataProcessingScheduled = processReadData;
+    this->ReadDataQueueLock.unlock();
+    this->WriteDataQueueLock.lock();
+    bool processWriteData = !(*this->InternalWriteDataQueue).empty();
+    this->WriteDataProcessingScheduled = processWriteData;
+    this->WriteDataQueueLock.unlock();
+    if (processReadData)
+      {
+      this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestReadDataEvent);
+      }
+    if (processWriteData)
+      {
+      this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent);
+      }
     }
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::TerminateProcessingThread()
 {
-  if (this->ProcessingThreadId != -1)
+  if (!this->ProcessingThreadIDs.empty())
     {
+    // Posted events are kept in the event broker until the channel is up again
+    vtkEventBroker::GetInstance()->SetPostedEventCallback(nullptr, nullptr);
     this->ModifiedQueueActiveLock.lock();
     this->ModifiedQueueActive = false;
     this->ModifiedQueueActiveLock.unlock();
@@ -242,14 +310,25 @@ void vtkSlicerApplicationLogic::TerminateProcessingThread()
     this->WriteDataQueueActive = false;
     this->WriteDataQueueActiveLock.unlock();
 
-    this->ProcessingThreadActiveLock.lock();
-    this->ProcessingThreadActive = false;
-    this->ProcessingThreadActiveLock.unlock();
-
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-    this->ProcessingThreadId = -1;
+    // Wake up the idle threads so that they can terminate. Running tasks are
+    // completed, queued tasks are canceled.
+    this->InternalTaskQueue->Mutex.lock();
+    this->InternalTaskQueue->Active = false;
+    this->InternalTaskQueue->CancelTasks(this->InternalTaskQueue->ProcessingTasks);
+    this->InternalTaskQueue->CancelTasks(this->InternalTaskQueue->NetworkingTasks);
+    this->InternalTaskQueue->Mutex.unlock();
+    this->InternalTaskQueue->ProcessingTaskAvailable.notify_all();
+    this->InternalTaskQueue->NetworkingTaskAvailable.notify_all();
 
     std::vector<int>::const_iterator idIterator;
+    idIterator = this->ProcessingThreadIDs.begin();
+    while (idIterator != this->ProcessingThreadIDs.end())
+      {
+      this->ProcessingThreader->TerminateThread( *idIterator );
+      ++idIterator;
+      }
+    this->ProcessingThreadIDs.clear();
+
     idIterator = this->NetworkingThreadIDs.begin();
     while (idIterator != this->NetworkingThreadIDs.end())
       {
@@ -298,52 +377,29 @@ vtkSlicerApplicationLogic
 }
 
 //----------------------------------------------------------------------------
-void vtkSlicerApplicationLogic::ProcessProcessingTasks()
+void vtkSlicerApplicationLogic::RunTask(vtkSlicerTask* task)
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = nullptr;
-
-  while (active)
+  if (!task->SetState(vtkSlicerTask::Running))
     {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock.lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock.unlock();
-
-    if (active)
-      {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock.lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-
-        // only handle processing tasks in this thread
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Processing )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = nullptr;
-          }
-        }
-      this->ProcessingTaskQueueLock.unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = nullptr;
-        }
-      }
+    return;
+    }
+  task->Execute();
+  task->SetState(vtkSlicerTask::Completed);
+}
 
-    // busy wait
-    itksys::SystemTools::Delay(100);
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::ProcessProcessingTasks()
+{
+  // Wait for a task to be scheduled, until the threads are terminated
+  ProcessingTaskQueue* queue = this->InternalTaskQueue;
+  while (vtkSmartPointer<vtkSlicerTask> task =
+         queue->WaitForTask(queue->ProcessingTasks, queue->ProcessingTaskAvailable))
+    {
+    vtkSlicerApplicationLogic::RunTask(task);
     }
 }
 
+//----------------------------------------------------------------------------
 itk::ITK_THREAD_RETURN_TYPE
 vtkSlicerApplicationLogic
 ::NetworkingThreaderCallback( void *arg )
@@ -382,66 +438,78 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = nullptr;
-
-  while (active)
+  // Wait for a task to be scheduled, until the threads are terminated
+  ProcessingTaskQueue* queue = this->InternalTaskQueue;
+  while (vtkSmartPointer<vtkSlicerTask> task =
+         queue->WaitForTask(queue->NetworkingTasks, queue->NetworkingTaskAvailable))
     {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock.lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock.unlock();
-
-    if (active)
-      {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock.lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Networking )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = nullptr;
-          }
-        }
-      this->ProcessingTaskQueueLock.unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = nullptr;
-        }
-      }
-
-    // busy wait
-    itksys::SystemTools::Delay(100);
+    vtkSlicerApplicationLogic::RunTask(task);
     }
 }
 
 //----------------------------------------------------------------------------
 int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
 {
-  // only schedule a task if the processing task is up
-  this->ProcessingThreadActiveLock.lock();
-  int active = this->ProcessingThreadActive;
-  this->ProcessingThreadActiveLock.unlock();
-  if (!active)
+  if (!task)
     {
     return false;
     }
-
-  this->ProcessingTaskQueueLock.lock();
-  (*this->InternalTaskQueue).push( task );
-  this->ProcessingTaskQueueLock.unlock();
+  ProcessingTaskQueue* queue = this->InternalTaskQueue;
+  bool networking = (task->GetType() == vtkSlicerTask::Networking);
+  {
+  std::lock_guard<std::mutex> lock(queue->Mutex);
+  // only schedule a task if the processing threads are up
+  if (!queue->Active)
+    {
+    return false;
+    }
+  if (!task->SetState(vtkSlicerTask::Queued))
+    {
+    // canceled task
+    return false;
+    }
+  ProcessingTaskQueue::QueuedTask queuedTask;
+  queuedTask.Task = task;
+  queuedTask.Priority = task->GetPriority();
+  queuedTask.Sequence = queue->NextSequence++;
+  (networking ? queue->NetworkingTasks : queue->ProcessingTasks).push(queuedTask);
+  }
+  // wake up an idle thread
+  if (networking)
+    {
+    queue->NetworkingTaskAvailable.notify_one();
+    }
+  else
+    {
+    queue->ProcessingTaskAvailable.notify_one();
+    }
   return true;
 }
 
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfQueuedTasks()
+{
+  std::lock_guard<std::mutex> lock(this->InternalTaskQueue->Mutex);
+  return static_cast<int>(this->InternalTaskQueue->ProcessingTasks.size()
+    + this->InternalTaskQueue->NetworkingTasks.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::InvokeRequestProcessingEvent(unsigned long requestEvent)
+{
+  // The event is invoked in the main thread, which then calls
+  // ProcessModified(), ProcessReadData() or ProcessWriteData().
+  this->InvokeEventWithDelay(0, this, requestEvent, &RequestProcessingDelay);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::PostedEventCallback(void* clientData)
+{
+  // Called by the event broker from the posting thread
+  vtkSlicerApplicationLogic* self = reinterpret_cast<vtkSlicerApplicationLogic*>(clientData);
+  self->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestModifiedEvent);
+}
+
 //----------------------------------------------------------------------------
 vtkMTimeType vtkSlicerApplicationLogic::RequestModified(vtkObject *obj)
 {
@@ -449,18 +517,21 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestModified(vtkObject *obj)
   this->ModifiedQueueActiveLock.lock();
   int active = this->ModifiedQueueActive;
   this->ModifiedQueueActiveLock.unlock();
-  if (!active)
+  if (!active || !obj)
     {
     // could not request the Modified
     return 0;
     }
 
-  obj->Register(this);
-  this->ModifiedQueueLock.lock();
+  // RequestTimeStamp is shared with the read and write data requests
+  this->ReadDataQueueLock.lock();
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
-  (*this->InternalModifiedQueue).push(obj);
-  this->ModifiedQueueLock.unlock();
+  this->ReadDataQueueLock.unlock();
+
+  // The object is registered by the event broker until Modified() is
+  // called in the main thread by ProcessModified().
+  vtkEventBroker::GetInstance()->PostEvent(obj, vtkCommand::ModifiedEvent);
   return uid;
 }
 
@@ -482,7 +553,13 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestReadFile(const char *refNode, con
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(
     new ReadDataRequestFile(refNode, filename, displayData, deleteFile, uid));
+  bool scheduleProcessing = !this->ReadDataProcessingScheduled;
+  this->ReadDataProcessingScheduled = true;
   this->ReadDataQueueLock.unlock();
+  if (scheduleProcessing)
+    {
+    this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -503,7 +580,13 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestUpdateParentTransform(const std::
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(new ReadDataRequestUpdateParentTransform(refNode, parentTransformNode, uid));
+  bool scheduleProcessing = !this->ReadDataProcessingScheduled;
+  this->ReadDataProcessingScheduled = true;
   this->ReadDataQueueLock.unlock();
+  if (scheduleProcessing)
+    {
+    this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -524,7 +607,13 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestUpdateSubjectHierarchyLocation(co
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(new ReadDataRequestUpdateSubjectHierarchyLocation(updatedNode, siblingNode, uid));
+  bool scheduleProcessing = !this->ReadDataProcessingScheduled;
+  this->ReadDataProcessingScheduled = true;
   this->ReadDataQueueLock.unlock();
+  if (scheduleProcessing)
+    {
+    this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -545,7 +634,13 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestAddNodeReference(const std::strin
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(new ReadDataRequestAddNodeReference(referencingNode, referencedNode, role, uid));
+  bool scheduleProcessing = !this->ReadDataProcessingScheduled;
+  this->ReadDataProcessingScheduled = true;
   this->ReadDataQueueLock.unlock();
+  if (scheduleProcessing)
+    {
+    this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -567,7 +662,13 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestWriteData(const char *refNode, co
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalWriteDataQueue).push(
     new WriteDataRequestFile(refNode, filename, uid) );
+  bool scheduleProcessing = !this->WriteDataProcessingScheduled;
+  this->WriteDataProcessingScheduled = true;
   this->WriteDataQueueLock.unlock();
+  if (scheduleProcessing)
+    {
+    this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent);
+    }
   return uid;
 }
 
@@ -593,7 +694,13 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestReadScene(
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(
     new ReadDataRequestScene(targetIDs, sourceIDs, filename, displayData, deleteFile, uid));
+  bool scheduleProcessing = !this->ReadDataProcessingScheduled;
+  this->ReadDataProcessingScheduled = true;
   this->ReadDataQueueLock.unlock();
+  if (scheduleProcessing)
+    {
+    this->InvokeRequestProcessingEvent(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -609,37 +716,10 @@ void vtkSlicerApplicationLogic::ProcessModified()
     return;
     }
 
-  vtkSmartPointer<vtkObject> obj = nullptr;
-  // pull an object off the queue to modify
-  this->ModifiedQueueLock.lock();
-  if ((*this->InternalModifiedQueue).size() > 0)
-    {
-    obj = (*this->InternalModifiedQueue).front();
-    (*this->InternalModifiedQueue).pop();
-
-    // pop off any extra copies of the same object to save some updates
-    while (!(*this->InternalModifiedQueue).empty()
-           && (obj == (*this->InternalModifiedQueue).front()))
-      {
-      (*this->InternalModifiedQueue).pop();
-      obj->Delete(); // decrement ref count
-      }
-    }
-  this->ModifiedQueueLock.unlock();
-
-  // Modify the object
-  //  - decrement reference count that was increased when it was added to the queue
-  if (obj.GetPointer())
-    {
-    obj->Modified();
-    obj->Delete();
-    obj = nullptr;
-    }
-
-  // schedule the next timer sooner in case there is stuff in the queue
-  // otherwise for a while later
-  int delay = (*this->InternalModifiedQueue).size() > 0 ? 0: 200;
-  this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
+  // Invoke the events posted to the event broker so far (including the
+  // Modified() calls requested by RequestModified()), in posting order.
+  // Events posted from now on schedule another call.
+  vtkEventBroker::GetInstance()->ProcessPostedEvents();
 }
 
 //----------------------------------------------------------------------------
@@ -662,6 +742,9 @@ void vtkSlicerApplicationLogic::ProcessReadData()
     req = (*this->InternalReadDataQueue).front();
     (*this->InternalReadDataQueue).pop();
     }
+  // process the next request right after this one, or wait for a new request
+  bool processNext = !(*this->InternalReadDataQueue).empty();
+  this->ReadDataProcessingScheduled = processNext;
   this->ReadDataQueueLock.unlock();
 
   vtkMTimeType uid = 0;
@@ -672,10 +755,11 @@ void vtkSlicerApplicationLogic::ProcessReadData()
     delete req;
     }
 
-  int delay = (*this->InternalReadDataQueue).size() > 0 ? 0: 200;
-  // schedule the next timer sooner in case there is stuff in the queue
-  // otherwise for a while later
-  this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
+  if (processNext)
+    {
+    int delay = 0;
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
+    }
   if (uid)
     {
     this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
@@ -703,6 +787,9 @@ void vtkSlicerApplicationLogic::ProcessWriteData()
     req = (*this->InternalWriteDataQueue).front();
     (*this->InternalWriteDataQueue).pop();
     }
+  // process the next request right after this one, or wait for a new request
+  bool processNext = !(*this->InternalWriteDataQueue).empty();
+  this->WriteDataProcessingScheduled = processNext;
   this->WriteDataQueueLock.unlock();
 
   if (req)
@@ -711,10 +798,11 @@ void vtkSlicerApplicationLogic::ProcessWriteData()
     req->Execute(this);
     delete req;
 
-    // schedule the next timer sooner in case there is stuff in the queue
-    // otherwise for a while later
-    int delay = (*this->InternalWriteDataQueue).size() > 0 ? 0 : 200;
-    this->InvokeEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent, &delay);
+    if (processNext)
+      {
+      int delay = 0;
+      this->InvokeEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent, &delay);
+      }
     if (uid)
       {
       this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
@@ -39,7 +39,6 @@ class vtkMRMLRemoteIOLogic;
 class vtkDataIOManagerLogic;
 class vtkPersonInformation;
 class vtkSlicerTask;
-class ModifiedQueue;
 class ProcessingTaskQueue;
 class ReadDataQueue;
 class ReadDataRequest;
@@ -72,11 +71,18 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// (display it in the Fiducials GUI)
   void PropagateFiducialListSelection();
 
-  /// Create a thread for processing
+  /// Create the threads that run the scheduled tasks: NumberOfProcessingThreads
+  /// threads for Processing tasks and one thread for Networking tasks.
   void CreateProcessingThread();
 
-  /// Shutdown the processing thread
+  /// Shutdown the processing threads. Tasks still in the queues are canceled.
   void TerminateProcessingThread();
+
+  /// Number of threads running Processing tasks concurrently.
+  /// It must be set before CreateProcessingThread() is called. Default is 4.
+  vtkSetClampMacro(NumberOfProcessingThreads, int, 1, 64);
+  vtkGetMacro(NumberOfProcessingThreads, int);
+
   /// List of events potentially fired by the application logic
   enum RequestEvents
     {
@@ -90,16 +96,23 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
       RequestProcessedEvent
     };
 
-  /// Schedule a task to run in the processing thread. Returns true if
-  /// task was successfully scheduled. ScheduleTask() is called from the
-  /// main thread to run something in the processing thread.
+  /// Schedule a task to run in a processing thread (or in the networking
+  /// thread for Networking tasks). Returns true if task was successfully
+  /// scheduled. Idle threads are woken up immediately, queued tasks are
+  /// started by decreasing vtkSlicerTask::Priority.
+  /// ScheduleTask() can be called from any thread.
+  /// \sa vtkSlicerTask::Cancel(), vtkSlicerTask::WaitForCompletion()
   int ScheduleTask( vtkSlicerTask* );
 
+  /// Number of tasks waiting to be started.
+  int GetNumberOfQueuedTasks();
+
   /// Request a Modified call on an object.  This method allows a
   /// processing thread to request a Modified call on an object to be
   /// performed in the main thread.  This allows the call to Modified
   /// to trigger GUI changes. RequestModified() is called from the
   /// processing thread to modify an object in the main thread.
+  /// The request is posted to the event broker (see vtkEventBroker::PostEvent()).
   /// Return the request UID (monotonically increasing) of the request or 0 if
   /// the request failed to be registered.
   /// \todo Fire RequestProcessedEvent when processing Modified requests.
@@ -170,10 +183,12 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
                        int displayData = false,
                        int deleteFile = false);
 
-  /// Process a request on the Modified queue.  This method is called
+  /// Invoke the events posted to the event broker, including the Modified
+  /// calls requested by RequestModified().  This method is called
   /// in the main thread of the application because calls to Modified()
   /// can cause an update to the GUI. (Method needs to be public to fit
   /// in the event callback chain.)
+  /// \sa vtkEventBroker::ProcessPostedEvents()
   void ProcessModified();
 
   /// Process a request to read data and set it on a referenced node.
@@ -238,6 +253,15 @@ protected:
   /// Networking Task processing loop that is run in a networking thread
   void ProcessNetworkingTasks();
 
+  /// Request the main thread to call ProcessModified(), ProcessReadData() or
+  /// ProcessWriteData() as soon as possible. Can be called from any thread.
+  void InvokeRequestProcessingEvent(unsigned long requestEvent);
+
+  /// Callback of the event broker, called when an event is posted while no
+  /// other posted event is pending. Requests the main thread to call
+  /// ProcessModified().
+  static void PostedEventCallback(void* clientData);
+
   /// Process a request to read data into a scene.  This method is
   /// called by ProcessReadData() in the application main thread
   /// because calls to load data will cause a Modified() on a node
@@ -249,25 +273,28 @@ private:
   vtkSlicerApplicationLogic(const vtkSlicerApplicationLogic&);
   void operator=(const vtkSlicerApplicationLogic&);
 
+  /// Run a task pulled off a task queue, unless it has been canceled.
+  /// Called from the processing and networking threads.
+  static void RunTask(vtkSlicerTask* task);
+
   itk::PlatformMultiThreader::Pointer ProcessingThreader;
-  std::mutex ProcessingThreadActiveLock;
-  std::mutex ProcessingTaskQueueLock;
   std::mutex ModifiedQueueActiveLock;
-  std::mutex ModifiedQueueLock;
   std::mutex ReadDataQueueActiveLock;
   std::mutex ReadDataQueueLock;
   std::mutex WriteDataQueueActiveLock;
   std::mutex WriteDataQueueLock;
   vtkTimeStamp RequestTimeStamp;
-  int ProcessingThreadId;
+  std::vector<int> ProcessingThreadIDs;
   std::vector<int> NetworkingThreadIDs;
-  int ProcessingThreadActive;
+  int NumberOfProcessingThreads;
   int ModifiedQueueActive;
   int ReadDataQueueActive;
   int WriteDataQueueActive;
+  /// Set when the main thread has been requested to process the queue
+  int ReadDataProcessingScheduled;
+  int WriteDataProcessingScheduled;
 
   ProcessingTaskQueue* InternalTaskQueue;
-  ModifiedQueue*       InternalModifiedQueue;
   ReadDataQueue*       InternalReadDataQueue;
   WriteDataQueue*      InternalWriteDataQueue;
 
@@ -287,6 +287,7 @@ public:
       }
 
     vtkNew<vtkMRMLScene> miniscene;
+    miniscene->SetNumberOfReadDataThreads(appLogic->GetMRMLScene()->GetNumberOfReadDataThreads());
     miniscene->SetURL(m_Filename.c_str() );
     miniscene->Import();
 
@@ -3,6 +3,21 @@
 // VTK includes
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+//----------------------------------------------------------------------------
+class vtkSlicerTask::vtkInternal
+{
+public:
+  std::mutex Mutex;
+  std::condition_variable StateChanged;
+  int State{vtkSlicerTask::Idle};
+  bool Canceled{false};
+};
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerTask);
 
@@ -13,10 +28,14 @@ vtkSlicerTask::vtkSlicerTask()
   this->TaskFunction = nullptr;
   this->TaskClientData = nullptr;
   this->Type = vtkSlicerTask::Undefined;
+  this->Priority = 0;
+  this->Internal = new vtkInternal;
 }
 //----------------------------------------------------------------------------
 vtkSlicerTask::~vtkSlicerTask()
-= default;
+{
+  delete this->Internal;
+}
 
 //----------------------------------------------------------------------------
 void vtkSlicerTask::SetTaskFunction(vtkMRMLAbstractLogic *object,
@@ -37,8 +56,83 @@ void vtkSlicerTask::Execute()
     }
 }
 
+//----------------------------------------------------------------------------
+int vtkSlicerTask::GetState()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->State;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::SetState(int state)
+{
+  {
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  if (this->Internal->Canceled && state != vtkSlicerTask::Completed)
+    {
+    // A canceled task is finished unless it is already running
+    if (this->Internal->State != vtkSlicerTask::Running)
+      {
+      this->Internal->State = vtkSlicerTask::Canceled;
+      }
+    this->Internal->StateChanged.notify_all();
+    return false;
+    }
+  this->Internal->State = state;
+  }
+  this->Internal->StateChanged.notify_all();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTask::Cancel()
+{
+  {
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->Canceled = true;
+  if (this->Internal->State == vtkSlicerTask::Queued)
+    {
+    // the task will be skipped when it is pulled off the queue
+    this->Internal->State = vtkSlicerTask::Canceled;
+    }
+  }
+  this->Internal->StateChanged.notify_all();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::IsCanceled()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  return this->Internal->Canceled;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::WaitForCompletion(double timeoutInSeconds)
+{
+  std::unique_lock<std::mutex> lock(this->Internal->Mutex);
+  auto isFinished = [this]()
+    {
+    return this->Internal->State == vtkSlicerTask::Idle
+      || this->Internal->State == vtkSlicerTask::Completed
+      || this->Internal->State == vtkSlicerTask::Canceled;
+    };
+  if (timeoutInSeconds < 0)
+    {
+    this->Internal->StateChanged.wait(lock, isFinished);
+    }
+  else
+    {
+    this->Internal->StateChanged.wait_for(lock, std::chrono::duration<double>(timeoutInSeconds), isFinished);
+    }
+  return this->Internal->State == vtkSlicerTask::Completed
+    || this->Internal->State == vtkSlicerTask::Canceled;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerTask::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "Type: " << this->GetTypeAsString() << "\n";
+  os << indent << "Priority: " << this->Priority << "\n";
+  os << indent << "State: " << this->GetState() << "\n";
 }
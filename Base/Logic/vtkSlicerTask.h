@@ -6,6 +6,11 @@
 #include "vtkMRMLAbstractLogic.h"
 #include "vtkSlicerBaseLogic.h"
 
+/// \brief Task run by the processing or networking threads of vtkSlicerApplicationLogic.
+///
+/// Tasks are scheduled with vtkSlicerApplicationLogic::ScheduleTask().
+/// Queued tasks with a higher priority are started first. A task can be
+/// canceled, and WaitForCompletion() can be used to wait for it to finish.
 class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerTask : public vtkObject
 {
 public:
@@ -38,6 +43,39 @@ public:
   void SetTypeToProcessing() {this->SetType(vtkSlicerTask::Processing);};
   void SetTypeToNetworking() {this->SetType(vtkSlicerTask::Networking);};
 
+  ///
+  /// Tasks with higher priority are started before queued tasks with
+  /// lower priority. Tasks of the same priority are started in the order
+  /// they were scheduled. Default is 0.
+  vtkSetMacro(Priority, int);
+  vtkGetMacro(Priority, int);
+
+  ///
+  /// State of the task in the application logic task queues.
+  enum
+    {
+    Idle = 0,
+    Queued,
+    Running,
+    Completed,
+    Canceled
+    };
+  int GetState();
+
+  ///
+  /// Cancel the task. A queued task is not run. A running task is not
+  /// interrupted, but the task function can check IsCanceled() to stop
+  /// early. Can be called from any thread.
+  void Cancel();
+  bool IsCanceled();
+
+  ///
+  /// Block until the task is completed or canceled. Returns false if the
+  /// task was not finished after timeoutInSeconds (negative value means no
+  /// timeout) or if it is not scheduled. Must not be called from the
+  /// task function.
+  bool WaitForCompletion(double timeoutInSeconds = -1.0);
+
   const char* GetTypeAsString( ) {
     switch (this->Type)
       {
@@ -54,13 +92,21 @@ protected:
   vtkSlicerTask(const vtkSlicerTask&);
   void operator=(const vtkSlicerTask&);
 
+  /// Set the state and wake up threads waiting for completion.
+  /// Returns false if the task is canceled (the state is then not changed).
+  bool SetState(int state);
+  friend class vtkSlicerApplicationLogic;
+
 private:
   vtkSmartPointer<vtkMRMLAbstractLogic> TaskObject;
   vtkMRMLAbstractLogic::TaskFunctionPointer TaskFunction;
   void *TaskClientData;
 
   int Type;
+  int Priority;
 
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 #endif
 
@@ -16,6 +16,10 @@
 // STD includes
 #include <fstream>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 // Use an anonymous namespace to keep class types and function names
 // from colliding when module is used as shared object module.  Every
 // thing should be in an anonymous namespace except for the module
@@ -42,6 +46,31 @@ bool outputResult(int result, const std::string& outputFile)
   return true;
   }
 
+// Copy the file written by Slicer for the input volume into the file
+// read by Slicer for the output volume and report the permissions of the
+// input file.
+bool copyVolume(const std::string& inputFile, const std::string& outputFile)
+  {
+  std::ifstream input(inputFile.c_str(), std::ios::binary);
+  std::ofstream output(outputFile.c_str(), std::ios::binary);
+  if (!input.is_open() || !output.is_open())
+    {
+    std::cerr << "Failed to copy file:" << inputFile << " to " << outputFile << std::endl;
+    return false;
+    }
+  output << input.rdbuf();
+
+  std::cout << "Input volume:" << inputFile << std::endl;
+#ifndef _WIN32
+  struct stat inputStat;
+  if (stat(inputFile.c_str(), &inputStat) == 0)
+    {
+    std::cout << "Input volume permissions:" << std::oct << (inputStat.st_mode & 0777) << std::dec << std::endl;
+    }
+#endif
+  return true;
+  }
+
 } // end of anonymous namespace
 
 
@@ -71,5 +100,11 @@ int main(int argc, char * argv[])
     return EXIT_FAILURE;
     }
 
+  if (!InputVolume.empty() && !OutputVolume.empty()
+      && !copyVolume(InputVolume, OutputVolume))
+    {
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,331 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SlicerExecutionModel includes
+#include <ModuleDescription.h>
+#include <ModuleDescriptionParser.h>
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerCLIModuleLogic.h"
+
+// MRML includes
+#include <vtkMRMLCommandLineModuleNode.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/DynamicLoader.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// Run the CLIModule4Test module with vtkSlicerCLIModuleLogic, as an
+// executable and as a shared object module.
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+int ReadModuleDescription(const std::string& xmlFileName, const std::string& executable,
+                          ModuleDescription& description)
+{
+  std::ifstream xmlFile(xmlFileName.c_str());
+  CHECK_BOOL(xmlFile.is_open(), true);
+  std::stringstream xml;
+  xml << xmlFile.rdbuf();
+  ModuleDescriptionParser parser;
+  CHECK_INT(parser.Parse(xml.str(), description), 0);
+  description.SetType("CommandLineModule");
+  description.SetTarget(executable);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int ResolveSharedObjectModule(const std::string& library, ModuleDescription& description)
+{
+  // the library is not unloaded, the module may register ITK factories
+  vtksys::DynamicLoader::LibraryHandle handle = vtksys::DynamicLoader::OpenLibrary(library);
+  CHECK_NOT_NULL(handle);
+  typedef int (*ModuleEntryPointType)(int argc, char* argv[]);
+  ModuleEntryPointType moduleEntryPoint = reinterpret_cast<ModuleEntryPointType>(
+    vtksys::DynamicLoader::GetSymbolAddress(handle, "ModuleEntryPoint"));
+  CHECK_NOT_NULL(reinterpret_cast<void*>(moduleEntryPoint));
+  char buffer[256];
+  sprintf(buffer, "slicer:%p", moduleEntryPoint);
+  description.SetType("SharedObjectModule");
+  description.SetTarget(buffer);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* AddInputVolume(vtkMRMLScene* scene)
+{
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(16, 16, 8);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  imageData->GetPointData()->GetScalars()->FillComponent(0, 7);
+  vtkNew<vtkMRMLScalarVolumeNode> inputVolumeNode;
+  inputVolumeNode->SetAndObserveImageData(imageData.GetPointer());
+  inputVolumeNode->SetOrigin(1.0, 2.0, 3.0);
+  scene->AddNode(inputVolumeNode.GetPointer());
+  return inputVolumeNode.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+int CheckOutputVolume(vtkMRMLScalarVolumeNode* outputVolumeNode)
+{
+  CHECK_NOT_NULL(outputVolumeNode->GetImageData());
+  int dimensions[3] = { 0, 0, 0 };
+  outputVolumeNode->GetImageData()->GetDimensions(dimensions);
+  CHECK_INT(dimensions[0], 16);
+  CHECK_INT(dimensions[1], 16);
+  CHECK_INT(dimensions[2], 8);
+  CHECK_DOUBLE(outputVolumeNode->GetImageData()->GetScalarComponentAsDouble(5, 5, 5, 0), 7.0);
+  CHECK_DOUBLE(outputVolumeNode->GetOrigin()[2], 3.0);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::string ReadFile(const std::string& fileName)
+{
+  std::ifstream file(fileName.c_str());
+  std::string content;
+  std::getline(file, content);
+  return content;
+}
+
+//----------------------------------------------------------------------------
+// Return the value following "<key>:" in the output of the module
+std::string GetOutputValue(const std::string& outputText, const std::string& key)
+{
+  std::istringstream lines(outputText);
+  std::string line;
+  while (std::getline(lines, line))
+    {
+    if (line.compare(0, key.size() + 1, key + ":") == 0)
+      {
+      return line.substr(key.size() + 1);
+      }
+    }
+  return std::string();
+}
+
+//----------------------------------------------------------------------------
+int TestSharedMemoryTransfer(vtkSlicerCLIModuleLogic* logic, vtkMRMLScene* scene,
+                             const std::string& tempDir)
+{
+  std::string sharedMemoryDirectory = logic->GetSharedMemoryDirectory();
+  if (sharedMemoryDirectory.empty()
+      || !vtksys::SystemTools::FileIsDirectory(sharedMemoryDirectory))
+    {
+    std::cout << "Shared memory transfer is not available, test skipped" << std::endl;
+    return EXIT_SUCCESS;
+    }
+  CHECK_INT(logic->GetAllowSharedMemoryTransfer(), 1);
+
+  vtkMRMLScalarVolumeNode* inputVolumeNode = AddInputVolume(scene);
+  vtkNew<vtkMRMLScalarVolumeNode> outputVolumeNode;
+  scene->AddNode(outputVolumeNode.GetPointer());
+
+  vtkMRMLCommandLineModuleNode* cliNode = logic->CreateNodeInScene();
+  std::string outputFile = tempDir + "/vtkSlicerCLIModuleLogicTest1_SharedMemory.txt";
+  cliNode->SetParameterAsString("OutputFile", outputFile);
+  cliNode->SetParameterAsString("InputVolume", inputVolumeNode->GetID());
+  cliNode->SetParameterAsString("OutputVolume", outputVolumeNode->GetID());
+  logic->ApplyAndWait(cliNode, false);
+  CHECK_INT(cliNode->GetStatus(), vtkMRMLCommandLineModuleNode::Completed);
+
+  // the volume went through a private file in the shared memory directory
+  std::string inputFile = GetOutputValue(cliNode->GetOutputText(), "Input volume");
+  CHECK_STD_STRING(vtksys::SystemTools::GetParentDirectory(inputFile), sharedMemoryDirectory);
+#ifndef _WIN32
+  CHECK_STD_STRING(GetOutputValue(cliNode->GetOutputText(), "Input volume permissions"), "600");
+#endif
+
+  // the data is unchanged
+  CHECK_EXIT_SUCCESS(CheckOutputVolume(outputVolumeNode.GetPointer()));
+
+  // the input and output files are removed
+  CHECK_BOOL(vtksys::SystemTools::FileExists(inputFile), false);
+  std::string inputFileName = vtksys::SystemTools::GetFilenameName(inputFile);
+  // file names start with a prefix specific to the process
+  std::string processPrefix = inputFileName.substr(0, inputFileName.find('_') + 1);
+  vtksys::Directory directory;
+  CHECK_BOOL(directory.Load(sharedMemoryDirectory), true);
+  for (unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i)
+    {
+    std::string fileName = directory.GetFile(i);
+    if (fileName.compare(0, processPrefix.size(), processPrefix) == 0)
+      {
+      std::cerr << "Line " << __LINE__ << " - Temporary file was not removed: "
+                << sharedMemoryDirectory << "/" << fileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtksys::SystemTools::RemoveFile(outputFile);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Run the jobs of a batch at the same time, with the same input volume.
+// All the jobs are run by the same logic: each one must be completed
+// once its outputs are loaded.
+int TestConcurrentJobs(vtkSlicerApplicationLogic* appLogic, vtkSlicerCLIModuleLogic* logic,
+                       vtkMRMLScene* scene, const std::string& tempDir, int numberOfJobs)
+{
+  vtkMRMLScalarVolumeNode* inputVolumeNode = AddInputVolume(scene);
+  vtkMRMLCommandLineModuleNode* templateNode = logic->CreateNodeInScene();
+  templateNode->SetParameterAsString("InputVolume", inputVolumeNode->GetID());
+
+  std::vector<vtkSlicerCLIModuleLogic::BatchJobParameters> jobParameters(numberOfJobs);
+  std::vector<vtkSmartPointer<vtkMRMLScalarVolumeNode> > outputVolumeNodes;
+  std::vector<std::string> outputFiles;
+  for (int jobIndex = 0; jobIndex < numberOfJobs; ++jobIndex)
+    {
+    vtkNew<vtkMRMLScalarVolumeNode> outputVolumeNode;
+    scene->AddNode(outputVolumeNode.GetPointer());
+    outputVolumeNodes.push_back(outputVolumeNode.GetPointer());
+    std::stringstream outputFile;
+    outputFile << tempDir << "/vtkSlicerCLIModuleLogicTest1_" << templateNode->GetID() << "_" << jobIndex << ".txt";
+    outputFiles.push_back(outputFile.str());
+    std::stringstream inputValue;
+    inputValue << 10 * (jobIndex + 1);
+    jobParameters[jobIndex]["InputValue1"] = inputValue.str();
+    jobParameters[jobIndex]["OutputFile"] = outputFile.str();
+    jobParameters[jobIndex]["OutputVolume"] = outputVolumeNode->GetID();
+    }
+
+  vtkNew<vtkCollection> jobNodes;
+  int batchID = logic->ApplyBatch(templateNode, jobParameters, jobNodes.GetPointer());
+  CHECK_BOOL(batchID > 0, true);
+  CHECK_INT(jobNodes->GetNumberOfItems(), numberOfJobs);
+
+  // Process the requests of the jobs (done by the application event loop)
+  double timeout = vtkTimerLog::GetUniversalTime() + 60.0;
+  bool busy = true;
+  while (busy && vtkTimerLog::GetUniversalTime() < timeout)
+    {
+    appLogic->ProcessReadData();
+    appLogic->ProcessModified();
+    busy = false;
+    for (int jobIndex = 0; jobIndex < numberOfJobs; ++jobIndex)
+      {
+      busy = busy || vtkMRMLCommandLineModuleNode::SafeDownCast(jobNodes->GetItemAsObject(jobIndex))->IsBusy();
+      }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  CHECK_BOOL(busy, false);
+  CHECK_INT(logic->GetBatchStatistics(batchID).NumberOfCompletedJobs, numberOfJobs);
+  CHECK_INT(logic->GetBatchStatistics(batchID).NumberOfFailedJobs, 0);
+
+  std::vector<std::string> inputFiles;
+  for (int jobIndex = 0; jobIndex < numberOfJobs; ++jobIndex)
+    {
+    vtkMRMLCommandLineModuleNode* jobNode =
+      vtkMRMLCommandLineModuleNode::SafeDownCast(jobNodes->GetItemAsObject(jobIndex));
+    CHECK_INT(jobNode->GetStatus(), vtkMRMLCommandLineModuleNode::Completed);
+
+    // the output of each job is captured separately
+    std::string outputText = jobNode->GetOutputText();
+    std::string inputFile = GetOutputValue(outputText, "Input volume");
+    CHECK_BOOL(inputFile.empty(), false);
+    CHECK_BOOL(outputText.find("Input volume:") == outputText.rfind("Input volume:"), true);
+    for (std::vector<std::string>::iterator it = inputFiles.begin(); it != inputFiles.end(); ++it)
+      {
+      // the same input node is written in a different file for each job
+      CHECK_STD_STRING_DIFFERENT(*it, inputFile);
+      }
+    inputFiles.push_back(inputFile);
+
+    std::stringstream expectedResult;
+    expectedResult << 10 * (jobIndex + 1) + 1;
+    CHECK_STD_STRING(ReadFile(outputFiles[jobIndex]), expectedResult.str());
+    vtksys::SystemTools::RemoveFile(outputFiles[jobIndex]);
+    CHECK_EXIT_SUCCESS(CheckOutputVolume(outputVolumeNodes[jobIndex]));
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogicTest1(int argc, char * argv[])
+{
+  if (argc != 5)
+    {
+    std::cerr << "Usage: " << argv[0]
+              << " /path/to/CLIModule4Test /path/to/CLIModule4TestLib /path/to/CLIModule4Test.xml /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string executable = argv[1];
+  std::string library = argv[2];
+  std::string xmlFileName = argv[3];
+  std::string tempDir = argv[4];
+
+  ModuleDescription description;
+  CHECK_EXIT_SUCCESS(ReadModuleDescription(xmlFileName, executable, description));
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetMRMLScene(scene.GetPointer());
+  appLogic->SetTemporaryPath(tempDir.c_str());
+  appLogic->SetNumberOfProcessingThreads(4);
+
+  vtkNew<vtkSlicerCLIModuleLogic> logic;
+  logic->SetMRMLApplicationLogic(appLogic.GetPointer());
+  logic->SetMRMLScene(scene.GetPointer());
+  logic->SetDefaultModuleDescription(description);
+
+  CHECK_EXIT_SUCCESS(TestSharedMemoryTransfer(logic.GetPointer(), scene.GetPointer(), tempDir));
+
+  // Shared object module, the files are used instead of the scene to
+  // exchange the volumes (the module does not use the MRML image IO)
+  ModuleDescription sharedObjectDescription = description;
+  CHECK_EXIT_SUCCESS(ResolveSharedObjectModule(library, sharedObjectDescription));
+  vtkNew<vtkSlicerCLIModuleLogic> sharedObjectLogic;
+  sharedObjectLogic->SetMRMLApplicationLogic(appLogic.GetPointer());
+  sharedObjectLogic->SetMRMLScene(scene.GetPointer());
+  sharedObjectLogic->SetDefaultModuleDescription(sharedObjectDescription);
+  sharedObjectLogic->SetAllowInMemoryTransfer(0);
+
+  appLogic->CreateProcessingThread();
+  CHECK_EXIT_SUCCESS(TestConcurrentJobs(appLogic.GetPointer(), logic.GetPointer(), scene.GetPointer(), tempDir, 2));
+  // more jobs than processing threads
+  CHECK_EXIT_SUCCESS(TestConcurrentJobs(appLogic.GetPointer(), logic.GetPointer(), scene.GetPointer(), tempDir, 10));
+  CHECK_EXIT_SUCCESS(TestConcurrentJobs(appLogic.GetPointer(), sharedObjectLogic.GetPointer(), scene.GetPointer(), tempDir, 6));
+  appLogic->TerminateProcessingThread();
+
+  sharedObjectLogic->SetMRMLScene(nullptr);
+  sharedObjectLogic->SetMRMLApplicationLogic(nullptr);
+  logic->SetMRMLScene(nullptr);
+  logic->SetMRMLApplicationLogic(nullptr);
+  return EXIT_SUCCESS;
+}
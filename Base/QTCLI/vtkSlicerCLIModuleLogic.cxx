@@ -30,16 +30,23 @@
 #include <vtkMRMLStorageNode.h>
 #include <vtkMRMLModelStorageNode.h>
 #include <vtkMRMLTransformNode.h>
+#include <vtkMRMLVolumeNode.h>
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointSet.h>
 #include <vtkStringArray.h>
+#include <vtkTimerLog.h>
 #include <vtksys/SystemTools.hxx>
 
+// ITK includes
+#include <itkMultiThreaderBase.h>
+
 // ITKSYS includes
 #include <itksys/Process.h>
 #include <itksys/SystemTools.hxx>
@@ -54,13 +61,19 @@
 
 // STL includes
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <ctime>
+#include <map>
 #include <mutex>
 #include <set>
+#include <thread>
 
 #ifdef _WIN32
 #else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
@@ -79,6 +92,27 @@ struct DigitsToCharacters
     }
 };
 
+//----------------------------------------------------------------------------
+// Prefix of temporary file names: the process id followed by a number that
+// is incremented for each name, so that modules running at the same time
+// (in different processing threads) never use the same file.
+// To avoid confusing the Archetype readers, the numbers are converted to
+// characters [0-9]->[A-J].
+static std::string ConstructUniqueTemporaryFilePrefix()
+{
+  static std::atomic<unsigned long> temporaryFileCount(0);
+  std::ostringstream prefixString;
+#ifdef _WIN32
+  prefixString << GetCurrentProcessId();
+#else
+  prefixString << getpid();
+#endif
+  prefixString << "_" << temporaryFileCount++;
+  std::string prefix = prefixString.str();
+  std::transform(prefix.begin(), prefix.end(), prefix.begin(), DigitsToCharacters());
+  return prefix;
+}
+
 typedef std::pair<vtkSlicerCLIModuleLogic *, vtkMRMLCommandLineModuleNode *> LogicNodePair;
 class MRMLIDMap : public std::map<std::string, std::string> {};
 
@@ -92,8 +126,13 @@ public:
   }
   void Execute(vtkObject* caller, unsigned long eid, void *callData) override
   {
-    if (std::find(this->ThreadIDs.begin(), this->ThreadIDs.end(),
-                  vtkMultiThreader::GetCurrentThreadID()) != this->ThreadIDs.end())
+    bool reschedule = false;
+    {
+    std::lock_guard<std::mutex> lock(this->ThreadIDsLock);
+    reschedule = (std::find(this->ThreadIDs.begin(), this->ThreadIDs.end(),
+                            vtkMultiThreader::GetCurrentThreadID()) != this->ThreadIDs.end());
+    }
+    if (reschedule)
       {
       if (this->CLIModuleLogic)
         {
@@ -129,6 +168,7 @@ public:
       {
       return;
       }
+    std::lock_guard<std::mutex> lock(this->ThreadIDsLock);
     if (reschedule)
       {
       this->ThreadIDs.push_back(id);
@@ -151,7 +191,10 @@ protected:
 
   vtkSlicerCLIModuleLogic* CLIModuleLogic;
   int Delay;
+  /// Threads of the CLI tasks being executed. CLI tasks run concurrently and
+  /// the events are invoked from any thread: ThreadIDsLock guards the list.
   std::vector<vtkMultiThreaderIDType> ThreadIDs;
+  std::mutex ThreadIDsLock;
 };
 
 //---------------------------------------------------------------------------
@@ -199,12 +242,125 @@ public:
   ModuleDescription DefaultModuleDescription;
   int DeleteTemporaryFiles;
   int AllowInMemoryTransfer;
+  int AllowSharedMemoryTransfer;
+  std::string SharedMemoryDirectory;
+  int NumberOfThreadsPerBatchJob;
 
   int RedirectModuleStreams;
 
   std::mutex ProcessesKillLock;
   std::vector<itksysProcess*> Processes;
 
+  /// Shared object modules write in std::cout and std::cerr and use the
+  /// global number of threads of ITK and VTK. These are shared by all the
+  /// modules of the application (not only the ones of this logic): only
+  /// one shared object module runs at a time.
+  static std::mutex SharedObjectModuleLock;
+
+  /// Lock the environment variables while starting a CLI process.
+  /// The environment is shared by all the logics of the application.
+  static std::mutex ProcessEnvironmentLock;
+
+  /// Limit the global maximum number of threads of ITK and VTK while a
+  /// shared object module runs and restore it when going out of scope.
+  /// Must be used while SharedObjectModuleLock is locked.
+  /// \sa ApplyBatch()
+  struct GlobalNumberOfThreadsLimit
+  {
+    GlobalNumberOfThreadsLimit(int numberOfThreads)
+      : ITKMaximumNumberOfThreads(itk::MultiThreaderBase::GetGlobalMaximumNumberOfThreads())
+      , ITKDefaultNumberOfThreads(itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+      , VTKMaximumNumberOfThreads(vtkMultiThreader::GetGlobalMaximumNumberOfThreads())
+      , Limited(numberOfThreads > 0)
+    {
+      if (!this->Limited)
+        {
+        return;
+        }
+      itk::MultiThreaderBase::SetGlobalMaximumNumberOfThreads(numberOfThreads);
+      itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(numberOfThreads);
+      vtkMultiThreader::SetGlobalMaximumNumberOfThreads(numberOfThreads);
+    }
+    ~GlobalNumberOfThreadsLimit()
+    {
+      if (!this->Limited)
+        {
+        return;
+        }
+      itk::MultiThreaderBase::SetGlobalMaximumNumberOfThreads(this->ITKMaximumNumberOfThreads);
+      itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(this->ITKDefaultNumberOfThreads);
+      vtkMultiThreader::SetGlobalMaximumNumberOfThreads(this->VTKMaximumNumberOfThreads);
+    }
+    itk::ThreadIdType ITKMaximumNumberOfThreads;
+    itk::ThreadIdType ITKDefaultNumberOfThreads;
+    int VTKMaximumNumberOfThreads;
+    bool Limited;
+  };
+
+  struct BatchRecord
+  {
+    double StartTime;
+    double EndTime;
+    BatchStatistics Statistics;
+  };
+  std::mutex BatchLock;
+  std::map<int, BatchRecord> Batches;
+  int LastBatchID;
+
+  /// Record the execution of a batch job (if the node has a "BatchID"
+  /// attribute) when going out of scope.
+  /// \sa ApplyBatch()
+  struct BatchJobTimer
+  {
+    BatchJobTimer(vtkInternal* internal, vtkMRMLCommandLineModuleNode* node)
+      : Internal(internal)
+      , Node(node)
+      , StartTime(vtkTimerLog::GetUniversalTime())
+    {
+    }
+    ~BatchJobTimer()
+    {
+      const char* batchID = this->Node->GetAttribute("BatchID");
+      if (!batchID)
+        {
+        return;
+        }
+      double endTime = vtkTimerLog::GetUniversalTime();
+      int status = this->Node->GetStatus();
+      bool failed = (status == vtkMRMLCommandLineModuleNode::CompletedWithErrors
+                     || status == vtkMRMLCommandLineModuleNode::Cancelled);
+      std::lock_guard<std::mutex> lock(this->Internal->BatchLock);
+      std::map<int, BatchRecord>::iterator batchIt = this->Internal->Batches.find(atoi(batchID));
+      if (batchIt == this->Internal->Batches.end())
+        {
+        return;
+        }
+      BatchRecord& batch = batchIt->second;
+      if (failed)
+        {
+        ++batch.Statistics.NumberOfFailedJobs;
+        }
+      else
+        {
+        ++batch.Statistics.NumberOfCompletedJobs;
+        }
+      batch.Statistics.TotalJobTime += endTime - this->StartTime;
+      if (batch.Statistics.NumberOfCompletedJobs + batch.Statistics.NumberOfFailedJobs
+          == batch.Statistics.NumberOfJobs)
+        {
+        batch.EndTime = endTime;
+        double elapsedTime = batch.EndTime - batch.StartTime;
+        qDebug() << "CLI batch" << batchIt->first << "completed:"
+                 << batch.Statistics.NumberOfCompletedJobs << "jobs succeeded,"
+                 << batch.Statistics.NumberOfFailedJobs << "failed in"
+                 << elapsedTime << "s (" << batch.Statistics.TotalJobTime << "s of job execution)";
+        }
+    }
+    vtkInternal* Internal;
+    vtkMRMLCommandLineModuleNode* Node;
+    double StartTime;
+  };
+
   typedef std::vector<std::pair<vtkMTimeType, vtkMRMLCommandLineModuleNode*> > RequestType;
   struct FindRequest
   {
@@ -227,6 +383,9 @@ public:
     vtkMTimeType LastRequestUID;
   };
 
+  /// Must be called with LastRequestsLock locked, from the moment the
+  /// request is placed: the request may be processed by the main thread
+  /// before it is recorded otherwise.
   void SetLastRequest(vtkMRMLCommandLineModuleNode* node, vtkMTimeType requestUID)
   {
     RequestType::iterator it = std::find_if(
@@ -243,6 +402,7 @@ public:
   }
   vtkMTimeType GetLastRequest(vtkMRMLCommandLineModuleNode* node)
   {
+    std::lock_guard<std::mutex> lock(this->LastRequestsLock);
     RequestType::iterator it = std::find_if(
       this->LastRequests.begin(), this->LastRequests.end(), FindRequest(node));
     return (it != this->LastRequests.end())? it->first : 0;
@@ -282,14 +442,90 @@ public:
       }
   }
 
+  /// Return the number of bytes needed to exchange the bulk data of the
+  /// node (image or mesh) with an executable CLI, 0 if unknown.
+  static vtkTypeInt64 GetDataExchangeSize(vtkMRMLNode* node)
+  {
+    vtkDataObject* data = nullptr;
+    vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(node);
+    if (volumeNode)
+      {
+      data = volumeNode->GetImageData();
+      }
+    else if (modelNode)
+      {
+      data = modelNode->GetMesh();
+      }
+    // GetActualMemorySize() is in kibibytes
+    return data ? static_cast<vtkTypeInt64>(data->GetActualMemorySize()) * 1024 : 0;
+  }
+
+  /// Return the shared memory directory if it can hold \a requiredSize
+  /// bytes, an empty string otherwise.
+  std::string GetAvailableSharedMemoryDirectory(vtkTypeInt64 requiredSize)
+  {
+    if (!this->AllowSharedMemoryTransfer
+      || this->SharedMemoryDirectory.empty()
+      || !vtksys::SystemTools::FileIsDirectory(this->SharedMemoryDirectory))
+      {
+      return std::string();
+      }
+#ifdef _WIN32
+    (void)requiredSize;
+    return std::string();
+#else
+    struct statvfs stats;
+    if (statvfs(this->SharedMemoryDirectory.c_str(), &stats) != 0)
+      {
+      return std::string();
+      }
+    vtkTypeInt64 availableSize = static_cast<vtkTypeInt64>(stats.f_bavail) * stats.f_frsize;
+    // keep a margin for the other CLIs and the file headers
+    if (requiredSize + requiredSize / 4 > availableSize)
+      {
+      return std::string();
+      }
+    return this->SharedMemoryDirectory;
+#endif
+  }
+
+  /// Create an empty file that only the user can read and write.
+  /// The shared memory directory is accessible by all the users: the files
+  /// exchanged with the CLI are created before being written by Slicer or
+  /// the CLI, which keep the permissions when they truncate the file.
+  /// Return false if the file cannot be created (e.g. it already exists).
+  static bool CreatePrivateFile(const std::string& fileName)
+  {
+#ifdef _WIN32
+    (void)fileName;
+    return false;
+#else
+    int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+      {
+      return false;
+      }
+    close(fd);
+    return true;
+#endif
+  }
+
   /// List of read data/scene requests of the CLI nodes
   /// being executed with their.
+  /// CLI tasks run concurrently on the processing threads and the requests
+  /// are removed by the main thread: LastRequestsLock guards the list.
   RequestType LastRequests;
+  std::mutex LastRequestsLock;
 
   vtkSmartPointer<vtkSlicerCLIRescheduleCallback> RescheduleCallback;
   vtkSmartPointer<vtkSlicerCLIOneShotCallbackCallback>OneShotCallbackCallback;
 };
 
+//----------------------------------------------------------------------------
+std::mutex vtkSlicerCLIModuleLogic::vtkInternal::SharedObjectModuleLock;
+std::mutex vtkSlicerCLIModuleLogic::vtkInternal::ProcessEnvironmentLock;
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerCLIModuleLogic);
 
@@ -300,6 +536,12 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
 
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->AllowInMemoryTransfer = 1;
+  this->Internal->AllowSharedMemoryTransfer = 1;
+  this->Internal->NumberOfThreadsPerBatchJob = 0;
+  this->Internal->LastBatchID = 0;
+#ifdef __linux__
+  this->Internal->SharedMemoryDirectory = "/dev/shm";
+#endif
   this->Internal->RedirectModuleStreams = 1;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
@@ -403,6 +645,35 @@ int vtkSlicerCLIModuleLogic::GetAllowInMemoryTransfer() const
   return this->Internal->AllowInMemoryTransfer;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetAllowSharedMemoryTransfer(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting AllowSharedMemoryTransfer to " << value);
+  if (this->Internal->AllowSharedMemoryTransfer != value)
+    {
+    this->Internal->AllowSharedMemoryTransfer = value;
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetAllowSharedMemoryTransfer() const
+{
+  return this->Internal->AllowSharedMemoryTransfer;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetSharedMemoryDirectory(const std::string& directory)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting SharedMemoryDirectory to " << directory);
+  this->Internal->SharedMemoryDirectory = directory;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkSlicerCLIModuleLogic::GetSharedMemoryDirectory() const
+{
+  return this->Internal->SharedMemoryDirectory;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerCLIModuleLogic::RedirectModuleStreamsOn()
 {
@@ -438,9 +709,6 @@ vtkSlicerCLIModuleLogic
 ::ConstructTemporarySceneFileName(vtkMRMLScene *scene)
 {
   std::string fname;
-  std::ostringstream fnameString;
-  std::string pid;
-  std::ostringstream pidString;
 
   // Part of the filename will include an encoding of the scene
   // pointer for uniqueness
@@ -455,18 +723,8 @@ vtkSlicerCLIModuleLogic
   std::transform(fname.begin(), fname.end(),
                  fname.begin(), DigitsToCharacters());
 
-  // Encode process id into a string.  To avoid confusing the
-  // Archetype reader, convert the numbers in pid to characters [0-9]->[A-J]
-#ifdef _WIN32
-  pidString << GetCurrentProcessId();
-#else
-  pidString << getpid();
-#endif
-  pid = pidString.str();
-  std::transform(pid.begin(), pid.end(), pid.begin(), DigitsToCharacters());
-
   // By default, the filename is based on the temporary directory and
-  // the pid
+  // a prefix unique to the execution
   // by default use the current directory
   std::string temporaryDirectory = ".";
   vtkSlicerApplicationLogic* appLogic = this->GetApplicationLogic();
@@ -474,7 +732,7 @@ vtkSlicerCLIModuleLogic
     {
     temporaryDirectory = appLogic->GetTemporaryPath();
     }
-  fname = temporaryDirectory + "/" + pid + "_" + fname + ".mrml";
+  fname = temporaryDirectory + "/" + ConstructUniqueTemporaryFilePrefix() + "_" + fname + ".mrml";
 
   return fname;
 }
@@ -489,8 +747,6 @@ vtkSlicerCLIModuleLogic
                              CommandLineModuleType commandType)
 {
   std::string fname = name;
-  std::string pid;
-  std::ostringstream pidString;
 
   // Constructing a temporary filename from a node involves:
   //
@@ -507,27 +763,11 @@ vtkSlicerCLIModuleLogic
   // the MRML scene, then a real temporary filename is constructed.
   // The filename will point to the Temporary directory defined for
   // Slicer. The filename will be unique to the process (multiple
-  // running instances of slicer will not collide).  The filename
-  // will be unique to the node in the process (the same node will be
-  // encoded to the same filename every time within that running
-  // instance of Slicer).  This last point is an optimization to
-  // minimize the number of times a file is written when running a
-  // module.  However, if we change the execution model such that more
-  // than one module can run at the same time within the same Slicer
-  // process, then this encoding will need to be changed to be unique
-  // per module execution.
+  // running instances of slicer will not collide) and unique to each
+  // call (modules running at the same time within the same Slicer
+  // process, e.g. with the same input node, will not collide).
   //
 
-  // Encode process id into a string.  To avoid confusing the
-  // Archetype reader, convert the numbers in pid to characters [0-9]->[A-J]
-#ifdef _WIN32
-  pidString << GetCurrentProcessId();
-#else
-  pidString << getpid();
-#endif
-  pid = pidString.str();
-  std::transform(pid.begin(), pid.end(), pid.begin(), DigitsToCharacters());
-
   // Because Python is responsible for looking up the MRML Object,
   // we can simply return the MRML Id.
   if ( commandType == PythonModule )
@@ -541,14 +781,14 @@ vtkSlicerCLIModuleLogic
                  fname.begin(), DigitsToCharacters());
 
   // By default, the filename is based on the temporary directory and
-  // the pid
+  // a prefix unique to the execution
   std::string temporaryDirectory = ".";
   vtkSlicerApplicationLogic* appLogic = this->GetApplicationLogic();
   if (appLogic)
     {
     temporaryDirectory = appLogic->GetTemporaryPath();
     }
-  fname = temporaryDirectory + "/" + pid + "_" + fname;
+  fname = temporaryDirectory + "/" + ConstructUniqueTemporaryFilePrefix() + "_" + fname;
 
   if (tag == "image")
     {
@@ -731,6 +971,135 @@ void vtkSlicerCLIModuleLogic::Apply ( vtkMRMLCommandLineModuleNode* node, bool u
     }
 }
 
+//-----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::ApplyBatch(vtkMRMLCommandLineModuleNode* templateNode,
+                                        const std::vector<BatchJobParameters>& jobParameters,
+                                        vtkCollection* jobNodes)
+{
+  if (!templateNode || !this->GetMRMLScene() || !this->GetApplicationLogic())
+    {
+    vtkErrorMacro("ApplyBatch: invalid template node, scene or application logic");
+    return -1;
+    }
+  if (templateNode->GetModuleDescription().GetType() == "PythonModule")
+    {
+    vtkErrorMacro("ApplyBatch: " << templateNode->GetModuleDescription().GetTitle()
+                  << " is a Python module, it can not run in a background thread");
+    return -1;
+    }
+  if (jobParameters.empty())
+    {
+    return -1;
+    }
+
+  int numberOfThreadsPerJob = this->Internal->NumberOfThreadsPerBatchJob;
+  if (numberOfThreadsPerJob <= 0)
+    {
+    int numberOfConcurrentJobs = std::min(
+      static_cast<int>(jobParameters.size()),
+      this->GetApplicationLogic()->GetNumberOfProcessingThreads());
+    int numberOfCores = static_cast<int>(std::thread::hardware_concurrency());
+    numberOfThreadsPerJob = std::max(1, numberOfCores / std::max(1, numberOfConcurrentJobs));
+    }
+  std::stringstream numberOfThreadsStream;
+  numberOfThreadsStream << numberOfThreadsPerJob;
+
+  int batchID = 0;
+  {
+  std::lock_guard<std::mutex> lock(this->Internal->BatchLock);
+  batchID = ++this->Internal->LastBatchID;
+  vtkInternal::BatchRecord& batch = this->Internal->Batches[batchID];
+  batch.StartTime = vtkTimerLog::GetUniversalTime();
+  batch.EndTime = 0.0;
+  // all the jobs are counted before the first one can complete
+  batch.Statistics.NumberOfJobs = static_cast<int>(jobParameters.size());
+  }
+  std::stringstream batchIDStream;
+  batchIDStream << batchID;
+
+  int numberOfUnscheduledJobs = 0;
+  for (size_t jobIndex = 0; jobIndex < jobParameters.size(); ++jobIndex)
+    {
+    vtkSmartPointer<vtkMRMLCommandLineModuleNode> jobNode =
+      vtkSmartPointer<vtkMRMLCommandLineModuleNode>::Take(vtkMRMLCommandLineModuleNode::SafeDownCast(
+        this->GetMRMLScene()->CreateNodeByClass("vtkMRMLCommandLineModuleNode")));
+    jobNode->Copy(templateNode);
+    jobNode->SetStatus(vtkMRMLCommandLineModuleNode::Idle, false);
+    std::stringstream name;
+    name << (templateNode->GetName() ? templateNode->GetName() : "CLI") << "_" << batchID << "_" << jobIndex;
+    jobNode->SetName(name.str().c_str());
+    for (BatchJobParameters::const_iterator paramIt = jobParameters[jobIndex].begin();
+         paramIt != jobParameters[jobIndex].end(); ++paramIt)
+      {
+      if (!jobNode->SetParameterAsString(paramIt->first.c_str(), paramIt->second))
+        {
+        vtkWarningMacro("ApplyBatch: failed to set parameter " << paramIt->first
+                        << " of job " << jobIndex);
+        }
+      }
+    jobNode->SetAttribute("BatchID", batchIDStream.str().c_str());
+    jobNode->SetAttribute("NumberOfThreads", numberOfThreadsStream.str().c_str());
+    this->GetMRMLScene()->AddNode(jobNode);
+    if (jobNodes)
+      {
+      jobNodes->AddItem(jobNode);
+      }
+
+    this->Apply(jobNode, false);
+    if (jobNode->GetStatus() != vtkMRMLCommandLineModuleNode::Scheduled)
+      {
+      ++numberOfUnscheduledJobs;
+      }
+    }
+
+  if (numberOfUnscheduledJobs > 0)
+    {
+    vtkErrorMacro("ApplyBatch: " << numberOfUnscheduledJobs << " jobs could not be scheduled");
+    std::lock_guard<std::mutex> lock(this->Internal->BatchLock);
+    vtkInternal::BatchRecord& batch = this->Internal->Batches[batchID];
+    batch.Statistics.NumberOfFailedJobs += numberOfUnscheduledJobs;
+    if (batch.Statistics.NumberOfCompletedJobs + batch.Statistics.NumberOfFailedJobs
+        == batch.Statistics.NumberOfJobs)
+      {
+      batch.EndTime = vtkTimerLog::GetUniversalTime();
+      }
+    }
+  return batchID;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetNumberOfThreadsPerBatchJob(int numberOfThreads)
+{
+  this->Internal->NumberOfThreadsPerBatchJob = std::max(0, numberOfThreads);
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetNumberOfThreadsPerBatchJob() const
+{
+  return this->Internal->NumberOfThreadsPerBatchJob;
+}
+
+//-----------------------------------------------------------------------------
+vtkSlicerCLIModuleLogic::BatchStatistics
+vtkSlicerCLIModuleLogic::GetBatchStatistics(int batchID) const
+{
+  std::lock_guard<std::mutex> lock(this->Internal->BatchLock);
+  std::map<int, vtkInternal::BatchRecord>::const_iterator batchIt =
+    this->Internal->Batches.find(batchID);
+  if (batchIt == this->Internal->Batches.end())
+    {
+    return BatchStatistics();
+    }
+  const vtkInternal::BatchRecord& batch = batchIt->second;
+  BatchStatistics statistics = batch.Statistics;
+  double endTime = batch.EndTime > 0.0 ? batch.EndTime : vtkTimerLog::GetUniversalTime();
+  statistics.ElapsedTime = endTime - batch.StartTime;
+  int numberOfDoneJobs = statistics.NumberOfCompletedJobs + statistics.NumberOfFailedJobs;
+  statistics.Throughput = statistics.ElapsedTime > 0.0 ?
+    numberOfDoneJobs * 60.0 / statistics.ElapsedTime : 0.0;
+  return statistics;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerCLIModuleLogic
 ::SetMRMLApplicationLogic(vtkMRMLApplicationLogic* logic)
@@ -833,6 +1202,9 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // release it when it goes out of scope
   node0.TakeReference(reinterpret_cast<vtkMRMLCommandLineModuleNode*>(clientdata));
 
+  // Update the batch statistics when the task is done
+  vtkInternal::BatchJobTimer batchJobTimer(this->Internal, node0);
+
   // Check to see if this node/task has been cancelled
   if (node0->GetStatus() == vtkMRMLCommandLineModuleNode::Cancelling ||
       node0->GetStatus() == vtkMRMLCommandLineModuleNode::Cancelled)
@@ -916,6 +1288,9 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // vector of files to delete
   std::set<std::string> filesToDelete;
 
+  // images and models that can be exchanged through shared memory
+  std::set<std::string> sharedMemoryNodeIDs;
+
   // iterators for parameter groups
   std::vector<ModuleParameterGroup>::iterator pgbeginit
     = node0->GetModuleDescription().GetParameterGroups().begin();
@@ -966,6 +1341,11 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                                              commandType);
 
         filesToDelete.insert(fname);
+        if (commandType == CommandLineModule
+            && ((*pit).GetTag() == "image" || (*pit).GetTag() == "geometry"))
+          {
+          sharedMemoryNodeIDs.insert(id);
+          }
         if ((*pit).GetChannel() == "input")
           {
           nodesToWrite[id] = fname;
@@ -998,6 +1378,58 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     temporaryDirectory = appLogic->GetTemporaryPath();
     }
 
+  // Exchange images and models with executable CLIs through a
+  // memory-backed file system if it is large enough for the inputs and the
+  // outputs (assumed to be as large as the largest input).
+  std::string sharedMemoryDirectory;
+  if (!sharedMemoryNodeIDs.empty())
+    {
+    vtkTypeInt64 requiredSize = 0;
+    vtkTypeInt64 largestSize = 0;
+    for (MRMLIDToFileNameMap::const_iterator it = nodesToWrite.begin(); it != nodesToWrite.end(); ++it)
+      {
+      if (sharedMemoryNodeIDs.find(it->first) != sharedMemoryNodeIDs.end())
+        {
+        vtkTypeInt64 size = vtkInternal::GetDataExchangeSize(
+          this->GetMRMLScene()->GetNodeByID(it->first.c_str()));
+        requiredSize += size;
+        largestSize = std::max(largestSize, size);
+        }
+      }
+    requiredSize += largestSize * static_cast<vtkTypeInt64>(nodesToReload.size());
+    sharedMemoryDirectory = this->Internal->GetAvailableSharedMemoryDirectory(requiredSize);
+    if (sharedMemoryDirectory.empty())
+      {
+      vtkDebugMacro("Shared memory transfer is not available for "
+        << requiredSize << " bytes, using " << temporaryDirectory);
+      }
+    }
+  if (!sharedMemoryDirectory.empty())
+    {
+    MRMLIDToFileNameMap* fileNameMaps[2] = { &nodesToWrite, &nodesToReload };
+    for (int mapIndex = 0; mapIndex < 2; ++mapIndex)
+      {
+      MRMLIDToFileNameMap& fileNameMap = *fileNameMaps[mapIndex];
+      for (MRMLIDToFileNameMap::iterator it = fileNameMap.begin(); it != fileNameMap.end(); ++it)
+        {
+        if (sharedMemoryNodeIDs.find(it->first) == sharedMemoryNodeIDs.end())
+          {
+          continue;
+          }
+        std::string sharedMemoryFileName =
+          sharedMemoryDirectory + "/" + vtksys::SystemTools::GetFilenameName(it->second);
+        if (!vtkInternal::CreatePrivateFile(sharedMemoryFileName))
+          {
+          vtkWarningMacro("Cannot create " << sharedMemoryFileName << ", using " << it->second);
+          continue;
+          }
+        filesToDelete.erase(it->second);
+        it->second = sharedMemoryFileName;
+        filesToDelete.insert(it->second);
+        }
+      }
+    }
+
   // write out the input datasets
   //
   //
@@ -1009,7 +1441,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   MemoryTransferPossible.insert("vtkMRMLDiffusionWeightedVolumeNode");
   MemoryTransferPossible.insert("vtkMRMLDiffusionTensorVolumeNode");
 
-  MRMLIDToFileNameMap::const_iterator id2fn0;
+  MRMLIDToFileNameMap::iterator id2fn0;
 
   for (id2fn0 = nodesToWrite.begin();
        id2fn0 != nodesToWrite.end();
@@ -1119,7 +1551,21 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       {
       out->SetScene(this->GetMRMLScene());
       out->SetFileName( (*id2fn0).second.c_str() );
-      if (!out->WriteData( nd ))
+      bool written = (out->WriteData( nd ) != 0);
+      if (!written && !sharedMemoryDirectory.empty()
+          && sharedMemoryNodeIDs.find((*id2fn0).first) != sharedMemoryNodeIDs.end())
+        {
+        // shared memory may have been filled up in the meantime,
+        // fall back to the temporary directory
+        itksys::SystemTools::RemoveFile((*id2fn0).second.c_str());
+        filesToDelete.erase((*id2fn0).second);
+        (*id2fn0).second = temporaryDirectory + "/"
+          + vtksys::SystemTools::GetFilenameName((*id2fn0).second);
+        filesToDelete.insert((*id2fn0).second);
+        out->SetFileName( (*id2fn0).second.c_str() );
+        written = (out->WriteData( nd ) != 0);
+        }
+      if (!written)
         {
         vtkErrorMacro("ERROR writing file " << out->GetFileName());
         }
@@ -1254,26 +1700,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     {
     commandLineAsString.push_back( "--returnparameterfile" );
 
-    std::ostringstream pidString;
-#ifdef _WIN32
-    pidString << GetCurrentProcessId();
-#else
-    pidString << getpid();
-#endif
-
-    static const char alphanum[] =
-        "0123456789"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz";
-    srand(time(nullptr));
-
-    std::ostringstream code;
-    for (int ii = 0; ii < 10; ii++)
-      {
-      code << alphanum[rand() % (sizeof(alphanum)-1)];
-      }
-    std::string returnFile = temporaryDirectory + "/" + pidString.str()
-      + "_" + code.str() + ".params";
+    std::string returnFile = temporaryDirectory + "/"
+      + ConstructUniqueTemporaryFilePrefix() + ".params";
 
     commandLineAsString.push_back( returnFile );
 
@@ -1836,6 +2264,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     // statically linked to the executable.
     // Historically, there was an nvidia driver bug that causes the module
     // to fail on exit with undefined symbol.
+    // The environment is shared by the CLIs started concurrently
+    std::unique_lock<std::mutex> environmentLock(vtkInternal::ProcessEnvironmentLock);
      std::string saveITKAutoLoadPath;
      itksys::SystemTools::GetEnv("ITK_AUTOLOAD_PATH", saveITKAutoLoadPath);
      std::string emptyString("ITK_AUTOLOAD_PATH=");
@@ -1845,12 +2275,39 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
        {
        vtkErrorMacro( "Unable to reset ITK_AUTOLOAD_PATH.");
        }
+    // Let the CLI know which files are exchanged through shared memory so
+    // that it does not compress them (see itk::UseCompressionForFileName()).
+    std::string saveSharedMemoryDirectory;
+    bool hasSharedMemoryDirectory =
+      itksys::SystemTools::GetEnv("SLICER_CLI_SHARED_MEMORY_DIRECTORY", saveSharedMemoryDirectory);
+    std::string sharedMemoryString("SLICER_CLI_SHARED_MEMORY_DIRECTORY=");
+    sharedMemoryString += sharedMemoryDirectory;
+    if (!itksys::SystemTools::PutEnv(const_cast <char *> (sharedMemoryString.c_str())))
+      {
+      vtkErrorMacro( "Unable to set SLICER_CLI_SHARED_MEMORY_DIRECTORY.");
+      }
+    // Limit the number of threads of the batch jobs (see ApplyBatch())
+    const char* numberOfThreads = node0->GetAttribute("NumberOfThreads");
+    std::string saveITKNumberOfThreads;
+    std::string saveOMPNumberOfThreads;
+    bool hasITKNumberOfThreads =
+      itksys::SystemTools::GetEnv("ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS", saveITKNumberOfThreads);
+    bool hasOMPNumberOfThreads =
+      itksys::SystemTools::GetEnv("OMP_NUM_THREADS", saveOMPNumberOfThreads);
+    if (numberOfThreads)
+      {
+      itksys::SystemTools::PutEnv(
+        std::string("ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS=") + numberOfThreads);
+      itksys::SystemTools::PutEnv(std::string("OMP_NUM_THREADS=") + numberOfThreads);
+      }
     //
     // now run the process
     //
     itksysProcess *process = itksysProcess_New();
 
+    this->Internal->ProcessesKillLock.lock();
     this->Internal->Processes.push_back(process);
+    this->Internal->ProcessesKillLock.unlock();
 
     // setup the command
     itksysProcess_SetCommand(process, command);
@@ -1872,6 +2329,37 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       {
       vtkErrorMacro( "Unable to restore ITK_AUTOLOAD_PATH. ");
       }
+    if (hasSharedMemoryDirectory)
+      {
+      itksys::SystemTools::PutEnv(
+        std::string("SLICER_CLI_SHARED_MEMORY_DIRECTORY=") + saveSharedMemoryDirectory);
+      }
+    else
+      {
+      itksys::SystemTools::UnPutEnv("SLICER_CLI_SHARED_MEMORY_DIRECTORY");
+      }
+    if (numberOfThreads)
+      {
+      // restore the values set by the user
+      if (hasITKNumberOfThreads)
+        {
+        itksys::SystemTools::PutEnv(
+          std::string("ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS=") + saveITKNumberOfThreads);
+        }
+      else
+        {
+        itksys::SystemTools::UnPutEnv("ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS");
+        }
+      if (hasOMPNumberOfThreads)
+        {
+        itksys::SystemTools::PutEnv(std::string("OMP_NUM_THREADS=") + saveOMPNumberOfThreads);
+        }
+      else
+        {
+        itksys::SystemTools::UnPutEnv("OMP_NUM_THREADS");
+        }
+      }
+    environmentLock.unlock();
 
     // Wait for the command to finish
     char *tbuffer;
@@ -1898,8 +2386,10 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       if (node0->GetModuleDescription().GetProcessInformation()->Abort)
         {
         itksysProcess_Kill(process);
+        this->Internal->ProcessesKillLock.lock();
         this->Internal->Processes.erase(
               std::find(this->Internal->Processes.begin(), this->Internal->Processes.end(), process));
+        this->Internal->ProcessesKillLock.unlock();
         node0->GetModuleDescription().GetProcessInformation()->Progress = 0;
         node0->GetModuleDescription().GetProcessInformation()->StageProgress =0;
         this->GetApplicationLogic()->RequestModified( node0 );
@@ -2156,6 +2646,14 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     //
     //
 
+    // The streams are redirected and the number of threads is limited for
+    // the whole process, concurrent modules would interfere (the streams
+    // must be restored before another module can redirect them).
+    std::lock_guard<std::mutex> sharedObjectModuleLock(vtkInternal::SharedObjectModuleLock);
+    // Limit the number of threads of the batch jobs (see ApplyBatch())
+    const char* numberOfThreads = node0->GetAttribute("NumberOfThreads");
+    vtkInternal::GlobalNumberOfThreadsLimit numberOfThreadsLimit(numberOfThreads ? atoi(numberOfThreads) : 0);
+
     std::ostringstream coutstringstream;
     std::ostringstream cerrstringstream;
     std::streambuf* origcoutrdbuf = std::cout.rdbuf();
@@ -2388,10 +2886,14 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
         }
 
         bool deleteFile = this->GetDeleteTemporaryFiles();
+        {
+        // recorded before the request can be processed (see ProcessMRMLLogicsEvents())
+        std::lock_guard<std::mutex> lastRequestsLock(this->Internal->LastRequestsLock);
         vtkMTimeType requestUID = this->GetApplicationLogic()
           ->RequestReadFile((*id2fn0).first.c_str(), (*id2fn0).second.c_str(),
                             displayData, deleteFile);
         this->Internal->SetLastRequest(node0, requestUID);
+        }
 
         // If we are reloading a file, then we know that it is a file
         // that needs to be removed.  It wouldn't make sense for two
@@ -2434,6 +2936,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
         }
 
       // Place a request to read the miniscene and map any ids as necessary
+      // recorded before the request can be processed (see ProcessMRMLLogicsEvents())
+      std::lock_guard<std::mutex> lastRequestsLock(this->Internal->LastRequestsLock);
       vtkMTimeType requestUID = this->GetApplicationLogic()
         ->RequestReadScene( minisceneFilename, keys, values,
                             displayData, deleteFile );
@@ -2503,6 +3007,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                   if (trefNode != nullptr && !transformNodeID.empty())
                     {
                     // Place a request to update parent transform based of the referenced node
+                    // recorded before the request can be processed (see ProcessMRMLLogicsEvents())
+                    std::lock_guard<std::mutex> lastRequestsLock(this->Internal->LastRequestsLock);
                     vtkMTimeType requestUID = this->GetApplicationLogic()
                       ->RequestUpdateParentTransform(reference, transformNodeID);
                     this->Internal->SetLastRequest(node0, requestUID);
@@ -2515,6 +3021,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                   if (!updatedNodeID.empty())
                     {
                     // Place a request to update location in the subject hierarchy based of the referenced node
+                    // recorded before the request can be processed (see ProcessMRMLLogicsEvents())
+                    std::lock_guard<std::mutex> lastRequestsLock(this->Internal->LastRequestsLock);
                     vtkMTimeType requestUID = this->GetApplicationLogic()
                       ->RequestUpdateSubjectHierarchyLocation(updatedNodeID, reference);
                     this->Internal->SetLastRequest(node0, requestUID);
@@ -2556,6 +3064,8 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                   if (referencedNodeID.size() > 0)
                     {
                     // Place a request to add node reference
+                    // recorded before the request can be processed (see ProcessMRMLLogicsEvents())
+                    std::lock_guard<std::mutex> lastRequestsLock(this->Internal->LastRequestsLock);
                     vtkMTimeType requestUID = this->GetApplicationLogic()
                       ->RequestAddNodeReference(referencingNodeID, referencedNodeID, role);
                     this->Internal->SetLastRequest(node0, requestUID);
@@ -2754,19 +3264,25 @@ void vtkSlicerCLIModuleLogic::ProcessMRMLLogicsEvents(vtkObject* caller,
       event == vtkSlicerApplicationLogic::RequestProcessedEvent)
     {
     vtkMTimeType uid = reinterpret_cast<vtkMTimeType>(callData);
+    vtkMRMLCommandLineModuleNode* node = nullptr;
+    {
+    std::lock_guard<std::mutex> lock(this->Internal->LastRequestsLock);
     vtkInternal::RequestType::iterator it =
       std::find_if(this->Internal->LastRequests.begin(),
       this->Internal->LastRequests.end(), vtkInternal::FindRequest(uid));
     if (it != this->Internal->LastRequests.end())
       {
-      vtkMRMLCommandLineModuleNode* node = it->second;
+      node = it->second;
+      // we are not interested in any request anymore because the cli node is
+      // Completed.
+      this->Internal->LastRequests.erase(it);
+      }
+    }
+    if (node)
+      {
       // If the status is not Completing, then there should be no request made
       // on the application logic.
       assert(node->GetStatus() == vtkMRMLCommandLineModuleNode::Completing);
-      this->Internal->LastRequests.erase(it);
-      // we are not interested in any request anymore because the cli node is
-      // Completed.
-
       node->SetStatus(vtkMRMLCommandLineModuleNode::Completed);
       }
     }
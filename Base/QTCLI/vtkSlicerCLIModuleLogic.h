@@ -26,8 +26,13 @@ class ModuleParameter;
 class vtkMRMLModelHierarchyNode;
 class MRMLIDMap;
 
+// VTK includes
+class vtkCollection;
+
 // STL includes
+#include <map>
 #include <string>
+#include <vector>
 
 #include "qSlicerBaseQTCLIExport.h"
 
@@ -80,6 +85,20 @@ public:
   void SetAllowInMemoryTransfer(int value);
   int GetAllowInMemoryTransfer() const;
 
+  /// Control use of shared memory by executable CLIs: input and output
+  /// images and models are exchanged through uncompressed files in a
+  /// memory-backed file system (see SetSharedMemoryDirectory()) instead
+  /// of the temporary directory. The temporary directory is used if there
+  /// is not enough shared memory available.
+  void SetAllowSharedMemoryTransfer(int value);
+  int GetAllowSharedMemoryTransfer() const;
+
+  /// Directory of the memory-backed file system used when shared memory
+  /// transfer is allowed. Default is "/dev/shm" on Linux, empty (shared
+  /// memory transfer disabled) on the other platforms.
+  void SetSharedMemoryDirectory(const std::string& directory);
+  std::string GetSharedMemoryDirectory() const;
+
   /// For debugging, control redirection of cout and cerr
   virtual void RedirectModuleStreamsOn();
   virtual void RedirectModuleStreamsOff();
@@ -104,6 +123,55 @@ public:
 
   void KillProcesses();
 
+  /// Parameter values of a batch job: parameter name -> value (node ID for
+  /// node parameters).
+  /// \sa ApplyBatch()
+  typedef std::map<std::string, std::string> BatchJobParameters;
+
+  /// Run the CLI once for each parameter set of \a jobParameters.
+  /// A job node is created for each parameter set by copying \a templateNode
+  /// and overriding its parameters; it is added to the scene (and to
+  /// \a jobNodes if not null). The jobs are scheduled as regular CLI tasks:
+  /// they run concurrently on the processing threads of the application
+  /// logic (see vtkSlicerApplicationLogic::SetNumberOfProcessingThreads())
+  /// and the outputs of each job are loaded into the scene as soon as it is
+  /// done. Shared object modules share the standard streams and the global
+  /// number of threads of the application, their jobs run one at a time.
+  /// Returns the identifier of the batch, -1 if it could not be scheduled.
+  /// \sa GetBatchStatistics(), SetNumberOfThreadsPerBatchJob()
+  int ApplyBatch(vtkMRMLCommandLineModuleNode* templateNode,
+                 const std::vector<BatchJobParameters>& jobParameters,
+                 vtkCollection* jobNodes = nullptr);
+
+  /// Maximum number of threads used by each CLI of a batch, so that the
+  /// concurrent jobs do not oversubscribe the processor: executables get
+  /// ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS and OMP_NUM_THREADS, shared object
+  /// modules run with the global maximum number of threads of ITK and VTK.
+  /// If 0 (default), the cores are split evenly between the jobs that can
+  /// run at the same time.
+  void SetNumberOfThreadsPerBatchJob(int numberOfThreads);
+  int GetNumberOfThreadsPerBatchJob() const;
+
+  /// Progress and timing of a batch.
+  struct BatchStatistics
+  {
+    int NumberOfJobs{0};
+    int NumberOfCompletedJobs{0};
+    int NumberOfFailedJobs{0};
+    /// Wall-clock time (in seconds) since the batch was scheduled, until
+    /// the last job is done.
+    double ElapsedTime{0.0};
+    /// Sum of the execution time of the jobs that are done. The ratio
+    /// TotalJobTime / ElapsedTime is the effective concurrency.
+    double TotalJobTime{0.0};
+    /// Number of jobs done per minute.
+    double Throughput{0.0};
+  };
+
+  /// Return the statistics of a batch started with ApplyBatch().
+  /// Can be called from any thread.
+  BatchStatistics GetBatchStatistics(int batchID) const;
+
 //   void LazyEvaluateModuleTarget(ModuleDescription& moduleDescriptionObject);
 //   void LazyEvaluateModuleTarget(vtkMRMLCommandLineModuleNode* node)
 //     { this->LazyEvaluateModuleTarget(node->GetModuleDescription()); }
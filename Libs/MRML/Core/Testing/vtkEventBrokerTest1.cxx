@@ -0,0 +1,226 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+struct CallbackData
+{
+  int Count = 0;
+  void* LastCallData = nullptr;
+};
+
+//---------------------------------------------------------------------------
+void CountingCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                      void* clientData, void* callData)
+{
+  CallbackData* data = reinterpret_cast<CallbackData*>(clientData);
+  data->Count++;
+  data->LastCallData = callData;
+}
+
+//---------------------------------------------------------------------------
+int TestEventMode(int eventMode, int numberOfEvents, int expectedNumberOfInvocations)
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+
+  vtkNew<vtkObject> subject;
+  vtkNew<vtkObject> observer;
+  CallbackData data;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountingCallback);
+  callback->SetClientData(&data);
+  vtkObservation* observation = broker->AddObservation(
+    subject.GetPointer(), vtkCommand::ModifiedEvent, observer.GetPointer(), callback.GetPointer());
+
+  CallbackData queuedData;
+  vtkNew<vtkCallbackCommand> queuedCallback;
+  queuedCallback->SetCallback(CountingCallback);
+  queuedCallback->SetClientData(&queuedData);
+  unsigned long queuedTag = broker->AddObserver(vtkEventBroker::EventQueuedEvent, queuedCallback.GetPointer());
+
+  broker->SetEventMode(eventMode);
+  int callData[100];
+  for (int i = 0; i < numberOfEvents; ++i)
+    {
+    subject->InvokeEvent(vtkCommand::ModifiedEvent, &callData[i]);
+    }
+  if (eventMode != vtkEventBroker::Synchronous)
+    {
+    CHECK_INT(data.Count, 0);
+    CHECK_INT(broker->GetNumberOfQueuedObservations(), 1);
+    CHECK_INT(queuedData.Count, 1);
+    broker->ProcessEventQueue();
+    CHECK_INT(broker->GetNumberOfQueuedObservations(), 0);
+    }
+  CHECK_INT(data.Count, expectedNumberOfInvocations);
+  CHECK_POINTER(data.LastCallData, &callData[numberOfEvents - 1]);
+  CHECK_INT(static_cast<int>(observation->GetInvocationCount()), expectedNumberOfInvocations);
+  if (eventMode == vtkEventBroker::Coalescing)
+    {
+    CHECK_INT(static_cast<int>(observation->GetCoalescedEventCount()), numberOfEvents - 1);
+    }
+  broker->PrintObservationStatistics(std::cout);
+
+  broker->RemoveObserver(queuedTag);
+  broker->RemoveObservations(subject.GetPointer());
+  broker->SetEventModeToSynchronous();
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+struct LatencyData
+{
+  vtkObservation* Observation = nullptr;
+  std::vector<double> Latencies;
+};
+
+//---------------------------------------------------------------------------
+void LatencyCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                     void* clientData, void* vtkNotUsed(callData))
+{
+  LatencyData* data = reinterpret_cast<LatencyData*>(clientData);
+  data->Latencies.push_back(data->Observation->GetLastLatency());
+}
+
+//---------------------------------------------------------------------------
+// The latency of a coalesced observation invoked with several call data
+// is accumulated once.
+int TestCoalescedLatency()
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+
+  vtkNew<vtkObject> subject;
+  vtkNew<vtkObject> observer;
+  LatencyData data;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(LatencyCallback);
+  callback->SetClientData(&data);
+  data.Observation = broker->AddObservation(
+    subject.GetPointer(), vtkCommand::AnyEvent, observer.GetPointer(), callback.GetPointer());
+
+  broker->SetEventModeToCoalescing();
+  subject->InvokeEvent(vtkCommand::ModifiedEvent);
+  subject->InvokeEvent(vtkCommand::StartEvent);
+  subject->InvokeEvent(vtkCommand::EndEvent);
+  broker->ProcessEventQueue();
+
+  CHECK_INT(static_cast<int>(data.Latencies.size()), 3);
+  CHECK_INT(static_cast<int>(data.Observation->GetInvocationCount()), 3);
+  CHECK_DOUBLE(data.Latencies[1], 0.0);
+  CHECK_DOUBLE(data.Latencies[2], 0.0);
+  CHECK_DOUBLE(data.Observation->GetTotalLatency(), data.Latencies[0]);
+
+  broker->RemoveObservations(subject.GetPointer());
+  broker->SetEventModeToSynchronous();
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+const int NumberOfPostingThreads = 4;
+const int NumberOfPostedEventsPerThread = 1000;
+
+//---------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE PostEventsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkObject* subject = static_cast<vtkObject*>(info->UserData);
+  for (int i = 0; i < NumberOfPostedEventsPerThread; ++i)
+    {
+    vtkEventBroker::GetInstance()->PostEvent(subject, vtkCommand::ModifiedEvent);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//---------------------------------------------------------------------------
+void PostedEventCallback(void* clientData)
+{
+  // Called from the posting threads
+  std::atomic<int>* count = static_cast<std::atomic<int>*>(clientData);
+  ++(*count);
+}
+
+//---------------------------------------------------------------------------
+int TestPostEvent()
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+
+  vtkNew<vtkObject> subject;
+  CallbackData data;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountingCallback);
+  callback->SetClientData(&data);
+  subject->AddObserver(vtkCommand::ModifiedEvent, callback.GetPointer());
+  vtkMTimeType mtime = subject->GetMTime();
+
+  std::atomic<int> postedEventCallbackCount(0);
+  broker->SetPostedEventCallback(PostedEventCallback, &postedEventCallbackCount);
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(NumberOfPostingThreads);
+  threader->SetSingleMethod(PostEventsThread, subject.GetPointer());
+  threader->SingleMethodExecute();
+
+  // Events are only invoked by ProcessPostedEvents
+  CHECK_INT(data.Count, 0);
+  CHECK_BOOL(broker->GetPostedEventsPending(), true);
+  CHECK_INT(postedEventCallbackCount, 1);
+  CHECK_INT(broker->ProcessPostedEvents(), NumberOfPostingThreads * NumberOfPostedEventsPerThread);
+  CHECK_BOOL(broker->GetPostedEventsPending(), false);
+  CHECK_INT(data.Count, NumberOfPostingThreads * NumberOfPostedEventsPerThread);
+  CHECK_BOOL(subject->GetMTime() > mtime, true);
+
+  // Posted objects are kept alive until the events are processed
+  vtkObject* postedSubject = vtkObject::New();
+  broker->PostEvent(postedSubject, vtkCommand::UserEvent);
+  postedSubject->Delete();
+  CHECK_INT(postedEventCallbackCount, 2);
+  CHECK_INT(broker->ProcessPostedEvents(), 1);
+
+  broker->SetPostedEventCallback(nullptr, nullptr);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkEventBrokerTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestEventMode(vtkEventBroker::Synchronous, 100, 100));
+  // Each different call data is invoked
+  vtkEventBroker::GetInstance()->CompressCallDataOff();
+  CHECK_EXIT_SUCCESS(TestEventMode(vtkEventBroker::Asynchronous, 100, 100));
+  // Events are merged whatever the call data
+  CHECK_EXIT_SUCCESS(TestEventMode(vtkEventBroker::Coalescing, 100, 1));
+  CHECK_EXIT_SUCCESS(TestCoalescedLatency());
+  CHECK_EXIT_SUCCESS(TestPostEvent());
+  return EXIT_SUCCESS;
+}
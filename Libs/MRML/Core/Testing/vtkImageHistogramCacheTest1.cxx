@@ -0,0 +1,192 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkImageHistogramCache.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkImageHistogramStatistics.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateImage(int size, int scalarType)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(size, size, size);
+  image->AllocateScalars(scalarType, 1);
+  unsigned int value = 1;
+  for (int z = 0; z < size; ++z)
+    {
+    for (int y = 0; y < size; ++y)
+      {
+      for (int x = 0; x < size; ++x)
+        {
+        // values between -1000 and 3000
+        value = value * 1103515245 + 12345;
+        image->SetScalarComponentFromDouble(x, y, z, 0, static_cast<double>((value >> 16) % 4001) - 1000.0);
+        }
+      }
+    }
+  return image;
+}
+
+//---------------------------------------------------------------------------
+int TestCache()
+{
+  vtkImageHistogramCache* cache = vtkImageHistogramCache::GetInstance();
+  cache->RemoveAllEntries();
+  vtkSmartPointer<vtkImageData> image = CreateImage(64, VTK_SHORT);
+
+  double scalarRange[2] = { 0.0, 0.0 };
+  CHECK_BOOL(cache->GetScalarRange(image, scalarRange), true);
+  CHECK_INT(cache->GetNumberOfEntries(), 1);
+
+  double range[2] = { 0.0, 0.0 };
+  int numberOfComputations = cache->GetNumberOfHistogramComputations();
+  CHECK_BOOL(cache->GetAutoRange(image, 0.0, 100.0, range), true);
+  CHECK_INT(cache->GetNumberOfHistogramComputations(), numberOfComputations + 1);
+  CHECK_BOOL(range[0] == scalarRange[0] && range[1] == scalarRange[1], true);
+
+  // Same image: the histogram is reused
+  double median = 0.0;
+  CHECK_BOOL(cache->GetPercentile(image, 50.0, median), true);
+  CHECK_BOOL(median > 900.0 && median < 1100.0, true);
+  CHECK_INT(cache->GetNumberOfHistogramComputations(), numberOfComputations + 1);
+
+  // Modified image: the histogram is computed again
+  image->SetScalarComponentFromDouble(0, 0, 0, 0, 5000.0);
+  image->GetPointData()->GetScalars()->Modified();
+  CHECK_BOOL(cache->GetAutoRange(image, 0.0, 100.0, range), true);
+  CHECK_INT(cache->GetNumberOfHistogramComputations(), numberOfComputations + 2);
+  CHECK_BOOL(range[1] == 5000.0, true);
+
+  // Deleted images are removed from the cache
+  image = nullptr;
+  CHECK_INT(cache->GetNumberOfEntries(), 0);
+
+  // Images without scalars
+  vtkNew<vtkImageData> emptyImage;
+  CHECK_BOOL(cache->GetAutoRange(emptyImage.GetPointer(), 0.1, 99.9, range), false);
+  CHECK_BOOL(cache->GetAutoRange(nullptr, 0.1, 99.9, range), false);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestAutoRange(int size, int scalarType, vtkIdType maximumNumberOfSamples)
+{
+  vtkImageHistogramCache* cache = vtkImageHistogramCache::GetInstance();
+  cache->RemoveAllEntries();
+  vtkIdType defaultMaximumNumberOfSamples = cache->GetMaximumNumberOfSamples();
+  cache->SetMaximumNumberOfSamples(maximumNumberOfSamples);
+  vtkSmartPointer<vtkImageData> image = CreateImage(size, scalarType);
+  vtkNew<vtkTimerLog> timer;
+
+  vtkNew<vtkImageHistogramStatistics> statistics;
+  statistics->SetAutoRangePercentiles(0.1, 99.9);
+  statistics->SetAutoRangeExpansionFactors(0.0, 0.0);
+  statistics->SetInputData(image);
+  timer->StartTimer();
+  statistics->Update();
+  timer->StopTimer();
+  double statisticsTime = timer->GetElapsedTime();
+  double* expectedRange = statistics->GetAutoRange();
+
+  double range[2] = { 0.0, 0.0 };
+  timer->StartTimer();
+  CHECK_BOOL(cache->GetAutoRange(image, 0.1, 99.9, range), true);
+  timer->StopTimer();
+  double cacheTime = timer->GetElapsedTime();
+
+  timer->StartTimer();
+  CHECK_BOOL(cache->GetAutoRange(image, 0.1, 99.9, range), true);
+  timer->StopTimer();
+  double cachedTime = timer->GetElapsedTime();
+
+  // Less than 1% of the intensity range difference, sampling included
+  double tolerance = (expectedRange[1] - expectedRange[0]) * 0.01;
+  CHECK_BOOL(fabs(range[0] - expectedRange[0]) <= tolerance, true);
+  CHECK_BOOL(fabs(range[1] - expectedRange[1]) <= tolerance, true);
+
+  std::cout << size << "^3 " << image->GetScalarTypeAsString()
+            << " vtkImageHistogramStatistics: " << statisticsTime << "s"
+            << " first computation: " << cacheTime << "s"
+            << " cached: " << cachedTime << "s" << std::endl;
+
+  cache->SetMaximumNumberOfSamples(defaultMaximumNumberOfSamples);
+  cache->RemoveAllEntries();
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestNonFiniteValues()
+{
+  vtkImageHistogramCache* cache = vtkImageHistogramCache::GetInstance();
+  cache->RemoveAllEntries();
+  vtkSmartPointer<vtkImageData> image = CreateImage(32, VTK_FLOAT);
+  image->SetScalarComponentFromDouble(0, 0, 0, 0, std::numeric_limits<double>::infinity());
+  image->SetScalarComponentFromDouble(1, 0, 0, 0, -std::numeric_limits<double>::infinity());
+  image->GetPointData()->GetScalars()->Modified();
+
+  // Infinite values are not counted in the histogram
+  double range[2] = { 0.0, 0.0 };
+  CHECK_BOOL(cache->GetAutoRange(image, 0.0, 100.0, range), true);
+  CHECK_BOOL(range[0] >= -1000.0 && range[0] < -990.0, true);
+  CHECK_BOOL(range[1] <= 3000.0 && range[1] > 2990.0, true);
+  double median = 0.0;
+  CHECK_BOOL(cache->GetPercentile(image, 50.0, median), true);
+  CHECK_BOOL(median > 900.0 && median < 1100.0, true);
+
+  // Only infinite values: no percentile
+  vtkNew<vtkImageData> infiniteImage;
+  infiniteImage->SetDimensions(2, 1, 1);
+  infiniteImage->AllocateScalars(VTK_FLOAT, 1);
+  infiniteImage->SetScalarComponentFromDouble(0, 0, 0, 0, std::numeric_limits<double>::infinity());
+  infiniteImage->SetScalarComponentFromDouble(1, 0, 0, 0, std::numeric_limits<double>::infinity());
+  CHECK_BOOL(cache->GetPercentile(infiniteImage.GetPointer(), 50.0, median), false);
+
+  cache->RemoveAllEntries();
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkImageHistogramCacheTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestCache());
+  CHECK_EXIT_SUCCESS(TestAutoRange(64, VTK_SHORT, 1 << 24));
+  CHECK_EXIT_SUCCESS(TestAutoRange(64, VTK_FLOAT, 1 << 24));
+  CHECK_EXIT_SUCCESS(TestNonFiniteValues());
+  // Sampled histogram
+  CHECK_EXIT_SUCCESS(TestAutoRange(64, VTK_SHORT, 10000));
+#ifdef NDEBUG
+  CHECK_EXIT_SUCCESS(TestAutoRange(256, VTK_SHORT, 1 << 24));
+#endif
+  return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include "vtkMRMLCoreTestingMacros.h"
 #include "vtkMRMLGridTransformNode.h"
 #include "vtkMRMLScene.h"
+#include "vtkOrientedGridTransform.h"
 
 int vtkMRMLGridTransformNodeTest1(int , char * [] )
 {
@@ -20,5 +21,29 @@ int vtkMRMLGridTransformNodeTest1(int , char * [] )
   vtkNew<vtkMRMLScene> scene;
   scene->AddNode(node1.GetPointer());
   EXERCISE_ALL_BASIC_MRML_METHODS(node1.GetPointer());
+
+  // Inverse grid caching is set in the grid transform and its inverse
+  CHECK_BOOL(node1->GetInverseGridCaching(), true);
+  vtkOrientedGridTransform* gridTransform =
+    vtkOrientedGridTransform::SafeDownCast(node1->GetTransformFromParent());
+  CHECK_NOT_NULL(gridTransform);
+  CHECK_BOOL(gridTransform->GetInverseGridCaching(), true);
+  vtkOrientedGridTransform* inverseGridTransform =
+    vtkOrientedGridTransform::SafeDownCast(node1->GetTransformToParent());
+  CHECK_NOT_NULL(inverseGridTransform);
+  inverseGridTransform->Update();
+  CHECK_BOOL(inverseGridTransform->GetInverseGridCaching(), true);
+  node1->InverseGridCachingOff();
+  CHECK_BOOL(gridTransform->GetInverseGridCaching(), false);
+  inverseGridTransform->Update();
+  CHECK_BOOL(inverseGridTransform->GetInverseGridCaching(), false);
+
+  // Transforms that are set later get the setting of the node
+  vtkNew<vtkOrientedGridTransform> newGridTransform;
+  newGridTransform->SetDisplacementGridData(gridTransform->GetDisplacementGrid());
+  newGridTransform->InverseGridCachingOn();
+  node1->SetAndObserveTransformFromParent(newGridTransform.GetPointer());
+  CHECK_BOOL(newGridTransform->GetInverseGridCaching(), false);
+
   return EXIT_SUCCESS;
 }
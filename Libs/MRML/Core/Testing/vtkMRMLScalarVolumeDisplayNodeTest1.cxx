@@ -10,12 +10,136 @@
 
 =========================================================================auto=*/
 
+#include "vtkMRMLColorTableNode.h"
 #include "vtkMRMLCoreTestingMacros.h"
 #include "vtkMRMLScalarVolumeDisplayNode.h"
+#include "vtkMRMLScene.h"
 
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkTrivialProducer.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> ComputeOutput(vtkMRMLScalarVolumeDisplayNode* displayNode,
+                                            bool useFusedDisplayFilter, double& time)
+{
+  displayNode->SetUseFusedDisplayFilter(useFusedDisplayFilter);
+  vtkAlgorithm* producer = displayNode->GetOutputImageDataConnection()->GetProducer();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  producer->Update();
+  timer->StopTimer();
+  time = timer->GetElapsedTime();
+  vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+  output->DeepCopy(producer->GetOutputDataObject(0));
+  return output;
+}
+
+//---------------------------------------------------------------------------
+int TestFusedDisplayFilter(int scalarType)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToGrey();
+  scene->AddNode(colorNode.GetPointer());
+
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  scene->AddNode(displayNode.GetPointer());
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+  displayNode->SetAutoWindowLevel(0);
+  displayNode->SetWindowLevel(1000., 200.);
+
+  const int size = 1024;
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(size, size, 1);
+  image->AllocateScalars(scalarType, 1);
+  for (int y = 0; y < size; ++y)
+    {
+    for (int x = 0; x < size; ++x)
+      {
+      image->SetScalarComponentFromDouble(x, y, 0, 0, ((x * 7 + y * 13) % 4096) - 1024.5);
+      }
+    }
+  vtkNew<vtkTrivialProducer> imageProducer;
+  imageProducer->SetOutput(image.GetPointer());
+  displayNode->SetInputImageDataConnection(imageProducer->GetOutputPort());
+
+  for (int applyThreshold = 0; applyThreshold < 2; ++applyThreshold)
+    {
+    displayNode->SetApplyThreshold(applyThreshold);
+    displayNode->SetThreshold(-200., 900.);
+
+    double chainTime = 0.0;
+    double fusedTime = 0.0;
+    vtkSmartPointer<vtkImageData> chainOutput = ComputeOutput(displayNode.GetPointer(), false, chainTime);
+    vtkSmartPointer<vtkImageData> fusedOutput = ComputeOutput(displayNode.GetPointer(), true, fusedTime);
+
+    CHECK_INT(fusedOutput->GetScalarType(), VTK_UNSIGNED_CHAR);
+    CHECK_INT(fusedOutput->GetNumberOfScalarComponents(), 4);
+    CHECK_INT(static_cast<int>(fusedOutput->GetNumberOfPoints()), static_cast<int>(chainOutput->GetNumberOfPoints()));
+    unsigned char* chainPtr = static_cast<unsigned char*>(chainOutput->GetScalarPointer());
+    unsigned char* fusedPtr = static_cast<unsigned char*>(fusedOutput->GetScalarPointer());
+    int maximumDifference = 0;
+    for (vtkIdType i = 0; i < chainOutput->GetNumberOfPoints() * 4; ++i)
+      {
+      maximumDifference = std::max(maximumDifference, std::abs(chainPtr[i] - fusedPtr[i]));
+      }
+    CHECK_BOOL(maximumDifference <= 1, true);
+
+    std::cout << image->GetScalarTypeAsString() << " applyThreshold=" << applyThreshold
+              << " filter chain: " << chainTime << "s"
+              << " fused display filter: " << fusedTime << "s" << std::endl;
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestUseFusedDisplayFilterSerialization()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  CHECK_BOOL(displayNode->GetUseFusedDisplayFilter(), true);
+  displayNode->SetUseFusedDisplayFilter(false);
+  scene->AddNode(displayNode.GetPointer());
+
+  scene->SetSaveToXMLString(1);
+  scene->Commit();
+  std::string sceneXMLString = scene->GetSceneXMLString();
+
+  vtkNew<vtkMRMLScene> scene2;
+  scene2->SetLoadFromXMLString(1);
+  scene2->SetSceneXMLString(sceneXMLString);
+  scene2->Import();
+  vtkMRMLScalarVolumeDisplayNode* importedDisplayNode =
+    vtkMRMLScalarVolumeDisplayNode::SafeDownCast(scene2->GetNodeByID(displayNode->GetID()));
+  CHECK_NOT_NULL(importedDisplayNode);
+  CHECK_BOOL(importedDisplayNode->GetUseFusedDisplayFilter(), false);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
 int vtkMRMLScalarVolumeDisplayNodeTest1(int , char * [] )
 {
   vtkNew<vtkMRMLScalarVolumeDisplayNode> node1;
   EXERCISE_ALL_BASIC_MRML_METHODS(node1.GetPointer());
+
+  CHECK_EXIT_SUCCESS(TestFusedDisplayFilter(VTK_SHORT));
+  CHECK_EXIT_SUCCESS(TestFusedDisplayFilter(VTK_FLOAT));
+  CHECK_EXIT_SUCCESS(TestUseFusedDisplayFilterSerialization());
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,165 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+class vtkMRMLSceneWithInternedIDs : public vtkMRMLScene
+{
+public:
+  static vtkMRMLSceneWithInternedIDs* New();
+  vtkTypeMacro(vtkMRMLSceneWithInternedIDs, vtkMRMLScene);
+  int GetNumberOfInternedIDs()
+    {
+    return static_cast<int>(this->InternedIDs.size());
+    }
+};
+vtkStandardNewMacro(vtkMRMLSceneWithInternedIDs);
+
+//---------------------------------------------------------------------------
+std::string GenerateSceneXML(int numberOfModels)
+{
+  std::stringstream xml;
+  xml << "<MRML version=\"Slicer4.4.0\" userTags=\"\">";
+  for (int i = 1; i <= numberOfModels; ++i)
+    {
+    xml << "<Model id=\"vtkMRMLModelNode" << i << "\" name=\"Model" << i << "\""
+        << " displayNodeRef=\"vtkMRMLModelDisplayNode" << i << "\" ></Model>"
+        << "<ModelDisplay id=\"vtkMRMLModelDisplayNode" << i << "\" name=\"Display" << i << "\" ></ModelDisplay>";
+    }
+  xml << "</MRML>";
+  return xml.str();
+}
+
+//---------------------------------------------------------------------------
+int TestImportPerformance(int numberOfModels)
+{
+  vtkNew<vtkMRMLScene> scene;
+  std::string sceneXML = GenerateSceneXML(numberOfModels);
+  scene->SetLoadFromXMLString(1);
+  vtkNew<vtkTimerLog> timer;
+
+  // First import: no ID conflict
+  scene->SetSceneXMLString(sceneXML);
+  timer->StartTimer();
+  scene->Import();
+  timer->StopTimer();
+  double firstImportTime = timer->GetElapsedTime();
+
+  // Second import: all IDs conflict, node IDs and references are remapped
+  scene->SetSceneXMLString(sceneXML);
+  timer->StartTimer();
+  scene->Import();
+  timer->StopTimer();
+  double secondImportTime = timer->GetElapsedTime();
+
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 2 * numberOfModels);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelDisplayNode"), 2 * numberOfModels);
+
+  // Lookup of all nodes by ID
+  std::vector<std::string> modelNodeIDs;
+  for (int i = 1; i <= 2 * numberOfModels; ++i)
+    {
+    std::stringstream id;
+    id << "vtkMRMLModelNode" << i;
+    modelNodeIDs.push_back(id.str());
+    }
+  timer->StartTimer();
+  std::vector<vtkMRMLNode*> referencingNodes;
+  for (std::vector<std::string>::iterator idIt = modelNodeIDs.begin(); idIt != modelNodeIDs.end(); ++idIt)
+    {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(scene->GetNodeByID(idIt->c_str()));
+    CHECK_NOT_NULL(modelNode);
+    vtkMRMLDisplayNode* displayNode = modelNode->GetDisplayNode();
+    CHECK_NOT_NULL(displayNode);
+    scene->GetReferencingNodes(displayNode, referencingNodes);
+    CHECK_INT(static_cast<int>(referencingNodes.size()), 1);
+    CHECK_POINTER(referencingNodes[0], modelNode);
+    }
+  timer->StopTimer();
+  double lookupTime = timer->GetElapsedTime();
+
+  std::cout << numberOfModels << " models:"
+            << " import: " << firstImportTime << "s"
+            << " import with ID conflicts: " << secondImportTime << "s"
+            << " lookup by ID and referencing nodes: " << lookupTime << "s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestInternedIDsReleased()
+{
+  vtkNew<vtkMRMLSceneWithInternedIDs> scene;
+  vtkNew<vtkMRMLModelNode> persistentModelNode;
+  scene->AddNode(persistentModelNode.GetPointer());
+  vtkNew<vtkMRMLModelDisplayNode> persistentDisplayNode;
+  scene->AddNode(persistentDisplayNode.GetPointer());
+  persistentModelNode->SetAndObserveDisplayNodeID(persistentDisplayNode->GetID());
+  int numberOfInternedIDs = scene->GetNumberOfInternedIDs();
+  CHECK_INT(numberOfInternedIDs, 2);
+
+  // IDs of removed nodes must not accumulate
+  for (int i = 0; i < 100; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> modelNode;
+    scene->AddNode(modelNode.GetPointer());
+    vtkNew<vtkMRMLModelDisplayNode> displayNode;
+    scene->AddNode(displayNode.GetPointer());
+    modelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+    modelNode->AddAndObserveDisplayNodeID(persistentDisplayNode->GetID());
+    CHECK_INT(scene->GetNumberOfInternedIDs(), numberOfInternedIDs + 2);
+    scene->RemoveNode(modelNode.GetPointer());
+    scene->RemoveNode(displayNode.GetPointer());
+    CHECK_INT(scene->GetNumberOfInternedIDs(), numberOfInternedIDs);
+    }
+
+  scene->Clear(1);
+  CHECK_INT(scene->GetNumberOfInternedIDs(), 0);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneImportPerformanceTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestInternedIDsReleased());
+  CHECK_EXIT_SUCCESS(TestImportPerformance(100));
+  CHECK_EXIT_SUCCESS(TestImportPerformance(1000));
+#ifdef NDEBUG
+  // In debug mode AddNode checks if the node is already in the scene, which
+  // makes populating a large scene too slow to be run as part of the tests.
+  CHECK_EXIT_SUCCESS(TestImportPerformance(10000));
+#endif
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+// Reference implementation: what GetNodesByClass used to do, a full scan of
+// the scene calling IsA() on each node.
+int GetNodesByClassUsingScan(vtkMRMLScene* scene, const char* className, std::vector<vtkMRMLNode*>& nodes)
+{
+  nodes.clear();
+  vtkCollection* sceneNodes = scene->GetNodes();
+  vtkMRMLNode* node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (sceneNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(sceneNodes->GetNextItemAsObject(it)));)
+    {
+    if (node->IsA(className))
+      {
+      nodes.push_back(node);
+      }
+    }
+  return static_cast<int>(nodes.size());
+}
+
+//---------------------------------------------------------------------------
+void PopulateScene(vtkMRMLScene* scene, int numberOfNodes)
+{
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkSmartPointer<vtkMRMLNode> node;
+    switch (i % 10)
+      {
+      case 0: node = vtkSmartPointer<vtkMRMLLinearTransformNode>::New(); break;
+      case 1: node = vtkSmartPointer<vtkMRMLModelNode>::New(); break;
+      default: node = vtkSmartPointer<vtkMRMLScriptedModuleNode>::New(); break;
+      }
+    // Set a name to avoid the (linear) unique name generation
+    std::stringstream name;
+    name << "Node" << i;
+    node->SetName(name.str().c_str());
+    scene->AddNode(node);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool CheckSameNodes(vtkMRMLScene* scene, const char* className)
+{
+  std::vector<vtkMRMLNode*> expectedNodes;
+  GetNodesByClassUsingScan(scene, className, expectedNodes);
+  std::vector<vtkMRMLNode*> nodes;
+  scene->GetNodesByClass(className, nodes);
+  if (nodes != expectedNodes)
+    {
+    std::cerr << "GetNodesByClass(" << className << ") returned " << nodes.size()
+              << " nodes, expected " << expectedNodes.size() << std::endl;
+    return false;
+    }
+  if (scene->GetNumberOfNodesByClass(className) != static_cast<int>(expectedNodes.size()))
+    {
+    std::cerr << "GetNumberOfNodesByClass(" << className << ") returned "
+              << scene->GetNumberOfNodesByClass(className)
+              << ", expected " << expectedNodes.size() << std::endl;
+    return false;
+    }
+  for (int n = 0; n < static_cast<int>(expectedNodes.size()); ++n)
+    {
+    if (scene->GetNthNodeByClass(n, className) != expectedNodes[n])
+      {
+      std::cerr << "GetNthNodeByClass(" << n << ", " << className << ") mismatch" << std::endl;
+      return false;
+      }
+    }
+  if (scene->GetNthNodeByClass(static_cast<int>(expectedNodes.size()), className) != nullptr)
+    {
+    std::cerr << "GetNthNodeByClass(" << expectedNodes.size() << ", " << className << ") is expected to be null" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int TestIndexConsistency()
+{
+  vtkNew<vtkMRMLScene> scene;
+  PopulateScene(scene.GetPointer(), 100);
+
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLTransformNode"), true);
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLDisplayableNode"), true);
+
+  // Add and remove nodes after the index is built
+  vtkNew<vtkMRMLModelNode> addedModelNode;
+  scene->AddNode(addedModelNode.GetPointer());
+  scene->RemoveNode(scene->GetNthNodeByClass(3, "vtkMRMLTransformNode"));
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLTransformNode"), true);
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLDisplayableNode"), true);
+  CHECK_POINTER(scene->GetNthNodeByClass(scene->GetNumberOfNodesByClass("vtkMRMLModelNode") - 1,
+    "vtkMRMLModelNode"), addedModelNode.GetPointer());
+
+  // Insert a node in the middle of the scene
+  vtkNew<vtkMRMLModelNode> insertedModelNode;
+  scene->InsertAfterNode(scene->GetNthNode(5), insertedModelNode.GetPointer());
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLModelNode"), true);
+
+  // Modify the node collection directly
+  vtkNew<vtkMRMLModelNode> directlyAddedModelNode;
+  scene->GetNodes()->AddItem(directlyAddedModelNode.GetPointer());
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLModelNode"), true);
+  scene->GetNodes()->RemoveItem(directlyAddedModelNode.GetPointer());
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLModelNode"), true);
+
+  // Clear
+  scene->Clear(1);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 0);
+  CHECK_BOOL(CheckSameNodes(scene.GetPointer(), "vtkMRMLNode"), true);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPerformance(int numberOfNodes)
+{
+  vtkNew<vtkMRMLScene> scene;
+  PopulateScene(scene.GetPointer(), numberOfNodes);
+
+  const char* classNames[] = { "vtkMRMLTransformNode", "vtkMRMLModelNode", "vtkMRMLDisplayableNode" };
+  const int numberOfClassNames = sizeof(classNames) / sizeof(classNames[0]);
+  const int numberOfRepeats = 100;
+
+  vtkNew<vtkTimerLog> timer;
+  std::vector<vtkMRMLNode*> nodes;
+
+  // Full scan
+  timer->StartTimer();
+  int scanCount = 0;
+  for (int repeat = 0; repeat < numberOfRepeats; ++repeat)
+    {
+    for (int classIndex = 0; classIndex < numberOfClassNames; ++classIndex)
+      {
+      scanCount += GetNodesByClassUsingScan(scene.GetPointer(), classNames[classIndex], nodes);
+      }
+    }
+  timer->StopTimer();
+  double scanTime = timer->GetElapsedTime();
+
+  // Class index (first query of each class builds the index entry)
+  timer->StartTimer();
+  int indexCount = 0;
+  for (int repeat = 0; repeat < numberOfRepeats; ++repeat)
+    {
+    for (int classIndex = 0; classIndex < numberOfClassNames; ++classIndex)
+      {
+      indexCount += scene->GetNumberOfNodesByClass(classNames[classIndex]);
+      }
+    }
+  timer->StopTimer();
+  double indexTime = timer->GetElapsedTime();
+
+  CHECK_INT(indexCount, scanCount);
+
+  std::cout << numberOfNodes << " nodes, " << numberOfRepeats * numberOfClassNames << " queries:"
+            << " scan: " << scanTime << "s"
+            << " index: " << indexTime << "s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodesByClassPerformanceTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestIndexConsistency());
+
+  CHECK_EXIT_SUCCESS(TestPerformance(1000));
+  CHECK_EXIT_SUCCESS(TestPerformance(10000));
+#ifdef NDEBUG
+  // In debug mode AddNode checks if the node is already in the scene, which
+  // makes populating a large scene too slow to be run as part of the tests.
+  CHECK_EXIT_SUCCESS(TestPerformance(100000));
+#endif
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkMRMLStorageNode.h"
+
+// SegmentationCore includes
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+const int NumberOfModels = 6;
+const int NumberOfVolumes = 4;
+const int NumberOfTransforms = 3;
+const int NumberOfSegmentations = 2;
+
+//---------------------------------------------------------------------------
+void ProgressCallback(vtkObject* vtkNotUsed(caller), unsigned long eid,
+                      void* clientData, void* vtkNotUsed(callData))
+{
+  if (eid == (vtkMRMLScene::StateEvent | vtkMRMLScene::ProgressEvent | vtkMRMLScene::ImportState))
+    {
+    ++(*reinterpret_cast<int*>(clientData));
+    }
+}
+
+//---------------------------------------------------------------------------
+int CreateScene(const std::string& tempDir, const std::string& sceneFileName)
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetRootDirectory(tempDir.c_str());
+
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkNew<vtkSphereSource> sphere;
+    sphere->SetThetaResolution(8 + i);
+    sphere->SetPhiResolution(8 + i);
+    sphere->Update();
+    vtkNew<vtkMRMLModelNode> modelNode;
+    std::stringstream name;
+    name << "Model" << i;
+    modelNode->SetName(name.str().c_str());
+    modelNode->SetAndObservePolyData(sphere->GetOutput());
+    modelNode->SetAttribute("ParallelReadDataTest", name.str().c_str());
+    scene->AddNode(modelNode.GetPointer());
+    modelNode->AddDefaultStorageNode();
+    std::string fileName = tempDir + "/vtkMRMLSceneParallelReadDataTest_" + name.str() + ".vtp";
+    modelNode->GetStorageNode()->SetFileName(fileName.c_str());
+    CHECK_BOOL(modelNode->GetStorageNode()->WriteData(modelNode.GetPointer()) != 0, true);
+    }
+
+  for (int i = 0; i < NumberOfVolumes; ++i)
+    {
+    vtkNew<vtkImageData> imageData;
+    imageData->SetDimensions(16 + i, 16, 16);
+    imageData->AllocateScalars(VTK_SHORT, 1);
+    imageData->GetPointData()->GetScalars()->FillComponent(0, 10 * i);
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    std::stringstream name;
+    name << "Volume" << i;
+    volumeNode->SetName(name.str().c_str());
+    volumeNode->SetAndObserveImageData(imageData.GetPointer());
+    volumeNode->SetOrigin(i, 0, 0);
+    volumeNode->SetAttribute("ParallelReadDataTest", name.str().c_str());
+    scene->AddNode(volumeNode.GetPointer());
+    volumeNode->AddDefaultStorageNode();
+    std::string fileName = tempDir + "/vtkMRMLSceneParallelReadDataTest_" + name.str() + ".nrrd";
+    volumeNode->GetStorageNode()->SetFileName(fileName.c_str());
+    CHECK_BOOL(volumeNode->GetStorageNode()->WriteData(volumeNode.GetPointer()) != 0, true);
+    }
+
+  for (int i = 0; i < NumberOfTransforms; ++i)
+    {
+    vtkNew<vtkMRMLLinearTransformNode> transformNode;
+    std::stringstream name;
+    name << "Transform" << i;
+    transformNode->SetName(name.str().c_str());
+    vtkNew<vtkMatrix4x4> matrix;
+    matrix->SetElement(0, 3, 12.5 + i);
+    transformNode->SetMatrixTransformToParent(matrix.GetPointer());
+    scene->AddNode(transformNode.GetPointer());
+    transformNode->AddDefaultStorageNode();
+    std::string fileName = tempDir + "/vtkMRMLSceneParallelReadDataTest_" + name.str() + ".h5";
+    transformNode->GetStorageNode()->SetFileName(fileName.c_str());
+    CHECK_BOOL(transformNode->GetStorageNode()->WriteData(transformNode.GetPointer()) != 0, true);
+    // node references must be kept when the data is set in the node
+    scene->GetNthNodeByClass(i, "vtkMRMLModelNode")->SetNodeReferenceID("ParallelReadDataTest", transformNode->GetID());
+    }
+
+  for (int i = 0; i < NumberOfSegmentations; ++i)
+    {
+    vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+    std::stringstream name;
+    name << "Segmentation" << i;
+    segmentationNode->SetName(name.str().c_str());
+    vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+    segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetClosedSurfaceRepresentationName());
+    for (int segmentIndex = 0; segmentIndex <= i; ++segmentIndex)
+      {
+      vtkNew<vtkSphereSource> sphere;
+      sphere->SetCenter(10.0 * segmentIndex, 0, 0);
+      sphere->Update();
+      vtkNew<vtkSegment> segment;
+      segment->AddRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName(), sphere->GetOutput());
+      segmentation->AddSegment(segment.GetPointer());
+      }
+    scene->AddNode(segmentationNode.GetPointer());
+    segmentationNode->AddDefaultStorageNode();
+    std::string fileName = tempDir + "/vtkMRMLSceneParallelReadDataTest_" + name.str() + ".seg.vtm";
+    segmentationNode->GetStorageNode()->SetFileName(fileName.c_str());
+    CHECK_BOOL(segmentationNode->GetStorageNode()->WriteData(segmentationNode.GetPointer()) != 0, true);
+    }
+
+  scene->SetURL(sceneFileName.c_str());
+  CHECK_BOOL(scene->Commit() != 0, true);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPreloadData(const std::string& tempDir)
+{
+  // PreloadData() is called from background threads: the data object must be
+  // kept in the storage node and not set in the node, which would add
+  // observations to the (not thread-safe) event broker.
+  vtkNew<vtkMRMLModelNode> modelNode;
+  vtkSmartPointer<vtkMRMLStorageNode> modelStorageNode =
+    vtkSmartPointer<vtkMRMLStorageNode>::Take(modelNode->CreateDefaultStorageNode());
+  std::string modelFileName = tempDir + "/vtkMRMLSceneParallelReadDataTest_Model0.vtp";
+  modelStorageNode->SetFileName(modelFileName.c_str());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  vtkSmartPointer<vtkMRMLStorageNode> volumeStorageNode =
+    vtkSmartPointer<vtkMRMLStorageNode>::Take(volumeNode->CreateDefaultStorageNode());
+  std::string volumeFileName = tempDir + "/vtkMRMLSceneParallelReadDataTest_Volume1.nrrd";
+  volumeStorageNode->SetFileName(volumeFileName.c_str());
+
+  int numberOfObservations = vtkEventBroker::GetInstance()->GetNumberOfObservations();
+  CHECK_BOOL(modelStorageNode->PreloadData(modelNode.GetPointer()) != 0, true);
+  CHECK_BOOL(volumeStorageNode->PreloadData(volumeNode.GetPointer()) != 0, true);
+  CHECK_INT(vtkEventBroker::GetInstance()->GetNumberOfObservations(), numberOfObservations);
+  CHECK_NULL(modelNode->GetPolyData());
+  CHECK_NULL(volumeNode->GetImageData());
+  vtkPolyData* polyData = vtkPolyData::SafeDownCast(modelStorageNode->GetPreloadedData());
+  CHECK_NOT_NULL(polyData);
+  CHECK_INT(polyData->GetNumberOfPoints(), 8 * 6 + 2);
+  vtkImageData* imageData = vtkImageData::SafeDownCast(volumeStorageNode->GetPreloadedData());
+  CHECK_NOT_NULL(imageData);
+  CHECK_INT(imageData->GetDimensions()[0], 17);
+  // orientation is set in the node
+  CHECK_DOUBLE(volumeNode->GetOrigin()[0], 1.0);
+
+  // the data is set in the node in the main thread
+  vtkNew<vtkMRMLModelNode> sceneModelNode;
+  vtkSmartPointer<vtkMRMLStorageNode> sceneModelStorageNode =
+    vtkSmartPointer<vtkMRMLStorageNode>::Take(sceneModelNode->CreateDefaultStorageNode());
+  sceneModelStorageNode->SetFileName(modelFileName.c_str());
+  sceneModelStorageNode->SetPreloadedNode(modelNode.GetPointer(), polyData);
+  CHECK_BOOL(sceneModelStorageNode->ReadData(sceneModelNode.GetPointer()) != 0, true);
+  CHECK_POINTER(sceneModelNode->GetPolyData(), polyData);
+  CHECK_NULL(sceneModelStorageNode->GetPreloadedNode());
+  CHECK_NULL(sceneModelStorageNode->GetPreloadedData());
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestImport(const std::string& sceneFileName, int numberOfThreads)
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetNumberOfReadDataThreads(numberOfThreads);
+  CHECK_INT(scene->GetNumberOfReadDataThreads(), numberOfThreads);
+
+  int numberOfProgressEvents = 0;
+  vtkNew<vtkCallbackCommand> progressCallback;
+  progressCallback->SetCallback(ProgressCallback);
+  progressCallback->SetClientData(&numberOfProgressEvents);
+  scene->AddObserver(vtkCommand::AnyEvent, progressCallback.GetPointer());
+
+  scene->SetURL(sceneFileName.c_str());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  CHECK_BOOL(scene->Import() != 0, true);
+  timer->StopTimer();
+  CHECK_INT(scene->GetErrorCode(), 0);
+
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    std::stringstream name;
+    name << "Model" << i;
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(
+      scene->GetFirstNodeByName(name.str().c_str()));
+    CHECK_NOT_NULL(modelNode);
+    CHECK_NOT_NULL(modelNode->GetPolyData());
+    CHECK_INT(modelNode->GetPolyData()->GetNumberOfPoints(), (8 + i) * (8 + i - 2) + 2);
+    // attributes and node references are not overwritten by the preloaded node
+    CHECK_STRING(modelNode->GetAttribute("ParallelReadDataTest"), name.str().c_str());
+    if (i < NumberOfTransforms)
+      {
+      std::stringstream transformName;
+      transformName << "Transform" << i;
+      CHECK_POINTER(modelNode->GetNodeReference("ParallelReadDataTest"),
+        scene->GetFirstNodeByName(transformName.str().c_str()));
+      }
+    // the storage node is still referenced and the data is not modified since read
+    CHECK_NOT_NULL(modelNode->GetStorageNode());
+    CHECK_NULL(modelNode->GetStorageNode()->GetPreloadedNode());
+    CHECK_BOOL(modelNode->GetModifiedSinceRead(), false);
+    }
+
+  for (int i = 0; i < NumberOfVolumes; ++i)
+    {
+    std::stringstream name;
+    name << "Volume" << i;
+    vtkMRMLScalarVolumeNode* volumeNode = vtkMRMLScalarVolumeNode::SafeDownCast(
+      scene->GetFirstNodeByName(name.str().c_str()));
+    CHECK_NOT_NULL(volumeNode);
+    CHECK_NOT_NULL(volumeNode->GetImageData());
+    int dimensions[3] = { 0, 0, 0 };
+    volumeNode->GetImageData()->GetDimensions(dimensions);
+    CHECK_INT(dimensions[0], 16 + i);
+    CHECK_DOUBLE(volumeNode->GetImageData()->GetScalarComponentAsDouble(3, 3, 3, 0), 10.0 * i);
+    CHECK_DOUBLE(volumeNode->GetOrigin()[0], static_cast<double>(i));
+    CHECK_STRING(volumeNode->GetAttribute("ParallelReadDataTest"), name.str().c_str());
+    CHECK_BOOL(volumeNode->GetModifiedSinceRead(), false);
+    }
+
+  // transforms and segmentations are not preloaded (reading them adds MRML
+  // observations), they are read by the main thread
+  for (int i = 0; i < NumberOfTransforms; ++i)
+    {
+    std::stringstream name;
+    name << "Transform" << i;
+    vtkMRMLLinearTransformNode* transformNode = vtkMRMLLinearTransformNode::SafeDownCast(
+      scene->GetFirstNodeByName(name.str().c_str()));
+    CHECK_NOT_NULL(transformNode);
+    CHECK_BOOL(transformNode->GetStorageNode()->CanPreloadData(transformNode), false);
+    vtkNew<vtkMatrix4x4> matrix;
+    transformNode->GetMatrixTransformToParent(matrix.GetPointer());
+    CHECK_DOUBLE(matrix->GetElement(0, 3), 12.5 + i);
+    }
+
+  for (int i = 0; i < NumberOfSegmentations; ++i)
+    {
+    std::stringstream name;
+    name << "Segmentation" << i;
+    vtkMRMLSegmentationNode* segmentationNode = vtkMRMLSegmentationNode::SafeDownCast(
+      scene->GetFirstNodeByName(name.str().c_str()));
+    CHECK_NOT_NULL(segmentationNode);
+    CHECK_BOOL(segmentationNode->GetStorageNode()->CanPreloadData(segmentationNode), false);
+    CHECK_NOT_NULL(segmentationNode->GetSegmentation());
+    CHECK_INT(segmentationNode->GetSegmentation()->GetNumberOfSegments(), i + 1);
+    CHECK_NOT_NULL(segmentationNode->GetDisplayNode());
+    }
+
+  if (numberOfThreads > 1)
+    {
+    CHECK_BOOL(scene->GetLastPreloadDataSize() > 0, true);
+    CHECK_BOOL(numberOfProgressEvents > 0, true);
+    }
+  else
+    {
+    CHECK_INT(static_cast<int>(scene->GetLastPreloadDataSize()), 0);
+    }
+  std::cout << "Import with " << numberOfThreads << " threads: " << timer->GetElapsedTime() << "s"
+            << " (files read in background: " << scene->GetLastPreloadDataSize() / 1.0e6 << "MB"
+            << " in " << scene->GetLastPreloadDataTime() << "s)" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneParallelReadDataTest(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+  std::string sceneFileName = tempDir + "/vtkMRMLSceneParallelReadDataTest.mrml";
+
+  CHECK_EXIT_SUCCESS(CreateScene(tempDir, sceneFileName));
+  CHECK_EXIT_SUCCESS(TestPreloadData(tempDir));
+  CHECK_EXIT_SUCCESS(TestImport(sceneFileName, 1));
+  CHECK_EXIT_SUCCESS(TestImport(sceneFileName, 4));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+void PopulateScene(vtkMRMLScene* scene, int numberOfNodes, std::vector<vtkMRMLScriptedModuleNode*>& nodes)
+{
+  nodes.clear();
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkSmartPointer<vtkMRMLScriptedModuleNode> node = vtkSmartPointer<vtkMRMLScriptedModuleNode>::New();
+    std::stringstream name;
+    name << "Node" << i;
+    node->SetName(name.str().c_str());
+    node->SetParameter("Value", "0");
+    node->UndoEnabledOn();
+    scene->AddNode(node);
+    nodes.push_back(node);
+    }
+}
+
+//---------------------------------------------------------------------------
+int TestUndoRedo()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  std::vector<vtkMRMLScriptedModuleNode*> nodes;
+  PopulateScene(scene.GetPointer(), 10, nodes);
+
+  scene->SaveStateForUndo();
+  nodes[1]->SetParameter("Value", "1");
+  scene->SaveStateForUndo();
+  nodes[2]->SetParameter("Value", "2");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+
+  scene->Undo();
+  CHECK_STD_STRING(nodes[1]->GetParameter("Value"), "1");
+  CHECK_STD_STRING(nodes[2]->GetParameter("Value"), "0");
+  scene->Undo();
+  CHECK_STD_STRING(nodes[1]->GetParameter("Value"), "0");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 2);
+
+  scene->Redo();
+  CHECK_STD_STRING(nodes[1]->GetParameter("Value"), "1");
+  scene->Redo();
+  CHECK_STD_STRING(nodes[2]->GetParameter("Value"), "2");
+
+  // Removed node is restored by undo. The saved state is shared by the two
+  // undo levels, modifying the restored node must not alter it.
+  scene->SaveStateForUndo();
+  scene->SaveStateForUndo();
+  std::string removedNodeID = nodes[3]->GetID();
+  scene->RemoveNode(nodes[3]);
+  scene->Undo();
+  vtkMRMLScriptedModuleNode* restoredNode =
+    vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(removedNodeID));
+  CHECK_NOT_NULL(restoredNode);
+  CHECK_STD_STRING(restoredNode->GetParameter("Value"), "0");
+  restoredNode->SetParameter("Value", "3");
+  scene->Undo();
+  CHECK_POINTER(scene->GetNodeByID(removedNodeID), restoredNode);
+  CHECK_STD_STRING(restoredNode->GetParameter("Value"), "0");
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestSharedStatesAndMemoryLimit()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  std::vector<vtkMRMLScriptedModuleNode*> nodes;
+  PopulateScene(scene.GetPointer(), 100, nodes);
+
+  scene->SaveStateForUndo();
+  vtkTypeInt64 firstLevelSize = scene->GetUndoStackMemorySize();
+  CHECK_BOOL(firstLevelSize > 0, true);
+
+  // Unmodified nodes are not copied again
+  for (int i = 0; i < 10; ++i)
+    {
+    nodes[i]->SetParameter("Value", "1");
+    scene->SaveStateForUndo();
+    }
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 11);
+  vtkTypeInt64 undoStackSize = scene->GetUndoStackMemorySize();
+  CHECK_BOOL(undoStackSize < firstLevelSize * 2, true);
+
+  // Memory limit removes the oldest levels but keeps the latest one
+  scene->SetMaximumUndoStackMemorySize(firstLevelSize + 1);
+  CHECK_BOOL(scene->GetNumberOfUndoLevels() < 11, true);
+  CHECK_BOOL(scene->GetNumberOfUndoLevels() >= 1, true);
+  CHECK_BOOL(scene->GetUndoStackMemorySize() <= firstLevelSize + 1, true);
+  scene->SetMaximumUndoStackMemorySize(1);
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 1);
+
+  scene->Undo();
+  CHECK_STD_STRING(nodes[8]->GetParameter("Value"), "1");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+
+  scene->ClearUndoStack();
+  scene->ClearRedoStack();
+  CHECK_BOOL(scene->GetUndoStackMemorySize() == 0, true);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestTrimmedLevels()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  scene->SetMaximumNumberOfSavedUndoStates(2);
+  std::vector<vtkMRMLScriptedModuleNode*> nodes;
+  PopulateScene(scene.GetPointer(), 10, nodes);
+
+  // Each level only stores the nodes modified since the previous level,
+  // the state of the other nodes is saved in the first level.
+  scene->SaveStateForUndo();
+  vtkTypeInt64 firstLevelSize = scene->GetUndoStackMemorySize();
+  nodes[1]->SetParameter("Value", "1");
+  scene->SaveStateForUndo();
+  CHECK_BOOL(scene->GetUndoStackMemorySize() > firstLevelSize, true);
+  CHECK_BOOL(scene->GetUndoStackMemorySize() < firstLevelSize + firstLevelSize * 2 / 10, true);
+
+  // Removing the first level must keep the node states that the next levels rely on
+  std::string removedNodeID = nodes[4]->GetID();
+  scene->RemoveNode(nodes[4]);
+  nodes[2]->SetParameter("Value", "2");
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+  nodes[3]->SetParameter("Value", "3");
+
+  scene->Undo();
+  CHECK_STD_STRING(nodes[1]->GetParameter("Value"), "1");
+  CHECK_STD_STRING(nodes[2]->GetParameter("Value"), "2");
+  CHECK_STD_STRING(nodes[3]->GetParameter("Value"), "0");
+  CHECK_NULL(scene->GetNodeByID(removedNodeID));
+
+  scene->Undo();
+  CHECK_STD_STRING(nodes[1]->GetParameter("Value"), "1");
+  CHECK_STD_STRING(nodes[2]->GetParameter("Value"), "0");
+  vtkMRMLScriptedModuleNode* restoredNode =
+    vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(removedNodeID));
+  CHECK_NOT_NULL(restoredNode);
+  CHECK_STD_STRING(restoredNode->GetParameter("Value"), "0");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPerformance(int numberOfNodes)
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  std::vector<vtkMRMLScriptedModuleNode*> nodes;
+  PopulateScene(scene.GetPointer(), numberOfNodes, nodes);
+
+  const int numberOfSaves = 20;
+  vtkNew<vtkTimerLog> timer;
+
+  timer->StartTimer();
+  scene->SaveStateForUndo();
+  timer->StopTimer();
+  double firstSaveTime = timer->GetElapsedTime();
+
+  timer->StartTimer();
+  for (int i = 0; i < numberOfSaves; ++i)
+    {
+    nodes[i % numberOfNodes]->SetParameter("Value", "1");
+    scene->SaveStateForUndo();
+    }
+  timer->StopTimer();
+  double saveTime = timer->GetElapsedTime() / numberOfSaves;
+
+  timer->StartTimer();
+  scene->Undo();
+  timer->StopTimer();
+  double undoTime = timer->GetElapsedTime();
+
+  std::cout << numberOfNodes << " nodes:"
+            << " first save: " << firstSaveTime << "s"
+            << " save after single node change: " << saveTime << "s"
+            << " undo: " << undoTime << "s"
+            << " undo stack memory: " << scene->GetUndoStackMemorySize() << " bytes" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestUndoRedo());
+  CHECK_EXIT_SUCCESS(TestSharedStatesAndMemoryLimit());
+  CHECK_EXIT_SUCCESS(TestTrimmedLevels());
+
+  CHECK_EXIT_SUCCESS(TestPerformance(1000));
+#ifdef NDEBUG
+  // In debug mode AddNode checks if the node is already in the scene, which
+  // makes populating a large scene too slow to be run as part of the tests.
+  CHECK_EXIT_SUCCESS(TestPerformance(10000));
+#endif
+  return EXIT_SUCCESS;
+}
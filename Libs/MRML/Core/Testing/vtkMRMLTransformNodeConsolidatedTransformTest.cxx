@@ -0,0 +1,207 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLTransformNode.h"
+#include "vtkOrientedGridTransform.h"
+
+// VTK includes
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkThinPlateSplineTransform.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Maximum distance between points transformed by the two transforms
+double GetMaximumDifference(vtkAbstractTransform* transform1, vtkAbstractTransform* transform2, vtkPoints* points)
+{
+  double maximumDifference = 0.0;
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    points->GetPoint(i, point);
+    double transformedPoint1[3] = { 0.0, 0.0, 0.0 };
+    transform1->TransformPoint(point, transformedPoint1);
+    double transformedPoint2[3] = { 0.0, 0.0, 0.0 };
+    transform2->TransformPoint(point, transformedPoint2);
+    maximumDifference = std::max(maximumDifference, sqrt(vtkMath::Distance2BetweenPoints(transformedPoint1, transformedPoint2)));
+    }
+  return maximumDifference;
+}
+
+//----------------------------------------------------------------------------
+/// Time of transforming the points
+double GetTransformTime(vtkAbstractTransform* transform, vtkPoints* points)
+{
+  vtkNew<vtkPoints> transformedPoints;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  transform->TransformPoints(points, transformedPoints.GetPointer());
+  timer->StopTimer();
+  return timer->GetElapsedTime();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLTransformNodeConsolidatedTransformTest(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // WORLD
+  //  |-- tpsTransformNode (thin-plate spline)
+  //         |-- linearTransformNode
+  vtkNew<vtkThinPlateSplineTransform> tpsTransform;
+  vtkNew<vtkPoints> sourceLandmarks;
+  vtkNew<vtkPoints> targetLandmarks;
+  const double landmarks[][6] = {
+    { -50, -50, -50,  -48, -53, -50 }, {  50, -50, -50,  52, -49, -47 },
+    { -50,  50, -50, -50,  50, -52 }, {  50,  50, -50,  47,  53, -50 },
+    { -50, -50,  50, -50, -48,  51 }, {  50, -50,  50,  50, -50,  47 },
+    { -50,  50,  50, -53,  51,  50 }, {  50,  50,  50,  50,  48,  53 },
+    {   0,   0,   0,   3,  -2,   2 } };
+  for (const double* landmark : landmarks)
+    {
+    sourceLandmarks->InsertNextPoint(landmark[0], landmark[1], landmark[2]);
+    targetLandmarks->InsertNextPoint(landmark[3], landmark[4], landmark[5]);
+    }
+  tpsTransform->SetSourceLandmarks(sourceLandmarks.GetPointer());
+  tpsTransform->SetTargetLandmarks(targetLandmarks.GetPointer());
+  tpsTransform->SetBasisToR();
+  vtkNew<vtkMRMLTransformNode> tpsTransformNode;
+  scene->AddNode(tpsTransformNode.GetPointer());
+  tpsTransformNode->SetAndObserveTransformToParent(tpsTransform.GetPointer());
+
+  vtkNew<vtkTransform> linearTransform;
+  linearTransform->Translate(5, -3, 2);
+  linearTransform->RotateZ(10);
+  vtkNew<vtkMRMLTransformNode> linearTransformNode;
+  scene->AddNode(linearTransformNode.GetPointer());
+  linearTransformNode->SetMatrixTransformToParent(linearTransform->GetMatrix());
+  linearTransformNode->SetAndObserveTransformNodeID(tpsTransformNode->GetID());
+
+  const double bounds[6] = { -40, 40, -40, 40, -40, 40 };
+  vtkNew<vtkPoints> points;
+  vtkMath::RandomSeed(42);
+  for (int i = 0; i < 20000; i++)
+    {
+    points->InsertNextPoint(vtkMath::Random(bounds[0], bounds[1]),
+      vtkMath::Random(bounds[2], bounds[3]), vtkMath::Random(bounds[4], bounds[5]));
+    }
+
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  linearTransformNode->GetTransformToWorld(transformToWorld.GetPointer());
+
+  // Consolidation is disabled by default, the full chain is returned
+  vtkNew<vtkGeneralTransform> consolidatedTransformToWorld;
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformCaching(), false);
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), false);
+  CHECK_BOOL(vtkMRMLTransformNode::AreTransformsEqual(consolidatedTransformToWorld.GetPointer(), transformToWorld.GetPointer()), true);
+
+  // Consolidated grid transform
+  linearTransformNode->ConsolidatedTransformCachingOn();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), true);
+  timer->StopTimer();
+  double consolidationTime = timer->GetElapsedTime();
+  CHECK_INT(consolidatedTransformToWorld->GetNumberOfConcatenatedTransforms(), 1);
+  // keep a reference to the grid transform to detect if a new grid is computed
+  vtkSmartPointer<vtkAbstractTransform> gridTransform = consolidatedTransformToWorld->GetConcatenatedTransform(0);
+  CHECK_NOT_NULL(vtkOrientedGridTransform::SafeDownCast(gridTransform));
+  double consolidationError = GetMaximumDifference(transformToWorld.GetPointer(), consolidatedTransformToWorld.GetPointer(), points.GetPointer());
+
+  std::cout << "Transform " << points->GetNumberOfPoints() << " points:" << std::endl
+    << "  full transform chain: " << GetTransformTime(transformToWorld.GetPointer(), points.GetPointer()) << "s" << std::endl
+    << "  consolidated transform: " << GetTransformTime(consolidatedTransformToWorld.GetPointer(), points.GetPointer()) << "s"
+    << " (grid computation: " << consolidationTime << "s), maximum error = " << consolidationError << std::endl;
+  CHECK_BOOL(consolidationError < 0.1, true);
+
+  // The grid is reused if nothing has changed and the region is covered by the grid
+  const double smallerBounds[6] = { -10, 10, -10, 10, -10, 10 };
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), smallerBounds), true);
+  CHECK_POINTER(consolidatedTransformToWorld->GetConcatenatedTransform(0), gridTransform.GetPointer());
+
+  // The grid is recomputed if a transform in the chain is modified
+  targetLandmarks->SetPoint(8, 5, -3, 4);
+  tpsTransform->Modified();
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), true);
+  CHECK_POINTER_DIFFERENT(consolidatedTransformToWorld->GetConcatenatedTransform(0), gridTransform.GetPointer());
+  linearTransformNode->GetTransformToWorld(transformToWorld.GetPointer());
+  CHECK_BOOL(GetMaximumDifference(transformToWorld.GetPointer(), consolidatedTransformToWorld.GetPointer(), points.GetPointer()) < 0.1, true);
+  gridTransform = consolidatedTransformToWorld->GetConcatenatedTransform(0);
+
+  // The grid is recomputed if the chain changes
+  linearTransformNode->SetAndObserveTransformNodeID(nullptr);
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), false);
+  linearTransformNode->SetAndObserveTransformNodeID(tpsTransformNode->GetID());
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), true);
+  CHECK_POINTER_DIFFERENT(consolidatedTransformToWorld->GetConcatenatedTransform(0), gridTransform.GetPointer());
+  gridTransform = consolidatedTransformToWorld->GetConcatenatedTransform(0);
+
+  // The grid is recomputed to cover both regions if a region outside of the grid is requested
+  const double shiftedBounds[6] = { 0, 60, -40, 40, -40, 40 };
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), shiftedBounds), true);
+  CHECK_POINTER_DIFFERENT(consolidatedTransformToWorld->GetConcatenatedTransform(0), gridTransform.GetPointer());
+  gridTransform = consolidatedTransformToWorld->GetConcatenatedTransform(0);
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), true);
+  CHECK_POINTER(consolidatedTransformToWorld->GetConcatenatedTransform(0), gridTransform.GetPointer());
+
+  // Consolidated transform from world
+  vtkNew<vtkGeneralTransform> transformFromWorld;
+  linearTransformNode->GetTransformFromWorld(transformFromWorld.GetPointer());
+  vtkNew<vtkGeneralTransform> consolidatedTransformFromWorld;
+  CHECK_BOOL(linearTransformNode->GetConsolidatedTransformFromWorld(consolidatedTransformFromWorld.GetPointer(), bounds), true);
+  CHECK_BOOL(GetMaximumDifference(transformFromWorld.GetPointer(), consolidatedTransformFromWorld.GetPointer(), points.GetPointer()) < 0.1, true);
+
+  // Linear transform chains are not consolidated
+  vtkNew<vtkMRMLTransformNode> otherLinearTransformNode;
+  scene->AddNode(otherLinearTransformNode.GetPointer());
+  otherLinearTransformNode->SetMatrixTransformToParent(linearTransform->GetMatrix());
+  otherLinearTransformNode->ConsolidatedTransformCachingOn();
+  CHECK_BOOL(otherLinearTransformNode->GetConsolidatedTransformToWorld(consolidatedTransformToWorld.GetPointer(), bounds), false);
+  CHECK_BOOL(vtkMRMLTransformNode::IsGeneralTransformLinear(consolidatedTransformToWorld.GetPointer()), true);
+
+  // Displacement grid sampling
+  vtkNew<vtkImageData> displacementGrid;
+  displacementGrid->SetExtent(0, 9, 0, 9, 0, 9);
+  vtkNew<vtkMatrix4x4> gridIJKToRAS;
+  gridIJKToRAS->SetElement(0, 0, 5.0);
+  gridIJKToRAS->SetElement(1, 1, 5.0);
+  gridIJKToRAS->SetElement(2, 2, 5.0);
+  CHECK_BOOL(vtkMRMLTransformNode::ComputeDisplacementGrid(linearTransform.GetPointer(), gridIJKToRAS.GetPointer(), displacementGrid.GetPointer()), true);
+  double point[3] = { 45.0, 10.0, 20.0 };
+  double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+  linearTransform->TransformPoint(point, transformedPoint);
+  for (int axis = 0; axis < 3; axis++)
+    {
+    CHECK_DOUBLE_TOLERANCE(displacementGrid->GetScalarComponentAsDouble(9, 2, 4, axis), transformedPoint[axis] - point[axis], 1e-6);
+    }
+
+  std::cout << "Success" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -24,6 +24,19 @@
 
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
+//----------------------------------------------------------------------------
+// Element of the posted event queue.
+// The queue is a singly linked list (last posted event first) that producers
+// push to with a compare-and-swap on its head. The consumer takes the whole
+// list at once with an exchange, so there is no ABA problem.
+struct vtkEventBroker::PostedEvent
+{
+  vtkObject *Subject;
+  unsigned long Event;
+  void *CallData;
+  PostedEvent *Next;
+};
+
 //----------------------------------------------------------------------------
 // The IO manager singleton.
 // This MUST be default initialized to zero by the compiler and is
@@ -98,6 +111,9 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = nullptr;
   this->ScriptHandler = nullptr;
   this->ScriptHandlerClientData = nullptr;
+  this->PostedEvents = nullptr;
+  this->PostedEventCallback = nullptr;
+  this->PostedEventCallbackClientData = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -106,6 +122,16 @@ vtkEventBroker::~vtkEventBroker()
   /// fast and dangerous but ok because we are in the destructor.
   this->DetachObservations();
 
+  // discard events that have not been processed
+  PostedEvent *postedEvent = this->PostedEvents.exchange(nullptr);
+  while ( postedEvent )
+    {
+    PostedEvent *next = postedEvent->Next;
+    postedEvent->Subject->UnRegister(nullptr);
+    delete postedEvent;
+    postedEvent = next;
+    }
+
   // close the event log if needed
   if ( this->LogFile.is_open() )
     {
@@ -662,7 +688,17 @@ void vtkEventBroker::LogEvent ( vtkObservation *observation )
       {
       this->LogFile << " ";
       }
-    this->LogFile << " # " << observation->GetLastElapsedTime() << " seconds \n";
+    this->LogFile << " # " << observation->GetLastElapsedTime() << " seconds";
+    if ( observation->GetLastLatency() > 0.0 )
+      {
+      this->LogFile << ", queued " << observation->GetLastLatency() << " seconds";
+      }
+    if ( observation->GetCoalescedEventCount() > 0 )
+      {
+      this->LogFile << ", " << observation->GetInvocationCount() << " invocations for "
+                    << observation->GetInvocationCount() + observation->GetCoalescedEventCount() << " events";
+      }
+    this->LogFile << " \n";
 
     this->LogFile.flush();
     }
@@ -685,7 +721,8 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
       {
       this->InvokeObservation( observation, eid, callData );
       }
-    else if ( this->EventMode == vtkEventBroker::Asynchronous )
+    else if ( this->EventMode == vtkEventBroker::Asynchronous
+              || this->EventMode == vtkEventBroker::Coalescing )
       {
       this->QueueObservation( observation, eid, callData );
       }
@@ -749,9 +786,31 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
   // it it's not there, add the current call data to the list so that each unique combination
   // can be invoked.
   // If the event is not currently in the queue, add it and keep a flag.
+  // In coalescing mode, only the most recent call data of each event is kept,
+  // whatever the CompressCallData mode is.
   //
   vtkObservation::CallType call(eid, callData);
-  if ( this->GetCompressCallData() &&
+  if ( this->EventMode == vtkEventBroker::Coalescing )
+    {
+    std::deque< vtkObservation::CallType >::iterator dataIter;
+    for(dataIter=observation->GetCallDataList()->begin();dataIter != observation->GetCallDataList()->end(); dataIter++)
+      {
+      if ( call.EventID == dataIter->EventID )
+        {
+        break;
+        }
+      }
+    if ( dataIter == observation->GetCallDataList()->end() )
+      {
+      observation->GetCallDataList()->push_back( call );
+      }
+    else
+      {
+      dataIter->CallData = callData;
+      observation->SetCoalescedEventCount( observation->GetCoalescedEventCount() + 1 );
+      }
+    }
+  else if ( this->GetCompressCallData() &&
        observation->GetEvent() != vtkCommand::AnyEvent)
     {
     observation->GetCallDataList()->clear();
@@ -776,8 +835,14 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
 
   if ( !observation->GetInEventQueue() )
     {
+    bool wasEmpty = this->EventQueue.empty();
     this->EventQueue.push_back( observation );
     observation->SetInEventQueue(1);
+    observation->SetQueuedTime( this->TimerLog->GetUniversalTime() );
+    if ( wasEmpty )
+      {
+      this->InvokeEvent( vtkEventBroker::EventQueuedEvent );
+      }
     }
 }
 
@@ -803,6 +868,7 @@ vtkObservation *vtkEventBroker::DequeueObservation ()
   vtkObservation *observation = this->EventQueue.front();
   this->EventQueue.pop_front();
   observation->SetInEventQueue(0);
+  observation->SetQueuedTime(0.0);
   return( observation );
 }
 
@@ -817,6 +883,19 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
   // Register so observation won't be deleted while callback is running
   observation->Register(this);
 
+  // Time spent in the event queue
+  // - counted once per dequeued observation: the queued time is reset so
+  //   that the other call data of a coalesced observation do not add it again
+  double latency = 0.0;
+  if ( observation->GetInEventQueue() && observation->GetQueuedTime() > 0.0 )
+    {
+    latency = startTime - observation->GetQueuedTime();
+    observation->SetQueuedTime(0.0);
+    }
+  observation->SetLastLatency (latency);
+  observation->SetTotalLatency (observation->GetTotalLatency() + latency);
+  observation->SetInvocationCount (observation->GetInvocationCount() + 1);
+
   // Invoke the observation
   // - run script if available, otherwise run callback command
   //  -- pass back the client data to the script handler (for
@@ -882,6 +961,153 @@ void vtkEventBroker::ProcessEventQueue ()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::PostEvent ( vtkObject *subject, unsigned long event, void *callData )
+{
+  if ( subject == nullptr )
+    {
+    return;
+    }
+  // Reference counting is atomic, the subject is released in the main thread
+  subject->Register(nullptr);
+
+  PostedEvent *postedEvent = new PostedEvent;
+  postedEvent->Subject = subject;
+  postedEvent->Event = event;
+  postedEvent->CallData = callData;
+  // postedEvent must not be accessed once it is published, it may be
+  // processed and deleted by the main thread right away.
+  PostedEvent *head = this->PostedEvents.load(std::memory_order_relaxed);
+  do
+    {
+    postedEvent->Next = head;
+    }
+  while ( !this->PostedEvents.compare_exchange_weak(
+            head, postedEvent, std::memory_order_release, std::memory_order_relaxed) );
+
+  if ( head == nullptr )
+    {
+    // The callback is called with the lock held so that it cannot be
+    // reset (and its client data deleted) while it is running.
+    std::lock_guard<std::mutex> lock(this->PostedEventCallbackMutex);
+    if ( this->PostedEventCallback )
+      {
+      (*(this->PostedEventCallback)) ( this->PostedEventCallbackClientData );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::SetPostedEventCallback ( void (*postedEventCallback) (void *clientData), void *clientData )
+{
+  std::lock_guard<std::mutex> lock(this->PostedEventCallbackMutex);
+  this->PostedEventCallback = postedEventCallback;
+  this->PostedEventCallbackClientData = clientData;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::ProcessPostedEvents ()
+{
+  PostedEvent *postedEvent = this->PostedEvents.exchange(nullptr, std::memory_order_acquire);
+
+  // reverse the list to invoke the events in posting order
+  PostedEvent *orderedEvents = nullptr;
+  while ( postedEvent )
+    {
+    PostedEvent *next = postedEvent->Next;
+    postedEvent->Next = orderedEvents;
+    orderedEvents = postedEvent;
+    postedEvent = next;
+    }
+
+  int numberOfEvents = 0;
+  while ( orderedEvents )
+    {
+    postedEvent = orderedEvents;
+    orderedEvents = postedEvent->Next;
+    if ( postedEvent->Event == vtkCommand::ModifiedEvent )
+      {
+      postedEvent->Subject->Modified();
+      }
+    else
+      {
+      postedEvent->Subject->InvokeEvent( postedEvent->Event, postedEvent->CallData );
+      }
+    postedEvent->Subject->UnRegister(nullptr);
+    delete postedEvent;
+    ++numberOfEvents;
+    }
+  return numberOfEvents;
+}
+
+//----------------------------------------------------------------------------
+bool vtkEventBroker::GetPostedEventsPending ()
+{
+  return this->PostedEvents.load(std::memory_order_acquire) != nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintObservationStatistics (ostream& os)
+{
+  char eventString[BUFSIZ];
+  ObjectToObservationVectorMap::iterator iter;
+  for(iter=this->SubjectMap.begin(); iter != this->SubjectMap.end(); iter++)
+    {
+    ObservationVector::iterator obsIter;
+    for(obsIter=iter->second.begin(); obsIter != iter->second.end(); obsIter++)
+      {
+      vtkObservation *observation = *obsIter;
+      if ( observation->GetInvocationCount() == 0 )
+        {
+        continue;
+        }
+
+      const char *eventStringPointer = vtkCommand::GetStringFromEventId( observation->GetEvent() );
+      if ( !strcmp (eventStringPointer, "NoEvent") )
+        {
+        sprintf (eventString, "%ld", observation->GetEvent());
+        eventStringPointer = eventString;
+        }
+      const char *observerString = "No observer class";
+      if ( observation->GetScript() != nullptr )
+        {
+        observerString = observation->GetScript();
+        }
+      else if ( observation->GetObserver() )
+        {
+        observerString = observation->GetObserver()->GetClassName();
+        }
+
+      os << observation->GetSubject()->GetClassName()
+         << " -> " << observerString
+         << " [" << eventStringPointer << "]: "
+         << observation->GetInvocationCount() << " invocations, "
+         << observation->GetCoalescedEventCount() << " coalesced events, "
+         << observation->GetTotalElapsedTime() << " seconds, "
+         << observation->GetTotalLatency() << " seconds queued\n";
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetObservationStatistics ()
+{
+  ObjectToObservationVectorMap::iterator iter;
+  for(iter=this->SubjectMap.begin(); iter != this->SubjectMap.end(); iter++)
+    {
+    ObservationVector::iterator obsIter;
+    for(obsIter=iter->second.begin(); obsIter != iter->second.end(); obsIter++)
+      {
+      (*obsIter)->SetInvocationCount(0);
+      (*obsIter)->SetCoalescedEventCount(0);
+      (*obsIter)->SetLastElapsedTime(0.0);
+      (*obsIter)->SetTotalElapsedTime(0.0);
+      (*obsIter)->SetLastLatency(0.0);
+      (*obsIter)->SetTotalLatency(0.0);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -891,6 +1117,7 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "NumberOfQueueObservations: " << this->GetNumberOfQueuedObservations() << "\n";
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
+  os << indent << "PostedEventsPending: " << this->GetPostedEventsPending() << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
@@ -19,14 +19,17 @@
 #include "vtkMRML.h"
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkObject.h>
 class vtkTimerLog;
 
 // STD includes
+#include <atomic>
 #include <deque>
 #include <vector>
 #include <set>
 #include <map>
+#include <mutex>
 #include <fstream>
 
 class vtkCollection;
@@ -179,9 +182,23 @@ public:
   /// In synchronous mode, observations are invoked immediately when the
   /// event takes place.  In asynchronous mode, observations are added
   /// to the event queue for later invocation.
+  /// Coalescing mode is the same as asynchronous mode except that all the
+  /// occurrences of the same event of a subject are merged into one single
+  /// invocation (with the most recent call data) when the queue is processed.
+  /// The queue is processed when ProcessEventQueue() is called (typically at
+  /// the end of a batch of changes or from an idle callback scheduled when
+  /// EventQueuedEvent is invoked) or when the event mode is changed.
   enum EventMode {
     Synchronous,
-    Asynchronous
+    Asynchronous,
+    Coalescing
+  };
+
+  enum
+  {
+    /// Invoked by the broker when an observation is added to the empty event
+    /// queue. Observe it to schedule the processing of the queue (e.g. on idle).
+    EventQueuedEvent = vtkCommand::UserEvent + 1
   };
   vtkGetMacro(EventMode, int);
   void SetEventMode(int eventMode)
@@ -196,9 +213,11 @@ public:
 
   void SetEventModeToSynchronous() {this->SetEventMode(vtkEventBroker::Synchronous);};
   void SetEventModeToAsynchronous() {this->SetEventMode(vtkEventBroker::Asynchronous);};
+  void SetEventModeToCoalescing() {this->SetEventMode(vtkEventBroker::Coalescing);};
   const char * GetEventModeAsString() {
     if (this->EventMode == vtkEventBroker::Synchronous) return ("Synchronous");
     if (this->EventMode == vtkEventBroker::Asynchronous) return ("Asynchronous");
+    if (this->EventMode == vtkEventBroker::Coalescing) return ("Coalescing");
     return "Undefined";
   }
 
@@ -222,6 +241,51 @@ public:
                           void *callData);
   void ProcessEventQueue ();
 
+  ///
+  /// Write the number of invocations, number of coalesced events, total
+  /// elapsed time and total latency (time spent in the event queue) of each
+  /// observation that has been invoked at least once.
+  /// When EventLogging is on, the latency and coalescing of each invocation are
+  /// also written to the event log.
+  void PrintObservationStatistics (ostream& os);
+
+  ///
+  /// Reset the invocation statistics of all observations.
+  void ResetObservationStatistics ();
+
+  /// Thread-safe event posting
+  ///
+  /// PostEvent can be called from any thread (e.g. a processing thread or a
+  /// CLI runner) to request an event to be invoked on a subject by the main
+  /// thread. Posted events are stored in a lock-free queue: posting threads
+  /// never wait for each other nor for the main thread.
+  /// Posted events are invoked, in the order they were posted, when the main
+  /// thread calls ProcessPostedEvents(). If the event is ModifiedEvent, the
+  /// Modified() method of the subject is called so that its modification time
+  /// is updated. The subject is registered until the event is invoked.
+  /// \sa ProcessPostedEvents(), SetPostedEventCallback()
+  void PostEvent (vtkObject *subject, unsigned long event, void *callData = nullptr);
+
+  ///
+  /// Invoke all the events posted so far, in posting order.
+  /// Must be called from the main thread. Returns the number of invoked events.
+  int ProcessPostedEvents ();
+
+  ///
+  /// Returns true if events have been posted and not processed yet.
+  /// Can be called from any thread.
+  bool GetPostedEventsPending ();
+
+  ///
+  /// Sets a function called when an event is posted while no other posted
+  /// event is pending. It is called from the posting thread and must only
+  /// schedule a call to ProcessPostedEvents() on the main thread (e.g. using
+  /// a queued Qt connection). The callback is not called anymore once
+  /// SetPostedEventCallback returns, it can be reset to nullptr at any time.
+  /// vtkSlicerApplicationLogic sets the callback when its processing threads
+  /// are created.
+  void SetPostedEventCallback ( void (*postedEventCallback) (void *clientData), void *clientData );
+
   ///
   /// two modes -
   ///  - CompressCallDataOn: only keep the most recent call data.  this means that if the
@@ -275,6 +339,15 @@ protected:
   /// The event queue of triggered but not-yet-invoked observations
   std::deque< vtkObservation * > EventQueue;
 
+  /// Events posted by PostEvent, most recently posted first (see vtkEventBroker.cxx)
+  struct PostedEvent;
+  std::atomic< PostedEvent * > PostedEvents;
+  /// Protects PostedEventCallback and PostedEventCallbackClientData, which
+  /// are read by the posting threads.
+  std::mutex PostedEventCallbackMutex;
+  void (*PostedEventCallback) (void* clientData);
+  void *PostedEventCallbackClientData;
+
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
 
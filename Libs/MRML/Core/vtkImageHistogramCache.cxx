@@ -0,0 +1,491 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkImageHistogramCache.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Below this number of samples the histogram is computed in the calling thread
+const vtkIdType MinimumNumberOfSamplesPerThread = 1 << 20;
+
+//----------------------------------------------------------------------------
+struct HistogramEntry
+{
+  vtkWeakPointer<vtkImageData> ImageData;
+  vtkMTimeType ImageMTime;
+  double ScalarRange[2];
+  double BinOrigin;
+  double BinSpacing;
+  /// Empty until a percentile is requested
+  std::vector<vtkIdType> Bins;
+  vtkIdType TotalCount;
+};
+
+//----------------------------------------------------------------------------
+struct HistogramThreadData
+{
+  vtkDataArray* Scalars;
+  vtkIdType NumberOfSamples;
+  vtkIdType SampleIncrement;
+  double BinOrigin;
+  double BinSpacing;
+  std::vector<std::vector<vtkIdType> > ThreadBins;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void AccumulateHistogram(const T* scalars, vtkIdType beginSample, vtkIdType endSample,
+                         const HistogramThreadData* data, std::vector<vtkIdType>& bins)
+{
+  const int lastBin = static_cast<int>(bins.size()) - 1;
+  const double binScale = 1.0 / data->BinSpacing;
+  const T* scalarPtr = scalars + beginSample * data->SampleIncrement;
+  for (vtkIdType sample = beginSample; sample < endSample; ++sample, scalarPtr += data->SampleIncrement)
+    {
+    double value = static_cast<double>(*scalarPtr);
+    if (!vtkMath::IsFinite(value))
+      {
+      continue;
+      }
+    // Clamp before the conversion, out of range values can't be converted to int
+    double bin = (value - data->BinOrigin) * binScale + 0.5;
+    ++bins[static_cast<int>(std::min(std::max(bin, 0.0), static_cast<double>(lastBin)))];
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Range of the finite values of the samples, [VTK_DOUBLE_MAX, VTK_DOUBLE_MIN]
+/// if there is none.
+template <class T>
+void ComputeFiniteRange(const T* scalars, const HistogramThreadData* data, double range[2])
+{
+  range[0] = VTK_DOUBLE_MAX;
+  range[1] = VTK_DOUBLE_MIN;
+  const T* scalarPtr = scalars;
+  for (vtkIdType sample = 0; sample < data->NumberOfSamples; ++sample, scalarPtr += data->SampleIncrement)
+    {
+    double value = static_cast<double>(*scalarPtr);
+    if (!vtkMath::IsFinite(value))
+      {
+      continue;
+      }
+    range[0] = std::min(range[0], value);
+    range[1] = std::max(range[1], value);
+    }
+}
+
+//----------------------------------------------------------------------------
+void AccumulateHistogram(const HistogramThreadData* data, int threadId, int numberOfThreads)
+{
+  vtkIdType beginSample = data->NumberOfSamples * threadId / numberOfThreads;
+  vtkIdType endSample = data->NumberOfSamples * (threadId + 1) / numberOfThreads;
+  std::vector<vtkIdType>& bins = const_cast<HistogramThreadData*>(data)->ThreadBins[threadId];
+  switch (data->Scalars->GetDataType())
+    {
+    vtkTemplateMacro(AccumulateHistogram(static_cast<const VTK_TT*>(data->Scalars->GetVoidPointer(0)),
+      beginSample, endSample, data, bins));
+    default:
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE AccumulateHistogramThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  HistogramThreadData* data = static_cast<HistogramThreadData*>(info->UserData);
+  AccumulateHistogram(data, info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+double ComputePercentile(const HistogramEntry& entry, double percentile)
+{
+  double targetCount = entry.TotalCount * std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+  vtkIdType count = 0;
+  for (size_t bin = 0; bin < entry.Bins.size(); ++bin)
+    {
+    count += entry.Bins[bin];
+    if (count > 0 && count >= targetCount)
+      {
+      double value = entry.BinOrigin + bin * entry.BinSpacing;
+      return std::min(std::max(value, entry.ScalarRange[0]), entry.ScalarRange[1]);
+      }
+    }
+  return entry.ScalarRange[1];
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageHistogramCache::vtkInternal
+{
+public:
+  /// Return the up-to-date entry of the image, nullptr if it has no scalars.
+  /// The histogram is computed only if computeHistogram is true.
+  /// Must be called with Mutex locked.
+  const HistogramEntry* GetEntry(vtkImageHistogramCache* self, vtkImageData* imageData, bool computeHistogram);
+
+  void ComputeHistogram(vtkImageHistogramCache* self, vtkDataArray* scalars, HistogramEntry& entry);
+
+  void RemoveExpiredEntries(size_t maximumNumberOfEntries);
+
+  /// Most recently used entry first
+  std::list<HistogramEntry> Entries;
+  std::mutex Mutex;
+};
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::vtkInternal::RemoveExpiredEntries(size_t maximumNumberOfEntries)
+{
+  for (std::list<HistogramEntry>::iterator entryIt = this->Entries.begin(); entryIt != this->Entries.end();)
+    {
+    if (entryIt->ImageData.GetPointer() == nullptr)
+      {
+      entryIt = this->Entries.erase(entryIt);
+      }
+    else
+      {
+      ++entryIt;
+      }
+    }
+  while (this->Entries.size() > maximumNumberOfEntries)
+    {
+    this->Entries.pop_back();
+    }
+}
+
+//----------------------------------------------------------------------------
+const HistogramEntry* vtkImageHistogramCache::vtkInternal::GetEntry(
+  vtkImageHistogramCache* self, vtkImageData* imageData, bool computeHistogram)
+{
+  vtkDataArray* scalars = (imageData && imageData->GetPointData()) ? imageData->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || scalars->GetNumberOfTuples() == 0)
+    {
+    return nullptr;
+    }
+
+  std::list<HistogramEntry>::iterator entryIt = this->Entries.begin();
+  for (; entryIt != this->Entries.end(); ++entryIt)
+    {
+    if (entryIt->ImageData.GetPointer() == imageData)
+      {
+      break;
+      }
+    }
+  if (entryIt == this->Entries.end())
+    {
+    this->Entries.push_front(HistogramEntry());
+    entryIt = this->Entries.begin();
+    entryIt->ImageData = imageData;
+    entryIt->ImageMTime = 0;
+    }
+  else if (entryIt != this->Entries.begin())
+    {
+    this->Entries.splice(this->Entries.begin(), this->Entries, entryIt);
+    }
+
+  // The image MTime includes the modification time of its scalars
+  if (entryIt->ImageMTime != imageData->GetMTime())
+    {
+    // The range of the array is cached by VTK
+    scalars->GetRange(entryIt->ScalarRange, 0);
+    entryIt->Bins.clear();
+    entryIt->TotalCount = 0;
+    entryIt->ImageMTime = imageData->GetMTime();
+    }
+  if (computeHistogram && entryIt->Bins.empty())
+    {
+    this->ComputeHistogram(self, scalars, *entryIt);
+    }
+
+  this->RemoveExpiredEntries(static_cast<size_t>(std::max(self->MaximumNumberOfEntries, 1)));
+  return &this->Entries.front();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::vtkInternal::ComputeHistogram(
+  vtkImageHistogramCache* self, vtkDataArray* scalars, HistogramEntry& entry)
+{
+  ++self->NumberOfHistogramComputations;
+
+  HistogramThreadData data;
+  data.Scalars = scalars;
+  vtkIdType numberOfTuples = scalars->GetNumberOfTuples();
+  vtkIdType maximumNumberOfSamples = std::max(self->MaximumNumberOfSamples, static_cast<vtkIdType>(1));
+  vtkIdType tupleIncrement = (numberOfTuples + maximumNumberOfSamples - 1) / maximumNumberOfSamples;
+  data.SampleIncrement = tupleIncrement * scalars->GetNumberOfComponents();
+  data.NumberOfSamples = (numberOfTuples + tupleIncrement - 1) / tupleIncrement;
+
+  // Infinite values are not counted, the bins span the finite values
+  double binRange[2] = { entry.ScalarRange[0], entry.ScalarRange[1] };
+  if (!vtkMath::IsFinite(binRange[0]) || !vtkMath::IsFinite(binRange[1]))
+    {
+    switch (scalars->GetDataType())
+      {
+      vtkTemplateMacro(ComputeFiniteRange(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+        &data, binRange));
+      default:
+        break;
+      }
+    if (binRange[0] > binRange[1])
+      {
+      binRange[0] = binRange[1] = 0.0;
+      }
+    }
+
+  // Use one bin per value for integer images that have a small range
+  double rangeWidth = binRange[1] - binRange[0];
+  int maximumNumberOfBins = std::max(self->MaximumNumberOfBins, 2);
+  int numberOfBins = maximumNumberOfBins;
+  entry.BinOrigin = binRange[0];
+  entry.BinSpacing = 1.0;
+  if (scalars->GetDataType() != VTK_FLOAT && scalars->GetDataType() != VTK_DOUBLE
+    && rangeWidth < maximumNumberOfBins)
+    {
+    numberOfBins = static_cast<int>(rangeWidth) + 1;
+    }
+  else if (rangeWidth > 0.0 && vtkMath::IsFinite(rangeWidth))
+    {
+    entry.BinSpacing = rangeWidth / (numberOfBins - 1);
+    }
+  else
+    {
+    numberOfBins = 1;
+    }
+  data.BinOrigin = entry.BinOrigin;
+  data.BinSpacing = entry.BinSpacing;
+
+  int numberOfThreads = static_cast<int>(std::min(
+    static_cast<vtkIdType>(vtkMultiThreader::GetGlobalDefaultNumberOfThreads()),
+    data.NumberOfSamples / MinimumNumberOfSamplesPerThread));
+  numberOfThreads = std::max(numberOfThreads, 1);
+  data.ThreadBins.resize(numberOfThreads, std::vector<vtkIdType>(numberOfBins, 0));
+  if (numberOfThreads > 1)
+    {
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(AccumulateHistogramThread, &data);
+    threader->SingleMethodExecute();
+    }
+  else
+    {
+    AccumulateHistogram(&data, 0, 1);
+    }
+
+  // Merge the histograms of all the threads
+  entry.Bins.swap(data.ThreadBins[0]);
+  for (int threadId = 1; threadId < numberOfThreads; ++threadId)
+    {
+    const std::vector<vtkIdType>& threadBins = data.ThreadBins[threadId];
+    for (int bin = 0; bin < numberOfBins; ++bin)
+      {
+      entry.Bins[bin] += threadBins[bin];
+      }
+    }
+  entry.TotalCount = 0;
+  for (int bin = 0; bin < numberOfBins; ++bin)
+    {
+    entry.TotalCount += entry.Bins[bin];
+    }
+}
+
+//----------------------------------------------------------------------------
+// The singleton.
+// This MUST be default initialized to zero by the compiler and is
+// therefore not initialized here.  The ClassInitialize and
+// ClassFinalize methods handle this instance.
+static vtkImageHistogramCache* vtkImageHistogramCacheInstance;
+
+//----------------------------------------------------------------------------
+// Must NOT be initialized.  Default initialization to zero is necessary.
+unsigned int vtkImageHistogramCacheInitialize::Count;
+
+//----------------------------------------------------------------------------
+vtkImageHistogramCacheInitialize::vtkImageHistogramCacheInitialize()
+{
+  if(++Self::Count == 1)
+    {
+    vtkImageHistogramCache::classInitialize();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkImageHistogramCacheInitialize::~vtkImageHistogramCacheInitialize()
+{
+  if(--Self::Count == 0)
+    {
+    vtkImageHistogramCache::classFinalize();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Up the reference count so it behaves like New
+vtkImageHistogramCache* vtkImageHistogramCache::New()
+{
+  vtkImageHistogramCache* ret = vtkImageHistogramCache::GetInstance();
+  ret->Register(nullptr);
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// Return the single instance of the vtkImageHistogramCache
+vtkImageHistogramCache* vtkImageHistogramCache::GetInstance()
+{
+  if(!vtkImageHistogramCacheInstance)
+    {
+    // Try the factory first
+    vtkImageHistogramCacheInstance = (vtkImageHistogramCache*)vtkObjectFactory::CreateInstance("vtkImageHistogramCache");
+    // if the factory did not provide one, then create it here
+    if(!vtkImageHistogramCacheInstance)
+      {
+      vtkImageHistogramCacheInstance = new vtkImageHistogramCache;
+#ifdef VTK_HAS_INITIALIZE_OBJECT_BASE
+      vtkImageHistogramCacheInstance->InitializeObjectBase();
+#endif
+      }
+    }
+  // return the instance
+  return vtkImageHistogramCacheInstance;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::classInitialize()
+{
+  // Allocate the singleton
+  vtkImageHistogramCacheInstance = vtkImageHistogramCache::GetInstance();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::classFinalize()
+{
+  vtkImageHistogramCacheInstance->Delete();
+  vtkImageHistogramCacheInstance = nullptr;
+}
+
+//----------------------------------------------------------------------------
+vtkImageHistogramCache::vtkImageHistogramCache()
+{
+  this->MaximumNumberOfSamples = 1 << 24;
+  this->MaximumNumberOfBins = 65536;
+  this->MaximumNumberOfEntries = 32;
+  this->NumberOfHistogramComputations = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkImageHistogramCache::~vtkImageHistogramCache()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MaximumNumberOfSamples: " << this->MaximumNumberOfSamples << "\n";
+  os << indent << "MaximumNumberOfBins: " << this->MaximumNumberOfBins << "\n";
+  os << indent << "MaximumNumberOfEntries: " << this->MaximumNumberOfEntries << "\n";
+  os << indent << "NumberOfEntries: " << this->GetNumberOfEntries() << "\n";
+  os << indent << "NumberOfHistogramComputations: " << this->NumberOfHistogramComputations << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageHistogramCache::GetAutoRange(vtkImageData* imageData,
+  double lowerPercentile, double upperPercentile, double range[2])
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  const HistogramEntry* entry = this->Internal->GetEntry(this, imageData, true);
+  if (!entry || entry->TotalCount == 0)
+    {
+    return false;
+    }
+  range[0] = ComputePercentile(*entry, lowerPercentile);
+  range[1] = ComputePercentile(*entry, upperPercentile);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageHistogramCache::GetPercentile(vtkImageData* imageData, double percentile, double& value)
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  const HistogramEntry* entry = this->Internal->GetEntry(this, imageData, true);
+  if (!entry || entry->TotalCount == 0)
+    {
+    return false;
+    }
+  value = ComputePercentile(*entry, percentile);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageHistogramCache::GetScalarRange(vtkImageData* imageData, double range[2])
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  const HistogramEntry* entry = this->Internal->GetEntry(this, imageData, false);
+  if (!entry)
+    {
+    return false;
+    }
+  range[0] = entry->ScalarRange[0];
+  range[1] = entry->ScalarRange[1];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::SetMaximumNumberOfEntries(int maximumNumberOfEntries)
+{
+  if (this->MaximumNumberOfEntries == maximumNumberOfEntries)
+    {
+    return;
+    }
+  this->MaximumNumberOfEntries = maximumNumberOfEntries;
+  {
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->RemoveExpiredEntries(static_cast<size_t>(std::max(maximumNumberOfEntries, 1)));
+  }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageHistogramCache::GetNumberOfEntries()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->RemoveExpiredEntries(static_cast<size_t>(std::max(this->MaximumNumberOfEntries, 1)));
+  return static_cast<int>(this->Internal->Entries.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkImageHistogramCache::RemoveAllEntries()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->Mutex);
+  this->Internal->Entries.clear();
+}
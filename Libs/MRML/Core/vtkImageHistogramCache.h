@@ -0,0 +1,142 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageHistogramCache_h
+#define __vtkImageHistogramCache_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkImageData;
+
+/// \brief Process-wide cache of image intensity histograms.
+///
+/// Computing the histogram of a large volume takes seconds, and it used to be
+/// computed again by each module that needed an intensity range (automatic
+/// window/level, volume rendering transfer functions, etc.) and whenever the
+/// displayed image changed (e.g. when browsing a 4D sequence).
+/// vtkImageHistogramCache keeps the histogram of the first scalar component
+/// of the most recently used images, and recomputes it only when the image is
+/// modified (MTime changed).
+///
+/// The histogram is computed with multiple threads. Images that have more
+/// than MaximumNumberOfSamples voxels are sampled at regular intervals, the
+/// resulting percentiles are approximate.
+///
+/// \code
+/// double range[2];
+/// vtkImageHistogramCache::GetInstance()->GetAutoRange(imageData, 0.1, 99.9, range);
+/// \endcode
+class VTK_MRML_EXPORT vtkImageHistogramCache : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkImageHistogramCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  ///
+  /// Return the singleton instance with no reference counting.
+  static vtkImageHistogramCache* GetInstance();
+
+  ///
+  /// This is a singleton pattern New. Clients that call this must call
+  /// Delete on the object.
+  static vtkImageHistogramCache* New();
+
+  ///
+  /// Get the intensity values at the lower and upper percentiles (in the
+  /// range [0, 100]) of the first scalar component of the image.
+  /// Returns false if the image has no scalars.
+  bool GetAutoRange(vtkImageData* imageData, double lowerPercentile, double upperPercentile, double range[2]);
+
+  ///
+  /// Get the intensity value at the percentile (in the range [0, 100]) of
+  /// the first scalar component of the image.
+  /// Returns false if the image has no scalars.
+  bool GetPercentile(vtkImageData* imageData, double percentile, double& value);
+
+  ///
+  /// Get the minimum and maximum of the first scalar component of the image.
+  /// Returns false if the image has no scalars.
+  bool GetScalarRange(vtkImageData* imageData, double range[2]);
+
+  ///
+  /// Maximum number of voxels used to compute the histogram. Larger images
+  /// are sampled. Default is 2^24 (16M voxels).
+  vtkSetMacro(MaximumNumberOfSamples, vtkIdType);
+  vtkGetMacro(MaximumNumberOfSamples, vtkIdType);
+
+  ///
+  /// Maximum number of histogram bins. Integer images that have a smaller
+  /// range use one bin per value. Default is 65536.
+  vtkSetMacro(MaximumNumberOfBins, int);
+  vtkGetMacro(MaximumNumberOfBins, int);
+
+  ///
+  /// Maximum number of images in the cache. The least recently used
+  /// histograms are removed first. Default is 32.
+  void SetMaximumNumberOfEntries(int maximumNumberOfEntries);
+  vtkGetMacro(MaximumNumberOfEntries, int);
+
+  ///
+  /// Number of images in the cache.
+  int GetNumberOfEntries();
+
+  ///
+  /// Remove all the histograms from the cache.
+  void RemoveAllEntries();
+
+  ///
+  /// Number of histograms that have been computed (not found in the cache).
+  vtkGetMacro(NumberOfHistogramComputations, int);
+
+protected:
+  vtkImageHistogramCache();
+  ~vtkImageHistogramCache() override;
+  vtkImageHistogramCache(const vtkImageHistogramCache&);
+  void operator=(const vtkImageHistogramCache&);
+
+  ///
+  /// Singleton management functions.
+  static void classInitialize();
+  static void classFinalize();
+
+  friend class vtkImageHistogramCacheInitialize;
+
+  vtkIdType MaximumNumberOfSamples;
+  int MaximumNumberOfBins;
+  int MaximumNumberOfEntries;
+  int NumberOfHistogramComputations;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+/// Utility class to make sure vtkImageHistogramCache is initialized before it is used.
+class VTK_MRML_EXPORT vtkImageHistogramCacheInitialize
+{
+public:
+  typedef vtkImageHistogramCacheInitialize Self;
+
+  vtkImageHistogramCacheInitialize();
+  ~vtkImageHistogramCacheInitialize();
+private:
+  static unsigned int Count;
+};
+
+/// This instance will show up in any translation unit that uses
+/// vtkImageHistogramCache. It will make sure vtkImageHistogramCache is
+/// initialized before it is used.
+static vtkImageHistogramCacheInitialize vtkImageHistogramCacheInitializer;
+
+#endif
@@ -0,0 +1,425 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkImageMapToWindowLevelThresholdColors.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataObject.h>
+#include <vtkExecutive.h>
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkScalarsToColors.h>
+#include <vtkTypeTraits.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageMapToWindowLevelThresholdColors);
+vtkCxxSetObjectMacro(vtkImageMapToWindowLevelThresholdColors, LookupTable, vtkScalarsToColors);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+inline unsigned char ClampToUnsignedChar(double value)
+{
+  if (value > 255.0)
+    {
+    return 255;
+    }
+  // false for NaN (zero window)
+  if (value >= 0.0)
+    {
+    return static_cast<unsigned char>(value);
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Map one input value to RGBA. Window/level and threshold are computed the
+// same way as vtkImageMapToWindowLevelColors and vtkImageThreshold, the
+// comparisons are done in the input scalar type.
+template <class T>
+class WindowLevelThresholdMapper
+{
+public:
+  WindowLevelThresholdMapper(vtkImageMapToWindowLevelThresholdColors* self, const unsigned char* colorTable)
+  {
+    this->ColorTable = colorTable;
+
+    double window = self->GetWindow();
+    double level = self->GetLevel();
+    this->Shift = window / 2.0 - level;
+    this->Scale = 255.0 / window;
+
+    const double typeMin = static_cast<double>(vtkTypeTraits<T>::Min());
+    const double typeMax = static_cast<double>(vtkTypeTraits<T>::Max());
+    double lower = level - fabs(window) / 2.0;
+    double upper = lower + fabs(window);
+    double adjustedLower = std::min(std::max(lower, typeMin), typeMax);
+    double adjustedUpper = std::min(std::max(upper, typeMin), typeMax);
+    this->Lower = static_cast<T>(adjustedLower);
+    this->Upper = static_cast<T>(adjustedUpper);
+    double lowerValue = 255.0 * (adjustedLower - lower) / window;
+    double upperValue = 255.0 * (adjustedUpper - lower) / window;
+    if (window < 0)
+      {
+      lowerValue += 255.0;
+      upperValue += 255.0;
+      }
+    this->LowerValue = ClampToUnsignedChar(lowerValue);
+    this->UpperValue = ClampToUnsignedChar(upperValue);
+
+    this->ApplyThreshold = (self->GetApplyThreshold() != 0);
+    this->LowerThreshold = static_cast<T>(std::min(std::max(self->GetLowerThreshold(), typeMin), typeMax));
+    this->UpperThreshold = static_cast<T>(std::min(std::max(self->GetUpperThreshold(), typeMin), typeMax));
+  }
+
+  inline void Map(T value, unsigned char* rgba) const
+  {
+    unsigned char luminance;
+    if (value <= this->Lower)
+      {
+      luminance = this->LowerValue;
+      }
+    else if (value >= this->Upper)
+      {
+      luminance = this->UpperValue;
+      }
+    else
+      {
+      luminance = static_cast<unsigned char>((value + this->Shift) * this->Scale);
+      }
+    const unsigned char* color = this->ColorTable + 4 * luminance;
+    rgba[0] = color[0];
+    rgba[1] = color[1];
+    rgba[2] = color[2];
+    bool visible = color[3] != 0
+      && (!this->ApplyThreshold || (this->LowerThreshold <= value && value <= this->UpperThreshold));
+    rgba[3] = visible ? 255 : 0;
+  }
+
+protected:
+  const unsigned char* ColorTable;
+  double Shift;
+  double Scale;
+  T Lower;
+  T Upper;
+  unsigned char LowerValue;
+  unsigned char UpperValue;
+  bool ApplyThreshold;
+  T LowerThreshold;
+  T UpperThreshold;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void BuildValueTable(vtkImageMapToWindowLevelThresholdColors* self, const unsigned char* colorTable,
+                     std::vector<unsigned char>& valueTable, T*)
+{
+  WindowLevelThresholdMapper<T> mapper(self, colorTable);
+  const int typeMin = static_cast<int>(vtkTypeTraits<T>::Min());
+  const int typeMax = static_cast<int>(vtkTypeTraits<T>::Max());
+  valueTable.resize(static_cast<size_t>(typeMax - typeMin + 1) * 4);
+  for (int value = typeMin; value <= typeMax; ++value)
+    {
+    mapper.Map(static_cast<T>(value), &valueTable[static_cast<size_t>(value - typeMin) * 4]);
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void MapToWindowLevelThresholdColors(vtkImageMapToWindowLevelThresholdColors* self,
+  const unsigned char* colorTable, const unsigned char* valueTable,
+  vtkImageData* inData, T* inPtr, vtkImageData* outData, unsigned char* outPtr,
+  int outExt[6], vtkImageStencilData* stencil)
+{
+  WindowLevelThresholdMapper<T> mapper(self, colorTable);
+  // value table is only built for 8 and 16 bit integer types
+  const int typeMin = valueTable ? static_cast<int>(vtkTypeTraits<T>::Min()) : 0;
+
+  int numberOfComponents = inData->GetNumberOfScalarComponents();
+  vtkIdType inIncX, inIncY, inIncZ;
+  inData->GetContinuousIncrements(outExt, inIncX, inIncY, inIncZ);
+  vtkIdType outIncX, outIncY, outIncZ;
+  outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+  int rowLength = outExt[1] - outExt[0] + 1;
+
+  for (int z = outExt[4]; z <= outExt[5]; ++z)
+    {
+    for (int y = outExt[2]; y <= outExt[3]; ++y)
+      {
+      unsigned char* rowPtr = outPtr;
+      if (valueTable)
+        {
+        for (int x = 0; x < rowLength; ++x)
+          {
+          const unsigned char* rgba = valueTable + static_cast<size_t>(static_cast<int>(*inPtr) - typeMin) * 4;
+          outPtr[0] = rgba[0];
+          outPtr[1] = rgba[1];
+          outPtr[2] = rgba[2];
+          outPtr[3] = rgba[3];
+          inPtr += numberOfComponents;
+          outPtr += 4;
+          }
+        }
+      else
+        {
+        for (int x = 0; x < rowLength; ++x)
+          {
+          mapper.Map(*inPtr, outPtr);
+          inPtr += numberOfComponents;
+          outPtr += 4;
+          }
+        }
+      if (stencil)
+        {
+        // Voxels between the stencil extents are transparent
+        int iter = 0;
+        int r1, r2;
+        int x = outExt[0];
+        bool moreExtents = true;
+        while (moreExtents)
+          {
+          moreExtents = (stencil->GetNextExtent(r1, r2, outExt[0], outExt[1], y, z, iter) != 0);
+          int transparentEnd = moreExtents ? r1 : outExt[1] + 1;
+          for (; x < transparentEnd; ++x)
+            {
+            rowPtr[4 * (x - outExt[0]) + 3] = 0;
+            }
+          if (moreExtents)
+            {
+            x = r2 + 1;
+            }
+          }
+        }
+      inPtr += inIncY;
+      outPtr += outIncY;
+      }
+    inPtr += inIncZ;
+    outPtr += outIncZ;
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageMapToWindowLevelThresholdColors::vtkImageMapToWindowLevelThresholdColors()
+{
+  this->SetNumberOfInputPorts(2);
+  this->Window = 255.0;
+  this->Level = 127.5;
+  this->ApplyThreshold = 0;
+  this->LowerThreshold = VTK_SHORT_MIN;
+  this->UpperThreshold = VTK_SHORT_MAX;
+  this->LookupTable = nullptr;
+  this->TablesScalarType = VTK_VOID;
+}
+
+//----------------------------------------------------------------------------
+vtkImageMapToWindowLevelThresholdColors::~vtkImageMapToWindowLevelThresholdColors()
+{
+  this->SetLookupTable(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Window: " << this->Window << "\n";
+  os << indent << "Level: " << this->Level << "\n";
+  os << indent << "ApplyThreshold: " << this->ApplyThreshold << "\n";
+  os << indent << "LowerThreshold: " << this->LowerThreshold << "\n";
+  os << indent << "UpperThreshold: " << this->UpperThreshold << "\n";
+  os << indent << "LookupTable: " << this->LookupTable << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::ThresholdBetween(double lower, double upper)
+{
+  if (this->LowerThreshold == lower && this->UpperThreshold == upper)
+    {
+    return;
+    }
+  this->LowerThreshold = lower;
+  this->UpperThreshold = upper;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::SetStencilConnection(vtkAlgorithmOutput* outputPort)
+{
+  this->SetInputConnection(1, outputPort);
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkImageMapToWindowLevelThresholdColors::GetStencilConnection()
+{
+  return this->GetNumberOfInputConnections(1) > 0 ? this->GetInputConnection(1, 0) : nullptr;
+}
+
+//----------------------------------------------------------------------------
+vtkImageStencilData* vtkImageMapToWindowLevelThresholdColors::GetStencil()
+{
+  if (this->GetNumberOfInputConnections(1) < 1)
+    {
+    return nullptr;
+    }
+  return vtkImageStencilData::SafeDownCast(this->GetExecutive()->GetInputData(1, 0));
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkImageMapToWindowLevelThresholdColors::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  if (this->LookupTable)
+    {
+    mTime = std::max(mTime, this->LookupTable->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColors::FillInputPortInformation(int port, vtkInformation* info)
+{
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageStencilData");
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
+  else
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColors::RequestInformation(vtkInformation* vtkNotUsed(request),
+                                                               vtkInformationVector** vtkNotUsed(inputVector),
+                                                               vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 4);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::UpdateTables(int inputScalarType)
+{
+  if (!this->ColorTable.empty()
+    && this->TablesScalarType == inputScalarType
+    && this->TablesBuildTime.GetMTime() > this->GetMTime())
+    {
+    return;
+    }
+
+  this->ColorTable.resize(256 * 4);
+  if (this->LookupTable)
+    {
+    unsigned char values[256];
+    for (int i = 0; i < 256; ++i)
+      {
+      values[i] = static_cast<unsigned char>(i);
+      }
+    this->LookupTable->Build();
+    this->LookupTable->MapScalarsThroughTable(values, &this->ColorTable[0], VTK_UNSIGNED_CHAR, 256, 1, VTK_RGBA);
+    }
+  else
+    {
+    for (int i = 0; i < 256; ++i)
+      {
+      this->ColorTable[4 * i] = this->ColorTable[4 * i + 1] = this->ColorTable[4 * i + 2] = static_cast<unsigned char>(i);
+      this->ColorTable[4 * i + 3] = 255;
+      }
+    }
+
+  switch (inputScalarType)
+    {
+    case VTK_CHAR:
+      BuildValueTable(this, &this->ColorTable[0], this->ValueTable, static_cast<char*>(nullptr));
+      break;
+    case VTK_SIGNED_CHAR:
+      BuildValueTable(this, &this->ColorTable[0], this->ValueTable, static_cast<signed char*>(nullptr));
+      break;
+    case VTK_UNSIGNED_CHAR:
+      BuildValueTable(this, &this->ColorTable[0], this->ValueTable, static_cast<unsigned char*>(nullptr));
+      break;
+    case VTK_SHORT:
+      BuildValueTable(this, &this->ColorTable[0], this->ValueTable, static_cast<short*>(nullptr));
+      break;
+    case VTK_UNSIGNED_SHORT:
+      BuildValueTable(this, &this->ColorTable[0], this->ValueTable, static_cast<unsigned short*>(nullptr));
+      break;
+    default:
+      // Computed for each voxel
+      this->ValueTable.clear();
+      break;
+    }
+
+  this->TablesScalarType = inputScalarType;
+  this->TablesBuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColors::RequestData(vtkInformation* request,
+                                                        vtkInformationVector** inputVector,
+                                                        vtkInformationVector* outputVector)
+{
+  // Tables are shared by all the threads, build them before splitting
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  if (input && input->GetPointData()->GetScalars())
+    {
+    this->UpdateTables(input->GetScalarType());
+    }
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::ThreadedRequestData(vtkInformation* vtkNotUsed(request),
+                                                                 vtkInformationVector** vtkNotUsed(inputVector),
+                                                                 vtkInformationVector* vtkNotUsed(outputVector),
+                                                                 vtkImageData*** inData,
+                                                                 vtkImageData** outData,
+                                                                 int outExt[6], int vtkNotUsed(id))
+{
+  vtkImageData* input = inData[0][0];
+  if (!input || !input->GetPointData()->GetScalars() || this->ColorTable.empty())
+    {
+    return;
+    }
+  if (input->GetScalarType() != this->TablesScalarType)
+    {
+    vtkErrorMacro("ThreadedRequestData: tables were not built for the input scalar type");
+    return;
+    }
+  void* inPtr = input->GetScalarPointerForExtent(outExt);
+  unsigned char* outPtr = static_cast<unsigned char*>(outData[0]->GetScalarPointerForExtent(outExt));
+  const unsigned char* valueTable = this->ValueTable.empty() ? nullptr : &this->ValueTable[0];
+  vtkImageStencilData* stencil = this->GetStencil();
+
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(MapToWindowLevelThresholdColors(this, &this->ColorTable[0], valueTable,
+      input, static_cast<VTK_TT*>(inPtr), outData[0], outPtr, outExt, stencil));
+    default:
+      vtkErrorMacro("ThreadedRequestData: unknown input scalar type");
+      return;
+    }
+}
@@ -0,0 +1,119 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageMapToWindowLevelThresholdColors_h
+#define __vtkImageMapToWindowLevelThresholdColors_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageStencilData;
+class vtkScalarsToColors;
+
+/// \brief Map a scalar image to an RGBA image in a single pass.
+///
+/// Computes the same output as the display pipeline of
+/// vtkMRMLScalarVolumeDisplayNode (vtkImageMapToWindowLevelColors,
+/// vtkImageMapToColors, vtkImageThreshold, vtkImageStencil, vtkImageLogic and
+/// vtkImageAppendComponents) without intermediate images:
+/// - the first component of the input is mapped to [0,255] using Window and
+///   Level, then to RGBA using the LookupTable (grayscale if none),
+/// - the alpha of the output is 255 if the lookup table alpha is not 0, the
+///   voxel is inside the threshold range (only if ApplyThreshold is on) and
+///   inside the optional stencil (input port 1), otherwise it is 0.
+///
+/// For 8 and 16 bit integer inputs all the parameters are combined into a
+/// single table indexed by the input value, which is rebuilt only when a
+/// parameter changes.
+class VTK_MRML_EXPORT vtkImageMapToWindowLevelThresholdColors : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageMapToWindowLevelThresholdColors *New();
+  vtkTypeMacro(vtkImageMapToWindowLevelThresholdColors, vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  vtkSetMacro(Window, double);
+  vtkGetMacro(Window, double);
+
+  vtkSetMacro(Level, double);
+  vtkGetMacro(Level, double);
+
+  /// Voxels outside [LowerThreshold, UpperThreshold] are transparent if
+  /// ApplyThreshold is on.
+  vtkSetMacro(ApplyThreshold, int);
+  vtkGetMacro(ApplyThreshold, int);
+  vtkBooleanMacro(ApplyThreshold, int);
+
+  void ThresholdBetween(double lower, double upper);
+  vtkGetMacro(LowerThreshold, double);
+  vtkGetMacro(UpperThreshold, double);
+
+  /// Lookup table applied on the window/level output ([0,255] range).
+  virtual void SetLookupTable(vtkScalarsToColors*);
+  vtkGetObjectMacro(LookupTable, vtkScalarsToColors);
+
+  /// Optional stencil, voxels outside of the stencil are transparent.
+  void SetStencilConnection(vtkAlgorithmOutput* outputPort);
+  vtkAlgorithmOutput* GetStencilConnection();
+  vtkImageStencilData* GetStencil();
+
+  /// The lookup table is part of the filter parameters.
+  vtkMTimeType GetMTime() override;
+
+  int RequestData(vtkInformation* request,
+                  vtkInformationVector** inputVector,
+                  vtkInformationVector* outputVector) override;
+
+protected:
+  vtkImageMapToWindowLevelThresholdColors();
+  ~vtkImageMapToWindowLevelThresholdColors() override;
+
+  int RequestInformation(vtkInformation* request,
+                         vtkInformationVector** inputVector,
+                         vtkInformationVector* outputVector) override;
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+
+  void ThreadedRequestData(vtkInformation* request,
+                           vtkInformationVector** inputVector,
+                           vtkInformationVector* outputVector,
+                           vtkImageData*** inData,
+                           vtkImageData** outData,
+                           int outExt[6], int id) override;
+
+  /// Update ColorTable and, for 8 and 16 bit inputs, ValueTable.
+  void UpdateTables(int inputScalarType);
+
+  double Window;
+  double Level;
+  int ApplyThreshold;
+  double LowerThreshold;
+  double UpperThreshold;
+  vtkScalarsToColors* LookupTable;
+
+  /// RGBA color of each window/level output value (256 entries).
+  std::vector<unsigned char> ColorTable;
+  /// RGBA output of each input value, for 8 and 16 bit integer inputs.
+  std::vector<unsigned char> ValueTable;
+  int TablesScalarType;
+  vtkTimeStamp TablesBuildTime;
+
+private:
+  vtkImageMapToWindowLevelThresholdColors(const vtkImageMapToWindowLevelThresholdColors&) = delete;
+  void operator=(const vtkImageMapToWindowLevelThresholdColors&) = delete;
+};
+
+#endif
@@ -186,6 +186,8 @@ protected:
   void SetInputToImageDataPipeline(vtkAlgorithmOutput *imageDataConnection) override;
 
   vtkAlgorithmOutput* GetScalarImageDataConnection() override;
+  /// The filter chain is modified, it can't be replaced by FusedDisplayFilter.
+  bool CanUseFusedDisplayFilter() override { return false; }
 
   static std::vector<int> GetSupportedColorModes();
 
@@ -84,6 +84,8 @@ protected:
   void SetInputToImageDataPipeline(vtkAlgorithmOutput *imageDataConnection) override;
 
   vtkAlgorithmOutput* GetScalarImageDataConnection() override;
+  /// The filter chain is modified, it can't be replaced by FusedDisplayFilter.
+  bool CanUseFusedDisplayFilter() override { return false; }
 
   /// This property holds the current diffusion component used for display.
   int DiffusionComponent;
@@ -43,6 +43,10 @@ public:
   /// Return true if reference node can be written from
   bool CanWriteFromReferenceNode(vtkMRMLNode *refNode) override;
 
+  /// Overlays are added to the existing mesh of the model node, which is
+  /// shared with the preloaded node: data cannot be read in a background thread
+  bool CanPreloadData(vtkMRMLNode* vtkNotUsed(refNode)) override { return false; }
+
 protected:
   vtkMRMLFreeSurferModelOverlayStorageNode();
   ~vtkMRMLFreeSurferModelOverlayStorageNode() override;
@@ -30,6 +30,7 @@
 #include <vtkPolyDataMapper.h>
 #include <vtkPLYReader.h>
 #include <vtkPLYWriter.h>
+#include <vtkPointSet.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkProperty.h>
@@ -119,6 +120,67 @@ bool vtkMRMLModelStorageNode::CanReadInReferenceNode(vtkMRMLNode *refNode)
   return refNode->IsA("vtkMRMLModelNode");
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLModelStorageNode::CanPreloadData(vtkMRMLNode* refNode)
+{
+  return this->CanReadInReferenceNode(refNode);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                                       vtkDataObject* preloadedData)
+{
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(refNode);
+  vtkMRMLModelNode* preloadedModelNode = vtkMRMLModelNode::SafeDownCast(preloadedNode);
+  if (!modelNode || !preloadedModelNode)
+    {
+    vtkErrorMacro("ReadPreloadedDataInternal: Reference node is not a model node");
+    return 0;
+    }
+  modelNode->SetAndObserveMesh(vtkPointSet::SafeDownCast(preloadedData));
+  this->UpdateDisplayNodeScalarRange(modelNode);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::SetReaderOutputInModelNode(vtkMRMLModelNode* modelNode, vtkAlgorithm* reader)
+{
+  vtkDataObject* mesh = reader->GetOutputDataObject(0);
+  if (this->PreloadingData)
+    {
+    // set in the node by ReadPreloadedDataInternal() in the main thread
+    this->PreloadedData = vtkSmartPointer<vtkDataObject>::Take(mesh->NewInstance());
+    this->PreloadedData->ShallowCopy(mesh);
+    }
+  else if (vtkUnstructuredGrid::SafeDownCast(mesh))
+    {
+    modelNode->SetUnstructuredGridConnection(reader->GetOutputPort());
+    }
+  else
+    {
+    modelNode->SetPolyDataConnection(reader->GetOutputPort());
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLModelStorageNode::UpdateDisplayNodeScalarRange(vtkMRMLModelNode* modelNode)
+{
+  if (modelNode->GetMesh() != nullptr)
+    {
+    // is there an active scalar array?
+    if (modelNode->GetDisplayNode()
+      && modelNode->GetDisplayNode()->GetScalarRangeFlag() == vtkMRMLDisplayNode::UseDataScalarRange)
+      {
+      double *scalarRange = modelNode->GetMesh()->GetScalarRange();
+      if (scalarRange)
+        {
+        vtkDebugMacro("ReadDataInternal: setting scalar range " << scalarRange[0] << ", " << scalarRange[1]);
+        modelNode->GetDisplayNode()->SetScalarRange(scalarRange);
+        }
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -162,7 +224,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       vtkNew<vtkBYUReader> reader;
       reader->SetGeometryFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
       }
     else if (extension == std::string(".vtk"))
       {
@@ -181,7 +243,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
         reader->ReadAllColorScalarsOn();
         reader->ReadAllTCoordsOn();
         reader->ReadAllFieldsOn();
-        modelNode->SetPolyDataConnection(reader->GetOutputPort());
+        this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
         }
       else if (unstructuredGridReader->IsFileUnstructuredGrid())
         {
@@ -193,7 +255,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
         unstructuredGridReader->ReadAllTCoordsOn();
         unstructuredGridReader->ReadAllFieldsOn();
         unstructuredGridReader->Update();
-        modelNode->SetUnstructuredGridConnection(unstructuredGridReader->GetOutputPort());
+        this->SetReaderOutputInModelNode(modelNode, unstructuredGridReader.GetPointer());
         }
       else
         {
@@ -206,35 +268,35 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       vtkNew<vtkXMLPolyDataReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
       }
     else if (extension == std::string(".vtu"))
       {
       vtkNew<vtkXMLUnstructuredGridReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetUnstructuredGridConnection(reader->GetOutputPort());
+      this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
       }
     else if (extension == std::string(".stl"))
       {
       vtkNew<vtkSTLReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
       }
     else if (extension == std::string(".ply"))
       {
       vtkNew<vtkPLYReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
       }
     else if (extension == std::string(".obj"))
       {
       vtkNew<vtkOBJReader> reader;
       reader->SetFileName(fullName.c_str());
       reader->Update();
-      modelNode->SetPolyDataConnection(reader->GetOutputPort());
+      this->SetReaderOutputInModelNode(modelNode, reader.GetPointer());
       }
     else if (extension == std::string(".meta"))  // model in meta format
       {
@@ -294,7 +356,14 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
       vtkMesh->SetPolys(cells.GetPointer());
 
-      modelNode->SetAndObservePolyData(vtkMesh.GetPointer());
+      if (this->PreloadingData)
+        {
+        this->PreloadedData = vtkMesh.GetPointer();
+        }
+      else
+        {
+        modelNode->SetAndObservePolyData(vtkMesh.GetPointer());
+        }
       }
     else
       {
@@ -308,20 +377,7 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     result = 0;
     }
 
-  if (modelNode->GetMesh() != nullptr)
-    {
-    // is there an active scalar array?
-    if (modelNode->GetDisplayNode()
-      && modelNode->GetDisplayNode()->GetScalarRangeFlag() == vtkMRMLDisplayNode::UseDataScalarRange)
-      {
-      double *scalarRange = modelNode->GetMesh()->GetScalarRange();
-      if (scalarRange)
-        {
-        vtkDebugMacro("ReadDataInternal: setting scalar range " << scalarRange[0] << ", " << scalarRange[1]);
-        modelNode->GetDisplayNode()->SetScalarRange(scalarRange);
-        }
-      }
-    }
+  this->UpdateDisplayNodeScalarRange(modelNode);
 
   return result;
 }
@@ -19,6 +19,9 @@
 
 class vtkMRMLModelNode;
 
+// VTK includes
+class vtkAlgorithm;
+
 /// \brief MRML node for model storage on disk.
 ///
 /// Storage nodes has methods to read/write vtkPolyData to/from disk.
@@ -41,6 +44,9 @@ public:
   /// Return true if the reference node can be read in
   bool CanReadInReferenceNode(vtkMRMLNode *refNode) override;
 
+  /// Data can be read in a background thread
+  bool CanPreloadData(vtkMRMLNode* refNode) override;
+
 protected:
   vtkMRMLModelStorageNode();
   ~vtkMRMLModelStorageNode() override;
@@ -59,6 +65,19 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Set the preloaded mesh and update the scalar range of the display node,
+  /// which is not available in the preloaded node
+  int ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                vtkDataObject* preloadedData) override;
+
+  /// Set the mesh read by \a reader in the model node, or keep a copy of
+  /// it as preloaded data when reading from a background thread
+  void SetReaderOutputInModelNode(vtkMRMLModelNode* modelNode, vtkAlgorithm* reader);
+
+  /// Set the scalar range of the display node from the mesh if the display
+  /// node uses the data scalar range
+  void UpdateDisplayNodeScalarRange(vtkMRMLModelNode* modelNode);
+
   /// Write data from a  referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
@@ -27,6 +27,7 @@ Version:   $Revision: 1.6 $
 // VTK includes
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
@@ -122,6 +123,61 @@ bool vtkMRMLNRRDStorageNode::CanReadInReferenceNode(vtkMRMLNode *refNode)
          refNode->IsA("vtkMRMLDiffusionTensorVolumeNode");
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLNRRDStorageNode::CanPreloadData(vtkMRMLNode* refNode)
+{
+  return this->CanReadInReferenceNode(refNode);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLNRRDStorageNode::ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                                      vtkDataObject* preloadedData)
+{
+  vtkMRMLVolumeNode* volNode = vtkMRMLVolumeNode::SafeDownCast(refNode);
+  vtkMRMLVolumeNode* preloadedVolNode = vtkMRMLVolumeNode::SafeDownCast(preloadedNode);
+  if (!volNode || !preloadedVolNode)
+    {
+    vtkErrorMacro("ReadPreloadedDataInternal: Reference node is not a volume node");
+    return 0;
+    }
+  int wasModified = volNode->StartModify();
+  volNode->SetAndObserveImageData(vtkImageData::SafeDownCast(preloadedData));
+  volNode->CopyOrientation(preloadedVolNode);
+
+  vtkNew<vtkMatrix4x4> measurementFrame;
+  vtkMRMLTensorVolumeNode* tensorNode = vtkMRMLTensorVolumeNode::SafeDownCast(volNode);
+  vtkMRMLTensorVolumeNode* preloadedTensorNode = vtkMRMLTensorVolumeNode::SafeDownCast(preloadedVolNode);
+  if (tensorNode && preloadedTensorNode)
+    {
+    preloadedTensorNode->GetMeasurementFrameMatrix(measurementFrame.GetPointer());
+    tensorNode->SetMeasurementFrameMatrix(measurementFrame.GetPointer());
+    }
+  vtkMRMLDiffusionWeightedVolumeNode* dwiNode = vtkMRMLDiffusionWeightedVolumeNode::SafeDownCast(volNode);
+  vtkMRMLDiffusionWeightedVolumeNode* preloadedDwiNode = vtkMRMLDiffusionWeightedVolumeNode::SafeDownCast(preloadedVolNode);
+  if (dwiNode && preloadedDwiNode)
+    {
+    preloadedDwiNode->GetMeasurementFrameMatrix(measurementFrame.GetPointer());
+    dwiNode->SetMeasurementFrameMatrix(measurementFrame.GetPointer());
+    dwiNode->SetDiffusionGradients(preloadedDwiNode->GetDiffusionGradients());
+    dwiNode->SetBValues(preloadedDwiNode->GetBValues());
+    }
+
+  // The preloaded node was copied from the reference node, it has the same
+  // attributes except the ones that were read from the nrrd header.
+  std::vector<std::string> attributeNames = preloadedVolNode->GetAttributeNames();
+  for (std::vector<std::string>::iterator it = attributeNames.begin(); it != attributeNames.end(); ++it)
+    {
+    const char* value = preloadedVolNode->GetAttribute(it->c_str());
+    const char* currentValue = volNode->GetAttribute(it->c_str());
+    if (!currentValue || strcmp(value, currentValue) != 0)
+      {
+      volNode->SetAttribute(it->c_str(), value);
+      }
+    }
+  volNode->EndModify(wasModified);
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -167,7 +223,7 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     reader->SetUseNativeOriginOn();
     }
 
-  if (volNode->GetImageData())
+  if (volNode->GetImageData() && !this->PreloadingData)
     {
     volNode->SetAndObserveImageData (nullptr);
     }
@@ -299,7 +355,17 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   ici->SetOutputOrigin( 0, 0, 0 );
   ici->Update();
 
-  volNode->SetImageDataConnection(ici->GetOutputPort());
+  if (this->PreloadingData)
+    {
+    // set in the node by ReadPreloadedDataInternal() in the main thread
+    vtkNew<vtkImageData> iciOutputCopy;
+    iciOutputCopy->ShallowCopy(ici->GetOutput());
+    this->PreloadedData = iciOutputCopy.GetPointer();
+    }
+  else
+    {
+    volNode->SetImageDataConnection(ici->GetOutputPort());
+    }
   return 1;
 }
 
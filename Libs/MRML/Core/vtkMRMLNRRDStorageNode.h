@@ -60,6 +60,9 @@ class VTK_MRML_EXPORT vtkMRMLNRRDStorageNode : public vtkMRMLStorageNode
   /// Return true if the node can be read in.
   bool CanReadInReferenceNode(vtkMRMLNode *refNode) override;
 
+  /// Data can be read in a background thread
+  bool CanPreloadData(vtkMRMLNode* refNode) override;
+
   ///
   /// Configure the storage node for data exchange. This is an
   /// opportunity to optimize the storage node's settings, for
@@ -88,6 +91,11 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Set the image data, orientation, diffusion information and header
+  /// attributes of the preloaded node
+  int ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                vtkDataObject* preloadedData) override;
+
   /// Write data from a  referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
@@ -75,6 +75,14 @@ vtkMRMLNode::~vtkMRMLNode()
   this->NodeReferences.clear();
   this->NodeReferenceEvents.clear();
 
+  // The scene indexes referencing nodes by pointer. Remove this node from the
+  // index (e.g., node copies in the undo stack are never removed from the scene)
+  // so that a node allocated later at the same address is not mistaken for it.
+  if (this->Scene && !this->Scene->IsClosing())
+    {
+    this->Scene->RemoveNodeReferences(this);
+    }
+
   this->SetID(nullptr);
   this->SetName(nullptr);
   this->SetDescription(nullptr);
@@ -14,6 +14,8 @@ Version:   $Revision: 1.2 $
 
 // MRML includes
 #include "vtkEventBroker.h"
+#include "vtkImageHistogramCache.h"
+#include "vtkImageMapToWindowLevelThresholdColors.h"
 #include "vtkMRMLScalarVolumeDisplayNode.h"
 #include "vtkMRMLScene.h"
 #include "vtkMRMLProceduralColorNode.h"
@@ -27,7 +29,6 @@ Version:   $Revision: 1.2 $
 #include <vtkImageCast.h>
 #include <vtkImageData.h>
 #include <vtkImageExtractComponents.h>
-#include <vtkImageHistogramStatistics.h>
 #include <vtkImageLogic.h>
 #include <vtkImageMapToWindowLevelColors.h>
 #include <vtkImageStencil.h>
@@ -104,7 +105,12 @@ vtkMRMLScalarVolumeDisplayNode::vtkMRMLScalarVolumeDisplayNode()
   this->AppendComponents->AddInputConnection(0, this->ExtractRGB->GetOutputPort() );
   this->AppendComponents->AddInputConnection(0, this->AlphaLogic->GetOutputPort() );
 
-  this->HistogramStatistics = nullptr;
+  this->FusedDisplayFilter = vtkImageMapToWindowLevelThresholdColors::New();
+  this->FusedDisplayFilter->SetWindow(this->MapToWindowLevelColors->GetWindow());
+  this->FusedDisplayFilter->SetLevel(this->MapToWindowLevelColors->GetLevel());
+  this->FusedDisplayFilter->ThresholdBetween(VTK_SHORT_MIN, VTK_SHORT_MAX);
+  this->UseFusedDisplayFilter = true;
+
   this->IsInCalculateAutoLevels = false;
 
   vtkEventBroker::GetInstance()->AddObservation(
@@ -124,12 +130,7 @@ vtkMRMLScalarVolumeDisplayNode::~vtkMRMLScalarVolumeDisplayNode()
   this->ExtractRGB->Delete();
   this->ExtractAlpha->Delete();
   this->MultiplyAlpha->Delete();
-
-  if (this->HistogramStatistics)
-    {
-    this->HistogramStatistics->Delete();
-    this->HistogramStatistics = nullptr;
-    }
+  this->FusedDisplayFilter->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -171,6 +172,7 @@ void vtkMRMLScalarVolumeDisplayNode
 {
   this->Threshold->SetInputConnection(imageDataConnection);
   this->MapToWindowLevelColors->SetInputConnection(imageDataConnection);
+  this->FusedDisplayFilter->SetInputConnection(imageDataConnection);
 }
 
 //----------------------------------------------------------------------------
@@ -178,6 +180,7 @@ void vtkMRMLScalarVolumeDisplayNode
 ::SetBackgroundImageStencilDataConnection(vtkAlgorithmOutput *imageDataConnection)
 {
   this->MultiplyAlpha->SetStencilConnection(imageDataConnection);
+  this->FusedDisplayFilter->SetStencilConnection(imageDataConnection);
 }
 //----------------------------------------------------------------------------
 vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetBackgroundImageStencilDataConnection()
@@ -199,9 +202,30 @@ vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetInputImageDataConnection(
 //----------------------------------------------------------------------------
 vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetOutputImageDataConnection()
 {
+  if (this->UseFusedDisplayFilter && this->CanUseFusedDisplayFilter())
+    {
+    return this->FusedDisplayFilter->GetOutputPort();
+    }
   return this->AppendComponents->GetOutputPort();
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLScalarVolumeDisplayNode::CanUseFusedDisplayFilter()
+{
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLScalarVolumeDisplayNode::SetUseFusedDisplayFilter(bool use)
+{
+  if (this->UseFusedDisplayFilter == use)
+    {
+    return;
+    }
+  this->UseFusedDisplayFilter = use;
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLScalarVolumeDisplayNode::WriteXML(ostream& of, int nIndent)
 {
@@ -248,6 +272,7 @@ void vtkMRMLScalarVolumeDisplayNode::WriteXML(ostream& of, int nIndent)
   ss << this->AutoThreshold;
   of << " autoThreshold=\"" << ss.str() << "\"";
   }
+  of << " useFusedDisplayFilter=\"" << (this->UseFusedDisplayFilter ? "true" : "false") << "\"";
   if (this->WindowLevelPresets.size() > 0)
     {
     for (int p = 0; p < this->GetNumberOfWindowLevelPresets(); p++)
@@ -334,6 +359,10 @@ void vtkMRMLScalarVolumeDisplayNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->AutoThreshold;
       }
+    else if (!strcmp(attName, "useFusedDisplayFilter"))
+      {
+      this->SetUseFusedDisplayFilter(strcmp(attValue, "true") == 0);
+      }
     else if (!strncmp(attName, "windowLevelPreset", 17))
       {
       this->AddWindowLevelPresetFromString(attValue);
@@ -360,6 +389,7 @@ void vtkMRMLScalarVolumeDisplayNode::Copy(vtkMRMLNode *anode)
   this->SetApplyThreshold(node->GetApplyThreshold());
   this->SetThreshold(node->GetLowerThreshold(), node->GetUpperThreshold());
   this->SetInterpolate(node->Interpolate);
+  this->SetUseFusedDisplayFilter(node->GetUseFusedDisplayFilter());
   for (int p = 0; p < node->GetNumberOfWindowLevelPresets(); p++)
     {
     this->AddWindowLevelPreset(node->GetWindowPreset(p), node->GetLevelPreset(p));
@@ -389,6 +419,7 @@ void vtkMRMLScalarVolumeDisplayNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "UpperThreshold:    " << this->GetUpperThreshold() << "\n";
   os << indent << "LowerThreshold:    " << this->GetLowerThreshold() << "\n";
   os << indent << "Interpolate:       " << this->Interpolate << "\n";
+  os << indent << "UseFusedDisplayFilter: " << (this->UseFusedDisplayFilter ? "true" : "false") << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -434,6 +465,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetWindow(double window)
     }
 
   this->MapToWindowLevelColors->SetWindow(window);
+  this->FusedDisplayFilter->SetWindow(window);
   this->Modified();
 }
 
@@ -452,6 +484,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetLevel(double level)
     }
 
   this->MapToWindowLevelColors->SetLevel(level);
+  this->FusedDisplayFilter->SetLevel(level);
   this->Modified();
 }
 
@@ -466,6 +499,8 @@ void vtkMRMLScalarVolumeDisplayNode::SetWindowLevel(double window, double level)
 
   this->MapToWindowLevelColors->SetWindow(window);
   this->MapToWindowLevelColors->SetLevel(level);
+  this->FusedDisplayFilter->SetWindow(window);
+  this->FusedDisplayFilter->SetLevel(level);
   this->Modified();
 }
 
@@ -502,6 +537,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetApplyThreshold(int apply)
     }
   this->ApplyThreshold = apply;
   this->Threshold->SetOutValue(apply ? 0 : 255);
+  this->FusedDisplayFilter->SetApplyThreshold(apply);
   this->Modified();
 }
 
@@ -538,6 +574,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetThreshold(double lowerThreshold, double
     return;
     }
   this->Threshold->ThresholdBetween( lowerThreshold, upperThreshold );
+  this->FusedDisplayFilter->ThresholdBetween(lowerThreshold, upperThreshold);
   this->Modified();
 }
 
@@ -565,6 +602,7 @@ void vtkMRMLScalarVolumeDisplayNode::UpdateLookupTable(vtkMRMLColorNode* newColo
       }
     }
   this->MapToColors->SetLookupTable(lookupTable);
+  this->FusedDisplayFilter->SetLookupTable(lookupTable);
 }
 
 //---------------------------------------------------------------------------
@@ -730,32 +768,26 @@ void vtkMRMLScalarVolumeDisplayNode::CalculateAutoLevels()
     return;
     }
 
-  if (this->HistogramStatistics == nullptr)
-    {
-    this->HistogramStatistics = vtkImageHistogramStatistics::New();
-
-    // Set automatic window/level to include the entire intensity range
-    // (except top/bottom 0.1%, to not let a very thin tail of the intensity
-    // distribution to decrease the image contrast too much).
-    // While in CT and sometimes in MRI, there may be a large empty area
-    // outside the reconstructed image, which could be suppressed
-    // by a larger lower percentile value, it would make the method
-    // too specific to particular imaging modalities and could lead to
-    // suboptimal results for other types of images.
-    // Therefore, we choose small, symmetric percentile values here
-    // and maybe add modality-specific methods later (e.g., for CT
-    // images we could set lower value to -1000HU).
-    this->HistogramStatistics->SetAutoRangePercentiles(0.1, 99.9);
-
-    // Percentiles are very low (0.1%), so there is no need for
-    // range expansion.
-    this->HistogramStatistics->SetAutoRangeExpansionFactors(0.0, 0.0);
+  // Set automatic window/level to include the entire intensity range
+  // (except top/bottom 0.1%, to not let a very thin tail of the intensity
+  // distribution to decrease the image contrast too much).
+  // While in CT and sometimes in MRI, there may be a large empty area
+  // outside the reconstructed image, which could be suppressed
+  // by a larger lower percentile value, it would make the method
+  // too specific to particular imaging modalities and could lead to
+  // suboptimal results for other types of images.
+  // Therefore, we choose small, symmetric percentile values here
+  // and maybe add modality-specific methods later (e.g., for CT
+  // images we could set lower value to -1000HU).
+  // The histogram is cached, it is computed only once per image modification
+  // and shared with the other modules.
+  double intensityRange[2] = { 0.0, 0.0 };
+  if (!vtkImageHistogramCache::GetInstance()->GetAutoRange(imageDataScalar, 0.1, 99.9, intensityRange))
+    {
+    vtkDebugMacro("CalculateScalarAutoLevels: failed to compute the histogram of the input image");
+    return;
     }
-
   this->IsInCalculateAutoLevels = true;
-  this->HistogramStatistics->SetInputData(imageDataScalar);
-  this->HistogramStatistics->Update();
-  double* intensityRange = this->HistogramStatistics->GetAutoRange();
   vtkDebugMacro("CalculateScalarAutoLevels:"
                 << " lower: " << intensityRange[0] << " upper: " << intensityRange[1]);
 
@@ -21,10 +21,10 @@
 // VTK includes
 class vtkImageAlgorithm;
 class vtkImageAppendComponents;
-class vtkImageHistogramStatistics;
 class vtkImageCast;
 class vtkImageLogic;
 class vtkImageMapToColors;
+class vtkImageMapToWindowLevelThresholdColors;
 class vtkImageMapToWindowLevelColors;
 class vtkImageStencil;
 class vtkImageThreshold;
@@ -132,6 +132,18 @@ class VTK_MRML_EXPORT vtkMRMLScalarVolumeDisplayNode : public vtkMRMLVolumeDispl
   vtkSetMacro(Interpolate, int);
   vtkBooleanMacro(Interpolate, int);
 
+  ///
+  /// Compute the output with a single filter
+  /// (vtkImageMapToWindowLevelThresholdColors) instead of the chain of
+  /// window/level, color mapping, threshold, stencil and append components
+  /// filters. No intermediate image is allocated, which makes reslicing of
+  /// large volumes faster. Ignored by subclasses that modify the filter chain
+  /// (see CanUseFusedDisplayFilter()).
+  /// On by default.
+  vtkGetMacro(UseFusedDisplayFilter, bool);
+  virtual void SetUseFusedDisplayFilter(bool);
+  vtkBooleanMacro(UseFusedDisplayFilter, bool);
+
   void SetDefaultColorMap() override;
 
   ///
@@ -202,6 +214,11 @@ protected:
 
   void SetInputToImageDataPipeline(vtkAlgorithmOutput *imageDataConnection) override;
 
+  /// Returns true if the output of the filter chain can be computed by
+  /// FusedDisplayFilter. Subclasses that connect other filters to the chain
+  /// must return false.
+  virtual bool CanUseFusedDisplayFilter();
+
   ///
   /// To hold preset values for window and level, so can restore this display
   /// node's window and level to ones read from DICOM files, or defined by
@@ -235,13 +252,16 @@ protected:
   vtkImageExtractComponents *ExtractAlpha;
   vtkImageStencil *MultiplyAlpha;
 
+  /// Replaces the filters above if UseFusedDisplayFilter is on
+  vtkImageMapToWindowLevelThresholdColors *FusedDisplayFilter;
+  bool UseFusedDisplayFilter;
+
   ///
   /// window level presets
   std::vector<WindowLevelPreset> WindowLevelPresets;
 
   ///
   /// Used internally in CalculateScalarAutoLevels and CalculateStatisticsAutoLevels
-  vtkImageHistogramStatistics *HistogramStatistics;
   bool IsInCalculateAutoLevels;
 };
 
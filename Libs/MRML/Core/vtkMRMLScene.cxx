@@ -59,6 +59,8 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLSliceCompositeNode.h"
 #include "vtkMRMLSliceNode.h"
 #include "vtkMRMLSnapshotClipNode.h"
+#include "vtkMRMLStorableNode.h"
+#include "vtkMRMLStorageNode.h"
 #include "vtkMRMLSubjectHierarchyNode.h"
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableStorageNode.h"
@@ -87,8 +89,10 @@ Version:   $Revision: 1.18 $
 #include <vtkCollection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
 
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
@@ -96,14 +100,18 @@ Version:   $Revision: 1.18 $
 
 // STD includes
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
 #include <numeric>
+#include <thread>
+#include <unordered_set>
 
 //#define MRMLSCENE_VERBOSE
 
-#ifdef MRMLSCENE_VERBOSE
-# include <vtkTimerLog.h>
-#endif
-
 vtkCxxSetObjectMacro(vtkMRMLScene, CacheManager, vtkCacheManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, DataIOManager, vtkDataIOManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, UserTagTable, vtkTagTable)
@@ -113,6 +121,7 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NodesByClassMTime = 0;
 
   this->RegisteredNodeClasses.clear();
   this->UniqueIDs.clear();
@@ -120,6 +129,7 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->Nodes =  vtkCollection::New();
   this->MaximumNumberOfSavedUndoStates = 20;
+  this->MaximumUndoStackMemorySize = 0;
   this->UndoFlag = false;
 
   this->NodeReferences.clear();
@@ -138,6 +148,10 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->ReadDataOnLoad = 1;
 
+  this->NumberOfReadDataThreads = 1;
+  this->LastPreloadDataTime = 0.0;
+  this->LastPreloadDataSize = 0;
+
   this->LastLoadedVersion = nullptr;
   this->Version = nullptr;
   this->SetVersion(CURRENT_MRML_VERSION);
@@ -310,7 +324,8 @@ void vtkMRMLScene::Clear(int removeSingletons)
   this->StartState(vtkMRMLScene::CloseState);
 
   this->RemoveAllNodes(removeSingletons);
-  this->NodeReferences.clear();
+  this->ClearNodesByClass();
+  this->ClearNodeReferences();
   this->ReferencedIDChanges.clear();
   this->ResetNodes();
 
@@ -803,6 +818,13 @@ int vtkMRMLScene::Import()
 
     this->InvokeEvent(vtkMRMLScene::NewSceneEvent, nullptr);
 
+    // Read the files in background threads, the data is set in the nodes
+    // by UpdateScene()
+    if (this->NumberOfReadDataThreads > 1 && this->ReadDataOnLoad)
+      {
+      this->PreloadStorableNodesData(addedNodes);
+      }
+
     // Notify the imported nodes about that all nodes are created
     // (so the observers can be attached to referenced nodes, etc.)
     // by calling UpdateScene on each node
@@ -827,6 +849,18 @@ int vtkMRMLScene::Import()
         }
       }
 
+    // Release the preloaded data that has not been used
+    // (e.g. if a node was removed while updating the scene)
+    for (addedNodes->InitTraversal(it);
+         (node = (vtkMRMLNode*)addedNodes->GetNextItemAsObject(it)) ;)
+      {
+      vtkMRMLStorageNode* storageNode = vtkMRMLStorageNode::SafeDownCast(node);
+      if (storageNode)
+        {
+        storageNode->SetPreloadedNode(nullptr);
+        }
+      }
+
     this->Modified();
     this->RemoveUnusedNodeReferences();
 #ifdef MRMLSCENE_VERBOSE
@@ -1105,6 +1139,40 @@ inline bool IsNodeWithoutName(vtkMRMLNode* node)
   return node->GetName() == nullptr || node->GetName()[0] == '\0';
 }
 
+//------------------------------------------------------------------------------
+bool IDLess(const char* id1, const char* id2)
+{
+  return strcmp(id1, id2) < 0;
+}
+
+//------------------------------------------------------------------------------
+bool NodeIDLess(vtkMRMLNode* node1, vtkMRMLNode* node2)
+{
+  const char* id1 = node1 ? node1->GetID() : nullptr;
+  const char* id2 = node2 ? node2->GetID() : nullptr;
+  return IDLess(id1 ? id1 : "", id2 ? id2 : "");
+}
+
+//------------------------------------------------------------------------------
+bool NodeReferenceLess(const std::pair<const char*, const char*>& reference1,
+                       const std::pair<const char*, const char*>& reference2)
+{
+  int referencedIDCompare = strcmp(reference1.first, reference2.first);
+  if (referencedIDCompare != 0)
+    {
+    return referencedIDCompare < 0;
+    }
+  return IDLess(reference1.second, reference2.second);
+}
+
+//------------------------------------------------------------------------------
+bool NodeReferenceEqual(const std::pair<const char*, const char*>& reference1,
+                        const std::pair<const char*, const char*>& reference2)
+{
+  return strcmp(reference1.first, reference2.first) == 0
+    && strcmp(reference1.second, reference2.second) == 0;
+}
+
 }
 
 //------------------------------------------------------------------------------
@@ -1192,10 +1260,12 @@ vtkMRMLNode* vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
     n->SetName(this->GenerateUniqueName(n).c_str());
     }
   n->SetScene( this );
+  this->UpdateNodesByClass();
   this->Nodes->vtkCollection::AddItem((vtkObject *)n);
 
   // cache the node so the whole scene cache stays up-to date
   this->AddNodeID(n);
+  this->AddNodeToNodesByClass(n);
 
   // Keep the SH up-to-date
   if (vtkMRMLSubjectHierarchyNode::SafeDownCast(n) != nullptr &&
@@ -1324,7 +1394,7 @@ vtkMRMLNode* vtkMRMLScene::AddNewNodeByClassWithID(std::string className, std::s
     return nullptr;
     }
 
-  if (this->NodeIDs.find(nodeID) != this->NodeIDs.end())
+  if (this->NodeIDs.find(nodeID.c_str()) != this->NodeIDs.end())
     {
     vtkErrorMacro("AddNewNodeByClassWithID: node already exists with ID - " << nodeID);
     return NULL;
@@ -1409,7 +1479,9 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     {
     n->SetScene(nullptr);
     }
+  this->UpdateNodesByClass();
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
+  this->RemoveNodeFromNodesByClass(n);
 
   std::string nid = (n->GetID() ? n->GetID() : "");
   this->RemoveNodeID(n->GetID());
@@ -1423,17 +1495,23 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     // all the nodes that the deleted node referred to.
     this->RemoveNodeReferences(n);
     // Notify nodes that referred to the deleted node to update their references
-    NodeReferencesType::iterator referencedNodeIdIt=this->NodeReferences.find(nid);
+    NodeReferencesType::iterator referencedNodeIdIt=this->NodeReferences.find(nid.c_str());
     if (referencedNodeIdIt!=this->NodeReferences.end())
       {
       // make a copy of the referring node list, as the list may change as a result of UpdateReferences calls
-      std::set<std::string> referringNodes=referencedNodeIdIt->second;
-      for (NodeReferencesType::value_type::second_type::iterator referringNodesIt = referringNodes.begin();
+      std::vector< vtkWeakPointer<vtkMRMLNode> > referringNodes;
+      for (ReferencingNodesType::iterator referringNodesIt = referencedNodeIdIt->second.begin();
+        referringNodesIt != referencedNodeIdIt->second.end();
+        ++referringNodesIt)
+        {
+        referringNodes.push_back(referringNodesIt->second);
+        }
+      for (std::vector< vtkWeakPointer<vtkMRMLNode> >::iterator referringNodesIt = referringNodes.begin();
         referringNodesIt != referringNodes.end();
         ++referringNodesIt)
         {
-        vtkMRMLNode* node=this->GetNodeByID(*referringNodesIt);
-        if (node)
+        vtkMRMLNode* node = *referringNodesIt;
+        if (this->IsNodeInScene(node))
           {
           node->UpdateReferences();
           }
@@ -1462,12 +1540,7 @@ void vtkMRMLScene::RemoveReferencedNodeID(const char *id, vtkMRMLNode *referenci
     // no referrers to id
     return;
     }
-  if (referencingNode->GetID()==nullptr)
-    {
-    // invalid referencing node id
-    return;
-    }
-  referenceIt->second.erase(referencingNode->GetID());
+  referenceIt->second.erase(referencingNode);
 }
 
 //------------------------------------------------------------------------------
@@ -1483,19 +1556,13 @@ void vtkMRMLScene::RemoveNodeReferences(vtkMRMLNode *n)
     // can happen when adding singleton nodes that are not really added but copied
     return;
     }
-  std::string nid=n->GetID();
 
-  NodeReferencesType::value_type::second_type::iterator referringNodesIt;
   for (NodeReferencesType::iterator referenceIt = this->NodeReferences.begin();
     referenceIt != this->NodeReferences.end();
     ++referenceIt)
     {
-    referringNodesIt=referenceIt->second.find(nid);
-    if (referringNodesIt!=referenceIt->second.end())
-      {
-      // observation has been deleted, so remove it from the index
-      referenceIt->second.erase(referringNodesIt);
-      }
+    // observation has been deleted, so remove it from the index
+    referenceIt->second.erase(n);
     }
 }
 
@@ -1507,18 +1574,14 @@ void vtkMRMLScene::RemoveUnusedNodeReferences()
     referenceIt != this->NodeReferences.end();
     ++referenceIt)
     {
-    for (NodeReferencesType::value_type::second_type::iterator referringNodesIt = referenceIt->second.begin();
+    for (ReferencingNodesType::iterator referringNodesIt = referenceIt->second.begin();
       referringNodesIt != referenceIt->second.end();
       /*upon deletion the increment is done already, so don't increment here*/)
       {
-      vtkMRMLNode *currentReferencingNodePtr=this->GetNodeByID(*referringNodesIt);
-      if (currentReferencingNodePtr==nullptr)
+      if (!this->IsNodeInScene(referringNodesIt->second))
         {
-        // ### Slicer 4.4: Simplify this logic when adding support for C++11 across all supported platform/compilers
-        // the node is not in the scene (or in the scene but with a different pointer), remove it
-        NodeReferencesType::value_type::second_type::iterator referringNodesItToRemove = referringNodesIt;
-        ++referringNodesIt;
-        referenceIt->second.erase(referringNodesItToRemove);
+        // the node is deleted or not in the scene (or in the scene but with a different pointer), remove it
+        referringNodesIt = referenceIt->second.erase(referringNodesIt);
         continue;
         }
       ++referringNodesIt;
@@ -1533,11 +1596,10 @@ void vtkMRMLScene::RemoveUnusedNodeReferences()
     vtkMRMLNode *node = this->GetNodeByID(referenceIt->first);
     if (node==nullptr || referenceIt->second.empty())
       {
-      // ### Slicer 4.4: Simplify this logic when adding support for C++11 across all supported platform/compilers
       // the referenced ID is no longer in the scene (or no more references), so remove all related references
-      NodeReferencesType::iterator referenceItToBeRemoved = referenceIt;
-      ++referenceIt;
-      this->NodeReferences.erase(referenceItToBeRemoved);
+      const char* referencedID = referenceIt->first;
+      referenceIt = this->NodeReferences.erase(referenceIt);
+      this->ReleaseInternedID(referencedID);
       continue;
       }
     // go to next referenced ID
@@ -1545,6 +1607,152 @@ void vtkMRMLScene::RemoveUnusedNodeReferences()
     }
 }
 
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PreloadStorableNodesData(vtkCollection* nodes)
+{
+  this->LastPreloadDataTime = 0.0;
+  this->LastPreloadDataSize = 0;
+
+  // Copies of the storable and storage nodes that are not in the scene,
+  // data is read into them in the background threads.
+  struct PreloadRequest
+    {
+    vtkMRMLStorageNode* StorageNode;
+    vtkSmartPointer<vtkMRMLNode> DetachedNode;
+    vtkSmartPointer<vtkMRMLStorageNode> DetachedStorageNode;
+    vtkTypeInt64 FileSize;
+    bool Success;
+    };
+  std::vector<PreloadRequest> requests;
+
+  vtkMRMLNode* node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (nodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+    if (!storableNode || !storableNode->GetAddToScene()
+      || storableNode->GetNumberOfStorageNodes() != 1)
+      {
+      continue;
+      }
+    vtkMRMLStorageNode* storageNode = storableNode->GetStorageNode();
+    // remote files are downloaded by the cache manager of the scene
+    if (!storageNode || !storageNode->GetFileName()
+      || (storageNode->GetURI() && strlen(storageNode->GetURI()) > 0)
+      || !storageNode->CanPreloadData(storableNode))
+      {
+      continue;
+      }
+    PreloadRequest request;
+    request.StorageNode = storageNode;
+    request.DetachedNode = vtkSmartPointer<vtkMRMLNode>::Take(storableNode->CreateNodeInstance());
+    request.DetachedNode->Copy(storableNode);
+    request.DetachedStorageNode = vtkSmartPointer<vtkMRMLStorageNode>::Take(
+      vtkMRMLStorageNode::SafeDownCast(storageNode->CreateNodeInstance()));
+    request.DetachedStorageNode->Copy(storageNode);
+    // same ID so that the storage node reference of the detached node is not
+    // changed when the data is read
+    static_cast<vtkMRMLNode*>(request.DetachedStorageNode)->SetID(storageNode->GetID());
+    // relative file names can only be resolved in the scene
+    std::string fullName = storageNode->GetFullNameFromFileName();
+    request.DetachedStorageNode->SetFileName(fullName.c_str());
+    request.FileSize = static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(fullName));
+    request.DetachedStorageNode->ResetFileNameList();
+    for (int i = 0; i < storageNode->GetNumberOfFileNames(); ++i)
+      {
+      std::string nthFullName = storageNode->GetFullNameFromNthFileName(i);
+      request.DetachedStorageNode->AddFileName(nthFullName.c_str());
+      if (nthFullName != fullName)
+        {
+        request.FileSize += static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(nthFullName));
+        }
+      }
+    request.Success = false;
+    requests.push_back(request);
+    }
+  if (requests.size() < 2)
+    {
+    // nothing to gain
+    return;
+    }
+
+  double startTime = vtkTimerLog::GetUniversalTime();
+  std::atomic<size_t> nextRequest(0);
+  std::mutex mutex;
+  std::condition_variable requestDone;
+  size_t numberOfDoneRequests = 0;
+  auto readData = [&]()
+    {
+    for (size_t i = nextRequest++; i < requests.size(); i = nextRequest++)
+      {
+      PreloadRequest& request = requests[i];
+      try
+        {
+        request.Success = (request.DetachedStorageNode->PreloadData(request.DetachedNode) != 0);
+        }
+      catch (...)
+        {
+        request.Success = false;
+        }
+      std::lock_guard<std::mutex> lock(mutex);
+      ++numberOfDoneRequests;
+      requestDone.notify_one();
+      }
+    };
+
+  int numberOfThreads = std::min(this->NumberOfReadDataThreads, static_cast<int>(requests.size()));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numberOfThreads; ++i)
+    {
+    threads.push_back(std::thread(readData));
+    }
+
+  // Report progress from the main thread
+  {
+  std::unique_lock<std::mutex> lock(mutex);
+  size_t reportedRequests = 0;
+  while (reportedRequests < requests.size())
+    {
+    requestDone.wait_for(lock, std::chrono::milliseconds(100),
+      [&]() { return numberOfDoneRequests != reportedRequests; });
+    if (numberOfDoneRequests != reportedRequests)
+      {
+      reportedRequests = numberOfDoneRequests;
+      lock.unlock();
+      this->ProgressState(vtkMRMLScene::ImportState,
+        static_cast<int>(100 * reportedRequests / requests.size()));
+      lock.lock();
+      }
+    }
+  }
+  for (std::vector<std::thread>::iterator threadIt = threads.begin(); threadIt != threads.end(); ++threadIt)
+    {
+    threadIt->join();
+    }
+  this->LastPreloadDataTime = vtkTimerLog::GetUniversalTime() - startTime;
+
+  // The data is set in the nodes of the scene by vtkMRMLStorageNode::ReadData()
+  // in the main thread (vtkEventBroker is not thread-safe).
+  // Nodes that failed are read again in the main thread to report the errors.
+  int numberOfPreloadedNodes = 0;
+  for (std::vector<PreloadRequest>::iterator requestIt = requests.begin(); requestIt != requests.end(); ++requestIt)
+    {
+    this->LastPreloadDataSize += requestIt->FileSize;
+    if (requestIt->Success)
+      {
+      requestIt->StorageNode->SetPreloadedNode(requestIt->DetachedNode,
+        requestIt->DetachedStorageNode->GetPreloadedData());
+      ++numberOfPreloadedNodes;
+      }
+    }
+  vtkDebugMacro("PreloadStorableNodesData: read " << numberOfPreloadedNodes << "/" << requests.size()
+    << " nodes (" << this->LastPreloadDataSize / 1.0e6 << "MB) in " << this->LastPreloadDataTime << "s"
+    << " using " << numberOfThreads << " threads ("
+    << (this->LastPreloadDataTime > 0 ? this->LastPreloadDataSize / 1.0e6 / this->LastPreloadDataTime : 0.0)
+    << "MB/s)");
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::RemoveReferencesToNode(vtkMRMLNode *n)
 {
@@ -1553,7 +1761,10 @@ void vtkMRMLScene::RemoveReferencesToNode(vtkMRMLNode *n)
     vtkErrorMacro("RemoveReferencesToNode: node is null or has null id, can't remove refs");
     return;
     }
-  this->NodeReferences.erase(n->GetID());
+  if (this->NodeReferences.erase(n->GetID()) > 0)
+    {
+    this->ReleaseInternedID(n->GetID());
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -1590,18 +1801,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetNodesByClassFromIndex(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1613,16 +1813,7 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
-    }
+  nodes = this->GetNodesByClassFromIndex(className);
   return static_cast<int>(nodes.size());
 }
 
@@ -1635,15 +1826,10 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return nullptr;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetNodesByClassFromIndex(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin(); nodeIt != classNodes.end(); ++nodeIt)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(*nodeIt);
     }
   return nodes;
 }
@@ -1780,22 +1966,12 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return nullptr;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetNodesByClassFromIndex(className);
+  if (n >= static_cast<int>(classNodes.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return nullptr;
     }
-  return nullptr;
+  return classNodes[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1902,7 +2078,7 @@ vtkMRMLNode* vtkMRMLScene::GetNodeByID(const char* id)
 
   vtkMRMLNode *node = nullptr;
   this->UpdateNodeIDs();
-  std::map< std::string, vtkSmartPointer<vtkMRMLNode> >::iterator it = this->NodeIDs.find(std::string(id));
+  NodeIDsType::iterator it = this->NodeIDs.find(id);
   if (it != this->NodeIDs.end())
     {
     node = it->second;
@@ -2041,6 +2217,9 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-to-date
   this->AddNodeID(n);
+  // the node is not necessarily the last one, so the class index can't
+  // simply be appended, it will be rebuilt on demand
+  this->ClearNodesByClass();
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2137,8 +2316,11 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     vtkDebugMacro("InsertBeforeNode: item index = " << itemIndex-1 << ", inserting after index = " << index);
     this->Nodes->vtkCollection::InsertItem(index, (vtkObject *)n);
     }
-  // cache the node so the whole scene cache stays up-todate
+  // cache the node so the whole scene cache stays up-to-date
   this->AddNodeID(n);
+  // the node is not necessarily the last one, so the class index can't
+  // simply be appended, it will be rebuilt on demand
+  this->ClearNodesByClass();
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2284,7 +2466,7 @@ int vtkMRMLScene::GetUniqueIDIndex(const std::string& baseID)
     vtkWarningMacro("vtkMRMLScene::GetUniqueIDIndex: baseID is empty");
     }
   int lastIDIndex = 0;
-  std::map< std::string, int>::const_iterator uidIt =
+  std::unordered_map< std::string, int>::const_iterator uidIt =
     this->UniqueIDs.find(baseID);
   if (uidIt != this->UniqueIDs.end())
     {
@@ -2309,7 +2491,7 @@ int vtkMRMLScene::GetUniqueIDIndex(const std::string& baseID)
 //------------------------------------------------------------------------------
 bool vtkMRMLScene::IsNodeIDReservedByUndo(const std::string id) const
 {
-  NodeReferencesType::const_iterator referenceIt = this->NodeReferences.find(id);
+  NodeReferencesType::const_iterator referenceIt = this->NodeReferences.find(id.c_str());
   if (referenceIt != this->NodeReferences.end())
     {
     // ID is referenced by a node in the scene.
@@ -2332,18 +2514,13 @@ void vtkMRMLScene::GetNodeReferenceIDsFromUndoStack(std::set<std::string>& refer
 {
   referenceIDs.clear();
 
-  std::list<vtkCollection*>::const_iterator undoStackIt;
+  // Each node copy is stored in a single undo level
+  std::list<UndoLevel>::const_iterator undoStackIt;
   for (undoStackIt = this->UndoStack.begin(); undoStackIt != this->UndoStack.end(); ++undoStackIt)
     {
-    vtkCollection* nodes = *undoStackIt;
-    for (int i = 0; i < nodes->GetNumberOfItems(); ++i)
+    for (const auto& snapshot : undoStackIt->Snapshots)
       {
-      vtkMRMLNode* node = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(i));
-      if (!node)
-        {
-        continue;
-        }
-
+      vtkMRMLNode* node = snapshot.second;
       std::vector<std::string> roles;
       node->GetNodeReferenceRoles(roles);
       std::vector<std::string>::iterator roleIt;
@@ -2499,11 +2676,12 @@ void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
 
   this->ClearRedoStack();
   //this->SetUndoOn();
-  this->PushIntoUndoStack();
+  vtkNew<vtkCollection> savedNodes;
   if (node)
     {
-    this->CopyNodeInUndoStack(node);
+    savedNodes->AddItem(node);
     }
+  this->PushIntoUndoStack(savedNodes);
 }
 
 //------------------------------------------------------------------------------
@@ -2525,16 +2703,15 @@ void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
 
   this->ClearRedoStack();
   //this->SetUndoOn();
-  this->PushIntoUndoStack();
-  unsigned int n;
-  for (n=0; n<nodes.size(); n++)
+  vtkNew<vtkCollection> savedNodes;
+  for (vtkMRMLNode* node : nodes)
     {
-    vtkMRMLNode *node = nodes[n];
-    if (node && node->GetUndoEnabled())
+    if (node)
       {
-      this->CopyNodeInUndoStack(node);
+      savedNodes->AddItem(node);
       }
     }
+  this->PushIntoUndoStack(savedNodes);
 }
 
 //------------------------------------------------------------------------------
@@ -2562,18 +2739,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
 
   this->ClearRedoStack();
   //this->SetUndoOn();
-  this->PushIntoUndoStack();
-
-  int nnodes = nodes->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
-      {
-      this->CopyNodeInUndoStack(node);
-      }
-    }
+  this->PushIntoUndoStack(nodes);
 }
 
 //------------------------------------------------------------------------------
@@ -2597,28 +2763,80 @@ void vtkMRMLScene::SaveStateForUndo ()
 //------------------------------------------------------------------------------
 // Make a new collection that has pointers to all the nodes in the current scene
 void vtkMRMLScene::PushIntoUndoStack()
+{
+  this->PushIntoUndoStack(nullptr);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PushIntoUndoStack(vtkCollection* savedNodes)
 {
   if (this->Nodes == nullptr)
     {
     return;
     }
 
-  vtkCollection* newScene = vtkCollection::New();
+  bool saveAllNodes = (savedNodes == this->Nodes);
+  std::unordered_set<vtkMRMLNode*> savedNodeSet;
+  if (savedNodes && !saveAllNodes)
+    {
+    vtkMRMLNode* node = nullptr;
+    vtkCollectionSimpleIterator it;
+    for (savedNodes->InitTraversal(it);
+      (node = vtkMRMLNode::SafeDownCast(savedNodes->GetNextItemAsObject(it)));)
+      {
+      savedNodeSet.insert(node);
+      }
+    }
 
-  vtkCollection* currentScene = this->Nodes;
+  bool firstLevel = this->UndoStack.empty();
+  this->UndoStack.push_back(UndoLevel());
+  UndoLevel& level = this->UndoStack.back();
+  level.AllNodesSaved = saveAllNodes;
 
-  int nnodes = currentScene->GetNumberOfItems();
+  // Only nodes that have been modified since they were last saved are copied
+  std::vector<std::string> nodeIDs;
+  vtkMRMLNode* node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+    (node = vtkMRMLNode::SafeDownCast(this->Nodes->GetNextItemAsObject(it)));)
+    {
+    if (!node->GetUndoEnabled() || !node->GetID())
+      {
+      continue;
+      }
+    nodeIDs.push_back(node->GetID());
+    if (saveAllNodes || savedNodeSet.find(node) != savedNodeSet.end())
+      {
+      if (!saveAllNodes)
+        {
+        level.SavedNodeIDs.insert(node->GetID());
+        }
+      this->SaveUndoNodeSnapshot(level, node);
+      }
+    }
 
-  for (int n=0; n<nnodes; n++)
+  // Record the nodes added and removed since the previous level
+  if (!firstLevel)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
+    std::unordered_set<std::string> previousNodeIDSet(this->UndoStackNodeIDs.begin(), this->UndoStackNodeIDs.end());
+    std::unordered_set<std::string> nodeIDSet(nodeIDs.begin(), nodeIDs.end());
+    for (const std::string& nodeID : nodeIDs)
       {
-      newScene->AddItem(node);
+      if (previousNodeIDSet.find(nodeID) == previousNodeIDSet.end())
+        {
+        level.AddedNodeIDs.push_back(nodeID);
+        }
+      }
+    for (const std::string& nodeID : this->UndoStackNodeIDs)
+      {
+      if (nodeIDSet.find(nodeID) == nodeIDSet.end())
+        {
+        level.RemovedNodeIDs.push_back(nodeID);
+        }
       }
     }
+  this->UndoStackNodeIDs.swap(nodeIDs);
 
-  this->UndoStack.push_back(newScene);
   this->TrimUndoStack();
 }
 
@@ -2650,34 +2868,157 @@ void vtkMRMLScene::PushIntoRedoStack()
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the undoable copy of the scene so that the node
-// can be edited
+// Save the node in the latest undo level so that the node can be edited
 void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
 {
-  if (!copyNode)
+  if (!copyNode || !copyNode->GetID())
+    {
+    vtkErrorMacro("CopyNodeInUndoStack: node is invalid");
+    return;
+    }
+  if (this->UndoStack.empty())
     {
-    vtkErrorMacro("CopyNodeInUndoStack: node is null");
     return;
     }
 
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != nullptr)
+  UndoLevel& level = this->UndoStack.back();
+  if (!level.AllNodesSaved)
     {
-    snode->CopyWithScene(copyNode);
+    level.SavedNodeIDs.insert(copyNode->GetID());
     }
+  this->SaveUndoNodeSnapshot(level, copyNode);
+}
 
-  vtkCollection* undoScene = this->UndoStack.back();
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::SaveUndoNodeSnapshot(UndoLevel& level, vtkMRMLNode* node)
+{
+  if (!node || !node->GetID())
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
+    vtkErrorMacro("SaveUndoNodeSnapshot: invalid node");
+    return;
+    }
+  std::unordered_map<std::string, UndoNodeSnapshotsType::iterator>::iterator latestIt =
+    this->LatestUndoNodeSnapshots.find(node->GetID());
+  if (latestIt != this->LatestUndoNodeSnapshots.end()
+    && this->IsUndoNodeSnapshotUpToDate(node, latestIt->second->Snapshot))
+    {
+    // the latest copy, in this level or an older one, is the current state of the node
+    return;
+    }
+
+  vtkSmartPointer<vtkMRMLNode> snapshot = vtkSmartPointer<vtkMRMLNode>::Take(node->CreateNodeInstance());
+  if (!snapshot)
+    {
+    return;
+    }
+  snapshot->CopyWithScene(node);
+  level.Snapshots[node->GetID()] = snapshot;
+
+  UndoNodeSnapshotInfo info;
+  info.Snapshot = snapshot;
+  info.SourceNode = node;
+  info.SourceMTime = node->GetMTime();
+  info.Size = -1;
+  UndoNodeSnapshotsType::iterator infoIt = this->UndoNodeSnapshots.insert(this->UndoNodeSnapshots.end(), info);
+  this->LatestUndoNodeSnapshots[node->GetID()] = infoIt;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::GetLatestUndoNodeSnapshots(std::unordered_map<std::string, vtkMRMLNode*>& snapshots)
+{
+  snapshots.clear();
+  // walk back from the most recent level, the first copy found for a node is the latest
+  for (std::list<UndoLevel>::reverse_iterator levelIt = this->UndoStack.rbegin();
+    levelIt != this->UndoStack.rend(); ++levelIt)
+    {
+    for (const auto& snapshot : levelIt->Snapshots)
       {
-      undoScene->ReplaceItem (n, snode);
-      break;
+      snapshots.emplace(snapshot.first, snapshot.second.GetPointer());
       }
     }
-  snode->Delete();
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLScene::IsUndoNodeSnapshotUpToDate(vtkMRMLNode* node, vtkMRMLNode* snapshot)
+{
+  if (!node || !snapshot || !node->GetID())
+    {
+    return false;
+    }
+  std::unordered_map<std::string, UndoNodeSnapshotsType::iterator>::iterator latestIt =
+    this->LatestUndoNodeSnapshots.find(node->GetID());
+  if (latestIt == this->LatestUndoNodeSnapshots.end())
+    {
+    return false;
+    }
+  const UndoNodeSnapshotInfo& info = *latestIt->second;
+  // Modifications made while modified events are disabled do not update the
+  // MTime until the pending modified event is invoked.
+  return info.Snapshot.GetPointer() == snapshot
+    && info.SourceNode.GetPointer() == node
+    && node->GetMTime() <= info.SourceMTime
+    && !node->GetModifiedEventPending();
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::RemoveUnusedUndoNodeSnapshots()
+{
+  for (std::unordered_map<std::string, UndoNodeSnapshotsType::iterator>::iterator latestIt =
+    this->LatestUndoNodeSnapshots.begin(); latestIt != this->LatestUndoNodeSnapshots.end();)
+    {
+    if (!latestIt->second->Snapshot)
+      {
+      latestIt = this->LatestUndoNodeSnapshots.erase(latestIt);
+      }
+    else
+      {
+      ++latestIt;
+      }
+    }
+  for (UndoNodeSnapshotsType::iterator infoIt = this->UndoNodeSnapshots.begin();
+    infoIt != this->UndoNodeSnapshots.end();)
+    {
+    if (!infoIt->Snapshot)
+      {
+      infoIt = this->UndoNodeSnapshots.erase(infoIt);
+      }
+    else
+      {
+      ++infoIt;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkTypeInt64 vtkMRMLScene::EstimateUndoNodeSnapshotSize(vtkMRMLNode* snapshot)
+{
+  if (!snapshot)
+    {
+    return 0;
+    }
+  std::stringstream ss;
+  snapshot->WriteXML(ss, 0);
+  ss.seekp(0, std::ios::end);
+  return static_cast<vtkTypeInt64>(ss.tellp()) + static_cast<vtkTypeInt64>(sizeof(vtkMRMLNode));
+}
+
+//------------------------------------------------------------------------------
+vtkTypeInt64 vtkMRMLScene::GetUndoStackMemorySize()
+{
+  vtkTypeInt64 size = 0;
+  for (UndoNodeSnapshotInfo& info : this->UndoNodeSnapshots)
+    {
+    if (!info.Snapshot)
+      {
+      continue;
+      }
+    if (info.Size < 0)
+      {
+      info.Size = vtkMRMLScene::EstimateUndoNodeSnapshotSize(info.Snapshot);
+      }
+    size += info.Size;
+    }
+  return size;
 }
 
 //------------------------------------------------------------------------------
@@ -2749,48 +3090,54 @@ void vtkMRMLScene::Undo()
       }
     }
 
-  vtkCollection* undoScene = nullptr;
-  std::vector<std::string> undoIDs;
-  std::vector<vtkMRMLNode*> undoNodes;
-
-  if (!this->UndoStack.empty())
-    {
-    undoScene = this->UndoStack.back();
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
-      {
-      vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-      if (node && node->GetUndoEnabled())
-        {
-        undoIDs.push_back(node->GetID());
-        undoNodes.push_back(node);
-        }
-      }
-    }
+  // The saved state of each node is its latest copy in the undo levels
+  UndoLevel& undoLevel = this->UndoStack.back();
+  std::unordered_map<std::string, vtkMRMLNode*> undoSnapshots;
+  this->GetLatestUndoNodeSnapshots(undoSnapshots);
 
-  std::vector<std::string>::iterator iterID;
-  std::vector<vtkMRMLNode*>::iterator iterNode;
   std::vector<std::string>::iterator curIterID;
   std::vector<vtkMRMLNode*>::iterator curIterNode;
 
+  std::unordered_map<std::string, vtkMRMLNode*> currentNodesByID;
+  for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
+    {
+    currentNodesByID[*curIterID] = *curIterNode;
+    }
+  std::unordered_set<std::string> undoIDSet(this->UndoStackNodeIDs.begin(), this->UndoStackNodeIDs.end());
+
   // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
+  std::vector<vtkSmartPointer<vtkMRMLNode> > addNodes;
 
-  for(iterID=undoIDs.begin(), iterNode = undoNodes.begin(); iterID != undoIDs.end(); iterID++, iterNode++)
+  for (const std::string& undoID : this->UndoStackNodeIDs)
     {
-    curIterID = std::find(currentIDs.begin(), currentIDs.end(), *iterID);
-    curIterNode = currentNodes.begin() + std::distance(currentIDs.begin(), curIterID);
-    if ( curIterID == currentIDs.end() )
+    std::unordered_map<std::string, vtkMRMLNode*>::iterator snapshotIt = undoSnapshots.find(undoID);
+    vtkMRMLNode* snapshot = (snapshotIt != undoSnapshots.end() ? snapshotIt->second : nullptr);
+    std::unordered_map<std::string, vtkMRMLNode*>::iterator currentNodeIt = currentNodesByID.find(undoID);
+    if ( currentNodeIt == currentNodesByID.end() )
       {
       // the node was deleted, add Node back to the current scene
-      addNodes.push_back(*iterNode);
+      if (!snapshot)
+        {
+        vtkWarningMacro("Undo: the state of node " << undoID << " was not saved, it cannot be restored");
+        continue;
+        }
+      // The saved copy may be needed by more recent undo levels, add a copy of it
+      // so that further changes of the node do not alter those levels.
+      vtkSmartPointer<vtkMRMLNode> node = vtkSmartPointer<vtkMRMLNode>::Take(snapshot->CreateNodeInstance());
+      node->CopyWithScene(snapshot);
+      addNodes.push_back(node);
       }
-    else if (*iterNode != *curIterNode)
+    else if (!undoLevel.AllNodesSaved && undoLevel.SavedNodeIDs.find(undoID) == undoLevel.SavedNodeIDs.end())
+      {
+      // the state of this node was not saved in this level
+      continue;
+      }
+    else if (snapshot && !this->IsUndoNodeSnapshotUpToDate(currentNodeIt->second, snapshot))
       {
       // nodes differ, copy from undo to current scene
       // but before create a copy in redo stack from current
-      this->CopyNodeInRedoStack(*curIterNode);
-      (*curIterNode)->CopyWithSceneWithSingleModifiedEvent(*iterNode);
+      this->CopyNodeInRedoStack(currentNodeIt->second);
+      currentNodeIt->second->CopyWithSceneWithSingleModifiedEvent(snapshot);
       }
     }
 
@@ -2798,9 +3145,8 @@ void vtkMRMLScene::Undo()
   std::vector<vtkMRMLNode*> removeNodes;
   for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
     {
-    iterID = std::find(undoIDs.begin(),undoIDs.end(), *curIterID);
     // Remove only if the node is not present in the previous state.
-    if ( iterID == undoIDs.end() )
+    if ( undoIDSet.find(*curIterID) == undoIDSet.end() )
       {
       removeNodes.push_back(*curIterNode);
       }
@@ -2822,16 +3168,21 @@ void vtkMRMLScene::Undo()
       }
     }
 
-  if (undoScene)
+  // Nodes of the previous level are the nodes of this level, without the
+  // added nodes and with the removed nodes.
+  std::unordered_set<std::string> addedIDSet(undoLevel.AddedNodeIDs.begin(), undoLevel.AddedNodeIDs.end());
+  this->UndoStackNodeIDs.erase(std::remove_if(this->UndoStackNodeIDs.begin(), this->UndoStackNodeIDs.end(),
+    [&addedIDSet](const std::string& nodeID) { return addedIDSet.find(nodeID) != addedIDSet.end(); }),
+    this->UndoStackNodeIDs.end());
+  this->UndoStackNodeIDs.insert(this->UndoStackNodeIDs.end(),
+    undoLevel.RemovedNodeIDs.begin(), undoLevel.RemovedNodeIDs.end());
+
+  this->UndoStack.pop_back();
+  if (this->UndoStack.empty())
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    this->UndoStackNodeIDs.clear();
     }
-
-  if (!this->UndoStack.empty())
-   {
-   this->UndoStack.pop_back();
-   }
+  this->RemoveUnusedUndoNodeSnapshots();
   this->Modified();
 
   this->EndState(vtkMRMLScene::UndoState);
@@ -2966,13 +3317,9 @@ void vtkMRMLScene::Redo()
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearUndoStack()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
-    {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
-    }
   this->UndoStack.clear();
+  this->UndoStackNodeIDs.clear();
+  this->RemoveUnusedUndoNodeSnapshots();
 }
 
 //------------------------------------------------------------------------------
@@ -3010,12 +3357,14 @@ void vtkMRMLScene::AddReferencedNodeID(const char *id, vtkMRMLNode *referencingN
     // When the scene will be set then all the references will be added.
     return;
     }
-  if (this->IsNodeReferencingNodeID(referencingNode, id))
+  NodeReferencesType::iterator referenceIt = this->NodeReferences.find(id);
+  if (referenceIt == this->NodeReferences.end())
     {
-    // this reference already exists, there is nothing to do
-    return;
+    referenceIt = this->NodeReferences.insert(
+      NodeReferencesType::value_type(this->InternID(id), ReferencingNodesType())).first;
     }
-  this->NodeReferences[id].insert(referencingNode->GetID());
+  // if this reference already exists then it is just overwritten
+  referenceIt->second[referencingNode] = referencingNode;
 }
 
 //------------------------------------------------------------------------------
@@ -3037,11 +3386,13 @@ bool vtkMRMLScene::IsNodeReferencingNodeID(vtkMRMLNode* referencingNode, const c
     // invalid referencing node id
     return false;
     }
-  if (referenceIt->second.find(referencingNode->GetID())==referenceIt->second.end())
+  ReferencingNodesType::iterator referringNodeIt = referenceIt->second.find(referencingNode);
+  if (referringNodeIt == referenceIt->second.end())
     {
     return false;
     }
-  return true;
+  // the entry may have been left by a deleted node at the same address
+  return referringNodeIt->second.GetPointer() == referencingNode;
 }
 
 //------------------------------------------------------------------------------
@@ -3089,25 +3440,32 @@ const char* vtkMRMLScene::GetChangedID(const char* id)
 //------------------------------------------------------------------------------
 void vtkMRMLScene::UpdateNodeReferences(vtkCollection* checkNodes/*=nullptr*/)
 {
+  std::vector< vtkWeakPointer<vtkMRMLNode> > nodesToNotify;
   for (std::map< std::string, std::string>::const_iterator iterChanged = this->ReferencedIDChanges.begin();
     iterChanged != this->ReferencedIDChanges.end(); iterChanged++)
     {
     const std::string& oldID = iterChanged->first;
     const std::string& newID = iterChanged->second;
-    NodeReferencesType::iterator referencedIdIt=this->NodeReferences.find(oldID);
+    NodeReferencesType::iterator referencedIdIt=this->NodeReferences.find(oldID.c_str());
     if (referencedIdIt==this->NodeReferences.end())
       {
       // this updated ID is not observed by any node
       continue;
       }
     // make a copy of the node list, as the list may change as a result of UpdateReferenceID calls
-    std::set<std::string> nodesToNotify=referencedIdIt->second;
-    for (NodeReferencesType::value_type::second_type::iterator referringNodesIt = nodesToNotify.begin();
+    nodesToNotify.clear();
+    for (ReferencingNodesType::iterator referringNodesIt = referencedIdIt->second.begin();
+      referringNodesIt != referencedIdIt->second.end();
+      ++referringNodesIt)
+      {
+      nodesToNotify.push_back(referringNodesIt->second);
+      }
+    for (std::vector< vtkWeakPointer<vtkMRMLNode> >::iterator referringNodesIt = nodesToNotify.begin();
       referringNodesIt!=nodesToNotify.end();
       ++referringNodesIt)
       {
-      vtkMRMLNode *node = this->GetNodeByID(*referringNodesIt);
-      if (node==nullptr)
+      vtkMRMLNode *node = *referringNodesIt;
+      if (!this->IsNodeInScene(node))
         {
         continue;
         }
@@ -3131,21 +3489,31 @@ void vtkMRMLScene::AddReferencedNodes(vtkMRMLNode *node, vtkCollection *refNodes
 
   std::deque<vtkMRMLNode*> newFoundReferencedNodes;
 
+  std::vector<const char*> referencedIDs;
   for (NodeReferencesType::iterator referenceIt = this->NodeReferences.begin();
     referenceIt != this->NodeReferences.end();
     ++referenceIt)
     {
-    NodeReferencesType::value_type::second_type::iterator referringNodesIt = referenceIt->second.find(node->GetID());
-    if (referringNodesIt!=referenceIt->second.end())
+    ReferencingNodesType::iterator referringNodeIt = referenceIt->second.find(node);
+    if (referringNodeIt != referenceIt->second.end()
+      && referringNodeIt->second.GetPointer() == node)
       {
-      // this ID is referenced by this node
-      vtkMRMLNode *referencedNode = this->GetNodeByID(referenceIt->first);
-      if (referencedNode!=nullptr && !refNodes->IsItemPresent(referencedNode))
-        {
-        // this ID is not yet in the list of reference nodes, so add it
-        refNodes->AddItem(referencedNode);
-        newFoundReferencedNodes.push_back(referencedNode);
-        }
+      // this ID is referenced by this node (and not by a deleted node at the same address)
+      referencedIDs.push_back(referenceIt->first);
+      }
+    }
+  // Process IDs in a deterministic order (NodeReferences is not sorted)
+  std::sort(referencedIDs.begin(), referencedIDs.end(), IDLess);
+
+  for (std::vector<const char*>::iterator referencedIDIt = referencedIDs.begin();
+    referencedIDIt != referencedIDs.end(); ++referencedIDIt)
+    {
+    vtkMRMLNode *referencedNode = this->GetNodeByID(*referencedIDIt);
+    if (referencedNode!=nullptr && !refNodes->IsItemPresent(referencedNode))
+      {
+      // this ID is not yet in the list of reference nodes, so add it
+      refNodes->AddItem(referencedNode);
+      newFoundReferencedNodes.push_back(referencedNode);
       }
     }
 
@@ -3192,16 +3560,18 @@ void vtkMRMLScene::GetReferencingNodes(vtkMRMLNode* referencedNode, std::vector<
     // no references to this node
     return;
     }
-  for (NodeReferencesType::value_type::second_type::iterator referringNodesIt = referencedNodeIdIt->second.begin();
+  for (ReferencingNodesType::iterator referringNodesIt = referencedNodeIdIt->second.begin();
     referringNodesIt != referencedNodeIdIt->second.end();
     ++referringNodesIt)
     {
-    vtkMRMLNode* node=this->GetNodeByID(*referringNodesIt);
-    if (node)
+    vtkMRMLNode* node = referringNodesIt->second;
+    if (this->IsNodeInScene(node))
       {
       referencingNodes.push_back(node);
       }
     }
+  // Return nodes in a deterministic order (NodeReferences is not sorted)
+  std::sort(referencingNodes.begin(), referencingNodes.end(), NodeIDLess);
 }
 
 //------------------------------------------------------------------------------
@@ -3212,8 +3582,30 @@ void vtkMRMLScene::CopyNodeReferences(vtkMRMLScene *scene)
     return;
     }
 
-  //assuming the nodes exist in this scene
-  this->NodeReferences=scene->NodeReferences;
+  // Referencing nodes are stored by pointer, so find the nodes
+  // in this scene that have the same IDs as the referencing nodes
+  // (assuming the nodes exist in this scene).
+  this->ClearNodeReferences();
+  for (NodeReferencesType::iterator referenceIt = scene->NodeReferences.begin();
+    referenceIt != scene->NodeReferences.end();
+    ++referenceIt)
+    {
+    for (ReferencingNodesType::iterator referringNodesIt = referenceIt->second.begin();
+      referringNodesIt != referenceIt->second.end();
+      ++referringNodesIt)
+      {
+      vtkMRMLNode* referencingNode = referringNodesIt->second;
+      if (referencingNode == nullptr || referencingNode->GetID() == nullptr)
+        {
+        continue;
+        }
+      vtkMRMLNode* node = this->GetNodeByID(referencingNode->GetID());
+      if (node)
+        {
+        this->AddReferencedNodeID(referenceIt->first, node);
+        }
+      }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -3287,7 +3679,15 @@ void vtkMRMLScene::AddNodeID(vtkMRMLNode *node)
 {
   if (this->Nodes && node && node->GetID())
     {
-    this->NodeIDs[std::string(node->GetID())] = node;
+    NodeIDsType::iterator nodeIDIt = this->NodeIDs.find(node->GetID());
+    if (nodeIDIt != this->NodeIDs.end())
+      {
+      nodeIDIt->second = node;
+      }
+    else
+      {
+      this->NodeIDs.insert(NodeIDsType::value_type(this->InternID(node->GetID()), node));
+      }
     this->NodeIDsMTime = this->Nodes->GetMTime();
     }
 }
@@ -3297,7 +3697,10 @@ void vtkMRMLScene::RemoveNodeID(char *nodeID)
 {
   if (this->Nodes && nodeID)
     {
-    this->NodeIDs.erase(std::string(nodeID));
+    if (this->NodeIDs.erase(nodeID) > 0)
+      {
+      this->ReleaseInternedID(nodeID);
+      }
     this->NodeIDsMTime = this->Nodes->GetMTime();
     }
 }
@@ -3307,11 +3710,174 @@ void vtkMRMLScene::ClearNodeIDs()
 {
   if (this->Nodes)
     {
+    for (NodeIDsType::iterator nodeIDIt = this->NodeIDs.begin(); nodeIDIt != this->NodeIDs.end(); ++nodeIDIt)
+      {
+      this->ReleaseInternedID(nodeIDIt->first);
+      }
     this->NodeIDs.clear();
     this->NodeIDsMTime = this->Nodes->GetMTime();
   }
 }
 
+//-----------------------------------------------------------------------------
+bool vtkMRMLScene::IsNodeInScene(vtkMRMLNode* node)
+{
+  // Node copies (e.g., in the undo stack) may have their scene set and
+  // have the same ID as a node in the scene, therefore the node pointer
+  // found by ID must be checked.
+  if (node == nullptr || node->GetScene() != this || node->GetID() == nullptr)
+    {
+    return false;
+    }
+  return this->GetNodeByID(node->GetID()) == node;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t vtkMRMLScene::IDHash::operator()(const char* id) const
+{
+  // FNV-1a hash
+  std::size_t hash = 2166136261u;
+  for (; *id; ++id)
+    {
+    hash = (hash ^ static_cast<unsigned char>(*id)) * 16777619u;
+    }
+  return hash;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkMRMLScene::IDEqual::operator()(const char* id1, const char* id2) const
+{
+  return strcmp(id1, id2) == 0;
+}
+
+//-----------------------------------------------------------------------------
+const char* vtkMRMLScene::InternID(const char* id)
+{
+  InternedIDsType::iterator idIt = this->InternedIDs.find(id);
+  if (idIt == this->InternedIDs.end())
+    {
+    InternedIDType internedID;
+    internedID.ID.reset(new std::string(id));
+    internedID.ReferenceCount = 0;
+    const char* key = internedID.ID->c_str();
+    idIt = this->InternedIDs.insert(InternedIDsType::value_type(key, std::move(internedID))).first;
+    }
+  idIt->second.ReferenceCount++;
+  return idIt->first;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ReleaseInternedID(const char* id)
+{
+  InternedIDsType::iterator idIt = this->InternedIDs.find(id);
+  if (idIt == this->InternedIDs.end())
+    {
+    vtkErrorMacro("ReleaseInternedID: ID " << id << " is not interned");
+    return;
+    }
+  if (--idIt->second.ReferenceCount <= 0)
+    {
+    // id may point to the interned string, which is deleted here
+    this->InternedIDs.erase(idIt);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodeReferences()
+{
+  for (NodeReferencesType::iterator referenceIt = this->NodeReferences.begin();
+    referenceIt != this->NodeReferences.end(); ++referenceIt)
+    {
+    this->ReleaseInternedID(referenceIt->first);
+    }
+  this->NodeReferences.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodesByClass()
+{
+  if (this->Nodes && this->Nodes->GetMTime() > this->NodesByClassMTime)
+    {
+    // The collection was modified without updating the index,
+    // the index can't be trusted anymore
+    this->ClearNodesByClass();
+    }
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>& vtkMRMLScene::GetNodesByClassFromIndex(const char* className)
+{
+  this->UpdateNodesByClass();
+  NodesByClassType::iterator classIt = this->NodesByClass.find(className);
+  if (classIt != this->NodesByClass.end())
+    {
+    return classIt->second;
+    }
+  // First time this class is queried, build the index entry
+  std::vector<vtkMRMLNode*>& classNodes = this->NodesByClass[className];
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    if (node->IsA(className))
+      {
+      classNodes.push_back(node);
+      }
+    }
+  return classNodes;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToNodesByClass(vtkMRMLNode* node)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  for (NodesByClassType::iterator classIt = this->NodesByClass.begin(); classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second.push_back(node);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromNodesByClass(vtkMRMLNode* node)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  for (NodesByClassType::iterator classIt = this->NodesByClass.begin(); classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (!node->IsA(classIt->first.c_str()))
+      {
+      continue;
+      }
+    std::vector<vtkMRMLNode*>& classNodes = classIt->second;
+    std::vector<vtkMRMLNode*>::iterator nodeIt = std::find(classNodes.begin(), classNodes.end(), node);
+    if (nodeIt != classNodes.end())
+      {
+      classNodes.erase(nodeIt);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodesByClass()
+{
+  if (this->Nodes)
+    {
+    this->NodesByClass.clear();
+    this->NodesByClassMTime = this->Nodes->GetMTime();
+    }
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
@@ -3622,49 +4188,59 @@ SetStorableNodesModifiedSinceRead(vtkCollection* storableNodes)
 //-----------------------------------------------------------------------------
 int vtkMRMLScene::GetNumberOfNodeReferences()
 {
-  int totalNumberOfReferences=0;
+  std::vector< std::pair<const char*, const char*> > references;
+  this->GetSortedNodeReferences(references);
+  return static_cast<int>(references.size());
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::GetSortedNodeReferences(std::vector< std::pair<const char*, const char*> >& references)
+{
+  references.clear();
   for (NodeReferencesType::iterator referenceIt = this->NodeReferences.begin();
     referenceIt != this->NodeReferences.end();
     ++referenceIt)
     {
-    totalNumberOfReferences+=referenceIt->second.size();
+    for (ReferencingNodesType::iterator referringNodesIt = referenceIt->second.begin();
+      referringNodesIt != referenceIt->second.end();
+      ++referringNodesIt)
+      {
+      vtkMRMLNode* referencingNode = referringNodesIt->second;
+      if (referencingNode == nullptr || referencingNode->GetID() == nullptr)
+        {
+        continue;
+        }
+      references.push_back(std::make_pair(referenceIt->first, referencingNode->GetID()));
+      }
     }
-  return totalNumberOfReferences;
+  std::sort(references.begin(), references.end(), NodeReferenceLess);
+  // Node copies (e.g., in the undo stack) have the same ID as the node they
+  // are copied from, count them only once.
+  references.erase(std::unique(references.begin(), references.end(), NodeReferenceEqual), references.end());
 }
 
 //-----------------------------------------------------------------------------
 vtkMRMLNode* vtkMRMLScene::GetNthReferencingNode(int n)
 {
-  for (NodeReferencesType::iterator referenceIt = this->NodeReferences.begin();
-    referenceIt != this->NodeReferences.end();
-    ++referenceIt)
+  std::vector< std::pair<const char*, const char*> > references;
+  this->GetSortedNodeReferences(references);
+  if (n < 0 || n >= static_cast<int>(references.size()))
     {
-    if (n<static_cast<int>(referenceIt->second.size()))
-      {
-      NodeReferencesType::value_type::second_type::iterator referringNodesIt=referenceIt->second.begin();
-      std::advance( referringNodesIt, n );
-      return this->GetNodeByID(*referringNodesIt);
-      }
-    n-=referenceIt->second.size();
+    return nullptr;
     }
-  return nullptr;
+  return this->GetNodeByID(references[n].second);
 }
 
 //-----------------------------------------------------------------------------
 const char* vtkMRMLScene::GetNthReferencedID(int n)
 {
-  for (NodeReferencesType::iterator referenceIt = this->NodeReferences.begin();
-    referenceIt != this->NodeReferences.end();
-    ++referenceIt)
+  std::vector< std::pair<const char*, const char*> > references;
+  this->GetSortedNodeReferences(references);
+  if (n < 0 || n >= static_cast<int>(references.size()))
     {
-    if (n<static_cast<int>(referenceIt->second.size()))
-      {
-      //NodeReferencesType::value_type::second_type::iterator referringNodesIt=referenceIt->second.begin();
-      return referenceIt->first.c_str();
-      }
-    n-=referenceIt->second.size();
+    return nullptr;
     }
-  return nullptr;
+  return references[n].first;
 }
 
 //-----------------------------------------------------------------------------
@@ -3688,10 +4264,70 @@ void vtkMRMLScene::SetMaximumNumberOfSavedUndoStates(int stackSize)
 //-----------------------------------------------------------------------------
 void vtkMRMLScene::TrimUndoStack()
 {
-  std::list<vtkSmartPointer<vtkCollection> > removedStacks;
   while(static_cast<int>(this->UndoStack.size()) > this->MaximumNumberOfSavedUndoStates)
     {
-    removedStacks.push_back(this->UndoStack.front());
-    this->UndoStack.pop_front();
+    this->RemoveOldestUndoLevel();
+    }
+  this->RemoveUnusedUndoNodeSnapshots();
+
+  if (this->MaximumUndoStackMemorySize <= 0)
+    {
+    return;
     }
+  // Node copies that are overridden by more recent levels are deleted with
+  // the oldest level. The most recent level is always kept.
+  while (this->UndoStack.size() > 1
+    && this->GetUndoStackMemorySize() > this->MaximumUndoStackMemorySize)
+    {
+    this->RemoveOldestUndoLevel();
+    this->RemoveUnusedUndoNodeSnapshots();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveOldestUndoLevel()
+{
+  if (this->UndoStack.empty())
+    {
+    return;
+    }
+  std::list<UndoLevel>::iterator oldestLevelIt = this->UndoStack.begin();
+  std::list<UndoLevel>::iterator nextLevelIt = std::next(oldestLevelIt);
+  if (nextLevelIt != this->UndoStack.end())
+    {
+    // The next level inherits the saved states that it does not override,
+    // except for the nodes that were removed from the scene in between.
+    std::unordered_set<std::string> removedIDSet(
+      nextLevelIt->RemovedNodeIDs.begin(), nextLevelIt->RemovedNodeIDs.end());
+    for (const auto& snapshot : oldestLevelIt->Snapshots)
+      {
+      if (removedIDSet.find(snapshot.first) == removedIDSet.end())
+        {
+        nextLevelIt->Snapshots.insert(snapshot);
+        }
+      }
+    // The next level is now the oldest, changes since the removed level are not needed anymore
+    nextLevelIt->AddedNodeIDs.clear();
+    nextLevelIt->RemovedNodeIDs.clear();
+    }
+  this->UndoStack.pop_front();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::SetMaximumUndoStackMemorySize(vtkTypeInt64 size)
+{
+  if (size == this->MaximumUndoStackMemorySize)
+    {
+    return;
+    }
+
+  if (size < 0)
+    {
+    vtkErrorMacro("Cannot set maximum undo stack memory size to be a value less than 0");
+    return;
+    }
+
+  this->MaximumUndoStackMemorySize = size;
+  this->TrimUndoStack();
+  this->Modified();
 }
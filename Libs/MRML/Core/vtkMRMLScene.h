@@ -30,8 +30,11 @@ Version:   $Revision: 1.18 $
 // STD includes
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class vtkCacheManager;
@@ -431,6 +434,12 @@ public:
 
   void RemoveUnusedNodeReferences();
 
+  /// Read the data of the storable nodes in background threads.
+  /// The result is set as preloaded node of the storage nodes, which use
+  /// it when the nodes are updated.
+  /// \sa SetNumberOfReadDataThreads(), vtkMRMLStorageNode::SetPreloadedNode()
+  void PreloadStorableNodesData(vtkCollection* nodes);
+
   bool IsReservedID(const std::string& id);
 
   void AddReservedID(const char *id);
@@ -494,6 +503,27 @@ public:
   vtkSetMacro(ReadDataOnLoad,int);
   vtkGetMacro(ReadDataOnLoad,int);
 
+  /// \brief Number of threads used to read the data of storable nodes when a
+  /// scene is imported.
+  ///
+  /// If larger than 1, the files of storable nodes that support it (see
+  /// vtkMRMLStorageNode::CanPreloadData()) are read concurrently into copies
+  /// of the nodes that are not in the scene. The data is then set in the
+  /// nodes of the scene in the main thread, when the nodes are updated.
+  /// Progress is reported by ProgressState() with the ImportState (in percent).
+  /// Default is 1: the files are read one after another in the main thread.
+  /// \sa GetLastPreloadDataTime(), GetLastPreloadDataSize()
+  vtkSetClampMacro(NumberOfReadDataThreads, int, 1, 64);
+  vtkGetMacro(NumberOfReadDataThreads, int);
+
+  /// Time in seconds spent reading the files of the last imported scene in
+  /// background threads.
+  vtkGetMacro(LastPreloadDataTime, double);
+
+  /// Size in bytes of the files read in background threads for the last
+  /// imported scene. Throughput is LastPreloadDataSize / LastPreloadDataTime.
+  vtkGetMacro(LastPreloadDataSize, vtkTypeInt64);
+
   void SetErrorMessage(const std::string &error);
   std::string GetErrorMessage();
 
@@ -745,9 +775,62 @@ public:
   void SetMaximumNumberOfSavedUndoStates(int stackSize);
   vtkGetMacro(MaximumNumberOfSavedUndoStates, int);
 
+  /// \brief Sets the maximum memory size (in bytes) of the saved undo states and removes the oldest saved
+  /// states so that the estimated memory size of the undo stack is less than the new maximum.
+  ///
+  /// The most recent saved state is never removed. 0 (default) means no limit.
+  /// \sa GetUndoStackMemorySize()
+  void SetMaximumUndoStackMemorySize(vtkTypeInt64 size);
+  vtkGetMacro(MaximumUndoStackMemorySize, vtkTypeInt64);
+
+  /// \brief Returns the estimated memory size (in bytes) of the node copies stored in the undo stack.
+  ///
+  /// Each undo level only stores copies of the nodes that were modified since they were last
+  /// saved, so only these copies are counted. The size of a node copy is estimated from the size
+  /// of its serialized properties, bulk data (image data, polydata...) is shared with the scene
+  /// node and is not included.
+  vtkTypeInt64 GetUndoStackMemorySize();
+
 protected:
 
-  typedef std::map< std::string, std::set<std::string> > NodeReferencesType;
+  /// \brief Hash and equality functors for IDs stored as C strings.
+  ///
+  /// Maps keyed by C strings can be searched using any node ID
+  /// without allocating a temporary std::string.
+  struct IDHash
+    {
+    std::size_t operator()(const char* id) const;
+    };
+  struct IDEqual
+    {
+    bool operator()(const char* id1, const char* id2) const;
+    };
+
+  /// Nodes referencing an ID. The weak pointer allows detecting referencing
+  /// nodes that have been deleted without having been removed from the map.
+  typedef std::unordered_map< vtkMRMLNode*, vtkWeakPointer<vtkMRMLNode> > ReferencingNodesType;
+  /// Keys are interned IDs (see InternID()).
+  typedef std::unordered_map< const char*, ReferencingNodesType, IDHash, IDEqual > NodeReferencesType;
+  /// Keys are interned IDs (see InternID()).
+  typedef std::unordered_map< const char*, vtkSmartPointer<vtkMRMLNode>, IDHash, IDEqual > NodeIDsType;
+
+  /// \brief Changes saved by one level of the undo stack.
+  ///
+  /// A level only stores copies of the nodes that have been modified since they
+  /// were last saved. The saved state of the other nodes is the latest copy found
+  /// in the older levels.
+  struct UndoLevel
+    {
+    /// Node copies made at this level, by node ID
+    std::unordered_map<std::string, vtkSmartPointer<vtkMRMLNode> > Snapshots;
+    /// True if the state of all the undo-enabled nodes was saved at this level.
+    /// Otherwise, only the nodes in SavedNodeIDs are restored by undo.
+    bool AllNodesSaved = true;
+    std::unordered_set<std::string> SavedNodeIDs;
+    /// Undo-enabled nodes added to and removed from the scene since the previous level
+    std::vector<std::string> AddedNodeIDs;
+    std::vector<std::string> RemovedNodeIDs;
+    };
 
   vtkMRMLScene();
   ~vtkMRMLScene() override;
@@ -755,9 +838,38 @@ protected:
   void PushIntoUndoStack();
   void PushIntoRedoStack();
 
+  /// Make a new undo level that saves the state of the nodes in \a savedNodes
+  /// and records the undo-enabled nodes that were added or removed since the previous level.
+  /// If \a savedNodes is the scene node collection, the state of all nodes is saved.
+  void PushIntoUndoStack(vtkCollection* savedNodes);
+
   void CopyNodeInUndoStack(vtkMRMLNode *node);
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// \brief Save the state of the node in an undo level.
+  ///
+  /// A copy of the node is added to the level only if the node has been modified since
+  /// its latest copy was made (or that copy is not in the undo stack anymore), otherwise
+  /// the saved state is the latest copy, found in an older level.
+  void SaveUndoNodeSnapshot(UndoLevel& level, vtkMRMLNode* node);
+
+  /// Get the latest copy of each node saved at or before the most recent undo level.
+  void GetLatestUndoNodeSnapshots(std::unordered_map<std::string, vtkMRMLNode*>& snapshots);
+
+  /// Remove the oldest undo level. Node copies that are still needed by the next level
+  /// are moved to that level.
+  void RemoveOldestUndoLevel();
+
+  /// Returns true if \a snapshot is the latest copy of \a node stored in the undo
+  /// stack and the node has not been modified since then.
+  bool IsUndoNodeSnapshotUpToDate(vtkMRMLNode* node, vtkMRMLNode* snapshot);
+
+  /// Forget about node copies that are not in the undo stack anymore.
+  void RemoveUnusedUndoNodeSnapshots();
+
+  /// Estimate the memory size of a node copy from the size of its XML serialization.
+  static vtkTypeInt64 EstimateUndoNodeSnapshotSize(vtkMRMLNode* snapshot);
+
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
   /// \warning Use with extreme caution as it might unsynchronize observer.
@@ -802,10 +914,60 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method.
   void ClearNodeIDs();
 
+  /// \brief Synchronize NodesByClass index with the \a Nodes collection.
+  ///
+  /// If the collection was modified without updating the index (e.g. by
+  /// directly adding items into the collection) then the index is cleared
+  /// and will be rebuilt on demand.
+  void UpdateNodesByClass();
+
+  /// \brief Get all nodes of class \a className (or derived from it) using
+  /// the NodesByClass index. Nodes are in the same order as in the scene.
+  ///
+  /// The index entry for \a className is built the first time the class
+  /// is queried, afterward it is kept up-to-date as nodes are added or removed.
+  const std::vector<vtkMRMLNode*>& GetNodesByClassFromIndex(const char* className);
+
+  /// Add node to all matching entries of the NodesByClass index.
+  void AddNodeToNodesByClass(vtkMRMLNode* node);
+
+  /// Remove node from all matching entries of the NodesByClass index.
+  void RemoveNodeFromNodesByClass(vtkMRMLNode* node);
+
+  /// Clear NodesByClass index used to speedup GetNodesByClass() methods.
+  void ClearNodesByClass();
+
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
-  /// Clean up elements of the undo/redo stack beyond the maximum size
+  /// \brief Return a copy of \a id owned by the scene.
+  ///
+  /// The same pointer is returned for identical IDs. Each call increments
+  /// the reference count of the ID, the returned string remains valid until
+  /// ReleaseInternedID() is called the same number of times.
+  const char* InternID(const char* id);
+
+  /// \brief Decrement the reference count of an interned ID.
+  ///
+  /// The interned string is deleted when it is no longer referenced.
+  /// Must be called when a key is removed from NodeIDs or NodeReferences.
+  void ReleaseInternedID(const char* id);
+
+  /// Clear NodeReferences and release the interned IDs used as keys.
+  void ClearNodeReferences();
+
+  /// \brief Return true if \a node is in the scene.
+  ///
+  /// Unlike IsNodePresent(), this method does not traverse the node collection
+  /// but it uses the NodeIDs map.
+  bool IsNodeInScene(vtkMRMLNode* node);
+
+  /// Get all unique (referenced ID, referencing node ID) pairs sorted by IDs.
+  /// Only for testing and debugging.
+  void GetSortedNodeReferences(std::vector< std::pair<const char*, const char*> >& references);
+
+  /// Clean up elements of the undo stack beyond the maximum number of levels
+  /// or the maximum memory size
   void TrimUndoStack();
 
   /// Reserve all node reference ids for a node
@@ -835,22 +997,63 @@ protected:
   int  MaximumNumberOfSavedUndoStates;
   bool UndoFlag;
 
-  std::list< vtkCollection* >  UndoStack;
+  std::list< UndoLevel >  UndoStack;
   std::list< vtkCollection* >  RedoStack;
 
+  /// IDs of the undo-enabled nodes of the scene when the most recent undo level
+  /// was saved, in the order of the scene.
+  std::vector<std::string> UndoStackNodeIDs;
+
+  vtkTypeInt64 MaximumUndoStackMemorySize;
+
+  /// Copy of a node stored in the undo stack. Snapshots are owned by the
+  /// undo level they are saved in, they are only weakly referenced here.
+  struct UndoNodeSnapshotInfo
+    {
+    vtkWeakPointer<vtkMRMLNode> Snapshot;
+    /// Scene node the snapshot was copied from
+    vtkWeakPointer<vtkMRMLNode> SourceNode;
+    /// Modification time of the scene node when the snapshot was copied
+    vtkMTimeType SourceMTime;
+    /// Estimated memory size of the snapshot, -1 if not computed yet
+    vtkTypeInt64 Size;
+    };
+  typedef std::list<UndoNodeSnapshotInfo> UndoNodeSnapshotsType;
+  /// All the snapshots that are stored in the undo stack
+  UndoNodeSnapshotsType UndoNodeSnapshots;
+  /// Latest snapshot of each node, by node ID
+  std::unordered_map<std::string, UndoNodeSnapshotsType::iterator> LatestUndoNodeSnapshots;
+
   std::string                 URL;
   std::string                 RootDirectory;
 
-  std::map<std::string, int> UniqueIDs;
+  std::unordered_map<std::string, int> UniqueIDs;
   std::map<std::string, int> UniqueNames;
   std::set<std::string>   ReservedIDs;
 
   std::vector< vtkMRMLNode* > RegisteredNodeClasses;
   std::vector< std::string >  RegisteredNodeTags;
 
-  NodeReferencesType NodeReferences; // ReferencedIDs (string), ReferencingNodes (node pointer)
+  NodeReferencesType NodeReferences; // ReferencedIDs (interned string), ReferencingNodes (node pointer)
   std::map< std::string, std::string > ReferencedIDChanges;
-  std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
+  NodeIDsType NodeIDs;
+
+  // Storage of the IDs used as keys in NodeIDs and NodeReferences, with
+  // the number of keys using each of them. The strings are allocated
+  // separately so that they do not move when the map is rehashed.
+  struct InternedIDType
+    {
+    std::unique_ptr<std::string> ID;
+    int ReferenceCount;
+    };
+  typedef std::unordered_map< const char*, InternedIDType, IDHash, IDEqual > InternedIDsType;
+  InternedIDsType InternedIDs;
+
+  // Nodes of the scene grouped by the class names that have been queried so far
+  // (a node is listed under all the queried classes it IsA()). Raw pointers are
+  // stored as the nodes are kept alive by the Nodes collection.
+  typedef std::map< std::string, std::vector<vtkMRMLNode*> > NodesByClassType;
+  NodesByClassType NodesByClass;
 
   // Stores default nodes. If a class is created or reset (using CreateNodeByClass or Clear) and
   // a default node is defined for it then the content of the default node will be used to initialize
@@ -867,7 +1070,12 @@ protected:
 
   int ReadDataOnLoad;
 
+  int NumberOfReadDataThreads;
+  double LastPreloadDataTime;
+  vtkTypeInt64 LastPreloadDataSize;
+
   vtkMTimeType  NodeIDsMTime;
+  vtkMTimeType  NodesByClassMTime;
 
   void RemoveAllNodes(bool removeSingletons);
 
@@ -24,6 +24,7 @@ Version:   $Revision: 1.1.1.1 $
 // VTK includes
 #include <vtkCollection.h>
 #include <vtkCommand.h>
+#include <vtkDataObject.h>
 #include <vtkNew.h>
 #include <vtkStringArray.h>
 #include <vtkURIHandler.h>
@@ -57,6 +58,7 @@ vtkMRMLStorageNode::vtkMRMLStorageNode()
   this->SupportedWriteFileTypes = vtkStringArray::New();
   this->WriteFileFormat = nullptr;
   this->StoredTime = vtkTimeStamp::New();
+  this->PreloadingData = false;
 }
 
 //----------------------------------------------------------------------------
@@ -1195,17 +1197,32 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
     return 0;
     }
 
-  this->StageReadData(refNode);
-  if ( this->GetReadState() != this->TransferDone )
+  int res = 0;
+  if (this->PreloadedNode && this->PreloadedNode->IsA(refNode->GetClassName()))
     {
-    // remote file download hasn't finished
-    vtkWarningMacro("ReadData: read state is pending, remote download hasn't finished yet");
-    return 0;
+    // data has already been read in a background thread
+    vtkSmartPointer<vtkMRMLNode> preloadedNode = this->PreloadedNode;
+    vtkSmartPointer<vtkDataObject> preloadedData = this->PreloadedData;
+    this->SetPreloadedNode(nullptr);
+    vtkDebugMacro("ReadData: using preloaded data, "
+      << "filename = " << (this->GetFileName() == nullptr ? "null" : this->GetFileName()));
+    res = this->ReadPreloadedDataInternal(refNode, preloadedNode, preloadedData);
+    }
+  else
+    {
+    this->SetPreloadedNode(nullptr);
+    this->StageReadData(refNode);
+    if ( this->GetReadState() != this->TransferDone )
+      {
+      // remote file download hasn't finished
+      vtkWarningMacro("ReadData: read state is pending, remote download hasn't finished yet");
+      return 0;
+      }
+    vtkDebugMacro("ReadData: read state is ready, "
+      <<  "URI = " << (this->GetURI() == nullptr ? "null" : this->GetURI()) << ", "
+      << "filename = " << (this->GetFileName() == nullptr ? "null" : this->GetFileName()));
+    res = this->ReadDataInternal(refNode);
     }
-  vtkDebugMacro("ReadData: read state is ready, "
-    <<  "URI = " << (this->GetURI() == nullptr ? "null" : this->GetURI()) << ", "
-    << "filename = " << (this->GetFileName() == nullptr ? "null" : this->GetFileName()));
-  int res = this->ReadDataInternal(refNode);
   if (res)
     {
     vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(refNode);
@@ -1254,6 +1271,50 @@ int vtkMRMLStorageNode::ReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
   return 0;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanPreloadData(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return false;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::PreloadData(vtkMRMLNode* refNode)
+{
+  this->SetPreloadedNode(nullptr);
+  this->PreloadingData = true;
+  int res = this->ReadData(refNode);
+  this->PreloadingData = false;
+  return res;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLStorageNode::SetPreloadedNode(vtkMRMLNode* preloadedNode, vtkDataObject* preloadedData)
+{
+  // not node properties, no Modified()
+  this->PreloadedNode = preloadedNode;
+  this->PreloadedData = preloadedData;
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLStorageNode::GetPreloadedNode()
+{
+  return this->PreloadedNode;
+}
+
+//------------------------------------------------------------------------------
+vtkDataObject* vtkMRMLStorageNode::GetPreloadedData()
+{
+  return this->PreloadedData;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::ReadPreloadedDataInternal(vtkMRMLNode* vtkNotUsed(refNode),
+  vtkMRMLNode* vtkNotUsed(preloadedNode), vtkDataObject* vtkNotUsed(preloadedData))
+{
+  vtkErrorMacro("ReadPreloadedDataInternal: not implemented for " << this->GetClassName());
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
 {
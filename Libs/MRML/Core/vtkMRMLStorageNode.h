@@ -22,6 +22,7 @@ class vtkMRMLStorableNode;
 class vtkURIHandler;
 
 // VTK includes
+class vtkDataObject;
 class vtkStringArray;
 
 // STD includes
@@ -57,6 +58,32 @@ public:
   /// \sa SetFileName(), ReadDataInternal(), GetStoredTime()
   virtual int ReadData(vtkMRMLNode *refNode, bool temporaryFile = false);
 
+  ///
+  /// Return true if PreloadData() can be called from a background thread on
+  /// a copy of \a refNode that is not in a scene. It is used by the scene
+  /// to read the data of multiple nodes concurrently.
+  /// Returns false by default.
+  /// \sa SetPreloadedNode(), vtkMRMLScene::SetNumberOfReadDataThreads()
+  virtual bool CanPreloadData(vtkMRMLNode* refNode);
+
+  ///
+  /// Read the file from a background thread. \a refNode is a copy of the
+  /// referenced node that is not in a scene. The data object that is read
+  /// is not set in \a refNode (it would add MRML observations and
+  /// vtkEventBroker is not thread-safe) but kept in GetPreloadedData().
+  /// Return 1 on success, 0 on failure.
+  /// \sa CanPreloadData(), SetPreloadedNode()
+  int PreloadData(vtkMRMLNode* refNode);
+
+  ///
+  /// Copy of the referenced node and data object read by PreloadData().
+  /// The next ReadData() call takes the data from them instead of reading
+  /// the file, then clears them.
+  /// \sa CanPreloadData(), ReadPreloadedDataInternal()
+  void SetPreloadedNode(vtkMRMLNode* preloadedNode, vtkDataObject* preloadedData = nullptr);
+  vtkMRMLNode* GetPreloadedNode();
+  vtkDataObject* GetPreloadedData();
+
   ///
   /// Write data from a  referenced node
   /// Return 1 on success, 0 on failure.
@@ -361,6 +388,16 @@ protected:
   /// To be reimplemented in subclass.
   virtual int ReadDataInternal(vtkMRMLNode* refNode);
 
+  /// Set the preloaded data object and the content of the preloaded node
+  /// in the referenced node (both nodes have the same class).
+  /// Returns 1 on success, 0 otherwise.
+  /// Only the content read from the file must be set: name, attributes and
+  /// node references of the referenced node are kept.
+  /// Returns 0 by default, to be reimplemented in subclasses that return
+  /// true in CanPreloadData().
+  virtual int ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                        vtkDataObject* preloadedData);
+
   /// Does the actual writing. Returns 1 on success, 0 otherwise.
   /// Returns 0 by default (write not supported).
   /// To be reimplemented in subclass.
@@ -420,6 +457,14 @@ protected:
   vtkTimeStamp* StoredTime;
 
   vtkWeakPointer<vtkMRMLStorableNode> LastFoundStorableNode;
+
+  vtkSmartPointer<vtkMRMLNode> PreloadedNode;
+
+  /// Set while ReadDataInternal() is called by PreloadData(): subclasses
+  /// must then keep the data object they read in PreloadedData instead of
+  /// setting it in the node.
+  bool PreloadingData;
+  vtkSmartPointer<vtkDataObject> PreloadedData;
 };
 
 #endif
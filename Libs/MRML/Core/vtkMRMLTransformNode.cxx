@@ -21,6 +21,7 @@ Version:   $Revision: 1.14 $
 #include "vtkMRMLScene.h"
 #include "vtkMRMLTransformStorageNode.h"
 #include "vtkMRMLTransformDisplayNode.h"
+#include "vtkBatchPointTransformer.h"
 #include "vtkOrientedBSplineTransform.h"
 #include "vtkOrientedGridTransform.h"
 
@@ -28,23 +29,123 @@ Version:   $Revision: 1.14 $
 #include <vtkCommand.h>
 #include <vtkCollection.h>
 #include <vtkCollectionIterator.h>
+#include <vtkDataArray.h>
 #include <vtkGeneralTransform.h>
 #include <vtkImageData.h>
 #include <vtkLinearTransform.h>
 #include <vtkHomogeneousTransform.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 #include <vtkPoints.h>
+#include <vtkSmartPointer.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
 
 // STD includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <sstream>
 #include <stack>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLTransformNode);
 
+//----------------------------------------------------------------------------
+class vtkMRMLTransformNode::vtkConsolidatedTransformCache
+{
+public:
+  /// Release the grid
+  void Reset()
+    {
+    this->SourceTransform = nullptr;
+    this->SourceTransformMTime = 0;
+    this->GridResolution = 0;
+    this->GridTransform = nullptr;
+    this->Bounds[0] = this->Bounds[2] = this->Bounds[4] = 0.0;
+    this->Bounds[1] = this->Bounds[3] = this->Bounds[5] = -1.0;
+    }
+
+  /// Transform chain that the grid was computed from
+  vtkSmartPointer<vtkGeneralTransform> SourceTransform;
+  vtkMTimeType SourceTransformMTime = 0;
+  /// Region that the grid is computed for (the grid extends one grid point beyond it)
+  double Bounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+  int GridResolution = 0;
+  vtkSmartPointer<vtkOrientedGridTransform> GridTransform;
+};
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct DisplacementGridThreadData
+{
+  vtkBatchPointTransformer* Transformer;
+  double GridIJKToRAS[16];
+  vtkImageData* DisplacementGrid;
+  std::atomic<int> NextSlice;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void ComputeDisplacementGridSlice(DisplacementGridThreadData* data, int k,
+  std::vector<double>& points_RAS, std::vector<double>& transformedPoints_RAS)
+{
+  int* extent = data->DisplacementGrid->GetExtent();
+  T* displacement = static_cast<T*>(data->DisplacementGrid->GetScalarPointer(extent[0], extent[2], k));
+  int rowLength = extent[1] - extent[0] + 1;
+  double point_IJK[4] = { 0.0, 0.0, static_cast<double>(k), 1.0 };
+  double point_RAS[4] = { 0.0, 0.0, 0.0, 1.0 };
+  for (int j = extent[2]; j <= extent[3]; j++)
+    {
+    // transform a row of grid points at once
+    point_IJK[1] = j;
+    for (int i = extent[0]; i <= extent[1]; i++)
+      {
+      point_IJK[0] = i;
+      vtkMatrix4x4::MultiplyPoint(data->GridIJKToRAS, point_IJK, point_RAS);
+      std::copy(point_RAS, point_RAS + 3, points_RAS.begin() + (i - extent[0]) * 3);
+      }
+    transformedPoints_RAS = points_RAS;
+    data->Transformer->TransformPointBuffer(transformedPoints_RAS.data(), rowLength);
+    for (int n = 0; n < rowLength * 3; n++)
+      {
+      *(displacement++) = static_cast<T>(transformedPoints_RAS[n] - points_RAS[n]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Computation time of slices may be very different (e.g., inverse of non-linear transforms
+// is computed iteratively), therefore each thread takes the next slice when it is done.
+VTK_THREAD_RETURN_TYPE ComputeDisplacementGridThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  DisplacementGridThreadData* data = static_cast<DisplacementGridThreadData*>(info->UserData);
+  int* extent = data->DisplacementGrid->GetExtent();
+  bool doublePrecision = (data->DisplacementGrid->GetScalarType() == VTK_DOUBLE);
+  std::vector<double> points_RAS((extent[1] - extent[0] + 1) * 3);
+  std::vector<double> transformedPoints_RAS(points_RAS.size());
+  for (int k = data->NextSlice++; k <= extent[5]; k = data->NextSlice++)
+    {
+    if (doublePrecision)
+      {
+      ComputeDisplacementGridSlice<double>(data, k, points_RAS, transformedPoints_RAS);
+      }
+    else
+      {
+      ComputeDisplacementGridSlice<float>(data, k, points_RAS, transformedPoints_RAS);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkMRMLTransformNode::vtkMRMLTransformNode()
 {
@@ -54,6 +155,12 @@ vtkMRMLTransformNode::vtkMRMLTransformNode()
 
   this->CachedMatrixTransformToParent=vtkMatrix4x4::New();
   this->CachedMatrixTransformFromParent=vtkMatrix4x4::New();
+
+  this->ConsolidatedTransformCaching = false;
+  this->ConsolidatedTransformGridResolution = 64;
+  this->ConsolidatedTransformToWorldCache = new vtkConsolidatedTransformCache;
+  this->ConsolidatedTransformFromWorldCache = new vtkConsolidatedTransformCache;
+  this->InverseGridCaching = true;
 }
 
 //----------------------------------------------------------------------------
@@ -66,12 +173,23 @@ vtkMRMLTransformNode::~vtkMRMLTransformNode()
   this->CachedMatrixTransformToParent=nullptr;
   this->CachedMatrixTransformFromParent->Delete();
   this->CachedMatrixTransformFromParent=nullptr;
+
+  delete this->ConsolidatedTransformToWorldCache;
+  this->ConsolidatedTransformToWorldCache = nullptr;
+  delete this->ConsolidatedTransformFromWorldCache;
+  this->ConsolidatedTransformFromWorldCache = nullptr;
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLTransformNode::WriteXML(ostream& of, int nIndent)
 {
   Superclass::WriteXML(of, nIndent);
+
+  vtkMRMLWriteXMLBeginMacro(of);
+  vtkMRMLWriteXMLBooleanMacro(consolidatedTransformCaching, ConsolidatedTransformCaching);
+  vtkMRMLWriteXMLIntMacro(consolidatedTransformGridResolution, ConsolidatedTransformGridResolution);
+  vtkMRMLWriteXMLBooleanMacro(inverseGridCaching, InverseGridCaching);
+  vtkMRMLWriteXMLEndMacro();
 }
 
 //----------------------------------------------------------------------------
@@ -81,6 +199,12 @@ void vtkMRMLTransformNode::ReadXMLAttributes(const char** atts)
 
   Superclass::ReadXMLAttributes(atts);
 
+  vtkMRMLReadXMLBeginMacro(atts);
+  vtkMRMLReadXMLBooleanMacro(consolidatedTransformCaching, ConsolidatedTransformCaching);
+  vtkMRMLReadXMLIntMacro(consolidatedTransformGridResolution, ConsolidatedTransformGridResolution);
+  vtkMRMLReadXMLBooleanMacro(inverseGridCaching, InverseGridCaching);
+  vtkMRMLReadXMLEndMacro();
+
   const char* attName;
   const char* attValue;
   while (*atts != nullptr)
@@ -302,6 +426,12 @@ void vtkMRMLTransformNode::Copy(vtkMRMLNode *anode)
 
   this->SetReadAsTransformToParent(node->GetReadAsTransformToParent());
 
+  vtkMRMLCopyBeginMacro(anode);
+  vtkMRMLCopyBooleanMacro(ConsolidatedTransformCaching);
+  vtkMRMLCopyIntMacro(ConsolidatedTransformGridResolution);
+  vtkMRMLCopyBooleanMacro(InverseGridCaching);
+  vtkMRMLCopyEndMacro();
+
   // Unfortunately VTK transform DeepCopy actually performs a shallow copy (only data object
   // pointers are copied, but not the contents itself), so we have to apply our custom DeepCopy
   // operation.
@@ -332,6 +462,12 @@ void vtkMRMLTransformNode::PrintSelf(ostream& os, vtkIndent indent)
   Superclass::PrintSelf(os,indent);
   os << indent << "ReadAsTransformToParent: " << this->ReadAsTransformToParent << "\n";
 
+  vtkMRMLPrintBeginMacro(os, indent);
+  vtkMRMLPrintBooleanMacro(ConsolidatedTransformCaching);
+  vtkMRMLPrintIntMacro(ConsolidatedTransformGridResolution);
+  vtkMRMLPrintBooleanMacro(InverseGridCaching);
+  vtkMRMLPrintEndMacro();
+
   // Flatten the transform list to make the copying simpler
   if (this->TransformToParent)
     {
@@ -433,6 +569,167 @@ void vtkMRMLTransformNode::GetTransformFromWorld(vtkGeneralTransform* transformF
   vtkMRMLTransformNode::GetTransformBetweenNodes(nullptr, this, transformFromWorld);
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLTransformNode::GetConsolidatedTransformToWorld(vtkGeneralTransform* transformToWorld, const double bounds[6])
+{
+  return this->GetConsolidatedTransform(transformToWorld, bounds, true);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLTransformNode::GetConsolidatedTransformFromWorld(vtkGeneralTransform* transformFromWorld, const double bounds_World[6])
+{
+  return this->GetConsolidatedTransform(transformFromWorld, bounds_World, false);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLTransformNode::GetConsolidatedTransform(vtkGeneralTransform* consolidatedTransform, const double bounds[6], bool toWorld)
+{
+  if (consolidatedTransform == nullptr)
+    {
+    vtkErrorMacro("vtkMRMLTransformNode::GetConsolidatedTransform failed: consolidatedTransform is invalid");
+    return false;
+    }
+  vtkConsolidatedTransformCache* cache = toWorld ? this->ConsolidatedTransformToWorldCache : this->ConsolidatedTransformFromWorldCache;
+  vtkNew<vtkGeneralTransform> sourceTransform;
+  if (toWorld)
+    {
+    this->GetTransformToWorld(sourceTransform.GetPointer());
+    }
+  else
+    {
+    this->GetTransformFromWorld(sourceTransform.GetPointer());
+    }
+
+  bool validBounds = (bounds != nullptr && bounds[0] <= bounds[1] && bounds[2] <= bounds[3] && bounds[4] <= bounds[5]);
+  if (!this->ConsolidatedTransformCaching || !validBounds || this->IsTransformToWorldLinear())
+    {
+    // no need for consolidation, release the grid
+    cache->Reset();
+    vtkMRMLTransformNode::GetTransformBetweenNodes(toWorld ? this : nullptr, toWorld ? nullptr : this, consolidatedTransform);
+    return false;
+    }
+
+  // Reuse the grid if the transform chain is the same, not modified, and the grid covers the requested region
+  vtkMTimeType sourceTransformMTime = this->GetTransformToWorldMTime();
+  bool gridValid = (cache->GridTransform != nullptr
+    && cache->GridResolution == this->ConsolidatedTransformGridResolution
+    && cache->SourceTransformMTime >= sourceTransformMTime
+    && vtkMRMLTransformNode::AreTransformsEqual(cache->SourceTransform, sourceTransform.GetPointer()));
+  bool regionCovered = true;
+  for (int axis = 0; axis < 3; axis++)
+    {
+    if (bounds[axis * 2] < cache->Bounds[axis * 2] || bounds[axis * 2 + 1] > cache->Bounds[axis * 2 + 1])
+      {
+      regionCovered = false;
+      }
+    }
+
+  if (!gridValid || !regionCovered)
+    {
+    // Grid covers the previously requested region as well, to avoid recomputation
+    // when the transform is used for multiple nodes.
+    double gridBounds[6] = { bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5] };
+    if (cache->Bounds[0] <= cache->Bounds[1])
+      {
+      for (int axis = 0; axis < 3; axis++)
+        {
+        gridBounds[axis * 2] = std::min(gridBounds[axis * 2], cache->Bounds[axis * 2]);
+        gridBounds[axis * 2 + 1] = std::max(gridBounds[axis * 2 + 1], cache->Bounds[axis * 2 + 1]);
+        }
+      }
+
+    // Isotropic spacing, at most ConsolidatedTransformGridResolution points along each axis
+    // and one extra grid point on both sides.
+    double maximumSize = std::max(std::max(gridBounds[1] - gridBounds[0], gridBounds[3] - gridBounds[2]), gridBounds[5] - gridBounds[4]);
+    int numberOfCells = std::max(this->ConsolidatedTransformGridResolution - 3, 1);
+    double spacing = (maximumSize > 0.0 ? maximumSize / numberOfCells : 1.0);
+    int dimensions[3] = { 1, 1, 1 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    for (int axis = 0; axis < 3; axis++)
+      {
+      dimensions[axis] = static_cast<int>(ceil((gridBounds[axis * 2 + 1] - gridBounds[axis * 2]) / spacing - 1e-6)) + 3;
+      origin[axis] = gridBounds[axis * 2] - spacing;
+      }
+
+    vtkNew<vtkImageData> displacementGrid;
+    displacementGrid->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    displacementGrid->SetOrigin(origin);
+    displacementGrid->SetSpacing(spacing, spacing, spacing);
+    displacementGrid->AllocateScalars(VTK_DOUBLE, 3);
+    vtkNew<vtkMatrix4x4> gridIJKToRAS;
+    for (int axis = 0; axis < 3; axis++)
+      {
+      gridIJKToRAS->SetElement(axis, axis, spacing);
+      gridIJKToRAS->SetElement(axis, 3, origin[axis]);
+      }
+    if (!vtkMRMLTransformNode::ComputeDisplacementGrid(sourceTransform.GetPointer(), gridIJKToRAS.GetPointer(), displacementGrid.GetPointer()))
+      {
+      cache->Reset();
+      vtkMRMLTransformNode::GetTransformBetweenNodes(toWorld ? this : nullptr, toWorld ? nullptr : this, consolidatedTransform);
+      return false;
+      }
+
+    cache->GridTransform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+    cache->GridTransform->SetDisplacementGridData(displacementGrid.GetPointer());
+    cache->SourceTransform = sourceTransform.GetPointer();
+    cache->SourceTransformMTime = sourceTransformMTime;
+    cache->GridResolution = this->ConsolidatedTransformGridResolution;
+    std::copy(gridBounds, gridBounds + 6, cache->Bounds);
+    }
+
+  consolidatedTransform->Identity();
+  consolidatedTransform->PostMultiply();
+  consolidatedTransform->Concatenate(cache->GridTransform);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLTransformNode::ComputeDisplacementGrid(vtkAbstractTransform* transform, vtkMatrix4x4* gridIJKToRAS,
+  vtkImageData* displacementGrid, int numberOfThreads/*=0*/)
+{
+  if (!transform || !gridIJKToRAS || !displacementGrid)
+    {
+    vtkGenericWarningMacro("vtkMRMLTransformNode::ComputeDisplacementGrid failed: invalid input");
+    return false;
+    }
+  int* extent = displacementGrid->GetExtent();
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    vtkGenericWarningMacro("vtkMRMLTransformNode::ComputeDisplacementGrid failed: empty grid extent");
+    return false;
+    }
+  vtkDataArray* scalars = displacementGrid->GetPointData()->GetScalars();
+  if (!scalars || scalars->GetNumberOfComponents() != 3
+    || scalars->GetNumberOfTuples() != displacementGrid->GetNumberOfPoints()
+    || (scalars->GetDataType() != VTK_FLOAT && scalars->GetDataType() != VTK_DOUBLE))
+    {
+    displacementGrid->AllocateScalars((scalars && scalars->GetDataType() == VTK_FLOAT) ? VTK_FLOAT : VTK_DOUBLE, 3);
+    }
+
+  // The transformer splits the transform into its concatenated transforms, so that
+  // each row of grid points can be pushed through them using batch kernels
+  vtkNew<vtkBatchPointTransformer> transformer;
+  transformer->SetTransform(transform);
+  transformer->Update();
+
+  DisplacementGridThreadData data;
+  data.Transformer = transformer.GetPointer();
+  vtkMatrix4x4::DeepCopy(data.GridIJKToRAS, gridIJKToRAS);
+  data.DisplacementGrid = displacementGrid;
+  data.NextSlice = extent[4];
+
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  numberOfThreads = std::max(1, std::min(std::min(numberOfThreads, extent[5] - extent[4] + 1), VTK_MAX_THREADS));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ComputeDisplacementGridThread, &data);
+  threader->SingleMethodExecute();
+  return true;
+}
+
 //----------------------------------------------------------------------------
 int  vtkMRMLTransformNode::IsTransformToNodeLinear(vtkMRMLTransformNode* targetNode)
 {
@@ -1117,6 +1414,7 @@ void vtkMRMLTransformNode::SetAndObserveTransform(vtkAbstractTransform** origina
   // the operations are performed without interruption.
   int disabledModify = this->StartModify();
 
+  this->UpdateInverseGridCaching(transform);
   vtkSetAndObserveMRMLObjectMacro((*originalTransformPtr), transform);
 
   // We set the inverse to nullptr, which means that it's unknown and will be computed atuomatically from the original transform
@@ -1128,6 +1426,44 @@ void vtkMRMLTransformNode::SetAndObserveTransform(vtkAbstractTransform** origina
   this->EndModify(disabledModify);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::SetInverseGridCaching(bool enable)
+{
+  if (this->InverseGridCaching == enable)
+    {
+    return;
+    }
+  int disabledModify = this->StartModify();
+  this->InverseGridCaching = enable;
+  // the inverse transform, if computed from the original transform, gets it when it is updated
+  this->UpdateInverseGridCaching(this->TransformToParent);
+  this->UpdateInverseGridCaching(this->TransformFromParent);
+  this->Modified();
+  this->EndModify(disabledModify);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLTransformNode::UpdateInverseGridCaching(vtkAbstractTransform* transform)
+{
+  vtkNew<vtkCollection> transformList;
+  vtkMRMLTransformNode::FlattenGeneralTransform(transformList.GetPointer(), transform);
+  vtkCollectionSimpleIterator it;
+  vtkObject* transformComponent = nullptr;
+  for (transformList->InitTraversal(it); (transformComponent = transformList->GetNextItemAsObject(it)) ;)
+    {
+    vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(transformComponent);
+    if (gridTransform)
+      {
+      gridTransform->SetInverseGridCaching(this->InverseGridCaching);
+      }
+    vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(transformComponent);
+    if (bsplineTransform)
+      {
+      bsplineTransform->SetInverseGridCaching(this->InverseGridCaching);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLTransformNode::SetAndObserveTransformToParent(vtkAbstractTransform *transform)
 {
@@ -20,6 +20,7 @@
 class vtkCollection;
 class vtkAbstractTransform;
 class vtkGeneralTransform;
+class vtkImageData;
 class vtkMatrix4x4;
 class vtkTransform;
 
@@ -146,6 +147,67 @@ public:
   static void GetTransformBetweenNodes(vtkMRMLTransformNode* sourceNode,
     vtkMRMLTransformNode* targetNode, vtkGeneralTransform* transformSourceToTarget);
 
+  ///
+  /// Enable consolidation of non-linear transform chains into a single grid transform.
+  /// Evaluating a chain of non-linear transforms (this transform, its parents, and all
+  /// components of composite transforms) at each point is slow. If consolidation is enabled
+  /// then GetConsolidatedTransformToWorld and GetConsolidatedTransformFromWorld sample the
+  /// whole chain once on a displacement grid and return that grid transform instead of the chain.
+  /// The result is an approximation, therefore it is disabled by default.
+  vtkSetMacro(ConsolidatedTransformCaching, bool);
+  vtkGetMacro(ConsolidatedTransformCaching, bool);
+  vtkBooleanMacro(ConsolidatedTransformCaching, bool);
+
+  ///
+  /// Enable inverse grid caching in the grid and b-spline components of the transform
+  /// (see vtkOrientedGridTransform::SetInverseGridCaching). When many points are inverse
+  /// transformed (e.g., when a volume is resampled), the inverse displacement is then
+  /// computed once on a grid and interpolated, which gives the iterative inversion a
+  /// starting point close to the solution. Accuracy of the inverse is not changed.
+  /// Enabled by default.
+  void SetInverseGridCaching(bool enable);
+  vtkGetMacro(InverseGridCaching, bool);
+  vtkBooleanMacro(InverseGridCaching, bool);
+
+  ///
+  /// Maximum number of grid points along an axis of the consolidated transform grid.
+  /// The grid spacing is isotropic. Default is 64.
+  vtkSetClampMacro(ConsolidatedTransformGridResolution, int, 4, 1024);
+  vtkGetMacro(ConsolidatedTransformGridResolution, int);
+
+  ///
+  /// Get concatenated transforms to world, for transforming points in the specified region.
+  /// If ConsolidatedTransformCaching is enabled and the transform to world is not linear
+  /// then the returned transform is a single grid transform that samples the transform chain
+  /// in the region (and one grid point beyond it). Outside the grid the displacement
+  /// of the closest grid boundary point is used.
+  /// The grid is computed (concurrently) when it is first requested and it is recomputed
+  /// when any transform of the chain is modified or the chain itself changes.
+  /// If a region is requested that is not covered by the grid then the grid is recomputed so that it covers
+  /// both the previous and the new region.
+  /// In all other cases the same transform is returned as by GetTransformToWorld.
+  /// \param bounds region (xmin, xmax, ymin, ymax, zmin, zmax) in the coordinate system of this node
+  /// \return true if the consolidated grid transform is returned
+  /// \sa GetTransformToWorld
+  bool GetConsolidatedTransformToWorld(vtkGeneralTransform* transformToWorld, const double bounds[6]);
+
+  ///
+  /// Get concatenated transforms from world, for transforming points in the specified region.
+  /// \param bounds_World region (xmin, xmax, ymin, ymax, zmin, zmax) in world coordinate system
+  /// \sa GetConsolidatedTransformToWorld, GetTransformFromWorld
+  bool GetConsolidatedTransformFromWorld(vtkGeneralTransform* transformFromWorld, const double bounds_World[6]);
+
+  ///
+  /// Sample the displacement of a transform at each point of a grid.
+  /// Points are transformed concurrently, using the batch kernels of vtkBatchPointTransformer.
+  /// The extent of the displacement grid must be set before calling this method.
+  /// The origin and spacing of the displacement grid are ignored, the grid geometry is specified by gridIJKToRAS.
+  /// 3-component float or double scalars are allocated if the grid does not have them yet.
+  /// \param numberOfThreads number of threads, 0 uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads()
+  /// \return true on success
+  static bool ComputeDisplacementGrid(vtkAbstractTransform* transform, vtkMatrix4x4* gridIJKToRAS,
+    vtkImageData* displacementGrid, int numberOfThreads = 0);
+
   ///
   /// Get concatenated transforms to world.
   /// Returns 0 if the transform is not linear (cannot be described by a matrix).
@@ -393,6 +455,25 @@ protected:
   /// GetMatrixTransformToParent and GetMatrixFromParent methods
   vtkMatrix4x4* CachedMatrixTransformToParent;
   vtkMatrix4x4* CachedMatrixTransformFromParent;
+
+  ///
+  /// Get the consolidated transform to or from world.
+  /// \sa GetConsolidatedTransformToWorld
+  bool GetConsolidatedTransform(vtkGeneralTransform* consolidatedTransform, const double bounds[6], bool toWorld);
+
+  bool ConsolidatedTransformCaching;
+  int ConsolidatedTransformGridResolution;
+
+  ///
+  /// Set InverseGridCaching in the grid and b-spline components of the transform.
+  void UpdateInverseGridCaching(vtkAbstractTransform* transform);
+
+  bool InverseGridCaching;
+
+  /// Grid transform computed from the transform to/from world
+  class vtkConsolidatedTransformCache;
+  vtkConsolidatedTransformCache* ConsolidatedTransformToWorldCache;
+  vtkConsolidatedTransformCache* ConsolidatedTransformFromWorldCache;
 };
 
 #endif
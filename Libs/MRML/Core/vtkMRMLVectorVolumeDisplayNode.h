@@ -128,6 +128,8 @@ protected:
   /// Set the input of the pipeline
   void SetInputToImageDataPipeline(vtkAlgorithmOutput *imageDataConnection) override;
   vtkAlgorithmOutput* GetScalarImageDataConnection() override;
+  /// The filter chain is modified, it can't be replaced by FusedDisplayFilter.
+  bool CanUseFusedDisplayFilter() override { return false; }
 
   int ScalarMode;
   int GlyphMode;
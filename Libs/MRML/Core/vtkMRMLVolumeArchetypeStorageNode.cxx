@@ -37,6 +37,7 @@ Version:   $Revision: 1.6 $
 #include <vtkDataArray.h>
 #include <vtkErrorCode.h>
 #include <vtkImageChangeInformation.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
@@ -156,6 +157,39 @@ bool vtkMRMLVolumeArchetypeStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *r
   return refNode->IsA("vtkMRMLScalarVolumeNode");
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLVolumeArchetypeStorageNode::CanPreloadData(vtkMRMLNode* refNode)
+{
+  return this->CanReadInReferenceNode(refNode);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                                                 vtkDataObject* preloadedData)
+{
+  vtkMRMLVolumeNode* volNode = vtkMRMLVolumeNode::SafeDownCast(refNode);
+  vtkMRMLVolumeNode* preloadedVolNode = vtkMRMLVolumeNode::SafeDownCast(preloadedNode);
+  if (!volNode || !preloadedVolNode)
+    {
+    vtkErrorMacro("ReadPreloadedDataInternal: Reference node is not a volume node");
+    return 0;
+    }
+  int wasModified = volNode->StartModify();
+  volNode->SetAndObserveImageData(vtkImageData::SafeDownCast(preloadedData));
+  volNode->CopyOrientation(preloadedVolNode);
+  vtkMRMLDiffusionTensorVolumeNode* dtvn = vtkMRMLDiffusionTensorVolumeNode::SafeDownCast(volNode);
+  vtkMRMLDiffusionTensorVolumeNode* preloadedDtvn = vtkMRMLDiffusionTensorVolumeNode::SafeDownCast(preloadedVolNode);
+  if (dtvn && preloadedDtvn)
+    {
+    vtkNew<vtkMatrix4x4> measurementFrame;
+    preloadedDtvn->GetMeasurementFrameMatrix(measurementFrame.GetPointer());
+    dtvn->SetMeasurementFrameMatrix(measurementFrame.GetPointer());
+    }
+  volNode->SetMetaDataDictionary(preloadedVolNode->GetMetaDataDictionary());
+  volNode->EndModify(wasModified);
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesReader*
 vtkMRMLVolumeArchetypeStorageNode::InstantiateVectorVolumeReader(const std::string& fullName)
@@ -324,7 +358,7 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   reader->AddObserver( vtkCommand::ProgressEvent,  this->MRMLCallbackCommand);
 
-  if (volNode->GetImageData())
+  if (volNode->GetImageData() && !this->PreloadingData)
     {
     volNode->SetAndObserveImageData(nullptr);
     }
@@ -462,7 +496,15 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   vtkNew<vtkImageData> iciOutputCopy;
   iciOutputCopy->ShallowCopy(ici->GetOutput());
-  volNode->SetAndObserveImageData(iciOutputCopy.GetPointer());
+  if (this->PreloadingData)
+    {
+    // set in the node by ReadPreloadedDataInternal() in the main thread
+    this->PreloadedData = iciOutputCopy.GetPointer();
+    }
+  else
+    {
+    volNode->SetAndObserveImageData(iciOutputCopy.GetPointer());
+    }
 
   // Log volume size to the application log. It helps to identify potential out-of-memory issues.
   vtkInfoMacro(<<"Loaded volume from file: "<<fullName \
@@ -77,6 +77,9 @@ public:
   bool CanReadInReferenceNode(vtkMRMLNode* refNode) override;
   bool CanWriteFromReferenceNode(vtkMRMLNode* refNode) override;
 
+  /// Data can be read in a background thread
+  bool CanPreloadData(vtkMRMLNode* refNode) override;
+
   ///
   /// Configure the storage node for data exchange. This is an
   /// opportunity to optimize the storage node's settings, for
@@ -104,6 +107,11 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Set the image data, orientation, measurement frame and meta data
+  /// dictionary of the preloaded node
+  int ReadPreloadedDataInternal(vtkMRMLNode* refNode, vtkMRMLNode* preloadedNode,
+                                vtkDataObject* preloadedData) override;
+
   /// Write data from a referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
@@ -46,6 +46,12 @@ vtkObservation::vtkObservation()
 
   this->LastElapsedTime = 0.0;
   this->TotalElapsedTime = 0.0;
+
+  this->InvocationCount = 0;
+  this->CoalescedEventCount = 0;
+  this->QueuedTime = 0.0;
+  this->LastLatency = 0.0;
+  this->TotalLatency = 0.0;
 }
 
 //----------------------------------------------------------------------------
@@ -100,4 +106,8 @@ void vtkObservation::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "LastElapsedTime: " << this->LastElapsedTime << "\n";
   os << indent << "TotalElapsedTime: " << this->TotalElapsedTime << "\n";
+  os << indent << "InvocationCount: " << this->InvocationCount << "\n";
+  os << indent << "CoalescedEventCount: " << this->CoalescedEventCount << "\n";
+  os << indent << "LastLatency: " << this->LastLatency << "\n";
+  os << indent << "TotalLatency: " << this->TotalLatency << "\n";
 }
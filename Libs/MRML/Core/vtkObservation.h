@@ -90,6 +90,32 @@ class VTK_MRML_EXPORT vtkObservation : public vtkObject
   vtkGetMacro (TotalElapsedTime, double);
   vtkSetMacro (TotalElapsedTime, double);
 
+  /// Description
+  /// Number of invocations of the observation
+  vtkGetMacro (InvocationCount, unsigned long);
+  vtkSetMacro (InvocationCount, unsigned long);
+
+  /// Description
+  /// Number of events merged into an already queued event (coalescing mode)
+  vtkGetMacro (CoalescedEventCount, unsigned long);
+  vtkSetMacro (CoalescedEventCount, unsigned long);
+
+  /// Description
+  /// Time (universal time in seconds) when the observation was added to the
+  /// event queue, 0 if the observation is not in the queue
+  vtkGetMacro (QueuedTime, double);
+  vtkSetMacro (QueuedTime, double);
+
+  /// Description
+  /// Time spent in the event queue before the last invocation and total time
+  /// spent in the event queue (0 for synchronous invocations).
+  /// When a queued observation is invoked with several call data, only the
+  /// first invocation has a latency.
+  vtkGetMacro (LastLatency, double);
+  vtkSetMacro (LastLatency, double);
+  vtkGetMacro (TotalLatency, double);
+  vtkSetMacro (TotalLatency, double);
+
   struct CallType
   {
     inline CallType(unsigned long eventID, void* callData);
@@ -160,6 +186,12 @@ protected:
   double LastElapsedTime;
   double TotalElapsedTime;
 
+  unsigned long InvocationCount;
+  unsigned long CoalescedEventCount;
+  double QueuedTime;
+  double LastLatency;
+  double TotalLatency;
+
 };
 
 //----------------------------------------------------------------------------
@@ -1037,7 +1037,17 @@ void vtkMRMLModelDisplayableManager::UpdateModelMesh(vtkMRMLDisplayableNode *dis
   if (tnode != nullptr && !tnode->IsTransformToWorldLinear())
     {
     hasNonLinearTransform = true;
-    tnode->GetTransformToWorld(worldTransform);
+    if (tnode->GetConsolidatedTransformCaching())
+      {
+      // Use the whole transform chain consolidated into a grid over the model
+      double bounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+      displayableNode->GetBounds(bounds);
+      tnode->GetConsolidatedTransformToWorld(worldTransform, bounds);
+      }
+    else
+      {
+      tnode->GetTransformToWorld(worldTransform);
+      }
     }
 
   for (i=0; i<ndnodes; i++)
@@ -34,8 +34,10 @@
 #include <vtkMRMLSliceNode.h>
 #include <vtkMRMLTransformNode.h>
 
+// MRMLLogic includes
+#include <vtkIndexedPlaneCutter.h>
+
 // VTK includes
-#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
 #include <vtkActor2D.h>
 #include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
@@ -45,10 +47,10 @@
 #include <vtkGeneralTransform.h>
 #include <vtkLookupTable.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlane.h>
-#include <vtkPointLocator.h>
 #include <vtkPolyDataMapper2D.h>
 #include <vtkProperty2D.h>
 #include <vtkRenderer.h>
@@ -59,12 +61,6 @@
 #include <vtkWeakPointer.h>
 
 // VTK includes: customization
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-  #include <vtkCompositeDataGeometryFilter.h>
-  #include <vtkPlaneCutter.h>
-#else
-  #include <vtkCutter.h>
-#endif
 #include <vtkSampleImplicitFunctionFilter.h>
 
 // STD includes
@@ -72,10 +68,32 @@
 #include <cassert>
 #include <set>
 #include <map>
+#include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro(vtkMRMLModelSliceDisplayableManager );
 
+namespace
+{
+//---------------------------------------------------------------------------
+struct CutterThreadData
+{
+  std::vector<vtkIndexedPlaneCutter*> Cutters;
+};
+
+//---------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE UpdateCuttersThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  CutterThreadData* data = static_cast<CutterThreadData*>(info->UserData);
+  for (size_t cutterIndex = info->ThreadID; cutterIndex < data->Cutters.size(); cutterIndex += info->NumberOfThreads)
+    {
+    data->Cutters[cutterIndex]->Update();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
 //---------------------------------------------------------------------------
 class vtkMRMLModelSliceDisplayableManager::vtkInternal
 {
@@ -88,12 +106,7 @@ public:
     vtkSmartPointer<vtkDataSetSurfaceFilter> SurfaceExtractor;
     vtkSmartPointer<vtkTransformFilter> ModelWarper;
     vtkSmartPointer<vtkPlane> Plane;
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-    vtkSmartPointer<vtkPlaneCutter> Cutter;
-    vtkSmartPointer<vtkCompositeDataGeometryFilter> GeometryFilter; // appends multiple cut pieces into a single polydata
-#else
-    vtkSmartPointer<vtkCutter> Cutter;
-#endif
+    vtkSmartPointer<vtkIndexedPlaneCutter> Cutter; // caches cell extents along the slice normal
     vtkSmartPointer<vtkSampleImplicitFunctionFilter> SliceDistance;
     vtkSmartPointer<vtkProp> Actor;
     };
@@ -111,6 +124,7 @@ public:
   void SetSliceNode(vtkMRMLSliceNode* sliceNode);
   void UpdateSliceNode();
   void SetSlicePlaneFromMatrix(vtkMatrix4x4* matrix, vtkPlane* plane);
+  void UpdateIntersections();
 
   // Display Nodes
   void AddDisplayNode(vtkMRMLDisplayableNode*, vtkMRMLDisplayNode*);
@@ -211,6 +225,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   //   then update the DisplayNode pipelines to account for plane location
 
   this->SliceXYToRAS->DeepCopy( this->SliceNode->GetXYToRAS() );
+  this->UpdateIntersections();
   PipelinesCacheType::iterator it;
   for (it = this->DisplayPipelines.begin(); it != this->DisplayPipelines.end(); ++it)
     {
@@ -238,6 +253,45 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   plane->SetOrigin(origin);
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLModelSliceDisplayableManager::vtkInternal
+::UpdateIntersections()
+{
+  // Cut the displayed models with the new slice plane in parallel,
+  // UpdateDisplayNodePipeline then finds the cutters up-to-date.
+  CutterThreadData data;
+  std::set<vtkDataObject*> meshes;
+  PipelinesCacheType::iterator it;
+  for (it = this->DisplayPipelines.begin(); it != this->DisplayPipelines.end(); ++it)
+    {
+    const Pipeline* pipeline = it->second;
+    vtkMRMLModelDisplayNode* modelDisplayNode = vtkMRMLModelDisplayNode::SafeDownCast(it->first);
+    // Models that were not displayed are updated with their display properties in UpdateDisplayNodePipeline
+    if (!modelDisplayNode || !pipeline->Actor->GetVisibility()
+      || modelDisplayNode->GetSliceDisplayMode() != vtkMRMLModelDisplayNode::SliceDisplayIntersection)
+      {
+      continue;
+      }
+    // Pipelines that share the same input mesh are not updated concurrently
+    vtkDataObject* mesh = pipeline->ModelWarper->GetInputDataObject(0, 0);
+    if (!mesh || !meshes.insert(mesh).second)
+      {
+      continue;
+      }
+    this->SetSlicePlaneFromMatrix(this->SliceXYToRAS, pipeline->Plane);
+    data.Cutters.push_back(pipeline->Cutter);
+    }
+  if (data.Cutters.size() < 2)
+    {
+    return;
+    }
+  int numberOfThreads = std::min(static_cast<int>(data.Cutters.size()), vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(UpdateCuttersThread, &data);
+  threader->SingleMethodExecute();
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLModelSliceDisplayableManager::vtkInternal
 ::GetNodeTransformToWorld(vtkMRMLTransformableNode* node, vtkGeneralTransform* transformToWorld)
@@ -253,7 +307,18 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   transformToWorld->Identity();
   if (tnode)
     {
-    tnode->GetTransformToWorld(transformToWorld);
+    vtkMRMLDisplayableNode* displayableNode = vtkMRMLDisplayableNode::SafeDownCast(node);
+    if (displayableNode && tnode->GetConsolidatedTransformCaching())
+      {
+      // Use the whole transform chain consolidated into a grid over the model
+      double bounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+      displayableNode->GetBounds(bounds);
+      tnode->GetConsolidatedTransformToWorld(transformToWorld, bounds);
+      }
+    else
+      {
+      tnode->GetTransformToWorld(transformToWorld);
+      }
     }
 }
 
@@ -320,12 +385,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   // Create pipeline
   Pipeline* pipeline = new Pipeline();
   pipeline->Actor = actor.GetPointer();
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-  pipeline->Cutter = vtkSmartPointer<vtkPlaneCutter>::New();
-  pipeline->GeometryFilter = vtkSmartPointer<vtkCompositeDataGeometryFilter>::New();
-#else
-  pipeline->Cutter = vtkSmartPointer<vtkCutter>::New();
-#endif
+  pipeline->Cutter = vtkSmartPointer<vtkIndexedPlaneCutter>::New();
   pipeline->SliceDistance = vtkSmartPointer<vtkSampleImplicitFunctionFilter>::New();
   pipeline->TransformToSlice = vtkSmartPointer<vtkTransform>::New();
   pipeline->NodeToWorld = vtkSmartPointer<vtkGeneralTransform>::New();
@@ -336,18 +396,9 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
 
   // Set up pipeline
   pipeline->Transformer->SetTransform(pipeline->TransformToSlice);
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-  pipeline->Transformer->SetInputConnection(pipeline->GeometryFilter->GetOutputPort());
-  pipeline->Cutter->SetPlane(pipeline->Plane);
-  pipeline->Cutter->BuildTreeOff(); // the cutter crashes for complex geometries if build tree is enabled
-  pipeline->Cutter->SetInputConnection(pipeline->ModelWarper->GetOutputPort());
-  pipeline->GeometryFilter->SetInputConnection(pipeline->Cutter->GetOutputPort());
-#else
   pipeline->Transformer->SetInputConnection(pipeline->Cutter->GetOutputPort());
-  pipeline->Cutter->SetCutFunction(pipeline->Plane);
-  pipeline->Cutter->SetGenerateCutScalars(0);
+  pipeline->Cutter->SetPlane(pipeline->Plane);
   pipeline->Cutter->SetInputConnection(pipeline->ModelWarper->GetOutputPort());
-#endif
   // Projection is created from outer surface of volumetric meshes (for polydata surface
   // extraction is just shallow-copy)
   pipeline->SurfaceExtractor->SetInputConnection(pipeline->ModelWarper->GetOutputPort());
@@ -461,8 +512,8 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   pipeline->ModelWarper->SetTransform(pipeline->NodeToWorld);
 
   // Set Plane Transform
+  // The plane is only modified if the slice moved, the cutter reuses its cell index otherwise.
   this->SetSlicePlaneFromMatrix(this->SliceXYToRAS, pipeline->Plane);
-  pipeline->Plane->Modified();
 
   if (modelDisplayNode->GetSliceDisplayMode() == vtkMRMLModelDisplayNode::SliceDisplayProjection
     || modelDisplayNode->GetSliceDisplayMode() == vtkMRMLModelDisplayNode::SliceDisplayDistanceEncodedProjection)
@@ -494,35 +545,18 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
     {
     // show intersection in the slice view
     // include clipper in the pipeline
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-    pipeline->Transformer->SetInputConnection(pipeline->GeometryFilter->GetOutputPort());
-#else
     pipeline->Transformer->SetInputConnection(pipeline->Cutter->GetOutputPort());
-
-    // optimization for slice to slice intersections which are 1 quad polydatas
-    // no need for 50^3 default locator divisions
-    if (pointSet->GetPoints() != nullptr && pointSet->GetNumberOfPoints() <= 4)
-    {
-      vtkNew<vtkPointLocator> locator;
-      double *bounds = pointSet->GetBounds();
-      locator->SetDivisions(2, 2, 2);
-      locator->InitPointInsertion(pointSet->GetPoints(), bounds);
-      pipeline->Cutter->SetLocator(locator.GetPointer());
-    }
-#endif
     pipeline->Cutter->SetInputConnection(pipeline->ModelWarper->GetOutputPort());
 
-#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
     // If there is no input or if the input has no points, the vtkTransformPolyDataFilter will display an error message
     // on every update: "No input data".
     // To prevent the error, if the input is empty then the actor should not be visible since there is nothing to display.
-    pipeline->GeometryFilter->Update();
-    if (!pipeline->GeometryFilter->GetOutput() || pipeline->GeometryFilter->GetOutput()->GetNumberOfPoints() < 1)
+    pipeline->Cutter->Update();
+    if (!pipeline->Cutter->GetOutput() || pipeline->Cutter->GetOutput()->GetNumberOfPoints() < 1)
       {
       pipeline->Actor->SetVisibility(false);
       return;
       }
-#endif
 
     //  Set Poly Data Transform
     vtkNew<vtkMatrix4x4> rasToSliceXY;
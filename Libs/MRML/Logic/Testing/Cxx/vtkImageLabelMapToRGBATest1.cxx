@@ -0,0 +1,246 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkImageLabelMapToRGBA.h"
+#include "vtkImageLabelOutline.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageMapToRGBA.h>
+#include <vtkImageReslice.h>
+#include <vtkImageThreshold.h>
+#include <vtkLookupTable.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+const int Size = 256;
+const int NumberOfSlices = 16;
+
+//---------------------------------------------------------------------------
+/// Labelmap with a box for each label, boxes of the last labels overwrite
+/// the previous ones.
+vtkSmartPointer<vtkImageData> CreateLabelmap(int numberOfLabels)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(Size, Size, NumberOfSlices);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  memset(ptr, 0, sizeof(short) * Size * Size * NumberOfSlices);
+  unsigned int value = 1;
+  for (short label = 1; label <= numberOfLabels; ++label)
+    {
+    int box[6];
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      int dimension = (axis < 2 ? Size : NumberOfSlices);
+      // linear congruential generator, good enough for test data
+      value = value * 1103515245 + 12345;
+      box[2 * axis] = (value >> 16) % dimension;
+      value = value * 1103515245 + 12345;
+      box[2 * axis + 1] = std::min(box[2 * axis] + static_cast<int>((value >> 16) % (dimension / 4)) + 1, dimension - 1);
+      }
+    for (int z = box[4]; z <= box[5]; ++z)
+      {
+      for (int y = box[2]; y <= box[3]; ++y)
+        {
+        for (int x = box[0]; x <= box[1]; ++x)
+          {
+          ptr[(z * Size + y) * Size + x] = label;
+          }
+        }
+      }
+    }
+  return image;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkLookupTable> CreateLookupTable(int numberOfLabels, double opacity)
+{
+  vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+  lookupTable->SetNumberOfTableValues(numberOfLabels + 1);
+  lookupTable->SetRange(0, numberOfLabels);
+  lookupTable->Build();
+  lookupTable->SetTableValue(0, 0.0, 0.0, 0.0, 0.0);
+  for (int label = 1; label <= numberOfLabels; ++label)
+    {
+    lookupTable->SetTableValue(label, (label % 7) / 6.0, (label % 5) / 4.0, (label % 3) / 2.0, opacity);
+    }
+  return lookupTable;
+}
+
+//---------------------------------------------------------------------------
+bool IsSameImage(vtkImageData* image1, vtkImageData* image2)
+{
+  if (image1->GetNumberOfPoints() != image2->GetNumberOfPoints()
+    || image1->GetNumberOfScalarComponents() != image2->GetNumberOfScalarComponents()
+    || image1->GetScalarType() != image2->GetScalarType())
+    {
+    return false;
+    }
+  return memcmp(image1->GetScalarPointer(), image2->GetScalarPointer(),
+    image1->GetNumberOfPoints() * image1->GetNumberOfScalarComponents()) == 0;
+}
+
+//---------------------------------------------------------------------------
+int TestOutput(int outline)
+{
+  const int numberOfLabels = 50;
+  vtkSmartPointer<vtkImageData> labelmap = CreateLabelmap(numberOfLabels);
+  vtkSmartPointer<vtkLookupTable> fillLookupTable = CreateLookupTable(numberOfLabels, 0.5);
+  vtkSmartPointer<vtkLookupTable> outlineLookupTable = CreateLookupTable(numberOfLabels, 1.0);
+
+  vtkNew<vtkImageMapToRGBA> fillColorMapper;
+  fillColorMapper->SetInputData(labelmap);
+  fillColorMapper->SetOutputFormatToRGBA();
+  fillColorMapper->SetLookupTable(fillLookupTable);
+  fillColorMapper->Update();
+  vtkNew<vtkImageLabelOutline> labelOutline;
+  labelOutline->SetInputData(labelmap);
+  labelOutline->SetOutline(outline);
+  vtkNew<vtkImageMapToRGBA> outlineColorMapper;
+  outlineColorMapper->SetInputConnection(labelOutline->GetOutputPort());
+  outlineColorMapper->SetOutputFormatToRGBA();
+  outlineColorMapper->SetLookupTable(outlineLookupTable);
+  outlineColorMapper->Update();
+
+  vtkNew<vtkImageLabelMapToRGBA> labelMapToRGBA;
+  labelMapToRGBA->SetInputData(labelmap);
+  labelMapToRGBA->SetFillLookupTable(fillLookupTable);
+  labelMapToRGBA->SetOutlineLookupTable(outlineLookupTable);
+  labelMapToRGBA->SetOutline(outline);
+  labelMapToRGBA->Update();
+
+  CHECK_BOOL(IsSameImage(labelMapToRGBA->GetFillOutput(), fillColorMapper->GetOutput()), true);
+  CHECK_BOOL(IsSameImage(labelMapToRGBA->GetOutlineOutput(), outlineColorMapper->GetOutput()), true);
+
+  // Modified lookup tables are taken into account
+  fillLookupTable->SetTableValue(1, 1.0, 1.0, 1.0, 1.0);
+  fillColorMapper->Update();
+  labelMapToRGBA->Update();
+  CHECK_BOOL(IsSameImage(labelMapToRGBA->GetFillOutput(), fillColorMapper->GetOutput()), true);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+/// Reslice each slice of the labelmap and color its fill and outline, as the
+/// segmentations displayable manager does when scrolling through slices.
+/// If perSegment is true, a pipeline is used for each label (extracted by
+/// thresholding), otherwise all the labels are colored by one pipeline.
+double ScrollSlices(vtkImageData* labelmap, int numberOfLabels, bool perSegment, bool fused)
+{
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(labelmap);
+  reslice->SetInterpolationModeToNearestNeighbor();
+  reslice->SetOutputDimensionality(2);
+
+  std::vector<vtkSmartPointer<vtkAlgorithm> > outputs;
+  int numberOfPipelines = (perSegment ? numberOfLabels : 1);
+  vtkSmartPointer<vtkLookupTable> fillLookupTable = CreateLookupTable(numberOfLabels, 0.5);
+  vtkSmartPointer<vtkLookupTable> outlineLookupTable = CreateLookupTable(numberOfLabels, 1.0);
+  for (int pipelineIndex = 0; pipelineIndex < numberOfPipelines; ++pipelineIndex)
+    {
+    vtkAlgorithmOutput* labelOutput = reslice->GetOutputPort();
+    if (perSegment)
+      {
+      vtkNew<vtkImageThreshold> threshold;
+      threshold->SetInputConnection(reslice->GetOutputPort());
+      threshold->ThresholdBetween(pipelineIndex + 1, pipelineIndex + 1);
+      threshold->SetInValue(pipelineIndex + 1);
+      threshold->SetOutValue(0);
+      outputs.push_back(threshold.GetPointer());
+      labelOutput = threshold->GetOutputPort();
+      }
+    if (fused)
+      {
+      vtkNew<vtkImageLabelMapToRGBA> labelMapToRGBA;
+      labelMapToRGBA->SetInputConnection(labelOutput);
+      labelMapToRGBA->SetFillLookupTable(fillLookupTable);
+      labelMapToRGBA->SetOutlineLookupTable(outlineLookupTable);
+      outputs.push_back(labelMapToRGBA.GetPointer());
+      }
+    else
+      {
+      vtkNew<vtkImageMapToRGBA> fillColorMapper;
+      fillColorMapper->SetInputConnection(labelOutput);
+      fillColorMapper->SetLookupTable(fillLookupTable);
+      vtkNew<vtkImageLabelOutline> labelOutline;
+      labelOutline->SetInputConnection(labelOutput);
+      vtkNew<vtkImageMapToRGBA> outlineColorMapper;
+      outlineColorMapper->SetInputConnection(labelOutline->GetOutputPort());
+      outlineColorMapper->SetLookupTable(outlineLookupTable);
+      outputs.push_back(fillColorMapper.GetPointer());
+      outputs.push_back(outlineColorMapper.GetPointer());
+      }
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int slice = 0; slice < NumberOfSlices; ++slice)
+    {
+    reslice->SetResliceAxesOrigin(0.0, 0.0, slice);
+    for (std::vector<vtkSmartPointer<vtkAlgorithm> >::iterator outputIt = outputs.begin();
+      outputIt != outputs.end(); ++outputIt)
+      {
+      // Fused filters produce both outputs in the same update
+      (*outputIt)->Update();
+      }
+    }
+  timer->StopTimer();
+  return NumberOfSlices / timer->GetElapsedTime();
+}
+
+//---------------------------------------------------------------------------
+int TestPerformance(int numberOfLabels)
+{
+  vtkSmartPointer<vtkImageData> labelmap = CreateLabelmap(numberOfLabels);
+  double perSegmentFrameRate = ScrollSlices(labelmap, numberOfLabels, true, false);
+  double sharedFrameRate = ScrollSlices(labelmap, numberOfLabels, false, false);
+  double fusedFrameRate = ScrollSlices(labelmap, numberOfLabels, false, true);
+  std::cout << numberOfLabels << " segments, " << Size << "x" << Size << " slices:"
+            << " per-segment pipelines: " << perSegmentFrameRate << " frames/s"
+            << " shared pipeline: " << sharedFrameRate << " frames/s"
+            << " shared pipeline with vtkImageLabelMapToRGBA: " << fusedFrameRate << " frames/s" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkImageLabelMapToRGBATest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestOutput(0));
+  CHECK_EXIT_SUCCESS(TestOutput(1));
+  CHECK_EXIT_SUCCESS(TestOutput(3));
+  CHECK_EXIT_SUCCESS(TestPerformance(10));
+  CHECK_EXIT_SUCCESS(TestPerformance(100));
+#ifdef NDEBUG
+  CHECK_EXIT_SUCCESS(TestPerformance(300));
+#endif
+  return EXIT_SUCCESS;
+}
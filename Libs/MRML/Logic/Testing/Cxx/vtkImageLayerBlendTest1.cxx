@@ -0,0 +1,265 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkImageLayerBlend.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageBlend.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateLayer(int size, int seed)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(size, size, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 4);
+  unsigned char* ptr = static_cast<unsigned char*>(image->GetScalarPointer());
+  unsigned int value = static_cast<unsigned int>(seed);
+  for (vtkIdType i = 0; i < static_cast<vtkIdType>(size) * size * 4; ++i)
+    {
+    // linear congruential generator, good enough for test data
+    value = value * 1103515245 + 12345;
+    ptr[i] = static_cast<unsigned char>(value >> 16);
+    }
+  return image;
+}
+
+//---------------------------------------------------------------------------
+int MaximumDifference(vtkImageData* image1, vtkImageData* image2)
+{
+  if (image1->GetNumberOfPoints() != image2->GetNumberOfPoints()
+    || image1->GetNumberOfScalarComponents() != image2->GetNumberOfScalarComponents())
+    {
+    return 256;
+    }
+  unsigned char* ptr1 = static_cast<unsigned char*>(image1->GetScalarPointer());
+  unsigned char* ptr2 = static_cast<unsigned char*>(image2->GetScalarPointer());
+  int maximumDifference = 0;
+  for (vtkIdType i = 0; i < image1->GetNumberOfPoints() * image1->GetNumberOfScalarComponents(); ++i)
+    {
+    maximumDifference = std::max(maximumDifference, std::abs(ptr1[i] - ptr2[i]));
+    }
+  return maximumDifference;
+}
+
+//---------------------------------------------------------------------------
+// Add or subtract the RGB components of the foreground to the background,
+// as done by the previous vtkMRMLSliceLogic pipeline (cast, math, cast,
+// extract and append components).
+vtkSmartPointer<vtkImageData> AddLayers(vtkImageData* background, vtkImageData* foreground, bool subtract)
+{
+  vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+  output->DeepCopy(background);
+  unsigned char* outPtr = static_cast<unsigned char*>(output->GetScalarPointer());
+  unsigned char* inPtr = static_cast<unsigned char*>(foreground->GetScalarPointer());
+  for (vtkIdType i = 0; i < output->GetNumberOfPoints(); ++i, outPtr += 4, inPtr += 4)
+    {
+    for (int c = 0; c < 3; ++c)
+      {
+      int value = subtract ? outPtr[c] - inPtr[c] : outPtr[c] + inPtr[c];
+      outPtr[c] = static_cast<unsigned char>(std::min(std::max(value, 0), 255));
+      }
+    }
+  return output;
+}
+
+//---------------------------------------------------------------------------
+int TestAlphaBlending(vtkImageData* background, vtkImageData* foreground, vtkImageData* label)
+{
+  vtkNew<vtkImageBlend> referenceBlend;
+  vtkNew<vtkImageLayerBlend> layerBlend;
+  vtkImageBlend* blends[2] = { referenceBlend.GetPointer(), layerBlend.GetPointer() };
+  for (int i = 0; i < 2; ++i)
+    {
+    blends[i]->AddInputData(background);
+    blends[i]->AddInputData(foreground);
+    blends[i]->AddInputData(label);
+    blends[i]->SetOpacity(0, 1.0);
+    blends[i]->SetOpacity(1, 0.6);
+    blends[i]->SetOpacity(2, 0.3);
+    blends[i]->Update();
+    }
+  CHECK_BOOL(MaximumDifference(referenceBlend->GetOutput(), layerBlend->GetOutput()) <= 1, true);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestAddSubtract(vtkImageData* background, vtkImageData* foreground, vtkImageData* label, bool subtract)
+{
+  vtkNew<vtkImageBlend> referenceBlend;
+  referenceBlend->AddInputData(AddLayers(background, foreground, subtract));
+  referenceBlend->AddInputData(label);
+  referenceBlend->SetOpacity(1, 0.3);
+  referenceBlend->Update();
+
+  vtkNew<vtkImageLayerBlend> layerBlend;
+  layerBlend->AddInputData(background);
+  layerBlend->AddInputData(foreground);
+  layerBlend->AddInputData(label);
+  layerBlend->SetOpacity(2, 0.3);
+  if (subtract)
+    {
+    layerBlend->SetForegroundCompositingToSubtract();
+    }
+  else
+    {
+    layerBlend->SetForegroundCompositingToAdd();
+    }
+  layerBlend->Update();
+
+  CHECK_BOOL(MaximumDifference(referenceBlend->GetOutput(), layerBlend->GetOutput()) <= 1, true);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateFloatLayer(int size, int seed)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(size, size, 1);
+  image->AllocateScalars(VTK_FLOAT, 4);
+  float* ptr = static_cast<float*>(image->GetScalarPointer());
+  unsigned int value = static_cast<unsigned int>(seed);
+  for (vtkIdType i = 0; i < static_cast<vtkIdType>(size) * size * 4; ++i)
+    {
+    value = value * 1103515245 + 12345;
+    ptr[i] = static_cast<float>((value >> 16) & 0xff) / 255.0f;
+    }
+  return image;
+}
+
+//---------------------------------------------------------------------------
+// Inputs that are not unsigned char RGBA are not composited row by row,
+// the foreground must still be added to the background.
+int TestAddNonUnsignedChar(int size)
+{
+  vtkSmartPointer<vtkImageData> background = CreateFloatLayer(size, 4);
+  vtkSmartPointer<vtkImageData> foreground = CreateFloatLayer(size, 5);
+  vtkSmartPointer<vtkImageData> label = CreateFloatLayer(size, 6);
+
+  vtkSmartPointer<vtkImageData> added = vtkSmartPointer<vtkImageData>::New();
+  added->DeepCopy(background);
+  float* addedPtr = static_cast<float*>(added->GetScalarPointer());
+  float* foregroundPtr = static_cast<float*>(foreground->GetScalarPointer());
+  for (vtkIdType i = 0; i < added->GetNumberOfPoints(); ++i, addedPtr += 4, foregroundPtr += 4)
+    {
+    for (int c = 0; c < 3; ++c)
+      {
+      addedPtr[c] += foregroundPtr[c];
+      }
+    }
+
+  vtkNew<vtkImageBlend> referenceBlend;
+  referenceBlend->AddInputData(added);
+  referenceBlend->AddInputData(label);
+  referenceBlend->SetOpacity(1, 0.3);
+  referenceBlend->Update();
+
+  vtkNew<vtkImageLayerBlend> layerBlend;
+  layerBlend->AddInputData(background);
+  layerBlend->AddInputData(foreground);
+  layerBlend->AddInputData(label);
+  layerBlend->SetOpacity(2, 0.3);
+  layerBlend->SetForegroundCompositingToAdd();
+  layerBlend->Update();
+
+  vtkImageData* output = layerBlend->GetOutput();
+  vtkImageData* reference = referenceBlend->GetOutput();
+  CHECK_INT(output->GetScalarType(), VTK_FLOAT);
+  CHECK_INT(static_cast<int>(output->GetNumberOfPoints()), static_cast<int>(reference->GetNumberOfPoints()));
+  float* outputPtr = static_cast<float*>(output->GetScalarPointer());
+  float* referencePtr = static_cast<float*>(reference->GetScalarPointer());
+  double maximumDifference = 0.0;
+  for (vtkIdType i = 0; i < output->GetNumberOfPoints() * 4; ++i)
+    {
+    maximumDifference = std::max(maximumDifference, static_cast<double>(std::abs(outputPtr[i] - referencePtr[i])));
+    }
+  CHECK_DOUBLE_TOLERANCE(maximumDifference, 0.0, 1e-5);
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+double TimeBlend(vtkImageBlend* blend, vtkImageData* background, int numberOfFrames)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int frame = 0; frame < numberOfFrames; ++frame)
+    {
+    // Force re-execution as if the background slice was resliced
+    background->Modified();
+    blend->Update();
+    }
+  timer->StopTimer();
+  return timer->GetElapsedTime() / numberOfFrames;
+}
+
+//---------------------------------------------------------------------------
+int TestPerformance(vtkImageData* background, vtkImageData* foreground, vtkImageData* label)
+{
+  const int numberOfFrames = 20;
+
+  vtkNew<vtkImageBlend> referenceBlend;
+  vtkNew<vtkImageLayerBlend> layerBlend;
+  vtkImageBlend* blends[2] = { referenceBlend.GetPointer(), layerBlend.GetPointer() };
+  for (int i = 0; i < 2; ++i)
+    {
+    blends[i]->AddInputData(background);
+    blends[i]->AddInputData(foreground);
+    blends[i]->AddInputData(label);
+    blends[i]->SetOpacity(1, 0.5);
+    blends[i]->SetOpacity(2, 0.5);
+    }
+  double referenceTime = TimeBlend(referenceBlend.GetPointer(), background, numberOfFrames);
+  double layerBlendTime = TimeBlend(layerBlend.GetPointer(), background, numberOfFrames);
+
+  int* dimensions = background->GetDimensions();
+  std::cout << dimensions[0] << "x" << dimensions[1] << " 3 layers:"
+            << " vtkImageBlend: " << referenceTime << "s/frame"
+            << " vtkImageLayerBlend: " << layerBlendTime << "s/frame" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkImageLayerBlendTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  const int size = 1024;
+  vtkSmartPointer<vtkImageData> background = CreateLayer(size, 1);
+  vtkSmartPointer<vtkImageData> foreground = CreateLayer(size, 2);
+  vtkSmartPointer<vtkImageData> label = CreateLayer(size, 3);
+
+  CHECK_EXIT_SUCCESS(TestAlphaBlending(background, foreground, label));
+  CHECK_EXIT_SUCCESS(TestAddSubtract(background, foreground, label, false));
+  CHECK_EXIT_SUCCESS(TestAddSubtract(background, foreground, label, true));
+  CHECK_EXIT_SUCCESS(TestAddNonUnsignedChar(64));
+  CHECK_EXIT_SUCCESS(TestPerformance(background, foreground, label));
+  return EXIT_SUCCESS;
+}
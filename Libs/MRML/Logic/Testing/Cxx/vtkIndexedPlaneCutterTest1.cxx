@@ -0,0 +1,188 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkIndexedPlaneCutter.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkAppendFilter.h>
+#include <vtkCellArray.h>
+#include <vtkCutter.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+#include <vtkUnstructuredGrid.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+/// Total length of the line segments of the cut.
+double GetTotalLength(vtkPolyData* polyData)
+{
+  double length = 0.0;
+  vtkCellArray* lines = polyData->GetLines();
+  vtkIdType npts = 0;
+  vtkIdType* pts = nullptr;
+  for (lines->InitTraversal(); lines->GetNextCell(npts, pts);)
+    {
+    for (vtkIdType i = 1; i < npts; ++i)
+      {
+      double point1[3];
+      double point2[3];
+      polyData->GetPoint(pts[i - 1], point1);
+      polyData->GetPoint(pts[i], point2);
+      length += std::sqrt(vtkMath::Distance2BetweenPoints(point1, point2));
+      }
+    }
+  return length;
+}
+
+//---------------------------------------------------------------------------
+/// Cut the mesh at several plane positions, with vtkCutter and with
+/// vtkIndexedPlaneCutter, and compare the cuts.
+int TestCut(vtkPointSet* mesh, double normal[3])
+{
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(normal);
+  vtkNew<vtkCutter> cutter;
+  cutter->SetInputData(mesh);
+  cutter->SetCutFunction(plane.GetPointer());
+  cutter->GenerateCutScalarsOff();
+  vtkNew<vtkIndexedPlaneCutter> indexedCutter;
+  indexedCutter->SetInputData(mesh);
+  indexedCutter->SetPlane(plane.GetPointer());
+
+  for (double offset = -60.0; offset <= 60.0; offset += 7.0)
+    {
+    plane->SetOrigin(offset * normal[0], offset * normal[1], offset * normal[2]);
+    cutter->Update();
+    indexedCutter->Update();
+    vtkPolyData* expected = cutter->GetOutput();
+    vtkPolyData* cut = indexedCutter->GetOutput();
+    CHECK_INT(cut->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    CHECK_INT(cut->GetNumberOfCells(), expected->GetNumberOfCells());
+    if (std::fabs(GetTotalLength(cut) - GetTotalLength(expected)) > 1e-6)
+      {
+      std::cerr << "Line " << __LINE__ << ": cut length mismatch at offset " << offset
+                << ": " << GetTotalLength(cut) << " != " << GetTotalLength(expected) << std::endl;
+      return EXIT_FAILURE;
+      }
+    // Only the cells around the plane are cut
+    CHECK_BOOL(indexedCutter->GetNumberOfCutCells() < mesh->GetNumberOfCells() / 4, true);
+    }
+
+  // Modified mesh is taken into account
+  mesh->GetPoints()->SetPoint(0, 0.0, 0.0, 0.0);
+  mesh->GetPoints()->Modified();
+  plane->SetOrigin(0.0, 0.0, 0.0);
+  cutter->Update();
+  indexedCutter->Update();
+  CHECK_INT(indexedCutter->GetOutput()->GetNumberOfPoints(), cutter->GetOutput()->GetNumberOfPoints());
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateSphere(int resolution)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(50.0);
+  sphere->SetThetaResolution(resolution);
+  sphere->SetPhiResolution(resolution);
+  sphere->Update();
+  return sphere->GetOutput();
+}
+
+//---------------------------------------------------------------------------
+int TestPolyData()
+{
+  double normals[3][3] = { { 0.0, 0.0, 1.0 }, { 1.0, 0.0, 0.0 }, { 0.6, 0.0, 0.8 } };
+  for (int i = 0; i < 3; ++i)
+    {
+    CHECK_EXIT_SUCCESS(TestCut(CreateSphere(60), normals[i]));
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestUnstructuredGrid()
+{
+  vtkNew<vtkAppendFilter> append;
+  append->SetInputData(CreateSphere(60));
+  append->Update();
+  double normal[3] = { 0.0, 0.6, 0.8 };
+  CHECK_EXIT_SUCCESS(TestCut(append->GetOutput(), normal));
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestPerformance()
+{
+  vtkSmartPointer<vtkPolyData> mesh = CreateSphere(1000);
+  vtkNew<vtkPlane> plane;
+  vtkNew<vtkCutter> cutter;
+  cutter->SetInputData(mesh);
+  cutter->SetCutFunction(plane.GetPointer());
+  cutter->GenerateCutScalarsOff();
+  vtkNew<vtkIndexedPlaneCutter> indexedCutter;
+  indexedCutter->SetInputData(mesh);
+  indexedCutter->SetPlane(plane.GetPointer());
+
+  const int numberOfSlices = 20;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int slice = 0; slice < numberOfSlices; ++slice)
+    {
+    plane->SetOrigin(0.0, 0.0, slice - numberOfSlices / 2);
+    cutter->Update();
+    }
+  timer->StopTimer();
+  double cutterFrameRate = numberOfSlices / timer->GetElapsedTime();
+  timer->StartTimer();
+  for (int slice = 0; slice < numberOfSlices; ++slice)
+    {
+    plane->SetOrigin(0.0, 0.0, slice - numberOfSlices / 2);
+    indexedCutter->Update();
+    }
+  timer->StopTimer();
+  double indexedCutterFrameRate = numberOfSlices / timer->GetElapsedTime();
+  std::cout << mesh->GetNumberOfCells() << " cells:"
+            << " vtkCutter: " << cutterFrameRate << " slices/s"
+            << " vtkIndexedPlaneCutter: " << indexedCutterFrameRate << " slices/s" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkIndexedPlaneCutterTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestPolyData());
+  CHECK_EXIT_SUCCESS(TestUnstructuredGrid());
+  CHECK_EXIT_SUCCESS(TestPerformance());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,298 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkImageLabelMapToRGBA.h"
+
+// VTK includes
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkScalarsToColors.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelMapToRGBA);
+vtkCxxSetObjectMacro(vtkImageLabelMapToRGBA, FillLookupTable, vtkScalarsToColors);
+vtkCxxSetObjectMacro(vtkImageLabelMapToRGBA, OutlineLookupTable, vtkScalarsToColors);
+
+namespace
+{
+/// Number of colors above which the labels are not looked up in a
+/// precomputed table.
+const int MaximumNumberOfColors = 1 << 20;
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelMapToRGBA::vtkImageLabelMapToRGBA()
+{
+  this->FillLookupTable = nullptr;
+  this->OutlineLookupTable = nullptr;
+  this->Outline = 1;
+  this->Background = 0.0;
+  this->LabelRange[0] = 0;
+  this->LabelRange[1] = -1;
+  this->FillColors = nullptr;
+  this->OutlineColors = nullptr;
+  this->SetNumberOfOutputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelMapToRGBA::~vtkImageLabelMapToRGBA()
+{
+  this->SetFillLookupTable(nullptr);
+  this->SetOutlineLookupTable(nullptr);
+  delete [] this->FillColors;
+  delete [] this->OutlineColors;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelMapToRGBA::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "FillLookupTable: " << this->FillLookupTable << "\n";
+  os << indent << "OutlineLookupTable: " << this->OutlineLookupTable << "\n";
+  os << indent << "Outline: " << this->Outline << "\n";
+  os << indent << "Background: " << this->Background << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkImageLabelMapToRGBA::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  if (this->FillLookupTable)
+    {
+    mTime = std::max(mTime, this->FillLookupTable->GetMTime());
+    }
+  if (this->OutlineLookupTable)
+    {
+    mTime = std::max(mTime, this->OutlineLookupTable->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkImageLabelMapToRGBA::GetFillOutput()
+{
+  return vtkImageData::SafeDownCast(this->GetOutputDataObject(0));
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkImageLabelMapToRGBA::GetFillOutputPort()
+{
+  return this->GetOutputPort(0);
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkImageLabelMapToRGBA::GetOutlineOutput()
+{
+  return vtkImageData::SafeDownCast(this->GetOutputDataObject(1));
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkImageLabelMapToRGBA::GetOutlineOutputPort()
+{
+  return this->GetOutputPort(1);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelMapToRGBA::RequestInformation(vtkInformation* vtkNotUsed(request),
+                                               vtkInformationVector** vtkNotUsed(inputVector),
+                                               vtkInformationVector* outputVector)
+{
+  for (int port = 0; port < this->GetNumberOfOutputPorts(); ++port)
+    {
+    vtkDataObject::SetPointDataActiveScalarInfo(
+      outputVector->GetInformationObject(port), VTK_UNSIGNED_CHAR, 4);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelMapToRGBA::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
+                                                vtkInformationVector** inputVector,
+                                                vtkInformationVector* outputVector)
+{
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  int wholeExtent[6];
+  int updateExtent[6];
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), updateExtent);
+  // The outline needs the neighbors of the voxels in the XY plane
+  for (int axis = 0; axis < 2; ++axis)
+    {
+    updateExtent[2 * axis] = std::max(updateExtent[2 * axis] - this->Outline, wholeExtent[2 * axis]);
+    updateExtent[2 * axis + 1] = std::min(updateExtent[2 * axis + 1] + this->Outline, wholeExtent[2 * axis + 1]);
+    }
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), updateExtent, 6);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelMapToRGBA::RequestData(vtkInformation* request,
+                                        vtkInformationVector** inputVector,
+                                        vtkInformationVector* outputVector)
+{
+  if (!this->FillLookupTable || !this->OutlineLookupTable)
+    {
+    vtkErrorMacro("RequestData: fill and outline lookup tables are required");
+    return 0;
+    }
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  if (!input || input->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro("RequestData: a single component labelmap is required");
+    return 0;
+    }
+
+  // Look up the colors of all the labels once, the threads only copy them.
+  double* fillRange = this->FillLookupTable->GetRange();
+  double* outlineRange = this->OutlineLookupTable->GetRange();
+  int labelRange[2] =
+    {
+    static_cast<int>(std::floor(std::min(fillRange[0], outlineRange[0]))),
+    static_cast<int>(std::ceil(std::max(fillRange[1], outlineRange[1])))
+    };
+  if (labelRange[1] - labelRange[0] >= MaximumNumberOfColors)
+    {
+    vtkErrorMacro("RequestData: lookup table range [" << labelRange[0] << ", "
+                  << labelRange[1] << "] is too large");
+    return 0;
+    }
+  int numberOfColors = labelRange[1] - labelRange[0] + 1;
+  if (this->LabelRange[1] - this->LabelRange[0] + 1 != numberOfColors)
+    {
+    delete [] this->FillColors;
+    delete [] this->OutlineColors;
+    this->FillColors = new unsigned char[4 * numberOfColors];
+    this->OutlineColors = new unsigned char[4 * (numberOfColors + 1)];
+    }
+  this->LabelRange[0] = labelRange[0];
+  this->LabelRange[1] = labelRange[1];
+  for (int colorIndex = 0; colorIndex < numberOfColors; ++colorIndex)
+    {
+    double label = static_cast<double>(labelRange[0] + colorIndex);
+    memcpy(this->FillColors + 4 * colorIndex, this->FillLookupTable->MapValue(label), 4);
+    memcpy(this->OutlineColors + 4 * colorIndex, this->OutlineLookupTable->MapValue(label), 4);
+    }
+  // Color of the voxels that are not on the outline, stored after the labels
+  memcpy(this->OutlineColors + 4 * numberOfColors, this->OutlineLookupTable->MapValue(this->Background), 4);
+
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageLabelMapToRGBAExecute(vtkImageLabelMapToRGBA* self,
+                                   vtkImageData* inData, const int inWholeExtent[6],
+                                   vtkImageData* fillData, vtkImageData* outlineData,
+                                   const int outExt[6], const int labelRange[2],
+                                   const unsigned char* fillColors,
+                                   const unsigned char* outlineColors,
+                                   int outline, T background, int id)
+{
+  vtkIdType inInc[3];
+  inData->GetIncrements(inInc);
+  const int numberOfColors = labelRange[1] - labelRange[0] + 1;
+  const unsigned char* nonOutlineColor = outlineColors + 4 * numberOfColors;
+
+  unsigned long count = 0;
+  unsigned long target = static_cast<unsigned long>(
+    (outExt[5] - outExt[4] + 1) * (outExt[3] - outExt[2] + 1) / 50.0) + 1;
+
+  for (int z = outExt[4]; z <= outExt[5]; ++z)
+    {
+    for (int y = outExt[2]; !self->AbortExecute && y <= outExt[3]; ++y)
+      {
+      if (id == 0)
+        {
+        if (!(count % target))
+          {
+          self->UpdateProgress(count / (50.0 * target));
+          }
+        count++;
+        }
+      const T* inPtr = static_cast<const T*>(inData->GetScalarPointer(outExt[0], y, z));
+      unsigned char* fillPtr = static_cast<unsigned char*>(fillData->GetScalarPointer(outExt[0], y, z));
+      unsigned char* outlinePtr = static_cast<unsigned char*>(outlineData->GetScalarPointer(outExt[0], y, z));
+      // Neighborhood rows that are in the image
+      int yMin = std::max(y - outline, inWholeExtent[2]);
+      int yMax = std::min(y + outline, inWholeExtent[3]);
+      bool rowsOutside = (y - outline < inWholeExtent[2] || y + outline > inWholeExtent[3]);
+      for (int x = outExt[0]; x <= outExt[1]; ++x, ++inPtr, fillPtr += 4, outlinePtr += 4)
+        {
+        T label = *inPtr;
+        int colorIndex = static_cast<int>(label) - labelRange[0];
+        colorIndex = std::min(std::max(colorIndex, 0), numberOfColors - 1);
+        memcpy(fillPtr, fillColors + 4 * colorIndex, 4);
+
+        // Same rule as vtkImageLabelOutline: a non-background voxel is on
+        // the outline if a neighbor is different or outside of the image.
+        bool isOutline = false;
+        if (outline > 0 && label != background)
+          {
+          int xMin = x - outline;
+          int xMax = x + outline;
+          isOutline = rowsOutside || xMin < inWholeExtent[0] || xMax > inWholeExtent[1];
+          for (int ny = yMin; !isOutline && ny <= yMax; ++ny)
+            {
+            const T* hoodPtr = inPtr + (ny - y) * inInc[1] - outline;
+            for (int nx = xMin; nx <= xMax; ++nx, ++hoodPtr)
+              {
+              if (*hoodPtr != label)
+                {
+                isOutline = true;
+                break;
+                }
+              }
+            }
+          }
+        memcpy(outlinePtr, isOutline ? outlineColors + 4 * colorIndex : nonOutlineColor, 4);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelMapToRGBA::ThreadedRequestData(vtkInformation* vtkNotUsed(request),
+                                                 vtkInformationVector** inputVector,
+                                                 vtkInformationVector* vtkNotUsed(outputVector),
+                                                 vtkImageData*** inData,
+                                                 vtkImageData** outData,
+                                                 int outExt[6], int id)
+{
+  vtkImageData* input = inData[0][0];
+  if (!input || !outData[0] || !outData[1])
+    {
+    return;
+    }
+  int inWholeExtent[6];
+  inputVector[0]->GetInformationObject(0)->Get(
+    vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), inWholeExtent);
+
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(vtkImageLabelMapToRGBAExecute<VTK_TT>(this,
+      input, inWholeExtent, outData[0], outData[1], outExt, this->LabelRange,
+      this->FillColors, this->OutlineColors, this->Outline,
+      static_cast<VTK_TT>(this->Background), id));
+    default:
+      vtkErrorMacro("ThreadedRequestData: unknown input scalar type");
+      return;
+    }
+}
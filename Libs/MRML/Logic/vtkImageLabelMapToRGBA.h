@@ -0,0 +1,112 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageLabelMapToRGBA_h
+#define __vtkImageLabelMapToRGBA_h
+
+#include "vtkMRMLLogicExport.h"
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+class vtkScalarsToColors;
+
+/// \brief Color the fill and the outline of all the labels of a labelmap
+/// in a single pass.
+///
+/// Output 0 is the fill: the color of each voxel label in the
+/// FillLookupTable. Output 1 is the outline: voxels that have a neighbor
+/// with a different label within Outline voxels (in the XY plane) have the
+/// color of their label in the OutlineLookupTable, the other voxels have the
+/// color of the Background label.
+///
+/// This is equivalent to vtkImageMapToRGBA for the fill and
+/// vtkImageLabelOutline followed by vtkImageMapToRGBA for the outline, but
+/// the labelmap is read only once and no intermediate outline image is
+/// created. Both outputs are unsigned char RGBA images.
+class VTK_MRML_LOGIC_EXPORT vtkImageLabelMapToRGBA : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageLabelMapToRGBA *New();
+  vtkTypeMacro(vtkImageLabelMapToRGBA, vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  ///
+  /// Lookup table mapping the labels to the fill colors.
+  /// Labels outside of the table range are clamped.
+  virtual void SetFillLookupTable(vtkScalarsToColors*);
+  vtkGetObjectMacro(FillLookupTable, vtkScalarsToColors);
+
+  ///
+  /// Lookup table mapping the labels to the outline colors.
+  /// Labels outside of the table range are clamped.
+  virtual void SetOutlineLookupTable(vtkScalarsToColors*);
+  vtkGetObjectMacro(OutlineLookupTable, vtkScalarsToColors);
+
+  ///
+  /// Thickness of the outline in voxels. No outline is computed if 0.
+  /// Default is 1.
+  vtkSetClampMacro(Outline, int, 0, 100);
+  vtkGetMacro(Outline, int);
+
+  ///
+  /// Label of the voxels that are not segmented, they are never part of
+  /// the outline. Default is 0.
+  vtkSetMacro(Background, double);
+  vtkGetMacro(Background, double);
+
+  ///
+  /// Output ports.
+  vtkImageData* GetFillOutput();
+  vtkAlgorithmOutput* GetFillOutputPort();
+  vtkImageData* GetOutlineOutput();
+  vtkAlgorithmOutput* GetOutlineOutputPort();
+
+  /// Reimplemented to take into account the lookup tables.
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkImageLabelMapToRGBA();
+  ~vtkImageLabelMapToRGBA() override;
+
+  int RequestInformation(vtkInformation* request,
+                         vtkInformationVector** inputVector,
+                         vtkInformationVector* outputVector) override;
+  int RequestUpdateExtent(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector) override;
+  int RequestData(vtkInformation* request,
+                  vtkInformationVector** inputVector,
+                  vtkInformationVector* outputVector) override;
+  void ThreadedRequestData(vtkInformation* request,
+                           vtkInformationVector** inputVector,
+                           vtkInformationVector* outputVector,
+                           vtkImageData*** inData,
+                           vtkImageData** outData,
+                           int outExt[6], int id) override;
+
+  vtkScalarsToColors* FillLookupTable;
+  vtkScalarsToColors* OutlineLookupTable;
+  int Outline;
+  double Background;
+
+  /// Colors of the labels in [LabelRange[0], LabelRange[1]], computed
+  /// before the threads start.
+  int LabelRange[2];
+  unsigned char* FillColors;
+  unsigned char* OutlineColors;
+
+private:
+  vtkImageLabelMapToRGBA(const vtkImageLabelMapToRGBA&) = delete;
+  void operator=(const vtkImageLabelMapToRGBA&) = delete;
+};
+
+#endif
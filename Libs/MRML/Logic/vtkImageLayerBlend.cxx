@@ -0,0 +1,347 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkImageLayerBlend.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkTypeTraits.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLayerBlend);
+
+//----------------------------------------------------------------------------
+vtkImageLayerBlend::vtkImageLayerBlend()
+{
+  this->ForegroundCompositing = ForegroundCompositingAlpha;
+}
+
+//----------------------------------------------------------------------------
+vtkImageLayerBlend::~vtkImageLayerBlend() = default;
+
+//----------------------------------------------------------------------------
+void vtkImageLayerBlend::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "ForegroundCompositing: " << this->ForegroundCompositing << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageLayerBlend::CanCompositeRows(vtkImageData** inData, int numberOfInputs,
+                                          vtkImageData* outData, int outExt[6])
+{
+  if (numberOfInputs < 1 || this->GetBlendMode() != VTK_IMAGE_BLEND_MODE_NORMAL || this->GetStencil())
+    {
+    return false;
+    }
+  if (outData->GetScalarType() != VTK_UNSIGNED_CHAR || outData->GetNumberOfScalarComponents() != 4)
+    {
+    return false;
+    }
+  for (int inputIndex = 0; inputIndex < numberOfInputs; ++inputIndex)
+    {
+    vtkImageData* input = inData[inputIndex];
+    if (input == nullptr
+      || input->GetScalarType() != VTK_UNSIGNED_CHAR
+      || input->GetNumberOfScalarComponents() != 4)
+      {
+      return false;
+      }
+    // All the layers must cover the region to composite
+    int* inExt = input->GetExtent();
+    if (inExt[0] > outExt[0] || inExt[1] < outExt[1]
+      || inExt[2] > outExt[2] || inExt[3] < outExt[3]
+      || inExt[4] > outExt[4] || inExt[5] < outExt[5])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Blend a row of an RGBA layer over the output row.
+// Same integer arithmetic as vtkImageBlend (normal mode) so that results are
+// identical. The opacity is in the range [0,256].
+static void vtkImageLayerBlendAlphaRow(const unsigned char* inPtr, unsigned char* outPtr,
+                                       int numberOfPixels, unsigned int opacity)
+{
+  for (int i = 0; i < numberOfPixels; ++i)
+    {
+    // r is in the range [0,65280] = range of inPtr[3] * range of opacity
+    unsigned int r = inPtr[3] * opacity;
+    unsigned int f = 65280 - r;
+    outPtr[0] = static_cast<unsigned char>((outPtr[0] * f + inPtr[0] * r) >> 16);
+    outPtr[1] = static_cast<unsigned char>((outPtr[1] * f + inPtr[1] * r) >> 16);
+    outPtr[2] = static_cast<unsigned char>((outPtr[2] * f + inPtr[2] * r) >> 16);
+    inPtr += 4;
+    outPtr += 4;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Add (or subtract) the RGB components of a layer to the output row,
+// clamped to [0,255]. The alpha component of the output is unchanged.
+static void vtkImageLayerBlendAddRow(const unsigned char* inPtr, unsigned char* outPtr,
+                                     int numberOfPixels, bool subtract)
+{
+  if (subtract)
+    {
+    for (int i = 0; i < numberOfPixels * 4; i += 4)
+      {
+      outPtr[i] = static_cast<unsigned char>(std::max(outPtr[i] - inPtr[i], 0));
+      outPtr[i + 1] = static_cast<unsigned char>(std::max(outPtr[i + 1] - inPtr[i + 1], 0));
+      outPtr[i + 2] = static_cast<unsigned char>(std::max(outPtr[i + 2] - inPtr[i + 2], 0));
+      }
+    }
+  else
+    {
+    for (int i = 0; i < numberOfPixels * 4; i += 4)
+      {
+      outPtr[i] = static_cast<unsigned char>(std::min(outPtr[i] + inPtr[i], 255));
+      outPtr[i + 1] = static_cast<unsigned char>(std::min(outPtr[i + 1] + inPtr[i + 1], 255));
+      outPtr[i + 2] = static_cast<unsigned char>(std::min(outPtr[i + 2] + inPtr[i + 2], 255));
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Number of color components of an image with numberOfComponents components
+// (the last component of luminance-alpha and RGBA images is the alpha).
+static int vtkImageLayerBlendNumberOfColorComponents(int numberOfComponents)
+{
+  return (numberOfComponents == 2 || numberOfComponents == 4) ? numberOfComponents - 1 : numberOfComponents;
+}
+
+//----------------------------------------------------------------------------
+// Intersection of the extent of an input with the output extent.
+// Returns false if they do not overlap.
+static bool vtkImageLayerBlendClipExtent(vtkImageData* input, const int outExt[6], int ext[6])
+{
+  int* inExt = input->GetExtent();
+  for (int i = 0; i < 3; ++i)
+    {
+    ext[2 * i] = std::max(inExt[2 * i], outExt[2 * i]);
+    ext[2 * i + 1] = std::min(inExt[2 * i + 1], outExt[2 * i + 1]);
+    if (ext[2 * i] > ext[2 * i + 1])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Add or subtract compositing of layers of any scalar type and number of
+// components, for inputs that the unsigned char RGBA row functions cannot
+// handle. The first input is copied, the second input is added or subtracted
+// (color components only, clamped to the scalar type range) and the other
+// layers are alpha blended as in vtkImageBlend (normal mode). The alpha
+// component of the output is the one of the first input.
+template <class T>
+static void vtkImageLayerBlendGenericExecute(vtkImageData** inData,
+                                             const std::vector<int>& layers,
+                                             const std::vector<double>& opacities,
+                                             bool subtract,
+                                             vtkImageData* outData, int outExt[6])
+{
+  int outC = outData->GetNumberOfScalarComponents();
+  int outColorC = vtkImageLayerBlendNumberOfColorComponents(outC);
+  size_t pixelSize = static_cast<size_t>(outC) * sizeof(T);
+
+  // Alpha range, as in vtkImageBlend
+  double minA = 0.0;
+  double maxA = 1.0;
+  if (outData->GetScalarType() != VTK_FLOAT && outData->GetScalarType() != VTK_DOUBLE)
+    {
+    minA = static_cast<double>(vtkTypeTraits<T>::Min());
+    maxA = static_cast<double>(vtkTypeTraits<T>::Max());
+    }
+  const double typeMin = static_cast<double>(vtkTypeTraits<T>::Min());
+  const double typeMax = static_cast<double>(vtkTypeTraits<T>::Max());
+
+  // Background
+  int ext[6];
+  if (!vtkImageLayerBlendClipExtent(inData[0], outExt, ext)
+    || ext[0] != outExt[0] || ext[1] != outExt[1] || ext[2] != outExt[2]
+    || ext[3] != outExt[3] || ext[4] != outExt[4] || ext[5] != outExt[5])
+    {
+    // the background does not cover the whole region
+    for (int z = outExt[4]; z <= outExt[5]; ++z)
+      {
+      for (int y = outExt[2]; y <= outExt[3]; ++y)
+        {
+        memset(outData->GetScalarPointer(outExt[0], y, z), 0, (outExt[1] - outExt[0] + 1) * pixelSize);
+        }
+      }
+    }
+  if (vtkImageLayerBlendClipExtent(inData[0], outExt, ext))
+    {
+    for (int z = ext[4]; z <= ext[5]; ++z)
+      {
+      for (int y = ext[2]; y <= ext[3]; ++y)
+        {
+        memcpy(outData->GetScalarPointer(ext[0], y, z), inData[0]->GetScalarPointer(ext[0], y, z),
+               (ext[1] - ext[0] + 1) * pixelSize);
+        }
+      }
+    }
+
+  for (size_t layerIndex = 0; layerIndex < layers.size(); ++layerIndex)
+    {
+    int inputIndex = layers[layerIndex];
+    vtkImageData* input = inData[inputIndex];
+    if (!vtkImageLayerBlendClipExtent(input, outExt, ext))
+      {
+      continue;
+      }
+    int inC = input->GetNumberOfScalarComponents();
+    int inColorC = vtkImageLayerBlendNumberOfColorComponents(inC);
+    bool inAlpha = (inC != inColorC);
+    bool combinedWithBackground = (inputIndex == 1);
+    for (int z = ext[4]; z <= ext[5]; ++z)
+      {
+      for (int y = ext[2]; y <= ext[3]; ++y)
+        {
+        const T* inPtr = static_cast<const T*>(input->GetScalarPointer(ext[0], y, z));
+        T* outPtr = static_cast<T*>(outData->GetScalarPointer(ext[0], y, z));
+        for (int x = ext[0]; x <= ext[1]; ++x, inPtr += inC, outPtr += outC)
+          {
+          if (combinedWithBackground)
+            {
+            for (int c = 0; c < outColorC; ++c)
+              {
+              double inValue = static_cast<double>(inPtr[std::min(c, inColorC - 1)]);
+              double value = static_cast<double>(outPtr[c]) + (subtract ? -inValue : inValue);
+              outPtr[c] = static_cast<T>(std::min(std::max(value, typeMin), typeMax));
+              }
+            continue;
+            }
+          double r = opacities[layerIndex];
+          if (inAlpha)
+            {
+            r *= (static_cast<double>(inPtr[inC - 1]) - minA) / (maxA - minA);
+            }
+          double f = 1.0 - r;
+          for (int c = 0; c < outColorC; ++c)
+            {
+            outPtr[c] = static_cast<T>(outPtr[c] * f + inPtr[std::min(c, inColorC - 1)] * r);
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLayerBlend::ThreadedRequestData(vtkInformation* request,
+                                             vtkInformationVector** inputVector,
+                                             vtkInformationVector* outputVector,
+                                             vtkImageData*** inData,
+                                             vtkImageData** outData,
+                                             int outExt[6], int id)
+{
+  int numberOfInputs = this->GetNumberOfInputConnections(0);
+  bool addSubtract = (this->ForegroundCompositing != ForegroundCompositingAlpha);
+  bool compositeRows = this->CanCompositeRows(inData[0], numberOfInputs, outData[0], outExt);
+  if (!compositeRows && !addSubtract)
+    {
+    // vtkImageBlend supports all the blend modes, stencil and input types
+    this->Superclass::ThreadedRequestData(request, inputVector, outputVector, inData, outData, outExt, id);
+    return;
+    }
+
+  // Layers that are not visible are skipped.
+  std::vector<int> layers;
+  std::vector<double> opacities;
+  for (int inputIndex = 1; inputIndex < numberOfInputs; ++inputIndex)
+    {
+    if (inData[0][inputIndex] == nullptr)
+      {
+      continue;
+      }
+    bool combinedWithBackground = (inputIndex == 1 && addSubtract);
+    double opacity = combinedWithBackground ? 1.0 : this->GetOpacity(inputIndex);
+    if (opacity <= 0.0)
+      {
+      continue;
+      }
+    layers.push_back(inputIndex);
+    opacities.push_back(std::min(opacity, 1.0));
+    }
+
+  if (!compositeRows)
+    {
+    // Add or subtract compositing of inputs that are not unsigned char RGBA
+    if (numberOfInputs < 1 || inData[0][0] == nullptr)
+      {
+      return;
+      }
+    for (int inputIndex = 0; inputIndex < numberOfInputs; ++inputIndex)
+      {
+      if (inData[0][inputIndex] != nullptr
+        && inData[0][inputIndex]->GetScalarType() != outData[0]->GetScalarType())
+        {
+        vtkErrorMacro("ThreadedRequestData: scalar type of input " << inputIndex
+          << " does not match the output scalar type");
+        return;
+        }
+      }
+    switch (outData[0]->GetScalarType())
+      {
+      vtkTemplateMacro(vtkImageLayerBlendGenericExecute<VTK_TT>(inData[0], layers, opacities,
+        this->ForegroundCompositing == ForegroundCompositingSubtract, outData[0], outExt));
+      default:
+        vtkErrorMacro("ThreadedRequestData: unknown output scalar type");
+        return;
+      }
+    return;
+    }
+
+  // Opacity of each layer, rounded to [0,256] as in vtkImageBlend.
+  std::vector<unsigned int> rowOpacities;
+  for (size_t layerIndex = 0; layerIndex < opacities.size(); ++layerIndex)
+    {
+    rowOpacities.push_back(static_cast<unsigned int>(256 * opacities[layerIndex] + 0.5));
+    }
+
+  int numberOfPixels = outExt[1] - outExt[0] + 1;
+  size_t rowSize = static_cast<size_t>(numberOfPixels) * 4;
+  for (int z = outExt[4]; z <= outExt[5]; ++z)
+    {
+    for (int y = outExt[2]; y <= outExt[3]; ++y)
+      {
+      unsigned char* outPtr = static_cast<unsigned char*>(outData[0]->GetScalarPointer(outExt[0], y, z));
+      memcpy(outPtr, inData[0][0]->GetScalarPointer(outExt[0], y, z), rowSize);
+      for (size_t layerIndex = 0; layerIndex < layers.size(); ++layerIndex)
+        {
+        int inputIndex = layers[layerIndex];
+        const unsigned char* inPtr = static_cast<const unsigned char*>(
+          inData[0][inputIndex]->GetScalarPointer(outExt[0], y, z));
+        if (inputIndex == 1 && this->ForegroundCompositing != ForegroundCompositingAlpha)
+          {
+          vtkImageLayerBlendAddRow(inPtr, outPtr, numberOfPixels,
+            this->ForegroundCompositing == ForegroundCompositingSubtract);
+          }
+        else
+          {
+          vtkImageLayerBlendAlphaRow(inPtr, outPtr, numberOfPixels, rowOpacities[layerIndex]);
+          }
+        }
+      }
+    }
+}
@@ -0,0 +1,83 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageLayerBlend_h
+#define __vtkImageLayerBlend_h
+
+#include "vtkMRMLLogicExport.h"
+
+// VTK includes
+#include <vtkImageBlend.h>
+
+/// \brief Blend the layers of a slice view in a single pass.
+///
+/// Used by vtkMRMLSliceLogic to composite the background, foreground and
+/// label layers. The first input is the background, the second input is
+/// combined with it using the ForegroundCompositing mode (alpha blending,
+/// addition or subtraction of the RGB components), the following inputs
+/// are alpha blended on top of the result.
+///
+/// When all the inputs are unsigned char RGBA images (the output of the
+/// slice layers), the layers are composited row by row directly into the
+/// output, without any intermediate image, and the result is the same as
+/// vtkImageBlend for alpha blending. Other inputs are processed by
+/// vtkImageBlend in Alpha mode, and by a generic implementation for any
+/// scalar type and number of components in Add and Subtract modes (the
+/// other layers are then alpha blended as in vtkImageBlend normal mode).
+class VTK_MRML_LOGIC_EXPORT vtkImageLayerBlend : public vtkImageBlend
+{
+public:
+  static vtkImageLayerBlend *New();
+  vtkTypeMacro(vtkImageLayerBlend, vtkImageBlend);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum
+    {
+    ForegroundCompositingAlpha = 0,
+    ForegroundCompositingAdd,
+    ForegroundCompositingSubtract
+    };
+
+  ///
+  /// Compositing of the second input with the first input.
+  /// In Add and Subtract modes, the opacity of the second input is ignored,
+  /// color components are clamped to the range of the scalar type and the
+  /// alpha component of the output is the one of the first input.
+  /// Default is ForegroundCompositingAlpha.
+  vtkSetClampMacro(ForegroundCompositing, int, ForegroundCompositingAlpha, ForegroundCompositingSubtract);
+  vtkGetMacro(ForegroundCompositing, int);
+  void SetForegroundCompositingToAlpha() {this->SetForegroundCompositing(ForegroundCompositingAlpha);};
+  void SetForegroundCompositingToAdd() {this->SetForegroundCompositing(ForegroundCompositingAdd);};
+  void SetForegroundCompositingToSubtract() {this->SetForegroundCompositing(ForegroundCompositingSubtract);};
+
+protected:
+  vtkImageLayerBlend();
+  ~vtkImageLayerBlend() override;
+
+  void ThreadedRequestData(vtkInformation* request,
+                           vtkInformationVector** inputVector,
+                           vtkInformationVector* outputVector,
+                           vtkImageData*** inData,
+                           vtkImageData** outData,
+                           int outExt[6], int id) override;
+
+  /// Returns true if the inputs can be composited row by row.
+  bool CanCompositeRows(vtkImageData** inData, int numberOfInputs,
+                        vtkImageData* outData, int outExt[6]);
+
+  int ForegroundCompositing;
+
+private:
+  vtkImageLayerBlend(const vtkImageLayerBlend&) = delete;
+  void operator=(const vtkImageLayerBlend&) = delete;
+};
+
+#endif
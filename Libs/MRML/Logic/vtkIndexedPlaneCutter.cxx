@@ -0,0 +1,402 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkIndexedPlaneCutter.h"
+
+// VTK includes
+#include <vtkCellData.h>
+#include <vtkCutter.h>
+#include <vtkIdList.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPlane.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkIndexedPlaneCutter);
+vtkCxxSetObjectMacro(vtkIndexedPlaneCutter, Plane, vtkPlane);
+
+namespace
+{
+/// Number of consecutive sorted cells whose maximum distance is stored,
+/// blocks that end before the plane are skipped.
+const vtkIdType BlockSize = 64;
+
+//----------------------------------------------------------------------------
+/// Round to float so that the interval of the cell is not shrunk.
+float RoundDown(double value)
+{
+  float rounded = static_cast<float>(value);
+  return (rounded > value ? std::nextafter(rounded, -std::numeric_limits<float>::max()) : rounded);
+}
+
+//----------------------------------------------------------------------------
+float RoundUp(double value)
+{
+  float rounded = static_cast<float>(value);
+  return (rounded < value ? std::nextafter(rounded, std::numeric_limits<float>::max()) : rounded);
+}
+}
+
+//----------------------------------------------------------------------------
+class vtkIndexedPlaneCutter::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Compute the extent of each cell along the normal.
+  void BuildIndex(vtkPointSet* mesh, const double normal[3]);
+  bool IsIndexUpToDate(vtkPointSet* mesh, const double normal[3]);
+  /// Sort the cells by their minimum distance.
+  void SortIndex();
+  /// Get the cells that may cross the plane at the given distance along the normal.
+  void FindCells(double offset, std::vector<vtkIdType>& cellIds);
+  /// Copy the given cells and the points they use into a new mesh.
+  vtkPointSet* ExtractCells(vtkPointSet* mesh, const std::vector<vtkIdType>& cellIds);
+
+  vtkWeakPointer<vtkPointSet> IndexedMesh;
+  vtkTimeStamp IndexTime;
+  double IndexNormal[3];
+
+  /// Minimum and maximum distance of the cells along the normal.
+  /// Indexed by cell id, or by sorted position if SortedCellIds is not empty.
+  std::vector<float> CellMinimum;
+  std::vector<float> CellMaximum;
+  std::vector<vtkIdType> SortedCellIds;
+  std::vector<float> BlockMaximum;
+
+  /// Index of each mesh point in the extracted mesh, -1 if not extracted.
+  std::vector<vtkIdType> PointMap;
+  std::vector<vtkIdType> ExtractedPointIds;
+
+  vtkNew<vtkIdList> CellPointIds;
+  vtkNew<vtkIdList> ExtractedCellPointIds;
+  vtkNew<vtkPolyData> ExtractedPolyData;
+  vtkNew<vtkUnstructuredGrid> ExtractedGrid;
+  vtkNew<vtkCutter> Cutter;
+};
+
+//----------------------------------------------------------------------------
+vtkIndexedPlaneCutter::vtkInternal::vtkInternal()
+{
+  this->IndexNormal[0] = 0.0;
+  this->IndexNormal[1] = 0.0;
+  this->IndexNormal[2] = 0.0;
+  this->Cutter->GenerateCutScalarsOff();
+}
+
+//----------------------------------------------------------------------------
+bool vtkIndexedPlaneCutter::vtkInternal::IsIndexUpToDate(vtkPointSet* mesh, const double normal[3])
+{
+  return this->IndexedMesh.GetPointer() == mesh
+    && mesh->GetMTime() <= this->IndexTime.GetMTime()
+    && this->IndexNormal[0] == normal[0]
+    && this->IndexNormal[1] == normal[1]
+    && this->IndexNormal[2] == normal[2];
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::vtkInternal::BuildIndex(vtkPointSet* mesh, const double normal[3])
+{
+  vtkIdType numberOfPoints = mesh->GetNumberOfPoints();
+  vtkIdType numberOfCells = mesh->GetNumberOfCells();
+  vtkPoints* points = mesh->GetPoints();
+
+  std::vector<double> pointDistances(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+    {
+    double point[3];
+    points->GetPoint(pointId, point);
+    pointDistances[pointId] = vtkMath::Dot(point, normal);
+    }
+
+  this->CellMinimum.resize(numberOfCells);
+  this->CellMaximum.resize(numberOfCells);
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    mesh->GetCellPoints(cellId, this->CellPointIds);
+    vtkIdType numberOfCellPoints = this->CellPointIds->GetNumberOfIds();
+    if (numberOfCellPoints == 0)
+      {
+      // empty cell, never cut
+      this->CellMinimum[cellId] = std::numeric_limits<float>::max();
+      this->CellMaximum[cellId] = -std::numeric_limits<float>::max();
+      continue;
+      }
+    double minimum = VTK_DOUBLE_MAX;
+    double maximum = VTK_DOUBLE_MIN;
+    for (vtkIdType i = 0; i < numberOfCellPoints; ++i)
+      {
+      double distance = pointDistances[this->CellPointIds->GetId(i)];
+      minimum = std::min(minimum, distance);
+      maximum = std::max(maximum, distance);
+      }
+    this->CellMinimum[cellId] = RoundDown(minimum);
+    this->CellMaximum[cellId] = RoundUp(maximum);
+    }
+  this->SortedCellIds.clear();
+  this->BlockMaximum.clear();
+  this->PointMap.assign(numberOfPoints, -1);
+
+  this->IndexedMesh = mesh;
+  this->IndexNormal[0] = normal[0];
+  this->IndexNormal[1] = normal[1];
+  this->IndexNormal[2] = normal[2];
+  this->IndexTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::vtkInternal::SortIndex()
+{
+  vtkIdType numberOfCells = static_cast<vtkIdType>(this->CellMinimum.size());
+  this->SortedCellIds.resize(numberOfCells);
+  for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+    {
+    this->SortedCellIds[cellId] = cellId;
+    }
+  const std::vector<float>& cellMinimum = this->CellMinimum;
+  std::sort(this->SortedCellIds.begin(), this->SortedCellIds.end(),
+    [&cellMinimum](vtkIdType a, vtkIdType b) { return cellMinimum[a] < cellMinimum[b]; });
+
+  std::vector<float> sortedMinimum(numberOfCells);
+  std::vector<float> sortedMaximum(numberOfCells);
+  this->BlockMaximum.assign((numberOfCells + BlockSize - 1) / BlockSize, -std::numeric_limits<float>::max());
+  for (vtkIdType i = 0; i < numberOfCells; ++i)
+    {
+    vtkIdType cellId = this->SortedCellIds[i];
+    sortedMinimum[i] = this->CellMinimum[cellId];
+    sortedMaximum[i] = this->CellMaximum[cellId];
+    float& blockMaximum = this->BlockMaximum[i / BlockSize];
+    blockMaximum = std::max(blockMaximum, sortedMaximum[i]);
+    }
+  this->CellMinimum.swap(sortedMinimum);
+  this->CellMaximum.swap(sortedMaximum);
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::vtkInternal::FindCells(double offset, std::vector<vtkIdType>& cellIds)
+{
+  cellIds.clear();
+  if (this->SortedCellIds.empty())
+    {
+    vtkIdType numberOfCells = static_cast<vtkIdType>(this->CellMinimum.size());
+    for (vtkIdType cellId = 0; cellId < numberOfCells; ++cellId)
+      {
+      if (this->CellMinimum[cellId] <= offset && this->CellMaximum[cellId] >= offset)
+        {
+        cellIds.push_back(cellId);
+        }
+      }
+    return;
+    }
+
+  // Only the cells that start before the plane may cross it
+  vtkIdType numberOfCandidates = static_cast<vtkIdType>(
+    std::upper_bound(this->CellMinimum.begin(), this->CellMinimum.end(), offset) - this->CellMinimum.begin());
+  for (vtkIdType blockStart = 0; blockStart < numberOfCandidates; blockStart += BlockSize)
+    {
+    if (this->BlockMaximum[blockStart / BlockSize] < offset)
+      {
+      continue;
+      }
+    vtkIdType blockEnd = std::min(blockStart + BlockSize, numberOfCandidates);
+    for (vtkIdType i = blockStart; i < blockEnd; ++i)
+      {
+      if (this->CellMaximum[i] >= offset)
+        {
+        cellIds.push_back(this->SortedCellIds[i]);
+        }
+      }
+    }
+  // Visit the mesh in order when extracting the cells
+  std::sort(cellIds.begin(), cellIds.end());
+}
+
+//----------------------------------------------------------------------------
+vtkPointSet* vtkIndexedPlaneCutter::vtkInternal::ExtractCells(vtkPointSet* mesh, const std::vector<vtkIdType>& cellIds)
+{
+  vtkPolyData* meshPolyData = vtkPolyData::SafeDownCast(mesh);
+  vtkPointSet* extracted = nullptr;
+  vtkIdType numberOfCells = static_cast<vtkIdType>(cellIds.size());
+  if (meshPolyData)
+    {
+    this->ExtractedPolyData->Initialize();
+    this->ExtractedPolyData->Allocate(numberOfCells);
+    extracted = this->ExtractedPolyData.GetPointer();
+    }
+  else
+    {
+    this->ExtractedGrid->Initialize();
+    this->ExtractedGrid->Allocate(numberOfCells);
+    extracted = this->ExtractedGrid.GetPointer();
+    }
+
+  vtkPoints* meshPoints = mesh->GetPoints();
+  vtkNew<vtkPoints> extractedPoints;
+  extractedPoints->SetDataType(meshPoints->GetDataType());
+  extractedPoints->Allocate(3 * numberOfCells);
+  vtkPointData* meshPointData = mesh->GetPointData();
+  vtkPointData* extractedPointData = extracted->GetPointData();
+  extractedPointData->CopyAllocate(meshPointData, 3 * numberOfCells);
+  vtkCellData* meshCellData = mesh->GetCellData();
+  vtkCellData* extractedCellData = extracted->GetCellData();
+  extractedCellData->CopyAllocate(meshCellData, numberOfCells);
+
+  for (std::vector<vtkIdType>::const_iterator cellIt = cellIds.begin(); cellIt != cellIds.end(); ++cellIt)
+    {
+    int cellType = mesh->GetCellType(*cellIt);
+    mesh->GetCellPoints(*cellIt, this->CellPointIds);
+    vtkIdType numberOfCellPoints = this->CellPointIds->GetNumberOfIds();
+    this->ExtractedCellPointIds->SetNumberOfIds(numberOfCellPoints);
+    for (vtkIdType i = 0; i < numberOfCellPoints; ++i)
+      {
+      vtkIdType pointId = this->CellPointIds->GetId(i);
+      vtkIdType& extractedPointId = this->PointMap[pointId];
+      if (extractedPointId < 0)
+        {
+        extractedPointId = extractedPoints->InsertNextPoint(meshPoints->GetPoint(pointId));
+        extractedPointData->CopyData(meshPointData, pointId, extractedPointId);
+        this->ExtractedPointIds.push_back(pointId);
+        }
+      this->ExtractedCellPointIds->SetId(i, extractedPointId);
+      }
+    vtkIdType extractedCellId = (meshPolyData
+      ? this->ExtractedPolyData->InsertNextCell(cellType, this->ExtractedCellPointIds)
+      : this->ExtractedGrid->InsertNextCell(cellType, this->ExtractedCellPointIds));
+    extractedCellData->CopyData(meshCellData, *cellIt, extractedCellId);
+    }
+  extracted->SetPoints(extractedPoints);
+
+  // Reset only the entries that were set, the map is reused for the next cut
+  for (std::vector<vtkIdType>::iterator pointIt = this->ExtractedPointIds.begin();
+    pointIt != this->ExtractedPointIds.end(); ++pointIt)
+    {
+    this->PointMap[*pointIt] = -1;
+    }
+  this->ExtractedPointIds.clear();
+  return extracted;
+}
+
+//----------------------------------------------------------------------------
+vtkIndexedPlaneCutter::vtkIndexedPlaneCutter()
+{
+  this->Plane = nullptr;
+  this->NumberOfCutCells = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkIndexedPlaneCutter::~vtkIndexedPlaneCutter()
+{
+  this->SetPlane(nullptr);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Plane: " << this->Plane << "\n";
+  os << indent << "NumberOfCutCells: " << this->NumberOfCutCells << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkIndexedPlaneCutter::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  if (this->Plane)
+    {
+    mTime = std::max(mTime, this->Plane->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkIndexedPlaneCutter::FillInputPortInformation(int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkPointSet");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkIndexedPlaneCutter::RequestData(vtkInformation* vtkNotUsed(request),
+                                       vtkInformationVector** inputVector,
+                                       vtkInformationVector* outputVector)
+{
+  vtkPointSet* input = vtkPointSet::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+  this->NumberOfCutCells = 0;
+  if (!this->Plane)
+    {
+    vtkErrorMacro("RequestData: plane is required");
+    return 0;
+    }
+  if (!input || !input->GetPoints() || input->GetNumberOfCells() == 0)
+    {
+    // nothing to cut
+    return 1;
+    }
+
+  double normal[3];
+  double origin[3];
+  this->Plane->GetNormal(normal);
+  this->Plane->GetOrigin(origin);
+  vtkUnstructuredGrid* inputGrid = vtkUnstructuredGrid::SafeDownCast(input);
+  vtkInternal* internal = this->Internal;
+  if (vtkMath::Normalize(normal) == 0.0 || (inputGrid && inputGrid->GetFaces()))
+    {
+    // Polyhedral cells cannot be extracted by their point ids
+    internal->Cutter->SetInputData(input);
+    this->NumberOfCutCells = input->GetNumberOfCells();
+    }
+  else
+    {
+    if (!internal->IsIndexUpToDate(input, normal))
+      {
+      internal->BuildIndex(input, normal);
+      }
+    else if (internal->SortedCellIds.empty())
+      {
+      // Same normal is used again, it is worth sorting the cells
+      internal->SortIndex();
+      }
+    std::vector<vtkIdType> cellIds;
+    internal->FindCells(vtkMath::Dot(normal, origin), cellIds);
+    this->NumberOfCutCells = static_cast<vtkIdType>(cellIds.size());
+    if (cellIds.empty())
+      {
+      return 1;
+      }
+    internal->Cutter->SetInputData(internal->ExtractCells(input, cellIds));
+    }
+
+  internal->Cutter->SetCutFunction(this->Plane);
+  internal->Cutter->Update();
+  output->ShallowCopy(internal->Cutter->GetOutput());
+  // Do not keep a reference to the input
+  internal->Cutter->SetInputData(nullptr);
+  return 1;
+}
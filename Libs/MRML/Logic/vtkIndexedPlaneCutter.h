@@ -0,0 +1,75 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkIndexedPlaneCutter_h
+#define __vtkIndexedPlaneCutter_h
+
+#include "vtkMRMLLogicExport.h"
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+
+class vtkPlane;
+
+/// \brief Cut a mesh with a plane, visiting only the cells that cross the plane.
+///
+/// The extent of each cell along the plane normal is computed and cached.
+/// When only the plane origin changes (for example when scrolling through
+/// slices), the cells that cross the plane are found in the sorted cell extents
+/// and only those cells are passed to vtkCutter. The cache is rebuilt when the
+/// input mesh or the plane normal changes.
+///
+/// The first cut with a new normal scans all the cell extents, the sorted index
+/// is only built when the same normal is used again, so that continuously
+/// rotated planes are not slower than cutting the full mesh.
+///
+/// The output is the same as the output of vtkCutter with the same plane,
+/// except for the order of points and cells.
+class VTK_MRML_LOGIC_EXPORT vtkIndexedPlaneCutter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkIndexedPlaneCutter *New();
+  vtkTypeMacro(vtkIndexedPlaneCutter, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  ///
+  /// Plane used for cutting the input.
+  virtual void SetPlane(vtkPlane*);
+  vtkGetObjectMacro(Plane, vtkPlane);
+
+  ///
+  /// Number of cells that were cut in the last execution.
+  vtkGetMacro(NumberOfCutCells, vtkIdType);
+
+  /// Reimplemented to take into account the plane.
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkIndexedPlaneCutter();
+  ~vtkIndexedPlaneCutter() override;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation* request,
+                  vtkInformationVector** inputVector,
+                  vtkInformationVector* outputVector) override;
+
+  vtkPlane* Plane;
+  vtkIdType NumberOfCutCells;
+
+private:
+  vtkIndexedPlaneCutter(const vtkIndexedPlaneCutter&) = delete;
+  void operator=(const vtkIndexedPlaneCutter&) = delete;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
@@ -518,7 +518,18 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
       {
       vtkNew<vtkGeneralTransform> worldTransform;
       worldTransform->Identity();
-      transformNode->GetTransformFromWorld(worldTransform.GetPointer());
+      if (transformNode->GetConsolidatedTransformCaching())
+        {
+        // Reslicing evaluates the transform at each slice pixel, use the
+        // whole transform chain consolidated into a grid over the volume.
+        double bounds_World[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+        this->VolumeNode->GetRASBounds(bounds_World);
+        transformNode->GetConsolidatedTransformFromWorld(worldTransform.GetPointer(), bounds_World);
+        }
+      else
+        {
+        transformNode->GetTransformFromWorld(worldTransform.GetPointer());
+        }
       //worldTransform->Inverse();
 
       this->XYToIJKTransform->Concatenate(worldTransform.GetPointer());
@@ -13,6 +13,7 @@
 =========================================================================auto=*/
 
 // MRMLLogic includes
+#include "vtkImageLayerBlend.h"
 #include "vtkMRMLSliceLogic.h"
 #include "vtkMRMLSliceLayerLogic.h"
 
@@ -32,12 +33,9 @@
 #include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
-#include <vtkImageAppendComponents.h>
 #include <vtkImageBlend.h>
 #include <vtkImageResample.h>
-#include <vtkImageCast.h>
 #include <vtkImageData.h>
-#include <vtkImageMathematics.h>
 #include <vtkImageReslice.h>
 #include <vtkImageThreshold.h>
 #include <vtkInformation.h>
@@ -89,41 +87,18 @@ struct BlendPipeline
     //
     // Add, Subtract:
     //
-    //   Casting is needed to avoid overflow during adding (or subtracting).
+    //   Blend adds/subtracts the RGB components of the foreground to/from the
+    //   background and keeps the background's alpha channel, in the same pass
+    //   as the alpha blending of the label layer.
     //
-    //   AddSubMath adds/subtracts alpha channel, therefore we copy RGB and alpha
-    //   components and copy of the background's alpha channel to the output.
-    //   Splitting and appending channels is probably quite inefficient, but there does not
-    //   seem to be simpler pipeline to do this in VTK.
-    //
-    //   foreground > AddSubForegroundCast \
-    //                                      > AddSubMath > AddSubOutputCast ...
-    //   background > AddSubBackroundCast  /
-    //
-    //
-    //     ... AddSubOutputCast > AddSubExtractRGB \
-    //                                              > AddSubAppendRGBA > Blend
-    //             background > AddSubExtractAlpha /
+    //   foreground \
+    //               > Blend (ForegroundCompositing = Add or Subtract)
+    //   background /
     */
-
-    this->AddSubForegroundCast->SetOutputScalarTypeToShort();
-    this->AddSubBackgroundCast->SetOutputScalarTypeToShort();
-    this->AddSubMath->SetOperationToAdd();
-    this->AddSubMath->SetInputConnection(0, this->AddSubBackgroundCast->GetOutputPort());
-    this->AddSubMath->SetInputConnection(1, this->AddSubForegroundCast->GetOutputPort());
-    this->AddSubOutputCast->SetInputConnection(this->AddSubMath->GetOutputPort());
-
-    this->AddSubExtractRGB->SetInputConnection(this->AddSubOutputCast->GetOutputPort());
-    this->AddSubExtractRGB->SetComponents(0, 1, 2);
-    this->AddSubExtractAlpha->SetComponents(3);
-    this->AddSubAppendRGBA->AddInputConnection(this->AddSubExtractRGB->GetOutputPort());
-    this->AddSubAppendRGBA->AddInputConnection(this->AddSubExtractAlpha->GetOutputPort());
-
-    this->AddSubOutputCast->SetOutputScalarTypeToUnsignedChar();
-    this->AddSubOutputCast->ClampOverflowOn();
   }
 
-  void AddLayers(std::deque<SliceLayerInfo>& layers, int sliceCompositing,
+  /// Returns true if the compositing mode of the blend filter has changed.
+  bool AddLayers(std::deque<SliceLayerInfo>& layers, int sliceCompositing,
     vtkAlgorithmOutput* backgroundImagePort,
     vtkAlgorithmOutput* foregroundImagePort, double foregroundOpacity,
     vtkAlgorithmOutput* labelImagePort, double labelOpacity)
@@ -137,8 +112,10 @@ struct BlendPipeline
         }
       }
 
+    vtkMTimeType oldBlendMTime = this->Blend->GetMTime();
     if (sliceCompositing == vtkMRMLSliceCompositeNode::Alpha)
       {
+      this->Blend->SetForegroundCompositingToAlpha();
       if (backgroundImagePort)
         {
         layers.push_back(SliceLayerInfo(backgroundImagePort, 1.0));
@@ -150,6 +127,7 @@ struct BlendPipeline
       }
     else if (sliceCompositing == vtkMRMLSliceCompositeNode::ReverseAlpha)
       {
+      this->Blend->SetForegroundCompositingToAlpha();
       if (foregroundImagePort)
         {
         layers.push_back(SliceLayerInfo(foregroundImagePort, 1.0));
@@ -161,18 +139,16 @@ struct BlendPipeline
       }
     else
       {
-      this->AddSubForegroundCast->SetInputConnection(foregroundImagePort);
-      this->AddSubBackgroundCast->SetInputConnection(backgroundImagePort);
-      this->AddSubExtractAlpha->SetInputConnection(backgroundImagePort);
       if (sliceCompositing == vtkMRMLSliceCompositeNode::Add)
         {
-        this->AddSubMath->SetOperationToAdd();
+        this->Blend->SetForegroundCompositingToAdd();
         }
       else
         {
-        this->AddSubMath->SetOperationToSubtract();
+        this->Blend->SetForegroundCompositingToSubtract();
         }
-      layers.push_back(SliceLayerInfo(this->AddSubAppendRGBA->GetOutputPort(), 1.0));
+      layers.push_back(SliceLayerInfo(backgroundImagePort, 1.0));
+      layers.push_back(SliceLayerInfo(foregroundImagePort, 1.0));
       }
 
     // always blending the label layer
@@ -180,16 +156,10 @@ struct BlendPipeline
       {
       layers.push_back(SliceLayerInfo(labelImagePort, labelOpacity));
       }
+    return this->Blend->GetMTime() > oldBlendMTime;
   }
 
-  vtkNew<vtkImageCast> AddSubForegroundCast;
-  vtkNew<vtkImageCast> AddSubBackgroundCast;
-  vtkNew<vtkImageMathematics> AddSubMath;
-  vtkNew<vtkImageExtractComponents> AddSubExtractRGB;
-  vtkNew<vtkImageExtractComponents> AddSubExtractAlpha;
-  vtkNew<vtkImageAppendComponents> AddSubAppendRGBA;
-  vtkNew<vtkImageCast> AddSubOutputCast;
-  vtkNew<vtkImageBlend> Blend;
+  vtkNew<vtkImageLayerBlend> Blend;
 };
 
 //----------------------------------------------------------------------------
@@ -1095,12 +1065,18 @@ void vtkMRMLSliceLogic::UpdatePipeline()
     std::deque<SliceLayerInfo> layers;
     std::deque<SliceLayerInfo> layersUVW;
 
-    this->Pipeline->AddLayers(layers, this->SliceCompositeNode->GetCompositing(),
+    if (this->Pipeline->AddLayers(layers, this->SliceCompositeNode->GetCompositing(),
       backgroundImagePort, foregroundImagePort, this->SliceCompositeNode->GetForegroundOpacity(),
-      labelImagePort, this->SliceCompositeNode->GetLabelOpacity());
-    this->PipelineUVW->AddLayers(layersUVW, this->SliceCompositeNode->GetCompositing(),
+      labelImagePort, this->SliceCompositeNode->GetLabelOpacity()))
+      {
+      modified = 1;
+      }
+    if (this->PipelineUVW->AddLayers(layersUVW, this->SliceCompositeNode->GetCompositing(),
       backgroundImagePortUVW, foregroundImagePortUVW, this->SliceCompositeNode->GetForegroundOpacity(),
-      labelImagePortUVW, this->SliceCompositeNode->GetLabelOpacity());
+      labelImagePortUVW, this->SliceCompositeNode->GetLabelOpacity()))
+      {
+      modified = 1;
+      }
 
     if (this->UpdateBlendLayers(this->Pipeline->Blend.GetPointer(), layers))
       {
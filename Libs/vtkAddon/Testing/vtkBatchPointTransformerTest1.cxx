@@ -0,0 +1,230 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkBatchPointTransformer.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+
+// VTK includes
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkThinPlateSplineTransform.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Grid with a smooth sinusoidal displacement and an oblique axis direction.
+template <class T>
+vtkSmartPointer<vtkImageData> CreateDisplacementGrid(int scalarType, vtkMatrix4x4* directionMatrix)
+{
+  const int dimension = 21;
+  const double spacing = 10.0;
+  double direction[3][3] = { { 0.92128500, -0.36017075, -0.146666625 },
+                             { 0.31722386, 0.91417248, -0.25230478 },
+                             { 0.22495105, 0.18591857, 0.95646814 } };
+  for (int row = 0; row < 3; row++)
+    {
+    for (int column = 0; column < 3; column++)
+      {
+      directionMatrix->SetElement(row, column, direction[row][column]);
+      }
+    }
+  vtkSmartPointer<vtkImageData> grid = vtkSmartPointer<vtkImageData>::New();
+  grid->SetExtent(0, dimension - 1, 0, dimension - 1, 0, dimension - 1);
+  grid->SetOrigin(-100.0, -90.0, -110.0);
+  grid->SetSpacing(spacing, spacing, spacing);
+  grid->AllocateScalars(scalarType, 3);
+  T* displacement = static_cast<T*>(grid->GetScalarPointer());
+  for (int k = 0; k < dimension; k++)
+    {
+    for (int j = 0; j < dimension; j++)
+      {
+      for (int i = 0; i < dimension; i++)
+        {
+        *(displacement++) = static_cast<T>(5.0 * sin(j * 0.5) * cos(k * 0.5));
+        *(displacement++) = static_cast<T>(5.0 * sin(k * 0.5) * cos(i * 0.5));
+        *(displacement++) = static_cast<T>(5.0 * sin(i * 0.5) * cos(j * 0.5));
+        }
+      }
+    }
+  return grid;
+}
+
+//----------------------------------------------------------------------------
+/// Random points, partly outside the grid
+void CreatePoints(vtkPoints* points, int numberOfPoints)
+{
+  vtkMath::RandomSeed(42);
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    points->SetPoint(i, vtkMath::Random(-150.0, 150.0), vtkMath::Random(-150.0, 150.0), vtkMath::Random(-150.0, 150.0));
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Compare batch transform with transforming points one by one
+int TestBatchTransform(const char* name, vtkAbstractTransform* transform, int pointDataType, int numberOfPoints = 200000)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataType(pointDataType);
+  CreatePoints(points.GetPointer(), numberOfPoints);
+  vtkNew<vtkTimerLog> timer;
+
+  // Reference: one point at a time
+  vtkNew<vtkPoints> expectedPoints;
+  expectedPoints->SetDataTypeToDouble();
+  expectedPoints->SetNumberOfPoints(points->GetNumberOfPoints());
+  timer->StartTimer();
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    {
+    double point[3];
+    points->GetPoint(i, point);
+    transform->TransformPoint(point, point);
+    expectedPoints->SetPoint(i, point);
+    }
+  timer->StopTimer();
+  double pointByPointTime = timer->GetElapsedTime();
+
+  // Batch
+  vtkNew<vtkBatchPointTransformer> transformer;
+  transformer->SetTransform(transform);
+  vtkNew<vtkPoints> transformedPoints;
+  transformedPoints->SetDataType(pointDataType);
+  timer->StartTimer();
+  transformer->TransformPoints(points.GetPointer(), transformedPoints.GetPointer());
+  timer->StopTimer();
+  double batchTime = timer->GetElapsedTime();
+
+  std::cout << name << ": transform " << points->GetNumberOfPoints() << " points one by one: "
+    << pointByPointTime << "s, in batch: " << batchTime << "s" << std::endl;
+
+  CHECK_INT(static_cast<int>(transformedPoints->GetNumberOfPoints()), static_cast<int>(points->GetNumberOfPoints()));
+  double tolerance = (pointDataType == VTK_DOUBLE ? 1e-9 : 1e-3);
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    {
+    double expectedPoint[3];
+    double transformedPoint[3];
+    expectedPoints->GetPoint(i, expectedPoint);
+    transformedPoints->GetPoint(i, transformedPoint);
+    double difference = sqrt(vtkMath::Distance2BetweenPoints(expectedPoint, transformedPoint));
+    if (difference > tolerance)
+      {
+      std::cerr << "Line " << __LINE__ << ": " << name << " point " << i << " mismatch: difference = "
+        << difference << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Contiguous arrays, transformed in place
+  std::vector<double> pointArray(points->GetNumberOfPoints() * 3);
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    {
+    points->GetPoint(i, &pointArray[i * 3]);
+    }
+  transformer->TransformPoints(&pointArray[0], &pointArray[0], points->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    {
+    double expectedPoint[3];
+    expectedPoints->GetPoint(i, expectedPoint);
+    CHECK_DOUBLE_TOLERANCE(sqrt(vtkMath::Distance2BetweenPoints(expectedPoint, &pointArray[i * 3])), 0.0, 1e-9);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkBatchPointTransformerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMatrix4x4> directionMatrix;
+
+  // Grid transforms, with a specialized kernel for each grid scalar type
+  vtkNew<vtkOrientedGridTransform> gridTransform;
+  gridTransform->SetDisplacementGridData(CreateDisplacementGrid<double>(VTK_DOUBLE, directionMatrix.GetPointer()));
+  gridTransform->SetGridDirectionMatrix(directionMatrix.GetPointer());
+  CHECK_EXIT_SUCCESS(TestBatchTransform("Grid (double)", gridTransform.GetPointer(), VTK_DOUBLE));
+  CHECK_EXIT_SUCCESS(TestBatchTransform("Grid (double), float points", gridTransform.GetPointer(), VTK_FLOAT));
+
+  vtkNew<vtkOrientedGridTransform> floatGridTransform;
+  floatGridTransform->SetDisplacementGridData(CreateDisplacementGrid<float>(VTK_FLOAT, directionMatrix.GetPointer()));
+  floatGridTransform->SetGridDirectionMatrix(directionMatrix.GetPointer());
+  floatGridTransform->SetDisplacementScale(1.5);
+  floatGridTransform->SetDisplacementShift(0.5);
+  CHECK_EXIT_SUCCESS(TestBatchTransform("Grid (float)", floatGridTransform.GetPointer(), VTK_DOUBLE));
+
+  // Cubic interpolation is computed point by point
+  vtkNew<vtkOrientedGridTransform> cubicGridTransform;
+  cubicGridTransform->SetDisplacementGridData(CreateDisplacementGrid<double>(VTK_DOUBLE, directionMatrix.GetPointer()));
+  cubicGridTransform->SetGridDirectionMatrix(directionMatrix.GetPointer());
+  cubicGridTransform->SetInterpolationModeToCubic();
+  CHECK_EXIT_SUCCESS(TestBatchTransform("Grid (cubic)", cubicGridTransform.GetPointer(), VTK_DOUBLE));
+
+  // B-spline transform with bulk transform
+  vtkNew<vtkOrientedBSplineTransform> bsplineTransform;
+  bsplineTransform->SetCoefficientData(CreateDisplacementGrid<double>(VTK_DOUBLE, directionMatrix.GetPointer()));
+  bsplineTransform->SetGridDirectionMatrix(directionMatrix.GetPointer());
+  vtkNew<vtkTransform> bulkTransform;
+  bulkTransform->RotateX(5.0);
+  bulkTransform->Translate(2.0, -3.0, 4.0);
+  bsplineTransform->SetBulkTransformMatrix(bulkTransform->GetMatrix());
+  CHECK_EXIT_SUCCESS(TestBatchTransform("B-spline", bsplineTransform.GetPointer(), VTK_DOUBLE));
+
+  // Concatenation of linear, grid, inverse grid, and thin-plate spline transforms
+  vtkNew<vtkThinPlateSplineTransform> tpsTransform;
+  vtkNew<vtkPoints> sourceLandmarks;
+  vtkNew<vtkPoints> targetLandmarks;
+  for (int i = 0; i < 8; i++)
+    {
+    double landmark[3] = { (i & 1) ? 100.0 : -100.0, (i & 2) ? 100.0 : -100.0, (i & 4) ? 100.0 : -100.0 };
+    sourceLandmarks->InsertNextPoint(landmark);
+    targetLandmarks->InsertNextPoint(landmark[0] + i, landmark[1] - i, landmark[2] + 0.5 * i);
+    }
+  tpsTransform->SetSourceLandmarks(sourceLandmarks.GetPointer());
+  tpsTransform->SetTargetLandmarks(targetLandmarks.GetPointer());
+  tpsTransform->SetBasisToR();
+
+  vtkNew<vtkGeneralTransform> transformChain;
+  transformChain->PostMultiply();
+  transformChain->Concatenate(bulkTransform.GetPointer());
+  transformChain->Concatenate(floatGridTransform.GetPointer());
+  transformChain->Concatenate(bsplineTransform->GetInverse());
+  vtkNew<vtkGeneralTransform> innerChain;
+  innerChain->Concatenate(tpsTransform.GetPointer());
+  innerChain->Concatenate(gridTransform.GetPointer());
+  innerChain->Inverse();
+  transformChain->Concatenate(innerChain.GetPointer());
+  // fewer points, as inverse transforms are computed iteratively
+  CHECK_EXIT_SUCCESS(TestBatchTransform("Transform chain", transformChain.GetPointer(), VTK_DOUBLE, 20000));
+
+  return EXIT_SUCCESS;
+}
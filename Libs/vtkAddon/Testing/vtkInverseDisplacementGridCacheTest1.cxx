@@ -0,0 +1,225 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkAddonTestingMacros.h"
+#include "vtkInverseDisplacementGridCache.h"
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkWarpTransform.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+const double Spacing = 10.0;
+const int Dimension = 21;
+const double Amplitude = 5.0;
+const double Wavelength = 120.0;
+
+//----------------------------------------------------------------------------
+/// Grid with a smooth sinusoidal displacement, oriented along an oblique direction
+/// and centered at the origin.
+vtkSmartPointer<vtkImageData> CreateDisplacementGrid(vtkMatrix4x4* directionMatrix)
+{
+  double direction[3][3] = { { 0.92128500, -0.36017075, -0.146666625 },
+                             { 0.31722386, 0.91417248, -0.25230478 },
+                             { 0.22495105, 0.18591857, 0.95646814 } };
+  double halfSize = (Dimension - 1) * Spacing / 2.0;
+  double origin[3] = { 0.0, 0.0, 0.0 };
+  for (int row = 0; row < 3; row++)
+    {
+    for (int column = 0; column < 3; column++)
+      {
+      directionMatrix->SetElement(row, column, direction[row][column]);
+      origin[row] -= direction[row][column] * halfSize;
+      }
+    }
+
+  vtkSmartPointer<vtkImageData> grid = vtkSmartPointer<vtkImageData>::New();
+  grid->SetExtent(0, Dimension - 1, 0, Dimension - 1, 0, Dimension - 1);
+  grid->SetOrigin(origin);
+  grid->SetSpacing(Spacing, Spacing, Spacing);
+  grid->AllocateScalars(VTK_DOUBLE, 3);
+  double* displacement = static_cast<double*>(grid->GetScalarPointer());
+  for (int k = 0; k < Dimension; k++)
+    {
+    for (int j = 0; j < Dimension; j++)
+      {
+      for (int i = 0; i < Dimension; i++)
+        {
+        double x = i * Spacing * 2.0 * vtkMath::Pi() / Wavelength;
+        double y = j * Spacing * 2.0 * vtkMath::Pi() / Wavelength;
+        double z = k * Spacing * 2.0 * vtkMath::Pi() / Wavelength;
+        *(displacement++) = Amplitude * sin(y) * cos(z);
+        *(displacement++) = Amplitude * sin(z) * cos(x);
+        *(displacement++) = Amplitude * sin(x) * cos(y);
+        }
+      }
+    }
+  return grid;
+}
+
+//----------------------------------------------------------------------------
+/// Random points in the central region of the grid, transformed by the forward transform.
+void CreateTestPoints(vtkWarpTransform* transform, vtkPoints* points, vtkPoints* transformedPoints)
+{
+  vtkMath::RandomSeed(42);
+  // more points than the nodes of the inverse grid of the b-spline transform (41^3),
+  // so that the inverse grid is computed for the whole batch
+  const int numberOfPoints = 80000;
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    points->SetPoint(i, vtkMath::Random(-60.0, 60.0), vtkMath::Random(-60.0, 60.0), vtkMath::Random(-60.0, 60.0));
+    }
+  transform->TransformPoints(points, transformedPoints);
+}
+
+//----------------------------------------------------------------------------
+/// Maximum distance between the original points and the inverse transformed points
+double GetMaximumInverseError(vtkPoints* points, vtkPoints* inversePoints)
+{
+  double maximumError = 0.0;
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); i++)
+    {
+    double point[3];
+    double inversePoint[3];
+    points->GetPoint(i, point);
+    inversePoints->GetPoint(i, inversePoint);
+    maximumError = std::max(maximumError, sqrt(vtkMath::Distance2BetweenPoints(point, inversePoint)));
+    }
+  return maximumError;
+}
+
+//----------------------------------------------------------------------------
+/// Compare cached and iterative inverse of the transform.
+/// The cached inverse is only the starting point of the iterative inversion,
+/// so both must be accurate to the inverse tolerance.
+template <class TransformType>
+int TestInverseGridCache(TransformType* transform)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkPoints> transformedPoints;
+  CreateTestPoints(transform, points.GetPointer(), transformedPoints.GetPointer());
+  vtkNew<vtkTimerLog> timer;
+
+  // Iterative inverse (reference)
+  transform->InverseGridCachingOff();
+  transform->Inverse();
+  vtkNew<vtkPoints> iterativeInversePoints;
+  timer->StartTimer();
+  transform->TransformPoints(transformedPoints.GetPointer(), iterativeInversePoints.GetPointer());
+  timer->StopTimer();
+  double iterativeTime = timer->GetElapsedTime();
+  double iterativeError = GetMaximumInverseError(points.GetPointer(), iterativeInversePoints.GetPointer());
+  CHECK_BOOL(transform->GetInverseGridCache()->IsValid(), false);
+
+  // Cached inverse: the inverse grid is computed for the large batch of points
+  transform->InverseGridCachingOn();
+  vtkNew<vtkPoints> cachedInversePoints;
+  timer->StartTimer();
+  transform->TransformPoints(transformedPoints.GetPointer(), cachedInversePoints.GetPointer());
+  timer->StopTimer();
+  double cachedTime = timer->GetElapsedTime();
+  CHECK_BOOL(transform->GetInverseGridCache()->IsValid(), true);
+  CHECK_INT(static_cast<int>(transform->GetInverseGridCache()->GetNumberOfConvergenceFailures()), 0);
+  double cachedError = GetMaximumInverseError(points.GetPointer(), cachedInversePoints.GetPointer());
+
+  // Second batch only interpolates the grid and refines the result
+  timer->StartTimer();
+  transform->TransformPoints(transformedPoints.GetPointer(), cachedInversePoints.GetPointer());
+  timer->StopTimer();
+  double cachedTimeWithoutGridUpdate = timer->GetElapsedTime();
+
+  std::cout << transform->GetClassName() << " inverse of " << points->GetNumberOfPoints() << " points:" << std::endl
+    << "  iterative: " << iterativeTime << "s, maximum error = " << iterativeError << std::endl
+    << "  cached: " << cachedTime << "s (" << cachedTimeWithoutGridUpdate << "s without grid update)"
+    << ", maximum error = " << cachedError << std::endl;
+
+  double tolerance = iterativeError + transform->GetInverseTolerance();
+  if (cachedError > tolerance)
+    {
+    std::cerr << "Line " << __LINE__ << ": cached inverse error " << cachedError
+      << " is larger than the tolerance " << tolerance << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Points outside the grid are inverted iteratively, the same as without caching
+  double outsidePoint[3] = { 500.0, -400.0, 300.0 };
+  double cachedInverse[3] = { 0.0, 0.0, 0.0 };
+  transform->TransformPoint(outsidePoint, cachedInverse);
+  transform->InverseGridCachingOff();
+  double iterativeInverse[3] = { 0.0, 0.0, 0.0 };
+  transform->TransformPoint(outsidePoint, iterativeInverse);
+  CHECK_DOUBLE_TOLERANCE(sqrt(vtkMath::Distance2BetweenPoints(cachedInverse, iterativeInverse)), 0.0, 1e-6);
+
+  // Modifying the transform discards the inverse grid
+  transform->InverseGridCachingOn();
+  CHECK_BOOL(transform->UpdateInverseGrid(), true);
+  CHECK_BOOL(transform->GetInverseGridCache()->IsValid(), true);
+  transform->Modified();
+  transform->Update();
+  CHECK_BOOL(transform->GetInverseGridCache()->IsValid(), false);
+
+  transform->Inverse();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestGridTransform()
+{
+  vtkNew<vtkMatrix4x4> directionMatrix;
+  vtkSmartPointer<vtkImageData> grid = CreateDisplacementGrid(directionMatrix.GetPointer());
+  vtkNew<vtkOrientedGridTransform> transform;
+  transform->SetDisplacementGridData(grid);
+  transform->SetGridDirectionMatrix(directionMatrix.GetPointer());
+  transform->SetInterpolationModeToCubic();
+  return TestInverseGridCache(transform.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+int TestBSplineTransform()
+{
+  vtkNew<vtkMatrix4x4> directionMatrix;
+  vtkSmartPointer<vtkImageData> grid = CreateDisplacementGrid(directionMatrix.GetPointer());
+  vtkNew<vtkOrientedBSplineTransform> transform;
+  transform->SetCoefficientData(grid);
+  transform->SetGridDirectionMatrix(directionMatrix.GetPointer());
+  return TestInverseGridCache(transform.GetPointer());
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkInverseDisplacementGridCacheTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestGridTransform());
+  CHECK_EXIT_SUCCESS(TestBSplineTransform());
+  return EXIT_SUCCESS;
+}
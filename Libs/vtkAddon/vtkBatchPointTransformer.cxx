@@ -0,0 +1,320 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkBatchPointTransformer.h"
+
+#include "vtkOrientedBSplineTransform.h"
+#include "vtkOrientedGridTransform.h"
+
+#include "vtkDataArray.h"
+#include "vtkGeneralTransform.h"
+#include "vtkHomogeneousTransform.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkSmartPointer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+vtkStandardNewMacro(vtkBatchPointTransformer);
+
+vtkCxxSetObjectMacro(vtkBatchPointTransformer,Transform,vtkAbstractTransform);
+
+//----------------------------------------------------------------------------
+class vtkBatchPointTransformer::vtkInternal
+{
+public:
+  enum ComponentType
+    {
+    HomogeneousComponent,
+    OrientedGridComponent,
+    OrientedBSplineComponent,
+    GeneralComponent
+    };
+
+  struct Component
+    {
+    ComponentType Type;
+    vtkSmartPointer<vtkAbstractTransform> Transform;
+    double Matrix[4][4];
+    bool Perspective;
+    };
+
+  // Add the transform, or the transforms concatenated in it, to the list of components.
+  void AddComponents(vtkAbstractTransform* transform);
+
+  // Concatenated transforms, in the order they are applied
+  std::vector<Component> Components;
+};
+
+//----------------------------------------------------------------------------
+void vtkBatchPointTransformer::vtkInternal::AddComponents(vtkAbstractTransform* transform)
+{
+  if (transform == nullptr)
+    {
+    return;
+    }
+  transform->Update();
+
+  vtkGeneralTransform* generalTransform = vtkGeneralTransform::SafeDownCast(transform);
+  if (generalTransform)
+    {
+    // concatenated transforms are returned in the order they are applied,
+    // taking into account the inverse flag of the general transform
+    for (int i = 0; i < generalTransform->GetNumberOfConcatenatedTransforms(); i++)
+      {
+      this->AddComponents(generalTransform->GetConcatenatedTransform(i));
+      }
+    return;
+    }
+
+  Component component;
+  component.Type = GeneralComponent;
+  component.Transform = transform;
+  component.Perspective = false;
+  vtkHomogeneousTransform* homogeneousTransform = vtkHomogeneousTransform::SafeDownCast(transform);
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(transform);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(transform);
+  if (homogeneousTransform)
+    {
+    component.Type = HomogeneousComponent;
+    vtkMatrix4x4::DeepCopy(&component.Matrix[0][0], homogeneousTransform->GetMatrix());
+    component.Perspective = (component.Matrix[3][0] != 0.0 || component.Matrix[3][1] != 0.0
+      || component.Matrix[3][2] != 0.0 || component.Matrix[3][3] != 1.0);
+    }
+  else if (gridTransform && !gridTransform->GetInverseFlag())
+    {
+    component.Type = OrientedGridComponent;
+    }
+  else if (bsplineTransform && !bsplineTransform->GetInverseFlag())
+    {
+    component.Type = OrientedBSplineComponent;
+    }
+  this->Components.push_back(component);
+}
+
+namespace
+{
+
+// Number of points that are pushed through all the concatenated transforms at once.
+// Small enough to keep the points in the cache, large enough to make the cost of
+// switching between transforms negligible.
+const vtkIdType BlockSize = 1024;
+
+//----------------------------------------------------------------------------
+struct TransformThreadData
+{
+  vtkBatchPointTransformer* Self;
+  // Contiguous input and output point coordinates,
+  // nullptr if the points are not stored as double
+  const double* InPoints;
+  double* OutPoints;
+  vtkDataArray* InArray;
+  vtkDataArray* OutArray;
+  vtkIdType NumberOfPoints;
+  std::atomic<vtkIdType> NextBlock;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE TransformThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  TransformThreadData* data = static_cast<TransformThreadData*>(info->UserData);
+  std::vector<double> buffer;
+  if (!data->OutPoints)
+    {
+    buffer.resize(BlockSize * 3);
+    }
+  vtkIdType numberOfBlocks = (data->NumberOfPoints + BlockSize - 1) / BlockSize;
+  for (vtkIdType block = data->NextBlock++; block < numberOfBlocks; block = data->NextBlock++)
+    {
+    vtkIdType firstPointIndex = block * BlockSize;
+    vtkIdType numberOfPoints = std::min(BlockSize, data->NumberOfPoints - firstPointIndex);
+    // transform in place in the output array if possible
+    double* points = data->OutPoints ? data->OutPoints + firstPointIndex * 3 : &buffer[0];
+    if (data->InPoints)
+      {
+      const double* inPoints = data->InPoints + firstPointIndex * 3;
+      if (inPoints != points)
+        {
+        std::copy(inPoints, inPoints + numberOfPoints * 3, points);
+        }
+      }
+    else
+      {
+      for (vtkIdType i = 0; i < numberOfPoints; i++)
+        {
+        data->InArray->GetTuple(firstPointIndex + i, points + i * 3);
+        }
+      }
+    data->Self->TransformPointBuffer(points, numberOfPoints);
+    if (!data->OutPoints)
+      {
+      for (vtkIdType i = 0; i < numberOfPoints; i++)
+        {
+        data->OutArray->SetTuple(firstPointIndex + i, points + i * 3);
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void RunTransformThreads(TransformThreadData* data, int numberOfThreads)
+{
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  vtkIdType numberOfBlocks = (data->NumberOfPoints + BlockSize - 1) / BlockSize;
+  numberOfThreads = static_cast<int>(std::max<vtkIdType>(1,
+    std::min<vtkIdType>(std::min<vtkIdType>(numberOfThreads, numberOfBlocks), VTK_MAX_THREADS)));
+  data->NextBlock = 0;
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(TransformThread, data);
+  threader->SingleMethodExecute();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkBatchPointTransformer::vtkBatchPointTransformer()
+{
+  this->Transform = nullptr;
+  this->NumberOfThreads = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkBatchPointTransformer::~vtkBatchPointTransformer()
+{
+  this->SetTransform(nullptr);
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkBatchPointTransformer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Transform: " << this->Transform << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfConcatenatedTransforms: " << this->Internal->Components.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkBatchPointTransformer::Update()
+{
+  this->Internal->Components.clear();
+  this->Internal->AddComponents(this->Transform);
+}
+
+//----------------------------------------------------------------------------
+void vtkBatchPointTransformer::TransformPointBuffer(double* points, vtkIdType numberOfPoints)
+{
+  for (const vtkInternal::Component& component : this->Internal->Components)
+    {
+    switch (component.Type)
+      {
+      case vtkInternal::HomogeneousComponent:
+        {
+        const double (*matrix)[4] = component.Matrix;
+        for (double* point = points; point < points + numberOfPoints * 3; point += 3)
+          {
+          double x = matrix[0][0]*point[0] + matrix[0][1]*point[1] + matrix[0][2]*point[2] + matrix[0][3];
+          double y = matrix[1][0]*point[0] + matrix[1][1]*point[1] + matrix[1][2]*point[2] + matrix[1][3];
+          double z = matrix[2][0]*point[0] + matrix[2][1]*point[1] + matrix[2][2]*point[2] + matrix[2][3];
+          if (component.Perspective)
+            {
+            double w = 1.0 / (matrix[3][0]*point[0] + matrix[3][1]*point[1] + matrix[3][2]*point[2] + matrix[3][3]);
+            x *= w;
+            y *= w;
+            z *= w;
+            }
+          point[0] = x;
+          point[1] = y;
+          point[2] = z;
+          }
+        }
+        break;
+      case vtkInternal::OrientedGridComponent:
+        static_cast<vtkOrientedGridTransform*>(component.Transform.GetPointer())->ForwardTransformPoints(
+          points, points, numberOfPoints);
+        break;
+      case vtkInternal::OrientedBSplineComponent:
+        static_cast<vtkOrientedBSplineTransform*>(component.Transform.GetPointer())->ForwardTransformPoints(
+          points, points, numberOfPoints);
+        break;
+      default:
+        // The transform is already updated, therefore it can be called concurrently
+        for (double* point = points; point < points + numberOfPoints * 3; point += 3)
+          {
+          component.Transform->InternalTransformPoint(point, point);
+          }
+        break;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkBatchPointTransformer::TransformPoints(const double* inPoints, double* outPoints, vtkIdType numberOfPoints)
+{
+  if (!this->Transform || !inPoints || !outPoints)
+    {
+    vtkErrorMacro("TransformPoints failed: invalid transform or points");
+    return;
+    }
+  if (numberOfPoints <= 0)
+    {
+    return;
+    }
+  this->Update();
+
+  TransformThreadData data;
+  data.Self = this;
+  data.InPoints = inPoints;
+  data.OutPoints = outPoints;
+  data.InArray = nullptr;
+  data.OutArray = nullptr;
+  data.NumberOfPoints = numberOfPoints;
+  RunTransformThreads(&data, this->NumberOfThreads);
+}
+
+//----------------------------------------------------------------------------
+void vtkBatchPointTransformer::TransformPoints(vtkPoints* inPoints, vtkPoints* outPoints)
+{
+  if (!this->Transform || !inPoints || !outPoints)
+    {
+    vtkErrorMacro("TransformPoints failed: invalid transform or points");
+    return;
+    }
+  vtkIdType numberOfPoints = inPoints->GetNumberOfPoints();
+  outPoints->SetNumberOfPoints(numberOfPoints);
+  if (numberOfPoints == 0)
+    {
+    return;
+    }
+  this->Update();
+
+  TransformThreadData data;
+  data.Self = this;
+  data.InArray = inPoints->GetData();
+  data.OutArray = outPoints->GetData();
+  data.InPoints = (data.InArray->GetDataType() == VTK_DOUBLE) ? static_cast<double*>(data.InArray->GetVoidPointer(0)) : nullptr;
+  data.OutPoints = (data.OutArray->GetDataType() == VTK_DOUBLE) ? static_cast<double*>(data.OutArray->GetVoidPointer(0)) : nullptr;
+  data.NumberOfPoints = numberOfPoints;
+  RunTransformThreads(&data, this->NumberOfThreads);
+  outPoints->Modified();
+}
@@ -0,0 +1,88 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkBatchPointTransformer - transform large arrays of points concurrently.
+///
+/// vtkAbstractTransform::TransformPoint goes through several virtual calls for each
+/// point and each transform of a concatenation, and a vtkGeneralTransform transforms
+/// point sets in a single thread. This class splits the transform into its
+/// concatenated transforms once and pushes blocks of points through each of them:
+/// linear transforms are applied as a matrix, forward oriented grid and b-spline
+/// transforms use their batch kernels (see ForwardTransformPoints), and all other
+/// transforms are evaluated point by point. Blocks are processed concurrently.
+///
+/// The transform must not be modified while points are transformed.
+///
+
+#ifndef __vtkBatchPointTransformer_h
+#define __vtkBatchPointTransformer_h
+
+#include "vtkAddon.h"
+
+#include "vtkObject.h"
+
+class vtkAbstractTransform;
+class vtkPoints;
+
+class VTK_ADDON_EXPORT vtkBatchPointTransformer : public vtkObject
+{
+public:
+  static vtkBatchPointTransformer *New();
+  vtkTypeMacro(vtkBatchPointTransformer,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Set/Get the transform that is applied to the points.
+  virtual void SetTransform(vtkAbstractTransform*);
+  vtkGetObjectMacro(Transform, vtkAbstractTransform);
+
+  // Description:
+  // Transform a contiguous array of points (x0, y0, z0, x1, y1, z1, ...).
+  // inPoints and outPoints may be the same array.
+  void TransformPoints(const double* inPoints, double* outPoints, vtkIdType numberOfPoints);
+
+  // Description:
+  // Transform all the points of inPoints. The number of points of outPoints is set to
+  // the number of input points (unlike vtkAbstractTransform::TransformPoints, which
+  // appends the transformed points). inPoints and outPoints may be the same object.
+  void TransformPoints(vtkPoints* inPoints, vtkPoints* outPoints);
+
+  // Description:
+  // Update the transform and split it into the concatenated transforms.
+  // Must be called before TransformPointBuffer.
+  void Update();
+
+  // Description:
+  // Transform a contiguous array of points in place in the calling thread.
+  // Can be called concurrently after Update(), for computing the points to be
+  // transformed in the same thread as they are transformed.
+  void TransformPointBuffer(double* points, vtkIdType numberOfPoints);
+
+  // Description:
+  // Number of threads used for transforming points.
+  // Default is 0, which uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+protected:
+  vtkBatchPointTransformer();
+  ~vtkBatchPointTransformer() override;
+
+  vtkAbstractTransform* Transform;
+  int NumberOfThreads;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkBatchPointTransformer(const vtkBatchPointTransformer&) = delete;
+  void operator=(const vtkBatchPointTransformer&) = delete;
+};
+
+#endif
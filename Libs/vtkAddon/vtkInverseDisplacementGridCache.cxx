@@ -0,0 +1,350 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkInverseDisplacementGridCache.h"
+
+#include "vtkImageData.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+vtkStandardNewMacro(vtkInverseDisplacementGridCache);
+
+//----------------------------------------------------------------------------
+class vtkInverseDisplacementGridCache::vtkInternal
+{
+public:
+  vtkInternal()
+    : Valid(false)
+    , NumberOfInverseTransformedPoints(0)
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      this->Extent[2 * i] = 0;
+      this->Extent[2 * i + 1] = -1;
+      }
+    vtkMatrix4x4::Identity(&this->GridIndexToOutput[0][0]);
+    vtkMatrix4x4::Identity(&this->OutputToGridIndex[0][0]);
+    }
+
+  std::mutex UpdateMutex;
+  std::atomic<bool> Valid;
+  std::atomic<vtkIdType> NumberOfInverseTransformedPoints;
+
+  int Extent[6];
+  double GridIndexToOutput[4][4];
+  double OutputToGridIndex[4][4];
+
+  vtkSmartPointer<vtkImageData> InverseDisplacementGrid;
+  // Displacement vectors in the inverse displacement grid, i index is the fastest varying
+  double* Displacements = nullptr;
+};
+
+namespace
+{
+
+//------------------------------------------------------------------------
+inline void vtkLinearTransformPoint(const double matrix[4][4],
+                                    const double in[3], double out[3])
+{
+  double x =
+    matrix[0][0]*in[0]+matrix[0][1]*in[1]+matrix[0][2]*in[2]+matrix[0][3];
+  double y =
+    matrix[1][0]*in[0]+matrix[1][1]*in[1]+matrix[1][2]*in[2]+matrix[1][3];
+  double z =
+    matrix[2][0]*in[0]+matrix[2][1]*in[1]+matrix[2][2]*in[2]+matrix[2][3];
+
+  out[0] = x;
+  out[1] = y;
+  out[2] = z;
+}
+
+//----------------------------------------------------------------------------
+struct UpdateThreadData
+{
+  vtkInverseDisplacementGridCache::InversePointFunctionType InversePointFunction;
+  void* ClientData;
+  const int* Extent;
+  const double (*GridIndexToOutput)[4];
+  double* Displacements;
+  std::atomic<int> NextSlice;
+  double MaximumError[VTK_MAX_THREADS];
+  vtkIdType NumberOfConvergenceFailures[VTK_MAX_THREADS];
+};
+
+//----------------------------------------------------------------------------
+// Slices take different time to compute (the number of Newton iterations
+// depends on the displacement), therefore each thread takes the next slice when it is done.
+VTK_THREAD_RETURN_TYPE UpdateThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  UpdateThreadData* data = static_cast<UpdateThreadData*>(info->UserData);
+  const int* extent = data->Extent;
+  vtkIdType rowLength = extent[1] - extent[0] + 1;
+  vtkIdType sliceSize = rowLength * (extent[3] - extent[2] + 1);
+  double maximumError = 0.0;
+  vtkIdType numberOfConvergenceFailures = 0;
+  for (int k = data->NextSlice++; k <= extent[5]; k = data->NextSlice++)
+    {
+    double* displacement = data->Displacements + (k - extent[4]) * sliceSize * 3;
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++, displacement += 3)
+        {
+        double node_IJK[3] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) };
+        double node[3];
+        vtkLinearTransformPoint(data->GridIndexToOutput, node_IJK, node);
+        double inverse[3];
+        double error = 0.0;
+        if (!data->InversePointFunction(data->ClientData, node, inverse, &error))
+          {
+          numberOfConvergenceFailures++;
+          }
+        maximumError = std::max(maximumError, error);
+        displacement[0] = inverse[0] - node[0];
+        displacement[1] = inverse[1] - node[1];
+        displacement[2] = inverse[2] - node[2];
+        }
+      }
+    }
+  data->MaximumError[info->ThreadID] = maximumError;
+  data->NumberOfConvergenceFailures[info->ThreadID] = numberOfConvergenceFailures;
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkInverseDisplacementGridCache::vtkInverseDisplacementGridCache()
+{
+  this->MaximumError = 0.0;
+  this->NumberOfConvergenceFailures = 0;
+  this->NumberOfThreads = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkInverseDisplacementGridCache::~vtkInverseDisplacementGridCache()
+{
+  delete this->Internal;
+  this->Internal = nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkInverseDisplacementGridCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Extent: " << this->Internal->Extent[0] << " " << this->Internal->Extent[1] << " "
+    << this->Internal->Extent[2] << " " << this->Internal->Extent[3] << " "
+    << this->Internal->Extent[4] << " " << this->Internal->Extent[5] << "\n";
+  os << indent << "Valid: " << (this->Internal->Valid ? "true" : "false") << "\n";
+  os << indent << "NumberOfInverseTransformedPoints: " << this->Internal->NumberOfInverseTransformedPoints << "\n";
+  os << indent << "MaximumError: " << this->MaximumError << "\n";
+  os << indent << "NumberOfConvergenceFailures: " << this->NumberOfConvergenceFailures << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkInverseDisplacementGridCache::SetGridGeometry(const int extent[6], vtkMatrix4x4* gridIndexToOutput)
+{
+  this->Invalidate();
+  std::copy(extent, extent + 6, this->Internal->Extent);
+  if (gridIndexToOutput)
+    {
+    vtkMatrix4x4::DeepCopy(&this->Internal->GridIndexToOutput[0][0], gridIndexToOutput);
+    }
+  else
+    {
+    vtkMatrix4x4::Identity(&this->Internal->GridIndexToOutput[0][0]);
+    }
+  vtkMatrix4x4::Invert(&this->Internal->GridIndexToOutput[0][0], &this->Internal->OutputToGridIndex[0][0]);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkInverseDisplacementGridCache::Invalidate()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->UpdateMutex);
+  this->Internal->Valid = false;
+  this->Internal->NumberOfInverseTransformedPoints = 0;
+  this->Internal->InverseDisplacementGrid = nullptr;
+  this->Internal->Displacements = nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool vtkInverseDisplacementGridCache::IsValid()
+{
+  return this->Internal->Valid;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkInverseDisplacementGridCache::GetNumberOfGridPoints()
+{
+  const int* extent = this->Internal->Extent;
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return 0;
+    }
+  return static_cast<vtkIdType>(extent[1] - extent[0] + 1)
+    * static_cast<vtkIdType>(extent[3] - extent[2] + 1)
+    * static_cast<vtkIdType>(extent[5] - extent[4] + 1);
+}
+
+//----------------------------------------------------------------------------
+bool vtkInverseDisplacementGridCache::RegisterInverseTransformedPoints(vtkIdType numberOfPoints)
+{
+  vtkIdType numberOfGridPoints = this->GetNumberOfGridPoints();
+  if (numberOfGridPoints == 0)
+    {
+    return false;
+    }
+  vtkIdType numberOfInverseTransformedPoints = (this->Internal->NumberOfInverseTransformedPoints += numberOfPoints);
+  return numberOfInverseTransformedPoints >= numberOfGridPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vtkInverseDisplacementGridCache::Update(InversePointFunctionType inversePointFunction, void* clientData)
+{
+  if (this->Internal->Valid)
+    {
+    return true;
+    }
+  std::lock_guard<std::mutex> lock(this->Internal->UpdateMutex);
+  if (this->Internal->Valid)
+    {
+    // computed by another thread while this one was waiting
+    return true;
+    }
+  vtkIdType numberOfGridPoints = this->GetNumberOfGridPoints();
+  if (numberOfGridPoints == 0 || !inversePointFunction)
+    {
+    return false;
+    }
+
+  vtkSmartPointer<vtkImageData> inverseDisplacementGrid = vtkSmartPointer<vtkImageData>::New();
+  inverseDisplacementGrid->SetExtent(this->Internal->Extent);
+  inverseDisplacementGrid->AllocateScalars(VTK_DOUBLE, 3);
+
+  UpdateThreadData data;
+  data.InversePointFunction = inversePointFunction;
+  data.ClientData = clientData;
+  data.Extent = this->Internal->Extent;
+  data.GridIndexToOutput = this->Internal->GridIndexToOutput;
+  data.Displacements = static_cast<double*>(inverseDisplacementGrid->GetScalarPointer());
+  data.NextSlice = this->Internal->Extent[4];
+
+  int numberOfThreads = this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  int numberOfSlices = this->Internal->Extent[5] - this->Internal->Extent[4] + 1;
+  numberOfThreads = std::max(1, std::min(std::min(numberOfThreads, numberOfSlices), VTK_MAX_THREADS));
+  std::fill(data.MaximumError, data.MaximumError + VTK_MAX_THREADS, 0.0);
+  std::fill(data.NumberOfConvergenceFailures, data.NumberOfConvergenceFailures + VTK_MAX_THREADS, 0);
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(UpdateThread, &data);
+  threader->SingleMethodExecute();
+
+  this->MaximumError = *std::max_element(data.MaximumError, data.MaximumError + numberOfThreads);
+  this->NumberOfConvergenceFailures = 0;
+  for (int threadIndex = 0; threadIndex < numberOfThreads; threadIndex++)
+    {
+    this->NumberOfConvergenceFailures += data.NumberOfConvergenceFailures[threadIndex];
+    }
+
+  this->Internal->InverseDisplacementGrid = inverseDisplacementGrid;
+  this->Internal->Displacements = data.Displacements;
+  this->Internal->Valid = true;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkInverseDisplacementGridCache::InverseTransformPoint(const double in[3], double out[3])
+{
+  if (!this->Internal->Valid)
+    {
+    return false;
+    }
+  const int* extent = this->Internal->Extent;
+  double point_IJK[3];
+  vtkLinearTransformPoint(this->Internal->OutputToGridIndex, in, point_IJK);
+
+  // Grid cell and position inside the cell
+  int cellIndex[3];
+  double fraction[3];
+  vtkIdType increments[3] = { 1, 0, 0 };
+  increments[1] = extent[1] - extent[0] + 1;
+  increments[2] = increments[1] * (extent[3] - extent[2] + 1);
+  for (int axis = 0; axis < 3; axis++)
+    {
+    double position = point_IJK[axis] - extent[2 * axis];
+    int numberOfCells = extent[2 * axis + 1] - extent[2 * axis];
+    if (position < 0.0 || position > numberOfCells)
+      {
+      // outside the grid
+      return false;
+      }
+    cellIndex[axis] = std::min(static_cast<int>(position), std::max(numberOfCells - 1, 0));
+    fraction[axis] = position - cellIndex[axis];
+    if (numberOfCells == 0)
+      {
+      // single slice along this axis
+      increments[axis] = 0;
+      }
+    }
+
+  const double* cellDisplacement = this->Internal->Displacements
+    + (cellIndex[0] * increments[0] + cellIndex[1] * increments[1] + cellIndex[2] * increments[2]) * 3;
+  double displacement[3] = { 0.0, 0.0, 0.0 };
+  for (int corner = 0; corner < 8; corner++)
+    {
+    double weight = 1.0;
+    vtkIdType offset = 0;
+    for (int axis = 0; axis < 3; axis++)
+      {
+      if (corner & (1 << axis))
+        {
+        weight *= fraction[axis];
+        offset += increments[axis];
+        }
+      else
+        {
+        weight *= 1.0 - fraction[axis];
+        }
+      }
+    if (weight == 0.0)
+      {
+      continue;
+      }
+    const double* cornerDisplacement = cellDisplacement + offset * 3;
+    displacement[0] += weight * cornerDisplacement[0];
+    displacement[1] += weight * cornerDisplacement[1];
+    displacement[2] += weight * cornerDisplacement[2];
+    }
+
+  out[0] = in[0] + displacement[0];
+  out[1] = in[1] + displacement[1];
+  out[2] = in[2] + displacement[2];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkInverseDisplacementGridCache::GetInverseDisplacementGrid()
+{
+  if (!this->Internal->Valid)
+    {
+    return nullptr;
+    }
+  return this->Internal->InverseDisplacementGrid;
+}
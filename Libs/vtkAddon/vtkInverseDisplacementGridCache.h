@@ -0,0 +1,121 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+/// \brief vtkInverseDisplacementGridCache - explicit inverse of a warp transform
+/// sampled on a grid.
+///
+/// Inverting a displacement field or b-spline transform at a point requires an
+/// iterative (Newton) solve, which evaluates the forward transform many times.
+/// This class computes the inverse displacement once at each node of a grid
+/// (concurrently) and then computes the inverse of any point inside the grid
+/// by trilinear interpolation.
+///
+/// Building the grid costs about as much as inverting as many points as the grid
+/// has nodes, therefore transforms only use it after they have been asked to invert
+/// that many points (see RegisterInverseTransformedPoints).
+///
+
+#ifndef __vtkInverseDisplacementGridCache_h
+#define __vtkInverseDisplacementGridCache_h
+
+#include "vtkAddon.h"
+
+#include "vtkObject.h"
+
+class vtkImageData;
+class vtkMatrix4x4;
+
+class VTK_ADDON_EXPORT vtkInverseDisplacementGridCache : public vtkObject
+{
+public:
+  static vtkInverseDisplacementGridCache *New();
+  vtkTypeMacro(vtkInverseDisplacementGridCache,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  // Description:
+  // Function that computes the inverse of a point iteratively.
+  // It must be safe to call concurrently. Returns false if the iteration did not converge.
+  // Error is the distance between the input point and the forward-transformed inverse point.
+  typedef bool (*InversePointFunctionType)(void* clientData, const double in[3], double out[3], double* error);
+
+  // Description:
+  // Set the grid that the inverse displacement is computed on.
+  // The grid index to output transform must be invertible.
+  // Discards the cached inverse grid.
+  void SetGridGeometry(const int extent[6], vtkMatrix4x4* gridIndexToOutput);
+
+  // Description:
+  // Discard the cached inverse grid and reset the number of inverse transformed points.
+  void Invalidate();
+
+  // Description:
+  // Returns true if the inverse grid is computed and can be used.
+  bool IsValid();
+
+  // Description:
+  // Number of nodes of the grid.
+  vtkIdType GetNumberOfGridPoints();
+
+  // Description:
+  // Add to the number of points that have been inverse transformed since the last
+  // invalidation. Returns true if it is at least the number of grid points, i.e.,
+  // if computing the inverse grid is worth it. Can be called concurrently.
+  bool RegisterInverseTransformedPoints(vtkIdType numberOfPoints);
+
+  // Description:
+  // Compute the inverse grid using inversePointFunction at each grid node, unless
+  // it is already valid. Can be called concurrently: only the first caller computes
+  // the grid, the others wait for it.
+  // Returns false if the grid is empty.
+  bool Update(InversePointFunctionType inversePointFunction, void* clientData);
+
+  // Description:
+  // Compute the inverse of a point by interpolating the inverse grid.
+  // Returns false if the grid is not valid or the point is outside the grid,
+  // then the inverse must be computed iteratively.
+  bool InverseTransformPoint(const double in[3], double out[3]);
+
+  // Description:
+  // Inverse displacement vectors (in the output coordinate system) at the grid nodes.
+  // Origin and spacing are not set, the grid geometry is defined by the grid index
+  // to output transform.
+  vtkImageData* GetInverseDisplacementGrid();
+
+  // Description:
+  // Maximum error of the inverse at the grid nodes, computed in the last Update.
+  vtkGetMacro(MaximumError, double);
+
+  // Description:
+  // Number of grid nodes where the iterative inversion did not converge
+  // in the last Update.
+  vtkGetMacro(NumberOfConvergenceFailures, vtkIdType);
+
+  // Description:
+  // Number of threads used for computing the inverse grid.
+  // Default is 0, which uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+protected:
+  vtkInverseDisplacementGridCache();
+  ~vtkInverseDisplacementGridCache() override;
+
+  double MaximumError;
+  vtkIdType NumberOfConvergenceFailures;
+  int NumberOfThreads;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkInverseDisplacementGridCache(const vtkInverseDisplacementGridCache&) = delete;
+  void operator=(const vtkInverseDisplacementGridCache&) = delete;
+};
+
+#endif
@@ -10,9 +10,12 @@
 #include "vtkOrientedBSplineTransform.h"
 
 #include "vtkImageData.h"
+#include "vtkInverseDisplacementGridCache.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkPoints.h"
 
 #include <math.h>
 
@@ -85,6 +88,8 @@ vtkOrientedBSplineTransform::vtkOrientedBSplineTransform()
   this->GridIndexToOutputTransformMatrixCached = vtkMatrix4x4::New();
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
   this->InverseBulkTransformMatrixCached = vtkMatrix4x4::New();
+  this->InverseGridCaching = false;
+  this->InverseGridCache = vtkInverseDisplacementGridCache::New();
 }
 
 //----------------------------------------------------------------------------
@@ -107,6 +112,11 @@ vtkOrientedBSplineTransform::~vtkOrientedBSplineTransform()
     this->InverseBulkTransformMatrixCached->Delete();
     this->InverseBulkTransformMatrixCached=nullptr;
     }
+  if (this->InverseGridCache!=nullptr)
+    {
+    this->InverseGridCache->Delete();
+    this->InverseGridCache=nullptr;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -124,6 +134,9 @@ void vtkOrientedBSplineTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GetBulkTransformMatrix()->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "InverseGridCaching: " << (this->InverseGridCaching ? "On" : "Off") << "\n";
+  os << indent << "InverseGridCache:\n";
+  this->InverseGridCache->PrintSelf(os,indent.GetNextIndent());
 }
 
 //----------------------------------------------------------------------------
@@ -171,6 +184,59 @@ void vtkOrientedBSplineTransform::ForwardTransformPoint(const double inPointTemp
   outPoint[2] += displacement[2]*scale;
 }
 
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::ForwardTransformPoints(const double* inPoints,
+                                                        double* outPoints,
+                                                        vtkIdType numberOfPoints)
+{
+  // The spline function is already specialized for the coefficient scalar type,
+  // look up everything else once for the whole batch
+  const double (*bulkMatrix)[4] = this->BulkTransformMatrix ? this->BulkTransformMatrix->Element : nullptr;
+  const double (*outputToGridIndex)[4] = this->OutputToGridIndexTransformMatrixCached->Element;
+  void *gridPtr = this->GridPointer;
+  int *extent = this->GridExtent;
+  vtkIdType *increments = this->GridIncrements;
+  double scale = this->DisplacementScale;
+  int borderMode = this->BorderMode;
+  bool applySpline = (gridPtr != nullptr && this->CalculateSpline != nullptr);
+
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    // inPoints and outPoints may be the same array, so make a copy of the
+    // input before modifying the output
+    const double* inPointTemp = inPoints + 3 * pointIndex;
+    double inPoint[3] = { inPointTemp[0], inPointTemp[1], inPointTemp[2] };
+    double* outPoint = outPoints + 3 * pointIndex;
+
+    if (bulkMatrix)
+      {
+      vtkLinearTransformPoint(bulkMatrix, inPoint, outPoint);
+      }
+    else
+      {
+      outPoint[0] = inPoint[0];
+      outPoint[1] = inPoint[1];
+      outPoint[2] = inPoint[2];
+      }
+
+    if (!applySpline)
+      {
+      continue;
+      }
+
+    double point[3];
+    vtkLinearTransformPoint(outputToGridIndex, inPoint, point);
+
+    double displacement[3] = { 0.0, 0.0, 0.0 };
+    this->CalculateSpline(point, displacement, nullptr,
+                          gridPtr, extent, increments, borderMode);
+
+    outPoint[0] += displacement[0]*scale;
+    outPoint[1] += displacement[1]*scale;
+    outPoint[2] += displacement[2]*scale;
+    }
+}
+
 //----------------------------------------------------------------------------
 // calculate the derivative of the transform
 void vtkOrientedBSplineTransform::ForwardTransformDerivative(const double inPointTemp[3],
@@ -236,13 +302,22 @@ void vtkOrientedBSplineTransform::ForwardTransformDerivative(const double inPoin
 // singular.
 // Note that this is similar to vtkWarpTransform::InverseTransformPoint()
 // but has been optimized specifically for uniform grid transforms.
-void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPointTemp[3],
-                                                     double outPoint[3],
-                                                     double derivative[3][3])
+bool vtkOrientedBSplineTransform::SolveInverseTransform(const double inPointTemp[3],
+                                                double outPoint[3],
+                                                double derivative[3][3],
+                                                double* error,
+                                                const double* initialGuess)
 {
-  // inPointTemp and outPoint may be the same vector, so make a copy of the
-  // input before modifying the output
+  // inPointTemp, initialGuess and outPoint may be the same vector, so make a copy
+  // of the inputs before modifying the output
   double inPoint[3] = {inPointTemp[0],inPointTemp[1],inPointTemp[2]};
+  double guess[3] = {0.0, 0.0, 0.0};
+  if (initialGuess)
+    {
+    guess[0] = initialGuess[0];
+    guess[1] = initialGuess[1];
+    guess[2] = initialGuess[2];
+    }
 
   if (this->BulkTransformMatrix)
     {
@@ -260,7 +335,11 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
 
   if (!this->GridPointer || !this->CalculateSpline)
     {
-    return;
+    if (error)
+      {
+      *error = 0.0;
+      }
+    return true;
     }
 
   void *gridPtr = this->GridPointer;
@@ -282,22 +361,31 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   double f = 1.0;
   double a;
 
-  double inPoint_IJK[3];
-  // Convert the inPoint to i,j,k indices into the deformation grid
-  // plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
-
-  // first guess at inverse_IJK point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->CalculateSpline(inPoint_IJK, deltaP, nullptr,
-                        gridPtr, extent, increments, this->BorderMode);
+  if (initialGuess)
+    {
+    inverse[0] = guess[0];
+    inverse[1] = guess[1];
+    inverse[2] = guess[2];
+    }
+  else
+    {
+    double inPoint_IJK[3];
+    // Convert the inPoint to i,j,k indices into the deformation grid
+    // plus fractions
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, inPoint_IJK);
+
+    // first guess at inverse_IJK point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->CalculateSpline(inPoint_IJK, deltaP, nullptr,
+                          gridPtr, extent, increments, this->BorderMode);
 
-  double inverseBulkTransformedInPoint[3];
-  vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,inverseBulkTransformedInPoint);
+    double inverseBulkTransformedInPoint[3];
+    vtkLinearTransformPoint(this->InverseBulkTransformMatrixCached->Element,inPoint,inverseBulkTransformedInPoint);
 
-  inverse[0] = inverseBulkTransformedInPoint[0] - deltaP[0]*scale;
-  inverse[1] = inverseBulkTransformedInPoint[1] - deltaP[1]*scale;
-  inverse[2] = inverseBulkTransformedInPoint[2] - deltaP[2]*scale;
+    inverse[0] = inverseBulkTransformedInPoint[0] - deltaP[0]*scale;
+    inverse[1] = inverseBulkTransformedInPoint[1] - deltaP[1]*scale;
+    inverse[2] = inverseBulkTransformedInPoint[2] - deltaP[2]*scale;
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -418,17 +506,20 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
+  bool converged = true;
   if (iteration >= maxNumberOfIterations)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
+    functionValue = lastFunctionValue;
+    converged = false;
+    }
 
-    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                    ") error = " << sqrt(errorSquared) << " after " <<
-                    iteration << " iterations.");
+  if (error)
+    {
+    *error = sqrt(functionValue);
     }
 
   // Convert the inPoint to i,j,k indices into the deformation grid
@@ -436,6 +527,120 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::IterativeInverseTransformDerivative(const double inPoint[3],
+                                                              double outPoint[3],
+                                                              double derivative[3][3],
+                                                              const double* initialGuess)
+{
+  double error = 0.0;
+  if (!this->SolveInverseTransform(inPoint, outPoint, derivative, &error, initialGuess))
+    {
+    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                    ") error = " << error << " after " <<
+                    this->InverseIterations << " iterations.");
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::InverseTransformPoint(const double inPoint[3],
+                                                double outPoint[3])
+{
+  // the derivative won't be used, but it is required for Newton's method
+  double derivative[3][3];
+  this->InverseTransformDerivative(inPoint,outPoint,derivative);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoint[3],
+                                                     double outPoint[3],
+                                                     double derivative[3][3])
+{
+  // the interpolated inverse is only accurate to a fraction of the grid spacing,
+  // use it as starting point of Newton's method, which then needs few iterations
+  // to reach the inverse tolerance
+  double initialGuess[3];
+  if (this->UseInverseGrid(1) && this->InverseGridCache->InverseTransformPoint(inPoint, initialGuess))
+    {
+    this->IterativeInverseTransformDerivative(inPoint,outPoint,derivative,initialGuess);
+    return;
+    }
+
+  this->IterativeInverseTransformDerivative(inPoint,outPoint,derivative);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::InverseGridPointFunction(void* clientData,
+  const double in[3], double out[3], double* error)
+{
+  vtkOrientedBSplineTransform* self = static_cast<vtkOrientedBSplineTransform*>(clientData);
+  double derivative[3][3];
+  return self->SolveInverseTransform(in, out, derivative, error);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::UseInverseGrid(vtkIdType numberOfPoints)
+{
+  if (!this->InverseGridCaching || this->GridPointer == nullptr || this->CalculateSpline == nullptr)
+    {
+    return false;
+    }
+  if (this->InverseGridCache->IsValid())
+    {
+    return true;
+    }
+  if (!this->InverseGridCache->RegisterInverseTransformedPoints(numberOfPoints))
+    {
+    return false;
+    }
+  return this->ComputeInverseGrid();
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::ComputeInverseGrid()
+{
+  if (!this->InverseGridCache->Update(vtkOrientedBSplineTransform::InverseGridPointFunction, this))
+    {
+    return false;
+    }
+  if (this->InverseGridCache->GetNumberOfConvergenceFailures() > 0)
+    {
+    vtkWarningMacro("ComputeInverseGrid: no convergence at "
+                    << this->InverseGridCache->GetNumberOfConvergenceFailures()
+                    << " grid points, maximum error = " << this->InverseGridCache->GetMaximumError() << ".");
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::UpdateInverseGrid()
+{
+  this->Update();
+  if (!this->InverseGridCaching || this->GridPointer == nullptr || this->CalculateSpline == nullptr)
+    {
+    return false;
+    }
+  if (!this->ComputeInverseGrid())
+    {
+    return false;
+    }
+  return this->InverseGridCache->GetNumberOfConvergenceFailures() == 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::TransformPoints(vtkPoints *inPts, vtkPoints *outPts)
+{
+  if (this->InverseFlag && this->InverseGridCaching && inPts)
+    {
+    // compute the inverse grid right away if there are enough points
+    this->Update();
+    this->UseInverseGrid(inPts->GetNumberOfPoints());
+    }
+  this->Superclass::TransformPoints(inPts, outPts);
 }
 
 //----------------------------------------------------------------------------
@@ -444,6 +649,7 @@ void vtkOrientedBSplineTransform::InternalDeepCopy(vtkAbstractTransform *transfo
   vtkOrientedBSplineTransform *orientedBSplineTransform = (vtkOrientedBSplineTransform *)transform;
   this->SetGridDirectionMatrix(orientedBSplineTransform->GetGridDirectionMatrix());
   this->SetBulkTransformMatrix(orientedBSplineTransform ->GetBulkTransformMatrix());
+  this->SetInverseGridCaching(orientedBSplineTransform->GetInverseGridCaching());
 
   // Cached matrices will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
@@ -485,6 +691,21 @@ void vtkOrientedBSplineTransform::InternalUpdate()
     {
     vtkMatrix4x4::Invert(this->BulkTransformMatrix, this->InverseBulkTransformMatrixCached);
     }
+
+  // The inverse grid is computed when it is needed, on a grid that has a node
+  // at each control point and halfway between neighbor control points
+  int inverseGridExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkNew<vtkMatrix4x4> inverseGridIndexToGridIndex;
+  for (int axis = 0; axis < 3; axis++)
+    {
+    inverseGridExtent[2 * axis] = 2 * this->GridExtent[2 * axis];
+    inverseGridExtent[2 * axis + 1] = 2 * this->GridExtent[2 * axis + 1];
+    inverseGridIndexToGridIndex->SetElement(axis, axis, 0.5);
+    }
+  vtkNew<vtkMatrix4x4> inverseGridIndexToOutput;
+  vtkMatrix4x4::Multiply4x4(this->GridIndexToOutputTransformMatrixCached, inverseGridIndexToGridIndex.GetPointer(),
+    inverseGridIndexToOutput.GetPointer());
+  this->InverseGridCache->SetGridGeometry(inverseGridExtent, inverseGridIndexToOutput.GetPointer());
 }
 
 //----------------------------------------------------------------------------
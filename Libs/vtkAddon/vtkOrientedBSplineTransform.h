@@ -31,6 +31,8 @@
 
 #include "vtkBSplineTransform.h"
 
+class vtkInverseDisplacementGridCache;
+
 class VTK_ADDON_EXPORT vtkOrientedBSplineTransform : public vtkBSplineTransform
 {
 public:
@@ -56,6 +58,40 @@ public:
   virtual void SetBulkTransformMatrix(vtkMatrix4x4*);
   vtkGetObjectMacro(BulkTransformMatrix,vtkMatrix4x4);
 
+  // Description:
+  // Compute the inverse displacement once, on a grid twice as dense as the b-spline
+  // control point grid, and interpolate it when inverse transforming points, as starting
+  // point of the iterative inversion, which then converges in a few iterations. The
+  // inverse grid is computed when at least as many points are inverse transformed as
+  // the grid has nodes and it is recomputed after the transform is modified. Points
+  // outside the grid are inverted from the usual starting point. Default is off.
+  vtkSetMacro(InverseGridCaching, bool);
+  vtkGetMacro(InverseGridCaching, bool);
+  vtkBooleanMacro(InverseGridCaching, bool);
+
+  // Description:
+  // Compute the inverse grid now, if inverse grid caching is enabled.
+  // Returns false if the inverse grid cannot be computed or the iterative inversion
+  // did not converge at some grid nodes.
+  bool UpdateInverseGrid();
+
+  // Description:
+  // Cached inverse grid. Provides the accuracy of the inverse at the grid nodes.
+  vtkGetObjectMacro(InverseGridCache, vtkInverseDisplacementGridCache);
+
+  // Description:
+  // Apply the transformation to a series of points.
+  // Computes the inverse grid right away when inverse transforming many points.
+  void TransformPoints(vtkPoints *inPts, vtkPoints *outPts) override;
+
+  // Description:
+  // Apply the forward transformation to a contiguous array of points
+  // (x0, y0, z0, x1, y1, z1, ...), regardless of the inverse flag.
+  // inPoints and outPoints may be the same array.
+  // Update() must be called before, then it can be called concurrently.
+  void ForwardTransformPoints(const double* inPoints, double* outPoints,
+                              vtkIdType numberOfPoints);
+
 protected:
   vtkOrientedBSplineTransform();
   ~vtkOrientedBSplineTransform() override;
@@ -81,6 +117,34 @@ protected:
                                   double derivative[3][3]) override;
   using Superclass::InverseTransformDerivative; // Inherit the float version from parent
 
+  void InverseTransformPoint(const double in[3], double out[3]) override;
+  using Superclass::InverseTransformPoint; // Inherit the float version from parent
+
+  // Description:
+  // Invert the transformation using Newton's method, reporting convergence failures.
+  void IterativeInverseTransformDerivative(const double in[3], double out[3],
+                                           double derivative[3][3],
+                                           const double* initialGuess = nullptr);
+
+  // Description:
+  // Invert the transformation using Newton's method. Can be called concurrently.
+  // Returns false if the iteration did not converge. Error is the distance between
+  // the input point and the forward-transformed inverse point.
+  // If initialGuess is not null, the iteration starts from that point instead of
+  // the input point minus its displacement.
+  bool SolveInverseTransform(const double in[3], double out[3],
+                             double derivative[3][3], double* error,
+                             const double* initialGuess = nullptr);
+
+  // Description:
+  // Returns true if the inverse grid is to be used for inverse transforming
+  // numberOfPoints more points. Computes the inverse grid if it is worth it.
+  bool UseInverseGrid(vtkIdType numberOfPoints);
+
+  // Description:
+  // Compute the inverse grid, if it is not valid, and report convergence failures.
+  bool ComputeInverseGrid();
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -93,7 +157,12 @@ protected:
   vtkMatrix4x4* OutputToGridIndexTransformMatrixCached;
   vtkMatrix4x4* InverseBulkTransformMatrixCached;
 
+  bool InverseGridCaching;
+  vtkInverseDisplacementGridCache* InverseGridCache;
+
 private:
+  static bool InverseGridPointFunction(void* clientData, const double in[3], double out[3], double* error);
+
   vtkOrientedBSplineTransform(const vtkOrientedBSplineTransform&) = delete;
   void operator=(const vtkOrientedBSplineTransform&) = delete;
 };
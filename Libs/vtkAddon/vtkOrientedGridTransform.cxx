@@ -9,10 +9,12 @@
 
 #include "vtkOrientedGridTransform.h"
 
+#include "vtkInverseDisplacementGridCache.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkPoints.h"
 
 vtkStandardNewMacro(vtkOrientedGridTransform);
 
@@ -26,6 +28,9 @@ vtkOrientedGridTransform::vtkOrientedGridTransform()
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
 
   this->LastWarningMTime = 0;
+
+  this->InverseGridCaching = false;
+  this->InverseGridCache = vtkInverseDisplacementGridCache::New();
 }
 
 //----------------------------------------------------------------------------
@@ -42,6 +47,11 @@ vtkOrientedGridTransform::~vtkOrientedGridTransform()
     this->OutputToGridIndexTransformMatrixCached->Delete();
     this->OutputToGridIndexTransformMatrixCached = nullptr;
     }
+  if (this->InverseGridCache)
+    {
+    this->InverseGridCache->Delete();
+    this->InverseGridCache = nullptr;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -54,6 +64,9 @@ void vtkOrientedGridTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GridDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "InverseGridCaching: " << (this->InverseGridCaching ? "On" : "Off") << "\n";
+  os << indent << "InverseGridCache:\n";
+  this->InverseGridCache->PrintSelf(os,indent.GetNextIndent());
 }
 
 //------------------------------------------------------------------------
@@ -131,6 +144,121 @@ void vtkOrientedGridTransform::ForwardTransformPoint(const double inPoint[3],
   outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
 }
 
+//----------------------------------------------------------------------------
+// Trilinear interpolation of the displacement grid at a batch of points.
+// Same result as the linear interpolation function of vtkGridTransform (points
+// outside the grid get the displacement at the border of the grid), but the
+// grid scalar type is known at compile time and there is no function call per point.
+template <class T>
+void vtkOrientedGridLinearTransformPoints(const double matrix[4][4], const T* gridPtr,
+                                          const int extent[6], const vtkIdType increments[3],
+                                          double scale, double shift,
+                                          const double* inPoints, double* outPoints,
+                                          vtkIdType numberOfPoints)
+{
+  const int maxIndex[3] = { extent[1] - extent[0], extent[3] - extent[2], extent[5] - extent[4] };
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    const double* inPoint = inPoints + 3 * pointIndex;
+    double* outPoint = outPoints + 3 * pointIndex;
+
+    // Convert the inPoint to i,j,k indices into the deformation grid
+    // plus fractions
+    double point[3];
+    vtkLinearTransformPoint(matrix, inPoint, point);
+
+    vtkIdType offset0[3];
+    vtkIdType offset1[3];
+    double fraction[3];
+    for (int axis = 0; axis < 3; axis++)
+      {
+      int index0 = vtkMath::Floor(point[axis]);
+      fraction[axis] = point[axis] - index0;
+      index0 -= extent[2 * axis];
+      int index1 = index0 + 1;
+      // clamp to the border of the grid
+      if (index0 < 0)
+        {
+        index0 = 0;
+        index1 = 0;
+        fraction[axis] = 0.0;
+        }
+      else if (index1 > maxIndex[axis])
+        {
+        index0 = maxIndex[axis];
+        index1 = maxIndex[axis];
+        fraction[axis] = 0.0;
+        }
+      offset0[axis] = index0 * increments[axis];
+      offset1[axis] = index1 * increments[axis];
+      }
+
+    const T* v000 = gridPtr + offset0[0] + offset0[1] + offset0[2];
+    const T* v001 = gridPtr + offset1[0] + offset0[1] + offset0[2];
+    const T* v010 = gridPtr + offset0[0] + offset1[1] + offset0[2];
+    const T* v011 = gridPtr + offset1[0] + offset1[1] + offset0[2];
+    const T* v100 = gridPtr + offset0[0] + offset0[1] + offset1[2];
+    const T* v101 = gridPtr + offset1[0] + offset0[1] + offset1[2];
+    const T* v110 = gridPtr + offset0[0] + offset1[1] + offset1[2];
+    const T* v111 = gridPtr + offset1[0] + offset1[1] + offset1[2];
+
+    double fx = fraction[0];
+    double fy = fraction[1];
+    double fz = fraction[2];
+    double rx = 1.0 - fx;
+    double ry = 1.0 - fy;
+    double rz = 1.0 - fz;
+    double w000 = rx * ry * rz;
+    double w001 = fx * ry * rz;
+    double w010 = rx * fy * rz;
+    double w011 = fx * fy * rz;
+    double w100 = rx * ry * fz;
+    double w101 = fx * ry * fz;
+    double w110 = rx * fy * fz;
+    double w111 = fx * fy * fz;
+
+    double displacement[3];
+    for (int i = 0; i < 3; i++)
+      {
+      displacement[i] = w000 * v000[i] + w001 * v001[i] + w010 * v010[i] + w011 * v011[i]
+        + w100 * v100[i] + w101 * v101[i] + w110 * v110[i] + w111 * v111[i];
+      }
+
+    outPoint[0] = inPoint[0] + (displacement[0]*scale + shift);
+    outPoint[1] = inPoint[1] + (displacement[1]*scale + shift);
+    outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::ForwardTransformPoints(const double* inPoints,
+                                                     double* outPoints,
+                                                     vtkIdType numberOfPoints)
+{
+  if (this->GridDirectionMatrix == nullptr || this->GridPointer == nullptr
+    || this->InterpolationMode != VTK_LINEAR_INTERPOLATION)
+    {
+    // no specialized kernel, transform the points one by one
+    for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+      {
+      this->ForwardTransformPoint(inPoints + 3 * pointIndex, outPoints + 3 * pointIndex);
+      }
+    return;
+    }
+
+  switch (this->GridScalarType)
+    {
+    vtkTemplateMacro(vtkOrientedGridLinearTransformPoints(
+      this->OutputToGridIndexTransformMatrixCached->Element,
+      static_cast<const VTK_TT*>(this->GridPointer), this->GridExtent, this->GridIncrements,
+      this->DisplacementScale, this->DisplacementShift,
+      inPoints, outPoints, numberOfPoints));
+    default:
+      vtkErrorMacro("ForwardTransformPoints: unsupported grid scalar type " << this->GridScalarType);
+      break;
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkOrientedGridTransform::ForwardTransformDerivative(const double inPoint[3],
                                                   double outPoint[3],
@@ -174,10 +302,38 @@ void vtkOrientedGridTransform::ForwardTransformDerivative(const double inPoint[3
   outPoint[2] = inPoint[2] + (displacement[2]*scale + shift);
 }
 
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::InverseTransformPoint(const double inPoint[3],
+                                             double outPoint[3])
+{
+  // the derivative won't be used, but it is required for Newton's method
+  double derivative[3][3];
+  this->InverseTransformDerivative(inPoint,outPoint,derivative);
+}
+
 //----------------------------------------------------------------------------
 void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3],
                                                   double outPoint[3],
                                                   double derivative[3][3])
+{
+  // the interpolated inverse is only accurate to a fraction of the grid spacing,
+  // use it as starting point of Newton's method, which then needs few iterations
+  // to reach the inverse tolerance
+  double initialGuess[3];
+  if (this->UseInverseGrid(1) && this->InverseGridCache->InverseTransformPoint(inPoint, initialGuess))
+    {
+    this->IterativeInverseTransformDerivative(inPoint,outPoint,derivative,initialGuess);
+    return;
+    }
+
+  this->IterativeInverseTransformDerivative(inPoint,outPoint,derivative);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::IterativeInverseTransformDerivative(const double inPoint[3],
+                                                           double outPoint[3],
+                                                           double derivative[3][3],
+                                                           const double* initialGuess)
 {
   if (this->GridDirectionMatrix == nullptr || this->GridPointer == nullptr)
     {
@@ -185,6 +341,29 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     return;
     }
 
+  double error = 0.0;
+  if (!this->SolveInverseTransform(inPoint, outPoint, derivative, &error, initialGuess))
+    {
+    if (this->MTime > this->LastWarningMTime)
+      {
+      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                      ") error = " << error << " after " <<
+                      this->InverseIterations << " iterations."
+                      "  Further convergence warnings suppressed until transform is modified.");
+      this->LastWarningMTime = this->MTime;
+      }
+    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::SolveInverseTransform(const double inPoint[3],
+                                             double outPoint[3],
+                                             double derivative[3][3],
+                                             double* error,
+                                             const double* initialGuess)
+{
   void *gridPtr = this->GridPointer;
   int gridType = this->GridScalarType;
 
@@ -208,17 +387,26 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
   double f = 1.0;
   double a;
 
-  // convert the inPoint to i,j,k indices plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+  if (initialGuess)
+    {
+    inverse[0] = initialGuess[0];
+    inverse[1] = initialGuess[1];
+    inverse[2] = initialGuess[2];
+    }
+  else
+    {
+    // convert the inPoint to i,j,k indices plus fractions
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
 
-  // first guess at inverse point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->InterpolationFunction(point, deltaP, nullptr,
-                              gridPtr, gridType, extent, increments);
+    // first guess at inverse point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->InterpolationFunction(point, deltaP, nullptr,
+                                gridPtr, gridType, extent, increments);
 
-  inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
-  inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
-  inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
+    inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
+    inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -317,29 +505,103 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
 
   vtkDebugMacro("Inverse Iterations: " << (i+1));
 
+  bool converged = true;
   if (i >= n)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
+    functionValue = lastFunctionValue;
+    converged = false;
+    }
+
+  if (error)
+    {
+    *error = sqrt(functionValue);
+    }
+
+  // convert point
+  outPoint[0] = inverse[0];
+  outPoint[1] = inverse[1];
+  outPoint[2] = inverse[2];
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InverseGridPointFunction(void* clientData,
+  const double in[3], double out[3], double* error)
+{
+  vtkOrientedGridTransform* self = static_cast<vtkOrientedGridTransform*>(clientData);
+  double derivative[3][3];
+  return self->SolveInverseTransform(in, out, derivative, error);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::UseInverseGrid(vtkIdType numberOfPoints)
+{
+  if (!this->InverseGridCaching || this->GridPointer == nullptr)
+    {
+    return false;
+    }
+  if (this->InverseGridCache->IsValid())
+    {
+    return true;
+    }
+  if (!this->InverseGridCache->RegisterInverseTransformedPoints(numberOfPoints))
+    {
+    return false;
+    }
+  return this->ComputeInverseGrid();
+}
 
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::ComputeInverseGrid()
+{
+  if (!this->InverseGridCache->Update(vtkOrientedGridTransform::InverseGridPointFunction, this))
+    {
+    return false;
+    }
+  if (this->InverseGridCache->GetNumberOfConvergenceFailures() > 0)
+    {
     if (this->MTime > this->LastWarningMTime)
       {
-      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                      ") error = " << sqrt(errorSquared) << " after " <<
-                      i << " iterations."
+      vtkWarningMacro("ComputeInverseGrid: no convergence at "
+                      << this->InverseGridCache->GetNumberOfConvergenceFailures()
+                      << " grid points, maximum error = " << this->InverseGridCache->GetMaximumError() << "."
                       "  Further convergence warnings suppressed until transform is modified.");
       this->LastWarningMTime = this->MTime;
       }
     this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
     }
+  return true;
+}
 
-  // convert point
-  outPoint[0] = inverse[0];
-  outPoint[1] = inverse[1];
-  outPoint[2] = inverse[2];
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::UpdateInverseGrid()
+{
+  this->Update();
+  if (!this->InverseGridCaching || this->GridPointer == nullptr)
+    {
+    return false;
+    }
+  if (!this->ComputeInverseGrid())
+    {
+    return false;
+    }
+  return this->InverseGridCache->GetNumberOfConvergenceFailures() == 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::TransformPoints(vtkPoints *inPts, vtkPoints *outPts)
+{
+  if (this->InverseFlag && this->InverseGridCaching && inPts)
+    {
+    // compute the inverse grid right away if there are enough points
+    this->Update();
+    this->UseInverseGrid(inPts->GetNumberOfPoints());
+    }
+  this->Superclass::TransformPoints(inPts, outPts);
 }
 
 //----------------------------------------------------------------------------
@@ -348,6 +610,7 @@ void vtkOrientedGridTransform::InternalDeepCopy(vtkAbstractTransform *transform)
   vtkOrientedGridTransform *gridTransform = (vtkOrientedGridTransform *)transform;
 
   this->SetGridDirectionMatrix(gridTransform->GetGridDirectionMatrix());
+  this->SetInverseGridCaching(gridTransform->GetInverseGridCaching());
 
   // Cached matrices will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
@@ -385,6 +648,8 @@ void vtkOrientedGridTransform::InternalUpdate()
   // Compute Output to GridIndex transform
   vtkMatrix4x4::Invert(this->GridIndexToOutputTransformMatrixCached, this->OutputToGridIndexTransformMatrixCached);
 
+  // The inverse grid is computed on the displacement grid, when it is needed
+  this->InverseGridCache->SetGridGeometry(this->GridExtent, this->GridIndexToOutputTransformMatrixCached);
 }
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,313 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkCylinderSource.h>
+#include <vtkDataArray.h>
+#include <vtkImageChangeInformation.h>
+#include <vtkImageStencilToImage.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkPolyDataToImageStencil.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+// SegmentationCore includes
+#include "vtkBrushRasterizer.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// 0.5mm isotropic labelmap, rotated around the z axis
+vtkSmartPointer<vtkOrientedImageData> CreateLabelmap(int size)
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  labelmap->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+  labelmap->SetSpacing(0.5, 0.5, 0.5);
+  labelmap->SetOrigin(-10.0, -20.0, -30.0);
+  double angle = vtkMath::RadiansFromDegrees(30.0);
+  double directions[3][3] = { { cos(angle), -sin(angle), 0.0 }, { sin(angle), cos(angle), 0.0 }, { 0.0, 0.0, 1.0 } };
+  labelmap->SetDirections(directions);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  return labelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPoints> CreateStroke(vtkOrientedImageData* labelmap, int numberOfPoints, double step)
+{
+  // Start at the center of the labelmap
+  double bounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+  labelmap->GetBounds(bounds);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    points->InsertNextPoint((bounds[0] + bounds[1]) / 2.0 + i * step,
+      (bounds[2] + bounds[3]) / 2.0 + i * step * 0.3, (bounds[4] + bounds[5]) / 2.0 + 0.1);
+    }
+  return points;
+}
+
+//----------------------------------------------------------------------------
+/// Paint the brush model at each point by stamping its stencil, as the paint
+/// effect did before vtkBrushRasterizer.
+void PaintWithStencil(vtkOrientedImageData* labelmap, vtkPolyData* brushModel, vtkPoints* points)
+{
+  vtkNew<vtkPolyDataNormals> normals;
+  normals->SetInputData(brushModel);
+  normals->AutoOrientNormalsOn();
+
+  vtkNew<vtkMatrix4x4> worldToIjkMatrix;
+  labelmap->GetWorldToImageMatrix(worldToIjkMatrix.GetPointer());
+  vtkNew<vtkTransform> worldOriginToIjkTransform;
+  worldOriginToIjkTransform->SetMatrix(worldToIjkMatrix.GetPointer());
+  worldOriginToIjkTransform->PostMultiply();
+  double* translation = worldOriginToIjkTransform->GetPosition();
+  worldOriginToIjkTransform->Translate(-translation[0], -translation[1], -translation[2]);
+  vtkNew<vtkTransformPolyDataFilter> brushToIjk;
+  brushToIjk->SetInputConnection(normals->GetOutputPort());
+  brushToIjk->SetTransform(worldOriginToIjkTransform.GetPointer());
+  brushToIjk->Update();
+  double* boundsIjk = brushToIjk->GetOutput()->GetBounds();
+
+  vtkNew<vtkPolyDataToImageStencil> brushToStencil;
+  brushToStencil->SetInputConnection(brushToIjk->GetOutputPort());
+  brushToStencil->SetOutputSpacing(1.0, 1.0, 1.0);
+  brushToStencil->SetOutputWholeExtent(floor(boundsIjk[0]) - 1, ceil(boundsIjk[1]) + 1,
+    floor(boundsIjk[2]) - 1, ceil(boundsIjk[3]) + 1, floor(boundsIjk[4]) - 1, ceil(boundsIjk[5]) + 1);
+  vtkNew<vtkImageStencilToImage> stencilToImage;
+  stencilToImage->SetInputConnection(brushToStencil->GetOutputPort());
+  stencilToImage->SetInsideValue(1);
+  stencilToImage->SetOutsideValue(0);
+  stencilToImage->SetOutputScalarType(labelmap->GetScalarType());
+  vtkNew<vtkImageChangeInformation> brushPositioner;
+  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
+  brushPositioner->SetOutputSpacing(labelmap->GetSpacing());
+  brushPositioner->SetOutputOrigin(labelmap->GetOrigin());
+
+  for (vtkIdType pointIndex = 0; pointIndex < points->GetNumberOfPoints(); ++pointIndex)
+    {
+    double point[4] = { 0.0, 0.0, 0.0, 1.0 };
+    points->GetPoint(pointIndex, point);
+    double pointIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+    worldToIjkMatrix->MultiplyPoint(point, pointIjk);
+    int shift[3] = { int(floor(pointIjk[0] + 0.5)), int(floor(pointIjk[1] + 0.5)), int(floor(pointIjk[2] + 0.5)) };
+    brushPositioner->SetExtentTranslation(shift);
+    brushPositioner->Update();
+    vtkNew<vtkOrientedImageData> brushImage;
+    brushImage->ShallowCopy(brushPositioner->GetOutput());
+    brushImage->CopyDirections(labelmap);
+    vtkOrientedImageDataResample::ModifyImage(labelmap, brushImage.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+    }
+}
+
+//----------------------------------------------------------------------------
+void GetVoxelCounts(vtkImageData* labelmap1, vtkImageData* labelmap2, vtkIdType& paintedCount, vtkIdType& differenceCount)
+{
+  unsigned char* ptr1 = static_cast<unsigned char*>(labelmap1->GetScalarPointer());
+  unsigned char* ptr2 = static_cast<unsigned char*>(labelmap2->GetScalarPointer());
+  paintedCount = 0;
+  differenceCount = 0;
+  for (vtkIdType i = 0; i < labelmap1->GetNumberOfPoints(); ++i)
+    {
+    paintedCount += (ptr1[i] ? 1 : 0);
+    differenceCount += (ptr1[i] != ptr2[i] ? 1 : 0);
+    }
+}
+
+//----------------------------------------------------------------------------
+int TestSameAsStencil(bool sphere)
+{
+  vtkSmartPointer<vtkOrientedImageData> stencilLabelmap = CreateLabelmap(100);
+  vtkSmartPointer<vtkOrientedImageData> rasterizerLabelmap = CreateLabelmap(100);
+  vtkSmartPointer<vtkPoints> points = CreateStroke(stencilLabelmap, 5, 3.0);
+  const double radius = 5.0;
+  const double height = 0.5;
+
+  vtkNew<vtkBrushRasterizer> rasterizer;
+  rasterizer->SetRadius(radius);
+  vtkSmartPointer<vtkPolyData> brushModel;
+  if (sphere)
+    {
+    vtkNew<vtkSphereSource> sphereSource;
+    sphereSource->SetRadius(radius);
+    sphereSource->SetPhiResolution(32);
+    sphereSource->SetThetaResolution(32);
+    sphereSource->Update();
+    brushModel = sphereSource->GetOutput();
+    rasterizer->SetBrushShapeToSphere();
+    }
+  else
+    {
+    vtkNew<vtkCylinderSource> cylinderSource;
+    cylinderSource->SetRadius(radius);
+    cylinderSource->SetHeight(height);
+    cylinderSource->SetResolution(32);
+    vtkNew<vtkTransform> rotation;
+    rotation->RotateX(90); // cylinder's long axis is the Y axis
+    vtkNew<vtkTransformPolyDataFilter> rotator;
+    rotator->SetInputConnection(cylinderSource->GetOutputPort());
+    rotator->SetTransform(rotation.GetPointer());
+    rotator->Update();
+    brushModel = rotator->GetOutput();
+    rasterizer->SetBrushShapeToCylinder();
+    rasterizer->SetHeight(height);
+    rasterizer->SetAxis(0.0, 0.0, 1.0);
+    }
+
+  PaintWithStencil(stencilLabelmap, brushModel, points);
+  int paintedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  if (!rasterizer->Paint(rasterizerLabelmap, points, 1, paintedExtent))
+    {
+    std::cerr << __LINE__ << ": Paint failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (paintedExtent[0] > paintedExtent[1] || paintedExtent[4] > paintedExtent[5])
+    {
+    std::cerr << __LINE__ << ": Empty painted extent" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Only the voxels on the border of the brush may differ: the stencil is
+  // computed from a polygonal approximation of the brush.
+  vtkIdType paintedCount = 0;
+  vtkIdType differenceCount = 0;
+  GetVoxelCounts(stencilLabelmap, rasterizerLabelmap, paintedCount, differenceCount);
+  std::cout << (sphere ? "Sphere" : "Cylinder") << " brush: " << paintedCount << " voxels painted with stencil, "
+    << differenceCount << " different voxels" << std::endl;
+  if (paintedCount == 0 || differenceCount > paintedCount / 20)
+    {
+    std::cerr << __LINE__ << ": Rasterized brush does not match stencil brush" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSweep()
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmap = CreateLabelmap(100);
+  vtkSmartPointer<vtkPoints> points = CreateStroke(labelmap, 2, 10.0);
+  double* start = points->GetPoint(0);
+  double* end = points->GetPoint(1);
+  double middle[3] = { (start[0] + end[0]) / 2.0, (start[1] + end[1]) / 2.0, (start[2] + end[2]) / 2.0 };
+  int middleIjk[3] = { 0, 0, 0 };
+  vtkNew<vtkMatrix4x4> worldToIjkMatrix;
+  labelmap->GetWorldToImageMatrix(worldToIjkMatrix.GetPointer());
+  double middleHomogeneous[4] = { middle[0], middle[1], middle[2], 1.0 };
+  double middleIjkDouble[4] = { 0.0, 0.0, 0.0, 1.0 };
+  worldToIjkMatrix->MultiplyPoint(middleHomogeneous, middleIjkDouble);
+  for (int i = 0; i < 3; ++i)
+    {
+    middleIjk[i] = static_cast<int>(floor(middleIjkDouble[i] + 0.5));
+    }
+
+  vtkNew<vtkBrushRasterizer> rasterizer;
+  rasterizer->SetRadius(2.0);
+  rasterizer->Paint(labelmap, points, 1);
+  if (labelmap->GetScalarComponentAsDouble(middleIjk[0], middleIjk[1], middleIjk[2], 0) != 0.0)
+    {
+    std::cerr << __LINE__ << ": Voxel between brush stamps is painted" << std::endl;
+    return EXIT_FAILURE;
+    }
+  rasterizer->SweepOn();
+  rasterizer->Paint(labelmap, points, 1);
+  if (labelmap->GetScalarComponentAsDouble(middleIjk[0], middleIjk[1], middleIjk[2], 0) != 1.0)
+    {
+    std::cerr << __LINE__ << ": Voxel between brush positions is not painted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Brush outside of the image
+  vtkNew<vtkPoints> outsidePoints;
+  outsidePoints->InsertNextPoint(1000.0, 1000.0, 1000.0);
+  int paintedExtent[6] = { 0, 0, 0, 0, 0, 0 };
+  if (!rasterizer->Paint(labelmap, outsidePoints.GetPointer(), 1, paintedExtent)
+    || paintedExtent[0] <= paintedExtent[1])
+    {
+    std::cerr << __LINE__ << ": Brush outside of the image painted extent is not empty" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestPerformance(double radius)
+{
+  const int numberOfStrokes = 5;
+  vtkSmartPointer<vtkOrientedImageData> labelmap = CreateLabelmap(200);
+  vtkSmartPointer<vtkPoints> points = CreateStroke(labelmap, 20, 1.0);
+  vtkNew<vtkSphereSource> sphereSource;
+  sphereSource->SetRadius(radius);
+  sphereSource->SetPhiResolution(32);
+  sphereSource->SetThetaResolution(32);
+  sphereSource->Update();
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int stroke = 0; stroke < numberOfStrokes; ++stroke)
+    {
+    PaintWithStencil(labelmap, sphereSource->GetOutput(), points);
+    }
+  timer->StopTimer();
+  double stencilStrokesPerSecond = numberOfStrokes / timer->GetElapsedTime();
+
+  vtkNew<vtkBrushRasterizer> rasterizer;
+  rasterizer->SetRadius(radius);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  timer->StartTimer();
+  for (int stroke = 0; stroke < numberOfStrokes; ++stroke)
+    {
+    rasterizer->Paint(labelmap, points, 1);
+    }
+  timer->StopTimer();
+  double rasterizerStrokesPerSecond = numberOfStrokes / timer->GetElapsedTime();
+
+  std::cout << "Sphere brush radius " << radius << "mm, 0.5mm voxels, " << points->GetNumberOfPoints() << " points per stroke:"
+    << " stencil: " << stencilStrokesPerSecond << " strokes/s"
+    << " vtkBrushRasterizer: " << rasterizerStrokesPerSecond << " strokes/s" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkBrushRasterizerTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  if (TestSameAsStencil(true) != EXIT_SUCCESS
+    || TestSameAsStencil(false) != EXIT_SUCCESS
+    || TestSweep() != EXIT_SUCCESS
+    || TestPerformance(5.0) != EXIT_SUCCESS
+    || TestPerformance(15.0) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Brush rasterizer test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+  #include <vtkDiscreteFlyingEdges3D.h>
+#else
+  #include <vtkDiscreteMarchingCubes.h>
+#endif
+#include <vtkImageConstantPad.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// SegmentationCore includes
+#include "vtkMultiLabelSurfaceExtractor.h"
+
+namespace
+{
+
+const int NumberOfLabels = 12;
+const int CellSize = 24;
+
+//----------------------------------------------------------------------------
+/// Labelmap with spheres of different sizes on a grid. The last sphere is cut by the image boundary.
+vtkSmartPointer<vtkImageData> CreateSpheresLabelmap()
+{
+  const int spheresPerRow = 4;
+  int numberOfRows = (NumberOfLabels + spheresPerRow - 1) / spheresPerRow;
+  vtkSmartPointer<vtkImageData> labelmap = vtkSmartPointer<vtkImageData>::New();
+  labelmap->SetExtent(0, spheresPerRow * CellSize - 1, 0, numberOfRows * CellSize - 1, 0, CellSize - 1);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* voxels = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  for (int k = 0; k < CellSize; ++k)
+    {
+    for (int j = 0; j < numberOfRows * CellSize; ++j)
+      {
+      for (int i = 0; i < spheresPerRow * CellSize; ++i)
+        {
+        int label = (j / CellSize) * spheresPerRow + (i / CellSize);
+        double radius = 3.0 + (label % 5) * 2.0;
+        double di = i % CellSize - CellSize / 2.0;
+        double dj = j % CellSize - CellSize / 2.0;
+        double dk = k - CellSize / 2.0;
+        if (label == NumberOfLabels - 1)
+          {
+          // touches the last slice
+          radius = CellSize / 2.0;
+          dk = k - (CellSize - 1);
+          }
+        bool inside = (di * di + dj * dj + dk * dk < radius * radius);
+        *(voxels++) = (inside ? label + 1 : 0);
+        }
+      }
+    }
+  return labelmap;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMultiLabelSurfaceExtractorTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkImageData> labelmap = CreateSpheresLabelmap();
+
+  // Label extents
+  vtkMultiLabelSurfaceExtractor::LabelExtentMap labelExtents;
+  vtkMultiLabelSurfaceExtractor::ComputeLabelExtents(labelmap, labelExtents);
+  if (labelExtents.size() != NumberOfLabels)
+    {
+    std::cerr << __LINE__ << ": Expected " << NumberOfLabels << " label extents, got " << labelExtents.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  // label 1 is a sphere of radius 3 in the center of the first cell
+  const std::array<int, 6>& firstExtent = labelExtents[1];
+  int expectedFirstExtent[6] = { 10, 14, 10, 14, 10, 14 };
+  for (int i = 0; i < 6; ++i)
+    {
+    if (firstExtent[i] != expectedFirstExtent[i])
+      {
+      std::cerr << __LINE__ << ": Label extent mismatch: extent[" << i << "] = " << firstExtent[i]
+        << ", expected " << expectedFirstExtent[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  vtkMultiLabelSurfaceExtractor::LabelExtentMap singleThreadLabelExtents;
+  vtkMultiLabelSurfaceExtractor::ComputeLabelExtents(labelmap, singleThreadLabelExtents, 1);
+  if (singleThreadLabelExtents != labelExtents)
+    {
+    std::cerr << __LINE__ << ": Label extents depend on the number of threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Surfaces must be the same as the ones extracted from the whole padded labelmap
+  std::vector<int> labelValues;
+  for (int label = 1; label <= NumberOfLabels; ++label)
+    {
+    labelValues.push_back(label);
+    }
+  labelValues.push_back(NumberOfLabels + 1); // not in the labelmap
+
+  vtkNew<vtkMultiLabelSurfaceExtractor> surfaceExtractor;
+  std::vector<vtkSmartPointer<vtkPolyData> > surfaces;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!surfaceExtractor->Extract(labelmap, labelValues, surfaces))
+    {
+    std::cerr << __LINE__ << ": Extract failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  double extractorTime = timer->GetElapsedTime();
+  if (surfaces.size() != labelValues.size())
+    {
+    std::cerr << __LINE__ << ": Expected " << labelValues.size() << " surfaces, got " << surfaces.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (surfaces.back()->GetNumberOfPoints() != 0)
+    {
+    std::cerr << __LINE__ << ": Surface of missing label is not empty" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkImageConstantPad> padder;
+  padder->SetInputData(labelmap);
+  int* extent = labelmap->GetExtent();
+  padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
+  padder->Update();
+  timer->StartTimer();
+  for (int label = 1; label <= NumberOfLabels; ++label)
+    {
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+    vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
+#else
+    vtkNew<vtkDiscreteMarchingCubes> marchingCubes;
+#endif
+    marchingCubes->SetInputConnection(padder->GetOutputPort());
+    marchingCubes->ComputeGradientsOff();
+    marchingCubes->ComputeNormalsOff();
+    marchingCubes->SetValue(0, label);
+    marchingCubes->Update();
+    vtkPolyData* expectedSurface = marchingCubes->GetOutput();
+    vtkPolyData* surface = surfaces[label - 1];
+    if (surface->GetNumberOfPoints() == 0
+      || surface->GetNumberOfPoints() != expectedSurface->GetNumberOfPoints()
+      || surface->GetNumberOfPolys() != expectedSurface->GetNumberOfPolys())
+      {
+      std::cerr << __LINE__ << ": Surface mismatch for label " << label << ": "
+        << surface->GetNumberOfPoints() << " points (expected " << expectedSurface->GetNumberOfPoints() << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    double bounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+    double expectedBounds[6] = { 0.0, -1.0, 0.0, -1.0, 0.0, -1.0 };
+    surface->GetBounds(bounds);
+    expectedSurface->GetBounds(expectedBounds);
+    for (int i = 0; i < 6; ++i)
+      {
+      if (std::abs(bounds[i] - expectedBounds[i]) > 1e-6)
+        {
+        std::cerr << __LINE__ << ": Surface bounds mismatch for label " << label << ": bounds[" << i << "] = "
+          << bounds[i] << ", expected " << expectedBounds[i] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  timer->StopTimer();
+  double wholeImageTime = timer->GetElapsedTime();
+
+  // Without boundary padding, the surface of the label that touches the boundary is open
+  surfaceExtractor->PadBoundaryOff();
+  vtkNew<vtkPolyData> openSurface;
+  surfaceExtractor->ExtractLabel(labelmap, NumberOfLabels, openSurface.GetPointer());
+  if (openSurface->GetNumberOfPolys() == 0
+    || openSurface->GetNumberOfPolys() >= surfaces[NumberOfLabels - 1]->GetNumberOfPolys())
+    {
+    std::cerr << __LINE__ << ": Expected fewer polygons without boundary padding, got "
+      << openSurface->GetNumberOfPolys() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Smoothing and decimation are applied
+  surfaceExtractor->PadBoundaryOn();
+  surfaceExtractor->SetDecimationFactor(0.5);
+  surfaceExtractor->SetSmoothingIterations(20);
+  vtkNew<vtkPolyData> processedSurface;
+  surfaceExtractor->ExtractLabel(labelmap, NumberOfLabels, processedSurface.GetPointer(), &labelExtents);
+  if (processedSurface->GetNumberOfPolys() == 0
+    || processedSurface->GetNumberOfPolys() >= surfaces[NumberOfLabels - 1]->GetNumberOfPolys())
+    {
+    std::cerr << __LINE__ << ": Expected fewer polygons after decimation, got "
+      << processedSurface->GetNumberOfPolys() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << NumberOfLabels << " label surfaces extracted: "
+    << "whole image per label: " << wholeImageTime << "s, "
+    << "multi-label extractor: " << extractorTime << "s" << std::endl;
+  return EXIT_SUCCESS;
+}
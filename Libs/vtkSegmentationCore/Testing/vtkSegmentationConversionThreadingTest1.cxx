@@ -0,0 +1,176 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+// SegmentationCore includes
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+#include "vtkSegmentationConverterFactory.h"
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Labelmap with numberOfLabels spheres of different sizes on a grid
+vtkSmartPointer<vtkOrientedImageData> CreateSpheresLabelmap(int numberOfLabels, int firstLabel)
+{
+  const int spheresPerRow = 4;
+  const int cellSize = 32;
+  int numberOfRows = (numberOfLabels + spheresPerRow - 1) / spheresPerRow;
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  labelmap->SetExtent(0, spheresPerRow * cellSize - 1, 0, numberOfRows * cellSize - 1, 0, cellSize - 1);
+  labelmap->SetSpacing(0.8, 0.8, 1.5);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(labelmap->GetScalarPointer());
+  int dimensions[3] = { 0, 0, 0 };
+  labelmap->GetDimensions(dimensions);
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        int label = (j / cellSize) * spheresPerRow + (i / cellSize);
+        double radius = 4.0 + (label % 6) * 2.0;
+        double di = i % cellSize - cellSize / 2.0;
+        double dj = j % cellSize - cellSize / 2.0;
+        double dk = k - cellSize / 2.0;
+        bool inside = (label < numberOfLabels && di * di + dj * dj + dk * dk < radius * radius);
+        *(voxels++) = (inside ? firstLabel + label : 0);
+        }
+      }
+    }
+  return labelmap;
+}
+
+//----------------------------------------------------------------------------
+/// Segmentation with segments stored in two shared labelmap layers
+vtkSmartPointer<vtkSegmentation> CreateSegmentation(int numberOfSegmentsPerLayer)
+{
+  vtkSmartPointer<vtkSegmentation> segmentation = vtkSmartPointer<vtkSegmentation>::New();
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  for (int layer = 0; layer < 2; ++layer)
+    {
+    vtkSmartPointer<vtkOrientedImageData> labelmap = CreateSpheresLabelmap(numberOfSegmentsPerLayer, 1);
+    for (int label = 1; label <= numberOfSegmentsPerLayer; ++label)
+      {
+      vtkNew<vtkSegment> segment;
+      segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+      segment->SetLabelValue(label);
+      segmentation->AddSegment(segment.GetPointer());
+      }
+    }
+  return segmentation;
+}
+
+//----------------------------------------------------------------------------
+class RepresentationModifiedCounter : public vtkCommand
+{
+public:
+  static RepresentationModifiedCounter* New() { return new RepresentationModifiedCounter; }
+  void Execute(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eventId), void* vtkNotUsed(callData)) override
+    {
+    this->Count++;
+    }
+  int Count = 0;
+};
+
+//----------------------------------------------------------------------------
+bool ConvertToClosedSurface(vtkSegmentation* segmentation, int numberOfThreads, double& elapsedTime)
+{
+  segmentation->SetNumberOfConversionThreads(numberOfThreads);
+  vtkNew<RepresentationModifiedCounter> counter;
+  segmentation->AddObserver(vtkSegmentation::RepresentationModified, counter.GetPointer());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  bool success = segmentation->CreateRepresentation(vtkSegmentationConverter::GetClosedSurfaceRepresentationName());
+  timer->StopTimer();
+  elapsedTime = timer->GetElapsedTime();
+  segmentation->RemoveObserver(counter.GetPointer());
+  if (counter->Count != segmentation->GetNumberOfSegments())
+    {
+    std::cerr << __LINE__ << ": Expected " << segmentation->GetNumberOfSegments()
+      << " representation modified events, got " << counter->Count << std::endl;
+    return false;
+    }
+  return success;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentationConversionThreadingTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New());
+
+  const int numberOfSegmentsPerLayer = 30;
+  vtkSmartPointer<vtkSegmentation> sequentialSegmentation = CreateSegmentation(numberOfSegmentsPerLayer);
+  vtkSmartPointer<vtkSegmentation> threadedSegmentation = CreateSegmentation(numberOfSegmentsPerLayer);
+
+  double sequentialTime = 0.0;
+  if (!ConvertToClosedSurface(sequentialSegmentation, 1, sequentialTime))
+    {
+    std::cerr << __LINE__ << ": Sequential conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  double threadedTime = 0.0;
+  if (!ConvertToClosedSurface(threadedSegmentation, 0, threadedTime))
+    {
+    std::cerr << __LINE__ << ": Threaded conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Threaded conversion must produce the same surfaces
+  for (int segmentIndex = 0; segmentIndex < sequentialSegmentation->GetNumberOfSegments(); ++segmentIndex)
+    {
+    vtkPolyData* expectedSurface = vtkPolyData::SafeDownCast(sequentialSegmentation->GetNthSegment(segmentIndex)->GetRepresentation(
+      vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    vtkPolyData* surface = vtkPolyData::SafeDownCast(threadedSegmentation->GetNthSegment(segmentIndex)->GetRepresentation(
+      vtkSegmentationConverter::GetClosedSurfaceRepresentationName()));
+    if (!expectedSurface || !surface)
+      {
+      std::cerr << __LINE__ << ": Missing closed surface representation in segment " << segmentIndex << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (surface->GetNumberOfPoints() == 0
+      || surface->GetNumberOfPoints() != expectedSurface->GetNumberOfPoints()
+      || surface->GetNumberOfPolys() != expectedSurface->GetNumberOfPolys())
+      {
+      std::cerr << __LINE__ << ": Surface mismatch in segment " << segmentIndex << ": "
+        << surface->GetNumberOfPoints() << " points (expected " << expectedSurface->GetNumberOfPoints() << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << sequentialSegmentation->GetNumberOfSegments() << " segments in 2 shared labelmaps converted to closed surface:"
+    << " 1 thread: " << sequentialTime << "s, "
+    << vtkMultiThreader::GetGlobalDefaultNumberOfThreads() << " threads: " << threadedTime << "s" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,7 @@
 ==============================================================================*/
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkImageAccumulate.h>
 #include <vtkImageThreshold.h>
 #include <vtkMatrix4x4.h>
@@ -28,6 +29,10 @@
 #include <vtkSphereSource.h>
 #include <vtkVersion.h>
 
+// STD includes
+#include <algorithm>
+#include <cstring>
+
 // SegmentationCore includes
 #include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
 #include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
@@ -68,6 +73,141 @@ int GetVoxelCount(vtkImageData* labelmap, int labelValue)
   return accumulate->GetVoxelCount();
 }
 
+//----------------------------------------------------------------------------
+bool IsEqualLabelmap(vtkImageData* labelmap1, vtkImageData* labelmap2)
+{
+  int* extent1 = labelmap1->GetExtent();
+  int* extent2 = labelmap2->GetExtent();
+  if (!std::equal(extent1, extent1 + 6, extent2) || labelmap1->GetScalarType() != labelmap2->GetScalarType())
+    {
+    return false;
+    }
+  vtkIdType size = labelmap1->GetNumberOfPoints() * labelmap1->GetScalarSize();
+  return memcmp(labelmap1->GetScalarPointer(), labelmap2->GetScalarPointer(), size) == 0;
+}
+
+//----------------------------------------------------------------------------
+int TestLabelmapTiles()
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 99, 0, 119, 0, 139);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  labelmap->GetPointData()->GetScalars()->Fill(0);
+  for (int z = 20; z < 80; ++z)
+    {
+    for (int y = 20; y < 80; ++y)
+      {
+      for (int x = 0; x < 100; ++x)
+        {
+        labelmap->SetScalarComponentFromDouble(x, y, z, 0, (x + y + z) % 7 == 0 ? 2 : 1);
+        }
+      }
+    }
+
+  vtkNew<vtkSegment> segment1;
+  segment1->SetLabelValue(1);
+  segment1->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+  vtkNew<vtkSegment> segment2;
+  segment2->SetLabelValue(2);
+  segment2->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->AddSegment(segment1);
+  segmentation->AddSegment(segment2);
+
+  vtkNew<vtkSegmentationHistory> history;
+  history->SetSegmentation(segmentation);
+  history->SetMaximumNumberOfStates(10);
+  history->SaveState();
+  vtkNew<vtkOrientedImageData> originalLabelmap;
+  originalLabelmap->DeepCopy(labelmap);
+  vtkTypeInt64 initialMemorySize = history->GetMemorySize();
+  vtkTypeInt64 labelmapSize = labelmap->GetNumberOfPoints();
+
+  // Saving an unchanged segmentation does not store a new labelmap
+  history->SaveState();
+  if (history->GetMemorySize() != initialMemorySize)
+    {
+    std::cerr << "Memory size increased after saving unchanged segmentation: "
+      << initialMemorySize << " -> " << history->GetMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Small edit: only the modified tiles are stored
+  for (int z = 50; z < 60; ++z)
+    {
+    for (int y = 50; y < 60; ++y)
+      {
+      for (int x = 50; x < 60; ++x)
+        {
+        labelmap->SetScalarComponentFromDouble(x, y, z, 0, 3);
+        }
+      }
+    }
+  labelmap->Modified();
+  history->SaveState();
+  vtkTypeInt64 editMemorySize = history->GetMemorySize() - initialMemorySize;
+  if (editMemorySize <= 0 || editMemorySize > labelmapSize / 10)
+    {
+    std::cerr << "Unexpected memory size of a small edit: " << editMemorySize
+      << " bytes (labelmap size: " << labelmapSize << " bytes)" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkOrientedImageData> modifiedLabelmap;
+  modifiedLabelmap->DeepCopy(labelmap);
+
+  // Undo restores the original voxels and segments still share the labelmap
+  history->RestorePreviousState();
+  history->RestorePreviousState();
+  vtkOrientedImageData* undoLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment1->GetRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()));
+  if (!undoLabelmap || !IsEqualLabelmap(undoLabelmap, originalLabelmap)
+    || undoLabelmap != segment2->GetRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()))
+    {
+    std::cerr << "Undo did not restore the original labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+  history->RestoreNextState();
+  history->RestoreNextState();
+  vtkOrientedImageData* redoLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment1->GetRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()));
+  if (!redoLabelmap || !IsEqualLabelmap(redoLabelmap, modifiedLabelmap))
+    {
+    std::cerr << "Redo did not restore the modified labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Saving the restored labelmap does not store it again
+  vtkTypeInt64 redoMemorySize = history->GetMemorySize();
+  history->SaveState();
+  if (history->GetMemorySize() != redoMemorySize)
+    {
+    std::cerr << "Memory size increased after saving a restored labelmap: "
+      << redoMemorySize << " -> " << history->GetMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A new first segment in the shared labelmap does not store it again
+  vtkNew<vtkSegment> segment0;
+  segment0->SetLabelValue(3);
+  segment0->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), redoLabelmap);
+  segmentation->AddSegment(segment0, "Segment_0", segmentation->GetNthSegmentID(0));
+  history->SaveState();
+  if (history->GetMemorySize() != redoMemorySize)
+    {
+    std::cerr << "Memory size increased after adding a segment to the shared labelmap: "
+      << redoMemorySize << " -> " << history->GetMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Memory limit removes the oldest states
+  history->SetMaximumMemorySize(1);
+  if (!StateCountCheck(history, 2))
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 int vtkSegmentationHistoryTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
 {
@@ -178,6 +318,11 @@ int vtkSegmentationHistoryTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
     return EXIT_FAILURE;
     }
 
+  if (TestLabelmapTiles() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
   std::cout << "Segmentation history test 1 passed." << std::endl;
   return EXIT_SUCCESS;
 }
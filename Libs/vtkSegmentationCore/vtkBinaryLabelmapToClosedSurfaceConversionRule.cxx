@@ -20,6 +20,7 @@
 
 // SegmentationCore includes
 #include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkMultiLabelSurfaceExtractor.h"
 #include "vtkSegmentation.h"
 
 #include "vtkOrientedImageData.h"
@@ -156,8 +157,8 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment
     return false;
     }
 
-  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
-  int jointSmoothing = vtkVariant(this->ConversionParameters[GetJointSmoothingParameterName()].first).ToInt();
+  double smoothingFactor = vtkVariant(this->GetConversionParameterValue(GetSmoothingFactorParameterName())).ToDouble();
+  int jointSmoothing = vtkVariant(this->GetConversionParameterValue(GetJointSmoothingParameterName())).ToInt();
 
   if (jointSmoothing > 0 && smoothingFactor > 0)
     {
@@ -226,6 +227,14 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::IsConvertThreadSafe()
+{
+  double smoothingFactor = vtkVariant(this->GetConversionParameterValue(GetSmoothingFactorParameterName())).ToDouble();
+  int jointSmoothing = vtkVariant(this->GetConversionParameterValue(GetJointSmoothingParameterName())).ToInt();
+  return !(jointSmoothing > 0 && smoothingFactor > 0);
+}
+
 //----------------------------------------------------------------------------
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrientedImageData* orientedBinaryLabelmap,
   vtkPolyData* closedSurfacePolyData, std::vector<int> labelValues)
@@ -243,12 +252,10 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
     return false;
     }
 
-  vtkSmartPointer<vtkImageData> binaryLabelmap = orientedBinaryLabelmap;
-  if (!binaryLabelmap)
-    {
-    vtkErrorMacro("Convert: Source representation is not data");
-    return false;
-    }
+  // Segments of a shared labelmap may be converted concurrently, therefore the
+  // labelmap itself is not used as filter input, only a shallow copy of it.
+  vtkSmartPointer<vtkImageData> binaryLabelmap = vtkSmartPointer<vtkImageData>::New();
+  binaryLabelmap->ShallowCopy(orientedBinaryLabelmap);
 
   // Pad labelmap if it has non-background border voxels
   int* binaryLabelmapExtent = binaryLabelmap->GetExtent();
@@ -262,101 +269,132 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
     return true;
     }
 
-  /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
-  /// This function adds a 1 voxel padding to the labelmap in these cases.
-  bool paddingNecessary = this->IsLabelmapPaddingNecessary(binaryLabelmap);
-  if (paddingNecessary)
+  // Get conversion parameters
+  double decimationFactor = vtkVariant(this->GetConversionParameterValue(GetDecimationFactorParameterName())).ToDouble();
+  double smoothingFactor = vtkVariant(this->GetConversionParameterValue(GetSmoothingFactorParameterName())).ToDouble();
+  int computeSurfaceNormals = vtkVariant(this->GetConversionParameterValue(GetComputeSurfaceNormalsParameterName())).ToInt();
+
+  // Smoothing parameters
+  const int smoothingIterations = 20; // based on VTK documentation ("Ten or twenty iterations is all the is usually necessary")
+  // This formula maps:
+  // 0.0  -> 1.0   (almost no smoothing)
+  // 0.25 -> 0.1   (average smoothing)
+  // 0.5  -> 0.01  (more smoothing)
+  // 1.0  -> 0.001 (very strong smoothing)
+  double passBand = pow(10.0, -4.0 * smoothingFactor);
+
+  vtkSmartPointer<vtkPolyData> processingResult;
+  if (labelValues.size() == 1)
     {
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(binaryLabelmap);
-    int extent[6] = { 0, -1, 0, -1, 0, -1 };
-    binaryLabelmap->GetExtent(extent);
-    // Set the output extent to the new size
-    padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
-    padder->Update();
-    binaryLabelmap = padder->GetOutput();
+    // Only the bounding box of the label is processed. Label extents are computed
+    // once for all segments of a shared labelmap.
+    vtkMultiLabelSurfaceExtractor::LabelExtentMap labelExtents;
+    std::array<int, 6> labelExtent = { { 0, -1, 0, -1, 0, -1 } };
+    if (this->GetLabelExtent(orientedBinaryLabelmap, labelValues[0], labelExtent))
+      {
+      labelExtents[labelValues[0]] = labelExtent;
+      }
+    vtkNew<vtkMultiLabelSurfaceExtractor> surfaceExtractor;
+    surfaceExtractor->SetDecimationFactor(decimationFactor);
+    if (smoothingFactor > 0)
+      {
+      surfaceExtractor->SetSmoothingIterations(smoothingIterations);
+      surfaceExtractor->SetSmoothingPassBand(passBand);
+      surfaceExtractor->NonManifoldSmoothingOn();
+      surfaceExtractor->NormalizeCoordinatesOn();
+      }
+    // Segments are already converted concurrently
+    surfaceExtractor->SetNumberOfThreads(1);
+    processingResult = vtkSmartPointer<vtkPolyData>::New();
+    surfaceExtractor->ExtractLabel(binaryLabelmap, labelValues[0], processingResult, &labelExtents);
+    if (processingResult->GetNumberOfPolys() == 0)
+      {
+      vtkDebugMacro("Convert: No polygons can be created, probably all voxels are empty");
+      closedSurfacePolyData->Initialize();
+      return true;
+      }
     }
+  else
+    {
+    /// If input labelmap has non-background border voxels, then those regions remain open in the output closed surface.
+    /// This function adds a 1 voxel padding to the labelmap in these cases.
+    bool paddingNecessary = this->IsLabelmapPaddingNecessary(binaryLabelmap);
+    if (paddingNecessary)
+      {
+      vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+      padder->SetInputData(binaryLabelmap);
+      int extent[6] = { 0, -1, 0, -1, 0, -1 };
+      binaryLabelmap->GetExtent(extent);
+      // Set the output extent to the new size
+      padder->SetOutputWholeExtent(extent[0] - 1, extent[1] + 1, extent[2] - 1, extent[3] + 1, extent[4] - 1, extent[5] + 1);
+      padder->Update();
+      binaryLabelmap = padder->GetOutput();
+      }
 
-  // Clone labelmap and set identity geometry so that the whole transform can be done in IJK space and then
-  // the whole transform can be applied on the poly data to transform it to the world coordinate system
-  vtkSmartPointer<vtkImageData> binaryLabelmapWithIdentityGeometry = vtkSmartPointer<vtkImageData>::New();
-  binaryLabelmapWithIdentityGeometry->ShallowCopy(binaryLabelmap);
-  binaryLabelmapWithIdentityGeometry->SetOrigin(0, 0, 0);
-  binaryLabelmapWithIdentityGeometry->SetSpacing(1.0, 1.0, 1.0);
-
-  // Get conversion parameters
-  double decimationFactor = vtkVariant(this->ConversionParameters[GetDecimationFactorParameterName()].first).ToDouble();
-  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
-  int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
-  int jointSmoothing = vtkVariant(this->ConversionParameters[GetJointSmoothingParameterName()].first).ToInt();
+    // Clone labelmap and set identity geometry so that the whole transform can be done in IJK space and then
+    // the whole transform can be applied on the poly data to transform it to the world coordinate system
+    vtkSmartPointer<vtkImageData> binaryLabelmapWithIdentityGeometry = vtkSmartPointer<vtkImageData>::New();
+    binaryLabelmapWithIdentityGeometry->ShallowCopy(binaryLabelmap);
+    binaryLabelmapWithIdentityGeometry->SetOrigin(0, 0, 0);
+    binaryLabelmapWithIdentityGeometry->SetSpacing(1.0, 1.0, 1.0);
 
 #if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
-  vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
+    vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
 #else
-  vtkNew<vtkDiscreteMarchingCubes> marchingCubes;
+    vtkNew<vtkDiscreteMarchingCubes> marchingCubes;
 #endif
-  marchingCubes->SetInputData(binaryLabelmapWithIdentityGeometry);
-  marchingCubes->ComputeGradientsOff();
-  marchingCubes->ComputeNormalsOff(); // While computing normals is faster using the flying edges filter,
-  // it results in incorrect normals in meshes from shared labelmaps marchingCubes->ComputeScalarsOn();
+    marchingCubes->SetInputData(binaryLabelmapWithIdentityGeometry);
+    marchingCubes->ComputeGradientsOff();
+    marchingCubes->ComputeNormalsOff(); // While computing normals is faster using the flying edges filter,
+    // it results in incorrect normals in meshes from shared labelmaps marchingCubes->ComputeScalarsOn();
 
-  int valueIndex = 0;
-  for (vtkIdType labelValue : labelValues)
-    {
-    marchingCubes->SetValue(valueIndex, labelValue);
-    ++valueIndex;
-    }
-
-  vtkSmartPointer<vtkPolyData> convertedSegment = vtkSmartPointer<vtkPolyData>::New();
+    int valueIndex = 0;
+    for (vtkIdType labelValue : labelValues)
+      {
+      marchingCubes->SetValue(valueIndex, labelValue);
+      ++valueIndex;
+      }
 
-  // Run marching cubes
-  marchingCubes->Update();
-  vtkSmartPointer<vtkPolyData> processingResult = marchingCubes->GetOutput();
-  if (processingResult->GetNumberOfPolys() == 0)
-    {
-    vtkDebugMacro("Convert: No polygons can be created, probably all voxels are empty");
-    convertedSegment = nullptr;
-    closedSurfacePolyData->Initialize();
-    }
+    // Run marching cubes
+    marchingCubes->Update();
+    processingResult = marchingCubes->GetOutput();
+    if (processingResult->GetNumberOfPolys() == 0)
+      {
+      vtkDebugMacro("Convert: No polygons can be created, probably all voxels are empty");
+      closedSurfacePolyData->Initialize();
+      return true;
+      }
 
-  if (!convertedSegment)
-    {
-    return true;
-    }
+    // Decimate
+    if (decimationFactor > 0.0)
+      {
+      vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
+      decimator->SetInputData(processingResult);
+      decimator->SetFeatureAngle(60);
+      decimator->SplittingOff();
+      decimator->PreserveTopologyOn();
+      decimator->SetMaximumError(1);
+      decimator->SetTargetReduction(decimationFactor);
+      decimator->Update();
+      processingResult = decimator->GetOutput();
+      }
 
-  // Decimate
-  if (decimationFactor > 0.0)
-    {
-    vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
-    decimator->SetInputData(processingResult);
-    decimator->SetFeatureAngle(60);
-    decimator->SplittingOff();
-    decimator->PreserveTopologyOn();
-    decimator->SetMaximumError(1);
-    decimator->SetTargetReduction(decimationFactor);
-    decimator->Update();
-    processingResult = decimator->GetOutput();
+    if (smoothingFactor > 0)
+      {
+      vtkSmartPointer<vtkWindowedSincPolyDataFilter> smoother = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+      smoother->SetInputData(processingResult);
+      smoother->SetNumberOfIterations(smoothingIterations);
+      smoother->SetPassBand(passBand);
+      smoother->BoundarySmoothingOff();
+      smoother->FeatureEdgeSmoothingOff();
+      smoother->NonManifoldSmoothingOn();
+      smoother->NormalizeCoordinatesOn();
+      smoother->Update();
+      processingResult = smoother->GetOutput();
+      }
     }
 
-  if (smoothingFactor > 0)
-    {
-    vtkSmartPointer<vtkWindowedSincPolyDataFilter> smoother = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
-    smoother->SetInputData(processingResult);
-    smoother->SetNumberOfIterations(20); // based on VTK documentation ("Ten or twenty iterations is all the is usually necessary")
-    // This formula maps:
-    // 0.0  -> 1.0   (almost no smoothing)
-    // 0.25 -> 0.1   (average smoothing)
-    // 0.5  -> 0.01  (more smoothing)
-    // 1.0  -> 0.001 (very strong smoothing)
-    double passBand = pow(10.0, -4.0 * smoothingFactor);
-    smoother->SetPassBand(passBand);
-    smoother->BoundarySmoothingOff();
-    smoother->FeatureEdgeSmoothingOff();
-    smoother->NonManifoldSmoothingOn();
-    smoother->NormalizeCoordinatesOn();
-    smoother->Update();
-    processingResult = smoother->GetOutput();
-    }
+  vtkSmartPointer<vtkPolyData> convertedSegment = vtkSmartPointer<vtkPolyData>::New();
 
   // Transform the result surface from labelmap IJK to world coordinate system
   vtkSmartPointer<vtkTransform> labelmapGeometryTransform = vtkSmartPointer<vtkTransform>::New();
@@ -393,6 +431,31 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::PostConvert(vtkSegmentation* vtkNotUsed(segmentation))
 {
   this->JointSmoothCache.clear();
+  std::lock_guard<std::mutex> lock(this->LabelExtentsCacheMutex);
+  this->LabelExtentsCache.clear();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::GetLabelExtent(vtkOrientedImageData* binaryLabelmap,
+  int labelValue, std::array<int, 6>& labelExtent)
+{
+  // Segments of a shared labelmap may be converted concurrently
+  std::lock_guard<std::mutex> lock(this->LabelExtentsCacheMutex);
+  LabelExtentsCacheType::iterator cacheIt = this->LabelExtentsCache.find(binaryLabelmap);
+  if (cacheIt == this->LabelExtentsCache.end() || cacheIt->second.first != binaryLabelmap->GetMTime())
+    {
+    LabelExtentsCacheEntry& cacheEntry = this->LabelExtentsCache[binaryLabelmap];
+    cacheEntry.first = binaryLabelmap->GetMTime();
+    vtkMultiLabelSurfaceExtractor::ComputeLabelExtents(binaryLabelmap, cacheEntry.second);
+    cacheIt = this->LabelExtentsCache.find(binaryLabelmap);
+    }
+  vtkMultiLabelSurfaceExtractor::LabelExtentMap::iterator labelIt = cacheIt->second.second.find(labelValue);
+  if (labelIt == cacheIt->second.second.end())
+    {
+    return false;
+    }
+  labelExtent = labelIt->second;
   return true;
 }
 
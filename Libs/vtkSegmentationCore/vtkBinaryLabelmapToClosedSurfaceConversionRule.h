@@ -22,6 +22,7 @@
 #define __vtkBinaryLabelmapToClosedSurfaceConversionRule_h
 
 // SegmentationCore includes
+#include "vtkMultiLabelSurfaceExtractor.h"
 #include "vtkSegmentationConverterRule.h"
 #include "vtkSegmentationConverter.h"
 
@@ -30,6 +31,9 @@
 // VTK includes
 #include <vtkPolyData.h>
 
+// STD includes
+#include <mutex>
+
 /// \ingroup SegmentationCore
 /// \brief Convert binary labelmap representation (vtkOrientedImageData type) to
 ///   closed surface representation (vtkPolyData type). The conversion algorithm
@@ -71,8 +75,12 @@ public:
   /// Update the target representation based on the source representation
   bool Convert(vtkSegment* segment) override;
 
+  /// Segments can be converted concurrently, except with joint smoothing,
+  /// which shares the smoothed surface of each labelmap between segments.
+  bool IsConvertThreadSafe() override;
+
   /// Perform postprocesing steps on the output
-  /// Clears the joint smoothing cache
+  /// Clears the joint smoothing and label extents caches
   bool PostConvert(vtkSegmentation* segmentation) override;
 
   /// Get the cost of the conversion.
@@ -92,6 +100,11 @@ protected:
   /// This function checks whether this is the case.
   bool IsLabelmapPaddingNecessary(vtkImageData* binaryLabelMap);
 
+  /// Get the extent of the voxels of a label value in the labelmap.
+  /// Extents of all labels are computed in one pass and cached until the labelmap is modified.
+  /// \return False if the label value is not in the labelmap
+  bool GetLabelExtent(vtkOrientedImageData* binaryLabelmap, int labelValue, std::array<int, 6>& labelExtent);
+
 protected:
   vtkBinaryLabelmapToClosedSurfaceConversionRule();
   ~vtkBinaryLabelmapToClosedSurfaceConversionRule() override;
@@ -102,6 +115,13 @@ protected:
   /// The key used is the binary labelmap representation, which maps to the combined vtkPolyData containing surfaces for all segments in the segmentation
   std::map<vtkOrientedImageData*, vtkSmartPointer<vtkPolyData> > JointSmoothCache;
 
+  /// Cache for storing the extent of each label of the binary labelmap representations
+  /// The key used is the binary labelmap representation, which maps to its modified time and label extents
+  typedef std::pair<vtkMTimeType, vtkMultiLabelSurfaceExtractor::LabelExtentMap> LabelExtentsCacheEntry;
+  typedef std::map<vtkOrientedImageData*, LabelExtentsCacheEntry> LabelExtentsCacheType;
+  LabelExtentsCacheType LabelExtentsCache;
+  std::mutex LabelExtentsCacheMutex;
+
 };
 
 #endif // __vtkBinaryLabelmapToClosedSurfaceConversionRule_h
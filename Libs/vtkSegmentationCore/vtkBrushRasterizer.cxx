@@ -0,0 +1,349 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkBrushRasterizer.h"
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkBrushRasterizer);
+
+namespace
+{
+
+/// Minimum number of image rows painted by each thread.
+const vtkIdType MinimumNumberOfRowsPerThread = 16;
+
+//----------------------------------------------------------------------------
+/// Brush moved from Start to Start + Direction (zero Direction if the brush is stamped),
+/// in the coordinate system of the points.
+struct BrushSegment
+{
+  double Start[3];
+  double Direction[3];
+  double Length2;
+  int Extent[6];
+};
+
+//----------------------------------------------------------------------------
+struct PaintThreadData
+{
+  vtkImageData* Image;
+  std::vector<BrushSegment> Segments;
+  int Extent[6];
+  double IjkToPoints[4][4];
+  bool Sphere;
+  double Radius2;
+  double HalfHeight;
+  double Axis[3];
+  double Value;
+};
+
+//----------------------------------------------------------------------------
+bool IsInsideBrush(const PaintThreadData* data, const BrushSegment& segment, const double point[3])
+{
+  double offset[3] = { point[0] - segment.Start[0], point[1] - segment.Start[1], point[2] - segment.Start[2] };
+  if (segment.Length2 > 0.0)
+    {
+    // Offset from the closest brush position along the segment
+    double t = vtkMath::Dot(offset, segment.Direction) / segment.Length2;
+    t = std::min(std::max(t, 0.0), 1.0);
+    for (int i = 0; i < 3; ++i)
+      {
+      offset[i] -= t * segment.Direction[i];
+      }
+    }
+  double distance2 = vtkMath::Dot(offset, offset);
+  if (data->Sphere)
+    {
+    return distance2 <= data->Radius2;
+    }
+  double axial = vtkMath::Dot(offset, data->Axis);
+  return fabs(axial) <= data->HalfHeight && distance2 - axial * axial <= data->Radius2;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void PaintRows(const PaintThreadData* data, vtkIdType beginRow, vtkIdType endRow)
+{
+  const int* extent = data->Extent;
+  vtkIdType numberOfRowsPerSlice = extent[3] - extent[2] + 1;
+  T value = static_cast<T>(data->Value);
+  const double (*ijkToPoints)[4] = data->IjkToPoints;
+  for (vtkIdType row = beginRow; row < endRow; ++row)
+    {
+    int y = extent[2] + static_cast<int>(row % numberOfRowsPerSlice);
+    int z = extent[4] + static_cast<int>(row / numberOfRowsPerSlice);
+    for (std::vector<BrushSegment>::const_iterator segmentIt = data->Segments.begin();
+      segmentIt != data->Segments.end(); ++segmentIt)
+      {
+      const int* segmentExtent = segmentIt->Extent;
+      if (y < segmentExtent[2] || y > segmentExtent[3] || z < segmentExtent[4] || z > segmentExtent[5])
+        {
+        continue;
+        }
+      T* voxelPtr = static_cast<T*>(data->Image->GetScalarPointer(segmentExtent[0], y, z));
+      double point[3];
+      for (int i = 0; i < 3; ++i)
+        {
+        point[i] = ijkToPoints[i][0] * segmentExtent[0] + ijkToPoints[i][1] * y + ijkToPoints[i][2] * z + ijkToPoints[i][3];
+        }
+      for (int x = segmentExtent[0]; x <= segmentExtent[1]; ++x, ++voxelPtr)
+        {
+        if (*voxelPtr != value && IsInsideBrush(data, *segmentIt, point))
+          {
+          *voxelPtr = value;
+          }
+        point[0] += ijkToPoints[0][0];
+        point[1] += ijkToPoints[1][0];
+        point[2] += ijkToPoints[2][0];
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void PaintRows(const PaintThreadData* data, int threadId, int numberOfThreads)
+{
+  const int* extent = data->Extent;
+  vtkIdType numberOfRows = static_cast<vtkIdType>(extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+  vtkIdType beginRow = numberOfRows * threadId / numberOfThreads;
+  vtkIdType endRow = numberOfRows * (threadId + 1) / numberOfThreads;
+  switch (data->Image->GetScalarType())
+    {
+    vtkTemplateMacro(PaintRows<VTK_TT>(data, beginRow, endRow));
+    default:
+      break;
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE PaintRowsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  PaintThreadData* data = static_cast<PaintThreadData*>(info->UserData);
+  PaintRows(data, info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkBrushRasterizer::vtkBrushRasterizer()
+{
+  this->BrushShape = BRUSH_SHAPE_SPHERE;
+  this->Radius = 1.0;
+  this->Height = 1.0;
+  this->Axis[0] = 0.0;
+  this->Axis[1] = 0.0;
+  this->Axis[2] = 1.0;
+  this->Sweep = false;
+  this->SnapToVoxel = true;
+  this->NumberOfThreads = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkBrushRasterizer::~vtkBrushRasterizer() = default;
+
+//----------------------------------------------------------------------------
+void vtkBrushRasterizer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "BrushShape: " << (this->BrushShape == BRUSH_SHAPE_SPHERE ? "Sphere" : "Cylinder") << "\n";
+  os << indent << "Radius: " << this->Radius << "\n";
+  os << indent << "Height: " << this->Height << "\n";
+  os << indent << "Axis: " << this->Axis[0] << ", " << this->Axis[1] << ", " << this->Axis[2] << "\n";
+  os << indent << "Sweep: " << (this->Sweep ? "true" : "false") << "\n";
+  os << indent << "SnapToVoxel: " << (this->SnapToVoxel ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkBrushRasterizer::Paint(vtkOrientedImageData* image, vtkPoints* points, double value,
+  int paintedExtent[6]/*=nullptr*/, vtkMatrix4x4* pointsToWorldMatrix/*=nullptr*/)
+{
+  if (paintedExtent)
+    {
+    int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    std::copy(emptyExtent, emptyExtent + 6, paintedExtent);
+    }
+  if (!image || !points || !image->GetPointData() || !image->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Paint: Invalid image or points");
+    return false;
+    }
+  if (points->GetNumberOfPoints() == 0)
+    {
+    return true;
+    }
+
+  PaintThreadData data;
+  data.Image = image;
+  data.Sphere = (this->BrushShape == BRUSH_SHAPE_SPHERE);
+  data.Radius2 = this->Radius * this->Radius;
+  data.HalfHeight = this->Height / 2.0;
+  std::copy(this->Axis, this->Axis + 3, data.Axis);
+  if (vtkMath::Normalize(data.Axis) == 0.0)
+    {
+    data.Axis[2] = 1.0;
+    }
+  data.Value = value;
+
+  // Voxel index to points coordinate system and back
+  vtkNew<vtkMatrix4x4> ijkToWorldMatrix;
+  image->GetImageToWorldMatrix(ijkToWorldMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> worldToPointsMatrix;
+  if (pointsToWorldMatrix)
+    {
+    vtkMatrix4x4::Invert(pointsToWorldMatrix, worldToPointsMatrix.GetPointer());
+    }
+  vtkNew<vtkMatrix4x4> ijkToPointsMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToPointsMatrix.GetPointer(), ijkToWorldMatrix.GetPointer(), ijkToPointsMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> pointsToIjkMatrix;
+  vtkMatrix4x4::Invert(ijkToPointsMatrix.GetPointer(), pointsToIjkMatrix.GetPointer());
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      data.IjkToPoints[i][j] = ijkToPointsMatrix->GetElement(i, j);
+      }
+    }
+
+  // Half size of the bounding box of the brush along each axis
+  double halfSize[3] = { this->Radius, this->Radius, this->Radius };
+  if (!data.Sphere)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      halfSize[i] = fabs(data.Axis[i]) * data.HalfHeight
+        + this->Radius * sqrt(std::max(0.0, 1.0 - data.Axis[i] * data.Axis[i]));
+      }
+    }
+
+  int* imageExtent = image->GetExtent();
+  std::copy(imageExtent, imageExtent + 6, data.Extent);
+  int unionExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  double previousCenter[3] = { 0.0, 0.0, 0.0 };
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+    double center[4] = { 0.0, 0.0, 0.0, 1.0 };
+    points->GetPoint(pointIndex, center);
+    if (this->SnapToVoxel)
+      {
+      double centerIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      pointsToIjkMatrix->MultiplyPoint(center, centerIjk);
+      for (int i = 0; i < 3; ++i)
+        {
+        centerIjk[i] = floor(centerIjk[i] + 0.5);
+        }
+      ijkToPointsMatrix->MultiplyPoint(centerIjk, center);
+      }
+
+    BrushSegment segment;
+    std::copy(center, center + 3, segment.Start);
+    segment.Direction[0] = segment.Direction[1] = segment.Direction[2] = 0.0;
+    if (this->Sweep && pointIndex > 0)
+      {
+      std::copy(previousCenter, previousCenter + 3, segment.Start);
+      vtkMath::Subtract(center, previousCenter, segment.Direction);
+      }
+    segment.Length2 = vtkMath::Dot(segment.Direction, segment.Direction);
+    std::copy(center, center + 3, previousCenter);
+
+    // Bounding box of the brush along the segment, transformed to voxel indices
+    double bounds[6];
+    for (int i = 0; i < 3; ++i)
+      {
+      bounds[2 * i] = std::min(segment.Start[i], center[i]) - halfSize[i];
+      bounds[2 * i + 1] = std::max(segment.Start[i], center[i]) + halfSize[i];
+      }
+    double boundsIjk[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (int corner = 0; corner < 8; ++corner)
+      {
+      double cornerPoint[4] = { bounds[corner & 1], bounds[2 + ((corner >> 1) & 1)], bounds[4 + ((corner >> 2) & 1)], 1.0 };
+      double cornerIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      pointsToIjkMatrix->MultiplyPoint(cornerPoint, cornerIjk);
+      for (int i = 0; i < 3; ++i)
+        {
+        boundsIjk[2 * i] = std::min(boundsIjk[2 * i], cornerIjk[i]);
+        boundsIjk[2 * i + 1] = std::max(boundsIjk[2 * i + 1], cornerIjk[i]);
+        }
+      }
+    bool empty = false;
+    for (int i = 0; i < 3; ++i)
+      {
+      segment.Extent[2 * i] = std::max(static_cast<int>(floor(boundsIjk[2 * i])), imageExtent[2 * i]);
+      segment.Extent[2 * i + 1] = std::min(static_cast<int>(ceil(boundsIjk[2 * i + 1])), imageExtent[2 * i + 1]);
+      empty |= (segment.Extent[2 * i] > segment.Extent[2 * i + 1]);
+      }
+    if (empty)
+      {
+      // brush is outside of the image
+      continue;
+      }
+    for (int i = 0; i < 3; ++i)
+      {
+      unionExtent[2 * i] = std::min(unionExtent[2 * i], segment.Extent[2 * i]);
+      unionExtent[2 * i + 1] = std::max(unionExtent[2 * i + 1], segment.Extent[2 * i + 1]);
+      }
+    data.Segments.push_back(segment);
+    }
+  if (data.Segments.empty())
+    {
+    return true;
+    }
+  std::copy(unionExtent, unionExtent + 6, data.Extent);
+
+  // Each thread paints whole rows of the painted region, no voxel is written by two threads
+  vtkIdType numberOfRows = static_cast<vtkIdType>(unionExtent[3] - unionExtent[2] + 1) * (unionExtent[5] - unionExtent[4] + 1);
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  numberOfThreads = static_cast<int>(std::min(static_cast<vtkIdType>(numberOfThreads), numberOfRows / MinimumNumberOfRowsPerThread));
+  numberOfThreads = std::max(numberOfThreads, 1);
+  if (numberOfThreads > 1)
+    {
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(PaintRowsThread, &data);
+    threader->SingleMethodExecute();
+    }
+  else
+    {
+    PaintRows(&data, 0, 1);
+    }
+
+  if (paintedExtent)
+    {
+    std::copy(unionExtent, unionExtent + 6, paintedExtent);
+    }
+  image->GetPointData()->GetScalars()->Modified();
+  image->Modified();
+  return true;
+}
@@ -0,0 +1,120 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkBrushRasterizer_h
+#define __vtkBrushRasterizer_h
+
+// Segmentation includes
+#include "vtkSegmentationCoreConfigure.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMatrix4x4;
+class vtkOrientedImageData;
+class vtkPoints;
+
+/// \ingroup SegmentationCore
+/// \brief Paint sphere or cylinder brushes directly into the voxels of a labelmap
+///
+/// The brush is placed at each point of a stroke and the voxels whose center is
+/// inside the brush are set to the paint value. Only the voxels in the bounding box
+/// of each brush are visited and the slices of the painted region are split between
+/// threads.
+///
+/// By default the brush center is rounded to the nearest voxel, which gives the same
+/// result as rasterizing the brush model once with vtkPolyDataToImageStencil and
+/// stamping the stencil at each point, without the polygonal approximation of the brush.
+/// If Sweep is enabled, the volume swept by the brush between consecutive points
+/// (a capsule for sphere brushes) is painted as well, so that fast strokes have no gaps.
+class vtkSegmentationCore_EXPORT vtkBrushRasterizer : public vtkObject
+{
+public:
+  static vtkBrushRasterizer *New();
+  vtkTypeMacro(vtkBrushRasterizer, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum
+    {
+    BRUSH_SHAPE_SPHERE,
+    BRUSH_SHAPE_CYLINDER
+    };
+
+  /// Shape of the brush. Default is sphere.
+  vtkSetClampMacro(BrushShape, int, BRUSH_SHAPE_SPHERE, BRUSH_SHAPE_CYLINDER);
+  vtkGetMacro(BrushShape, int);
+  void SetBrushShapeToSphere() { this->SetBrushShape(BRUSH_SHAPE_SPHERE); };
+  void SetBrushShapeToCylinder() { this->SetBrushShape(BRUSH_SHAPE_CYLINDER); };
+
+  /// Radius of the brush (in mm).
+  vtkSetMacro(Radius, double);
+  vtkGetMacro(Radius, double);
+
+  /// Height of the cylinder brush along its axis (in mm).
+  vtkSetMacro(Height, double);
+  vtkGetMacro(Height, double);
+
+  /// Direction of the axis of the cylinder brush, in the coordinate system of the points.
+  /// Default is (0, 0, 1).
+  vtkSetVector3Macro(Axis, double);
+  vtkGetVector3Macro(Axis, double);
+
+  /// Paint the volume swept by the brush between consecutive points.
+  /// Default is off.
+  vtkSetMacro(Sweep, bool);
+  vtkGetMacro(Sweep, bool);
+  vtkBooleanMacro(Sweep, bool);
+
+  /// Round the brush center to the nearest voxel center.
+  /// Default is on.
+  vtkSetMacro(SnapToVoxel, bool);
+  vtkGetMacro(SnapToVoxel, bool);
+  vtkBooleanMacro(SnapToVoxel, bool);
+
+  /// Maximum number of threads used for painting. Default is 0, which uses
+  /// vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Paint the brush at each point into the image.
+  /// \param image Labelmap to modify, its scalars must be allocated
+  /// \param points Brush positions
+  /// \param value Value of the painted voxels
+  /// \param paintedExtent If not nullptr, the extent of the modified voxels is returned here
+  ///   (empty extent if no voxels were modified)
+  /// \param pointsToWorldMatrix Linear transform from the coordinate system of the points and the
+  ///   brush to the world coordinate system of the image. Identity if nullptr.
+  /// \return Success flag
+  bool Paint(vtkOrientedImageData* image, vtkPoints* points, double value,
+    int paintedExtent[6]=nullptr, vtkMatrix4x4* pointsToWorldMatrix=nullptr);
+
+protected:
+  vtkBrushRasterizer();
+  ~vtkBrushRasterizer() override;
+
+  int BrushShape;
+  double Radius;
+  double Height;
+  double Axis[3];
+  bool Sweep;
+  bool SnapToVoxel;
+  int NumberOfThreads;
+
+private:
+  vtkBrushRasterizer(const vtkBrushRasterizer&) = delete;
+  void operator=(const vtkBrushRasterizer&) = delete;
+};
+
+#endif
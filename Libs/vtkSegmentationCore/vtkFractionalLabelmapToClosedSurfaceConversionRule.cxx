@@ -149,11 +149,11 @@ bool vtkFractionalLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* seg
     }
 
   // Get conversion parameters
-  double decimationFactor = vtkVariant(this->ConversionParameters[this->GetDecimationFactorParameterName()].first).ToDouble();
-  double smoothingFactor = vtkVariant(this->ConversionParameters[this->GetSmoothingFactorParameterName()].first).ToDouble();
-  int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
-  double fractionalOversamplingFactor = vtkVariant(this->ConversionParameters[this->GetFractionalLabelMapOversamplingFactorParameterName()].first).ToDouble();
-  double fractionalThreshold = vtkVariant(this->ConversionParameters[this->GetThresholdFractionParameterName()].first).ToDouble();
+  double decimationFactor = vtkVariant(this->GetConversionParameterValue(this->GetDecimationFactorParameterName())).ToDouble();
+  double smoothingFactor = vtkVariant(this->GetConversionParameterValue(this->GetSmoothingFactorParameterName())).ToDouble();
+  int computeSurfaceNormals = vtkVariant(this->GetConversionParameterValue(GetComputeSurfaceNormalsParameterName())).ToInt();
+  double fractionalOversamplingFactor = vtkVariant(this->GetConversionParameterValue(this->GetFractionalLabelMapOversamplingFactorParameterName())).ToDouble();
+  double fractionalThreshold = vtkVariant(this->GetConversionParameterValue(this->GetThresholdFractionParameterName())).ToDouble();
 
   if (fractionalThreshold < 0 || fractionalThreshold > 1)
     {
@@ -0,0 +1,436 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkMultiLabelSurfaceExtractor.h"
+
+// VTK includes
+#include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
+#include <vtkDataArray.h>
+#include <vtkDecimatePro.h>
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+  #include <vtkDiscreteFlyingEdges3D.h>
+#else
+  #include <vtkDiscreteMarchingCubes.h>
+#endif
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkWindowedSincPolyDataFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMultiLabelSurfaceExtractor);
+
+namespace
+{
+
+/// Minimum number of slices scanned by each thread when computing label extents.
+const int MinimumNumberOfSlicesPerThread = 4;
+
+//----------------------------------------------------------------------------
+int GetNumberOfThreadsToUse(int numberOfThreads)
+{
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  return std::max(1, std::min(numberOfThreads, VTK_MAX_THREADS));
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void ComputeLabelExtentsGeneric(vtkImageData* labelmap, int kMin, int kMax,
+  vtkMultiLabelSurfaceExtractor::LabelExtentMap& labelExtents)
+{
+  int* extent = labelmap->GetExtent();
+  vtkMultiLabelSurfaceExtractor::LabelExtentMap::iterator lastLabelIt = labelExtents.end();
+  for (int k = kMin; k <= kMax; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      T* row = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      int i = extent[0];
+      while (i <= extent[1])
+        {
+        // Runs of voxels with the same value only update the extent once
+        T value = row[i - extent[0]];
+        int runStart = i;
+        while (i <= extent[1] && row[i - extent[0]] == value)
+          {
+          ++i;
+          }
+        int label = static_cast<int>(value);
+        if (label == 0)
+          {
+          continue;
+          }
+        if (lastLabelIt == labelExtents.end() || lastLabelIt->first != label)
+          {
+          lastLabelIt = labelExtents.find(label);
+          if (lastLabelIt == labelExtents.end())
+            {
+            std::array<int, 6> labelExtent = { { runStart, i - 1, j, j, k, k } };
+            lastLabelIt = labelExtents.insert(std::make_pair(label, labelExtent)).first;
+            continue;
+            }
+          }
+        std::array<int, 6>& labelExtent = lastLabelIt->second;
+        labelExtent[0] = std::min(labelExtent[0], runStart);
+        labelExtent[1] = std::max(labelExtent[1], i - 1);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[4] = std::min(labelExtent[4], k);
+        labelExtent[5] = std::max(labelExtent[5], k);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct LabelExtentsThreadData
+{
+  vtkImageData* Labelmap;
+  std::vector<vtkMultiLabelSurfaceExtractor::LabelExtentMap> ThreadLabelExtents;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ComputeLabelExtentsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LabelExtentsThreadData* data = static_cast<LabelExtentsThreadData*>(info->UserData);
+  int* extent = data->Labelmap->GetExtent();
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  int kMin = extent[4] + (numberOfSlices * info->ThreadID) / info->NumberOfThreads;
+  int kMax = extent[4] + (numberOfSlices * (info->ThreadID + 1)) / info->NumberOfThreads - 1;
+  switch (data->Labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(ComputeLabelExtentsGeneric<VTK_TT>(data->Labelmap, kMin, kMax,
+      data->ThreadLabelExtents[info->ThreadID]));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Copy the voxels of labelValue in the intersection of the extents of the
+/// labelmap and the region, the other voxels of the region are set to 0.
+template <class T>
+void CopyLabelGeneric(vtkImageData* labelmap, int labelValue, vtkImageData* region, const int copyExtent[6])
+{
+  vtkDataArray* regionScalars = region->GetPointData()->GetScalars();
+  regionScalars->Fill(0);
+  T value = static_cast<T>(labelValue);
+  int rowLength = copyExtent[1] - copyExtent[0] + 1;
+  for (int k = copyExtent[4]; k <= copyExtent[5]; ++k)
+    {
+    for (int j = copyExtent[2]; j <= copyExtent[3]; ++j)
+      {
+      T* labelmapRow = static_cast<T*>(labelmap->GetScalarPointer(copyExtent[0], j, k));
+      T* regionRow = static_cast<T*>(region->GetScalarPointer(copyExtent[0], j, k));
+      for (int i = 0; i < rowLength; ++i)
+        {
+        if (labelmapRow[i] == value)
+          {
+          regionRow[i] = value;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct ExtractionSettings
+{
+  double DecimationFactor;
+  int SmoothingIterations;
+  double SmoothingPassBand;
+  bool NonManifoldSmoothing;
+  bool NormalizeCoordinates;
+  bool PadBoundary;
+  bool ComputeScalars;
+};
+
+//----------------------------------------------------------------------------
+/// Extract the surface of labelValue from the voxels of the labelmap in labelExtent.
+void ExtractLabelInExtent(const ExtractionSettings& settings, vtkImageData* labelmap,
+  int labelValue, const std::array<int, 6>& labelExtent, vtkPolyData* surface)
+{
+  // The label is copied to a small image that contains its extent and one voxel
+  // of background around it. The labelmap is not used as filter input, as labels
+  // may be extracted concurrently.
+  int* labelmapExtent = labelmap->GetExtent();
+  int regionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    regionExtent[axis * 2] = labelExtent[axis * 2] - 1;
+    regionExtent[axis * 2 + 1] = labelExtent[axis * 2 + 1] + 1;
+    if (!settings.PadBoundary)
+      {
+      regionExtent[axis * 2] = std::max(regionExtent[axis * 2], labelmapExtent[axis * 2]);
+      regionExtent[axis * 2 + 1] = std::min(regionExtent[axis * 2 + 1], labelmapExtent[axis * 2 + 1]);
+      }
+    }
+  vtkNew<vtkImageData> region;
+  region->SetExtent(regionExtent);
+  region->AllocateScalars(labelmap->GetScalarType(), 1);
+  int copyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    copyExtent[axis * 2] = std::max(regionExtent[axis * 2], labelmapExtent[axis * 2]);
+    copyExtent[axis * 2 + 1] = std::min(regionExtent[axis * 2 + 1], labelmapExtent[axis * 2 + 1]);
+    }
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(CopyLabelGeneric<VTK_TT>(labelmap, labelValue, region.GetPointer(), copyExtent));
+    }
+
+#if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
+  vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
+#else
+  vtkNew<vtkDiscreteMarchingCubes> marchingCubes;
+#endif
+  marchingCubes->SetInputData(region.GetPointer());
+  marchingCubes->ComputeGradientsOff();
+  marchingCubes->ComputeNormalsOff();
+  marchingCubes->SetComputeScalars(settings.ComputeScalars);
+  marchingCubes->SetValue(0, labelValue);
+  marchingCubes->Update();
+  vtkSmartPointer<vtkPolyData> processingResult = marchingCubes->GetOutput();
+  if (processingResult->GetNumberOfPolys() == 0)
+    {
+    surface->Initialize();
+    return;
+    }
+
+  if (settings.DecimationFactor > 0.0)
+    {
+    vtkNew<vtkDecimatePro> decimator;
+    decimator->SetInputData(processingResult);
+    decimator->SetFeatureAngle(60);
+    decimator->SplittingOff();
+    decimator->PreserveTopologyOn();
+    decimator->SetMaximumError(1);
+    decimator->SetTargetReduction(settings.DecimationFactor);
+    decimator->Update();
+    processingResult = decimator->GetOutput();
+    }
+
+  if (settings.SmoothingIterations > 0)
+    {
+    vtkNew<vtkWindowedSincPolyDataFilter> smoother;
+    smoother->SetInputData(processingResult);
+    smoother->SetNumberOfIterations(settings.SmoothingIterations);
+    smoother->SetPassBand(settings.SmoothingPassBand);
+    smoother->BoundarySmoothingOff();
+    smoother->FeatureEdgeSmoothingOff();
+    smoother->SetNonManifoldSmoothing(settings.NonManifoldSmoothing);
+    smoother->SetNormalizeCoordinates(settings.NormalizeCoordinates);
+    smoother->Update();
+    processingResult = smoother->GetOutput();
+    }
+
+  surface->ShallowCopy(processingResult);
+}
+
+//----------------------------------------------------------------------------
+struct ExtractThreadData
+{
+  ExtractionSettings Settings;
+  vtkImageData* Labelmap;
+  std::vector<int> LabelValues;
+  std::vector<std::array<int, 6> > LabelExtents;
+  std::vector<vtkPolyData*> Surfaces;
+  std::atomic<size_t> NextLabelIndex;
+};
+
+//----------------------------------------------------------------------------
+// Labels take very different time to extract (depending on their size),
+// therefore each thread takes the next label when it is done.
+VTK_THREAD_RETURN_TYPE ExtractThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ExtractThreadData* data = static_cast<ExtractThreadData*>(info->UserData);
+  for (size_t labelIndex = data->NextLabelIndex++; labelIndex < data->LabelValues.size(); labelIndex = data->NextLabelIndex++)
+    {
+    ExtractLabelInExtent(data->Settings, data->Labelmap, data->LabelValues[labelIndex],
+      data->LabelExtents[labelIndex], data->Surfaces[labelIndex]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkMultiLabelSurfaceExtractor::vtkMultiLabelSurfaceExtractor()
+  : DecimationFactor(0.0)
+  , SmoothingIterations(0)
+  , SmoothingPassBand(0.1)
+  , NonManifoldSmoothing(false)
+  , NormalizeCoordinates(false)
+  , PadBoundary(true)
+  , ComputeScalars(true)
+  , NumberOfThreads(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkMultiLabelSurfaceExtractor::~vtkMultiLabelSurfaceExtractor() = default;
+
+//----------------------------------------------------------------------------
+void vtkMultiLabelSurfaceExtractor::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "DecimationFactor: " << this->DecimationFactor << "\n";
+  os << indent << "SmoothingIterations: " << this->SmoothingIterations << "\n";
+  os << indent << "SmoothingPassBand: " << this->SmoothingPassBand << "\n";
+  os << indent << "NonManifoldSmoothing: " << (this->NonManifoldSmoothing ? "On" : "Off") << "\n";
+  os << indent << "NormalizeCoordinates: " << (this->NormalizeCoordinates ? "On" : "Off") << "\n";
+  os << indent << "PadBoundary: " << (this->PadBoundary ? "On" : "Off") << "\n";
+  os << indent << "ComputeScalars: " << (this->ComputeScalars ? "On" : "Off") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMultiLabelSurfaceExtractor::ComputeLabelExtents(vtkImageData* labelmap, LabelExtentMap& labelExtents,
+  int numberOfThreads/*=0*/)
+{
+  labelExtents.clear();
+  if (!labelmap || !labelmap->GetPointData()->GetScalars()
+    || labelmap->GetNumberOfScalarComponents() != 1)
+    {
+    return;
+    }
+  int* extent = labelmap->GetExtent();
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return;
+    }
+
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  numberOfThreads = std::min(GetNumberOfThreadsToUse(numberOfThreads),
+    std::max(1, numberOfSlices / MinimumNumberOfSlicesPerThread));
+  LabelExtentsThreadData data;
+  data.Labelmap = labelmap;
+  data.ThreadLabelExtents.resize(numberOfThreads);
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ComputeLabelExtentsThread, &data);
+  threader->SingleMethodExecute();
+
+  // Merge the extents found by each thread
+  labelExtents.swap(data.ThreadLabelExtents[0]);
+  for (int threadIndex = 1; threadIndex < numberOfThreads; ++threadIndex)
+    {
+    for (const auto& threadLabelExtent : data.ThreadLabelExtents[threadIndex])
+      {
+      LabelExtentMap::iterator labelIt = labelExtents.find(threadLabelExtent.first);
+      if (labelIt == labelExtents.end())
+        {
+        labelExtents.insert(threadLabelExtent);
+        continue;
+        }
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        labelIt->second[axis * 2] = std::min(labelIt->second[axis * 2], threadLabelExtent.second[axis * 2]);
+        labelIt->second[axis * 2 + 1] = std::max(labelIt->second[axis * 2 + 1], threadLabelExtent.second[axis * 2 + 1]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkMultiLabelSurfaceExtractor::Extract(vtkImageData* labelmap, const std::vector<int>& labelValues,
+  std::vector<vtkSmartPointer<vtkPolyData> >& surfaces, const LabelExtentMap* labelExtents/*=nullptr*/)
+{
+  surfaces.clear();
+  if (!labelmap || !labelmap->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Extract: Invalid labelmap");
+    return false;
+    }
+  if (labelmap->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro("Extract: Labelmap must have a single scalar component");
+    return false;
+    }
+
+  LabelExtentMap computedLabelExtents;
+  if (!labelExtents)
+    {
+    vtkMultiLabelSurfaceExtractor::ComputeLabelExtents(labelmap, computedLabelExtents, this->NumberOfThreads);
+    labelExtents = &computedLabelExtents;
+    }
+
+  ExtractThreadData data;
+  data.Settings.DecimationFactor = this->DecimationFactor;
+  data.Settings.SmoothingIterations = this->SmoothingIterations;
+  data.Settings.SmoothingPassBand = this->SmoothingPassBand;
+  data.Settings.NonManifoldSmoothing = this->NonManifoldSmoothing;
+  data.Settings.NormalizeCoordinates = this->NormalizeCoordinates;
+  data.Settings.PadBoundary = this->PadBoundary;
+  data.Settings.ComputeScalars = this->ComputeScalars;
+  data.Labelmap = labelmap;
+  data.NextLabelIndex = 0;
+  for (int labelValue : labelValues)
+    {
+    vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+    surfaces.push_back(surface);
+    LabelExtentMap::const_iterator labelIt = labelExtents->find(labelValue);
+    if (labelValue == 0 || labelIt == labelExtents->end())
+      {
+      // Label is not in the labelmap, its surface is empty
+      continue;
+      }
+    data.LabelValues.push_back(labelValue);
+    data.LabelExtents.push_back(labelIt->second);
+    data.Surfaces.push_back(surface);
+    }
+  if (data.LabelValues.empty())
+    {
+    return true;
+    }
+
+  int numberOfThreads = std::min(GetNumberOfThreadsToUse(this->NumberOfThreads), static_cast<int>(data.LabelValues.size()));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ExtractThread, &data);
+  threader->SingleMethodExecute();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMultiLabelSurfaceExtractor::ExtractLabel(vtkImageData* labelmap, int labelValue, vtkPolyData* surface,
+  const LabelExtentMap* labelExtents/*=nullptr*/)
+{
+  if (!surface)
+    {
+    vtkErrorMacro("ExtractLabel: Invalid surface");
+    return false;
+    }
+  std::vector<int> labelValues(1, labelValue);
+  std::vector<vtkSmartPointer<vtkPolyData> > surfaces;
+  if (!this->Extract(labelmap, labelValues, surfaces, labelExtents))
+    {
+    return false;
+    }
+  surface->ShallowCopy(surfaces[0]);
+  return true;
+}
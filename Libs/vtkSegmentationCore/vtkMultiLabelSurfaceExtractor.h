@@ -0,0 +1,129 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkMultiLabelSurfaceExtractor_h
+#define __vtkMultiLabelSurfaceExtractor_h
+
+// Segmentation includes
+#include "vtkSegmentationCoreConfigure.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <array>
+#include <map>
+#include <vector>
+
+class vtkImageData;
+class vtkPolyData;
+
+/// \ingroup SegmentationCore
+/// \brief Extract the surface of each label of a labelmap
+///
+/// The bounding box of all labels is computed in one pass over the labelmap.
+/// The surface of each label is then extracted from its bounding box only (with one
+/// voxel margin), and decimated and smoothed. Labels are processed concurrently.
+///
+/// The output surfaces are in the IJK coordinate system of the labelmap (origin and
+/// spacing of the labelmap are ignored), they are the same as the surfaces that
+/// vtkDiscreteFlyingEdges3D extracts from the whole (padded) labelmap for each label.
+class vtkSegmentationCore_EXPORT vtkMultiLabelSurfaceExtractor : public vtkObject
+{
+public:
+  static vtkMultiLabelSurfaceExtractor *New();
+  vtkTypeMacro(vtkMultiLabelSurfaceExtractor, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Extent of the voxels of each label value
+  typedef std::map<int, std::array<int, 6> > LabelExtentMap;
+
+  /// Desired reduction in the number of polygons (vtkDecimatePro target reduction).
+  /// Default is 0.0 (no decimation).
+  vtkSetClampMacro(DecimationFactor, double, 0.0, 1.0);
+  vtkGetMacro(DecimationFactor, double);
+
+  /// Number of iterations of vtkWindowedSincPolyDataFilter. Default is 0 (no smoothing).
+  vtkSetMacro(SmoothingIterations, int);
+  vtkGetMacro(SmoothingIterations, int);
+
+  /// Pass band of vtkWindowedSincPolyDataFilter. Default is 0.1.
+  vtkSetMacro(SmoothingPassBand, double);
+  vtkGetMacro(SmoothingPassBand, double);
+
+  /// Smooth non-manifold vertices. Default is off.
+  vtkSetMacro(NonManifoldSmoothing, bool);
+  vtkGetMacro(NonManifoldSmoothing, bool);
+  vtkBooleanMacro(NonManifoldSmoothing, bool);
+
+  /// Normalize coordinates before smoothing. Default is off.
+  vtkSetMacro(NormalizeCoordinates, bool);
+  vtkGetMacro(NormalizeCoordinates, bool);
+  vtkBooleanMacro(NormalizeCoordinates, bool);
+
+  /// Add one voxel of background around the labelmap, so that labels touching the
+  /// image boundary get closed surfaces. Default is on.
+  vtkSetMacro(PadBoundary, bool);
+  vtkGetMacro(PadBoundary, bool);
+  vtkBooleanMacro(PadBoundary, bool);
+
+  /// Store the label value in the point scalars of the surfaces. Default is on.
+  vtkSetMacro(ComputeScalars, bool);
+  vtkGetMacro(ComputeScalars, bool);
+  vtkBooleanMacro(ComputeScalars, bool);
+
+  /// Maximum number of labels processed concurrently. Default is 0, which uses
+  /// vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Compute the extent of each non-zero label value in one pass over the labelmap.
+  /// Scalars are cast to int. Slabs of the labelmap are scanned concurrently.
+  static void ComputeLabelExtents(vtkImageData* labelmap, LabelExtentMap& labelExtents, int numberOfThreads = 0);
+
+  /// Extract the surface of each label value.
+  /// \param labelmap Labelmap with integer scalars
+  /// \param labelValues Label values to extract surfaces for
+  /// \param surfaces Surface of each label value, in the same order as labelValues.
+  ///   Surfaces of label values that are not in the labelmap are empty.
+  /// \param labelExtents Extents of the labels, as computed by \sa ComputeLabelExtents.
+  ///   If nullptr, extents are computed.
+  /// \return Success flag
+  bool Extract(vtkImageData* labelmap, const std::vector<int>& labelValues,
+    std::vector<vtkSmartPointer<vtkPolyData> >& surfaces, const LabelExtentMap* labelExtents = nullptr);
+
+  /// Extract the surface of a single label value, see \sa Extract.
+  bool ExtractLabel(vtkImageData* labelmap, int labelValue, vtkPolyData* surface, const LabelExtentMap* labelExtents = nullptr);
+
+protected:
+  vtkMultiLabelSurfaceExtractor();
+  ~vtkMultiLabelSurfaceExtractor() override;
+
+  double DecimationFactor;
+  int SmoothingIterations;
+  double SmoothingPassBand;
+  bool NonManifoldSmoothing;
+  bool NormalizeCoordinates;
+  bool PadBoundary;
+  bool ComputeScalars;
+  int NumberOfThreads;
+
+private:
+  vtkMultiLabelSurfaceExtractor(const vtkMultiLabelSurfaceExtractor&) = delete;
+  void operator=(const vtkMultiLabelSurfaceExtractor&) = delete;
+};
+
+#endif
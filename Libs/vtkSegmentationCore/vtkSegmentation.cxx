@@ -36,6 +36,7 @@
 #include <vtkImageThreshold.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
@@ -47,6 +48,7 @@
 
 // STD includes
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <sstream>
 
@@ -66,6 +68,31 @@ public:
     }
 };
 
+namespace
+{
+//----------------------------------------------------------------------------
+struct ConvertSegmentsThreadData
+{
+  vtkSegmentationConverterRule* Rule;
+  std::vector<vtkSegment*> Segments;
+  std::atomic<size_t> NextSegmentIndex;
+};
+
+//----------------------------------------------------------------------------
+// Segments take very different time to convert (depending on their size),
+// therefore each thread takes the next unconverted segment when it is done.
+VTK_THREAD_RETURN_TYPE ConvertSegmentsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ConvertSegmentsThreadData* data = static_cast<ConvertSegmentsThreadData*>(info->UserData);
+  for (size_t segmentIndex = data->NextSegmentIndex++; segmentIndex < data->Segments.size(); segmentIndex = data->NextSegmentIndex++)
+    {
+    data->Rule->Convert(data->Segments[segmentIndex]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
 //----------------------------------------------------------------------------
 vtkSegmentation::vtkSegmentation()
 {
@@ -84,6 +111,8 @@ vtkSegmentation::vtkSegmentation()
 
   this->SegmentIdAutogeneratorIndex = 0;
 
+  this->NumberOfConversionThreads = 0;
+
   this->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
 }
 
@@ -147,6 +176,7 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
 
   // Copy properties
   this->SetMasterRepresentationName(aSegmentation->GetMasterRepresentationName());
+  this->NumberOfConversionThreads = aSegmentation->NumberOfConversionThreads;
 
   // Copy conversion parameters
   this->Converter->DeepCopy(aSegmentation->Converter);
@@ -178,6 +208,7 @@ void vtkSegmentation::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "MasterRepresentationName:  " << this->MasterRepresentationName << "\n";
   os << indent << "Number of segments:  " << this->Segments.size() << "\n";
+  os << indent << "NumberOfConversionThreads:  " << this->NumberOfConversionThreads << "\n";
 
   for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin();
     segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
@@ -1031,6 +1062,7 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
 
     // Perform conversion step
     currentConversionRule->PreConvert(this);
+    std::vector<vtkSegment*> segmentsToConvert;
     for (auto segmentID : segmentIDs)
       {
       vtkSegment* segment = this->GetSegment(segmentID);
@@ -1053,11 +1085,56 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
         {
         continue;
         }
-      currentConversionRule->Convert(segment);
+      segmentsToConvert.push_back(segment);
       }
-    currentConversionRule->PostConvert(this);
 
-  }
+    int numberOfThreads = this->NumberOfConversionThreads;
+    if (numberOfThreads <= 0)
+      {
+      numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+      }
+    numberOfThreads = std::min(numberOfThreads, static_cast<int>(segmentsToConvert.size()));
+    if (numberOfThreads > 1 && currentConversionRule->IsConvertThreadSafe())
+      {
+      // Segment modified events must not be invoked from the conversion threads.
+      // Instead, modified event of the converted segments is invoked after all segments are converted.
+      std::vector<vtkMTimeType> segmentMTimesBefore;
+      for (vtkSegment* segment : segmentsToConvert)
+        {
+        segmentMTimesBefore.push_back(segment->GetMTime());
+        }
+      bool wasSegmentModifiedEnabled = this->SetSegmentModifiedEnabled(false);
+
+      ConvertSegmentsThreadData data;
+      data.Rule = currentConversionRule;
+      data.Segments = segmentsToConvert;
+      data.NextSegmentIndex = 0;
+      vtkNew<vtkMultiThreader> threader;
+      threader->SetNumberOfThreads(numberOfThreads);
+      threader->SetSingleMethod(ConvertSegmentsThread, &data);
+      threader->SingleMethodExecute();
+
+      this->SetSegmentModifiedEnabled(wasSegmentModifiedEnabled);
+      if (wasSegmentModifiedEnabled)
+        {
+        for (size_t segmentIndex = 0; segmentIndex < segmentsToConvert.size(); ++segmentIndex)
+          {
+          if (segmentsToConvert[segmentIndex]->GetMTime() != segmentMTimesBefore[segmentIndex])
+            {
+            segmentsToConvert[segmentIndex]->Modified();
+            }
+          }
+        }
+      }
+    else
+      {
+      for (vtkSegment* segment : segmentsToConvert)
+        {
+        currentConversionRule->Convert(segment);
+        }
+      }
+    currentConversionRule->PostConvert(this);
+    }
 
   return true;
 }
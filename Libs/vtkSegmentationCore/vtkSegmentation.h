@@ -461,6 +461,12 @@ public:
   /// the segmentation! Use \sa CreateRepresentation for that.
   virtual void SetMasterRepresentationName(const std::string& representationName);
 
+  /// Maximum number of threads used for converting segments concurrently.
+  /// Only conversion rules that support it convert segments concurrently (\sa vtkSegmentationConverterRule::IsConvertThreadSafe).
+  /// 0 (default) uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads(), 1 converts segments one by one.
+  vtkGetMacro(NumberOfConversionThreads, int);
+  vtkSetMacro(NumberOfConversionThreads, int);
+
   /// Deep copies source segment to destination segment. If the same representation is found in baseline
   /// with up-to-date timestamp then the representation is reused from baseline.
   static void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
@@ -544,6 +550,9 @@ protected:
   /// segment ID.
   int SegmentIdAutogeneratorIndex;
 
+  /// Maximum number of threads used for converting segments concurrently
+  int NumberOfConversionThreads;
+
   /// This contains the segment IDs in display order.
   /// (we could retrieve segment IDs from SegmentMap too, but that always contains segments in
   /// alphabetical order)
@@ -99,6 +99,17 @@ std::string vtkSegmentationConverterRule::GetConversionParameterDescription(cons
   return this->ConversionParameters[name].second;
 }
 
+//----------------------------------------------------------------------------
+std::string vtkSegmentationConverterRule::GetConversionParameterValue(const std::string& name) const
+{
+  ConversionParameterListType::const_iterator parameterIt = this->ConversionParameters.find(name);
+  if (parameterIt == this->ConversionParameters.end())
+    {
+    return "";
+    }
+  return parameterIt->second.first;
+}
+
 //----------------------------------------------------------------------------
 bool vtkSegmentationConverterRule::HasConversionParameter(const std::string& name)
 {
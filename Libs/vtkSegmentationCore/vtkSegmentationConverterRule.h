@@ -92,6 +92,13 @@ public:
   /// \sa ConvertInternal
   virtual bool Convert(vtkSegment* segment) = 0;
 
+  /// Returns true if \sa Convert can be called concurrently for different segments
+  /// (between \sa PreConvert and \sa PostConvert). Convert must then only modify the
+  /// target representation of the segment, not the rule itself (conversion parameters, caches).
+  /// Segments of a shared labelmap have the same source representation object, which
+  /// must not be used as filter input data either (shallow-copy it first).
+  virtual bool IsConvertThreadSafe() { return false; };
+
   /// Perform post-conversion steps across the specified segments in the segmentation
   /// This step should be unneccessary if only converting a single segment
   virtual bool PostConvert(vtkSegmentation* vtkNotUsed(segmentation)) { return true; };
@@ -136,6 +143,11 @@ protected:
   /// Update the target representation based on the source representation
   virtual bool CreateTargetRepresentation(vtkSegment* segment);
 
+  /// Get a conversion parameter value, empty if the parameter is not defined.
+  /// Does not modify the parameter list, therefore it can be used in \sa Convert
+  /// when the rule converts segments concurrently (\sa IsConvertThreadSafe).
+  std::string GetConversionParameterValue(const std::string& name) const;
+
   vtkSegmentationConverterRule();
   ~vtkSegmentationConverterRule() override;
   void operator=(const vtkSegmentationConverterRule&);
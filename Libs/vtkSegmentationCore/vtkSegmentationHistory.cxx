@@ -20,16 +20,167 @@
 
 // SegmentationCore includes
 #include "vtkSegmentationHistory.h"
-#include "vtkSegmentationConverterFactory.h"
 #include "vtkSegmentation.h"
+#include "vtkOrientedImageData.h"
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkWeakPointer.h>
 
 // std includes
 #include <algorithm>
+#include <cstring>
+#include <set>
+
+//----------------------------------------------------------------------------
+// Encoded tile: the first byte is the encoding, followed by the voxels
+// (TILE_RAW) or by runs of identical voxels (TILE_RLE), each stored as
+// a 32-bit run length and the voxel value.
+typedef std::vector<unsigned char> EncodedTile;
+
+namespace
+{
+  enum
+    {
+    TILE_RAW = 0,
+    TILE_RLE = 1
+    };
+
+  //----------------------------------------------------------------------------
+  void EncodeTile(const unsigned char* voxels, vtkIdType numberOfVoxels, int voxelSize, EncodedTile& encoded)
+  {
+    encoded.clear();
+    encoded.push_back(TILE_RLE);
+    vtkIdType rawSize = numberOfVoxels * voxelSize;
+    vtkIdType voxelIndex = 0;
+    while (voxelIndex < numberOfVoxels)
+      {
+      const unsigned char* value = voxels + voxelIndex * voxelSize;
+      vtkTypeUInt32 runLength = 1;
+      if (voxelSize == 1)
+        {
+        while (voxelIndex + runLength < numberOfVoxels && value[runLength] == value[0] && runLength < VTK_TYPE_UINT32_MAX)
+          {
+          ++runLength;
+          }
+        }
+      else
+        {
+        while (voxelIndex + runLength < numberOfVoxels
+          && memcmp(value + runLength * voxelSize, value, voxelSize) == 0 && runLength < VTK_TYPE_UINT32_MAX)
+          {
+          ++runLength;
+          }
+        }
+      const unsigned char* runLengthBytes = reinterpret_cast<const unsigned char*>(&runLength);
+      encoded.insert(encoded.end(), runLengthBytes, runLengthBytes + sizeof(runLength));
+      encoded.insert(encoded.end(), value, value + voxelSize);
+      if (static_cast<vtkIdType>(encoded.size()) > rawSize)
+        {
+        // Run-length encoding does not make the tile smaller, store the voxels
+        encoded.resize(1 + rawSize);
+        encoded[0] = TILE_RAW;
+        memcpy(&encoded[1], voxels, rawSize);
+        return;
+        }
+      voxelIndex += runLength;
+      }
+    encoded.shrink_to_fit();
+  }
+
+  //----------------------------------------------------------------------------
+  void DecodeTile(const EncodedTile& encoded, vtkIdType numberOfVoxels, int voxelSize, unsigned char* voxels)
+  {
+    if (encoded.empty())
+      {
+      return;
+      }
+    if (encoded[0] == TILE_RAW)
+      {
+      memcpy(voxels, &encoded[1], numberOfVoxels * voxelSize);
+      return;
+      }
+    const unsigned char* run = &encoded[1];
+    const unsigned char* end = encoded.data() + encoded.size();
+    unsigned char* output = voxels;
+    while (run < end)
+      {
+      vtkTypeUInt32 runLength = 0;
+      memcpy(&runLength, run, sizeof(runLength));
+      run += sizeof(runLength);
+      if (voxelSize == 1)
+        {
+        memset(output, run[0], runLength);
+        output += runLength;
+        }
+      else
+        {
+        for (vtkTypeUInt32 i = 0; i < runLength; ++i)
+          {
+          memcpy(output, run, voxelSize);
+          output += voxelSize;
+          }
+        }
+      run += voxelSize;
+      }
+  }
+}
+
+//----------------------------------------------------------------------------
+struct vtkSegmentationHistory::LabelmapState
+{
+  // Labelmap the state was saved from and its modified time at that point,
+  // used for detecting labelmaps that have not changed since.
+  vtkWeakPointer<vtkDataObject> Source;
+  vtkMTimeType SourceMTime = 0;
+
+  // Geometry
+  int Extent[6] = { 0, -1, 0, -1, 0, -1 };
+  double Origin[3] = { 0.0, 0.0, 0.0 };
+  double Spacing[3] = { 1.0, 1.0, 1.0 };
+  double Directions[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+  bool HasScalars = false;
+  int ScalarType = VTK_UNSIGNED_CHAR;
+  int NumberOfScalarComponents = 1;
+
+  // Tiles, in x, y, z order. Tiles that are unchanged between states are shared.
+  int TileSize = 0;
+  int NumberOfTiles[3] = { 0, 0, 0 };
+  std::vector<std::shared_ptr<const EncodedTile> > Tiles;
+
+  //----------------------------------------------------------------------------
+  /// Returns true if tiles of the two states cover the same voxels
+  bool IsSameTiling(const LabelmapState& other) const
+  {
+    return this->HasScalars == other.HasScalars
+      && this->ScalarType == other.ScalarType
+      && this->NumberOfScalarComponents == other.NumberOfScalarComponents
+      && this->TileSize == other.TileSize
+      && std::equal(this->Extent, this->Extent + 6, other.Extent)
+      && this->Tiles.size() == other.Tiles.size();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get the extent of a tile (clipped to the image extent)
+  void GetTileExtent(vtkIdType tileIndex, int tileExtent[6]) const
+  {
+    int tileIjk[3] =
+      {
+      static_cast<int>(tileIndex % this->NumberOfTiles[0]),
+      static_cast<int>((tileIndex / this->NumberOfTiles[0]) % this->NumberOfTiles[1]),
+      static_cast<int>(tileIndex / (this->NumberOfTiles[0] * this->NumberOfTiles[1]))
+      };
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      tileExtent[axis * 2] = this->Extent[axis * 2] + tileIjk[axis] * this->TileSize;
+      tileExtent[axis * 2 + 1] = std::min(tileExtent[axis * 2] + this->TileSize - 1, this->Extent[axis * 2 + 1]);
+      }
+  }
+};
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentationHistory);
@@ -40,6 +191,8 @@ vtkSegmentationHistory::vtkSegmentationHistory()
   this->Segmentation = nullptr;
 
   this->MaximumNumberOfStates = 5;
+  this->MaximumMemorySize = 0;
+  this->TileSize = 32;
 
   this->LastRestoredState = 0;
   this->RestoreStateInProgress = false;
@@ -98,6 +251,9 @@ void vtkSegmentationHistory::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Modified Time: " << this->GetMTime() << "\n";
 
   os << indent << "Number of saved states:  " << this->SegmentationStates.size() << "\n";
+  os << indent << "MaximumNumberOfStates:  " << this->MaximumNumberOfStates << "\n";
+  os << indent << "MaximumMemorySize:  " << this->MaximumMemorySize << "\n";
+  os << indent << "TileSize:  " << this->TileSize << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -123,6 +279,28 @@ bool vtkSegmentationHistory::SaveState()
   this->Segmentation->GetSegmentIDs(segmentIDs);
   newSegmentationState.SegmentIds = segmentIDs;
   std::map<vtkDataObject*, vtkDataObject*> savedObjects;
+  std::map<vtkDataObject*, std::shared_ptr<LabelmapState> > savedLabelmaps;
+
+  // Labelmaps of the previous saved state, by the labelmap they were saved from.
+  // Unchanged labelmaps are reused as a whole and changed labelmaps share their unchanged tiles.
+  std::map<vtkDataObject*, std::shared_ptr<LabelmapState> > baselineLabelmapsBySource;
+  if (this->SegmentationStates.size() > 0)
+    {
+    SegmentationState& baselineState = this->SegmentationStates.back();
+    for (std::map<std::string, LabelmapsMap>::iterator segmentLabelmapsIt = baselineState.Labelmaps.begin();
+      segmentLabelmapsIt != baselineState.Labelmaps.end(); ++segmentLabelmapsIt)
+      {
+      for (LabelmapsMap::iterator labelmapIt = segmentLabelmapsIt->second.begin();
+        labelmapIt != segmentLabelmapsIt->second.end(); ++labelmapIt)
+        {
+        if (labelmapIt->second->Source.GetPointer())
+          {
+          baselineLabelmapsBySource[labelmapIt->second->Source.GetPointer()] = labelmapIt->second;
+          }
+        }
+      }
+    }
+
   for (std::vector<std::string>::iterator segmentIDIt = segmentIDs.begin(); segmentIDIt != segmentIDs.end(); ++segmentIDIt)
     {
     vtkSegment* segment = this->Segmentation->GetSegment(*segmentIDIt);
@@ -134,17 +312,62 @@ bool vtkSegmentationHistory::SaveState()
     // Previous saved state of the segment
     // (if the new state has exactly the same representation then only a shallow copy will be made)
     vtkSegment* baselineSegment = nullptr;
+    LabelmapsMap* baselineLabelmaps = nullptr;
     if (this->SegmentationStates.size() > 0)
       {
-      SegmentsMap::iterator baselineSegmentIt = this->SegmentationStates.back().Segments.find(*segmentIDIt);
-      if (baselineSegmentIt != this->SegmentationStates.back().Segments.end())
+      SegmentationState& baselineState = this->SegmentationStates.back();
+      SegmentsMap::iterator baselineSegmentIt = baselineState.Segments.find(*segmentIDIt);
+      if (baselineSegmentIt != baselineState.Segments.end())
         {
         baselineSegment = baselineSegmentIt->second.GetPointer();
         }
+      std::map<std::string, LabelmapsMap>::iterator baselineLabelmapsIt = baselineState.Labelmaps.find(*segmentIDIt);
+      if (baselineLabelmapsIt != baselineState.Labelmaps.end())
+        {
+        baselineLabelmaps = &baselineLabelmapsIt->second;
+        }
+      }
+
+    // Labelmaps are stored in tiles. If the labelmap is shared with a previous segment then it is stored only once.
+    std::vector<std::string> representationNames;
+    segment->GetContainedRepresentationNames(representationNames);
+    std::vector<std::string> labelmapRepresentationNames;
+    for (const std::string& representationName : representationNames)
+      {
+      vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(representationName));
+      if (!labelmap)
+        {
+        continue;
+        }
+      labelmapRepresentationNames.push_back(representationName);
+      std::shared_ptr<LabelmapState>& labelmapState = savedLabelmaps[labelmap];
+      if (!labelmapState)
+        {
+        std::shared_ptr<LabelmapState> baselineLabelmap;
+        std::map<vtkDataObject*, std::shared_ptr<LabelmapState> >::iterator baselineBySourceIt =
+          baselineLabelmapsBySource.find(labelmap);
+        if (baselineBySourceIt != baselineLabelmapsBySource.end())
+          {
+          baselineLabelmap = baselineBySourceIt->second;
+          }
+        else if (baselineLabelmaps && baselineLabelmaps->find(representationName) != baselineLabelmaps->end())
+          {
+          baselineLabelmap = (*baselineLabelmaps)[representationName];
+          }
+        labelmapState = this->SaveLabelmap(labelmap, baselineLabelmap);
+        }
+      newSegmentationState.Labelmaps[*segmentIDIt][representationName] = labelmapState;
+      // Labelmaps are not copied by CopySegment, their tiles are restored instead
+      savedObjects[labelmap] = labelmap;
       }
 
+    // Other representations are copied (or shallow copied from the baseline if unchanged)
     vtkSmartPointer<vtkSegment> segmentClone = vtkSmartPointer<vtkSegment>::New();
     vtkSegmentation::CopySegment(segmentClone, segment, baselineSegment, savedObjects);
+    for (const std::string& representationName : labelmapRepresentationNames)
+      {
+      segmentClone->RemoveRepresentation(representationName);
+      }
     newSegmentationState.Segments[*segmentIDIt] = segmentClone;
     }
   this->SegmentationStates.push_back(newSegmentationState);
@@ -185,6 +408,11 @@ bool vtkSegmentationHistory::RestorePreviousState()
     // this->SegmentationStates.size() - 2 is the state that was the last saved state before
     stateToRestore = (int)this->SegmentationStates.size() - 2;
     }
+  if (stateToRestore < 0)
+    {
+    vtkWarningMacro("vtkSegmentation::RestorePreviousState failed: There are no previous state available for restore");
+    return false;
+    }
   return this->RestoreState(stateToRestore);
 }
 
@@ -213,6 +441,7 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
 
   std::set<std::string> segmentIDsToKeep;
   std::map<vtkDataObject*, vtkDataObject*> restoredRepresentations;
+  std::map<LabelmapState*, vtkSmartPointer<vtkOrientedImageData> > restoredLabelmaps;
   for (SegmentsMap::iterator restoredSegmentsIt = restoredState.Segments.begin();
     restoredSegmentsIt != restoredState.Segments.end(); ++restoredSegmentsIt)
     {
@@ -229,6 +458,23 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
 
     std::vector<std::string> restoredRepresentationNames;
     segmentToRestore->GetContainedRepresentationNames(restoredRepresentationNames);
+
+    // Labelmaps are restored from their tiles. Segments that shared a labelmap share the restored labelmap.
+    LabelmapsMap& labelmapsToRestore = restoredState.Labelmaps[restoredSegmentsIt->first];
+    for (LabelmapsMap::iterator labelmapIt = labelmapsToRestore.begin(); labelmapIt != labelmapsToRestore.end(); ++labelmapIt)
+      {
+      vtkSmartPointer<vtkOrientedImageData>& restoredLabelmap = restoredLabelmaps[labelmapIt->second.get()];
+      if (!restoredLabelmap)
+        {
+        restoredLabelmap = vtkSegmentationHistory::RestoreLabelmap(labelmapIt->second.get());
+        // The restored labelmap is unchanged until it is modified, the next saved state can reuse this one
+        labelmapIt->second->Source = restoredLabelmap;
+        labelmapIt->second->SourceMTime = restoredLabelmap->GetMTime();
+        }
+      segment->AddRepresentation(labelmapIt->first, restoredLabelmap);
+      restoredRepresentationNames.push_back(labelmapIt->first);
+      }
+
     std::vector<std::string> currentRepresentationNames;
     segment->GetContainedRepresentationNames(currentRepresentationNames);
     // Remove representations that are not in the restoring segment
@@ -304,9 +550,23 @@ void vtkSegmentationHistory::RemoveAllObsoleteStates()
   while ((this->SegmentationStates.size() > this->MaximumNumberOfStates) && (!this->SegmentationStates.empty()))
     {
     this->SegmentationStates.pop_front();
-    this->LastRestoredState--;
+    if (this->LastRestoredState > 0)
+      {
+      this->LastRestoredState--;
+      }
     modified = true;
-   }
+    }
+  // Memory limit: keep at least the two most recent states so that the last change can be undone
+  while (this->MaximumMemorySize > 0 && this->SegmentationStates.size() > 2
+    && this->GetMemorySize() > this->MaximumMemorySize)
+    {
+    this->SegmentationStates.pop_front();
+    if (this->LastRestoredState > 0)
+      {
+      this->LastRestoredState--;
+      }
+    modified = true;
+    }
   if (modified)
     {
     this->Modified();
@@ -363,3 +623,168 @@ int vtkSegmentationHistory::GetNumberOfStates()
 {
   return this->SegmentationStates.size();
 }
+
+//---------------------------------------------------------------------------
+void vtkSegmentationHistory::SetMaximumMemorySize(vtkTypeInt64 maximumMemorySize)
+{
+  if (maximumMemorySize == this->MaximumMemorySize)
+    {
+    return;
+    }
+  this->MaximumMemorySize = maximumMemorySize;
+  this->RemoveAllObsoleteStates();
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+vtkTypeInt64 vtkSegmentationHistory::GetMemorySize()
+{
+  vtkTypeInt64 memorySize = 0;
+  std::set<const void*> countedData;
+  for (const SegmentationState& state : this->SegmentationStates)
+    {
+    for (SegmentsMap::const_iterator segmentIt = state.Segments.begin(); segmentIt != state.Segments.end(); ++segmentIt)
+      {
+      std::vector<std::string> representationNames;
+      segmentIt->second->GetContainedRepresentationNames(representationNames);
+      for (const std::string& representationName : representationNames)
+        {
+        vtkDataObject* representation = segmentIt->second->GetRepresentation(representationName);
+        if (representation && countedData.insert(representation).second)
+          {
+          memorySize += static_cast<vtkTypeInt64>(representation->GetActualMemorySize()) * 1024;
+          }
+        }
+      }
+    for (std::map<std::string, LabelmapsMap>::const_iterator segmentIt = state.Labelmaps.begin(); segmentIt != state.Labelmaps.end(); ++segmentIt)
+      {
+      for (LabelmapsMap::const_iterator labelmapIt = segmentIt->second.begin(); labelmapIt != segmentIt->second.end(); ++labelmapIt)
+        {
+        if (!countedData.insert(labelmapIt->second.get()).second)
+          {
+          continue;
+          }
+        memorySize += sizeof(LabelmapState) + labelmapIt->second->Tiles.size() * sizeof(std::shared_ptr<const EncodedTile>);
+        for (const std::shared_ptr<const EncodedTile>& tile : labelmapIt->second->Tiles)
+          {
+          if (countedData.insert(tile.get()).second)
+            {
+            memorySize += sizeof(EncodedTile) + tile->capacity();
+            }
+          }
+        }
+      }
+    }
+  return memorySize;
+}
+
+//---------------------------------------------------------------------------
+std::shared_ptr<vtkSegmentationHistory::LabelmapState> vtkSegmentationHistory::SaveLabelmap(
+  vtkOrientedImageData* labelmap, std::shared_ptr<LabelmapState> baseline)
+{
+  // If the labelmap has not changed since the baseline was saved then the whole baseline is reused
+  if (baseline && baseline->Source.GetPointer() == labelmap && baseline->SourceMTime == labelmap->GetMTime()
+    && baseline->TileSize == this->TileSize)
+    {
+    return baseline;
+    }
+
+  std::shared_ptr<LabelmapState> labelmapState = std::make_shared<LabelmapState>();
+  labelmapState->Source = labelmap;
+  labelmapState->SourceMTime = labelmap->GetMTime();
+  labelmap->GetExtent(labelmapState->Extent);
+  labelmap->GetOrigin(labelmapState->Origin);
+  labelmap->GetSpacing(labelmapState->Spacing);
+  labelmap->GetDirections(labelmapState->Directions);
+  labelmapState->TileSize = this->TileSize;
+
+  vtkDataArray* scalars = labelmap->GetPointData() ? labelmap->GetPointData()->GetScalars() : nullptr;
+  labelmapState->HasScalars = (scalars != nullptr);
+  int* extent = labelmapState->Extent;
+  if (!labelmapState->HasScalars || extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return labelmapState;
+    }
+  labelmapState->ScalarType = labelmap->GetScalarType();
+  labelmapState->NumberOfScalarComponents = labelmap->GetNumberOfScalarComponents();
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    labelmapState->NumberOfTiles[axis] = (extent[axis * 2 + 1] - extent[axis * 2] + this->TileSize) / this->TileSize;
+    }
+  vtkIdType numberOfTiles = static_cast<vtkIdType>(labelmapState->NumberOfTiles[0])
+    * labelmapState->NumberOfTiles[1] * labelmapState->NumberOfTiles[2];
+  labelmapState->Tiles.resize(numberOfTiles);
+
+  bool baselineTilesComparable = (baseline && baseline->IsSameTiling(*labelmapState));
+  int voxelSize = labelmap->GetScalarSize() * labelmapState->NumberOfScalarComponents;
+  std::vector<unsigned char> tileVoxels(static_cast<size_t>(this->TileSize) * this->TileSize * this->TileSize * voxelSize);
+  std::shared_ptr<EncodedTile> encodedTile = std::make_shared<EncodedTile>();
+  for (vtkIdType tileIndex = 0; tileIndex < numberOfTiles; ++tileIndex)
+    {
+    int tileExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    labelmapState->GetTileExtent(tileIndex, tileExtent);
+    size_t rowSize = static_cast<size_t>(tileExtent[1] - tileExtent[0] + 1) * voxelSize;
+    unsigned char* tileVoxelsPtr = tileVoxels.data();
+    for (int z = tileExtent[4]; z <= tileExtent[5]; ++z)
+      {
+      for (int y = tileExtent[2]; y <= tileExtent[3]; ++y)
+        {
+        memcpy(tileVoxelsPtr, labelmap->GetScalarPointer(tileExtent[0], y, z), rowSize);
+        tileVoxelsPtr += rowSize;
+        }
+      }
+    vtkIdType numberOfTileVoxels = static_cast<vtkIdType>(tileVoxelsPtr - tileVoxels.data()) / voxelSize;
+    EncodeTile(tileVoxels.data(), numberOfTileVoxels, voxelSize, *encodedTile);
+
+    // Encoding is deterministic, so equal encoded tiles have equal voxels
+    if (baselineTilesComparable && *baseline->Tiles[tileIndex] == *encodedTile)
+      {
+      labelmapState->Tiles[tileIndex] = baseline->Tiles[tileIndex];
+      }
+    else
+      {
+      labelmapState->Tiles[tileIndex] = encodedTile;
+      encodedTile = std::make_shared<EncodedTile>();
+      }
+    }
+  return labelmapState;
+}
+
+//---------------------------------------------------------------------------
+vtkSmartPointer<vtkOrientedImageData> vtkSegmentationHistory::RestoreLabelmap(LabelmapState* labelmapState)
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  labelmap->SetExtent(labelmapState->Extent);
+  labelmap->SetOrigin(labelmapState->Origin);
+  labelmap->SetSpacing(labelmapState->Spacing);
+  labelmap->SetDirections(labelmapState->Directions);
+  if (!labelmapState->HasScalars)
+    {
+    return labelmap;
+    }
+  labelmap->AllocateScalars(labelmapState->ScalarType, labelmapState->NumberOfScalarComponents);
+
+  int tileSize = labelmapState->TileSize;
+  int voxelSize = labelmap->GetScalarSize() * labelmapState->NumberOfScalarComponents;
+  std::vector<unsigned char> tileVoxels(static_cast<size_t>(tileSize) * tileSize * tileSize * voxelSize);
+  vtkIdType numberOfTiles = static_cast<vtkIdType>(labelmapState->Tiles.size());
+  for (vtkIdType tileIndex = 0; tileIndex < numberOfTiles; ++tileIndex)
+    {
+    int tileExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    labelmapState->GetTileExtent(tileIndex, tileExtent);
+    size_t rowSize = static_cast<size_t>(tileExtent[1] - tileExtent[0] + 1) * voxelSize;
+    vtkIdType numberOfTileVoxels = static_cast<vtkIdType>(tileExtent[1] - tileExtent[0] + 1)
+      * (tileExtent[3] - tileExtent[2] + 1) * (tileExtent[5] - tileExtent[4] + 1);
+    DecodeTile(*labelmapState->Tiles[tileIndex], numberOfTileVoxels, voxelSize, tileVoxels.data());
+    const unsigned char* tileVoxelsPtr = tileVoxels.data();
+    for (int z = tileExtent[4]; z <= tileExtent[5]; ++z)
+      {
+      for (int y = tileExtent[2]; y <= tileExtent[3]; ++y)
+        {
+        memcpy(labelmap->GetScalarPointer(tileExtent[0], y, z), tileVoxelsPtr, rowSize);
+        tileVoxelsPtr += rowSize;
+        }
+      }
+    }
+  return labelmap;
+}
@@ -28,16 +28,25 @@
 // STD includes
 #include <deque>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "vtkSegmentationCoreConfigure.h"
 
 class vtkCallbackCommand;
 class vtkDataObject;
+class vtkOrientedImageData;
 class vtkSegment;
 class vtkSegmentation;
 
 /// \ingroup SegmentationCore
+/// \brief Stores previous states of a segmentation for undo/redo.
+///
+/// Binary labelmap representations are not copied as a whole. They are split
+/// into tiles (TileSize^3 voxels), each tile is run-length encoded, and tiles
+/// that have not changed since the previous state are shared with it.
+/// Therefore the memory used by a new state is proportional to the size of
+/// the edited region and not to the size of the labelmap.
 class vtkSegmentationCore_EXPORT vtkSegmentationHistory : public vtkObject
 {
 public:
@@ -86,6 +95,23 @@ public:
   /// Get the current number of states.
   int GetNumberOfStates();
 
+  /// Limits the memory size (in bytes) of the stored states.
+  /// If the stored states exceed the limit then the oldest states are removed,
+  /// but the two most recent states are always kept.
+  /// 0 (default) means no limit.
+  /// \sa GetMemorySize()
+  void SetMaximumMemorySize(vtkTypeInt64 maximumMemorySize);
+  vtkGetMacro(MaximumMemorySize, vtkTypeInt64);
+
+  /// Get the estimated memory size (in bytes) of the stored states.
+  /// Data shared between states is counted once.
+  vtkTypeInt64 GetMemorySize();
+
+  /// Size of the tiles (in voxels along each axis) that labelmaps are split into.
+  /// Smaller tiles store smaller changes with more overhead. Default is 32.
+  vtkSetClampMacro(TileSize, int, 4, 1024);
+  vtkGetMacro(TileSize, int);
+
 protected:
   /// Callback function called when the segmentation has been modified.
   /// It clears all states that are more recent than the last restored state.
@@ -107,16 +133,29 @@ protected:
 
   typedef std::map<std::string, vtkSmartPointer<vtkSegment> > SegmentsMap;
 
+  /// Tiled, run-length encoded copy of a labelmap representation
+  struct LabelmapState;
+  typedef std::map<std::string, std::shared_ptr<LabelmapState> > LabelmapsMap;
+
   struct SegmentationState
     {
-    SegmentsMap Segments;
+    SegmentsMap Segments; // segment metadata and representations that are not labelmaps
+    std::map<std::string, LabelmapsMap> Labelmaps; // segment ID -> representation name -> labelmap
     std::vector<std::string> SegmentIds; // order of segments
     };
 
+  /// Store the labelmap in tiles, sharing the tiles that are the same in the baseline
+  std::shared_ptr<LabelmapState> SaveLabelmap(vtkOrientedImageData* labelmap, std::shared_ptr<LabelmapState> baseline);
+
+  /// Create a labelmap from the stored tiles
+  static vtkSmartPointer<vtkOrientedImageData> RestoreLabelmap(LabelmapState* labelmapState);
+
   vtkSegmentation* Segmentation;
   vtkCallbackCommand* SegmentationModifiedCallbackCommand;
   std::deque<SegmentationState> SegmentationStates;
   unsigned int MaximumNumberOfStates;
+  vtkTypeInt64 MaximumMemorySize;
+  int TileSize;
 
   // Index of the state in SegmentationStates that was restored last.
   // If index == size of states then it means that the segmentation has changed
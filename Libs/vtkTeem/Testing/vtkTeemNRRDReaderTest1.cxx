@@ -0,0 +1,217 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkTeemNRRDReader.h>
+#include <vtkTeemNRRDWriter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> CreateImage(int numberOfComponents)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(20, 30, 40);
+  image->AllocateScalars(VTK_SHORT, numberOfComponents);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  vtkIdType numberOfValues = image->GetNumberOfPoints() * numberOfComponents;
+  for (vtkIdType i = 0; i < numberOfValues; ++i)
+    {
+    ptr[i] = static_cast<short>(i % 30011 - 15000);
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+bool CompareImages(vtkImageData* image, vtkImageData* expectedImage)
+{
+  int* extent = image->GetExtent();
+  int numberOfComponents = expectedImage->GetNumberOfScalarComponents();
+  if (image->GetNumberOfScalarComponents() != numberOfComponents
+    || image->GetScalarType() != expectedImage->GetScalarType())
+    {
+    std::cerr << "Scalar type or number of components mismatch" << std::endl;
+    return false;
+    }
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        for (int c = 0; c < numberOfComponents; ++c)
+          {
+          double value = image->GetScalarComponentAsDouble(i, j, k, c);
+          double expectedValue = expectedImage->GetScalarComponentAsDouble(i, j, k, c);
+          if (value != expectedValue)
+            {
+            std::cerr << "Value mismatch at (" << i << ", " << j << ", " << k << ", " << c << "): "
+              << value << " != " << expectedValue << std::endl;
+            return false;
+            }
+          }
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int TestRead(const std::string& fileName, vtkImageData* expectedImage)
+{
+  int* wholeExtent = expectedImage->GetExtent();
+
+  vtkNew<vtkTeemNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  if (reader->GetReadStatus() != 0 || !CompareImages(reader->GetOutput(), expectedImage))
+    {
+    std::cerr << "Failed to read " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  int* outputExtent = reader->GetOutput()->GetExtent();
+  if (!std::equal(outputExtent, outputExtent + 6, wholeExtent))
+    {
+    std::cerr << "Unexpected extent when reading " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Sub-extents: full rows and partial rows
+  int subExtents[2][6] = { { 0, 19, 5, 12, 30, 35 }, { 3, 7, 10, 29, 1, 2 } };
+  for (int extentIndex = 0; extentIndex < 2; ++extentIndex)
+    {
+    vtkNew<vtkTeemNRRDReader> subExtentReader;
+    subExtentReader->SetFileName(fileName.c_str());
+    subExtentReader->UpdateExtent(subExtents[extentIndex]);
+    vtkImageData* output = subExtentReader->GetOutput();
+    int* extent = output->GetExtent();
+    for (int i = 0; i < 3; ++i)
+      {
+      if (extent[2 * i] > subExtents[extentIndex][2 * i] || extent[2 * i + 1] < subExtents[extentIndex][2 * i + 1])
+        {
+        std::cerr << "Requested extent is not read from " << fileName << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    if (!CompareImages(output, expectedImage))
+      {
+      std::cerr << "Failed to read sub-extent of " << fileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestWriteRead(const std::string& fileName, vtkImageData* image, bool compression, bool ascii)
+{
+  vtkNew<vtkMatrix4x4> ijkToRas;
+  vtkNew<vtkTeemNRRDWriter> writer;
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(image);
+  writer->SetIJKToRASMatrix(ijkToRas.GetPointer());
+  writer->SetUseCompression(compression);
+  if (ascii)
+    {
+    writer->SetFileTypeToASCII();
+    }
+  writer->Write();
+  if (writer->GetWriteError())
+    {
+    std::cerr << "Failed to write " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  return TestRead(fileName, image);
+}
+
+//----------------------------------------------------------------------------
+int TestDetachedHeader(const std::string& tempDir, vtkImageData* image)
+{
+  // Raw voxels at the end of a data file (byte skip: -1)
+  std::string dataFileName = tempDir + "/vtkTeemNRRDReaderTest1_detached.raw";
+  std::ofstream dataFile(dataFileName.c_str(), std::ios::out | std::ios::binary);
+  dataFile << "Some bytes before the voxels";
+  dataFile.write(static_cast<char*>(image->GetScalarPointer()), image->GetNumberOfPoints() * sizeof(short));
+  dataFile.close();
+
+  std::string headerFileName = tempDir + "/vtkTeemNRRDReaderTest1_detached.nhdr";
+  std::ofstream headerFile(headerFileName.c_str(), std::ios::out);
+  headerFile << "NRRD0004\n"
+    << "type: short\n"
+    << "dimension: 3\n"
+    << "space: left-posterior-superior\n"
+    << "sizes: 20 30 40\n"
+    << "space directions: (1,0,0) (0,1,0) (0,0,1)\n"
+    << "kinds: domain domain domain\n"
+#ifdef VTK_WORDS_BIGENDIAN
+    << "endian: big\n"
+#else
+    << "endian: little\n"
+#endif
+    << "encoding: raw\n"
+    << "space origin: (0,0,0)\n"
+    << "byte skip: -1\n"
+    << "data file: vtkTeemNRRDReaderTest1_detached.raw\n";
+  headerFile.close();
+  return TestRead(headerFileName, image);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTeemNRRDReaderTest1(int argc, char* argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  vtkSmartPointer<vtkImageData> image = CreateImage(1);
+  vtkSmartPointer<vtkImageData> vectorImage = CreateImage(3);
+
+  // Raw and gzip: read without teem, sub-extents are read partially
+  if (TestWriteRead(tempDir + "/vtkTeemNRRDReaderTest1_raw.nrrd", image, false, false) != EXIT_SUCCESS
+    || TestWriteRead(tempDir + "/vtkTeemNRRDReaderTest1_gzip.nrrd", image, true, false) != EXIT_SUCCESS
+    || TestWriteRead(tempDir + "/vtkTeemNRRDReaderTest1_vector_gzip.nrrd", vectorImage, true, false) != EXIT_SUCCESS
+    || TestDetachedHeader(tempDir, image) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // ASCII: read by teem into the output, whole extent
+  if (TestWriteRead(tempDir + "/vtkTeemNRRDReaderTest1_ascii.nrrd", image, false, true) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "vtkTeemNRRDReaderTest1 passed." << std::endl;
+  return EXIT_SUCCESS;
+}
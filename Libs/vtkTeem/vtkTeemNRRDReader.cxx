@@ -30,6 +30,7 @@
 
 // VTK includes
 #include "vtkBitArray.h"
+#include <vtkByteSwap.h>
 #include "vtkCharArray.h"
 #include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
@@ -48,12 +49,137 @@
 #include "vtkUnsignedIntArray.h"
 #include "vtkUnsignedLongArray.h"
 #include <vtksys/SystemTools.hxx>
+#include <vtk_zlib.h>
 
 // Teem includes
 #include "teem/ten.h"
 
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
 vtkStandardNewMacro(vtkTeemNRRDReader);
 
+namespace
+{
+//----------------------------------------------------------------------------
+// Reads ranges of the voxel data of a raw or gzip encoded file.
+// Compressed data is decompressed sequentially, therefore ranges must be
+// read in increasing order.
+class NrrdDataStream
+{
+public:
+  NrrdDataStream()
+  {
+    memset(&this->ZStream, 0, sizeof(this->ZStream));
+  }
+
+  ~NrrdDataStream()
+  {
+    if (this->ZStreamInitialized)
+      {
+      inflateEnd(&this->ZStream);
+      }
+  }
+
+  bool Open(const std::string& fileName, vtkTypeInt64 offset, bool compressed)
+  {
+    this->File.open(fileName.c_str(), std::ios::in | std::ios::binary);
+    this->File.seekg(offset);
+    this->Offset = offset;
+    this->Compressed = compressed;
+    if (compressed)
+      {
+      // Accept both gzip and zlib headers
+      if (inflateInit2(&this->ZStream, 15 + 32) != Z_OK)
+        {
+        return false;
+        }
+      this->ZStreamInitialized = true;
+      this->InputBuffer.resize(1 << 20);
+      }
+    return this->File.good();
+  }
+
+  bool Read(vtkTypeInt64 position, char* buffer, vtkTypeInt64 size)
+  {
+    if (!this->Compressed)
+      {
+      this->File.seekg(this->Offset + position);
+      this->File.read(buffer, size);
+      return this->File.gcount() == size;
+      }
+    if (position < this->Position)
+      {
+      return false;
+      }
+    if (position > this->Position)
+      {
+      std::vector<char> skipped(static_cast<size_t>(std::min<vtkTypeInt64>(position - this->Position, 1 << 20)));
+      while (position > this->Position)
+        {
+        vtkTypeInt64 skipSize = std::min<vtkTypeInt64>(position - this->Position, static_cast<vtkTypeInt64>(skipped.size()));
+        if (!this->Inflate(skipped.data(), skipSize))
+          {
+          return false;
+          }
+        }
+      }
+    return this->Inflate(buffer, size);
+  }
+
+private:
+  bool Inflate(char* buffer, vtkTypeInt64 size)
+  {
+    while (size > 0)
+      {
+      uInt chunkSize = static_cast<uInt>(std::min<vtkTypeInt64>(size, 1 << 30));
+      this->ZStream.next_out = reinterpret_cast<Bytef*>(buffer);
+      this->ZStream.avail_out = chunkSize;
+      while (this->ZStream.avail_out > 0)
+        {
+        if (this->ZStream.avail_in == 0)
+          {
+          this->File.read(this->InputBuffer.data(), this->InputBuffer.size());
+          std::streamsize readSize = this->File.gcount();
+          if (readSize <= 0)
+            {
+            return false;
+            }
+          this->ZStream.next_in = reinterpret_cast<Bytef*>(this->InputBuffer.data());
+          this->ZStream.avail_in = static_cast<uInt>(readSize);
+          }
+        int status = inflate(&this->ZStream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END && this->ZStream.avail_out > 0)
+          {
+          // not enough data in the file
+          return false;
+          }
+        if (status != Z_OK && status != Z_STREAM_END)
+          {
+          return false;
+          }
+        }
+      buffer += chunkSize;
+      size -= chunkSize;
+      this->Position += chunkSize;
+      }
+    return true;
+  }
+
+  std::ifstream File;
+  vtkTypeInt64 Offset{0};
+  bool Compressed{false};
+  z_stream ZStream;
+  bool ZStreamInitialized{false};
+  std::vector<char> InputBuffer;
+  // Position in the decompressed data
+  vtkTypeInt64 Position{0};
+};
+}
+
 //----------------------------------------------------------------------------
 vtkTeemNRRDReader::vtkTeemNRRDReader()
 {
@@ -66,6 +192,10 @@ vtkTeemNRRDReader::vtkTeemNRRDReader()
   this->PointDataType = -1;
   this->DataType = -1;
   this->NumberOfComponents = -1;
+  this->ReadIntoOutput = false;
+  this->DataFileOffset = 0;
+  this->DataFileByteSkip = 0;
+  this->DataFileCompressed = false;
 }
 
 //----------------------------------------------------------------------------
@@ -349,6 +479,8 @@ void vtkTeemNRRDReader::ExecuteInformation()
     return;
     }
   this->CurrentFileName = this->GetFileName();
+  this->ReadIntoOutput = false;
+  this->DataFileName.clear();
 
   nrrdNuke(this->nrrd); // nuke and reallocate to reset the state
   this->nrrd = nrrdNew();
@@ -664,10 +796,118 @@ void vtkTeemNRRDReader::ExecuteInformation()
       }
     }
 
+  this->UpdateDataFileInformation(nio);
+
   this->vtkImageReader2::ExecuteInformation();
   nio = nrrdIoStateNix(nio);
 }
 
+//----------------------------------------------------------------------------
+void vtkTeemNRRDReader::UpdateDataFileInformation(NrrdIoState* nio)
+{
+  this->ReadIntoOutput = false;
+  this->DataFileName.clear();
+
+  // Voxels can be used as they are stored if the range axis (if any) is the
+  // fastest axis and no tensor expansion is needed
+  unsigned int rangeAxisIdx[NRRD_DIM_MAX] = { 0 };
+  unsigned int rangeAxisNum = nrrdRangeAxesGet(this->nrrd, rangeAxisIdx);
+  if (rangeAxisNum > 1 || (rangeAxisNum == 1 && rangeAxisIdx[0] != 0)
+    || nrrdKind3DMaskedSymMatrix == this->nrrd->axis[0].kind
+    || nrrdKind3DSymMatrix == this->nrrd->axis[0].kind)
+    {
+    return;
+    }
+  this->ReadIntoOutput = true;
+
+  // Only a single raw or gzip data file is read without teem
+  if (nio->encoding != nrrdEncodingRaw && nio->encoding != nrrdEncodingGzip)
+    {
+    return;
+    }
+  if (nio->dataFNFormat != nullptr || (nio->dataFNArr && nio->dataFNArr->len > 1))
+    {
+    return;
+    }
+  this->DataFileCompressed = (nio->encoding == nrrdEncodingGzip);
+  if (nio->byteSkip < -1 || (nio->byteSkip == -1 && this->DataFileCompressed))
+    {
+    return;
+    }
+
+  std::string dataFileName = this->GetFileName();
+  bool attachedHeader = true;
+  if (nio->dataFNArr && nio->dataFNArr->len == 1 && nio->dataFN[0] != nullptr)
+    {
+    // Detached header: data file path is relative to the header
+    attachedHeader = false;
+    dataFileName = nio->dataFN[0];
+    if (!vtksys::SystemTools::FileIsFullPath(dataFileName))
+      {
+      std::string headerRelativeFileName = vtksys::SystemTools::CollapseFullPath(
+        dataFileName, vtksys::SystemTools::GetFilenamePath(this->GetFileName()));
+      if (vtksys::SystemTools::FileExists(headerRelativeFileName, true) || !vtksys::SystemTools::FileExists(dataFileName, true))
+        {
+        dataFileName = headerRelativeFileName;
+        }
+      }
+    }
+
+  std::ifstream dataFile(dataFileName.c_str(), std::ios::in | std::ios::binary);
+  if (!dataFile.good())
+    {
+    return;
+    }
+  std::string line;
+  if (attachedHeader)
+    {
+    // Voxels follow the first empty line
+    bool headerEndFound = false;
+    while (std::getline(dataFile, line))
+      {
+      if (line.empty() || line == "\r")
+        {
+        headerEndFound = true;
+        break;
+        }
+      }
+    if (!headerEndFound)
+      {
+      return;
+      }
+    }
+  for (unsigned int lineIndex = 0; lineIndex < nio->lineSkip; ++lineIndex)
+    {
+    if (!std::getline(dataFile, line))
+      {
+      return;
+      }
+    }
+  this->DataFileOffset = static_cast<vtkTypeInt64>(dataFile.tellg());
+  this->DataFileByteSkip = 0;
+  if (this->DataFileCompressed)
+    {
+    // byte skip is applied on the decompressed data
+    this->DataFileByteSkip = nio->byteSkip;
+    }
+  else if (nio->byteSkip == -1)
+    {
+    // Voxels are at the end of the file
+    dataFile.seekg(0, std::ios::end);
+    vtkTypeInt64 dataSize = static_cast<vtkTypeInt64>(nrrdElementNumber(this->nrrd)) * nrrdElementSize(this->nrrd);
+    this->DataFileOffset = static_cast<vtkTypeInt64>(dataFile.tellg()) - dataSize;
+    if (this->DataFileOffset < 0)
+      {
+      return;
+      }
+    }
+  else
+    {
+    this->DataFileOffset += nio->byteSkip;
+    }
+  this->DataFileName = dataFileName;
+}
+
 //----------------------------------------------------------------------------
 vtkImageData *vtkTeemNRRDReader::AllocateOutputData(vtkDataObject *out, vtkInformation* outInfo)
 {
@@ -897,7 +1137,8 @@ int vtkTeemNRRDReader::tenSpaceDirectionReduce(Nrrd *nout, const Nrrd *nin, doub
 // are assumed to be the same as the file extent/order.
 void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInformation* outInfo)
 {
-  if (this->GetOutputInformation(0))
+  // Raw and gzip data files can be read partially, otherwise the whole extent is read
+  if (this->GetOutputInformation(0) && this->DataFileName.empty())
     {
     this->GetOutputInformation(0)->Set(
       vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
@@ -913,6 +1154,75 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
     return;
     }
 
+  vtkDataArray* outputArray = nullptr;
+  switch(this->PointDataType)
+    {
+    case vtkDataSetAttributes::SCALARS:
+      outputArray = imageData->GetPointData()->GetScalars();
+      break;
+    case vtkDataSetAttributes::VECTORS:
+      outputArray = imageData->GetPointData()->GetVectors();
+      break;
+    case vtkDataSetAttributes::NORMALS:
+      outputArray = imageData->GetPointData()->GetNormals();
+      break;
+    case vtkDataSetAttributes::TENSORS:
+      outputArray = imageData->GetPointData()->GetTensors();
+      break;
+    }
+  void *ptr = nullptr;
+  if (outputArray)
+    {
+    outputArray->SetName("NRRDImage");
+    //get pointer
+    ptr = outputArray->GetVoidPointer(0);
+    }
+
+  if (!this->DataFileName.empty() && ptr)
+    {
+    // Read the voxels of the update extent directly into the output
+    if (!this->ReadDataFile(imageData, ptr))
+      {
+      vtkErrorMacro("Read: Error reading data of " << this->GetFileName() << " from " << this->DataFileName);
+      }
+    return;
+    }
+
+  if (this->ReadIntoOutput && ptr)
+    {
+    // Let teem decode into the output: nrrdLoad reuses the data pointer of
+    // the nrrd if its size matches the size of the data in the file.
+    size_t numberOfValues = static_cast<size_t>(outputArray->GetNumberOfValues());
+    if (nrrdWrap_va(this->nrrd, ptr, this->VTKToNrrdPixelType(this->DataType), 1, numberOfValues) != 0)
+      {
+      char *err =  biffGetDone(NRRD); // would be nice to free(err)
+      vtkErrorMacro("Read: Error reading " << this->GetFileName() << ":\n" << err);
+      this->nrrd->data = nullptr;
+      return;
+      }
+    int loadStatus = nrrdLoad(this->nrrd, this->GetFileName(), nullptr);
+    bool dataReadIntoOutput = (this->nrrd->data == ptr);
+    if (dataReadIntoOutput)
+      {
+      // the output owns the data
+      this->nrrd->data = nullptr;
+      }
+    if (loadStatus != 0)
+      {
+      char *err =  biffGetDone(NRRD); // would be nice to free(err)
+      vtkErrorMacro("Read: Error reading " << this->GetFileName() << ":\n" << err);
+      nrrdEmpty(this->nrrd);
+      return;
+      }
+    if (!dataReadIntoOutput)
+      {
+      // file changed since the header was read
+      vtkErrorMacro("Read: Size of data in " << this->GetFileName() << " does not match its header");
+      }
+    nrrdEmpty(this->nrrd);
+    return;
+    }
+
   // Read in the this->nrrd.  Yes, this means that the header is being read
   // twice: once by ExecuteInformation, and once here
   if ( nrrdLoad(this->nrrd, this->GetFileName(), nullptr) != 0 )
@@ -928,28 +1238,6 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
     return;
     }
 
-  void *ptr = nullptr;
-  switch(this->PointDataType)
-    {
-    case vtkDataSetAttributes::SCALARS:
-      imageData->GetPointData()->GetScalars()->SetName("NRRDImage");
-      //get pointer
-      ptr = imageData->GetPointData()->GetScalars()->GetVoidPointer(0);
-      break;
-    case vtkDataSetAttributes::VECTORS:
-      imageData->GetPointData()->GetVectors()->SetName("NRRDImage");
-      //get pointer
-      ptr = imageData->GetPointData()->GetVectors()->GetVoidPointer(0);
-      break;
-    case vtkDataSetAttributes::NORMALS:
-      imageData->GetPointData()->GetNormals()->SetName("NRRDImage");
-      ptr = imageData->GetPointData()->GetNormals()->GetVoidPointer(0);
-      break;
-    case vtkDataSetAttributes::TENSORS:
-      imageData->GetPointData()->GetTensors()->SetName("NRRDImage");
-      ptr = imageData->GetPointData()->GetTensors()->GetVoidPointer(0);
-      break;
-    }
   this->ComputeDataIncrements();
 
   unsigned int rangeAxisIdx[NRRD_DIM_MAX] = { 0 };
@@ -1098,6 +1386,70 @@ void vtkTeemNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInf
   nrrdEmpty(this->nrrd);
 }
 
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDReader::ReadDataFile(vtkImageData* imageData, void* ptr)
+{
+  NrrdDataStream dataStream;
+  if (!dataStream.Open(this->DataFileName, this->DataFileOffset, this->DataFileCompressed))
+    {
+    return false;
+    }
+
+  int* extent = imageData->GetExtent();
+  int* wholeExtent = this->DataExtent;
+  if (extent[0] < wholeExtent[0] || extent[1] > wholeExtent[1]
+    || extent[2] < wholeExtent[2] || extent[3] > wholeExtent[3]
+    || extent[4] < wholeExtent[4] || extent[5] > wholeExtent[5])
+    {
+    vtkErrorMacro("ReadDataFile: requested extent is outside of the image extent");
+    return false;
+    }
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return true;
+    }
+
+  int scalarSize = vtkDataArray::GetDataTypeSize(this->DataType);
+  vtkTypeInt64 voxelSize = static_cast<vtkTypeInt64>(scalarSize) * this->NumberOfComponents;
+  vtkTypeInt64 rowLength = wholeExtent[1] - wholeExtent[0] + 1;
+  vtkTypeInt64 sliceLength = rowLength * (wholeExtent[3] - wholeExtent[2] + 1);
+  vtkTypeInt64 rowSize = (extent[1] - extent[0] + 1) * voxelSize;
+  bool fullRows = (extent[0] == wholeExtent[0] && extent[1] == wholeExtent[1]);
+
+  char* outputPtr = static_cast<char*>(ptr);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    vtkTypeInt64 sliceOffset = this->DataFileByteSkip + (k - wholeExtent[4]) * sliceLength * voxelSize;
+    if (fullRows)
+      {
+      // Rows are contiguous in the file, read them at once
+      vtkTypeInt64 blockSize = rowSize * (extent[3] - extent[2] + 1);
+      if (!dataStream.Read(sliceOffset + (extent[2] - wholeExtent[2]) * rowLength * voxelSize, outputPtr, blockSize))
+        {
+        return false;
+        }
+      outputPtr += blockSize;
+      continue;
+      }
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      vtkTypeInt64 rowOffset = sliceOffset + ((j - wholeExtent[2]) * rowLength + (extent[0] - wholeExtent[0])) * voxelSize;
+      if (!dataStream.Read(rowOffset, outputPtr, rowSize))
+        {
+        return false;
+        }
+      outputPtr += rowSize;
+      }
+    }
+
+  if (this->GetSwapBytes() && scalarSize > 1)
+    {
+    vtkIdType numberOfValues = static_cast<vtkIdType>((outputPtr - static_cast<char*>(ptr)) / scalarSize);
+    vtkByteSwap::SwapVoidRange(ptr, numberOfValues, scalarSize);
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkTeemNRRDReader::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -50,6 +50,12 @@
 ///
 /// Reads Nearly Raw Raster Data files using the nrrdio library as used in ITK
 //
+/// Voxels stored with raw or gzip encoding in a single data file are read
+/// directly into the output image, and only the requested update extent is
+/// read (the gzip stream is decompressed only up to the end of the requested
+/// extent). Other encodings are decoded by teem into the output image, and
+/// always produce the whole extent.
+///
 /// \sa vtkImageReader2
 class VTK_Teem_EXPORT vtkTeemNRRDReader : public vtkMedicalImageReader2
 {
@@ -268,6 +274,25 @@ protected:
 
   int tenSpaceDirectionReduce(Nrrd *nout, const Nrrd *nin, double SD[9]);
 
+  /// Determine where the voxels are stored in the file, from the header
+  /// read by ExecuteInformation. Sets DataFileName if the voxels can be read
+  /// without teem (single raw or gzip data file).
+  void UpdateDataFileInformation(NrrdIoState* nio);
+
+  /// Read the voxels of the output extent from DataFileName into ptr.
+  bool ReadDataFile(vtkImageData* imageData, void* ptr);
+
+  /// True if the voxels need no conversion (axis permutation, tensor
+  /// expansion) after reading, so that they can be read into the output image.
+  bool ReadIntoOutput;
+  /// File that contains the voxels, empty if they must be read by teem.
+  std::string DataFileName;
+  /// Position of the voxels (or of the compressed stream) in DataFileName.
+  vtkTypeInt64 DataFileOffset;
+  /// Number of decompressed bytes to skip before the voxels.
+  vtkTypeInt64 DataFileByteSkip;
+  bool DataFileCompressed;
+
 private:
   vtkTeemNRRDReader(const vtkTeemNRRDReader&) = delete;
   void operator=(const vtkTeemNRRDReader&) = delete;
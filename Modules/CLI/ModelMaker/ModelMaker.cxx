@@ -29,6 +29,9 @@ Version:   $Revision$
 // vtkITK includes
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
 
+// SegmentationCore includes
+#include "vtkMultiLabelSurfaceExtractor.h"
+
 // VTK includes
 #include <vtkVersion.h> // must precede reference to VTK_MAJOR_VERSION
 #include <vtkDebugLeaks.h>
@@ -51,6 +54,7 @@ Version:   $Revision$
 #include <vtkLookupTable.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkReverseSense.h>
@@ -61,12 +65,16 @@ Version:   $Revision$
 #include <vtkThreshold.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkTrivialProducer.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <map>
+
 int main(int argc, char * argv[])
 {
   PARSE_ARGS;
@@ -889,6 +897,53 @@ int main(int argc, char * argv[])
       loopLabels.push_back(Labels[i]);
       }
     }
+
+  // Without joint smoothing, the surfaces of all labels are extracted, decimated and
+  // smoothed (if using the Sinc filter) concurrently, each one from the bounding box of
+  // its label only. Intermediate models are saved after each of these steps, therefore
+  // in that case labels are processed one by one.
+  bool extractSurfacesConcurrently = (JointSmoothing == 0 && !SaveIntermediateModels);
+  bool smoothedBySurfaceExtractor = (extractSurfacesConcurrently && strcmp(FilterType.c_str(), "Sinc") == 0);
+  std::map<int, vtkSmartPointer<vtkPolyData> > extractedSurfaces;
+  if (extractSurfacesConcurrently)
+    {
+    if (smoothedBySurfaceExtractor && Smooth == 1)
+      {
+      std::cerr << "Warning: Smoothing iterations of 1 not allowed for Sinc filter, using 2" << endl;
+      Smooth = 2;
+      }
+    vtkNew<vtkMultiLabelSurfaceExtractor> surfaceExtractor;
+    surfaceExtractor->SetPadBoundary(Pad);
+    surfaceExtractor->ComputeScalarsOff();
+    surfaceExtractor->SetDecimationFactor(Decimate);
+    if (smoothedBySurfaceExtractor)
+      {
+      surfaceExtractor->SetSmoothingIterations(Smooth);
+      surfaceExtractor->SetSmoothingPassBand(0.1);
+      }
+    // only labels that have voxels are extracted
+    vtkMultiLabelSurfaceExtractor::LabelExtentMap labelExtents;
+    vtkMultiLabelSurfaceExtractor::ComputeLabelExtents(image, labelExtents);
+    std::vector<int> extractedLabels;
+    for (::size_t l = 0; l < loopLabels.size(); l++)
+      {
+      if (labelExtents.find(loopLabels[l]) != labelExtents.end())
+        {
+        extractedLabels.push_back(loopLabels[l]);
+        }
+      }
+    std::vector<vtkSmartPointer<vtkPolyData> > surfaces;
+    if (!surfaceExtractor->Extract(image, extractedLabels, surfaces, &labelExtents))
+      {
+      std::cerr << "ERROR while extracting surfaces of the labels" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (::size_t l = 0; l < extractedLabels.size(); l++)
+      {
+      extractedSurfaces[extractedLabels[l]] = surfaces[l];
+      }
+    }
+
   for(::size_t l = 0; l < loopLabels.size(); l++)
     {
     // get the label out of the vector
@@ -1000,7 +1055,11 @@ int main(int argc, char * argv[])
       }
 
     // threshold
-    if (JointSmoothing == 0)
+    if (extractSurfacesConcurrently)
+      {
+      // surface is already extracted
+      }
+    else if (JointSmoothing == 0)
       {
       if (imageThreshold)
         {
@@ -1099,7 +1158,33 @@ int main(int argc, char * argv[])
 
     // if not joint smoothing, may need to skip this label
     int skipLabel = 0;
-    if (JointSmoothing == 0)
+    vtkSmartPointer<vtkTrivialProducer> extractedSurfaceProducer;
+    if (extractSurfacesConcurrently)
+      {
+      // account for the threshold, marching cubes, decimation and smoothing steps
+      currentFilterOffset += (smoothedBySurfaceExtractor ? 4.0 : 3.0);
+      vtkPolyData* extractedSurface = nullptr;
+      std::map<int, vtkSmartPointer<vtkPolyData> >::iterator extractedSurfaceIt = extractedSurfaces.find(i);
+      if (extractedSurfaceIt != extractedSurfaces.end())
+        {
+        extractedSurface = extractedSurfaceIt->second;
+        }
+      if (debug)
+        {
+        std::cout << "\nNumber of polygons = " << (extractedSurface ? extractedSurface->GetNumberOfPolys() : 0) << endl;
+        }
+      if (!extractedSurface || extractedSurface->GetNumberOfPolys() == 0)
+        {
+        std::cout << "Cannot create a model from label " << i
+                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+        skipLabel = 1;
+        std::cout << "...continuing" << endl;
+        continue;
+        }
+      extractedSurfaceProducer = vtkSmartPointer<vtkTrivialProducer>::New();
+      extractedSurfaceProducer->SetOutput(extractedSurface);
+      }
+    else if (JointSmoothing == 0)
       {
       if (mcubes)
         {
@@ -1216,94 +1301,104 @@ int main(int argc, char * argv[])
       }
     if (!skipLabel)
       {
-      // In switch from vtk 4 to vtk 5, vtkDecimate was deprecated from the Patented dir, use vtkDecimatePro
-      // TODO: look at vtkQuadraticDecimation
-      if (decimator != nullptr)
+      // surface of the label before smoothing
+      vtkSmartPointer<vtkAlgorithm> surfaceSource;
+      if (extractSurfacesConcurrently)
         {
-        decimator->SetInputData(nullptr);
-        decimator = nullptr;
-        }
-      decimator = vtkSmartPointer<vtkDecimatePro>::New();
-      std::string            comment6 = "Decimate " + labelName;
-      vtkPluginFilterWatcher watchImageThreshold(decimator,
-                                                 comment6.c_str(),
-                                                 CLPProcessInformation,
-                                                 1.0 / numFilterSteps,
-                                                 currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchImageThreshold.QuietOn();
-        }
-      if (JointSmoothing == 0)
-        {
-        decimator->SetInputConnection(mcubes->GetOutputPort());
+        surfaceSource = extractedSurfaceProducer;
         }
       else
         {
-        decimator->SetInputConnection(geometryFilter->GetOutputPort());
-        }
-      decimator->SetFeatureAngle(60);
-      // decimator->SetMaximumIterations(Decimate);
-      // decimator->SetMaximumSubIterations(0);
-
-      // decimator->PreserveEdgesOn();
-      decimator->SplittingOff();
-      decimator->PreserveTopologyOn();
+        // In switch from vtk 4 to vtk 5, vtkDecimate was deprecated from the Patented dir, use vtkDecimatePro
+        // TODO: look at vtkQuadraticDecimation
+        if (decimator != nullptr)
+          {
+          decimator->SetInputData(nullptr);
+          decimator = nullptr;
+          }
+        decimator = vtkSmartPointer<vtkDecimatePro>::New();
+        std::string            comment6 = "Decimate " + labelName;
+        vtkPluginFilterWatcher watchImageThreshold(decimator,
+                                                   comment6.c_str(),
+                                                   CLPProcessInformation,
+                                                   1.0 / numFilterSteps,
+                                                   currentFilterOffset / numFilterSteps);
+        currentFilterOffset += 1.0;
+        if (debug)
+          {
+          watchImageThreshold.QuietOn();
+          }
+        if (JointSmoothing == 0)
+          {
+          decimator->SetInputConnection(mcubes->GetOutputPort());
+          }
+        else
+          {
+          decimator->SetInputConnection(geometryFilter->GetOutputPort());
+          }
+        decimator->SetFeatureAngle(60);
+        // decimator->SetMaximumIterations(Decimate);
+        // decimator->SetMaximumSubIterations(0);
 
-      decimator->SetMaximumError(1);
-      decimator->SetTargetReduction(Decimate);
-      // decimator->SetInitialError(0.0002);
-      // decimator->SetErrorIncrement(0.002);
-      decimator->ReleaseDataFlagOff();
+        // decimator->PreserveEdgesOn();
+        decimator->SplittingOff();
+        decimator->PreserveTopologyOn();
 
-      try
-        {
-        decimator->Update();
-        }
-      catch(...)
-        {
-        std::cerr << "ERROR decimating model " << i << std::endl;
-        return EXIT_FAILURE;
-        }
-      if (debug)
-        {
-        std::cout << "After decimation, number of polygons = " << (decimator->GetOutput())->GetNumberOfPolys() << endl;
-        }
+        decimator->SetMaximumError(1);
+        decimator->SetTargetReduction(Decimate);
+        // decimator->SetInitialError(0.0002);
+        // decimator->SetErrorIncrement(0.002);
+        decimator->ReleaseDataFlagOff();
 
-      if (SaveIntermediateModels)
-        {
-        writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-        std::string            commentSaveDecimation = "Writing intermediate model after decimation " + labelName;
-        vtkPluginFilterWatcher watchWriter(writer,
-                                           commentSaveDecimation.c_str(),
-                                           CLPProcessInformation,
-                                           1.0 / numFilterSteps,
-                                           currentFilterOffset / numFilterSteps);
-        currentFilterOffset += 1.0;
-        writer->SetInputConnection(decimator->GetOutputPort());
-        writer->SetFileType(2);
-        std::string fileName;
-        if (rootDir != "")
+        try
           {
-          fileName = rootDir + std::string("/") + labelName + std::string("-Decimated.vtk");
+          decimator->Update();
           }
-        else
+        catch(...)
           {
-          fileName = labelName + std::string("-MarchingCubes.vtk");
+          std::cerr << "ERROR decimating model " << i << std::endl;
+          return EXIT_FAILURE;
           }
         if (debug)
           {
-          watchWriter.QuietOn();
-          std::cout << "Writing intermediate file " << fileName.c_str() << std::endl;
+          std::cout << "After decimation, number of polygons = " << (decimator->GetOutput())->GetNumberOfPolys() << endl;
           }
-        writer->SetFileName(fileName.c_str());
-        if (!writer->Write())
+
+        if (SaveIntermediateModels)
           {
-          std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
+          writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+          std::string            commentSaveDecimation = "Writing intermediate model after decimation " + labelName;
+          vtkPluginFilterWatcher watchWriter(writer,
+                                             commentSaveDecimation.c_str(),
+                                             CLPProcessInformation,
+                                             1.0 / numFilterSteps,
+                                             currentFilterOffset / numFilterSteps);
+          currentFilterOffset += 1.0;
+          writer->SetInputConnection(decimator->GetOutputPort());
+          writer->SetFileType(2);
+          std::string fileName;
+          if (rootDir != "")
+            {
+            fileName = rootDir + std::string("/") + labelName + std::string("-Decimated.vtk");
+            }
+          else
+            {
+            fileName = labelName + std::string("-MarchingCubes.vtk");
+            }
+          if (debug)
+            {
+            watchWriter.QuietOn();
+            std::cout << "Writing intermediate file " << fileName.c_str() << std::endl;
+            }
+          writer->SetFileName(fileName.c_str());
+          if (!writer->Write())
+            {
+            std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
+            }
+          writer->SetInputData(nullptr);
+          writer = nullptr;
           }
-        writer->SetInputData(nullptr);
-        writer = nullptr;
+        surfaceSource = decimator;
         }
       if (transformIJKtoRAS == nullptr ||
           transformIJKtoRAS->GetMatrix() == nullptr)
@@ -1337,12 +1432,12 @@ int main(int argc, char * argv[])
           {
           watchReverser.QuietOn();
           }
-        reverser->SetInputConnection(decimator->GetOutputPort());
+        reverser->SetInputConnection(surfaceSource->GetOutputPort());
         reverser->ReverseNormalsOn();
         reverser->ReleaseDataFlagOn();
         }
 
-      if (JointSmoothing == 0)
+      if (JointSmoothing == 0 && !smoothedBySurfaceExtractor)
         {
         if (strcmp(FilterType.c_str(), "Sinc") == 0)
           {
@@ -1376,7 +1471,7 @@ int main(int argc, char * argv[])
             }
           else
             {
-            smootherSinc->SetInputConnection(decimator->GetOutputPort());
+            smootherSinc->SetInputConnection(surfaceSource->GetOutputPort());
             }
           smootherSinc->SetNumberOfIterations(Smooth);
           smootherSinc->FeatureEdgeSmoothingOff();
@@ -1423,7 +1518,7 @@ int main(int argc, char * argv[])
             }
           else
             {
-            smootherPoly->SetInputConnection(decimator->GetOutputPort());
+            smootherPoly->SetInputConnection(surfaceSource->GetOutputPort());
             }
           smootherPoly->SetNumberOfIterations(Smooth);
           smootherPoly->FeatureEdgeSmoothingOff();
@@ -1500,7 +1595,7 @@ int main(int argc, char * argv[])
         {
         watchTransformer.QuietOn();
         }
-      if (JointSmoothing == 0)
+      if (JointSmoothing == 0 && !smoothedBySurfaceExtractor)
         {
         if (strcmp(FilterType.c_str(), "Sinc") == 0)
           {
@@ -1519,7 +1614,7 @@ int main(int argc, char * argv[])
           }
         else
           {
-          transformer->SetInputConnection(decimator->GetOutputPort());
+          transformer->SetInputConnection(surfaceSource->GetOutputPort());
           }
         }
 
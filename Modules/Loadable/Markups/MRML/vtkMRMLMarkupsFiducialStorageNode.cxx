@@ -21,13 +21,17 @@
 #include "vtkMRMLScene.h"
 #include "vtkSlicerVersionConfigure.h"
 
+#include "vtkByteSwap.h"
 #include "vtkObjectFactory.h"
 #include "vtkStringArray.h"
 #include <vtksys/SystemTools.hxx>
 
 #include "itkNumberToString.h"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 // CSV table field indexes
 static const int FIELD_ID = 0;
@@ -213,6 +217,95 @@ protected:
   std::vector<std::string> Fields;
 };
 
+//------------------------------------------------------------------------------
+// Binary markups file (.mrkb)
+//
+// Values are stored in the byte order of the computer that wrote the file, which
+// is indicated by the byte order mark. Each array starts at a multiple of 8 bytes
+// from the beginning of the file, so that columns can be accessed directly
+// if the file is memory-mapped.
+//
+// Header:
+//   char[8]  magic: "MRKBIN\r\n"
+//   uint32   byte order mark: 0x01020304
+//   uint32   format version
+//   int32    coordinate system of positions (0 = RAS, 1 = LPS)
+//   uint32   reserved (0)
+//   uint64   total number of control points
+//   uint64   maximum number of control points in a chunk
+// Chunks of control points, until the total number of control points is reached:
+//   uint64   number of control points in the chunk (n)
+//   double   positions [n][3]
+//   double   orientation matrices [n][9] (same layout as ControlPoint::OrientationMatrix)
+//   uint8    flags [n]: bit 0 = visibility, bit 1 = selected, bit 2 = locked,
+//            bits 3-4 = position status
+//   string columns (ID, label, description, associated node ID), each stored as:
+//     uint64 offsets [n+1]: start of each string in the character data,
+//            the last value is the size of the character data
+//     char   character data
+// Each array is padded with zeros to a multiple of 8 bytes.
+
+namespace
+{
+const char BINARY_FILE_MAGIC[8] = { 'M', 'R', 'K', 'B', 'I', 'N', '\r', '\n' };
+const vtkTypeUInt32 BINARY_FILE_BYTE_ORDER_MARK = 0x01020304;
+const vtkTypeUInt32 BINARY_FILE_VERSION = 1;
+const vtkTypeUInt64 BINARY_FILE_CHUNK_SIZE = 65536;
+const int BINARY_FILE_NUMBER_OF_STRING_COLUMNS = 4;
+// position, orientation, flags, and string offsets
+const vtkTypeUInt64 BINARY_FILE_MINIMUM_POINT_SIZE = 3 * 8 + 9 * 8 + 1 + BINARY_FILE_NUMBER_OF_STRING_COLUMNS * 8;
+
+const vtkTypeUInt8 BINARY_FLAG_VISIBILITY = 0x01;
+const vtkTypeUInt8 BINARY_FLAG_SELECTED = 0x02;
+const vtkTypeUInt8 BINARY_FLAG_LOCKED = 0x04;
+const int BINARY_FLAG_POSITION_STATUS_SHIFT = 3;
+const vtkTypeUInt8 BINARY_FLAG_POSITION_STATUS_MASK = 0x18;
+
+//------------------------------------------------------------------------------
+std::string& GetStringColumn(vtkMRMLMarkupsNode::ControlPoint* controlPoint, int column)
+{
+  switch (column)
+    {
+    case 0: return controlPoint->ID;
+    case 1: return controlPoint->Label;
+    case 2: return controlPoint->Description;
+    default: return controlPoint->AssociatedNodeID;
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkTypeUInt64 GetPaddingSize(vtkTypeUInt64 size)
+{
+  return (8 - size % 8) % 8;
+}
+
+//------------------------------------------------------------------------------
+void WritePadded(std::ostream& of, const void* data, vtkTypeUInt64 size)
+{
+  static const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  if (size > 0)
+    {
+    of.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    of.write(padding, static_cast<std::streamsize>(GetPaddingSize(size)));
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ReadPadded(std::istream& in, void* data, vtkTypeUInt64 size, size_t wordSize, bool swapBytes)
+{
+  if (size > 0)
+    {
+    in.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    in.ignore(static_cast<std::streamsize>(GetPaddingSize(size)));
+    if (swapBytes && wordSize > 1)
+      {
+      vtkByteSwap::SwapVoidRange(data, size / wordSize, wordSize);
+      }
+    }
+  return !in.fail();
+}
+} // end of anonymous namespace
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsFiducialStorageNode);
 
@@ -471,9 +564,14 @@ int vtkMRMLMarkupsFiducialStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  std::string ext = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (ext.compare(".mrkb") == 0)
+    {
+    return this->ReadBinaryDataInternal(markupsNode, fullName);
+    }
+
   // check if it's an annotation csv file
   bool parseAsAnnotationFiducial = false;
-  std::string ext = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
   if (ext.compare(".acsv") == 0)
     {
     parseAsAnnotationFiducial = true;
@@ -683,6 +781,11 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName).compare(".mrkb") == 0)
+    {
+    return this->WriteBinaryDataInternal(markupsNode, fullName);
+    }
+
   // open the file for writing
   fstream of;
 
@@ -724,15 +827,286 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNode::ReadBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName)
+{
+  fstream in;
+  in.open(fullName.c_str(), fstream::in | fstream::binary);
+  if (!in.is_open())
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: unable to open file " << fullName.c_str() << " for reading");
+    return 0;
+    }
+
+  // header
+  char magic[sizeof(BINARY_FILE_MAGIC)] = { 0 };
+  vtkTypeUInt32 byteOrderMark = 0;
+  vtkTypeUInt32 version = 0;
+  vtkTypeInt32 coordinateSystem = 0;
+  vtkTypeUInt32 reserved = 0;
+  vtkTypeUInt64 numberOfControlPoints = 0;
+  vtkTypeUInt64 chunkSize = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&byteOrderMark), sizeof(byteOrderMark));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&coordinateSystem), sizeof(coordinateSystem));
+  in.read(reinterpret_cast<char*>(&reserved), sizeof(reserved));
+  in.read(reinterpret_cast<char*>(&numberOfControlPoints), sizeof(numberOfControlPoints));
+  in.read(reinterpret_cast<char*>(&chunkSize), sizeof(chunkSize));
+  if (in.fail() || memcmp(magic, BINARY_FILE_MAGIC, sizeof(magic)) != 0)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: " << fullName.c_str() << " is not a binary markups file");
+    return 0;
+    }
+  bool swapBytes = false;
+  if (byteOrderMark != BINARY_FILE_BYTE_ORDER_MARK)
+    {
+    // file was written on a computer with different byte order
+    swapBytes = true;
+    vtkByteSwap::SwapVoidRange(&byteOrderMark, 1, sizeof(byteOrderMark));
+    vtkByteSwap::SwapVoidRange(&version, 1, sizeof(version));
+    vtkByteSwap::SwapVoidRange(&coordinateSystem, 1, sizeof(coordinateSystem));
+    vtkByteSwap::SwapVoidRange(&numberOfControlPoints, 1, sizeof(numberOfControlPoints));
+    vtkByteSwap::SwapVoidRange(&chunkSize, 1, sizeof(chunkSize));
+    }
+  if (byteOrderMark != BINARY_FILE_BYTE_ORDER_MARK || version == 0 || version > BINARY_FILE_VERSION)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: unsupported binary markups file version in " << fullName.c_str());
+    return 0;
+    }
+  if (coordinateSystem != vtkMRMLMarkupsStorageNode::RAS && coordinateSystem != vtkMRMLMarkupsStorageNode::LPS)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: invalid coordinate system " << coordinateSystem << " in " << fullName.c_str());
+    return 0;
+    }
+  // prevent allocating huge buffers if the header is corrupted
+  vtkTypeUInt64 fileSize = static_cast<vtkTypeUInt64>(vtksys::SystemTools::FileLength(fullName));
+  if (numberOfControlPoints > static_cast<vtkTypeUInt64>(VTK_INT_MAX)
+    || numberOfControlPoints * BINARY_FILE_MINIMUM_POINT_SIZE > fileSize)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: invalid number of control points (" << numberOfControlPoints
+      << ") in " << fullName.c_str());
+    return 0;
+    }
+  this->SetCoordinateSystem(coordinateSystem);
+  bool lps = (coordinateSystem == vtkMRMLMarkupsStorageNode::LPS);
+
+  int wasModifying = markupsNode->StartModify();
+  markupsNode->RemoveAllControlPoints();
+
+  // Read the file one chunk at a time
+  vtkMRMLMarkupsNode::ControlPointsListType controlPoints;
+  controlPoints.reserve(static_cast<size_t>(numberOfControlPoints));
+  std::vector<double> positions;
+  std::vector<double> orientations;
+  std::vector<vtkTypeUInt8> flags;
+  std::vector<vtkTypeUInt64> offsets;
+  std::vector<char> characters;
+  bool success = true;
+  while (success && controlPoints.size() < numberOfControlPoints)
+    {
+    vtkTypeUInt64 numberOfControlPointsInChunk = 0;
+    success = ReadPadded(in, &numberOfControlPointsInChunk, sizeof(numberOfControlPointsInChunk),
+      sizeof(numberOfControlPointsInChunk), swapBytes);
+    if (!success || numberOfControlPointsInChunk == 0
+      || numberOfControlPointsInChunk > numberOfControlPoints - controlPoints.size())
+      {
+      vtkErrorMacro("ReadBinaryDataInternal: invalid chunk of control points in " << fullName.c_str());
+      success = false;
+      break;
+      }
+    size_t n = static_cast<size_t>(numberOfControlPointsInChunk);
+    positions.resize(n * 3);
+    orientations.resize(n * 9);
+    flags.resize(n);
+    success = ReadPadded(in, &positions[0], n * 3 * sizeof(double), sizeof(double), swapBytes)
+      && ReadPadded(in, &orientations[0], n * 9 * sizeof(double), sizeof(double), swapBytes)
+      && ReadPadded(in, &flags[0], n, 1, swapBytes);
+    if (!success)
+      {
+      vtkErrorMacro("ReadBinaryDataInternal: failed to read control points from " << fullName.c_str());
+      break;
+      }
+
+    size_t firstIndex = controlPoints.size();
+    for (size_t i = 0; i < n; i++)
+      {
+      vtkMRMLMarkupsNode::ControlPoint* controlPoint = new vtkMRMLMarkupsNode::ControlPoint;
+      controlPoint->Position[0] = lps ? -positions[i * 3] : positions[i * 3];
+      controlPoint->Position[1] = lps ? -positions[i * 3 + 1] : positions[i * 3 + 1];
+      controlPoint->Position[2] = positions[i * 3 + 2];
+      std::copy(&orientations[i * 9], &orientations[i * 9] + 9, controlPoint->OrientationMatrix);
+      controlPoint->Visibility = (flags[i] & BINARY_FLAG_VISIBILITY) != 0;
+      controlPoint->Selected = (flags[i] & BINARY_FLAG_SELECTED) != 0;
+      controlPoint->Locked = (flags[i] & BINARY_FLAG_LOCKED) != 0;
+      controlPoint->PositionStatus = (flags[i] & BINARY_FLAG_POSITION_STATUS_MASK) >> BINARY_FLAG_POSITION_STATUS_SHIFT;
+      controlPoints.push_back(controlPoint);
+      }
+
+    for (int column = 0; success && column < BINARY_FILE_NUMBER_OF_STRING_COLUMNS; column++)
+      {
+      offsets.resize(n + 1);
+      success = ReadPadded(in, &offsets[0], (n + 1) * sizeof(vtkTypeUInt64), sizeof(vtkTypeUInt64), swapBytes);
+      vtkTypeUInt64 numberOfCharacters = offsets[n];
+      success = success && offsets[0] == 0 && numberOfCharacters <= fileSize
+        && std::is_sorted(offsets.begin(), offsets.end());
+      if (success)
+        {
+        characters.resize(static_cast<size_t>(numberOfCharacters));
+        success = ReadPadded(in, characters.empty() ? nullptr : &characters[0], numberOfCharacters, 1, swapBytes);
+        }
+      if (!success)
+        {
+        vtkErrorMacro("ReadBinaryDataInternal: failed to read control point strings from " << fullName.c_str());
+        break;
+        }
+      for (size_t i = 0; i < n; i++)
+        {
+        GetStringColumn(controlPoints[firstIndex + i], column).assign(
+          characters.begin() + static_cast<size_t>(offsets[i]), characters.begin() + static_cast<size_t>(offsets[i + 1]));
+        }
+      }
+    }
+  in.close();
+
+  if (success && !controlPoints.empty())
+    {
+    // AddControlPoints generates labels for control points that have empty label,
+    // but empty labels are kept when reading (same as in fcsv files)
+    std::vector<size_t> emptyLabelIndices;
+    for (size_t i = 0; i < controlPoints.size(); i++)
+      {
+      if (controlPoints[i]->Label.empty())
+        {
+        emptyLabelIndices.push_back(i);
+        }
+      }
+    success = (markupsNode->AddControlPoints(controlPoints) >= 0);
+    if (success)
+      {
+      for (size_t i : emptyLabelIndices)
+        {
+        controlPoints[i]->Label.clear();
+        }
+      // make sure newly generated IDs do not clash with IDs of the loaded control points
+      markupsNode->LastUsedControlPointNumber = std::max(markupsNode->LastUsedControlPointNumber,
+        markupsNode->GetNumberOfControlPoints());
+      }
+    }
+  if (!success)
+    {
+    for (vtkMRMLMarkupsNode::ControlPoint* controlPoint : controlPoints)
+      {
+      delete controlPoint;
+      }
+    }
+
+  markupsNode->EndModify(wasModifying);
+  return success ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNode::WriteBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName)
+{
+  if (this->GetCoordinateSystem() != vtkMRMLMarkupsStorageNode::RAS
+    && this->GetCoordinateSystem() != vtkMRMLMarkupsStorageNode::LPS)
+    {
+    vtkErrorMacro("WriteBinaryDataInternal: invalid coordinate system index " << this->GetCoordinateSystem());
+    return 0;
+    }
+  bool lps = (this->GetCoordinateSystem() == vtkMRMLMarkupsStorageNode::LPS);
+
+  fstream of;
+  of.open(fullName.c_str(), fstream::out | fstream::binary | fstream::trunc);
+  if (!of.is_open())
+    {
+    vtkErrorMacro("WriteBinaryDataInternal: unable to open file " << fullName.c_str() << " for writing");
+    return 0;
+    }
+
+  // header
+  const vtkMRMLMarkupsNode::ControlPointsListType& controlPoints = *markupsNode->GetControlPoints();
+  vtkTypeUInt32 byteOrderMark = BINARY_FILE_BYTE_ORDER_MARK;
+  vtkTypeUInt32 version = BINARY_FILE_VERSION;
+  vtkTypeInt32 coordinateSystem = this->GetCoordinateSystem();
+  vtkTypeUInt32 reserved = 0;
+  vtkTypeUInt64 numberOfControlPoints = controlPoints.size();
+  vtkTypeUInt64 chunkSize = BINARY_FILE_CHUNK_SIZE;
+  of.write(BINARY_FILE_MAGIC, sizeof(BINARY_FILE_MAGIC));
+  of.write(reinterpret_cast<const char*>(&byteOrderMark), sizeof(byteOrderMark));
+  of.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  of.write(reinterpret_cast<const char*>(&coordinateSystem), sizeof(coordinateSystem));
+  of.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+  of.write(reinterpret_cast<const char*>(&numberOfControlPoints), sizeof(numberOfControlPoints));
+  of.write(reinterpret_cast<const char*>(&chunkSize), sizeof(chunkSize));
+
+  // Write the control points one chunk at a time, column by column
+  std::vector<double> positions;
+  std::vector<double> orientations;
+  std::vector<vtkTypeUInt8> flags;
+  std::vector<vtkTypeUInt64> offsets;
+  std::string characters;
+  for (size_t firstIndex = 0; firstIndex < controlPoints.size() && of.good(); firstIndex += BINARY_FILE_CHUNK_SIZE)
+    {
+    size_t n = std::min(static_cast<size_t>(BINARY_FILE_CHUNK_SIZE), controlPoints.size() - firstIndex);
+    positions.resize(n * 3);
+    orientations.resize(n * 9);
+    flags.resize(n);
+    for (size_t i = 0; i < n; i++)
+      {
+      vtkMRMLMarkupsNode::ControlPoint* controlPoint = controlPoints[firstIndex + i];
+      positions[i * 3] = lps ? -controlPoint->Position[0] : controlPoint->Position[0];
+      positions[i * 3 + 1] = lps ? -controlPoint->Position[1] : controlPoint->Position[1];
+      positions[i * 3 + 2] = controlPoint->Position[2];
+      std::copy(controlPoint->OrientationMatrix, controlPoint->OrientationMatrix + 9, &orientations[i * 9]);
+      flags[i] = static_cast<vtkTypeUInt8>(
+        (controlPoint->Visibility ? BINARY_FLAG_VISIBILITY : 0)
+        | (controlPoint->Selected ? BINARY_FLAG_SELECTED : 0)
+        | (controlPoint->Locked ? BINARY_FLAG_LOCKED : 0)
+        | ((controlPoint->PositionStatus << BINARY_FLAG_POSITION_STATUS_SHIFT) & BINARY_FLAG_POSITION_STATUS_MASK));
+      }
+    vtkTypeUInt64 numberOfControlPointsInChunk = n;
+    WritePadded(of, &numberOfControlPointsInChunk, sizeof(numberOfControlPointsInChunk));
+    WritePadded(of, &positions[0], n * 3 * sizeof(double));
+    WritePadded(of, &orientations[0], n * 9 * sizeof(double));
+    WritePadded(of, &flags[0], n);
+
+    for (int column = 0; column < BINARY_FILE_NUMBER_OF_STRING_COLUMNS; column++)
+      {
+      offsets.resize(n + 1);
+      characters.clear();
+      for (size_t i = 0; i < n; i++)
+        {
+        offsets[i] = characters.size();
+        characters += GetStringColumn(controlPoints[firstIndex + i], column);
+        }
+      offsets[n] = characters.size();
+      WritePadded(of, &offsets[0], (n + 1) * sizeof(vtkTypeUInt64));
+      WritePadded(of, characters.data(), characters.size());
+      }
+    }
+
+  bool success = of.good();
+  of.close();
+  if (!success)
+    {
+    vtkErrorMacro("WriteBinaryDataInternal: failed to write file " << fullName.c_str());
+    return 0;
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialStorageNode::InitializeSupportedReadFileTypes()
 {
   this->SupportedReadFileTypes->InsertNextValue("Markups Fiducial CSV (.fcsv)");
   this->SupportedReadFileTypes->InsertNextValue("Annotation Fiducial CSV (.acsv)");
+  this->SupportedReadFileTypes->InsertNextValue("Markups Binary (.mrkb)");
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialStorageNode::InitializeSupportedWriteFileTypes()
 {
   this->SupportedWriteFileTypes->InsertNextValue("Markups Fiducial CSV (.fcsv)");
+  this->SupportedWriteFileTypes->InsertNextValue("Markups Binary (.mrkb)");
 }
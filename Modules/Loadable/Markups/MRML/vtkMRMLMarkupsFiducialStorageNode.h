@@ -21,6 +21,11 @@
 ///
 /// vtkMRMLMarkupsFiducialStorageNode nodes describe the markups storage
 /// node that allows to read/write fiducial point data from/to file.
+///
+/// Control points are stored in a comma-separated text file (.fcsv) by default.
+/// Large point lists can be stored in a binary file (.mrkb) instead, which stores
+/// the same fields column by column, in chunks of points, so that it can be
+/// written and read without formatting or parsing numbers.
 
 #ifndef __vtkMRMLMarkupsFiducialStorageNode_h
 #define __vtkMRMLMarkupsFiducialStorageNode_h
@@ -91,6 +96,11 @@ protected:
   /// necessary, same with the description
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Read/write control points from/to a binary markups file (.mrkb).
+  /// Returns 1 on success, 0 on failure.
+  int ReadBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName);
+  int WriteBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName);
+
   std::string FieldDelimiterCharacters;
 };
 
@@ -29,6 +29,9 @@
 // Slicer MRML includes
 #include "vtkMRMLScene.h"
 
+// vtkAddon includes
+#include "vtkBatchPointTransformer.h"
+
 // VTK includes
 #include <vtkAbstractTransform.h>
 #include <vtkBitArray.h>
@@ -52,6 +55,33 @@
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsNode);
 
+namespace
+{
+//----------------------------------------------------------------------------
+void TransformPoints(vtkAbstractTransform* transform, vtkPoints* inPoints, vtkPoints* outPoints)
+{
+  if (transform)
+    {
+    vtkNew<vtkBatchPointTransformer> transformer;
+    transformer->SetTransform(transform);
+    transformer->TransformPoints(inPoints, outPoints);
+    return;
+    }
+  // not transformed
+  if (inPoints == outPoints)
+    {
+    return;
+    }
+  vtkIdType numberOfPoints = inPoints->GetNumberOfPoints();
+  outPoints->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    outPoints->SetPoint(pointIndex, inPoints->GetPoint(pointIndex));
+    }
+  outPoints->Modified();
+}
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkMRMLMarkupsNode::vtkMRMLMarkupsNode()
 {
@@ -64,6 +94,7 @@ vtkMRMLMarkupsNode::vtkMRMLMarkupsNode()
   this->MaximumNumberOfControlPoints = 0;
   this->MarkupLabelFormat = std::string("%N-%d");
   this->LastUsedControlPointNumber = 0;
+  this->ControlPointIndexByIDValid = true;
   this->CenterPos.Set(0,0,0);
 
   this->CurveInputPoly = vtkSmartPointer<vtkPolyData>::New();
@@ -205,12 +236,21 @@ void vtkMRMLMarkupsNode::Copy(vtkMRMLNode *anode)
 
   this->RemoveAllControlPoints();
   int numMarkups = node->GetNumberOfControlPoints();
+  ControlPointsListType controlPointCopies;
+  controlPointCopies.reserve(numMarkups);
   for (int n = 0; n < numMarkups; n++)
     {
     ControlPoint* controlPoint = node->GetNthControlPoint(n);
     ControlPoint* controlPointCopy = new ControlPoint;
     (*controlPointCopy) = (*controlPoint);
-    this->AddControlPoint(controlPointCopy);
+    controlPointCopies.push_back(controlPointCopy);
+    }
+  if (numMarkups > 0 && this->AddControlPoints(controlPointCopies) < 0)
+    {
+    for (ControlPoint* controlPointCopy : controlPointCopies)
+      {
+      delete controlPointCopy;
+      }
     }
 
   this->EndModify(disabledModify);
@@ -333,6 +373,8 @@ void vtkMRMLMarkupsNode::RemoveAllControlPoints()
     }
 
   this->ControlPoints.clear();
+  this->ControlPointIndexByID.clear();
+  this->ControlPointIndexByIDValid = true;
 
   this->CurveInputPoly->GetPoints()->Reset();
   this->CurveInputPoly->GetPoints()->Squeeze();
@@ -491,6 +533,12 @@ int vtkMRMLMarkupsNode::AddControlPoint(ControlPoint *controlPoint)
     }
 
   this->ControlPoints.push_back(controlPoint);
+  int controlPointIndex = this->GetNumberOfControlPoints() - 1;
+  if (this->ControlPointIndexByIDValid)
+    {
+    // if the ID is already used then the index of the first control point is kept
+    this->ControlPointIndexByID.emplace(controlPoint->ID, controlPointIndex);
+    }
 
   // Add point to CurveInputPoly
   // TODO: set point mask based on PositionStatus
@@ -498,7 +546,6 @@ int vtkMRMLMarkupsNode::AddControlPoint(ControlPoint *controlPoint)
   this->CurveInputPoly->GetPoints()->Modified();
   this->UpdateCurvePolyFromCurveInputPoly();
 
-  int controlPointIndex = this->GetNumberOfControlPoints() - 1;
   this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointAddedEvent,  static_cast<void*>(&controlPointIndex));
   this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent, static_cast<void*>(&controlPointIndex));
   if (controlPoint->PositionStatus == vtkMRMLMarkupsNode::PositionDefined)
@@ -509,6 +556,114 @@ int vtkMRMLMarkupsNode::AddControlPoint(ControlPoint *controlPoint)
   return controlPointIndex;
 }
 
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPoints(const ControlPointsListType& controlPoints)
+{
+  if (controlPoints.empty())
+    {
+    return -1;
+    }
+  if (this->MaximumNumberOfControlPoints != 0 &&
+      this->GetNumberOfControlPoints() + static_cast<int>(controlPoints.size()) > this->MaximumNumberOfControlPoints)
+    {
+    vtkErrorMacro("AddControlPoints: number of points major than maximum number of control points allowed.");
+    return -1;
+    }
+
+  vtkPoints* curveInputPoints = this->CurveInputPoly->GetPoints();
+  bool positionDefined = false;
+  for (ControlPoint* controlPoint : controlPoints)
+    {
+    // generate a unique id based on list policy
+    if (controlPoint->ID.empty())
+      {
+      controlPoint->ID = this->GenerateUniqueControlPointID();
+      }
+    if (controlPoint->Label.empty())
+      {
+      controlPoint->Label = this->GenerateControlPointLabel(this->LastUsedControlPointNumber);
+      }
+    this->ControlPoints.push_back(controlPoint);
+    if (this->ControlPointIndexByIDValid)
+      {
+      this->ControlPointIndexByID.emplace(controlPoint->ID, this->GetNumberOfControlPoints() - 1);
+      }
+    // TODO: set point mask based on PositionStatus
+    curveInputPoints->InsertNextPoint(controlPoint->Position);
+    if (controlPoint->PositionStatus == vtkMRMLMarkupsNode::PositionDefined)
+      {
+      positionDefined = true;
+      }
+    }
+  curveInputPoints->Modified();
+  this->UpdateCurvePolyFromCurveInputPoly();
+
+  // nullptr call data indicates that multiple points are added
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointAddedEvent);
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent);
+  if (positionDefined)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionDefinedEvent);
+    }
+  this->UpdateMeasurements();
+  return this->GetNumberOfControlPoints() - 1;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPoints(vtkPoints* points, vtkStringArray* labels/*=nullptr*/)
+{
+  if (!points)
+    {
+    vtkErrorMacro("AddControlPoints failed: invalid points");
+    return -1;
+    }
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if (labels && labels->GetNumberOfValues() != numberOfPoints)
+    {
+    vtkErrorMacro("AddControlPoints failed: number of labels (" << labels->GetNumberOfValues()
+      << ") does not match the number of points (" << numberOfPoints << ")");
+    return -1;
+    }
+
+  ControlPointsListType controlPoints;
+  controlPoints.reserve(numberOfPoints);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    ControlPoint *controlPoint = new ControlPoint;
+    points->GetPoint(pointIndex, controlPoint->Position);
+    controlPoint->PositionStatus = PositionDefined;
+    if (labels)
+      {
+      controlPoint->Label = labels->GetValue(pointIndex);
+      }
+    controlPoints.push_back(controlPoint);
+    }
+
+  int controlPointIndex = this->AddControlPoints(controlPoints);
+  if (controlPointIndex < 0)
+    {
+    for (ControlPoint* controlPoint : controlPoints)
+      {
+      delete controlPoint;
+      }
+    }
+  return controlPointIndex;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPointsWorld(vtkPoints* points, vtkStringArray* labels/*=nullptr*/)
+{
+  if (!points)
+    {
+    vtkErrorMacro("AddControlPointsWorld failed: invalid points");
+    return -1;
+    }
+  vtkNew<vtkPoints> pointsLocal;
+  pointsLocal->SetDataTypeToDouble();
+  this->TransformPointsFromWorld(points, pointsLocal);
+  return this->AddControlPoints(pointsLocal, labels);
+}
+
 //-----------------------------------------------------------
 int vtkMRMLMarkupsNode::AddNControlPoints(int n, std::string label /*=std::string()*/, vtkVector3d* point /*=nullptr*/)
 {
@@ -638,6 +793,20 @@ void vtkMRMLMarkupsNode::RemoveNthControlPoint(int pointIndex)
 
   bool positionWasDefined = (this->ControlPoints[static_cast<unsigned int>(pointIndex)]->PositionStatus == vtkMRMLMarkupsNode::PositionDefined);
 
+  if (this->ControlPointIndexByIDValid && pointIndex == this->GetNumberOfControlPoints() - 1)
+    {
+    // removing the last point does not change the index of other control points
+    std::unordered_map<std::string, int>::iterator it = this->ControlPointIndexByID.find(controlPoint->ID);
+    if (it != this->ControlPointIndexByID.end() && it->second == pointIndex)
+      {
+      this->ControlPointIndexByID.erase(it);
+      }
+    }
+  else
+    {
+    this->ControlPointIndexByIDValid = false;
+    }
+
   delete this->ControlPoints[static_cast<unsigned int> (pointIndex)];
   this->ControlPoints.erase(this->ControlPoints.begin() + pointIndex);
 
@@ -681,6 +850,7 @@ bool vtkMRMLMarkupsNode::InsertControlPoint(ControlPoint *controlPoint, int targ
 
   std::vector < ControlPoint* >::iterator pos = this->ControlPoints.begin() + destIndex;
   std::vector < ControlPoint* >::iterator result = this->ControlPoints.insert(pos, controlPoint);
+  this->ControlPointIndexByIDValid = false;
 
   this->UpdateCurvePolyFromControlPoints();
 
@@ -797,6 +967,7 @@ void vtkMRMLMarkupsNode::SwapControlPoints(int m1, int m2)
   *controlPoint1 = *controlPoint2;
   // and copy the backup of the first one into the second
   *controlPoint2 = controlPoint1Backup;
+  this->ControlPointIndexByIDValid = false;
 
   this->UpdateCurvePolyFromControlPoints();
 
@@ -1167,16 +1338,34 @@ int vtkMRMLMarkupsNode::GetNthControlPointIndexByID(const char* controlPointID)
     {
     return -1;
     }
+  this->UpdateControlPointIndexByID();
+  std::unordered_map<std::string, int>::iterator it = this->ControlPointIndexByID.find(controlPointID);
+  if (it == this->ControlPointIndexByID.end())
+    {
+    return -1;
+    }
+  return it->second;
+}
+
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::UpdateControlPointIndexByID()
+{
+  if (this->ControlPointIndexByIDValid)
+    {
+    return;
+    }
+  this->ControlPointIndexByID.clear();
+  this->ControlPointIndexByID.reserve(this->ControlPoints.size());
   for (int controlPointIndex = 0; controlPointIndex < this->GetNumberOfControlPoints(); controlPointIndex++)
     {
-    ControlPoint *compareControlPoint = this->ControlPoints[controlPointIndex];
-    if (compareControlPoint &&
-        strcmp(compareControlPoint->ID.c_str(), controlPointID) == 0)
+    ControlPoint *controlPoint = this->ControlPoints[controlPointIndex];
+    if (controlPoint)
       {
-      return controlPointIndex;
+      // if the same ID is used by multiple control points then the first one is found
+      this->ControlPointIndexByID.emplace(controlPoint->ID, controlPointIndex);
       }
     }
-  return -1;
+  this->ControlPointIndexByIDValid = true;
 }
 
 //-------------------------------------------------------------------------
@@ -1208,6 +1397,7 @@ void vtkMRMLMarkupsNode::SetNthControlPointID(int n, std::string id)
     return;
     }
   controlPoint->ID = id;
+  this->ControlPointIndexByIDValid = false;
 }
 
 //---------------------------------------------------------------------------
@@ -1855,25 +2045,95 @@ void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
     return;
     }
   int wasModified = this->StartModify();
-  vtkIdType numberOfPoints = points->GetNumberOfPoints();
-  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+
+  vtkNew<vtkPoints> pointsLocal;
+  pointsLocal->SetDataTypeToDouble();
+  this->TransformPointsFromWorld(points, pointsLocal);
+  int numberOfPoints = static_cast<int>(pointsLocal->GetNumberOfPoints());
+
+  // Remove extra control points
+  int numberOfControlPoints = this->GetNumberOfControlPoints();
+  if (numberOfControlPoints > numberOfPoints)
     {
-    double* posWorld = points->GetPoint(pointIndex);
-    if (pointIndex < this->GetNumberOfControlPoints())
+    bool positionWasDefined = false;
+    for (int pointIndex = numberOfControlPoints - 1; pointIndex >= numberOfPoints; pointIndex--)
       {
-      // point already exists, just update it
-      this->SetNthControlPointPositionWorldFromArray(pointIndex, posWorld);
+      ControlPoint* controlPoint = this->ControlPoints[pointIndex];
+      // Allow reusing last control point number (same as in RemoveNthControlPoint)
+      if (this->GenerateControlPointLabel(this->LastUsedControlPointNumber) == controlPoint->Label)
+        {
+        this->LastUsedControlPointNumber--;
+        }
+      if (controlPoint->PositionStatus == vtkMRMLMarkupsNode::PositionDefined)
+        {
+        positionWasDefined = true;
+        }
+      delete controlPoint;
       }
-    else
+    this->ControlPoints.resize(numberOfPoints);
+    this->ControlPointIndexByIDValid = false;
+    if (positionWasDefined)
+      {
+      this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionUndefinedEvent);
+      }
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointRemovedEvent);
+    numberOfControlPoints = numberOfPoints;
+    }
+
+  // Update existing control points
+  vtkPoints* curveInputPoints = this->CurveInputPoly->GetPoints();
+  curveInputPoints->SetNumberOfPoints(numberOfControlPoints);
+  bool positionDefined = false;
+  for (int pointIndex = 0; pointIndex < numberOfControlPoints; pointIndex++)
+    {
+    ControlPoint* controlPoint = this->ControlPoints[pointIndex];
+    pointsLocal->GetPoint(pointIndex, controlPoint->Position);
+    if (controlPoint->PositionStatus != vtkMRMLMarkupsNode::PositionDefined)
+      {
+      controlPoint->PositionStatus = vtkMRMLMarkupsNode::PositionDefined;
+      positionDefined = true;
+      }
+    curveInputPoints->SetPoint(pointIndex, controlPoint->Position);
+    }
+  curveInputPoints->Modified();
+  if (numberOfControlPoints > 0)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent);
+    }
+  if (positionDefined)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionDefinedEvent);
+    }
+
+  // Add new control points
+  if (numberOfPoints > numberOfControlPoints)
+    {
+    ControlPointsListType controlPoints;
+    controlPoints.reserve(numberOfPoints - numberOfControlPoints);
+    for (int pointIndex = numberOfControlPoints; pointIndex < numberOfPoints; pointIndex++)
+      {
+      ControlPoint *controlPoint = new ControlPoint;
+      pointsLocal->GetPoint(pointIndex, controlPoint->Position);
+      controlPoint->PositionStatus = PositionDefined;
+      controlPoints.push_back(controlPoint);
+      }
+    // curve and measurements are updated when the points are added
+    if (this->AddControlPoints(controlPoints) < 0)
       {
-      // need to add a new point
-      vtkMRMLMarkupsNode::AddControlPointWorld(vtkVector3d(posWorld));
+      for (ControlPoint* controlPoint : controlPoints)
+        {
+        delete controlPoint;
+        }
+      this->UpdateCurvePolyFromCurveInputPoly();
+      this->UpdateMeasurements();
       }
     }
-  while (this->GetNumberOfControlPoints() > numberOfPoints)
+  else
     {
-    this->RemoveNthControlPoint(this->GetNumberOfControlPoints() - 1);
+    this->UpdateCurvePolyFromCurveInputPoly();
+    this->UpdateMeasurements();
     }
+
   this->EndModify(wasModified);
 }
 
@@ -1885,13 +2145,40 @@ void vtkMRMLMarkupsNode::GetControlPointPositionsWorld(vtkPoints* points)
     return;
     }
   int numberOfControlPoints = this->GetNumberOfControlPoints();
-  points->SetNumberOfPoints(numberOfControlPoints);
-  double posWorld[3] = { 0.0 };
+  vtkNew<vtkPoints> pointsLocal;
+  pointsLocal->SetDataTypeToDouble();
+  pointsLocal->SetNumberOfPoints(numberOfControlPoints);
   for (int controlPointIndex = 0; controlPointIndex < numberOfControlPoints; controlPointIndex++)
     {
-    this->GetNthControlPointPositionWorld(controlPointIndex, posWorld);
-    points->SetPoint(controlPointIndex, posWorld);
+    pointsLocal->SetPoint(controlPointIndex, this->ControlPoints[controlPointIndex]->Position);
+    }
+  this->TransformPointsToWorld(pointsLocal, points);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::TransformPointsToWorld(vtkPoints* pointsLocal, vtkPoints* pointsWorld)
+{
+  vtkSmartPointer<vtkGeneralTransform> transformToWorld;
+  vtkMRMLTransformNode* transformNode = this->GetParentTransformNode();
+  if (transformNode)
+    {
+    transformToWorld = vtkSmartPointer<vtkGeneralTransform>::New();
+    transformNode->GetTransformToWorld(transformToWorld);
+    }
+  TransformPoints(transformToWorld, pointsLocal, pointsWorld);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::TransformPointsFromWorld(vtkPoints* pointsWorld, vtkPoints* pointsLocal)
+{
+  vtkSmartPointer<vtkGeneralTransform> transformFromWorld;
+  vtkMRMLTransformNode* transformNode = this->GetParentTransformNode();
+  if (transformNode)
+    {
+    transformFromWorld = vtkSmartPointer<vtkGeneralTransform>::New();
+    transformNode->GetTransformFromWorld(transformFromWorld);
     }
+  TransformPoints(transformFromWorld, pointsWorld, pointsLocal);
 }
 
 //---------------------------------------------------------------------------
@@ -31,6 +31,9 @@
 #include <vtkSmartPointer.h>
 #include <vtkVector.h>
 
+// STD includes
+#include <unordered_map>
+
 class vtkFrenetSerretFrame;
 class vtkMRMLUnitNode;
 
@@ -274,6 +277,25 @@ public:
   /// of new controlPoint, -1 on failure.
   /// Markups node takes over ownership of the pointer (markups node will delete it).
   int AddControlPoint(ControlPoint *controlPoint);
+  /// Add controlPoints to the end of the list.
+  /// Curve and measurements are updated and events are invoked only once
+  /// (with nullptr call data).
+  /// Return index of the last added control point, -1 on failure.
+  /// Markups node takes over ownership of the pointers (markups node will delete them)
+  /// if the control points are successfully added.
+  int AddControlPoints(const ControlPointsListType& controlPoints);
+  /// Add a control point for each point of the list (in local coordinate system).
+  /// If labels is specified then it must contain one label for each point,
+  /// empty labels are replaced by automatically generated labels.
+  /// Curve and measurements are updated only once and PointAddedEvent,
+  /// PointModifiedEvent, and PointPositionDefinedEvent are invoked only once
+  /// (with nullptr call data), therefore this method is much faster than
+  /// adding many control points one by one.
+  /// Return index of the last added control point, -1 on failure.
+  int AddControlPoints(vtkPoints* points, vtkStringArray* labels = nullptr);
+  /// Add a control point for each point of the list (in world coordinate system).
+  /// \sa AddControlPoints
+  int AddControlPointsWorld(vtkPoints* points, vtkStringArray* labels = nullptr);
 
   /// Get the position of the Nth control point
   /// returning it as a vtkVector3d, return (0,0,0) if not found
@@ -409,7 +431,10 @@ public:
   /// \deprecated Use GetNthControlPointID instead.
   std::string GetNthMarkupID(int n = 0) { return this->GetNthControlPointID(n); }
 
-  /// Get the Nth control point index based on it's ID
+  /// Get the Nth control point index based on it's ID.
+  /// Control points are looked up in a hash table, therefore it is fast even for
+  /// large number of control points. The ID of a control point must not be changed
+  /// by modifying the ControlPoint structure directly.
   int GetNthControlPointIndexByID(const char* controlPointID);
   /// Get the Nth control point based on it's ID
   ControlPoint* GetNthControlPointByID(const char* controlPointID);
@@ -556,6 +581,8 @@ public:
   /// New control points are added if needed.
   /// Existing control points are updated with the new positions.
   /// Any extra existing control points are removed.
+  /// All points are transformed at once, curve and measurements are updated only once,
+  /// and each point event is invoked only once (with nullptr call data).
   void SetControlPointPositionsWorld(vtkPoints* points);
 
   /// Get a copy of all control point positions in world coordinate system
@@ -596,6 +623,14 @@ protected:
 
   std::string GenerateControlPointLabel(int controlPointIndex);
 
+  /// Transform points between the local and world coordinate systems,
+  /// using a single transform for all the points.
+  void TransformPointsToWorld(vtkPoints* pointsLocal, vtkPoints* pointsWorld);
+  void TransformPointsFromWorld(vtkPoints* pointsWorld, vtkPoints* pointsLocal);
+
+  /// Rebuild the control point ID index if control points were inserted, removed, or reordered.
+  void UpdateControlPointIndexByID();
+
   virtual void UpdateCurvePolyFromControlPoints();
 
   virtual void UpdateCurvePolyFromCurveInputPoly();
@@ -617,6 +652,12 @@ protected:
   // Vector of control points
   ControlPointsListType ControlPoints;
 
+  // Index of each control point ID in ControlPoints.
+  // It is updated when control points are appended and rebuilt on demand
+  // (when ControlPointIndexByIDValid is false) after other modifications.
+  std::unordered_map<std::string, int> ControlPointIndexByID;
+  bool ControlPointIndexByIDValid;
+
   // Converts curve control points to curve points.
   vtkSmartPointer<vtkCurveGenerator> CurveGenerator;
 
@@ -0,0 +1,193 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsFiducialStorageNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTestingOutputWindow.h>
+#include <vtkTimerLog.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <string>
+
+// Test reading and writing large point lists in binary markups files (.mrkb)
+// and compare throughput with markups fiducial CSV files (.fcsv).
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateControlPoints(vtkMRMLMarkupsNode* markupsNode, int numberOfPoints)
+{
+  vtkMath::RandomSeed(42);
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    points->SetPoint(pointIndex, vtkMath::Random(-100.0, 100.0), vtkMath::Random(-100.0, 100.0), vtkMath::Random(-100.0, 100.0));
+    }
+  markupsNode->AddControlPoints(points.GetPointer());
+
+  // non-default values for some points
+  int wasModifying = markupsNode->StartModify();
+  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex += 7)
+    {
+    markupsNode->SetNthControlPointOrientation(pointIndex, cos(pointIndex * 0.1), sin(pointIndex * 0.1), 0.0, 0.0);
+    markupsNode->SetNthControlPointVisibility(pointIndex, false);
+    markupsNode->SetNthControlPointSelected(pointIndex, (pointIndex % 2) == 0);
+    markupsNode->SetNthControlPointLocked(pointIndex, true);
+    markupsNode->SetNthControlPointAssociatedNodeID(pointIndex, "vtkMRMLScalarVolumeNode1");
+    markupsNode->SetNthControlPointDescription(pointIndex, "Description, with \"quotes\" and commas");
+    }
+  markupsNode->SetNthControlPointLabel(1, "");
+  markupsNode->SetNthControlPointLabel(2, "Label, with comma");
+  markupsNode->UnsetNthControlPointPosition(3);
+  markupsNode->EndModify(wasModifying);
+}
+
+//----------------------------------------------------------------------------
+int CheckControlPoints(vtkMRMLMarkupsNode* expectedNode, vtkMRMLMarkupsNode* actualNode)
+{
+  CHECK_INT(actualNode->GetNumberOfControlPoints(), expectedNode->GetNumberOfControlPoints());
+  for (int pointIndex = 0; pointIndex < expectedNode->GetNumberOfControlPoints(); pointIndex++)
+    {
+    vtkMRMLMarkupsNode::ControlPoint* expected = expectedNode->GetNthControlPoint(pointIndex);
+    vtkMRMLMarkupsNode::ControlPoint* actual = actualNode->GetNthControlPoint(pointIndex);
+    CHECK_DOUBLE_TOLERANCE(sqrt(vtkMath::Distance2BetweenPoints(actual->Position, expected->Position)), 0.0, 1e-6);
+    for (int i = 0; i < 9; i++)
+      {
+      CHECK_DOUBLE_TOLERANCE(actual->OrientationMatrix[i], expected->OrientationMatrix[i], 1e-6);
+      }
+    CHECK_STD_STRING(actual->ID, expected->ID);
+    CHECK_STD_STRING(actual->Label, expected->Label);
+    CHECK_STD_STRING(actual->Description, expected->Description);
+    CHECK_STD_STRING(actual->AssociatedNodeID, expected->AssociatedNodeID);
+    CHECK_BOOL(actual->Visibility, expected->Visibility);
+    CHECK_BOOL(actual->Selected, expected->Selected);
+    CHECK_BOOL(actual->Locked, expected->Locked);
+    CHECK_INT(actual->PositionStatus, expected->PositionStatus);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestWriteRead(vtkMRMLScene* scene, vtkMRMLMarkupsNode* markupsNode, const std::string& fileName,
+  int coordinateSystem, bool lossless)
+{
+  vtkNew<vtkTimerLog> timer;
+
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> writerStorageNode;
+  scene->AddNode(writerStorageNode.GetPointer());
+  writerStorageNode->SetCoordinateSystem(coordinateSystem);
+  writerStorageNode->SetFileName(fileName.c_str());
+  timer->StartTimer();
+  CHECK_BOOL(writerStorageNode->WriteData(markupsNode), true);
+  timer->StopTimer();
+  double writeTime = timer->GetElapsedTime();
+
+  vtkNew<vtkMRMLMarkupsFiducialNode> readMarkupsNode;
+  scene->AddNode(readMarkupsNode.GetPointer());
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> readerStorageNode;
+  scene->AddNode(readerStorageNode.GetPointer());
+  readerStorageNode->SetFileName(fileName.c_str());
+  timer->StartTimer();
+  CHECK_BOOL(readerStorageNode->ReadData(readMarkupsNode.GetPointer()), true);
+  timer->StopTimer();
+  double readTime = timer->GetElapsedTime();
+
+  std::cout << vtksys::SystemTools::GetFilenameName(fileName) << ": "
+    << markupsNode->GetNumberOfControlPoints() << " points, "
+    << vtksys::SystemTools::FileLength(fileName) / 1024 << " kB, write " << writeTime << "s, read " << readTime << "s" << std::endl;
+
+  CHECK_INT(readerStorageNode->GetCoordinateSystem(), coordinateSystem);
+  if (lossless)
+    {
+    CHECK_EXIT_SUCCESS(CheckControlPoints(markupsNode, readMarkupsNode.GetPointer()));
+    }
+  else
+    {
+    CHECK_INT(readMarkupsNode->GetNumberOfControlPoints(), markupsNode->GetNumberOfControlPoints());
+    }
+
+  // new control points get a unique ID
+  int newPointIndex = readMarkupsNode->AddControlPoint(vtkVector3d(1.0, 2.0, 3.0));
+  std::string newPointID = readMarkupsNode->GetNthControlPointID(newPointIndex);
+  CHECK_INT(readMarkupsNode->GetNthControlPointIndexByID(newPointID.c_str()), newPointIndex);
+
+  scene->RemoveNode(readMarkupsNode.GetPointer());
+  scene->RemoveNode(readerStorageNode.GetPointer());
+  scene->RemoveNode(writerStorageNode.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNodeTest4(int argc, char * argv[] )
+{
+  // get the file name (without extension)
+  std::string fileNameBase = std::string("markupsFiducialStorageNodeTest4");
+  if (argc > 1)
+    {
+    fileNameBase = std::string(argv[1]);
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode;
+  scene->AddNode(markupsNode.GetPointer());
+  // more points than the number of points in a chunk of the binary file
+  CreateControlPoints(markupsNode.GetPointer(), 100000);
+
+  // fcsv files are only used as reference for timing, as they do not store
+  // position status and full precision coordinates
+  CHECK_EXIT_SUCCESS(TestWriteRead(scene.GetPointer(), markupsNode.GetPointer(),
+    fileNameBase + ".fcsv", vtkMRMLMarkupsStorageNode::RAS, false));
+  CHECK_EXIT_SUCCESS(TestWriteRead(scene.GetPointer(), markupsNode.GetPointer(),
+    fileNameBase + ".mrkb", vtkMRMLMarkupsStorageNode::RAS, true));
+  CHECK_EXIT_SUCCESS(TestWriteRead(scene.GetPointer(), markupsNode.GetPointer(),
+    fileNameBase + "-lps.mrkb", vtkMRMLMarkupsStorageNode::LPS, true));
+
+  // empty list
+  vtkNew<vtkMRMLMarkupsFiducialNode> emptyMarkupsNode;
+  scene->AddNode(emptyMarkupsNode.GetPointer());
+  CHECK_EXIT_SUCCESS(TestWriteRead(scene.GetPointer(), emptyMarkupsNode.GetPointer(),
+    fileNameBase + "-empty.mrkb", vtkMRMLMarkupsStorageNode::RAS, true));
+
+  // invalid file
+  std::string invalidFileName = fileNameBase + "-invalid.mrkb";
+  std::ofstream invalidFile(invalidFileName.c_str());
+  invalidFile << "# Markups fiducial file version = 4.11" << std::endl;
+  invalidFile.close();
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(invalidFileName.c_str());
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(storageNode->ReadData(markupsNode.GetPointer()), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  std::cout << "Success" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLMarkupsCurveNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLTransformNode.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkStringArray.h>
+#include <vtkTestingOutputWindow.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STL includes
+#include <cmath>
+#include <string>
+
+// Test bulk control point operations and control point lookup by ID on large point lists.
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+int CheckControlPointPositionsWorld(vtkMRMLMarkupsNode* markupsNode, vtkPoints* expectedPointsWorld)
+{
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), static_cast<int>(expectedPointsWorld->GetNumberOfPoints()));
+  vtkNew<vtkPoints> pointsWorld;
+  markupsNode->GetControlPointPositionsWorld(pointsWorld.GetPointer());
+  CHECK_INT(static_cast<int>(pointsWorld->GetNumberOfPoints()), static_cast<int>(expectedPointsWorld->GetNumberOfPoints()));
+  for (vtkIdType pointIndex = 0; pointIndex < expectedPointsWorld->GetNumberOfPoints(); pointIndex++)
+    {
+    double* expectedPointWorld = expectedPointsWorld->GetPoint(pointIndex);
+    CHECK_DOUBLE_TOLERANCE(sqrt(vtkMath::Distance2BetweenPoints(pointsWorld->GetPoint(pointIndex), expectedPointWorld)), 0.0, 1e-6);
+    }
+  // spot-check individual control point accessors
+  for (int pointIndex = 0; pointIndex < markupsNode->GetNumberOfControlPoints(); pointIndex += 997)
+    {
+    double pointWorld[3] = { 0.0, 0.0, 0.0 };
+    markupsNode->GetNthControlPointPositionWorld(pointIndex, pointWorld);
+    CHECK_DOUBLE_TOLERANCE(sqrt(vtkMath::Distance2BetweenPoints(pointWorld, expectedPointsWorld->GetPoint(pointIndex))), 0.0, 1e-6);
+    CHECK_INT(markupsNode->GetNthControlPointPositionStatus(pointIndex), vtkMRMLMarkupsNode::PositionDefined);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CheckControlPointIndexByID(vtkMRMLMarkupsNode* markupsNode)
+{
+  for (int pointIndex = 0; pointIndex < markupsNode->GetNumberOfControlPoints(); pointIndex++)
+    {
+    std::string id = markupsNode->GetNthControlPointID(pointIndex);
+    CHECK_INT(markupsNode->GetNthControlPointIndexByID(id.c_str()), pointIndex);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void CreateRandomPoints(vtkPoints* points, int numberOfPoints)
+{
+  points->SetNumberOfPoints(numberOfPoints);
+  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    points->SetPoint(pointIndex, vtkMath::Random(-100.0, 100.0), vtkMath::Random(-100.0, 100.0), vtkMath::Random(-100.0, 100.0));
+    }
+}
+
+//----------------------------------------------------------------------------
+int TestBulkOperations(vtkMRMLScene* scene, vtkMRMLMarkupsNode* markupsNode, vtkMRMLTransformNode* transformNode)
+{
+  const int numberOfPoints = 100000;
+  std::cout << markupsNode->GetClassName() << ":" << std::endl;
+
+  scene->AddNode(markupsNode);
+  markupsNode->SetAndObserveTransformNodeID(transformNode->GetID());
+
+  vtkNew<vtkMRMLCoreTestingUtilities::vtkMRMLNodeCallback> spy;
+  markupsNode->AddObserver(vtkCommand::AnyEvent, spy.GetPointer());
+  vtkNew<vtkTimerLog> timer;
+
+  // Add all points at once
+  vtkNew<vtkPoints> pointsWorld;
+  CreateRandomPoints(pointsWorld.GetPointer(), numberOfPoints);
+  timer->StartTimer();
+  CHECK_INT(markupsNode->AddControlPointsWorld(pointsWorld.GetPointer()), numberOfPoints - 1);
+  timer->StopTimer();
+  std::cout << "  add " << numberOfPoints << " points: " << timer->GetElapsedTime() << "s" << std::endl;
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointAddedEvent), 1);
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointModifiedEvent), 1);
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointPositionDefinedEvent), 1);
+  CHECK_EXIT_SUCCESS(CheckControlPointPositionsWorld(markupsNode, pointsWorld.GetPointer()));
+  CHECK_STD_STRING(markupsNode->GetNthControlPointLabel(numberOfPoints - 1), markupsNode->GetName() + std::string("-") + std::to_string(numberOfPoints));
+
+  // Look up all points by ID
+  timer->StartTimer();
+  CHECK_EXIT_SUCCESS(CheckControlPointIndexByID(markupsNode));
+  timer->StopTimer();
+  std::cout << "  look up " << numberOfPoints << " points by ID: " << timer->GetElapsedTime() << "s" << std::endl;
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID("nonexistent"), -1);
+  CHECK_NULL(markupsNode->GetNthControlPointByID("nonexistent"));
+
+  // Index is updated after points are removed, inserted, or swapped
+  std::string removedID = markupsNode->GetNthControlPointID(10);
+  std::string shiftedID = markupsNode->GetNthControlPointID(11);
+  markupsNode->RemoveNthControlPoint(10);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(removedID.c_str()), -1);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(shiftedID.c_str()), 10);
+  markupsNode->SwapControlPoints(10, 20);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(shiftedID.c_str()), 20);
+  CHECK_BOOL(markupsNode->InsertControlPoint(0, vtkVector3d(1.0, 2.0, 3.0)), true);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(shiftedID.c_str()), 21);
+  CHECK_EXIT_SUCCESS(CheckControlPointIndexByID(markupsNode));
+  std::string lastID = markupsNode->GetNthControlPointID(markupsNode->GetNumberOfControlPoints() - 1);
+  markupsNode->RemoveNthControlPoint(markupsNode->GetNumberOfControlPoints() - 1);
+  CHECK_INT(markupsNode->GetNthControlPointIndexByID(lastID.c_str()), -1);
+  CHECK_EXIT_SUCCESS(CheckControlPointIndexByID(markupsNode));
+
+  // Update all point positions, removing extra points
+  spy->ResetNumberOfEvents();
+  vtkNew<vtkPoints> fewerPointsWorld;
+  CreateRandomPoints(fewerPointsWorld.GetPointer(), numberOfPoints / 2);
+  timer->StartTimer();
+  markupsNode->SetControlPointPositionsWorld(fewerPointsWorld.GetPointer());
+  timer->StopTimer();
+  std::cout << "  update " << fewerPointsWorld->GetNumberOfPoints() << " points and remove the rest: "
+    << timer->GetElapsedTime() << "s" << std::endl;
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointRemovedEvent), 1);
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointModifiedEvent), 1);
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointAddedEvent), 0);
+  CHECK_EXIT_SUCCESS(CheckControlPointPositionsWorld(markupsNode, fewerPointsWorld.GetPointer()));
+  CHECK_EXIT_SUCCESS(CheckControlPointIndexByID(markupsNode));
+
+  // Update all point positions, adding new points
+  spy->ResetNumberOfEvents();
+  timer->StartTimer();
+  markupsNode->SetControlPointPositionsWorld(pointsWorld.GetPointer());
+  timer->StopTimer();
+  std::cout << "  update " << fewerPointsWorld->GetNumberOfPoints() << " points and add "
+    << numberOfPoints - fewerPointsWorld->GetNumberOfPoints() << " points: " << timer->GetElapsedTime() << "s" << std::endl;
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointRemovedEvent), 0);
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointModifiedEvent), 1);
+  CHECK_INT(spy->GetNumberOfEvents(vtkMRMLMarkupsNode::PointAddedEvent), 1);
+  CHECK_EXIT_SUCCESS(CheckControlPointPositionsWorld(markupsNode, pointsWorld.GetPointer()));
+  CHECK_EXIT_SUCCESS(CheckControlPointIndexByID(markupsNode));
+
+  // Copy
+  vtkSmartPointer<vtkMRMLMarkupsNode> markupsNodeCopy = vtkSmartPointer<vtkMRMLMarkupsNode>::Take(
+    vtkMRMLMarkupsNode::SafeDownCast(markupsNode->CreateNodeInstance()));
+  timer->StartTimer();
+  markupsNodeCopy->Copy(markupsNode);
+  timer->StopTimer();
+  std::cout << "  copy " << numberOfPoints << " points: " << timer->GetElapsedTime() << "s" << std::endl;
+  CHECK_INT(markupsNodeCopy->GetNumberOfControlPoints(), numberOfPoints);
+  CHECK_INT(markupsNodeCopy->GetNthControlPointIndexByID(markupsNode->GetNthControlPointID(123).c_str()), 123);
+
+  // Reference: add points one by one (fewer points, as it is much slower)
+  const int numberOfPointsOneByOne = 2000;
+  vtkSmartPointer<vtkMRMLMarkupsNode> markupsNodeOneByOne = vtkSmartPointer<vtkMRMLMarkupsNode>::Take(
+    vtkMRMLMarkupsNode::SafeDownCast(markupsNode->CreateNodeInstance()));
+  scene->AddNode(markupsNodeOneByOne);
+  markupsNodeOneByOne->SetAndObserveTransformNodeID(transformNode->GetID());
+  timer->StartTimer();
+  for (int pointIndex = 0; pointIndex < numberOfPointsOneByOne; pointIndex++)
+    {
+    markupsNodeOneByOne->AddControlPointWorld(vtkVector3d(pointsWorld->GetPoint(pointIndex)));
+    }
+  timer->StopTimer();
+  double oneByOneTime = timer->GetElapsedTime();
+  markupsNodeOneByOne->RemoveAllControlPoints();
+  vtkNew<vtkPoints> pointsWorldSubset;
+  pointsWorldSubset->SetNumberOfPoints(numberOfPointsOneByOne);
+  for (int pointIndex = 0; pointIndex < numberOfPointsOneByOne; pointIndex++)
+    {
+    pointsWorldSubset->SetPoint(pointIndex, pointsWorld->GetPoint(pointIndex));
+    }
+  timer->StartTimer();
+  markupsNodeOneByOne->AddControlPointsWorld(pointsWorldSubset.GetPointer());
+  timer->StopTimer();
+  std::cout << "  add " << numberOfPointsOneByOne << " points one by one: " << oneByOneTime
+    << "s, at once: " << timer->GetElapsedTime() << "s" << std::endl;
+  CHECK_EXIT_SUCCESS(CheckControlPointPositionsWorld(markupsNodeOneByOne, pointsWorldSubset.GetPointer()));
+
+  markupsNode->RemoveObserver(spy.GetPointer());
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsNodeTest4(int , char * [] )
+{
+  vtkMath::RandomSeed(42);
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkTransform> transform;
+  transform->Translate(10.0, -20.0, 30.0);
+  transform->RotateWXYZ(30.0, 1.0, 2.0, 3.0);
+  vtkNew<vtkMRMLTransformNode> transformNode;
+  scene->AddNode(transformNode.GetPointer());
+  transformNode->SetMatrixTransformToParent(transform->GetMatrix());
+
+  vtkNew<vtkMRMLMarkupsFiducialNode> fiducialNode;
+  fiducialNode->SetName("F");
+  CHECK_EXIT_SUCCESS(TestBulkOperations(scene.GetPointer(), fiducialNode.GetPointer(), transformNode.GetPointer()));
+
+  vtkNew<vtkMRMLMarkupsCurveNode> curveNode;
+  curveNode->SetName("C");
+  CHECK_EXIT_SUCCESS(TestBulkOperations(scene.GetPointer(), curveNode.GetPointer(), transformNode.GetPointer()));
+
+  // Invalid input
+  vtkNew<vtkPoints> points;
+  CreateRandomPoints(points.GetPointer(), 3);
+  vtkNew<vtkStringArray> labels;
+  labels->InsertNextValue("a");
+  labels->InsertNextValue("b");
+  labels->InsertNextValue("");
+  vtkNew<vtkMRMLMarkupsFiducialNode> labeledNode;
+  labeledNode->SetName("L");
+  CHECK_INT(labeledNode->AddControlPoints(points.GetPointer(), labels.GetPointer()), 2);
+  CHECK_STD_STRING(labeledNode->GetNthControlPointLabel(0), "a");
+  CHECK_STD_STRING(labeledNode->GetNthControlPointLabel(1), "b");
+  CHECK_STD_STRING(labeledNode->GetNthControlPointLabel(2), "L-3");
+  labels->InsertNextValue("d");
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_INT(labeledNode->AddControlPoints(points.GetPointer(), labels.GetPointer()), -1);
+  CHECK_INT(labeledNode->AddControlPoints(static_cast<vtkPoints*>(nullptr)), -1);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(labeledNode->GetNumberOfControlPoints(), 3);
+
+  std::cout << "Success" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -89,7 +89,8 @@ QStringList qSlicerMarkupsReader::extensions()const
 {
   return QStringList()
     << "Markups Fiducials (*.fcsv)"
-    << " Annotation Fiducial (*.acsv)";
+    << " Annotation Fiducial (*.acsv)"
+    << "Markups Binary (*.mrkb)";
 }
 
 //-----------------------------------------------------------------------------
@@ -101,6 +101,8 @@ The effect uses <a href="https://www.spl.harvard.edu/publications/item/view/2761
 
     if not self.growCutFilter:
       self.growCutFilter = vtkSlicerSegmentationsModuleLogic.vtkImageGrowCutSegment()
+      # Radix queue engine only stores the propagation front and updates only the region affected by seed changes
+      self.growCutFilter.SetEngineToRadixQueue()
       self.growCutFilter.SetIntensityVolume(self.clippedMasterImageData)
       self.growCutFilter.SetMaskVolume(self.clippedMaskImageData)
       maskExtent = self.clippedMaskImageData.GetExtent() if self.clippedMaskImageData else None
@@ -25,6 +25,7 @@
 #include "vtkMRMLSegmentationDisplayNode.h"
 #include "vtkMRMLSegmentationsDisplayableManager2D.h"
 #include "vtkMRMLSegmentEditorNode.h"
+#include "vtkBrushRasterizer.h"
 #include "vtkOrientedImageData.h"
 
 // Qt includes
@@ -47,10 +48,6 @@
 #include <vtkGlyph2D.h>
 #include <vtkGlyph3D.h>
 #include <vtkIdList.h>
-#include <vtkImageChangeInformation.h>
-#include <vtkImageStencil.h>
-#include <vtkImageStencilData.h>
-#include <vtkImageStencilToImage.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -61,7 +58,6 @@
 #include <vtkPolyDataMapper.h>
 #include <vtkPolyDataMapper2D.h>
 #include <vtkPolyDataNormals.h>
-#include <vtkPolyDataToImageStencil.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkPropPicker.h>
@@ -93,7 +89,6 @@
 #include "qSlicerApplication.h"
 #include "vtkMRMLSliceLogic.h"
 #include "vtkMRMLSliceLayerLogic.h"
-#include "vtkOrientedImageDataResample.h"
 
 //-----------------------------------------------------------------------------
 /// Visualization objects and pipeline for each slice view for the paint brush
@@ -253,13 +248,7 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   this->WorldOriginToWorldTransformer->SetTransform(this->WorldOriginToWorldTransform);
   this->WorldOriginToWorldTransformer->SetInputConnection(this->BrushPolyDataNormals->GetOutputPort());
 
-  this->WorldOriginToModifierLabelmapIjkTransformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  this->WorldOriginToModifierLabelmapIjkTransform = vtkSmartPointer<vtkTransform>::New();
-  this->WorldOriginToModifierLabelmapIjkTransformer->SetTransform(this->WorldOriginToModifierLabelmapIjkTransform);
-  this->WorldOriginToModifierLabelmapIjkTransformer->SetInputConnection(this->BrushPolyDataNormals->GetOutputPort());
-  this->BrushPolyDataToStencil = vtkSmartPointer<vtkPolyDataToImageStencil>::New();
-  this->BrushPolyDataToStencil->SetOutputSpacing(1.0,1.0,1.0);
-  this->BrushPolyDataToStencil->SetInputConnection(this->WorldOriginToModifierLabelmapIjkTransformer->GetOutputPort());
+  this->BrushRasterizer = vtkSmartPointer<vtkBrushRasterizer>::New();
 
   this->FeedbackGlyphFilter = vtkSmartPointer<vtkGlyph3D>::New();
   this->FeedbackGlyphFilter->SetInputData(this->FeedbackPointsPolyData);
@@ -407,55 +396,25 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
 }
 
 //-----------------------------------------------------------------------------
-void qSlicerSegmentEditorPaintEffectPrivate::updateBrushStencil(qMRMLWidget* viewWidget)
+void qSlicerSegmentEditorPaintEffectPrivate::updateBrushRasterizer(qMRMLWidget* viewWidget)
 {
   Q_Q(qSlicerSegmentEditorPaintEffect);
-  Q_UNUSED(viewWidget);
 
-  if (!q->parameterSetNode())
-    {
-    qCritical() << Q_FUNC_INFO << ": Invalid segment editor parameter set node!";
-    return;
-    }
-  vtkMRMLSegmentationNode* segmentationNode = q->parameterSetNode()->GetSegmentationNode();
-  if (!segmentationNode)
+  // Same brush shape as in updateBrushModel
+  this->BrushRasterizer->SetRadius(q->doubleParameter("BrushAbsoluteDiameter") / 2.0);
+  qMRMLSliceWidget* sliceWidget = qobject_cast<qMRMLSliceWidget*>(viewWidget);
+  if (!sliceWidget || q->integerParameter("BrushSphere"))
     {
-    qCritical() << Q_FUNC_INFO << ": Invalid segmentationNode";
-    return;
+    this->BrushRasterizer->SetBrushShapeToSphere();
     }
-  vtkOrientedImageData* modifierLabelmap = q->modifierLabelmap();
-  if (!modifierLabelmap)
+  else
     {
-    qCritical() << Q_FUNC_INFO << ": Invalid modifierLabelmap";
-    return;
+    // cylinder axis is the slice normal
+    vtkMatrix4x4* sliceToRAS = sliceWidget->sliceLogic()->GetSliceNode()->GetSliceToRAS();
+    this->BrushRasterizer->SetBrushShapeToCylinder();
+    this->BrushRasterizer->SetHeight(qSlicerSegmentEditorAbstractEffect::sliceSpacing(sliceWidget));
+    this->BrushRasterizer->SetAxis(sliceToRAS->GetElement(0, 2), sliceToRAS->GetElement(1, 2), sliceToRAS->GetElement(2, 2));
     }
-
-  // Brush stencil transform
-
-  this->WorldOriginToModifierLabelmapIjkTransform->Identity();
-
-  vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
-  modifierLabelmap->GetImageToWorldMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-  segmentationToSegmentationIjkTransformMatrix->Invert();
-  segmentationToSegmentationIjkTransformMatrix->SetElement(0,3, 0);
-  segmentationToSegmentationIjkTransformMatrix->SetElement(1,3, 0);
-  segmentationToSegmentationIjkTransformMatrix->SetElement(2,3, 0);
-  this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-
-  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
-  // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
-  // TODO: show a meaningful error message to the user if attempted
-  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(nullptr, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
-  worldToSegmentationTransformMatrix->SetElement(0,3, 0);
-  worldToSegmentationTransformMatrix->SetElement(1,3, 0);
-  worldToSegmentationTransformMatrix->SetElement(2,3, 0);
-  this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
-
-  this->WorldOriginToModifierLabelmapIjkTransformer->Update();
-  vtkPolyData* brushModel_ModifierLabelmapIjk = this->WorldOriginToModifierLabelmapIjkTransformer->GetOutput();
-  double* boundsIjk = brushModel_ModifierLabelmapIjk->GetBounds();
-  this->BrushPolyDataToStencil->SetOutputWholeExtent(floor(boundsIjk[0])-1, ceil(boundsIjk[1])+1,
-    floor(boundsIjk[2])-1, ceil(boundsIjk[3])+1, floor(boundsIjk[4])-1, ceil(boundsIjk[5])+1);
 }
 
 //-----------------------------------------------------------------------------
@@ -561,10 +520,9 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintBrushes(
   vtkPoints* pixelPositions_World,
   int updateExtent[6])
 {
-  Q_UNUSED(pixelPositions_World);
   Q_Q(qSlicerSegmentEditorPaintEffect);
 
-  this->updateBrushStencil(viewWidget);
+  this->updateBrushRasterizer(viewWidget);
 
   if (!modifierLabelmap)
     {
@@ -578,57 +536,13 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintBrushes(
     return;
     }
 
-  this->BrushPolyDataToStencil->Update();
-  vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-  int stencilExtent[6]={0,-1,0,-1,0,-1};
-  stencilData->GetExtent(stencilExtent);
-
-  vtkNew<vtkPoints> paintCoordinates_Ijk;
-  this->transformPointsFromWorldToIJK(modifierLabelmap, segmentationNode, this->PaintCoordinates_World, paintCoordinates_Ijk);
-
-  vtkNew<vtkImageStencilToImage> stencilToImage;
-  stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-  stencilToImage->SetInsideValue(q->m_FillValue);
-  stencilToImage->SetOutsideValue(q->m_EraseValue);
-  stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-  vtkNew<vtkImageChangeInformation> brushPositioner;
-  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-  brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-  brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
+  // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
+  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
+  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(nullptr, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
 
-  vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
-  for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
-    {
-    double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
-    int shift[3] = {int(shiftDouble[0]+0.5), int(shiftDouble[1]+0.5), int(shiftDouble[2]+0.5)};
-    brushPositioner->SetExtentTranslation(shift);
-    brushPositioner->Update();
-    vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-    orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
-    orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
-    if (pointIndex == 0)
-      {
-      orientedBrushPositionerOutput->GetExtent(updateExtent);
-      }
-    else
-      {
-      int* brushExtent = orientedBrushPositionerOutput->GetExtent();
-      for (int i = 0; i < 3; i++)
-        {
-        if (brushExtent[i * 2] < updateExtent[i * 2])
-          {
-          updateExtent[i * 2] = brushExtent[i * 2];
-          }
-        if (brushExtent[i * 2 + 1] > updateExtent[i * 2 + 1])
-          {
-          updateExtent[i * 2 + 1] = brushExtent[i * 2 + 1];
-          }
-        }
-      }
-    vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
-    }
-  modifierLabelmap->Modified();
+  // Brush voxels are set to the fill value, the other voxels are left unchanged
+  this->BrushRasterizer->Paint(modifierLabelmap, pixelPositions_World, q->m_FillValue,
+    updateExtent, worldToSegmentationTransformMatrix.GetPointer());
 }
 
 //-----------------------------------------------------------------------------
@@ -61,10 +61,10 @@ class QToolButton;
 class qMRMLSliceWidget;
 class qMRMLSpinBox;
 class vtkActor2D;
+class vtkBrushRasterizer;
 class vtkGlyph3D;
 class vtkPoints;
 class vtkPolyDataNormals;
-class vtkPolyDataToImageStencil;
 
 /// \ingroup SlicerRt_QtModules_Segmentations
 /// \brief Private implementation of the segment editor paint effect
@@ -92,9 +92,9 @@ public:
   /// Update brush model (shape and position)
   void updateBrushModel(qMRMLWidget* viewWidget, double brushPosition_World[3]);
 
-  /// Updates the brush stencil that can be used to quickly paint the brush shape into
+  /// Updates the brush rasterizer that paints the brush shape into
   /// modifierLabelmap at many different positions.
-  void updateBrushStencil(qMRMLWidget* viewWidget);
+  void updateBrushRasterizer(qMRMLWidget* viewWidget);
 
 protected:
   /// Get brush object for widget. Create if does not exist
@@ -144,9 +144,7 @@ public:
   vtkSmartPointer<vtkTransformPolyDataFilter> WorldOriginToWorldTransformer;
   vtkSmartPointer<vtkTransform> WorldOriginToWorldTransform;
   vtkSmartPointer<vtkPolyDataNormals> BrushPolyDataNormals;
-  vtkSmartPointer<vtkTransformPolyDataFilter> WorldOriginToModifierLabelmapIjkTransformer;
-  vtkSmartPointer<vtkTransform> WorldOriginToModifierLabelmapIjkTransform; // transforms from polydata source to modifierLabelmap's IJK coordinate system (brush origin in IJK origin)
-  vtkSmartPointer<vtkPolyDataToImageStencil> BrushPolyDataToStencil;
+  vtkSmartPointer<vtkBrushRasterizer> BrushRasterizer;
 
   vtkSmartPointer<vtkGlyph3D> FeedbackGlyphFilter;
 
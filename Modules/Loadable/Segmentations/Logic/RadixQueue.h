@@ -0,0 +1,143 @@
+// exclude from VTK wrapping
+#ifndef __VTK_WRAP__
+
+#ifndef RADIXQUEUE_H
+#define RADIXQUEUE_H
+
+#include "FibHeap.h"
+
+#include <cstring>
+#include <vector>
+
+// .NAME RadixQueue - Monotone priority queue of voxel indices
+// .SECTION Description
+//
+// Radix heap storing (key, voxel index) pairs in 33 buckets. It requires
+// that inserted keys are never smaller than the last extracted key, which
+// is the case in Dijkstra's algorithm with non-negative edge weights.
+//
+// Compared to FibHeap, no node has to be allocated for each voxel: only
+// the voxels that are on the propagation front are stored (8 bytes each).
+// Decreasing the key of a voxel is done by inserting it again, so the caller
+// has to skip extracted entries whose key is larger than the current
+// distance of the voxel.
+//
+// Keys are non-negative floats, which have the same ordering as their bit
+// pattern interpreted as unsigned integer.
+
+class RadixQueue
+{
+public:
+  struct Entry
+  {
+    unsigned int Radix;
+    NodeIndexType Index;
+  };
+
+  RadixQueue()
+    : m_Last(0)
+    , m_Size(0)
+  {
+  }
+
+  inline bool IsEmpty() const { return m_Size == 0; }
+  inline size_t GetSize() const { return m_Size; }
+
+  inline void Clear()
+  {
+    for (int i = 0; i < NumberOfBuckets; i++)
+      {
+      // swap with empty vector to release memory
+      std::vector<Entry>().swap(m_Buckets[i]);
+      }
+    m_Last = 0;
+    m_Size = 0;
+  }
+
+  // Key must not be smaller than the last extracted key
+  inline void Insert(NodeKeyValueType key, NodeIndexType index)
+  {
+    Entry entry;
+    entry.Radix = KeyToRadix(key);
+    entry.Index = index;
+    m_Buckets[GetBucketIndex(entry.Radix)].push_back(entry);
+    m_Size++;
+  }
+
+  // Queue must not be empty
+  inline void ExtractMin(NodeKeyValueType& key, NodeIndexType& index)
+  {
+    if (m_Buckets[0].empty())
+      {
+      // Find the first non-empty bucket and redistribute its entries in the lower buckets
+      int bucketIndex = 1;
+      while (m_Buckets[bucketIndex].empty())
+        {
+        bucketIndex++;
+        }
+      std::vector<Entry>& bucket = m_Buckets[bucketIndex];
+      unsigned int minRadix = bucket[0].Radix;
+      for (size_t i = 1; i < bucket.size(); i++)
+        {
+        if (bucket[i].Radix < minRadix)
+          {
+          minRadix = bucket[i].Radix;
+          }
+        }
+      m_Last = minRadix;
+      for (size_t i = 0; i < bucket.size(); i++)
+        {
+        m_Buckets[GetBucketIndex(bucket[i].Radix)].push_back(bucket[i]);
+        }
+      bucket.clear();
+      }
+    const Entry& entry = m_Buckets[0].back();
+    key = RadixToKey(entry.Radix);
+    index = entry.Index;
+    m_Buckets[0].pop_back();
+    m_Size--;
+  }
+
+private:
+  static const int NumberOfBuckets = 33;
+
+  static inline unsigned int KeyToRadix(NodeKeyValueType key)
+  {
+    unsigned int radix;
+    memcpy(&radix, &key, sizeof(radix));
+    return radix;
+  }
+
+  static inline NodeKeyValueType RadixToKey(unsigned int radix)
+  {
+    NodeKeyValueType key;
+    memcpy(&key, &radix, sizeof(key));
+    return key;
+  }
+
+  // 0 if radix is equal to the last extracted value, otherwise 1 + position
+  // of the highest bit that differs from the last extracted value.
+  inline int GetBucketIndex(unsigned int radix) const
+  {
+    unsigned int diff = radix ^ m_Last;
+    if (diff == 0)
+      {
+      return 0;
+      }
+    int bucketIndex = 1;
+    if (diff & 0xFFFF0000) { bucketIndex += 16; diff >>= 16; }
+    if (diff & 0xFF00) { bucketIndex += 8; diff >>= 8; }
+    if (diff & 0xF0) { bucketIndex += 4; diff >>= 4; }
+    if (diff & 0xC) { bucketIndex += 2; diff >>= 2; }
+    if (diff & 0x2) { bucketIndex += 1; }
+    return bucketIndex;
+  }
+
+  std::vector<Entry> m_Buckets[NumberOfBuckets];
+  unsigned int m_Last;
+  size_t m_Size;
+};
+
+#endif /* RADIXQUEUE_H */
+
+#endif //__VTK_WRAP__
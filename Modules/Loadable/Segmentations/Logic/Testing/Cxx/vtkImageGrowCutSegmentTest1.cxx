@@ -0,0 +1,302 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageGrowCutSegment.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+// Compare the labels and distances computed by the radix queue engine of
+// vtkImageGrowCutSegment with the results of the Fibonacci heap engine.
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void AllocateImage(vtkImageData* image, int dims[3], int scalarType)
+{
+  image->SetDimensions(dims);
+  image->SetSpacing(0.5, 0.6, 0.8);
+  image->SetOrigin(10.0, 20.0, 30.0);
+  image->AllocateScalars(scalarType, 1);
+  image->GetPointData()->GetScalars()->FillComponent(0, 0.0);
+}
+
+//----------------------------------------------------------------------------
+void FillBox(vtkImageData* image, int x0, int x1, int y0, int y1, int z0, int z1, double value)
+{
+  for (int z = z0; z <= z1; z++)
+    {
+    for (int y = y0; y <= y1; y++)
+      {
+      for (int x = x0; x <= x1; x++)
+        {
+        image->SetScalarComponentFromDouble(x, y, z, 0, value);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Copy a region of the image, keeping the voxel indices
+void CropImage(vtkImageData* image, int extent[6], vtkImageData* croppedImage)
+{
+  croppedImage->SetExtent(extent);
+  croppedImage->SetSpacing(image->GetSpacing());
+  croppedImage->SetOrigin(image->GetOrigin());
+  croppedImage->AllocateScalars(image->GetScalarType(), 1);
+  croppedImage->CopyAndCastFrom(image, extent);
+}
+
+//----------------------------------------------------------------------------
+// Labels are compared in the extent of the Fibonacci heap engine output, distances in the region
+// that is computed by the radix queue engine. Distances are not exact in coarse-to-fine mode.
+int CompareResults(vtkImageGrowCutSegment* fibonacciHeapFilter, vtkImageGrowCutSegment* radixQueueFilter,
+  bool compareDistances)
+{
+  vtkImageData* expectedLabels = fibonacciHeapFilter->GetOutput();
+  vtkImageData* actualLabels = radixQueueFilter->GetOutput();
+  int* extent = expectedLabels->GetExtent();
+  int* actualExtent = actualLabels->GetExtent();
+  for (int i = 0; i < 3; i++)
+    {
+    CHECK_BOOL(actualExtent[2 * i] <= extent[2 * i] && extent[2 * i + 1] <= actualExtent[2 * i + 1], true);
+    }
+  int numberOfDifferentLabels = 0;
+  for (int z = extent[4]; z <= extent[5]; z++)
+    {
+    for (int y = extent[2]; y <= extent[3]; y++)
+      {
+      for (int x = extent[0]; x <= extent[1]; x++)
+        {
+        if (expectedLabels->GetScalarComponentAsDouble(x, y, z, 0) != actualLabels->GetScalarComponentAsDouble(x, y, z, 0))
+          {
+          numberOfDifferentLabels++;
+          }
+        }
+      }
+    }
+  CHECK_INT(numberOfDifferentLabels, 0);
+
+  if (!compareDistances)
+    {
+    return EXIT_SUCCESS;
+    }
+  vtkImageData* expectedDistances = fibonacciHeapFilter->GetDistanceVolume();
+  vtkImageData* actualDistances = radixQueueFilter->GetDistanceVolume();
+  int* distanceExtent = actualDistances->GetExtent();
+  int numberOfDifferentDistances = 0;
+  for (int z = distanceExtent[4]; z <= distanceExtent[5]; z++)
+    {
+    for (int y = distanceExtent[2]; y <= distanceExtent[3]; y++)
+      {
+      for (int x = distanceExtent[0]; x <= distanceExtent[1]; x++)
+        {
+        double expected = expectedDistances->GetScalarComponentAsDouble(x, y, z, 0);
+        double actual = actualDistances->GetScalarComponentAsDouble(x, y, z, 0);
+        if (fabs(actual - expected) > 1e-5 * std::max(1.0, fabs(expected)))
+          {
+          numberOfDifferentDistances++;
+          }
+        }
+      }
+    }
+  CHECK_INT(numberOfDifferentDistances, 0);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Random intensities, so that there are no ties between the paths of different labels.
+// Results of both engines must be the same.
+int TestRandomIntensity()
+{
+  int dims[3] = { 64, 64, 64 };
+  vtkNew<vtkImageData> intensityVolume;
+  AllocateImage(intensityVolume.GetPointer(), dims, VTK_FLOAT);
+  vtkMath::RandomSeed(42);
+  float* intensity = static_cast<float*>(intensityVolume->GetScalarPointer());
+  for (vtkIdType i = 0; i < intensityVolume->GetNumberOfPoints(); i++)
+    {
+    intensity[i] = static_cast<float>(vtkMath::Random(0.0, 100.0));
+    }
+
+  vtkNew<vtkImageData> seedLabelVolume;
+  AllocateImage(seedLabelVolume.GetPointer(), dims, VTK_SHORT);
+  FillBox(seedLabelVolume.GetPointer(), 10, 12, 10, 12, 10, 12, 1);
+  FillBox(seedLabelVolume.GetPointer(), 45, 47, 40, 42, 30, 32, 2);
+  FillBox(seedLabelVolume.GetPointer(), 30, 31, 50, 52, 50, 52, 3);
+
+  // The computed region of the radix queue engine is cropped to the non-masked voxels
+  vtkNew<vtkImageData> maskVolume;
+  AllocateImage(maskVolume.GetPointer(), dims, VTK_UNSIGNED_CHAR);
+  FillBox(maskVolume.GetPointer(), 0, 5, 0, 63, 0, 63, 1);
+  FillBox(maskVolume.GetPointer(), 58, 63, 0, 63, 0, 63, 1);
+  FillBox(maskVolume.GetPointer(), 20, 25, 20, 25, 20, 25, 1);
+
+  vtkNew<vtkImageGrowCutSegment> fibonacciHeapFilter;
+  fibonacciHeapFilter->SetEngineToFibonacciHeap();
+  fibonacciHeapFilter->SetIntensityVolume(intensityVolume.GetPointer());
+  fibonacciHeapFilter->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  fibonacciHeapFilter->SetMaskVolume(maskVolume.GetPointer());
+  fibonacciHeapFilter->Update();
+
+  vtkNew<vtkImageGrowCutSegment> radixQueueFilter;
+  radixQueueFilter->SetEngineToRadixQueue();
+  // initialization is split between threads
+  radixQueueFilter->SetNumberOfThreads(4);
+  radixQueueFilter->SetIntensityVolume(intensityVolume.GetPointer());
+  radixQueueFilter->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  radixQueueFilter->SetMaskVolume(maskVolume.GetPointer());
+  radixQueueFilter->Update();
+
+  int expectedCropExtent[6] = { 5, 58, 0, 63, 0, 63 };
+  int* cropExtent = radixQueueFilter->GetDistanceVolume()->GetExtent();
+  CHECK_BOOL(std::equal(expectedCropExtent, expectedCropExtent + 6, cropExtent), true);
+  CHECK_EXIT_SUCCESS(CompareResults(fibonacciHeapFilter.GetPointer(), radixQueueFilter.GetPointer(), true));
+
+  // Update: new seeds for an existing and for a new label
+  FillBox(seedLabelVolume.GetPointer(), 15, 16, 50, 51, 15, 16, 2);
+  FillBox(seedLabelVolume.GetPointer(), 50, 52, 10, 12, 50, 52, 4);
+  seedLabelVolume->Modified();
+  fibonacciHeapFilter->Update();
+  radixQueueFilter->Update();
+  CHECK_EXIT_SUCCESS(CompareResults(fibonacciHeapFilter.GetPointer(), radixQueueFilter.GetPointer(), true));
+
+  // The update gives the same result as a full computation
+  vtkNew<vtkImageGrowCutSegment> fullRadixQueueFilter;
+  fullRadixQueueFilter->SetEngineToRadixQueue();
+  fullRadixQueueFilter->SetIntensityVolume(intensityVolume.GetPointer());
+  fullRadixQueueFilter->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  fullRadixQueueFilter->SetMaskVolume(maskVolume.GetPointer());
+  fullRadixQueueFilter->Update();
+  CHECK_EXIT_SUCCESS(CompareResults(fibonacciHeapFilter.GetPointer(), fullRadixQueueFilter.GetPointer(), true));
+
+  // Seed crop margin: same result as the Fibonacci heap engine on the cropped input
+  const int seedCropMargin = 3;
+  vtkNew<vtkImageGrowCutSegment> croppedRadixQueueFilter;
+  croppedRadixQueueFilter->SetEngineToRadixQueue();
+  croppedRadixQueueFilter->SetSeedCropMargin(seedCropMargin);
+  croppedRadixQueueFilter->SetIntensityVolume(intensityVolume.GetPointer());
+  croppedRadixQueueFilter->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  croppedRadixQueueFilter->SetMaskVolume(maskVolume.GetPointer());
+  croppedRadixQueueFilter->Update();
+
+  // bounding box of the seeds is [10, 52] along each axis
+  int expectedSeedCropExtent[6] = { 7, 55, 7, 55, 7, 55 };
+  int* seedCropExtent = croppedRadixQueueFilter->GetDistanceVolume()->GetExtent();
+  CHECK_BOOL(std::equal(expectedSeedCropExtent, expectedSeedCropExtent + 6, seedCropExtent), true);
+
+  vtkNew<vtkImageData> croppedIntensityVolume;
+  CropImage(intensityVolume.GetPointer(), seedCropExtent, croppedIntensityVolume.GetPointer());
+  vtkNew<vtkImageData> croppedSeedLabelVolume;
+  CropImage(seedLabelVolume.GetPointer(), seedCropExtent, croppedSeedLabelVolume.GetPointer());
+  vtkNew<vtkImageData> croppedMaskVolume;
+  CropImage(maskVolume.GetPointer(), seedCropExtent, croppedMaskVolume.GetPointer());
+  vtkNew<vtkImageGrowCutSegment> croppedFibonacciHeapFilter;
+  croppedFibonacciHeapFilter->SetEngineToFibonacciHeap();
+  croppedFibonacciHeapFilter->SetIntensityVolume(croppedIntensityVolume.GetPointer());
+  croppedFibonacciHeapFilter->SetSeedLabelVolume(croppedSeedLabelVolume.GetPointer());
+  croppedFibonacciHeapFilter->SetMaskVolume(croppedMaskVolume.GetPointer());
+  croppedFibonacciHeapFilter->Update();
+
+  // voxels outside of the cropped region are not labeled
+  vtkImageData* croppedLabels = croppedRadixQueueFilter->GetOutput();
+  int* extent = croppedLabels->GetExtent();
+  CHECK_BOOL(std::equal(extent, extent + 6, intensityVolume->GetExtent()), true);
+  CHECK_DOUBLE(croppedLabels->GetScalarComponentAsDouble(seedCropExtent[0] - 1, 30, 30, 0), 0.0);
+  CHECK_DOUBLE(croppedLabels->GetScalarComponentAsDouble(30, seedCropExtent[3] + 1, 30, 0), 0.0);
+  CHECK_BOOL(fullRadixQueueFilter->GetOutput()->GetScalarComponentAsDouble(30, seedCropExtent[3] + 1, 30, 0) != 0.0, true);
+
+  CHECK_EXIT_SUCCESS(CompareResults(croppedFibonacciHeapFilter.GetPointer(), croppedRadixQueueFilter.GetPointer(), true));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Bright sphere on a dark background, with an intensity gradient. Labels do not depend
+// on the order of the voxels of the propagation front, therefore coarse-to-fine computation
+// gives the same labels as full resolution computation.
+int TestCoarseToFine()
+{
+  int dims[3] = { 40, 36, 32 };
+  const double center[3] = { 20.0, 18.0, 16.0 };
+  const double radius = 10.0;
+  vtkNew<vtkImageData> intensityVolume;
+  AllocateImage(intensityVolume.GetPointer(), dims, VTK_SHORT);
+  for (int z = 0; z < dims[2]; z++)
+    {
+    for (int y = 0; y < dims[1]; y++)
+      {
+      for (int x = 0; x < dims[0]; x++)
+        {
+        double point[3] = { static_cast<double>(x), static_cast<double>(y), static_cast<double>(z) };
+        bool inside = vtkMath::Distance2BetweenPoints(point, center) <= radius * radius;
+        intensityVolume->SetScalarComponentFromDouble(x, y, z, 0, (inside ? 1000 : 0) + x + 2 * y + 3 * z);
+        }
+      }
+    }
+
+  vtkNew<vtkImageData> seedLabelVolume;
+  AllocateImage(seedLabelVolume.GetPointer(), dims, VTK_UNSIGNED_CHAR);
+  FillBox(seedLabelVolume.GetPointer(), 18, 22, 16, 20, 14, 18, 1);
+  FillBox(seedLabelVolume.GetPointer(), 2, 4, 2, 4, 2, 4, 2);
+  FillBox(seedLabelVolume.GetPointer(), 35, 37, 31, 33, 27, 29, 2);
+
+  vtkNew<vtkImageGrowCutSegment> fibonacciHeapFilter;
+  fibonacciHeapFilter->SetEngineToFibonacciHeap();
+  fibonacciHeapFilter->SetDistancePenalty(0.5);
+  fibonacciHeapFilter->SetIntensityVolume(intensityVolume.GetPointer());
+  fibonacciHeapFilter->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  fibonacciHeapFilter->Update();
+
+  vtkNew<vtkImageGrowCutSegment> radixQueueFilter;
+  radixQueueFilter->SetEngineToRadixQueue();
+  radixQueueFilter->SetDistancePenalty(0.5);
+  radixQueueFilter->CoarseToFineOn();
+  radixQueueFilter->SetIntensityVolume(intensityVolume.GetPointer());
+  radixQueueFilter->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  radixQueueFilter->Update();
+  CHECK_EXIT_SUCCESS(CompareResults(fibonacciHeapFilter.GetPointer(), radixQueueFilter.GetPointer(), false));
+
+  // the sphere is segmented
+  vtkImageData* labels = radixQueueFilter->GetOutput();
+  CHECK_DOUBLE(labels->GetScalarComponentAsDouble(20, 18, 16 + 9, 0), 1.0);
+  CHECK_DOUBLE(labels->GetScalarComponentAsDouble(20, 18, 16 + 11, 0), 2.0);
+  CHECK_DOUBLE(labels->GetScalarComponentAsDouble(20 - 10, 18, 16, 0), 1.0);
+  CHECK_DOUBLE(labels->GetScalarComponentAsDouble(20 - 11, 18, 16, 0), 2.0);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageGrowCutSegmentTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestRandomIntensity());
+  CHECK_EXIT_SUCCESS(TestCoarseToFine());
+  std::cout << "Success" << std::endl;
+  return EXIT_SUCCESS;
+}
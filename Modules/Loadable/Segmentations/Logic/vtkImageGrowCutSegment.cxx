@@ -1,5 +1,7 @@
 #include "vtkImageGrowCutSegment.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -7,6 +9,7 @@
 #include <vtkInformationVector.h>
 #include <vtkLoggingMacros.h>
 #include <vtkMath.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
@@ -14,6 +17,7 @@
 #include <vtkTimerLog.h>
 
 #include "FibHeap.h"
+#include "RadixQueue.h"
 
 vtkStandardNewMacro(vtkImageGrowCutSegment);
 
@@ -27,6 +31,157 @@ const int MaskPixelTypeID = VTK_UNSIGNED_CHAR;
 const NodeKeyValueType DIST_INF = std::numeric_limits<NodeKeyValueType>::max();
 const NodeKeyValueType DIST_EPSILON = 1e-3;
 
+// Coarse-to-fine computation is only used if the image is at least this large along each axis
+const int MINIMUM_COARSE_TO_FINE_DIMENSION = 8;
+
+// Initialization of smaller images is not split between threads
+const vtkIdType MINIMUM_NUMBER_OF_VOXELS_PER_THREAD = 65536;
+
+// Classification of the blocks of the coarse image in coarse-to-fine computation
+const unsigned char BLOCK_INTERIOR = 0; // block and all its neighbors have the same label, not recomputed at full resolution
+const unsigned char BLOCK_FRONT = 1; // same as interior, but adjacent to a band block, labels are propagated from here
+const unsigned char BLOCK_BAND = 2; // recomputed at full resolution
+
+//----------------------------------------------------------------------------
+// Initialization of distances and labels for the radix queue engine.
+// Each thread processes a range of slices and collects the voxels that have to be
+// inserted in the queue, as the queue is not thread-safe.
+template<typename LabelPixelType>
+struct RadixInitializationThreadData
+{
+  const LabelPixelType* SeedLabels; // first voxel of the computed region
+  const MaskPixelType* Mask; // first voxel of the computed region, nullptr if there is no mask
+  vtkIdType InputIncrements[3]; // increments of seed and mask volumes
+  int Dims[3]; // size of the computed region
+  NodeKeyValueType* Distances;
+  LabelPixelType* Labels;
+  bool Update; // only grow from new/changed seeds
+  // Result of coarse computation, nullptr if not used
+  const LabelPixelType* CoarseLabels;
+  const NodeKeyValueType* CoarseDistances;
+  const unsigned char* CoarseBlockTypes;
+  int CoarseDims[3];
+  std::vector< std::vector<NodeIndexType> > InsertedIndices; // for each thread
+};
+
+//----------------------------------------------------------------------------
+template<typename LabelPixelType>
+void InitializeRadixSlices(RadixInitializationThreadData<LabelPixelType>* data, int threadId, int numberOfThreads)
+{
+  const int* dims = data->Dims;
+  const vtkIdType* inc = data->InputIncrements;
+  int zBegin = static_cast<int>(static_cast<vtkIdType>(dims[2]) * threadId / numberOfThreads);
+  int zEnd = static_cast<int>(static_cast<vtkIdType>(dims[2]) * (threadId + 1) / numberOfThreads);
+  std::vector<NodeIndexType>& insertedIndices = data->InsertedIndices[threadId];
+  for (int z = zBegin; z < zEnd; z++)
+    {
+    for (int y = 0; y < dims[1]; y++)
+      {
+      const LabelPixelType* seedPtr = data->SeedLabels + z * inc[2] + y * inc[1];
+      const MaskPixelType* maskPtr = data->Mask ? data->Mask + z * inc[2] + y * inc[1] : nullptr;
+      NodeIndexType index = static_cast<NodeIndexType>(dims[0]) * (y + static_cast<NodeIndexType>(dims[1]) * z);
+      for (int x = 0; x < dims[0]; x++, index++)
+        {
+        bool masked = (maskPtr && maskPtr[x] != 0);
+        LabelPixelType seedValue = seedPtr[x];
+        if (data->Update)
+          {
+          // Only grow from new/changed seeds
+          if (!masked && seedValue != 0
+            && (data->Labels[index] != seedValue || data->Distances[index] > DIST_EPSILON))
+            {
+            data->Labels[index] = seedValue;
+            data->Distances[index] = DIST_EPSILON;
+            insertedIndices.push_back(index);
+            }
+          continue;
+          }
+        if (masked)
+          {
+          // small distance will prevent overwriting of masked voxels
+          data->Labels[index] = 0;
+          data->Distances[index] = DIST_EPSILON;
+          }
+        else if (seedValue != 0)
+          {
+          data->Labels[index] = seedValue;
+          data->Distances[index] = DIST_EPSILON;
+          insertedIndices.push_back(index);
+          }
+        else if (data->CoarseBlockTypes)
+          {
+          NodeIndexType coarseIndex = (x / 2) + static_cast<NodeIndexType>(data->CoarseDims[0])
+            * ((y / 2) + static_cast<NodeIndexType>(data->CoarseDims[1]) * (z / 2));
+          unsigned char blockType = data->CoarseBlockTypes[coarseIndex];
+          if (blockType == BLOCK_BAND)
+            {
+            data->Labels[index] = 0;
+            data->Distances[index] = DIST_INF;
+            }
+          else
+            {
+            // Distance is kept above DIST_EPSILON so that new seeds can relabel the voxel
+            data->Labels[index] = data->CoarseLabels[coarseIndex];
+            data->Distances[index] = data->CoarseDistances[coarseIndex] + DIST_EPSILON;
+            if (blockType == BLOCK_FRONT)
+              {
+              insertedIndices.push_back(index);
+              }
+            }
+          }
+        else
+          {
+          data->Labels[index] = 0;
+          data->Distances[index] = DIST_INF;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template<typename LabelPixelType>
+VTK_THREAD_RETURN_TYPE InitializeRadixSlicesThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  RadixInitializationThreadData<LabelPixelType>* data = static_cast<RadixInitializationThreadData<LabelPixelType>*>(info->UserData);
+  InitializeRadixSlices(data, info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+template<typename LabelPixelType>
+void InitializeRadix(RadixInitializationThreadData<LabelPixelType>& data, int maximumNumberOfThreads, RadixQueue& queue)
+{
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(data.Dims[0]) * data.Dims[1] * data.Dims[2];
+  int numberOfThreads = (maximumNumberOfThreads > 0 ? maximumNumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+  numberOfThreads = static_cast<int>(std::min(static_cast<vtkIdType>(numberOfThreads), numberOfVoxels / MINIMUM_NUMBER_OF_VOXELS_PER_THREAD));
+  numberOfThreads = std::max(std::min(numberOfThreads, data.Dims[2]), 1);
+  data.InsertedIndices.clear();
+  data.InsertedIndices.resize(numberOfThreads);
+  if (numberOfThreads > 1)
+    {
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(InitializeRadixSlicesThread<LabelPixelType>, &data);
+    threader->SingleMethodExecute();
+    }
+  else
+    {
+    InitializeRadixSlices(&data, 0, 1);
+    }
+  for (int threadId = 0; threadId < numberOfThreads; threadId++)
+    {
+    std::vector<NodeIndexType>& insertedIndices = data.InsertedIndices[threadId];
+    for (std::vector<NodeIndexType>::iterator indexIt = insertedIndices.begin(); indexIt != insertedIndices.end(); ++indexIt)
+      {
+      queue.Insert(data.Distances[*indexIt], *indexIt);
+      }
+    // swap with empty vector to release memory
+    std::vector<NodeIndexType>().swap(insertedIndices);
+    }
+}
+
 //----------------------------------------------------------------------------
 class vtkImageGrowCutSegment::vtkInternal
 {
@@ -44,11 +199,33 @@ public:
 
   template <class SourceVolType>
   bool ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
-    vtkImageData *resultLabelVolume, double distancePenalty);
+    vtkImageData *resultLabelVolume, double distancePenalty, int engine);
 
   template< class SourceVolType, class SeedVolType>
   bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
 
+  /// Compute the region where labels may change: bounding box of non-masked voxels
+  /// (and of the seeds, if SeedCropMargin is non-negative).
+  template<typename LabelPixelType>
+  void ComputeCropExtent(vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, int cropExtent[6]);
+
+  /// Build half-resolution intensity, seed, and mask images of the region of size dims.
+  /// Blocks that contain seeds of different labels are marked as BLOCK_BAND in coarseBlockTypes.
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void BuildCoarseImages(const IntensityPixelType* intensity, const vtkIdType intensityIncrements[3],
+    const LabelPixelType* seedLabels, const MaskPixelType* mask, const vtkIdType labelIncrements[3], const int dims[3],
+    std::vector<float>& coarseIntensity, std::vector<LabelPixelType>& coarseSeedLabels,
+    std::vector<MaskPixelType>& coarseMask, std::vector<unsigned char>& coarseBlockTypes);
+
+  /// Dijkstra propagation of labels from the voxels in the queue.
+  /// Voxels at the boundary of the region are labeled but labels are not propagated from them.
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void PropagateRadix(RadixQueue& queue, const IntensityPixelType* intensity, const vtkIdType intensityIncrements[3],
+    const int dims[3], const double spacing[3], NodeKeyValueType* distances, LabelPixelType* labels);
+
+  template<typename IntensityPixelType, typename LabelPixelType>
+  bool ExecuteGrowCutRadix(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
+
   // Stores the shortest distance from known labels to each point
   // If a point is set to DIST_INF then that point will modified, as a shorter distance path will be found.
   // If a point is set to DIST_EPSILON, then the distance is so small that a shorter path will not be found and so
@@ -70,6 +247,17 @@ public:
   FibHeap *m_Heap;
   FibHeapNode *m_HeapNodes; // a node is stored for each voxel
   bool m_bSegInitialized;
+
+  // Engine and input extent of the current result
+  int m_Engine;
+  int m_InputExtent[6];
+  // Region of the input that is stored in m_DistanceVolume and m_ResultLabelVolume by the radix queue engine
+  int m_CropExtent[6];
+
+  // Radix queue engine settings
+  bool m_CoarseToFine;
+  int m_SeedCropMargin;
+  int m_NumberOfThreads;
 };
 
 //-----------------------------------------------------------------------------
@@ -81,6 +269,17 @@ vtkImageGrowCutSegment::vtkInternal::vtkInternal()
   m_bSegInitialized = false;
   m_DistanceVolume = vtkSmartPointer<vtkImageData>::New();
   m_ResultLabelVolume = vtkSmartPointer<vtkImageData>::New();
+  m_Engine = -1;
+  for (int i = 0; i < 3; i++)
+    {
+    m_InputExtent[2 * i] = 0;
+    m_InputExtent[2 * i + 1] = -1;
+    m_CropExtent[2 * i] = 0;
+    m_CropExtent[2 * i + 1] = -1;
+    }
+  m_CoarseToFine = false;
+  m_SeedCropMargin = -1;
+  m_NumberOfThreads = 0;
 };
 
 //-----------------------------------------------------------------------------
@@ -105,6 +304,14 @@ void vtkImageGrowCutSegment::vtkInternal::Reset()
   m_bSegInitialized = false;
   m_DistanceVolume->Initialize();
   m_ResultLabelVolume->Initialize();
+  m_Engine = -1;
+  for (int i = 0; i < 3; i++)
+    {
+    m_InputExtent[2 * i] = 0;
+    m_InputExtent[2 * i + 1] = -1;
+    m_CropExtent[2 * i] = 0;
+    m_CropExtent[2 * i + 1] = -1;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -142,7 +349,7 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
     seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
     }
   MaskPixelType* maskLabelVolumePtr = nullptr;
-  if (seedLabelVolume != nullptr)
+  if (maskLabelVolume != nullptr)
     {
     maskLabelVolumePtr = static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer());
     }
@@ -442,10 +649,407 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensit
   return true;
 }
 
+//-----------------------------------------------------------------------------
+template<typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::ComputeCropExtent(vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, int cropExtent[6])
+{
+  int* extent = seedLabelVolume->GetExtent();
+  for (int i = 0; i < 6; i++)
+    {
+    cropExtent[i] = extent[i];
+    }
+
+  // Labels are only propagated through non-masked voxels. Masked voxels around them
+  // are kept in the region (1 voxel margin), as they stop the propagation.
+  const MaskPixelType* maskPtr = maskLabelVolume ? static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer()) : nullptr;
+  if (maskPtr)
+    {
+    int box[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    const MaskPixelType* voxelPtr = maskPtr;
+    for (int z = extent[4]; z <= extent[5]; z++)
+      {
+      for (int y = extent[2]; y <= extent[3]; y++)
+        {
+        for (int x = extent[0]; x <= extent[1]; x++, voxelPtr++)
+          {
+          if (*voxelPtr == 0)
+            {
+            box[0] = std::min(box[0], x);
+            box[1] = std::max(box[1], x);
+            box[2] = std::min(box[2], y);
+            box[3] = std::max(box[3], y);
+            box[4] = std::min(box[4], z);
+            box[5] = std::max(box[5], z);
+            }
+          }
+        }
+      }
+    for (int i = 0; i < 3; i++)
+      {
+      cropExtent[2 * i] = std::max(cropExtent[2 * i], box[2 * i] - 1);
+      cropExtent[2 * i + 1] = std::min(cropExtent[2 * i + 1], box[2 * i + 1] + 1);
+      }
+    }
+
+  if (m_SeedCropMargin >= 0)
+    {
+    int box[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    const LabelPixelType* voxelPtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
+    const MaskPixelType* maskVoxelPtr = maskPtr;
+    for (int z = extent[4]; z <= extent[5]; z++)
+      {
+      for (int y = extent[2]; y <= extent[3]; y++)
+        {
+        for (int x = extent[0]; x <= extent[1]; x++, voxelPtr++)
+          {
+          bool masked = (maskVoxelPtr && *(maskVoxelPtr++) != 0);
+          if (*voxelPtr != 0 && !masked)
+            {
+            box[0] = std::min(box[0], x);
+            box[1] = std::max(box[1], x);
+            box[2] = std::min(box[2], y);
+            box[3] = std::max(box[3], y);
+            box[4] = std::min(box[4], z);
+            box[5] = std::max(box[5], z);
+            }
+          }
+        }
+      }
+    for (int i = 0; i < 3; i++)
+      {
+      if (box[2 * i] > box[2 * i + 1])
+        {
+        // no seeds
+        cropExtent[2 * i + 1] = cropExtent[2 * i] - 1;
+        continue;
+        }
+      cropExtent[2 * i] = std::max(cropExtent[2 * i], box[2 * i] - m_SeedCropMargin);
+      cropExtent[2 * i + 1] = std::min(cropExtent[2 * i + 1], box[2 * i + 1] + m_SeedCropMargin);
+      }
+    }
+
+  if (cropExtent[0] > cropExtent[1] || cropExtent[2] > cropExtent[3] || cropExtent[4] > cropExtent[5])
+    {
+    // empty region, use the same representation everywhere to allow comparison
+    for (int i = 0; i < 3; i++)
+      {
+      cropExtent[2 * i] = 0;
+      cropExtent[2 * i + 1] = -1;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::BuildCoarseImages(
+  const IntensityPixelType* intensity, const vtkIdType intensityIncrements[3],
+  const LabelPixelType* seedLabels, const MaskPixelType* mask, const vtkIdType labelIncrements[3], const int dims[3],
+  std::vector<float>& coarseIntensity, std::vector<LabelPixelType>& coarseSeedLabels,
+  std::vector<MaskPixelType>& coarseMask, std::vector<unsigned char>& coarseBlockTypes)
+{
+  int coarseDims[3] = { (dims[0] + 1) / 2, (dims[1] + 1) / 2, (dims[2] + 1) / 2 };
+  NodeIndexType numberOfCoarseVoxels = static_cast<NodeIndexType>(coarseDims[0]) * coarseDims[1] * coarseDims[2];
+  coarseIntensity.assign(numberOfCoarseVoxels, 0.0f);
+  coarseSeedLabels.assign(numberOfCoarseVoxels, 0);
+  coarseBlockTypes.assign(numberOfCoarseVoxels, BLOCK_INTERIOR);
+  // A block is masked if all its voxels are masked
+  coarseMask.assign(mask ? numberOfCoarseVoxels : 0, 1);
+  std::vector<unsigned char> numberOfBlockVoxels(numberOfCoarseVoxels, 0);
+
+  for (int z = 0; z < dims[2]; z++)
+    {
+    for (int y = 0; y < dims[1]; y++)
+      {
+      const IntensityPixelType* intensityPtr = intensity + z * intensityIncrements[2] + y * intensityIncrements[1];
+      const LabelPixelType* seedPtr = seedLabels + z * labelIncrements[2] + y * labelIncrements[1];
+      const MaskPixelType* maskPtr = mask ? mask + z * labelIncrements[2] + y * labelIncrements[1] : nullptr;
+      NodeIndexType coarseRowIndex = static_cast<NodeIndexType>(coarseDims[0]) * ((y / 2) + static_cast<NodeIndexType>(coarseDims[1]) * (z / 2));
+      for (int x = 0; x < dims[0]; x++)
+        {
+        NodeIndexType coarseIndex = coarseRowIndex + x / 2;
+        coarseIntensity[coarseIndex] += static_cast<float>(intensityPtr[x * intensityIncrements[0]]);
+        numberOfBlockVoxels[coarseIndex]++;
+        if (maskPtr)
+          {
+          if (maskPtr[x] != 0)
+            {
+            continue;
+            }
+          coarseMask[coarseIndex] = 0;
+          }
+        LabelPixelType seedValue = seedPtr[x];
+        if (seedValue != 0)
+          {
+          if (coarseSeedLabels[coarseIndex] == 0)
+            {
+            coarseSeedLabels[coarseIndex] = seedValue;
+            }
+          else if (coarseSeedLabels[coarseIndex] != seedValue)
+            {
+            // seeds of different labels, must be computed at full resolution
+            coarseBlockTypes[coarseIndex] = BLOCK_BAND;
+            }
+          }
+        }
+      }
+    }
+  for (NodeIndexType coarseIndex = 0; coarseIndex < numberOfCoarseVoxels; coarseIndex++)
+    {
+    coarseIntensity[coarseIndex] /= numberOfBlockVoxels[coarseIndex];
+    }
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::PropagateRadix(RadixQueue& queue,
+  const IntensityPixelType* intensity, const vtkIdType intensityIncrements[3],
+  const int dims[3], const double spacing[3], NodeKeyValueType* distances, LabelPixelType* labels)
+{
+  vtkIdType neighborIndexOffsets[26];
+  vtkIdType neighborIntensityOffsets[26];
+  NodeKeyValueType neighborDistancePenalties[26];
+  int numberOfNeighbors = 0;
+  for (int iz = -1; iz <= 1; iz++)
+    {
+    for (int iy = -1; iy <= 1; iy++)
+      {
+      for (int ix = -1; ix <= 1; ix++)
+        {
+        if (ix == 0 && iy == 0 && iz == 0)
+          {
+          continue;
+          }
+        neighborIndexOffsets[numberOfNeighbors] = ix + static_cast<vtkIdType>(dims[0]) * (iy + static_cast<vtkIdType>(dims[1]) * iz);
+        neighborIntensityOffsets[numberOfNeighbors] = ix * intensityIncrements[0] + iy * intensityIncrements[1] + iz * intensityIncrements[2];
+        neighborDistancePenalties[numberOfNeighbors] = m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
+          + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz));
+        numberOfNeighbors++;
+        }
+      }
+    }
+
+  while (!queue.IsEmpty())
+    {
+    NodeKeyValueType currentDistance;
+    NodeIndexType index;
+    queue.ExtractMin(currentDistance, index);
+    if (currentDistance > distances[index])
+      {
+      // a shorter path has been found since this voxel was inserted
+      continue;
+      }
+
+    NodeIndexType x = index % dims[0];
+    NodeIndexType y = (index / dims[0]) % dims[1];
+    NodeIndexType z = index / dims[0] / dims[1];
+    if (x == 0 || y == 0 || z == 0
+      || x == static_cast<NodeIndexType>(dims[0] - 1)
+      || y == static_cast<NodeIndexType>(dims[1] - 1)
+      || z == static_cast<NodeIndexType>(dims[2] - 1))
+      {
+      continue;
+      }
+
+    const IntensityPixelType* intensityPtr = intensity + x * intensityIncrements[0] + y * intensityIncrements[1] + z * intensityIncrements[2];
+    NodeKeyValueType pixCenter = *intensityPtr;
+    LabelPixelType currentLabel = labels[index];
+    for (int i = 0; i < numberOfNeighbors; i++)
+      {
+      NodeIndexType indexNgbh = static_cast<NodeIndexType>(index + neighborIndexOffsets[i]);
+      NodeKeyValueType neighborNewDistance = fabs(pixCenter - intensityPtr[neighborIntensityOffsets[i]]) + currentDistance + neighborDistancePenalties[i];
+      if (distances[indexNgbh] > neighborNewDistance)
+        {
+        distances[indexNgbh] = neighborNewDistance;
+        labels[indexNgbh] = currentLabel;
+        queue.Insert(neighborNewDistance, indexNgbh);
+        }
+      }
+    }
+  queue.Clear();
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCutRadix(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
+  vtkImageData *maskLabelVolume, double distancePenalty)
+{
+  int cropExtent[6];
+  this->ComputeCropExtent<LabelPixelType>(seedLabelVolume, maskLabelVolume, cropExtent);
+  if (m_bSegInitialized && !std::equal(cropExtent, cropExtent + 6, m_CropExtent))
+    {
+    // Seeds moved out of the computed region, previous result cannot be reused
+    this->Reset();
+    }
+
+  int dims[3] = { cropExtent[1] - cropExtent[0] + 1, cropExtent[3] - cropExtent[2] + 1, cropExtent[5] - cropExtent[4] + 1 };
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+  vtkIdType maxNumberOfVoxels = std::numeric_limits<NodeIndexType>::max();
+  if (numberOfVoxels >= maxNumberOfVoxels)
+    {
+    vtkGenericWarningMacro("vtkImageGrowCutSegment: region size is too large (" << numberOfVoxels << " voxels)."
+      << " Maximum number of voxels is " << maxNumberOfVoxels - 1 << ".");
+    return false;
+    }
+
+  if (!m_bSegInitialized)
+    {
+    m_DistancePenalty = distancePenalty;
+    std::copy(cropExtent, cropExtent + 6, m_CropExtent);
+    m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
+    m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
+    m_ResultLabelVolume->SetExtent(cropExtent);
+    m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+    m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
+    m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
+    m_DistanceVolume->SetExtent(cropExtent);
+    m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+    }
+  if (numberOfVoxels == 0)
+    {
+    // nothing to compute (all voxels are masked or there are no seeds)
+    m_bSegInitialized = true;
+    return true;
+    }
+
+  const IntensityPixelType* intensity = static_cast<IntensityPixelType*>(
+    intensityVolume->GetScalarPointer(cropExtent[0], cropExtent[2], cropExtent[4]));
+  vtkIdType intensityIncrements[3];
+  intensityVolume->GetIncrements(intensityIncrements);
+  NodeKeyValueType* distances = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+  LabelPixelType* labels = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  double* spacing = intensityVolume->GetSpacing();
+
+  RadixInitializationThreadData<LabelPixelType> data;
+  data.SeedLabels = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer(cropExtent[0], cropExtent[2], cropExtent[4]));
+  data.Mask = maskLabelVolume ? static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer(cropExtent[0], cropExtent[2], cropExtent[4])) : nullptr;
+  seedLabelVolume->GetIncrements(data.InputIncrements);
+  std::copy(dims, dims + 3, data.Dims);
+  data.Distances = distances;
+  data.Labels = labels;
+  data.Update = m_bSegInitialized;
+  data.CoarseLabels = nullptr;
+  data.CoarseDistances = nullptr;
+  data.CoarseBlockTypes = nullptr;
+
+  RadixQueue queue;
+
+  // Coarse result, used for initializing the full resolution computation
+  std::vector<LabelPixelType> coarseLabels;
+  std::vector<NodeKeyValueType> coarseDistances;
+  std::vector<unsigned char> coarseBlockTypes;
+  if (!m_bSegInitialized && m_CoarseToFine
+    && dims[0] >= MINIMUM_COARSE_TO_FINE_DIMENSION
+    && dims[1] >= MINIMUM_COARSE_TO_FINE_DIMENSION
+    && dims[2] >= MINIMUM_COARSE_TO_FINE_DIMENSION)
+    {
+    std::vector<float> coarseIntensity;
+    std::vector<LabelPixelType> coarseSeedLabels;
+    std::vector<MaskPixelType> coarseMask;
+    this->BuildCoarseImages<IntensityPixelType, LabelPixelType>(intensity, intensityIncrements,
+      data.SeedLabels, data.Mask, data.InputIncrements, dims,
+      coarseIntensity, coarseSeedLabels, coarseMask, coarseBlockTypes);
+    int coarseDims[3] = { (dims[0] + 1) / 2, (dims[1] + 1) / 2, (dims[2] + 1) / 2 };
+    coarseLabels.resize(coarseIntensity.size());
+    coarseDistances.resize(coarseIntensity.size());
+
+    RadixInitializationThreadData<LabelPixelType> coarseData;
+    coarseData.SeedLabels = &(coarseSeedLabels[0]);
+    coarseData.Mask = coarseMask.empty() ? nullptr : &(coarseMask[0]);
+    coarseData.InputIncrements[0] = 1;
+    coarseData.InputIncrements[1] = coarseDims[0];
+    coarseData.InputIncrements[2] = static_cast<vtkIdType>(coarseDims[0]) * coarseDims[1];
+    std::copy(coarseDims, coarseDims + 3, coarseData.Dims);
+    coarseData.Distances = &(coarseDistances[0]);
+    coarseData.Labels = &(coarseLabels[0]);
+    coarseData.Update = false;
+    coarseData.CoarseLabels = nullptr;
+    coarseData.CoarseDistances = nullptr;
+    coarseData.CoarseBlockTypes = nullptr;
+    InitializeRadix(coarseData, m_NumberOfThreads, queue);
+    double coarseSpacing[3] = { spacing[0] * 2.0, spacing[1] * 2.0, spacing[2] * 2.0 };
+    this->PropagateRadix<float, LabelPixelType>(queue, &(coarseIntensity[0]), coarseData.InputIncrements,
+      coarseDims, coarseSpacing, coarseData.Distances, coarseData.Labels);
+
+    // Blocks that are not surrounded by blocks of the same label are recomputed at full resolution
+    for (int z = 0; z < coarseDims[2]; z++)
+      {
+      for (int y = 0; y < coarseDims[1]; y++)
+        {
+        for (int x = 0; x < coarseDims[0]; x++)
+          {
+          NodeIndexType coarseIndex = x + static_cast<NodeIndexType>(coarseDims[0]) * (y + static_cast<NodeIndexType>(coarseDims[1]) * z);
+          LabelPixelType label = coarseLabels[coarseIndex];
+          bool uniform = (label != 0 && coarseBlockTypes[coarseIndex] != BLOCK_BAND);
+          for (int nz = std::max(z - 1, 0); uniform && nz <= std::min(z + 1, coarseDims[2] - 1); nz++)
+            {
+            for (int ny = std::max(y - 1, 0); uniform && ny <= std::min(y + 1, coarseDims[1] - 1); ny++)
+              {
+              for (int nx = std::max(x - 1, 0); uniform && nx <= std::min(x + 1, coarseDims[0] - 1); nx++)
+                {
+                uniform = (coarseLabels[nx + static_cast<NodeIndexType>(coarseDims[0]) * (ny + static_cast<NodeIndexType>(coarseDims[1]) * nz)] == label);
+                }
+              }
+            }
+          if (!uniform)
+            {
+            coarseBlockTypes[coarseIndex] = BLOCK_BAND;
+            }
+          }
+        }
+      }
+    // Labels are propagated into the band from the uniform blocks next to it
+    for (int z = 0; z < coarseDims[2]; z++)
+      {
+      for (int y = 0; y < coarseDims[1]; y++)
+        {
+        for (int x = 0; x < coarseDims[0]; x++)
+          {
+          NodeIndexType coarseIndex = x + static_cast<NodeIndexType>(coarseDims[0]) * (y + static_cast<NodeIndexType>(coarseDims[1]) * z);
+          if (coarseBlockTypes[coarseIndex] == BLOCK_BAND)
+            {
+            continue;
+            }
+          bool front = false;
+          for (int nz = std::max(z - 1, 0); !front && nz <= std::min(z + 1, coarseDims[2] - 1); nz++)
+            {
+            for (int ny = std::max(y - 1, 0); !front && ny <= std::min(y + 1, coarseDims[1] - 1); ny++)
+              {
+              for (int nx = std::max(x - 1, 0); !front && nx <= std::min(x + 1, coarseDims[0] - 1); nx++)
+                {
+                front = (coarseBlockTypes[nx + static_cast<NodeIndexType>(coarseDims[0]) * (ny + static_cast<NodeIndexType>(coarseDims[1]) * nz)] == BLOCK_BAND);
+                }
+              }
+            }
+          if (front)
+            {
+            coarseBlockTypes[coarseIndex] = BLOCK_FRONT;
+            }
+          }
+        }
+      }
+
+    data.CoarseLabels = &(coarseLabels[0]);
+    data.CoarseDistances = &(coarseDistances[0]);
+    data.CoarseBlockTypes = &(coarseBlockTypes[0]);
+    std::copy(coarseDims, coarseDims + 3, data.CoarseDims);
+    }
+
+  InitializeRadix(data, m_NumberOfThreads, queue);
+  // Release memory before propagation at full resolution
+  std::vector<LabelPixelType>().swap(coarseLabels);
+  std::vector<NodeKeyValueType>().swap(coarseDistances);
+  std::vector<unsigned char>().swap(coarseBlockTypes);
+
+  this->PropagateRadix<IntensityPixelType, LabelPixelType>(queue, intensity, intensityIncrements, dims, spacing, distances, labels);
+
+  m_bSegInitialized = true;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 template <class SourceVolType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty, int engine)
 {
   int* extent = intensityVolume->GetExtent();
   double* spacing = intensityVolume->GetSpacing();
@@ -496,8 +1100,8 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
       }
     }
 
-  // Restart growcut from scratch if image size is changed (then cached buffers cannot be reused)
-  int* outExtent = m_ResultLabelVolume->GetExtent();
+  // Restart growcut from scratch if image size or engine is changed (then cached buffers cannot be reused)
+  int* outExtent = m_InputExtent;
   double* outSpacing = m_ResultLabelVolume->GetSpacing();
   double* outOrigin = m_ResultLabelVolume->GetOrigin();
   if (outExtent[0] != extent[0] || outExtent[1] != extent[1]
@@ -509,7 +1113,8 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
     || fabs(outSpacing[0] - spacing[0]) > compareTolerance
     || fabs(outSpacing[1] - spacing[1]) > compareTolerance
     || fabs(outSpacing[2] - spacing[2]) > compareTolerance
-    || fabs(distancePenalty - m_DistancePenalty) > compareTolerance)
+    || fabs(distancePenalty - m_DistancePenalty) > compareTolerance
+    || engine != m_Engine)
     {
     this->Reset();
     }
@@ -519,22 +1124,58 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
     }
 
   bool success = false;
-  switch (seedLabelVolume->GetScalarType())
-  {
-    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty)));
-  default:
-    vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Unknown ScalarType");
-  }
-
-  if (success)
+  if (engine == vtkImageGrowCutSegment::ENGINE_RADIX_QUEUE)
     {
-    resultLabelVolume->ShallowCopy(this->m_ResultLabelVolume);
+    switch (seedLabelVolume->GetScalarType())
+    {
+      vtkTemplateMacro((success = ExecuteGrowCutRadix<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty)));
+    default:
+      vtkGenericWarningMacro("vtkImageGrowCutSegment: Unknown seed label volume ScalarType");
+    }
     }
   else
     {
+    switch (seedLabelVolume->GetScalarType())
+    {
+      vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty)));
+    default:
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Unknown ScalarType");
+    }
+    }
+
+  if (!success)
+    {
+    this->Reset();
     resultLabelVolume->Initialize();
+    return false;
     }
-  return success;
+
+  m_Engine = engine;
+  for (int i = 0; i < 6; i++)
+    {
+    m_InputExtent[i] = extent[i];
+    }
+
+  if (engine == vtkImageGrowCutSegment::ENGINE_RADIX_QUEUE && !std::equal(extent, extent + 6, m_CropExtent))
+    {
+    // Only the cropped region is computed, voxels outside of it are not labeled
+    resultLabelVolume->Initialize();
+    resultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
+    resultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
+    resultLabelVolume->SetExtent(extent);
+    resultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+    memset(resultLabelVolume->GetScalarPointer(), 0,
+      resultLabelVolume->GetScalarSize() * resultLabelVolume->GetNumberOfPoints());
+    if (m_CropExtent[0] <= m_CropExtent[1])
+      {
+      resultLabelVolume->CopyAndCastFrom(this->m_ResultLabelVolume, m_CropExtent);
+      }
+    }
+  else
+    {
+    resultLabelVolume->ShallowCopy(this->m_ResultLabelVolume);
+    }
+  return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -544,6 +1185,10 @@ vtkImageGrowCutSegment::vtkImageGrowCutSegment()
   this->SetNumberOfInputPorts(3);
   this->SetNumberOfOutputPorts(1);
   this->DistancePenalty = 0.0;
+  this->Engine = ENGINE_FIBONACCI_HEAP;
+  this->CoarseToFine = false;
+  this->SeedCropMargin = -1;
+  this->NumberOfThreads = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -564,9 +1209,14 @@ void vtkImageGrowCutSegment::ExecuteDataWithInformation(
   vtkNew<vtkTimerLog> logger;
   logger->StartTimer();
 
+  this->Internal->m_CoarseToFine = this->CoarseToFine;
+  this->Internal->m_SeedCropMargin = this->SeedCropMargin;
+  this->Internal->m_NumberOfThreads = this->NumberOfThreads;
+
   switch (intensityVolume->GetScalarType())
     {
-    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume, this->DistancePenalty));
+    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume,
+      this->DistancePenalty, this->Engine));
     break;
     }
   logger->StopTimer();
@@ -594,9 +1244,19 @@ void vtkImageGrowCutSegment::Reset()
   this->Internal->Reset();
 }
 
+//-----------------------------------------------------------------------------
+vtkImageData* vtkImageGrowCutSegment::GetDistanceVolume()
+{
+  return this->Internal->m_DistanceVolume;
+}
+
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::PrintSelf(ostream &os, vtkIndent indent)
 {
-  // XXX Implement this function
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "DistancePenalty: " << this->DistancePenalty << "\n";
+  os << indent << "Engine: " << this->Engine << "\n";
+  os << indent << "CoarseToFine: " << this->CoarseToFine << "\n";
+  os << indent << "SeedCropMargin: " << this->SeedCropMargin << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
@@ -29,12 +29,54 @@ public:
   /// This method has to be called if intensity volume changes or if seeds are deleted after initial computation.
   void Reset();
 
+  /// Get the distance of each voxel from the seed its label was propagated from,
+  /// as computed by the last update. Only the region that the engine computed is stored:
+  /// the full input extent for ENGINE_FIBONACCI_HEAP, the cropped extent for ENGINE_RADIX_QUEUE.
+  vtkImageData* GetDistanceVolume();
+
   /// Spatial regularization factor, which can force growing in nearby regions.
   /// For each physical unit distance, this much intensity level difference is simulated.
   /// By default = 0, which means spatial distance does not play a role in the region growing, only intensity value similarity.
   vtkGetMacro(DistancePenalty, double);
   vtkSetMacro(DistancePenalty, double);
 
+  enum
+    {
+    ENGINE_FIBONACCI_HEAP,
+    ENGINE_RADIX_QUEUE
+    };
+
+  /// Priority queue used for propagating the labels.
+  /// ENGINE_FIBONACCI_HEAP (default) stores a heap node for each voxel.
+  /// ENGINE_RADIX_QUEUE only stores the voxels of the propagation front, computation is restricted
+  /// to the bounding box of non-masked voxels, and updates only visit the voxels that are reached from
+  /// new or changed seeds. It is faster and uses much less memory on large images.
+  /// Changing the engine forces full recomputation.
+  vtkSetClampMacro(Engine, int, ENGINE_FIBONACCI_HEAP, ENGINE_RADIX_QUEUE);
+  vtkGetMacro(Engine, int);
+  void SetEngineToFibonacciHeap() { this->SetEngine(ENGINE_FIBONACCI_HEAP); };
+  void SetEngineToRadixQueue() { this->SetEngine(ENGINE_RADIX_QUEUE); };
+
+  /// If enabled then the full computation is performed on a half-resolution image first,
+  /// and only the regions near the boundaries of the coarse result are propagated at full resolution.
+  /// The result is an approximation, which may differ from the full resolution computation
+  /// near thin structures. Only used by ENGINE_RADIX_QUEUE. Default is off.
+  vtkSetMacro(CoarseToFine, bool);
+  vtkGetMacro(CoarseToFine, bool);
+  vtkBooleanMacro(CoarseToFine, bool);
+
+  /// If non-negative then computation is restricted to the bounding box of the seeds,
+  /// expanded by this many voxels. Voxels outside of this region are not labeled.
+  /// Only used by ENGINE_RADIX_QUEUE. Default is -1 (no cropping to the seeds).
+  vtkSetMacro(SeedCropMargin, int);
+  vtkGetMacro(SeedCropMargin, int);
+
+  /// Maximum number of threads used for initializing the computation.
+  /// Default is 0, which uses vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  /// Only used by ENGINE_RADIX_QUEUE.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkImageGrowCutSegment();
   ~vtkImageGrowCutSegment() override;
@@ -46,6 +88,10 @@ private:
   class vtkInternal;
   vtkInternal * Internal;
   double DistancePenalty;
+  int Engine;
+  bool CoarseToFine;
+  int SeedCropMargin;
+  int NumberOfThreads;
 };
 
 #endif
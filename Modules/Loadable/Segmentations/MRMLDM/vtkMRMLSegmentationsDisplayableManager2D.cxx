@@ -30,6 +30,7 @@
 #include <vtkMRMLTransformNode.h>
 
 // MRML logic includes
+#include "vtkImageLabelMapToRGBA.h"
 #include "vtkImageLabelOutline.h"
 
 // SegmentationCore includes
@@ -209,6 +210,9 @@ public:
       this->LookupTableOutline = vtkSmartPointer<vtkLookupTable>::New();
       this->LookupTableFill = vtkSmartPointer<vtkLookupTable>::New();
       this->ImageThreshold = vtkSmartPointer<vtkImageThreshold>::New();
+      this->LabelMapToRGBA = vtkSmartPointer<vtkImageLabelMapToRGBA>::New();
+      this->OutlineColorMapper = vtkSmartPointer<vtkImageMapToRGBA>::New();
+      this->FillColorMapper = vtkSmartPointer<vtkImageMapToRGBA>::New();
 
       // Set up image pipeline
       this->Reslice->SetBackgroundColor(0.0, 0.0, 0.0, 0.0);
@@ -225,26 +229,29 @@ public:
       this->ImageThreshold->SetOutValue(1);
       this->ImageThreshold->SetInValue(0);
 
+      // Binary labelmap fill and outline, all the labels of the layer in one pass
+      this->LabelMapToRGBA->SetInputConnection(this->Reslice->GetOutputPort());
+      this->LabelMapToRGBA->SetFillLookupTable(this->LookupTableFill);
+      this->LabelMapToRGBA->SetOutlineLookupTable(this->LookupTableOutline);
+
       // Image outline
       this->LabelOutline->SetInputConnection(this->Reslice->GetOutputPort());
-      vtkSmartPointer<vtkImageMapToRGBA> outlineColorMapper = vtkSmartPointer<vtkImageMapToRGBA>::New();
-      outlineColorMapper->SetInputConnection(this->LabelOutline->GetOutputPort());
-      outlineColorMapper->SetOutputFormatToRGBA();
-      outlineColorMapper->SetLookupTable(this->LookupTableOutline);
+      this->OutlineColorMapper->SetInputConnection(this->LabelOutline->GetOutputPort());
+      this->OutlineColorMapper->SetOutputFormatToRGBA();
+      this->OutlineColorMapper->SetLookupTable(this->LookupTableOutline);
       vtkSmartPointer<vtkImageMapper> imageOutlineMapper = vtkSmartPointer<vtkImageMapper>::New();
-      imageOutlineMapper->SetInputConnection(outlineColorMapper->GetOutputPort());
+      imageOutlineMapper->SetInputConnection(this->OutlineColorMapper->GetOutputPort());
       imageOutlineMapper->SetColorWindow(255);
       imageOutlineMapper->SetColorLevel(127.5);
       this->ImageOutlineActor->SetMapper(imageOutlineMapper);
       this->ImageOutlineActor->SetVisibility(0);
 
       // Image fill
-      vtkSmartPointer<vtkImageMapToRGBA> fillColorMapper = vtkSmartPointer<vtkImageMapToRGBA>::New();
-      fillColorMapper->SetInputConnection(this->Reslice->GetOutputPort());
-      fillColorMapper->SetOutputFormatToRGBA();
-      fillColorMapper->SetLookupTable(this->LookupTableFill);
+      this->FillColorMapper->SetInputConnection(this->Reslice->GetOutputPort());
+      this->FillColorMapper->SetOutputFormatToRGBA();
+      this->FillColorMapper->SetLookupTable(this->LookupTableFill);
       vtkSmartPointer<vtkImageMapper> imageFillMapper = vtkSmartPointer<vtkImageMapper>::New();
-      imageFillMapper->SetInputConnection(fillColorMapper->GetOutputPort());
+      imageFillMapper->SetInputConnection(this->FillColorMapper->GetOutputPort());
       imageFillMapper->SetColorWindow(255);
       imageFillMapper->SetColorLevel(127.5);
       this->ImageFillActor->SetMapper(imageFillMapper);
@@ -276,6 +283,9 @@ public:
     vtkSmartPointer<vtkLookupTable> LookupTableOutline;
     vtkSmartPointer<vtkLookupTable> LookupTableFill;
     vtkSmartPointer<vtkImageThreshold> ImageThreshold;
+    vtkSmartPointer<vtkImageLabelMapToRGBA> LabelMapToRGBA;
+    vtkSmartPointer<vtkImageMapToRGBA> OutlineColorMapper;
+    vtkSmartPointer<vtkImageMapToRGBA> FillColorMapper;
 
     vtkMTimeType SliceIntersectionUpdatedTime;
     };
@@ -799,7 +809,12 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
     bool pipelineVisiblity = false;
     for (std::string segmentId : sharedSegmentIds)
       {
-      pipelineVisiblity |= this->IsSegmentVisibleInCurrentSlice(displayNode, pipeline, segmentId);
+      pipelineVisiblity = this->IsSegmentVisibleInCurrentSlice(displayNode, pipeline, segmentId);
+      // Segments sharing a labelmap have the bounds of the shared image, checking one of them is enough
+      if (pipelineVisiblity || imageData)
+        {
+        break;
+        }
       }
 
     if (!pipelineVisiblity)
@@ -1137,11 +1152,23 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
       int sliceOutputExtent[6] = { 0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1 };
       pipeline->Reslice->SetOutputExtent(sliceOutputExtent);
 
-      // Smooth the border of fractional labelmaps
-      pipeline->LabelOutline->SetInputConnection(pipeline->Reslice->GetOutputPort());
-      pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->Reslice->GetOutputPort());
-      if (shownRepresenatationName == vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName())
+      vtkImageMapper* imageOutlineMapper = vtkImageMapper::SafeDownCast(pipeline->ImageOutlineActor->GetMapper());
+      vtkImageMapper* imageFillMapper = vtkImageMapper::SafeDownCast(pipeline->ImageFillActor->GetMapper());
+      if (shownRepresenatationName != vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName())
+        {
+        // Color the fill and the outline of all the segments of the layer at once
+        pipeline->LabelOutline->SetInputConnection(nullptr);
+        pipeline->LabelMapToRGBA->SetOutline(outlineVisible ? genericDisplayNode->GetSliceIntersectionThickness() : 0);
+        imageOutlineMapper->SetInputConnection(pipeline->LabelMapToRGBA->GetOutlineOutputPort());
+        imageFillMapper->SetInputConnection(pipeline->LabelMapToRGBA->GetFillOutputPort());
+        }
+      else
         {
+        // Smooth the border of fractional labelmaps
+        imageOutlineMapper->SetInputConnection(pipeline->OutlineColorMapper->GetOutputPort());
+        imageFillMapper->SetInputConnection(pipeline->FillColorMapper->GetOutputPort());
+        pipeline->LabelOutline->SetInputConnection(pipeline->Reslice->GetOutputPort());
+        pipeline->FillColorMapper->SetInputConnection(pipeline->Reslice->GetOutputPort());
         // If ThresholdValue is not specified, then do not perform thresholding
         vtkDoubleArray* thresholdValue = vtkDoubleArray::SafeDownCast(
           imageData->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetThresholdValueFieldName()));
@@ -1149,7 +1176,7 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
           {
           if (!this->SmoothFractionalLabelMapBorder && thresholdValue && thresholdValue->GetNumberOfValues() == 1)
             {
-            pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
+            pipeline->FillColorMapper->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
             }
           pipeline->ImageThreshold->ThresholdByLower(thresholdValue->GetValue(0));
           pipeline->LabelOutline->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
@@ -33,6 +33,7 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include <vtkAppendPolyData.h>
 #include <vtkCollection.h>
 #include <vtkArrowSource.h>
+#include <vtkBatchPointTransformer.h>
 #include <vtkBoundingBox.h>
 #include <vtkConeSource.h>
 #include <vtkContourFilter.h>
@@ -207,21 +208,13 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
   vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* gridToRAS, int* gridSize,
   bool transformToWorld /* = true */)
 {
-  vtkNew<vtkGeneralTransform> inputTransform;
-  if (transformToWorld)
-  {
-    inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-  }
-  else
-  {
-    inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
-  }
   // Generate sample point set on a grid
+  // (the points are transformed in GetTransformedPointSamples)
   vtkNew<vtkPoints> samplePositions_RAS;
+  samplePositions_RAS->SetDataTypeToDouble();
   int numOfSamples = gridSize[0] * gridSize[1] * gridSize[2];
   samplePositions_RAS->SetNumberOfPoints(numOfSamples);
   double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
   double point_Grid[4] = { 0, 0, 0, 1 };
   int sampleIndex = 0;
   for (point_Grid[2] = 0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
@@ -231,7 +224,6 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
       for (point_Grid[0] = 0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
         {
         gridToRAS->MultiplyPoint(point_Grid, point_RAS);
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
         samplePositions_RAS->SetPoint(sampleIndex, point_RAS[0], point_RAS[1], point_RAS[2]);
         sampleIndex++;
         }
@@ -269,19 +261,22 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
     inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
     }
 
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
-  for (int sampleIndex = 0; sampleIndex < numOfSamples; sampleIndex++)
+  // Transform all the sample points at once (concurrently, using batch kernels),
+  // directly into the displacement vector array
+  vtkNew<vtkPoints> transformedSamplePositions_RAS;
+  transformedSamplePositions_RAS->SetData(sampleVectors_RAS.GetPointer());
+  vtkNew<vtkBatchPointTransformer> transformer;
+  transformer->SetTransform(inputTransform.GetPointer());
+  transformer->TransformPoints(samplePositions_RAS, transformedSamplePositions_RAS.GetPointer());
+
+  double point_RAS[3] = { 0, 0, 0 };
+  double* pointDislocationVector_RAS = sampleVectors_RAS->GetPointer(0);
+  for (int sampleIndex = 0; sampleIndex < numOfSamples; sampleIndex++, pointDislocationVector_RAS += 3)
     {
-    double* point_RAS = samplePositions_RAS->GetPoint(sampleIndex);
-
-    inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-    pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-    pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-    pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-    sampleVectors_RAS->SetTuple3(sampleIndex, pointDislocationVector_RAS[0], pointDislocationVector_RAS[1], pointDislocationVector_RAS[2]);
+    samplePositions_RAS->GetPoint(sampleIndex, point_RAS);
+    pointDislocationVector_RAS[0] -= point_RAS[0];
+    pointDislocationVector_RAS[1] -= point_RAS[1];
+    pointDislocationVector_RAS[2] -= point_RAS[2];
     }
 
   outputPointSet->SetPoints(samplePositions_RAS);
@@ -406,34 +401,26 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImag
   // if the direction matrix is not identity.
   magnitudeImage->AllocateScalars(VTK_FLOAT, 1);
 
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
-  float* voxelPtr = static_cast<float*>(magnitudeImage->GetScalarPointer());
-  int* extent = magnitudeImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
+  // Compute the displacement vectors concurrently, then their magnitude
+  vtkNew<vtkImageData> displacementImage;
+  displacementImage->SetExtent(magnitudeImage->GetExtent());
+  displacementImage->AllocateScalars(VTK_FLOAT, 3);
+  if (!vtkMRMLTransformNode::ComputeDisplacementGrid(inputTransform.GetPointer(), ijkToRAS, displacementImage.GetPointer()))
   {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
-    {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
+    return false;
+  }
 
-        float mag = sqrt(
-          pointDislocationVector_RAS[0] * pointDislocationVector_RAS[0] +
-          pointDislocationVector_RAS[1] * pointDislocationVector_RAS[1] +
-          pointDislocationVector_RAS[2] * pointDislocationVector_RAS[2]);
+  const float* pointDislocationVector_RAS = static_cast<float*>(displacementImage->GetScalarPointer());
+  float* voxelPtr = static_cast<float*>(magnitudeImage->GetScalarPointer());
+  vtkIdType numberOfVoxels = magnitudeImage->GetNumberOfPoints();
+  for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; voxelIndex++, pointDislocationVector_RAS += 3)
+  {
+    float mag = sqrt(
+      pointDislocationVector_RAS[0] * pointDislocationVector_RAS[0] +
+      pointDislocationVector_RAS[1] * pointDislocationVector_RAS[1] +
+      pointDislocationVector_RAS[2] * pointDislocationVector_RAS[2]);
 
-        *(voxelPtr++) = mag;
-      }
-    }
+    *(voxelPtr++) = mag;
   }
 
   return true;
@@ -700,30 +687,8 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
   // if the direction matrix is not identity.
   vectorImage->AllocateScalars(VTK_FLOAT, 3);
 
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
-  float* voxelPtr = static_cast<float*>(vectorImage->GetScalarPointer());
-  int* extent = vectorImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
-  {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
-    {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        // store the pointDislocationVector_RAS components in the image
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
-      }
-    }
-  }
-
-  return true;
+  // Points are transformed concurrently, as evaluating a chain of non-linear transforms is slow
+  return vtkMRMLTransformNode::ComputeDisplacementGrid(inputTransform.GetPointer(), ijkToRAS, vectorImage);
 }
 
 //----------------------------------------------------------------------------
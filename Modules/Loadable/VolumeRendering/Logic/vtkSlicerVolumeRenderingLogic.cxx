@@ -27,6 +27,7 @@
 
 // MRML includes
 #include <vtkCacheManager.h>
+#include <vtkImageHistogramCache.h>
 #include <vtkMRMLColorNode.h>
 #include <vtkMRMLLabelMapVolumeDisplayNode.h>
 #include <vtkMRMLScene.h>
@@ -375,14 +376,11 @@ void vtkSlicerVolumeRenderingLogic::UpdateTranferFunctionRangeFromImage(vtkMRMLV
   //update scalar range
   vtkColorTransferFunction *functionColor = prop->GetRGBTransferFunction();
 
-  vtkDataArray* scalars = input->GetPointData()->GetScalars();
-  if (!scalars)
+  double rangeNew[2];
+  if (!vtkImageHistogramCache::GetInstance()->GetScalarRange(input, rangeNew))
     {
     return;
     }
-
-  double rangeNew[2];
-  scalars->GetRange(rangeNew);
   functionColor->AdjustRange(rangeNew);
   vtkDebugMacro("Color range: "<< functionColor->GetRange()[0] << " " << functionColor->GetRange()[1]);
 
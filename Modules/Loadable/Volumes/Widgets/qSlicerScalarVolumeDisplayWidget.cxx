@@ -11,6 +11,7 @@
 #include <ctkVTKHistogram.h>
 
 // MRML includes
+#include "vtkImageHistogramCache.h"
 #include "vtkMRMLColorNode.h"
 #include "vtkMRMLScalarVolumeDisplayNode.h"
 #include "vtkMRMLScalarVolumeNode.h"
@@ -288,7 +289,7 @@ void qSlicerScalarVolumeDisplayWidget::updateHistogram()
     }
   else
     {
-    imageData->GetScalarRange(range);
+    vtkImageHistogramCache::GetInstance()->GetScalarRange(imageData, range);
     }
   // AdjustRange call will take out points that are outside of the new
   // range, but it needs the points to be there in order to work, so call